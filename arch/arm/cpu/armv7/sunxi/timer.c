@@ -48,6 +48,15 @@ int timer_init(void)
 	struct sunxi_timer_reg *timers =
 		(struct sunxi_timer_reg *)SUNXI_TIMER_BASE;
 	struct sunxi_timer *timer = &timers->timer[TIMER_NUM];
+
+#ifdef CONFIG_BOOTSTAGE
+	/*
+	 * Keep counting from the first call (in SPL), so that bootstage
+	 * times from SPL and U-Boot can be compared
+	 */
+	if (readl(&timer->ctl) & TIMER_EN)
+		return 0;
+#endif
 	writel(TIMER_LOAD_VAL, &timer->inter);
 	writel(TIMER_MODE | TIMER_DIV | TIMER_SRC | TIMER_RELOAD | TIMER_EN,
 	       &timer->ctl);
@@ -78,6 +87,14 @@ ulong get_timer_masked(void)
 	return gd->arch.tbl;
 }
 
+#ifdef CONFIG_BOOTSTAGE
+/* Time since the timer was started, wrapping after about three minutes */
+ulong timer_get_boot_us(void)
+{
+	return COUNT_TO_USEC(read_timer());
+}
+#endif
+
 /* delay x useconds */
 void __udelay(unsigned long usec)
 {
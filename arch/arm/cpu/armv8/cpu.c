@@ -13,6 +13,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <worker.h>
 #include <asm/system.h>
 #include <linux/compiler.h>
 
@@ -26,6 +27,9 @@ int cleanup_before_linux(void)
 	 */
 	disable_interrupts();
 
+	/* Put any secondary CPUs back where the OS expects to find them */
+	worker_stop();
+
 	/*
 	 * Turn off I-cache and invalidate it
 	 */
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Secondary CPUs for the worker pool, started with PSCI or the spin-table
+ *
+ * The CPUs are found in the control device tree, as Linux finds them. Each
+ * one is started at worker_secondary_entry(), which turns on its MMU with
+ * the boot CPU's page tables so that it sees memory the same way. When the
+ * pool is stopped the CPUs are turned off with PSCI, or sent back to the
+ * spin-table loop with their MMU and caches off, ready for the OS.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <fdt_support.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <worker.h>
+#include <asm/io.h>
+#include <asm/psci.h>
+#include <asm/spin_table.h>
+#include <asm/system.h>
+#include <asm/worker.h>
+#include <linux/compiler.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define WORKER_STACK_SIZE	SZ_16K
+#define WORKER_TIMEOUT_MS	100
+
+/* 64-bit calling convention for PSCI functions */
+#define WORKER_PSCI_FN64	0x40000000
+
+enum worker_method {
+	WORKER_PSCI,
+	WORKER_SPIN_TABLE,
+};
+
+/* What secondary CPUs should do once all have started */
+enum worker_release {
+	WORKER_WAIT,		/* not decided yet */
+	WORKER_RUN,		/* run jobs until the pool is stopped */
+	WORKER_PARK,		/* go straight back */
+};
+
+struct worker_boot worker_boot __aligned(ARCH_DMA_MINALIGN);
+
+/**
+ * struct worker_arch - secondary CPU state
+ *
+ * @method:	How the CPUs are started and stopped
+ * @hvc:	true to call PSCI with HVC, false to use SMC
+ * @count:	Number of secondary CPUs
+ * @stacks:	Stacks for the secondary CPUs, allocated on first use
+ * @release:	What the CPUs should do after starting (enum worker_release)
+ * @started:	Set by each CPU once it has started
+ * @parked:	Set by each CPU once it is back in the spin-table, written
+ *		with the cache off; each has its own cache line
+ */
+static struct worker_arch {
+	enum worker_method method;
+	bool hvc;
+	int count;
+	void *stacks;
+	int release;
+	bool started[CONFIG_WORKER_MAX_CPUS];
+	struct {
+		u64 val;
+	} __aligned(ARCH_DMA_MINALIGN) parked[CONFIG_WORKER_MAX_CPUS];
+} wk;
+
+static ulong worker_psci_call(ulong fn, ulong arg0, ulong arg1, ulong arg2)
+{
+	struct pt_regs regs;
+
+	memset(&regs, '\0', sizeof(regs));
+	regs.regs[0] = fn;
+	regs.regs[1] = arg0;
+	regs.regs[2] = arg1;
+	regs.regs[3] = arg2;
+	if (wk.hvc)
+		hvc_call(&regs);
+	else
+		smc_call(&regs);
+
+	return regs.regs[0];
+}
+
+/* Find the secondary CPUs and how to start them */
+static int worker_find_cpus(const void *blob, int max)
+{
+	u64 boot_mpidr = read_mpidr() & MPIDR_HWID_MASK;
+	const char *method = NULL, *prop;
+	const fdt32_t *reg;
+	int cpus, node, len;
+	int count = 1;
+	u64 mpidr;
+
+	cpus = fdt_path_offset(blob, "/cpus");
+	if (cpus < 0)
+		return -ENODEV;
+	fdt_for_each_subnode(blob, node, cpus) {
+		prop = fdt_getprop(blob, node, "device_type", NULL);
+		if (!prop || strcmp(prop, "cpu"))
+			continue;
+		reg = fdt_getprop(blob, node, "reg", &len);
+		if (!reg || (len != 4 && len != 8))
+			return -EINVAL;
+		mpidr = of_read_number(reg, len / 4) & MPIDR_HWID_MASK;
+		if (mpidr == boot_mpidr)
+			continue;
+		if (count > max)
+			break;
+
+		/* Mixing enable methods is not supported */
+		prop = fdt_getprop(blob, node, "enable-method", NULL);
+		if (!prop || (method && strcmp(prop, method)))
+			return -ENOTSUPP;
+		method = prop;
+		worker_boot.mpidr[count++] = mpidr;
+	}
+	if (!method)
+		return -ENODEV;
+
+	if (!strcmp(method, "psci")) {
+		node = fdt_path_offset(blob, "/psci");
+		if (node < 0)
+			return -ENODEV;
+		prop = fdt_getprop(blob, node, "method", NULL);
+		if (!prop)
+			return -ENODEV;
+		wk.method = WORKER_PSCI;
+		wk.hvc = !strcmp(prop, "hvc");
+#ifdef CONFIG_ARMV8_SPIN_TABLE
+	} else if (!strcmp(method, "spin-table")) {
+		wk.method = WORKER_SPIN_TABLE;
+#endif
+	} else {
+		return -ENOTSUPP;
+	}
+	worker_boot.mpidr[0] = boot_mpidr;
+	worker_boot.count = count;
+	wk.count = count - 1;
+
+	return 0;
+}
+
+/* Start the secondary CPUs, which wait until wk.release is set */
+static int worker_release_cpus(void)
+{
+	ulong entry = (ulong)worker_secondary_entry;
+	ulong ret;
+	int cpu;
+
+	if (wk.method == WORKER_PSCI) {
+		for (cpu = 1; cpu <= wk.count; cpu++) {
+			ret = worker_psci_call(ARM_PSCI_0_2_FN_CPU_ON |
+					       WORKER_PSCI_FN64,
+					       worker_boot.mpidr[cpu], entry,
+					       cpu);
+			if (ret) {
+				debug("%s: Cannot start CPU %llx (err=%ld)\n",
+				      __func__, worker_boot.mpidr[cpu],
+				      (long)ret);
+				return -EIO;
+			}
+		}
+		return 0;
+	}
+#ifdef CONFIG_ARMV8_SPIN_TABLE
+	spin_table_cpu_release_addr = entry;
+	flush_dcache_range((ulong)&spin_table_cpu_release_addr,
+			   (ulong)&spin_table_cpu_release_addr + sizeof(u64));
+	arch_worker_kick();
+#endif
+
+	return 0;
+}
+
+/* Wait for all the secondary CPUs to reach worker_secondary_main() */
+static int worker_wait_started(void)
+{
+	ulong start = get_timer(0);
+	int cpu;
+
+	for (cpu = 1; cpu <= wk.count; cpu++) {
+		while (!READ_ONCE(wk.started[cpu])) {
+			if (get_timer(start) > WORKER_TIMEOUT_MS)
+				return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+
+static bool worker_cpu_is_stopped(int cpu)
+{
+	ulong addr = (ulong)&wk.parked[cpu];
+
+	if (wk.method == WORKER_PSCI) {
+		return worker_psci_call(ARM_PSCI_0_2_FN_AFFINITY_INFO |
+					WORKER_PSCI_FN64,
+					worker_boot.mpidr[cpu], 0, 0) ==
+			PSCI_AFFINITY_LEVEL_OFF;
+	}
+
+	/* The CPU writes the flag with its cache off */
+	invalidate_dcache_range(addr, addr + ARCH_DMA_MINALIGN);
+
+	return READ_ONCE(wk.parked[cpu].val);
+}
+
+/* Wait for the secondary CPUs to go back to where they were */
+static void worker_wait_stopped(void)
+{
+	ulong start = get_timer(0);
+	int cpu;
+
+	for (cpu = 1; cpu <= wk.count; cpu++) {
+		while (!worker_cpu_is_stopped(cpu)) {
+			if (get_timer(start) > WORKER_TIMEOUT_MS) {
+				printf("CPU %llx did not stop\n",
+				       worker_boot.mpidr[cpu]);
+				break;
+			}
+		}
+	}
+}
+
+void worker_secondary_main(int cpu)
+{
+	int release;
+
+	WRITE_ONCE(wk.started[cpu], true);
+	mb();	/* let the boot CPU see that we have started */
+	arch_worker_kick();
+	while ((release = READ_ONCE(wk.release)) == WORKER_WAIT)
+		arch_worker_wait();
+	mb();	/* see everything the boot CPU set up before releasing us */
+	if (release == WORKER_RUN)
+		worker_main(cpu);
+
+	if (wk.method == WORKER_PSCI)
+		worker_psci_call(ARM_PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+#ifdef CONFIG_ARMV8_SPIN_TABLE
+	else
+		worker_secondary_park(&wk.parked[cpu].val);
+#endif
+
+	/* We should not get here */
+	hang();
+}
+
+int arch_worker_start(int max)
+{
+	int ret;
+	int cpu;
+
+	ret = worker_find_cpus(gd->fdt_blob, max);
+	if (ret)
+		return ret;
+	if (!wk.stacks) {
+		wk.stacks = memalign(ARCH_DMA_MINALIGN,
+				     WORKER_STACK_SIZE *
+				     (CONFIG_WORKER_MAX_CPUS - 1));
+		if (!wk.stacks)
+			return -ENOMEM;
+	}
+	for (cpu = 1; cpu <= wk.count; cpu++) {
+		worker_boot.stack[cpu] = (ulong)wk.stacks +
+			cpu * WORKER_STACK_SIZE;
+		wk.started[cpu] = false;
+		wk.parked[cpu].val = 0;
+	}
+	worker_boot.gd = (ulong)gd;
+	worker_save_mmu(&worker_boot);
+	wk.release = WORKER_WAIT;
+	flush_dcache_range((ulong)&worker_boot,
+			   (ulong)&worker_boot + sizeof(worker_boot));
+	flush_dcache_range((ulong)wk.parked,
+			   (ulong)wk.parked + sizeof(wk.parked));
+
+	ret = worker_release_cpus();
+	if (!ret)
+		ret = worker_wait_started();
+#ifdef CONFIG_ARMV8_SPIN_TABLE
+	if (wk.method == WORKER_SPIN_TABLE) {
+		/* Stop any CPU which has not started from following */
+		spin_table_cpu_release_addr = 0;
+		flush_dcache_range((ulong)&spin_table_cpu_release_addr,
+				   (ulong)&spin_table_cpu_release_addr +
+				   sizeof(u64));
+	}
+#endif
+	WRITE_ONCE(wk.release, ret ? WORKER_PARK : WORKER_RUN);
+	arch_worker_kick();
+	if (ret) {
+		worker_wait_stopped();
+		return ret;
+	}
+
+	return wk.count;
+}
+
+void arch_worker_stop(void)
+{
+	worker_wait_stopped();
+}
+
+void arch_worker_wait(void)
+{
+	asm volatile("wfe" : : : "memory");
+}
+
+void arch_worker_kick(void)
+{
+	asm volatile("dsb sy\n"
+		     "sev" : : : "memory");
+}
@@ -23,6 +23,21 @@ void sdelay(unsigned long);
  */
 void return_to_fel(uint32_t lr, uint32_t sp);
 
+/**
+ * sunxi_spl_dcache_enable() - Enable the MMU and D-cache in SPL
+ *
+ * This is called once DRAM is working, so that SPL can load the next stage
+ * into cached memory. It does nothing when booted over USB (FEL). The caches
+ * are turned off again before SPL jumps to the next stage.
+ *
+ * @ram_size:	Size of DRAM in bytes
+ */
+#if defined CONFIG_SPL_BUILD && defined CONFIG_SUNXI_SPL_DCACHE
+void sunxi_spl_dcache_enable(unsigned long ram_size);
+#else
+static inline void sunxi_spl_dcache_enable(unsigned long ram_size) {}
+#endif
+
 /* Board / SoC level designware gmac init */
 #if !defined CONFIG_SPL_BUILD && defined CONFIG_SUNXI_GMAC
 void eth_init_board(void);
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __ASM_WORKER_H__
+#define __ASM_WORKER_H__
+
+/* Offsets in struct worker_boot, for use by worker_v8.S */
+#define WORKER_BOOT_GD		0
+#define WORKER_BOOT_TTBR	8
+#define WORKER_BOOT_TCR		16
+#define WORKER_BOOT_MAIR	24
+#define WORKER_BOOT_SCTLR	32
+#define WORKER_BOOT_VBAR	40
+#define WORKER_BOOT_COUNT	48
+#define WORKER_BOOT_MPIDR	56
+#define WORKER_BOOT_STACK	(WORKER_BOOT_MPIDR + CONFIG_WORKER_MAX_CPUS * 8)
+
+/* Affinity fields of MPIDR_EL1 */
+#define MPIDR_HWID_MASK		0xff00ffffff
+
+#ifndef __ASSEMBLY__
+/**
+ * struct worker_boot - what a secondary CPU needs to join the worker pool
+ *
+ * This is read by secondary CPUs before they turn on their MMU, so must be
+ * flushed from the cache after it is written.
+ *
+ * @gd:		Global data pointer
+ * @ttbr:	Translation table base register of the boot CPU
+ * @tcr:	Translation control register of the boot CPU
+ * @mair:	Memory attribute indirection register of the boot CPU
+ * @sctlr:	System control register of the boot CPU
+ * @vbar:	Vector base address register of the boot CPU
+ * @count:	Number of CPUs in @mpidr, including the boot CPU
+ * @mpidr:	Affinity of each CPU; CPU 0 is the boot CPU
+ * @stack:	Initial stack pointer of each CPU
+ */
+struct worker_boot {
+	u64 gd;
+	u64 ttbr;
+	u64 tcr;
+	u64 mair;
+	u64 sctlr;
+	u64 vbar;
+	u64 count;
+	u64 mpidr[CONFIG_WORKER_MAX_CPUS];
+	u64 stack[CONFIG_WORKER_MAX_CPUS];
+};
+
+extern struct worker_boot worker_boot;
+
+/* Entry point for secondary CPUs, with the MMU off */
+void worker_secondary_entry(void);
+
+/* Save the MMU settings of the current CPU in @wb */
+void worker_save_mmu(struct worker_boot *wb);
+
+/*
+ * Turn off the MMU and caches, set *@parked to 1 and go back to the
+ * spin-table
+ */
+void __noreturn worker_secondary_park(u64 *parked);
+
+/* Called by worker_secondary_entry() once the MMU is on */
+void __noreturn worker_secondary_main(int cpu);
+#endif
+
+#endif /* __ASM_WORKER_H__ */
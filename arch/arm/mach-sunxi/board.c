@@ -261,6 +261,7 @@ void board_init_f(ulong dummy)
 {
 	spl_init();
 	preloader_console_init();
+	bootstage_mark_name(BOOTSTAGE_ID_START_SPL, "spl");
 
 #ifdef CONFIG_SPL_I2C_SUPPORT
 	/* Needed early by sunxi_board_init if PMU is enabled */
@@ -268,6 +269,37 @@ void board_init_f(ulong dummy)
 #endif
 	sunxi_board_init();
 }
+
+#ifdef CONFIG_SUNXI_SPL_DCACHE
+void sunxi_spl_dcache_enable(unsigned long ram_size)
+{
+	/* FEL returns to the BROM, which expects the MMU to be off */
+	if (spl_boot_device() == BOOT_DEVICE_BOARD)
+		return;
+
+	gd->bd->bi_dram[0].start = CONFIG_SYS_SDRAM_BASE;
+	gd->bd->bi_dram[0].size = ram_size;
+
+	/*
+	 * Nothing uses the DRAM between the SPL stack (which grows down) and
+	 * the SPL BSS, so put the page table at the bottom of it
+	 */
+	gd->arch.tlb_addr = CONFIG_SPL_STACK_R_ADDR;
+	dcache_enable();
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "dcache_on");
+}
+
+void spl_board_prepare_for_boot(void)
+{
+	/*
+	 * U-Boot expects to start with the MMU and D-cache off. Code has just
+	 * been written through the D-cache, so make sure that nothing stale
+	 * is left in the I-cache either.
+	 */
+	dcache_disable();
+	invalidate_icache_all();
+}
+#endif
 #endif
 
 void reset_cpu(ulong addr)
@@ -7,6 +7,8 @@
 #include <errno.h>
 #include <libfdt.h>
 #include <os.h>
+#include <uthread.h>
+#include <worker.h>
 #include <asm/io.h>
 #include <asm/state.h>
 #include <dm/root.h>
@@ -45,6 +47,58 @@ void __udelay(unsigned long usec)
 		os_usleep(usec);
 }
 
+#ifdef CONFIG_UTHREAD
+void *arch_uthread_create(void (*entry)(void), void *stack, size_t size)
+{
+	return os_context_create(entry, stack, size);
+}
+
+void arch_uthread_switch(void *from, void *to)
+{
+	os_context_switch(from, to);
+}
+
+void arch_uthread_free(void *ctx)
+{
+	os_context_free(ctx);
+}
+#endif
+
+#ifdef CONFIG_WORKER
+static void *worker_thread[CONFIG_WORKER_MAX_CPUS];
+static int worker_threads;
+
+int arch_worker_start(int max)
+{
+	void *thread;
+
+	for (worker_threads = 0; worker_threads < max; worker_threads++) {
+		thread = os_thread_create(worker_main, worker_threads + 1);
+		if (!thread)
+			break;
+		worker_thread[worker_threads] = thread;
+	}
+
+	return worker_threads;
+}
+
+void arch_worker_stop(void)
+{
+	while (worker_threads)
+		os_thread_join(worker_thread[--worker_threads]);
+}
+
+void arch_worker_wait(void)
+{
+	/* Sleep rather than spin, since the pool stays up while idle */
+	os_usleep(100);
+}
+
+void arch_worker_kick(void)
+{
+}
+#endif
+
 int cleanup_before_linux(void)
 {
 	return 0;
@@ -7,12 +7,14 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <termios.h>
 #include <time.h>
+#include <ucontext.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -20,6 +22,7 @@
 #include <sys/types.h>
 #include <linux/types.h>
 
+#include <asm/cache.h>
 #include <asm/getopt.h>
 #include <asm/sections.h>
 #include <asm/state.h>
@@ -28,9 +31,10 @@
 
 /* Operating System Interface */
 
+/* Padded so that the memory after it is aligned as U-Boot expects for DMA */
 struct os_mem_hdr {
 	size_t length;		/* number of bytes in the block */
-};
+} __attribute__((aligned(ARCH_DMA_MINALIGN)));
 
 ssize_t os_read(int fd, void *buf, size_t count)
 {
@@ -608,3 +612,75 @@ void os_localtime(struct rtc_time *rt)
 	rt->tm_yday = tm->tm_yday;
 	rt->tm_isdst = tm->tm_isdst;
 }
+
+void *os_context_create(void (*entry)(void), void *stack, size_t size)
+{
+	ucontext_t *ctx;
+
+	ctx = os_malloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+	memset(ctx, '\0', sizeof(*ctx));
+	if (!entry)
+		return ctx;
+	if (getcontext(ctx)) {
+		os_free(ctx);
+		return NULL;
+	}
+	ctx->uc_stack.ss_sp = stack;
+	ctx->uc_stack.ss_size = size;
+	ctx->uc_link = NULL;
+	makecontext(ctx, entry, 0);
+
+	return ctx;
+}
+
+void os_context_switch(void *from, void *to)
+{
+	swapcontext(from, to);
+}
+
+void os_context_free(void *ctx)
+{
+	os_free(ctx);
+}
+
+struct os_thread {
+	pthread_t thread;
+	void (*entry)(int arg);
+	int arg;
+};
+
+static void *os_thread_start(void *data)
+{
+	struct os_thread *ot = data;
+
+	ot->entry(ot->arg);
+
+	return NULL;
+}
+
+void *os_thread_create(void (*entry)(int arg), int arg)
+{
+	struct os_thread *ot;
+
+	ot = os_malloc(sizeof(*ot));
+	if (!ot)
+		return NULL;
+	ot->entry = entry;
+	ot->arg = arg;
+	if (pthread_create(&ot->thread, NULL, os_thread_start, ot)) {
+		os_free(ot);
+		return NULL;
+	}
+
+	return ot;
+}
+
+void os_thread_join(void *thread)
+{
+	struct os_thread *ot = thread;
+
+	pthread_join(ot->thread, NULL);
+	os_free(ot);
+}
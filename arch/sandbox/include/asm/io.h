@@ -47,6 +47,9 @@ phys_addr_t map_to_sysmem(const void *ptr);
 #define writew(v, addr)
 #define writel(v, addr)
 
+/* Order memory accesses with respect to other host threads */
+#define mb()	__sync_synchronize()
+
 /* I/O access functions */
 int inl(unsigned int addr);
 int inw(unsigned int addr);
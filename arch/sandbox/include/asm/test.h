@@ -79,4 +79,122 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * struct sandbox_nand_stats - Activity of the sandbox NAND chip
+ *
+ * @time_ns:	Virtual time taken by the chip, in nanoseconds
+ * @page_reads:	Number of pages read from the array
+ * @cache_reads: Number of READ CACHE SEQUENTIAL commands
+ * @page_progs:	Number of pages programmed
+ * @block_erases: Number of blocks erased
+ */
+struct sandbox_nand_stats {
+	u64 time_ns;
+	uint page_reads;
+	uint cache_reads;
+	uint page_progs;
+	uint block_erases;
+};
+
+/**
+ * sandbox_nand_get_stats() - get activity since the stats were last cleared
+ *
+ * @stats:	Returns the activity
+ */
+void sandbox_nand_get_stats(struct sandbox_nand_stats *stats);
+
+/**
+ * sandbox_nand_clear_stats() - clear the activity counters and timer
+ */
+void sandbox_nand_clear_stats(void);
+
+/**
+ * sandbox_nand_flip_bit() - flip a bit in the NAND array, to test ECC
+ *
+ * @offset:	Byte offset in the main (non-OOB) area of the chip
+ * @bit:	Bit number to flip (0-7)
+ */
+void sandbox_nand_flip_bit(loff_t offset, int bit);
+
+/**
+ * sandbox_nand_mark_bad() - write a factory bad block marker to a block
+ *
+ * @block:	Block number to mark
+ */
+void sandbox_nand_mark_bad(int block);
+
+/**
+ * struct sandbox_udc_stats - Activity of the sandbox USB device controller
+ *
+ * @busy_ns:	Virtual time spent moving data on the bus, in nanoseconds
+ * @wait_ns:	Virtual time the host spent waiting for the gadget to queue
+ *		an OUT request
+ * @waits:	Number of times the host had to wait
+ */
+struct sandbox_udc_stats {
+	u64 busy_ns;
+	u64 wait_ns;
+	uint waits;
+};
+
+/**
+ * sandbox_udc_connect() - enumerate the gadget from the simulated host
+ *
+ * This also clears the stats.
+ *
+ * @config:	Configuration value to select
+ * @return 0 if OK, -ENOTCONN if no gadget is connected, other -ve on error
+ */
+int sandbox_udc_connect(int config);
+
+/**
+ * sandbox_udc_disconnect() - unplug the simulated host
+ *
+ * The gadget driver is told of the disconnect and
+ * g_dnl_board_usb_cable_connected() returns 0 until the host connects again.
+ */
+void sandbox_udc_disconnect(void);
+
+/**
+ * sandbox_udc_set_host() - set a function to act as the host
+ *
+ * This is called each time the gadget polls the controller with
+ * usb_gadget_handle_interrupts(), so that a gadget which waits for the host
+ * in a loop of its own can be tested.
+ *
+ * @poll:	Function to call, or NULL to stop
+ * @priv:	Private data for @poll
+ */
+void sandbox_udc_set_host(void (*poll)(void *priv), void *priv);
+
+/**
+ * sandbox_udc_bulk_out() - send a bulk transfer from the host to the gadget
+ *
+ * The transfer ends with a short packet unless @len is a multiple of the
+ * packet size.
+ *
+ * @buf:	Data to send
+ * @len:	Number of bytes to send
+ * @return number of bytes taken by the gadget, or -EAGAIN if it has no
+ * request queued
+ */
+int sandbox_udc_bulk_out(const void *buf, int len);
+
+/**
+ * sandbox_udc_bulk_in() - receive a bulk transfer from the gadget
+ *
+ * @buf:	Place to put the data
+ * @maxlen:	Maximum number of bytes to receive
+ * @return number of bytes received, or -EAGAIN if the gadget has nothing
+ * to send
+ */
+int sandbox_udc_bulk_in(void *buf, int maxlen);
+
+/**
+ * sandbox_udc_get_stats() - get bus activity since the gadget connected
+ *
+ * @stats:	Returns the activity
+ */
+void sandbox_udc_get_stats(struct sandbox_udc_stats *stats);
+
 #endif
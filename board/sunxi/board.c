@@ -21,6 +21,7 @@
 #include <asm/arch/gpio.h>
 #include <asm/arch/mmc.h>
 #include <asm/arch/spl.h>
+#include <asm/arch/sys_proto.h>
 #include <asm/arch/usb_phy.h>
 #ifndef CONFIG_ARM64
 #include <asm/armv7.h>
@@ -534,10 +535,13 @@ void sunxi_board_init(void)
 #endif
 #endif
 	printf("DRAM:");
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "dram_init");
 	ramsize = sunxi_dram_init();
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "dram_done");
 	printf(" %d MiB\n", (int)(ramsize >> 20));
 	if (!ramsize)
 		hang();
+	sunxi_spl_dcache_enable(ramsize);
 
 	/*
 	 * Only clock up the CPU to full speed if we are reasonably
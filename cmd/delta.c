@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Command for applying block-level delta updates
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <delta.h>
+#include <mapmem.h>
+#include <part.h>
+
+/* Map a delta in memory and check it, returning NULL if it is not valid */
+static const struct delta_header *delta_map(const char *arg)
+{
+	const struct delta_header *delta;
+	ulong addr, size;
+	int ret;
+
+	addr = simple_strtoul(arg, NULL, 16);
+	delta = map_sysmem(addr, sizeof(*delta));
+	size = be32_to_cpu(delta->size);
+	unmap_sysmem(delta);
+	delta = map_sysmem(addr, size);
+	ret = delta_check(delta, max(size, sizeof(*delta)));
+	if (ret) {
+		printf("Invalid delta at %lx (err=%d)\n", addr, ret);
+		unmap_sysmem(delta);
+		return NULL;
+	}
+
+	return delta;
+}
+
+static int do_delta_check(int argc, char * const argv[])
+{
+	const struct delta_header *delta;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+	delta = delta_map(argv[2]);
+	if (!delta)
+		return CMD_RET_FAILURE;
+	printf("Delta of %u blocks of %u bytes from %u blocks, %u ops, ",
+	       be32_to_cpu(delta->dst_blocks), be32_to_cpu(delta->block_size),
+	       be32_to_cpu(delta->src_blocks), be32_to_cpu(delta->op_count));
+	print_size(be32_to_cpu(delta->size), "\n");
+	unmap_sysmem(delta);
+
+	return 0;
+}
+
+static int do_delta_apply(int argc, char * const argv[])
+{
+	struct blk_desc *src_desc, *dst_desc;
+	const struct delta_header *delta;
+	disk_partition_t src, dst;
+	struct delta_stats stats;
+	int ret;
+
+	if (argc != 7)
+		return CMD_RET_USAGE;
+	if (blk_get_device_part_str(argv[3], argv[4], &src_desc, &src, 1) < 0 ||
+	    blk_get_device_part_str(argv[5], argv[6], &dst_desc, &dst, 1) < 0)
+		return CMD_RET_FAILURE;
+	delta = delta_map(argv[2]);
+	if (!delta)
+		return CMD_RET_FAILURE;
+
+	ret = delta_apply(delta, src_desc, &src, dst_desc, &dst, &stats);
+	unmap_sysmem(delta);
+	printf("%lu blocks copied, %lu zeroed, %lu from the delta, %lu already written\n",
+	       stats.copied, stats.zeroed, stats.data, stats.skipped);
+	if (ret) {
+		printf("Delta update failed (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static int do_delta(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	if (!strcmp(argv[1], "check"))
+		return do_delta_check(argc, argv);
+	else if (!strcmp(argv[1], "apply"))
+		return do_delta_apply(argc, argv);
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	delta,	7,	0,	do_delta,
+	"block-level delta updates",
+	"check <addr>\n"
+	"    - check the delta at <addr> and show what it holds\n"
+	"delta apply <addr> <src_interface> <src_dev[:part]> <dst_interface> <dst_dev[:part]>\n"
+	"    - write the target image of the delta at <addr> to the destination\n"
+	"      partition, taking unchanged blocks from the source partition.\n"
+	"      Run it again after an interruption to finish the update."
+);
@@ -642,22 +642,32 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
 	/* apply an overlay */
 	else if (strncmp(argv[1], "ap", 2) == 0) {
+		void *blobs[CONFIG_SYS_MAXARGS];
 		unsigned long addr;
 		struct fdt_header *blob;
+		int i, err;
 
-		if (argc != 3)
+		if (argc < 3)
 			return CMD_RET_USAGE;
 
 		if (!working_fdt)
 			return CMD_RET_FAILURE;
 
-		addr = simple_strtoul(argv[2], NULL, 16);
-		blob = map_sysmem(addr, 0);
-		if (!fdt_valid(&blob))
-			return CMD_RET_FAILURE;
+		/* Apply all the overlays together, which is much faster */
+		for (i = 2; i < argc; i++) {
+			addr = simple_strtoul(argv[i], NULL, 16);
+			blob = map_sysmem(addr, 0);
+			if (!fdt_valid(&blob))
+				return CMD_RET_FAILURE;
+			blobs[i - 2] = blob;
+		}
 
-		if (fdt_overlay_apply(working_fdt, blob))
+		err = fdt_overlay_apply_list(working_fdt, blobs, argc - 2);
+		if (err) {
+			printf("Failed to apply overlays: %s\n",
+			       fdt_strerror(err));
 			return CMD_RET_FAILURE;
+		}
 	}
 #endif
 	/* resize the fdt */
@@ -1047,7 +1057,7 @@ static int fdt_print(const char *pathp, char *prop, int depth)
 static char fdt_help_text[] =
 	"addr [-c]  <addr> [<length>]   - Set the [control] fdt location to <addr>\n"
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
-	"fdt apply <addr>                    - Apply overlay to the DT\n"
+	"fdt apply <addr> [<addr>...]        - Apply overlays to the DT, in order\n"
 #endif
 #ifdef CONFIG_OF_BOARD_SETUP
 	"fdt boardsetup                      - Do board-specific set up\n"
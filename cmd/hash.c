@@ -20,6 +20,18 @@ static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
+	if (argc >= 2 && !strcmp(argv[1], "bench")) {
+		unsigned int size = 0x100000, count = 4;
+
+		if (argc >= 3)
+			size = simple_strtoul(argv[2], NULL, 16);
+		if (argc >= 4)
+			count = simple_strtoul(argv[3], NULL, 10);
+		if (!size || !count)
+			return CMD_RET_USAGE;
+
+		return hash_bench(size, count) ? CMD_RET_FAILURE : 0;
+	}
 #ifdef CONFIG_HASH_VERIFY
 	if (argc < 4)
 		return CMD_RET_USAGE;
@@ -53,4 +65,7 @@ U_BOOT_CMD(
 		"    - verify message digest of memory area to immediate value, \n"
 		"      env var or *address"
 #endif
+	"\nhash bench [size [count]]\n"
+		"    - report throughput of each algorithm and hash engine,\n"
+		"      hashing 'size' (hex) bytes 'count' times"
 );
@@ -605,11 +605,14 @@ U_BOOT_CMD(
 	"    - load binary file from flash bank\n"
 	"      with offset 'off'"
 );
+/* The generic 'ls' command takes this name when it is enabled */
+#ifndef CONFIG_CMD_FS_GENERIC
 U_BOOT_CMD(
 	ls,	2,	1,	do_jffs2_ls,
 	"list files in a directory (default /)",
 	"[ directory ]"
 );
+#endif
 
 U_BOOT_CMD(
 	fsinfo,	1,	1,	do_jffs2_fsinfo,
@@ -23,9 +23,12 @@
 #include <hash.h>
 #include <inttypes.h>
 #include <mapmem.h>
+#include <memtest.h>
 #include <watchdog.h>
+#include <worker.h>
 #include <asm/io.h>
 #include <linux/compiler.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -468,6 +471,17 @@ static int do_mem_cp(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	bytes = size * count;
 	buf = map_sysmem(dest, bytes);
 	src = map_sysmem(addr, bytes);
+#ifdef CONFIG_WORKER
+	/*
+	 * Use all CPUs for large copies which do not overlap, unless an
+	 * access width was given, since worker_memcpy() may use any width
+	 */
+	if (!strchr(argv[0], '.') && bytes >= CONFIG_WORKER_MIN_SIZE &&
+	    (dest + bytes <= addr || addr + bytes <= dest)) {
+		worker_memcpy(buf, src, bytes);
+		count = 0;
+	}
+#endif
 	while (count-- > 0) {
 		if (size == 4)
 			*((u32 *)buf) = *((u32  *)src);
@@ -993,6 +1007,97 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return errs;
 }
 
+#ifdef CONFIG_MEMTEST
+/* Space left for U-Boot's stack when testing all of DRAM */
+#define MTEST_STACK_SIZE	SZ_1M
+
+static int mtest_fast_range(ulong start, ulong end,
+			    struct memtest_result *res)
+{
+	if (end <= start)
+		return 0;
+	printf("Testing %08lx ... %08lx\n", start, end - 1);
+
+	return memtest_run(start, end - start, res);
+}
+
+/* Test all DRAM banks, except for the area used by U-Boot at the top */
+static int mtest_fast_dram(struct memtest_result *res)
+{
+	ulong limit = (gd->start_addr_sp - MTEST_STACK_SIZE) & ~(SZ_4K - 1);
+	ulong start, end;
+	int ret;
+	int i;
+
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		start = gd->bd->bi_dram[i].start;
+		end = start + gd->bd->bi_dram[i].size;
+		ret = mtest_fast_range(start, min(end, limit), res);
+		if (!ret)
+			ret = mtest_fast_range(max(start, (ulong)gd->ram_top),
+					       end, res);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Fast memory test, using 64-bit walking-bit, address and moving-inversions
+ * patterns. This reports the throughput and the data bits which failed.
+ */
+static int mtest_fast(int argc, char * const argv[])
+{
+	struct memtest_result res;
+	ulong start = 0, end = 0;
+	ulong iterations = 1;
+	ulong iteration;
+	ulong ms, mib;
+	ulong base;
+	int ret = 0;
+
+	if (argc > 1 && strict_strtoul(argv[1], 16, &start) < 0)
+		return CMD_RET_USAGE;
+	if (argc > 2 && strict_strtoul(argv[2], 16, &end) < 0)
+		return CMD_RET_USAGE;
+	if (argc > 3 && strict_strtoul(argv[3], 16, &iterations) < 0)
+		return CMD_RET_USAGE;
+	if (argc > 1 && end <= start) {
+		printf("Refusing to do empty test\n");
+		return CMD_RET_FAILURE;
+	}
+
+	memset(&res, '\0', sizeof(res));
+	base = get_timer(0);
+	for (iteration = 0; iteration < iterations && !ret; iteration++) {
+		if (argc > 1)
+			ret = mtest_fast_range(start, end, &res);
+		else
+			ret = mtest_fast_dram(&res);
+	}
+	ms = max(get_timer(base), 1UL);
+
+	if (ret == -EINTR) {
+		puts("Memory test interrupted\n");
+		return CMD_RET_FAILURE;
+	} else if (ret) {
+		printf("Memory test failed (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+	mib = res.bytes >> 20;
+	printf("Tested %lu iteration(s): %lu MiB in %lu ms, %lu MiB/s\n",
+	       iterations, mib, ms, mib * 1000 / ms);
+	if (res.errors) {
+		printf("%lu errors, first at %08lx, failing bits %016llx\n",
+		       res.errors, res.first_fail, res.fail_bits);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+#endif
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -1014,6 +1119,10 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 	const int alt_test = 0;
 #endif
 
+#ifdef CONFIG_MEMTEST
+	if (argc > 1 && !strcmp(argv[1], "-f"))
+		return mtest_fast(argc - 1, argv + 1);
+#endif
 	start = CONFIG_SYS_MEMTEST_START;
 	end = CONFIG_SYS_MEMTEST_END;
 
@@ -1376,6 +1485,11 @@ U_BOOT_CMD(
 	mtest,	5,	1,	do_mem_mtest,
 	"simple RAM read/write test",
 	"[start [end [pattern [iterations]]]]"
+#ifdef CONFIG_MEMTEST
+	"\nmtest -f [start [end [iterations]]]\n"
+	"    - fast test with 64-bit patterns, by default over all of\n"
+	"      the DRAM which is not used by U-Boot"
+#endif
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Throughput benchmark for memcpy(), memmove() and memset()
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <malloc.h>
+#include <linux/sizes.h>
+
+/* Amount of data moved by each operation at each size */
+#define MEMBENCH_BYTES		(16 * SZ_1M)
+
+/* Slack at the end of each buffer, for unaligned and overlapping copies */
+#define MEMBENCH_SLACK		64
+
+struct membench_op {
+	const char *name;
+	void (*run)(u8 *dst, u8 *src, ulong size);
+};
+
+static void membench_memcpy(u8 *dst, u8 *src, ulong size)
+{
+	memcpy(dst, src, size);
+}
+
+static void membench_memcpy_unaligned(u8 *dst, u8 *src, ulong size)
+{
+	memcpy(dst, src + 3, size);
+}
+
+static void membench_memmove(u8 *dst, u8 *src, ulong size)
+{
+	/* Overlapping, with the destination above, so it runs backwards */
+	memmove(src + 8, src, size);
+}
+
+static void membench_memset(u8 *dst, u8 *src, ulong size)
+{
+	memset(dst, 0xa5, size);
+}
+
+static void membench_memzero(u8 *dst, u8 *src, ulong size)
+{
+	memset(dst, '\0', size);
+}
+
+static const struct membench_op membench_ops[] = {
+	{ "memcpy", membench_memcpy },
+	{ "unaligned", membench_memcpy_unaligned },
+	{ "memmove", membench_memmove },
+	{ "memset", membench_memset },
+	{ "zero", membench_memzero },
+};
+
+static const ulong membench_sizes[] = {
+	64, 512, SZ_4K, SZ_64K, SZ_1M, SZ_8M,
+};
+
+/* Return the throughput of @op in MiB/s */
+static ulong membench_run(const struct membench_op *op, u8 *dst, u8 *src,
+			  ulong size)
+{
+	ulong count = max(MEMBENCH_BYTES / size, 1UL);
+	ulong start, us, i;
+
+	start = timer_get_us();
+	for (i = 0; i < count; i++)
+		op->run(dst, src, size);
+	us = max(timer_get_us() - start, 1UL);
+
+	return lldiv((u64)count * size * 1000000, us) >> 20;
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	const struct membench_op *op;
+	ulong max_size = SZ_1M;
+	u8 *src, *dst;
+	int i;
+
+	if (argc > 1)
+		max_size = simple_strtoul(argv[1], NULL, 16);
+	if (!max_size)
+		return CMD_RET_USAGE;
+
+	src = memalign(ARCH_DMA_MINALIGN, max_size + MEMBENCH_SLACK);
+	dst = memalign(ARCH_DMA_MINALIGN, max_size + MEMBENCH_SLACK);
+	if (!src || !dst) {
+		printf("Cannot allocate %lx bytes\n", max_size);
+		free(src);
+		free(dst);
+		return CMD_RET_FAILURE;
+	}
+	memset(src, 0x5a, max_size + MEMBENCH_SLACK);
+
+	printf("%8s", "size");
+	for (op = membench_ops; op < membench_ops + ARRAY_SIZE(membench_ops);
+	     op++)
+		printf(" %10s", op->name);
+	printf("  (MiB/s)\n");
+
+	for (i = 0; i < ARRAY_SIZE(membench_sizes); i++) {
+		ulong size = membench_sizes[i];
+
+		if (size > max_size)
+			break;
+		printf("%8lx", size);
+		for (op = membench_ops;
+		     op < membench_ops + ARRAY_SIZE(membench_ops); op++)
+			printf(" %10lu", membench_run(op, dst, src, size));
+		printf("\n");
+	}
+	free(src);
+	free(dst);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	membench,	2,	1,	do_membench,
+	"measure memcpy(), memmove() and memset() throughput",
+	"[max_size]\n"
+	"    - time each function at sizes from 64 bytes up to max_size\n"
+	"      (hex, default 0x100000), reporting MiB/s"
+);
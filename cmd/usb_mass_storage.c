@@ -92,6 +92,7 @@ static int ums_init(const char *devtype, const char *devnums_part_str)
 		if (!ums_new)
 			goto cleanup;
 		ums = ums_new;
+		memset(&ums[ums_count], '\0', sizeof(*ums));
 
 		/* if partnum = 0, expose all partitions */
 		if (partnum == 0) {
@@ -133,6 +134,22 @@ cleanup:
 	return ret;
 }
 
+static void ums_show_stats(void)
+{
+	struct ums_stats *stats;
+	int i;
+
+	for (i = 0; i < ums_count; i++) {
+		stats = &ums[i].stats;
+		printf("UMS: LUN %d: read ", i);
+		print_size(stats->read_bytes, "");
+		printf(" with %u device reads (", stats->dev_reads);
+		print_size(stats->ra_bytes, " read ahead), wrote ");
+		print_size(stats->write_bytes, "");
+		printf(" with %u device writes\n", stats->dev_writes);
+	}
+}
+
 int do_usb_mass_storage(cmd_tbl_t *cmdtp, int flag,
 			       int argc, char * const argv[])
 {
@@ -231,6 +248,7 @@ int do_usb_mass_storage(cmd_tbl_t *cmdtp, int flag,
 
 cleanup_register:
 	g_dnl_unregister();
+	ums_show_stats();
 cleanup_board:
 	board_usb_cleanup(controller_index, USB_INIT_DEVICE);
 cleanup_ums_init:
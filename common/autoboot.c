@@ -94,6 +94,8 @@ static int passwd_abort(uint64_t etime)
 			/* And check if sha matches saved value in env */
 			if (slow_equals(sha, sha_env, SHA256_SUM_LEN))
 				abort = 1;
+		} else {
+			autoboot_prefetch_step();
 		}
 	} while (!abort && get_ticks() <= etime);
 
@@ -154,6 +156,8 @@ static int passwd_abort(uint64_t etime)
 
 				presskey[i] = getc();
 			}
+		} else {
+			autoboot_prefetch_step();
 		}
 
 		for (i = 0; i < sizeof(delaykey) / sizeof(delaykey[0]); i++) {
@@ -243,7 +247,8 @@ static int __abortboot(int bootdelay)
 # endif
 				break;
 			}
-			udelay(10000);
+			if (!autoboot_prefetch_step())
+				udelay(10000);
 		} while (!abort && get_timer(ts) < 1000);
 
 		printf("\b\b\b%2d ", bootdelay);
@@ -259,8 +264,13 @@ static int abortboot(int bootdelay)
 {
 	int abort = 0;
 
-	if (bootdelay >= 0)
+	if (bootdelay >= 0) {
+		if (bootdelay > 0)
+			autoboot_prefetch_start(getenv("bootprefetch"));
 		abort = __abortboot(bootdelay);
+		if (abort)
+			autoboot_prefetch_cancel();
+	}
 
 #ifdef CONFIG_SILENT_CONSOLE
 	if (abort)
@@ -349,6 +359,7 @@ void autoboot_command(const char *s)
 #endif
 
 		run_command_list(s, -1, 0);
+		autoboot_prefetch_cancel();
 
 #if defined(CONFIG_AUTOBOOT_KEYED) && !defined(CONFIG_AUTOBOOT_KEYED_CTRLC)
 		disable_ctrlc(prev);	/* restore Control C checking */
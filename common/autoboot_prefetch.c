@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Load boot images during the boot delay
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <autoboot.h>
+#include <errno.h>
+#include <fs.h>
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <u-boot/crc.h>
+
+/* Maximum number of files which can be prefetched */
+#define PREFETCH_MAX_FILES	4
+
+enum prefetch_state {
+	PREFETCH_LOAD,		/* Reading the file */
+	PREFETCH_VERIFY,	/* Checking the image hashes */
+	PREFETCH_DONE,		/* Loaded and verified */
+	PREFETCH_FAILED,	/* Could not be loaded, or is corrupt */
+};
+
+/**
+ * struct prefetch_file - a file being prefetched
+ *
+ * @ifname:	Interface name
+ * @dev_part:	Device and partition
+ * @filename:	Name of file
+ * @addr:	Address the file is loaded to
+ * @size:	Size of file in bytes
+ * @pos:	Number of bytes read so far
+ * @crc:	CRC32 of the first @pos bytes
+ * @image:	For a FIT, offset of the next image node to check; -1 before
+ *		the first one is found
+ * @state:	Current state
+ */
+struct prefetch_file {
+	const char *ifname;
+	const char *dev_part;
+	const char *filename;
+	ulong addr;
+	loff_t size;
+	loff_t pos;
+	u32 crc;
+	int image;
+	enum prefetch_state state;
+};
+
+/**
+ * struct prefetch_info - all prefetch state
+ *
+ * @spec:	Copy of the file list, which the strings in @file point into
+ * @count:	Number of files
+ * @file:	Information about each file
+ */
+static struct prefetch_info {
+	char *spec;
+	int count;
+	struct prefetch_file file[PREFETCH_MAX_FILES];
+} pfi;
+
+static u32 prefetch_crc(ulong addr, loff_t size)
+{
+	void *buf = map_sysmem(addr, size);
+	u32 crc;
+
+	crc = crc32_wd(0, buf, size, CHUNKSZ_CRC32);
+	unmap_sysmem(buf);
+
+	return crc;
+}
+
+/* Read the next chunk of a file */
+static void prefetch_load(struct prefetch_file *pf)
+{
+	loff_t len = min_t(loff_t, pf->size - pf->pos,
+			   CONFIG_AUTOBOOT_PREFETCH_CHUNK);
+	loff_t actread;
+	void *buf;
+
+	if (fs_set_blk_dev(pf->ifname, pf->dev_part, FS_TYPE_ANY) ||
+	    fs_read(pf->filename, pf->addr + pf->pos, pf->pos, len, &actread) ||
+	    actread != len) {
+		pf->state = PREFETCH_FAILED;
+		return;
+	}
+
+	buf = map_sysmem(pf->addr + pf->pos, len);
+	pf->crc = crc32_wd(pf->crc, buf, len, CHUNKSZ_CRC32);
+	unmap_sysmem(buf);
+	pf->pos += len;
+	if (pf->pos == pf->size)
+		pf->state = PREFETCH_VERIFY;
+}
+
+#if defined(CONFIG_IMAGE_FORMAT_LEGACY)
+static void prefetch_verify_legacy(struct prefetch_file *pf,
+				   const image_header_t *hdr)
+{
+	if (pf->size < image_get_header_size() || !image_check_hcrc(hdr) ||
+	    image_get_image_size(hdr) > pf->size || !image_check_dcrc(hdr))
+		pf->state = PREFETCH_FAILED;
+}
+#endif
+
+#if IMAGE_ENABLE_FIT
+/* Check all the hashes of a FIT image, without printing anything */
+static bool prefetch_check_fit_image(const void *fit, int image_noffset)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	uint8_t *fit_value;
+	int fit_value_len;
+	const void *data;
+	int value_len;
+	size_t size;
+	char *algo;
+	int noffset;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size))
+		return false;
+	fdt_for_each_subnode(fit, noffset, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    fit_image_hash_get_value(fit, noffset, &fit_value,
+					     &fit_value_len) ||
+		    calculate_hash(data, size, algo, value, &value_len) ||
+		    value_len != fit_value_len ||
+		    memcmp(value, fit_value, value_len))
+			return false;
+	}
+
+	return true;
+}
+
+/* Check the next image in a FIT, returning true when all are done */
+static bool prefetch_verify_fit(struct prefetch_file *pf, const void *fit)
+{
+	int images;
+
+	if (pf->image < 0) {
+		if (!fit_check_format(fit) ||
+		    fdt_totalsize(fit) > pf->size) {
+			pf->state = PREFETCH_FAILED;
+			return true;
+		}
+		images = fdt_path_offset(fit, FIT_IMAGES_PATH);
+		if (images < 0) {
+			pf->state = PREFETCH_FAILED;
+			return true;
+		}
+		pf->image = fdt_first_subnode(fit, images);
+	} else {
+		pf->image = fdt_next_subnode(fit, pf->image);
+	}
+	if (pf->image < 0)
+		return true;
+	if (!prefetch_check_fit_image(fit, pf->image))
+		pf->state = PREFETCH_FAILED;
+
+	return false;
+}
+#endif
+
+/* Verify a loaded file, one step at a time */
+static void prefetch_verify(struct prefetch_file *pf)
+{
+	void *buf = map_sysmem(pf->addr, pf->size);
+	bool done = true;
+
+	switch (genimg_get_format(buf)) {
+#if defined(CONFIG_IMAGE_FORMAT_LEGACY)
+	case IMAGE_FORMAT_LEGACY:
+		prefetch_verify_legacy(pf, buf);
+		break;
+#endif
+#if IMAGE_ENABLE_FIT
+	case IMAGE_FORMAT_FIT:
+		done = prefetch_verify_fit(pf, buf);
+		break;
+#endif
+	default:
+		/* Nothing to check */
+		break;
+	}
+	unmap_sysmem(buf);
+	if (done && pf->state == PREFETCH_VERIFY)
+		pf->state = PREFETCH_DONE;
+}
+
+static void prefetch_step_file(struct prefetch_file *pf)
+{
+	if (pf->state == PREFETCH_LOAD)
+		prefetch_load(pf);
+	else
+		prefetch_verify(pf);
+	if (pf->state == PREFETCH_FAILED)
+		debug("%s: Cannot prefetch '%s'\n", __func__, pf->filename);
+}
+
+/* Parse one '<interface> <dev[:part]> <addr> <filename>' entry */
+static int prefetch_parse(char *entry, struct prefetch_file *pf)
+{
+	char *argv[4], *ep;
+	int argc = 0;
+	char *tok;
+
+	while ((tok = strsep(&entry, " \t"))) {
+		if (!*tok)
+			continue;
+		if (argc == ARRAY_SIZE(argv))
+			return -EINVAL;
+		argv[argc++] = tok;
+	}
+	if (argc != ARRAY_SIZE(argv))
+		return -EINVAL;
+	memset(pf, '\0', sizeof(*pf));
+	pf->ifname = argv[0];
+	pf->dev_part = argv[1];
+	pf->addr = simple_strtoul(argv[2], &ep, 16);
+	if (ep == argv[2] || *ep)
+		return -EINVAL;
+	pf->filename = argv[3];
+	pf->image = -1;
+
+	return 0;
+}
+
+void autoboot_prefetch_start(const char *spec)
+{
+	struct prefetch_file *pf;
+	char *entry, *next;
+
+	autoboot_prefetch_cancel();
+	if (!spec)
+		return;
+	pfi.spec = strdup(spec);
+	if (!pfi.spec)
+		return;
+	for (next = pfi.spec; (entry = strsep(&next, ";"));) {
+		if (pfi.count == PREFETCH_MAX_FILES) {
+			printf("Too many files to prefetch\n");
+			break;
+		}
+		pf = &pfi.file[pfi.count];
+		if (prefetch_parse(entry, pf)) {
+			if (*entry)
+				printf("Invalid bootprefetch entry\n");
+			continue;
+		}
+		pfi.count++;
+
+		if (fs_set_blk_dev(pf->ifname, pf->dev_part, FS_TYPE_ANY) ||
+		    fs_size(pf->filename, &pf->size) || !pf->size) {
+			pf->state = PREFETCH_FAILED;
+			continue;
+		}
+
+		/* Read the first chunk now, while messages are harmless */
+		prefetch_step_file(pf);
+	}
+}
+
+bool autoboot_prefetch_step(void)
+{
+	struct prefetch_file *pf;
+	int i;
+
+	for (i = 0; i < pfi.count; i++) {
+		pf = &pfi.file[i];
+		if (pf->state == PREFETCH_DONE || pf->state == PREFETCH_FAILED)
+			continue;
+		prefetch_step_file(pf);
+
+		return true;
+	}
+
+	return false;
+}
+
+void autoboot_prefetch_cancel(void)
+{
+	free(pfi.spec);
+	memset(&pfi, '\0', sizeof(pfi));
+}
+
+static bool prefetch_str_match(const char *s1, const char *s2)
+{
+	return s1 && s2 && !strcmp(s1, s2);
+}
+
+bool autoboot_prefetch_claim(const char *ifname, const char *dev_part,
+			     ulong addr, const char *filename, loff_t *sizep)
+{
+	struct prefetch_file *pf;
+	int i;
+
+	for (i = 0; i < pfi.count; i++) {
+		pf = &pfi.file[i];
+		if (pf->state != PREFETCH_DONE || pf->addr != addr ||
+		    !prefetch_str_match(pf->ifname, ifname) ||
+		    !prefetch_str_match(pf->dev_part, dev_part) ||
+		    !prefetch_str_match(pf->filename, filename))
+			continue;
+
+		/* Make sure nothing has written over it since */
+		if (prefetch_crc(pf->addr, pf->size) != pf->crc) {
+			pf->state = PREFETCH_FAILED;
+			return false;
+		}
+		*sizep = pf->size;
+
+		return true;
+	}
+
+	return false;
+}
@@ -763,6 +763,9 @@ static int setup_reloc(void)
 	      gd->relocaddr, (ulong)map_to_sysmem(gd->new_gd),
 	      gd->start_addr_sp);
 
+	/* The time from here until board_init_r() is spent relocating */
+	bootstage_mark_name(BOOTSTAGE_ID_RELOCATE, "relocate");
+
 	return 0;
 }
 
@@ -801,6 +804,11 @@ static int jump_to_copy(void)
 /* Record the board_init_f() bootstage (after arch_cpu_init()) */
 static int mark_bootstage(void)
 {
+#ifdef CONFIG_SPL_BOOTSTAGE
+	/* Pick up the timings stashed by SPL, if any */
+	bootstage_unstash((void *)CONFIG_BOOTSTAGE_STASH_ADDR,
+			  CONFIG_BOOTSTAGE_STASH_SIZE);
+#endif
 	bootstage_mark_name(BOOTSTAGE_ID_START_UBOOT_F, "board_init_f");
 
 	return 0;
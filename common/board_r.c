@@ -40,6 +40,7 @@
 #include <miiphy.h>
 #endif
 #include <mmc.h>
+#include <of_live.h>
 #include <nand.h>
 #include <onenand_uboot.h>
 #include <scsi.h>
@@ -48,6 +49,7 @@
 #include <stdio_dev.h>
 #include <timer.h>
 #include <trace.h>
+#include <uthread.h>
 #include <watchdog.h>
 #ifdef CONFIG_CMD_AMBAPP
 #include <ambapp.h>
@@ -314,6 +316,21 @@ static int initr_noncached(void)
 }
 #endif
 
+#ifdef CONFIG_OF_LIVE
+static int initr_of_live(void)
+{
+	int ret;
+
+	if (!gd->fdt_blob)
+		return 0;
+	bootstage_start(BOOTSTAGE_ID_ACCUM_OF_LIVE, "of_live");
+	ret = of_live_build(gd->fdt_blob, &gd->of_root);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_OF_LIVE);
+
+	return ret;
+}
+#endif
+
 #ifdef CONFIG_DM
 static int initr_dm(void)
 {
@@ -660,6 +677,45 @@ static int initr_net(void)
 }
 #endif
 
+#ifdef CONFIG_UTHREAD_INITR
+/*
+ * These mostly wait for their own hardware, so each runs in a thread and
+ * lets the others run while it does so. The output is kept in order. They
+ * are started where initr_net() would run, so initr_scsi() comes after
+ * initr_doc() and initr_bbmii() rather than before them.
+ */
+static init_fnc_t init_sequence_r_uthread[] = {
+#ifdef CONFIG_SCSI
+	initr_scsi,
+#endif
+#ifdef CONFIG_CMD_NET
+	initr_net,
+#endif
+};
+
+static int initr_uthread_run(void *arg)
+{
+	init_fnc_t *fn = arg;
+
+	return (*fn)();
+}
+
+static int initr_uthread(void)
+{
+	int ret;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(init_sequence_r_uthread); i++) {
+		ret = uthread_create(initr_uthread_run,
+				     &init_sequence_r_uthread[i], "initr");
+		if (ret)
+			return ret;
+	}
+
+	return uthread_join_all();
+}
+#endif
+
 #ifdef CONFIG_POST
 static int initr_post(void)
 {
@@ -781,6 +837,9 @@ init_fnc_t init_sequence_r[] = {
 	initr_noncached,
 #endif
 	bootstage_relocate,
+#ifdef CONFIG_OF_LIVE
+	initr_of_live,
+#endif
 #ifdef CONFIG_DM
 	initr_dm,
 #endif
@@ -923,7 +982,7 @@ init_fnc_t init_sequence_r[] = {
 	initr_ambapp_print,
 #endif
 #endif
-#ifdef CONFIG_SCSI
+#if defined(CONFIG_SCSI) && !defined(CONFIG_UTHREAD_INITR)
 	INIT_FUNC_WATCHDOG_RESET
 	initr_scsi,
 #endif
@@ -934,7 +993,10 @@ init_fnc_t init_sequence_r[] = {
 #ifdef CONFIG_BITBANGMII
 	initr_bbmii,
 #endif
-#ifdef CONFIG_CMD_NET
+#ifdef CONFIG_UTHREAD_INITR
+	INIT_FUNC_WATCHDOG_RESET
+	initr_uthread,
+#elif defined(CONFIG_CMD_NET)
 	INIT_FUNC_WATCHDOG_RESET
 	initr_net,
 #endif
@@ -989,6 +1051,10 @@ void board_init_r(gd_t *new_gd, ulong dest_addr)
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 	for (i = 0; i < ARRAY_SIZE(init_sequence_r); i++)
 		init_sequence_r[i] += gd->reloc_off;
+#ifdef CONFIG_UTHREAD_INITR
+	for (i = 0; i < ARRAY_SIZE(init_sequence_r_uthread); i++)
+		init_sequence_r_uthread[i] += gd->reloc_off;
+#endif
 #endif
 
 	if (initcall_run_list(init_sequence_r))
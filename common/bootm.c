@@ -616,11 +616,18 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	if (states & BOOTM_STATE_START)
 		ret = bootm_start(cmdtp, flag, argc, argv);
 
+	/*
+	 * Finding the images also verifies them. A FIT subimage can be checked
+	 * more than once (by several hash and signature nodes, or when it is
+	 * used for more than one purpose), so only hash its data once.
+	 */
+	fit_hash_cache_start();
 	if (!ret && (states & BOOTM_STATE_FINDOS))
 		ret = bootm_find_os(cmdtp, flag, argc, argv);
 
 	if (!ret && (states & BOOTM_STATE_FINDOTHER))
 		ret = bootm_find_other(cmdtp, flag, argc, argv);
+	fit_hash_cache_stop();
 
 	/* Load the OS */
 	if (!ret && (states & BOOTM_STATE_LOADOS)) {
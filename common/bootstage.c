@@ -27,7 +27,19 @@ struct bootstage_record {
 	enum bootstage_id id;
 };
 
-static struct bootstage_record record[BOOTSTAGE_ID_COUNT] = { {1} };
+/*
+ * Records are kept in the order they are added, not indexed by ID, so that
+ * SPL can get by with space for only the few stages it records.
+ */
+#ifdef CONFIG_SPL_BUILD
+#define RECORD_COUNT	CONFIG_SPL_BOOTSTAGE_RECORD_COUNT
+#else
+#define RECORD_COUNT	BOOTSTAGE_ID_COUNT
+#endif
+
+/* These are used before relocation, so must not be in BSS */
+static struct bootstage_record record[RECORD_COUNT] = { {1} };
+static int rec_count __attribute__((section(".data")));
 static int next_id = BOOTSTAGE_ID_USER;
 
 enum {
@@ -51,13 +63,36 @@ int bootstage_relocate(void)
 	 * Duplicate all strings.  They may point to an old location in the
 	 * program .text section that can eventually get trashed.
 	 */
-	for (i = 0; i < BOOTSTAGE_ID_COUNT; i++)
+	for (i = 0; i < rec_count; i++)
 		if (record[i].name)
 			record[i].name = strdup(record[i].name);
 
 	return 0;
 }
 
+/**
+ * find_id() - Find the record for a bootstage ID, adding it if needed
+ *
+ * @id:		Bootstage ID to look up
+ * @return pointer to the record, or NULL if it is new and there is no space
+ */
+static struct bootstage_record *find_id(enum bootstage_id id)
+{
+	struct bootstage_record *rec;
+
+	for (rec = record; rec < record + rec_count; rec++) {
+		if (rec->id == id)
+			return rec;
+	}
+	if (rec_count == RECORD_COUNT)
+		return NULL;
+	rec_count++;
+	memset(rec, '\0', sizeof(*rec));
+	rec->id = id;
+
+	return rec;
+}
+
 ulong bootstage_add_record(enum bootstage_id id, const char *name,
 			   int flags, ulong mark)
 {
@@ -67,10 +102,10 @@ ulong bootstage_add_record(enum bootstage_id id, const char *name,
 		id = next_id++;
 
 	if (id < BOOTSTAGE_ID_COUNT) {
-		rec = &record[id];
+		rec = find_id(id);
 
 		/* Only record the first event for each */
-		if (!rec->time_us) {
+		if (rec && !rec->time_us) {
 			rec->time_us = mark;
 			rec->name = name;
 			rec->flags = flags;
@@ -133,18 +168,23 @@ ulong bootstage_mark_code(const char *file, const char *func, int linenum)
 
 uint32_t bootstage_start(enum bootstage_id id, const char *name)
 {
-	struct bootstage_record *rec = &record[id];
+	struct bootstage_record *rec = find_id(id);
+	uint32_t start_us = timer_get_boot_us();
 
-	rec->start_us = timer_get_boot_us();
+	if (!rec)
+		return start_us;
+	rec->start_us = start_us;
 	rec->name = name;
 	return rec->start_us;
 }
 
 uint32_t bootstage_accum(enum bootstage_id id)
 {
-	struct bootstage_record *rec = &record[id];
+	struct bootstage_record *rec = find_id(id);
 	uint32_t duration;
 
+	if (!rec)
+		return 0;
 	duration = (uint32_t)timer_get_boot_us() - rec->start_us;
 	rec->time_us += duration;
 	return duration;
@@ -204,9 +244,9 @@ static int h_compare_record(const void *r1, const void *r2)
  */
 static int add_bootstages_devicetree(struct fdt_header *blob)
 {
+	struct bootstage_record *rec;
 	int bootstage;
 	char buf[20];
-	int id;
 	int i;
 
 	if (!blob)
@@ -224,11 +264,10 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 	 * Insert the timings to the device tree in the reverse order so
 	 * that they can be printed in the Linux kernel in the right order.
 	 */
-	for (id = BOOTSTAGE_ID_COUNT - 1, i = 0; id >= 0; id--, i++) {
-		struct bootstage_record *rec = &record[id];
+	for (rec = record + rec_count, i = 0; rec-- > record; i++) {
 		int node;
 
-		if (id != BOOTSTAGE_ID_AWAKE && rec->time_us == 0)
+		if (rec->id != BOOTSTAGE_ID_AWAKE && rec->time_us == 0)
 			continue;
 
 		node = fdt_add_subnode(blob, bootstage, simple_itoa(i));
@@ -261,22 +300,21 @@ int bootstage_fdt_add_report(void)
 
 void bootstage_report(void)
 {
-	struct bootstage_record *rec = record;
-	int id;
+	struct bootstage_record reset, *rec;
 	uint32_t prev;
 
 	puts("Timer summary in microseconds:\n");
 	printf("%11s%11s  %s\n", "Mark", "Elapsed", "Stage");
 
 	/* Fake the first record - we could get it from early boot */
-	rec->name = "reset";
-	rec->time_us = 0;
-	prev = print_time_record(BOOTSTAGE_ID_AWAKE, rec, 0);
+	memset(&reset, '\0', sizeof(reset));
+	reset.name = "reset";
+	prev = print_time_record(BOOTSTAGE_ID_AWAKE, &reset, 0);
 
 	/* Sort records by increasing time */
-	qsort(record, ARRAY_SIZE(record), sizeof(*rec), h_compare_record);
+	qsort(record, rec_count, sizeof(*rec), h_compare_record);
 
-	for (id = 0; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
+	for (rec = record; rec < record + rec_count; rec++) {
 		if (rec->time_us != 0 && !rec->start_us)
 			prev = print_time_record(rec->id, rec, prev);
 	}
@@ -286,9 +324,9 @@ void bootstage_report(void)
 		       next_id - BOOTSTAGE_ID_COUNT);
 
 	puts("\nAccumulated time:\n");
-	for (id = 0, rec = record; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
+	for (rec = record; rec < record + rec_count; rec++) {
 		if (rec->start_us)
-			prev = print_time_record(id, rec, -1);
+			prev = print_time_record(rec->id, rec, -1);
 	}
 }
 
@@ -338,7 +376,6 @@ int bootstage_stash(void *base, int size)
 	char buf[20];
 	char *ptr = base, *end = ptr + size;
 	uint32_t count;
-	int id;
 
 	if (hdr + 1 > (struct bootstage_hdr *)end) {
 		debug("%s: Not enough space for bootstage hdr\n", __func__);
@@ -349,8 +386,7 @@ int bootstage_stash(void *base, int size)
 	hdr->version = BOOTSTAGE_VERSION;
 
 	/* Count the number of records, and write that value first */
-	for (rec = record, id = count = 0; id < BOOTSTAGE_ID_COUNT;
-			id++, rec++) {
+	for (rec = record, count = 0; rec < record + rec_count; rec++) {
 		if (rec->time_us != 0)
 			count++;
 	}
@@ -360,13 +396,13 @@ int bootstage_stash(void *base, int size)
 	ptr += sizeof(*hdr);
 
 	/* Write the records, silently stopping when we run out of space */
-	for (rec = record, id = 0; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
+	for (rec = record; rec < record + rec_count; rec++) {
 		if (rec->time_us != 0)
 			append_data(&ptr, end, rec, sizeof(*rec));
 	}
 
 	/* Write the name strings */
-	for (rec = record, id = 0; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
+	for (rec = record; rec < record + rec_count; rec++) {
 		if (rec->time_us != 0) {
 			const char *name;
 
@@ -427,7 +463,8 @@ int bootstage_unstash(void *base, int size)
 		return -1;
 	}
 
-	if (next_id + hdr->count > BOOTSTAGE_ID_COUNT) {
+	if (next_id + hdr->count > BOOTSTAGE_ID_COUNT ||
+	    rec_count + hdr->count > RECORD_COUNT) {
 		debug("%s: Bootstage has %d records, we have space for %d\n"
 			"- please increase CONFIG_BOOTSTAGE_USER_COUNT\n",
 		      __func__, hdr->count, BOOTSTAGE_ID_COUNT - next_id);
@@ -438,19 +475,23 @@ int bootstage_unstash(void *base, int size)
 
 	/* Read the records */
 	rec_size = hdr->count * sizeof(*record);
-	memcpy(record + next_id, ptr, rec_size);
+	memcpy(record + rec_count, ptr, rec_size);
 
-	/* Read the name strings */
+	/*
+	 * Read the name strings. Each record gets a new user ID, so that it
+	 * cannot clash with one allocated here.
+	 */
 	ptr += rec_size;
-	for (rec = record + next_id, id = 0; id < hdr->count; id++, rec++) {
+	for (rec = record + rec_count, id = 0; id < hdr->count; id++, rec++) {
 		rec->name = ptr;
+		rec->id = next_id++;
 
 		/* Assume no data corruption here */
 		ptr += strlen(ptr) + 1;
 	}
 
 	/* Mark the records as read */
-	next_id += hdr->count;
+	rec_count += hdr->count;
 	printf("Unstashed %d records\n", hdr->count);
 
 	return 0;
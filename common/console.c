@@ -14,6 +14,7 @@
 #include <os.h>
 #include <serial.h>
 #include <stdio_dev.h>
+#include <uthread.h>
 #include <exports.h>
 #include <environment.h>
 
@@ -474,6 +475,9 @@ void putc(const char c)
 		return;
 	}
 #endif
+	/* Keep output from threads in order */
+	if (uthread_hold_output(&c, 1))
+		return;
 #ifdef CONFIG_CONSOLE_RECORD
 	if (gd && (gd->flags & GD_FLG_RECORD) && gd->console_out.start)
 		membuff_putbyte(&gd->console_out, c);
@@ -519,6 +523,8 @@ void puts(const char *s)
 		return;
 	}
 #endif
+	if (uthread_hold_output(s, strlen(s)))
+		return;
 #ifdef CONFIG_CONSOLE_RECORD
 	if (gd && (gd->flags & GD_FLG_RECORD) && gd->console_out.start)
 		membuff_put(&gd->console_out, s, strlen(s));
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Block-level delta updates, from an A slot to a B slot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <delta.h>
+#include <errno.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <linux/log2.h>
+#include <linux/sizes.h>
+
+/* Most data read or written in one go */
+#define DELTA_CHUNK_SIZE	SZ_256K
+
+static const struct delta_op *delta_ops(const struct delta_header *delta)
+{
+	return (const struct delta_op *)(delta + 1);
+}
+
+static const u8 *delta_hashes(const struct delta_header *delta)
+{
+	return (const u8 *)(delta_ops(delta) + be32_to_cpu(delta->op_count));
+}
+
+static const u8 *delta_data(const struct delta_header *delta)
+{
+	return delta_hashes(delta) +
+		be32_to_cpu(delta->dst_blocks) * DELTA_HASH_SIZE;
+}
+
+int delta_check(const struct delta_header *delta, ulong size)
+{
+	ulong block_size, src_blocks, dst_blocks, op_count, total;
+	ulong blocks = 0, data_blocks = 0;
+	u8 hash[DELTA_HASH_SIZE];
+	const struct delta_op *op;
+	ulong count, arg, i;
+	u64 expect;
+
+	if (size < sizeof(*delta) || be32_to_cpu(delta->magic) != DELTA_MAGIC)
+		return -ENOEXEC;
+	if (be32_to_cpu(delta->version) != DELTA_VERSION)
+		return -EPROTONOSUPPORT;
+	block_size = be32_to_cpu(delta->block_size);
+	if (block_size < DELTA_MIN_BLOCK_SIZE ||
+	    block_size > DELTA_MAX_BLOCK_SIZE || !is_power_of_2(block_size))
+		return -EINVAL;
+	total = be32_to_cpu(delta->size);
+	if (total > size)
+		return -E2BIG;
+
+	src_blocks = be32_to_cpu(delta->src_blocks);
+	dst_blocks = be32_to_cpu(delta->dst_blocks);
+	op_count = be32_to_cpu(delta->op_count);
+	expect = sizeof(*delta) + (u64)op_count * sizeof(*op) +
+		(u64)dst_blocks * DELTA_HASH_SIZE;
+	if (expect > total)
+		return -EINVAL;
+	sha256_csum_wd((const u8 *)(delta + 1), total - sizeof(*delta), hash,
+		       CHUNKSZ_SHA256);
+	if (memcmp(hash, delta->body_hash, DELTA_HASH_SIZE))
+		return -EBADMSG;
+
+	for (i = 0, op = delta_ops(delta); i < op_count; i++, op++) {
+		count = be32_to_cpu(op->count);
+		arg = be32_to_cpu(op->arg);
+		if (!count || count > dst_blocks - blocks)
+			return -EINVAL;
+		switch (be32_to_cpu(op->type)) {
+		case DELTA_OP_COPY:
+			if (arg > src_blocks || count > src_blocks - arg)
+				return -EINVAL;
+			break;
+		case DELTA_OP_ZERO:
+			break;
+		case DELTA_OP_DATA:
+			data_blocks += count;
+			break;
+		default:
+			return -EINVAL;
+		}
+		blocks += count;
+	}
+	if (blocks != dst_blocks ||
+	    expect + (u64)data_blocks * block_size != total)
+		return -EINVAL;
+
+	return 0;
+}
+
+/* Read or write @count blocks of a slot, starting at block @blk */
+static int delta_xfer(struct blk_desc *desc, disk_partition_t *part,
+		      ulong block_size, ulong blk, ulong count, void *buf,
+		      bool write)
+{
+	ulong per_block = block_size / desc->blksz;
+	lbaint_t start = part->start + (lbaint_t)blk * per_block;
+	ulong n;
+
+	count *= per_block;
+	if (write)
+		n = blk_dwrite(desc, start, count, buf);
+	else
+		n = blk_dread(desc, start, count, buf);
+	if (n != count) {
+		debug("%s: Cannot %s %lu blocks at " LBAF "\n", __func__,
+		      write ? "write" : "read", count, start);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Count how many of the blocks in @buf match their hashes */
+static ulong delta_matching(const u8 *buf, const u8 *hash, ulong count,
+			    ulong block_size)
+{
+	u8 sum[DELTA_HASH_SIZE];
+	ulong i;
+
+	for (i = 0; i < count; i++) {
+		sha256_csum_wd(buf + i * block_size, block_size, sum,
+			       CHUNKSZ_SHA256);
+		if (memcmp(sum, hash + i * DELTA_HASH_SIZE, DELTA_HASH_SIZE))
+			break;
+	}
+
+	return i;
+}
+
+/* Check that a slot can hold @blocks blocks of @block_size bytes */
+static int delta_check_slot(struct blk_desc *desc, disk_partition_t *part,
+			    ulong block_size, ulong blocks)
+{
+	if (block_size % desc->blksz)
+		return -EINVAL;
+	if ((u64)blocks * (block_size / desc->blksz) > part->size)
+		return -EINVAL;
+
+	return 0;
+}
+
+int delta_apply(const struct delta_header *delta, struct blk_desc *src_desc,
+		disk_partition_t *src, struct blk_desc *dst_desc,
+		disk_partition_t *dst, struct delta_stats *stats)
+{
+	ulong block_size = be32_to_cpu(delta->block_size);
+	ulong op_count = be32_to_cpu(delta->op_count);
+	const struct delta_op *op = delta_ops(delta);
+	const u8 *hash = delta_hashes(delta);
+	const u8 *data = delta_data(delta);
+	ulong chunk, count, arg, done, ok, n, i;
+	ulong blk = 0;
+	bool resuming = true;
+	ulong *stat;
+	int ret = 0;
+	u8 *buf;
+
+	memset(stats, '\0', sizeof(*stats));
+	if (delta_check_slot(src_desc, src, block_size,
+			     be32_to_cpu(delta->src_blocks)) ||
+	    delta_check_slot(dst_desc, dst, block_size,
+			     be32_to_cpu(delta->dst_blocks)))
+		return -EINVAL;
+	if (src_desc == dst_desc && src->start < dst->start + dst->size &&
+	    dst->start < src->start + src->size)
+		return -EINVAL;
+
+	chunk = max(DELTA_CHUNK_SIZE / block_size, 1UL);
+	buf = malloc_cache_aligned(chunk * block_size);
+	if (!buf)
+		return -ENOMEM;
+
+	for (i = 0; i < op_count; i++, op++) {
+		count = be32_to_cpu(op->count);
+		arg = be32_to_cpu(op->arg);
+		for (done = 0; done < count; done += n) {
+			n = min(count - done, chunk);
+
+			/*
+			 * Writes go from start to end, so once a block is
+			 * found which was not written, none after it were
+			 */
+			if (resuming) {
+				ret = delta_xfer(dst_desc, dst, block_size, blk,
+						 n, buf, false);
+				if (ret)
+					goto out;
+				ok = delta_matching(buf, hash, n, block_size);
+				resuming = ok == n;
+				if (ok) {
+					n = ok;
+					stats->skipped += n;
+					goto next;
+				}
+			}
+
+			switch (be32_to_cpu(op->type)) {
+			case DELTA_OP_COPY:
+				ret = delta_xfer(src_desc, src, block_size,
+						 arg + done, n, buf, false);
+				if (ret)
+					goto out;
+				stat = &stats->copied;
+				break;
+			case DELTA_OP_ZERO:
+				memset(buf, '\0', n * block_size);
+				stat = &stats->zeroed;
+				break;
+			case DELTA_OP_DATA:
+			default:
+				memcpy(buf, data, n * block_size);
+				stat = &stats->data;
+				break;
+			}
+
+			/* Write the good blocks, up to any which is not */
+			ok = delta_matching(buf, hash, n, block_size);
+			if (ok)
+				ret = delta_xfer(dst_desc, dst, block_size, blk,
+						 ok, buf, true);
+			if (ret)
+				goto out;
+			*stat += ok;
+			if (ok != n) {
+				printf("Delta block %lu does not match its hash\n",
+				       blk + ok);
+				ret = -EILSEQ;
+				goto out;
+			}
+next:
+			blk += n;
+			hash += n * DELTA_HASH_SIZE;
+			if (be32_to_cpu(op->type) == DELTA_OP_DATA)
+				data += n * block_size;
+		}
+	}
+out:
+	free(buf);
+
+	return ret;
+}
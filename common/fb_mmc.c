@@ -69,25 +69,37 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 }
 
 static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
-		const char *part_name, void *buffer,
+		const char *part_name, u64 offset, void *buffer,
 		unsigned int download_bytes)
 {
+	lbaint_t blkstart;
 	lbaint_t blkcnt;
 	lbaint_t blks;
 
+	if (offset & (info->blksz - 1)) {
+		error("offset not a multiple of the block size: '%s'\n",
+		      part_name);
+		fastboot_fail("offset not aligned to a block");
+		return;
+	}
+	blkstart = lldiv(offset, info->blksz);
+
 	/* determine number of blocks to write */
 	blkcnt = ((download_bytes + (info->blksz - 1)) & ~(info->blksz - 1));
 	blkcnt = lldiv(blkcnt, info->blksz);
 
-	if (blkcnt > info->size) {
+	if (blkstart + blkcnt > info->size) {
 		error("too large for partition: '%s'\n", part_name);
 		fastboot_fail("too large for partition");
 		return;
 	}
 
-	puts("Flashing Raw Image\n");
+	if (offset)
+		printf("Flashing Raw Image at offset 0x%llx\n", offset);
+	else
+		puts("Flashing Raw Image\n");
 
-	blks = blk_dwrite(dev_desc, info->start, blkcnt, buffer);
+	blks = blk_dwrite(dev_desc, info->start + blkstart, blkcnt, buffer);
 	if (blks != blkcnt) {
 		error("failed writing to device %d\n", dev_desc->devnum);
 		fastboot_fail("failed writing to device");
@@ -99,12 +111,21 @@ static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 	fastboot_okay("");
 }
 
-void fb_mmc_flash_write(const char *cmd, void *download_buffer,
+void fb_mmc_flash_write(const char *cmd, u64 offset, void *download_buffer,
 			unsigned int download_bytes)
 {
 	struct blk_desc *dev_desc;
 	disk_partition_t info;
 
+	/* Only raw images can be written in parts */
+	if (offset && (!strcmp(cmd, CONFIG_FASTBOOT_GPT_NAME) ||
+		       !strcmp(cmd, CONFIG_FASTBOOT_MBR_NAME) ||
+		       is_sparse_image(download_buffer))) {
+		error("cannot write '%s' at an offset\n", cmd);
+		fastboot_fail("offset not supported for this image");
+		return;
+	}
+
 	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
 	if (!dev_desc || dev_desc->type == DEV_TYPE_UNKNOWN) {
 		error("invalid mmc device\n");
@@ -178,7 +199,7 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 		write_sparse_image(&sparse, cmd, download_buffer,
 				   download_bytes);
 	} else {
-		write_raw_image(dev_desc, &info, cmd, download_buffer,
+		write_raw_image(dev_desc, &info, cmd, offset, download_buffer,
 				download_bytes);
 	}
 }
@@ -0,0 +1,688 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Batched editing of a flattened device tree. Edits are collected in side
+ * tables and the new tree is written in one pass, instead of moving the
+ * rest of the tree for every change as libfdt does.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_batch.h>
+#include <malloc.h>
+
+#define TAGALIGN(x)	ALIGN(x, FDT_TAGSIZE)
+
+/* Kinds of property edit */
+enum {
+	BATCH_PROP_ADD,		/* new property, at the start of its node */
+	BATCH_PROP_SET,		/* new value for a property in the tree */
+	BATCH_PROP_DEL,		/* delete a property in the tree */
+	BATCH_PROP_DEAD,	/* a new property which was deleted again */
+};
+
+/**
+ * struct fdt_batch_prop - An edit to a property
+ *
+ * @node:	Offset of node containing the property
+ * @seq:	Position of this edit in the order they were made
+ * @kind:	BATCH_PROP_...
+ * @nameoff:	Offset of property name in the (new) strings block
+ * @valoff:	Offset of value in the batch's value buffer
+ * @len:	Length of value in bytes
+ */
+struct fdt_batch_prop {
+	int node;
+	int seq;
+	int kind;
+	int nameoff;
+	int valoff;
+	int len;
+};
+
+/**
+ * struct fdt_batch_node - A node added by the batch
+ *
+ * @parent:	Offset of parent node
+ * @nameoff:	Offset of node name in the batch's value buffer
+ * @namelen:	Length of node name, excluding terminator
+ */
+struct fdt_batch_node {
+	int parent;
+	int nameoff;
+	int namelen;
+};
+
+static inline bool batch_is_new(struct fdt_batch *batch, int offset)
+{
+	return offset >= batch->struct_size;
+}
+
+static inline int batch_new_offset(struct fdt_batch *batch, int idx)
+{
+	return batch->struct_size + idx;
+}
+
+static int batch_grow(void **bufp, int *maxp, int count, int size)
+{
+	int new_max;
+	void *buf;
+
+	if (count <= *maxp)
+		return 0;
+	new_max = max(count, *maxp * 2);
+	new_max = max(new_max, 16);
+	buf = realloc(*bufp, new_max * size);
+	if (!buf)
+		return -FDT_ERR_NOSPACE;
+	*bufp = buf;
+	*maxp = new_max;
+
+	return 0;
+}
+
+/* Copy data into the value buffer, returning its offset */
+static int batch_add_val(struct fdt_batch *batch, const void *val, int len)
+{
+	int ret, offset = batch->vals_size;
+
+	ret = batch_grow((void **)&batch->vals, &batch->vals_max,
+			 offset + len + 1, 1);
+	if (ret)
+		return ret;
+	memcpy(batch->vals + offset, val, len);
+	batch->vals[offset + len] = '\0';
+	batch->vals_size += len + 1;
+
+	return offset;
+}
+
+static const char *batch_string(struct fdt_batch *batch, int nameoff)
+{
+	int size = fdt_size_dt_strings(batch->fdt);
+
+	if (nameoff < size)
+		return fdt_string(batch->fdt, nameoff);
+
+	return batch->strings + nameoff - size;
+}
+
+/* Search a string table in the same way as libfdt, including partial ones */
+static const char *batch_find_string(const char *strtab, int tabsize,
+				     const char *s, int len)
+{
+	const char *p;
+
+	if (tabsize < len)
+		return NULL;
+	for (p = strtab; p <= strtab + tabsize - len; p++) {
+		if (!memcmp(p, s, len))
+			return p;
+	}
+
+	return NULL;
+}
+
+static int *batch_cache_slot(struct fdt_batch *batch, const char *s)
+{
+	uint hash = 0;
+
+	while (*s)
+		hash = hash * 31 + (uint8_t)*s++;
+
+	return &batch->string_cache[hash % FDT_BATCH_STRING_CACHE];
+}
+
+/*
+ * Find a property name, adding it to the new strings if needed
+ *
+ * Searching the strings is slow for large trees, so remember where recent
+ * names were found. Strings are only ever added to the end, so the first
+ * match for a name never changes.
+ */
+static int batch_find_add_string(struct fdt_batch *batch, const char *s)
+{
+	const char *strtab = fdt_string(batch->fdt, 0);
+	int size = fdt_size_dt_strings(batch->fdt);
+	int *slot = batch_cache_slot(batch, s);
+	int len = strlen(s) + 1;
+	const char *p;
+	int ret;
+
+	if (*slot && !strcmp(batch_string(batch, *slot - 1), s))
+		return *slot - 1;
+	p = batch_find_string(strtab, size, s, len);
+	if (p) {
+		*slot = p - strtab + 1;
+		return *slot - 1;
+	}
+	p = batch_find_string(batch->strings, batch->strings_size, s, len);
+	if (!p) {
+		ret = batch_grow((void **)&batch->strings,
+				 &batch->strings_max,
+				 batch->strings_size + len, 1);
+		if (ret)
+			return ret;
+		p = batch->strings + batch->strings_size;
+		memcpy(batch->strings + batch->strings_size, s, len);
+		batch->strings_size += len;
+	}
+	*slot = size + p - batch->strings + 1;
+
+	return *slot - 1;
+}
+
+static int batch_check_node(struct fdt_batch *batch, int nodeoffset)
+{
+	int nextoffset;
+
+	if (batch_is_new(batch, nodeoffset)) {
+		if (nodeoffset - batch->struct_size >= batch->node_count)
+			return -FDT_ERR_BADOFFSET;
+		return 0;
+	}
+	if (nodeoffset < 0 || nodeoffset % FDT_TAGSIZE ||
+	    fdt_next_tag(batch->fdt, nodeoffset, &nextoffset) !=
+			FDT_BEGIN_NODE)
+		return -FDT_ERR_BADOFFSET;
+
+	return 0;
+}
+
+/* Find the most recent edit of a property which has not been undone */
+static struct fdt_batch_prop *batch_find_prop(struct fdt_batch *batch,
+					      int nodeoffset, const char *name)
+{
+	struct fdt_batch_prop *prop;
+
+	for (prop = batch->props + batch->prop_count; prop-- > batch->props;) {
+		if (prop->node == nodeoffset && prop->kind != BATCH_PROP_DEAD &&
+		    !strcmp(batch_string(batch, prop->nameoff), name))
+			return prop;
+	}
+
+	return NULL;
+}
+
+static struct fdt_batch_prop *batch_new_prop(struct fdt_batch *batch,
+					     int nodeoffset, int kind,
+					     int nameoff)
+{
+	struct fdt_batch_prop *prop;
+
+	if (batch_grow((void **)&batch->props, &batch->prop_max,
+		       batch->prop_count + 1, sizeof(*prop)))
+		return NULL;
+	prop = &batch->props[batch->prop_count];
+	prop->node = nodeoffset;
+	prop->seq = batch->prop_count++;
+	prop->kind = kind;
+	prop->nameoff = nameoff;
+	prop->valoff = 0;
+	prop->len = 0;
+
+	return prop;
+}
+
+int fdt_batch_init(struct fdt_batch *batch, void *fdt)
+{
+	int ret;
+
+	memset(batch, '\0', sizeof(*batch));
+	ret = fdt_check_header(fdt);
+	if (ret)
+		return ret;
+
+	/* The same layout which libfdt needs to edit the tree */
+	if (fdt_version(fdt) < 17)
+		return -FDT_ERR_BADVERSION;
+	if (fdt_off_mem_rsvmap(fdt) < ALIGN(sizeof(struct fdt_header), 8) ||
+	    fdt_off_dt_struct(fdt) < fdt_off_mem_rsvmap(fdt) +
+			sizeof(struct fdt_reserve_entry) ||
+	    fdt_off_dt_strings(fdt) < fdt_off_dt_struct(fdt) +
+			fdt_size_dt_struct(fdt) ||
+	    fdt_totalsize(fdt) < fdt_off_dt_strings(fdt) +
+			fdt_size_dt_strings(fdt))
+		return -FDT_ERR_BADLAYOUT;
+	batch->fdt = fdt;
+	batch->struct_size = fdt_size_dt_struct(fdt);
+
+	return 0;
+}
+
+int fdt_batch_setprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name, const void *val, int len)
+{
+	const struct fdt_property *old;
+	struct fdt_batch_prop *prop;
+	int kind, nameoff, valoff;
+	int ret;
+
+	ret = batch_check_node(batch, nodeoffset);
+	if (ret)
+		return ret;
+	prop = batch_find_prop(batch, nodeoffset, name);
+	if (!prop || prop->kind == BATCH_PROP_DEL) {
+		old = NULL;
+		if (!prop && !batch_is_new(batch, nodeoffset))
+			old = fdt_get_property(batch->fdt, nodeoffset, name,
+					       NULL);
+		if (old) {
+			kind = BATCH_PROP_SET;
+			nameoff = fdt32_to_cpu(old->nameoff);
+		} else {
+			kind = BATCH_PROP_ADD;
+			nameoff = batch_find_add_string(batch, name);
+			if (nameoff < 0)
+				return nameoff;
+		}
+		prop = batch_new_prop(batch, nodeoffset, kind, nameoff);
+		if (!prop)
+			return -FDT_ERR_NOSPACE;
+	} else if (len <= prop->len) {
+		/* Reuse the space from the previous value */
+		memcpy(batch->vals + prop->valoff, val, len);
+		prop->len = len;
+		return 0;
+	}
+
+	valoff = batch_add_val(batch, val, len);
+	if (valoff < 0)
+		return valoff;
+	prop->valoff = valoff;
+	prop->len = len;
+
+	return 0;
+}
+
+const void *fdt_batch_getprop(struct fdt_batch *batch, int nodeoffset,
+			      const char *name, int *lenp)
+{
+	struct fdt_batch_prop *prop;
+	int ret;
+
+	ret = batch_check_node(batch, nodeoffset);
+	if (ret)
+		goto err;
+	prop = batch_find_prop(batch, nodeoffset, name);
+	if (prop && prop->kind != BATCH_PROP_DEL) {
+		if (lenp)
+			*lenp = prop->len;
+		return batch->vals + prop->valoff;
+	}
+	ret = -FDT_ERR_NOTFOUND;
+	if (!prop && !batch_is_new(batch, nodeoffset))
+		return fdt_getprop(batch->fdt, nodeoffset, name, lenp);
+err:
+	if (lenp)
+		*lenp = ret;
+
+	return NULL;
+}
+
+int fdt_batch_delprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name)
+{
+	const struct fdt_property *old;
+	struct fdt_batch_prop *prop;
+	int ret;
+
+	ret = batch_check_node(batch, nodeoffset);
+	if (ret)
+		return ret;
+	prop = batch_find_prop(batch, nodeoffset, name);
+	if (prop) {
+		if (prop->kind == BATCH_PROP_DEL)
+			return -FDT_ERR_NOTFOUND;
+		prop->kind = prop->kind == BATCH_PROP_ADD ? BATCH_PROP_DEAD :
+			BATCH_PROP_DEL;
+		return 0;
+	}
+	if (batch_is_new(batch, nodeoffset))
+		return -FDT_ERR_NOTFOUND;
+	old = fdt_get_property(batch->fdt, nodeoffset, name, &ret);
+	if (!old)
+		return ret;
+	prop = batch_new_prop(batch, nodeoffset, BATCH_PROP_DEL,
+			      fdt32_to_cpu(old->nameoff));
+
+	return prop ? 0 : -FDT_ERR_NOSPACE;
+}
+
+/* Match node names in the same way as libfdt, ignoring any unit address */
+static bool batch_nodename_eq(const char *p, const char *s, int len)
+{
+	if (memcmp(p, s, len))
+		return false;
+
+	return !p[len] || (p[len] == '@' && !memchr(s, '@', len));
+}
+
+int fdt_batch_subnode_offset(struct fdt_batch *batch, int parentoffset,
+			     const char *name)
+{
+	struct fdt_batch_node *node;
+	int len = strlen(name);
+	int ret;
+
+	ret = batch_check_node(batch, parentoffset);
+	if (ret)
+		return ret;
+	if (!batch_is_new(batch, parentoffset)) {
+		ret = fdt_subnode_offset(batch->fdt, parentoffset, name);
+		if (ret != -FDT_ERR_NOTFOUND)
+			return ret;
+	}
+	for (node = batch->nodes; node < batch->nodes + batch->node_count;
+	     node++) {
+		if (node->parent == parentoffset &&
+		    batch_nodename_eq(batch->vals + node->nameoff, name, len))
+			return batch_new_offset(batch, node - batch->nodes);
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdt_batch_add_subnode(struct fdt_batch *batch, int parentoffset,
+			  const char *name)
+{
+	struct fdt_batch_node *node;
+	int len = strlen(name);
+	int ret, nameoff;
+
+	ret = fdt_batch_subnode_offset(batch, parentoffset, name);
+	if (ret >= 0)
+		return -FDT_ERR_EXISTS;
+	else if (ret != -FDT_ERR_NOTFOUND)
+		return ret;
+
+	nameoff = batch_add_val(batch, name, len);
+	if (nameoff < 0)
+		return nameoff;
+	ret = batch_grow((void **)&batch->nodes, &batch->node_max,
+			 batch->node_count + 1, sizeof(*node));
+	if (ret)
+		return ret;
+	node = &batch->nodes[batch->node_count];
+	node->parent = parentoffset;
+	node->nameoff = nameoff;
+	node->namelen = len;
+
+	return batch_new_offset(batch, batch->node_count++);
+}
+
+static int batch_cmp_prop(const void *a, const void *b)
+{
+	const struct fdt_batch_prop *pa = a, *pb = b;
+
+	if (pa->node != pb->node)
+		return pa->node - pb->node;
+
+	return pa->seq - pb->seq;
+}
+
+/* Find the range of (sorted) property edits for a node */
+static void batch_node_props(struct fdt_batch *batch, int nodeoffset,
+			     struct fdt_batch_prop **firstp,
+			     struct fdt_batch_prop **endp)
+{
+	int lo = 0, hi = batch->prop_count, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (batch->props[mid].node < nodeoffset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*firstp = batch->props + lo;
+	for (hi = lo; hi < batch->prop_count; hi++) {
+		if (batch->props[hi].node != nodeoffset)
+			break;
+	}
+	*endp = batch->props + hi;
+}
+
+static void batch_out(struct fdt_batch *batch, const void *data, int len)
+{
+	memcpy(batch->out + batch->out_pos, data, len);
+	batch->out_pos += len;
+}
+
+static void batch_out_tag(struct fdt_batch *batch, uint32_t val)
+{
+	fdt32_t tag = cpu_to_fdt32(val);
+
+	batch_out(batch, &tag, sizeof(tag));
+}
+
+/* Write data padded with zeroes to the next tag boundary */
+static void batch_out_padded(struct fdt_batch *batch, const void *data,
+			     int len)
+{
+	batch_out(batch, data, len);
+	memset(batch->out + batch->out_pos, '\0', TAGALIGN(len) - len);
+	batch->out_pos += TAGALIGN(len) - len;
+}
+
+static void batch_out_prop(struct fdt_batch *batch,
+			   struct fdt_batch_prop *prop)
+{
+	batch_out_tag(batch, FDT_PROP);
+	batch_out_tag(batch, prop->len);
+	batch_out_tag(batch, prop->nameoff);
+	batch_out_padded(batch, batch->vals + prop->valoff, prop->len);
+}
+
+/* Write the new properties of a node, most recent first */
+static void batch_out_new_props(struct fdt_batch *batch,
+				struct fdt_batch_prop *first,
+				struct fdt_batch_prop *end)
+{
+	struct fdt_batch_prop *prop;
+
+	for (prop = end; prop-- > first;) {
+		if (prop->kind == BATCH_PROP_ADD)
+			batch_out_prop(batch, prop);
+	}
+}
+
+/* Write the new subnodes of a node, most recent first */
+static void batch_out_new_nodes(struct fdt_batch *batch, int parentoffset)
+{
+	struct fdt_batch_prop *first, *end;
+	struct fdt_batch_node *node;
+	int offset;
+
+	for (node = batch->nodes + batch->node_count; node-- > batch->nodes;) {
+		if (node->parent != parentoffset)
+			continue;
+		offset = batch_new_offset(batch, node - batch->nodes);
+		batch_out_tag(batch, FDT_BEGIN_NODE);
+		batch_out_padded(batch, batch->vals + node->nameoff,
+				 node->namelen + 1);
+		batch_node_props(batch, offset, &first, &end);
+		batch_out_new_props(batch, first, end);
+		batch_out_new_nodes(batch, offset);
+		batch_out_tag(batch, FDT_END_NODE);
+	}
+}
+
+/* Write a property from the tree, with any changes made by the batch */
+static void batch_out_old_prop(struct fdt_batch *batch, int offset, int len,
+			       struct fdt_batch_prop *first,
+			       struct fdt_batch_prop *end)
+{
+	const struct fdt_property *old;
+	struct fdt_batch_prop *prop;
+	int nameoff;
+
+	old = fdt_offset_ptr(batch->fdt, offset, len);
+	nameoff = fdt32_to_cpu(old->nameoff);
+	for (prop = end; prop-- > first;) {
+		if (prop->nameoff != nameoff)
+			continue;
+		if (prop->kind == BATCH_PROP_DEL)
+			return;
+		if (prop->kind == BATCH_PROP_SET) {
+			batch_out_prop(batch, prop);
+			return;
+		}
+	}
+	batch_out(batch, old, len);
+}
+
+/**
+ * batch_out_node() - Write a node from the tree along with its edits
+ *
+ * @batch:	Batch being committed
+ * @offset:	Offset of node in the tree
+ * @return offset of the tag after the node, or -FDT_ERR_... on error
+ */
+static int batch_out_node(struct fdt_batch *batch, int offset)
+{
+	const void *fdt = batch->fdt;
+	struct fdt_batch_prop *first, *end;
+	int node = offset, nextoffset;
+	bool subnodes = false;
+	uint32_t tag;
+
+	fdt_next_tag(fdt, offset, &nextoffset);
+	batch_out(batch, fdt_offset_ptr(fdt, offset, 0), nextoffset - offset);
+	batch_node_props(batch, node, &first, &end);
+	batch_out_new_props(batch, first, end);
+
+	for (offset = nextoffset;; offset = nextoffset) {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+		if (nextoffset < 0)
+			return nextoffset;
+		switch (tag) {
+		case FDT_PROP:
+			batch_out_old_prop(batch, offset, nextoffset - offset,
+					   first, end);
+			break;
+		case FDT_NOP:
+			batch_out(batch, fdt_offset_ptr(fdt, offset, 0),
+				  nextoffset - offset);
+			break;
+		case FDT_BEGIN_NODE:
+		case FDT_END_NODE:
+			/* New subnodes go after the properties */
+			if (!subnodes) {
+				batch_out_new_nodes(batch, node);
+				subnodes = true;
+			}
+			if (tag == FDT_END_NODE) {
+				batch_out_tag(batch, FDT_END_NODE);
+				return nextoffset;
+			}
+			nextoffset = batch_out_node(batch, offset);
+			if (nextoffset < 0)
+				return nextoffset;
+			break;
+		default:
+			return -FDT_ERR_BADSTRUCTURE;
+		}
+	}
+}
+
+/* Work out the largest size the structure block could grow to */
+static int batch_max_struct_size(struct fdt_batch *batch)
+{
+	struct fdt_batch_prop *prop;
+	struct fdt_batch_node *node;
+	int size = batch->struct_size;
+
+	for (prop = batch->props; prop < batch->props + batch->prop_count;
+	     prop++) {
+		size += sizeof(struct fdt_property) + TAGALIGN(prop->len);
+	}
+	for (node = batch->nodes; node < batch->nodes + batch->node_count;
+	     node++) {
+		size += sizeof(struct fdt_node_header) +
+			TAGALIGN(node->namelen + 1) + FDT_TAGSIZE;
+	}
+
+	return size;
+}
+
+int fdt_batch_commit(struct fdt_batch *batch)
+{
+	void *fdt = batch->fdt;
+	int strings_size = fdt_size_dt_strings(fdt);
+	int gap, offset, nextoffset;
+	uint32_t tag;
+	int ret = 0;
+
+	if (!batch->prop_count && !batch->node_count)
+		goto done;
+	qsort(batch->props, batch->prop_count, sizeof(*batch->props),
+	      batch_cmp_prop);
+
+	/* Keep any gap between the structure and strings blocks */
+	gap = fdt_off_dt_strings(fdt) - fdt_off_dt_struct(fdt) -
+		batch->struct_size;
+	batch->out = malloc(batch_max_struct_size(batch) + gap +
+			    strings_size + batch->strings_size);
+	if (!batch->out) {
+		ret = -FDT_ERR_NOSPACE;
+		goto done;
+	}
+
+	for (offset = 0; offset < batch->struct_size; offset = nextoffset) {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+		if (nextoffset < 0) {
+			ret = nextoffset;
+			goto done;
+		}
+		if (tag == FDT_BEGIN_NODE) {
+			nextoffset = batch_out_node(batch, offset);
+			if (nextoffset < 0) {
+				ret = nextoffset;
+				goto done;
+			}
+		} else {
+			batch_out(batch, fdt_offset_ptr(fdt, offset, 0),
+				  nextoffset - offset);
+			if (tag == FDT_END)
+				break;
+		}
+	}
+	offset = batch->out_pos;
+	batch_out(batch, (char *)fdt + fdt_off_dt_strings(fdt) - gap,
+		  gap + strings_size);
+	batch_out(batch, batch->strings, batch->strings_size);
+
+	if (fdt_off_dt_struct(fdt) + batch->out_pos > fdt_totalsize(fdt)) {
+		ret = -FDT_ERR_NOSPACE;
+		goto done;
+	}
+	memcpy((char *)fdt + fdt_off_dt_struct(fdt), batch->out,
+	       batch->out_pos);
+	fdt_set_size_dt_struct(fdt, offset);
+	fdt_set_off_dt_strings(fdt, fdt_off_dt_struct(fdt) + offset + gap);
+	fdt_set_size_dt_strings(fdt, strings_size + batch->strings_size);
+	if (fdt_version(fdt) > 17)
+		fdt_set_version(fdt, 17);
+done:
+	fdt_batch_free(batch);
+
+	return ret;
+}
+
+void fdt_batch_free(struct fdt_batch *batch)
+{
+	free(batch->strings);
+	free(batch->vals);
+	free(batch->props);
+	free(batch->nodes);
+	free(batch->out);
+	batch->strings = NULL;
+	batch->vals = NULL;
+	batch->props = NULL;
+	batch->nodes = NULL;
+	batch->out = NULL;
+	batch->prop_count = 0;
+	batch->node_count = 0;
+}
@@ -0,0 +1,765 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Applying a list of device tree overlays in a single pass
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_batch.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <linux/log2.h>
+
+/* Longest node name in a target-path */
+#define OVERLAY_MAX_NAME	256
+
+/* Limits on the nodes which can be indexed by their path */
+#define OVERLAY_MAX_PATH	512
+#define OVERLAY_MAX_DEPTH	32
+
+/**
+ * struct overlay_phandle - Entry in the phandle index
+ *
+ * @phandle:	Phandle of node, or 0 if the entry is empty
+ * @offset:	Offset of node, from the tree or the batch
+ */
+struct overlay_phandle {
+	uint32_t phandle;
+	int offset;
+};
+
+/**
+ * struct overlay_symbol - Entry in the symbol index
+ *
+ * @name:	Label from /__symbols__, or NULL if the entry is empty
+ * @path:	Path of the node with that label
+ * @phandle:	Phandle of the node, or 0 if not found yet
+ */
+struct overlay_symbol {
+	const char *name;
+	const char *path;
+	uint32_t phandle;
+};
+
+/**
+ * struct overlay_node - Entry in the index of overlay nodes by path
+ *
+ * @pathoff:	Offset of path in the path buffer plus one, or 0 if the
+ *		entry is empty
+ * @len:	Length of path
+ * @offset:	Offset of node in the overlay
+ */
+struct overlay_node {
+	int pathoff;
+	int len;
+	int offset;
+};
+
+/**
+ * struct overlay_state - State while applying a list of overlays
+ *
+ * The indexes are hash tables with linear probing. They are built once,
+ * rather than searching the trees for each fixup and fragment as
+ * fdt_overlay_apply() does.
+ *
+ * @batch:		Edits made to the base tree so far
+ * @phandles:		Index of nodes by phandle
+ * @phandle_mask:	Number of entries in @phandles, less one
+ * @symbols:		Index of /__symbols__ by label
+ * @paths:		Index of the same symbols by path
+ * @symbol_mask:	Number of entries in @symbols and @paths, less one
+ * @symbols_found:	true once the nodes for the symbols have been found
+ * @max_phandle:	Highest phandle in the tree, including edits so far
+ * @fdto:		Overlay being applied
+ * @delta:		Amount added to the phandles of that overlay
+ * @nodes:		Index of nodes in that overlay by path
+ * @node_mask:		Number of entries in @nodes, less one
+ * @node_paths:		Paths of the nodes in @nodes
+ * @node_paths_size:	Number of bytes used in @node_paths
+ * @node_paths_max:	Number of bytes allocated for @node_paths
+ */
+struct overlay_state {
+	struct fdt_batch batch;
+	struct overlay_phandle *phandles;
+	uint32_t phandle_mask;
+	struct overlay_symbol *symbols;
+	struct overlay_symbol **paths;
+	uint32_t symbol_mask;
+	bool symbols_found;
+	uint32_t max_phandle;
+	void *fdto;
+	uint32_t delta;
+	struct overlay_node *nodes;
+	uint32_t node_mask;
+	char *node_paths;
+	int node_paths_size;
+	int node_paths_max;
+};
+
+/**
+ * typedef overlay_walk_func - Function called for each node in a walk
+ *
+ * @st:		State
+ * @path:	Path of node, relative to the start of the walk, or NULL if
+ *		it is too long
+ * @len:	Length of path
+ * @offset:	Offset of node
+ * @return 0 to continue, -FDT_ERR_... to stop the walk with an error
+ */
+typedef int (*overlay_walk_func)(struct overlay_state *st, const char *path,
+				 int len, int offset);
+
+static uint32_t overlay_hash(const char *str, int len)
+{
+	uint32_t hash = 2166136261U;
+
+	while (len--)
+		hash = (hash ^ (uint8_t)*str++) * 16777619;
+
+	return hash;
+}
+
+static int overlay_count_nodes(const void *fdt)
+{
+	int offset, count = 0;
+
+	for (offset = 0; offset >= 0; offset = fdt_next_node(fdt, offset, NULL))
+		count++;
+
+	return offset == -FDT_ERR_NOTFOUND ? count : offset;
+}
+
+/* Work out the mask for a hash table with room for @count entries */
+static uint32_t overlay_table_mask(int count)
+{
+	return roundup_pow_of_two(max(count * 2, 16)) - 1;
+}
+
+/**
+ * overlay_walk() - Call a function for a node and all its subnodes
+ *
+ * The path of each node is built up as the walk goes along, rather than
+ * looking up each node from its path, which would search from the start
+ * every time.
+ *
+ * @st:		State
+ * @fdt:	Tree to walk
+ * @start:	Offset of node to start from; its path is "/"
+ * @func:	Function to call
+ * @return 0 if OK, -FDT_ERR_... on error
+ */
+static int overlay_walk(struct overlay_state *st, const void *fdt, int start,
+			overlay_walk_func func)
+{
+	char path[OVERLAY_MAX_PATH];
+	int pos[OVERLAY_MAX_DEPTH];
+	int offset, depth = 0;
+
+	strcpy(path, "/");
+	pos[0] = 0;
+	for (offset = start; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		const char *name;
+		int len, ret;
+
+		if (!depth) {
+			if (offset != start)
+				break;
+			ret = func(st, path, 1, offset);
+		} else if (depth >= OVERLAY_MAX_DEPTH) {
+			ret = func(st, NULL, 0, offset);
+		} else {
+			len = pos[depth - 1];
+			name = fdt_get_name(fdt, offset, &ret);
+			if (!name)
+				return ret;
+			if (len + 1 + ret >= sizeof(path)) {
+				pos[depth] = sizeof(path);
+				ret = func(st, NULL, 0, offset);
+			} else {
+				path[len] = '/';
+				memcpy(path + len + 1, name, ret);
+				pos[depth] = len + 1 + ret;
+				path[pos[depth]] = '\0';
+				ret = func(st, path, pos[depth], offset);
+			}
+		}
+		if (ret)
+			return ret;
+	}
+
+	return offset < 0 && offset != -FDT_ERR_NOTFOUND ? offset : 0;
+}
+
+static struct overlay_phandle *overlay_find_phandle(struct overlay_state *st,
+						    uint32_t phandle)
+{
+	uint32_t i = phandle * 0x9e3779b1;
+
+	for (;; i++) {
+		struct overlay_phandle *entry;
+
+		entry = &st->phandles[i & st->phandle_mask];
+		if (!entry->phandle || entry->phandle == phandle)
+			return entry;
+	}
+}
+
+static void overlay_add_phandle(struct overlay_state *st, uint32_t phandle,
+				int offset)
+{
+	struct overlay_phandle *entry;
+
+	entry = overlay_find_phandle(st, phandle);
+	if (!entry->phandle) {
+		entry->phandle = phandle;
+		entry->offset = offset;
+	}
+	st->max_phandle = max(st->max_phandle, phandle);
+}
+
+static struct overlay_symbol *overlay_find_symbol(struct overlay_state *st,
+						  const char *name)
+{
+	uint32_t i = overlay_hash(name, strlen(name));
+
+	for (;; i++) {
+		struct overlay_symbol *entry;
+
+		entry = &st->symbols[i & st->symbol_mask];
+		if (!entry->name || !strcmp(entry->name, name))
+			return entry;
+	}
+}
+
+/* Find the next symbol with a path, starting at entry @i */
+static struct overlay_symbol **overlay_find_path(struct overlay_state *st,
+						 const char *path, uint32_t i)
+{
+	for (;; i++) {
+		struct overlay_symbol **entry;
+
+		entry = &st->paths[i & st->symbol_mask];
+		if (!*entry || !strcmp((*entry)->path, path))
+			return entry;
+	}
+}
+
+/**
+ * overlay_build_index() - Set up the indexes for the base tree
+ *
+ * @st:		State to set up, with the batch already set up
+ * @nodes:	Number of nodes which the phandle index must hold
+ * @return 0 if OK, -FDT_ERR_... on error
+ */
+static int overlay_build_index(struct overlay_state *st, int nodes)
+{
+	const void *fdt = st->batch.fdt;
+	int offset, symbols, count;
+
+	st->phandle_mask = overlay_table_mask(nodes);
+	st->phandles = calloc(st->phandle_mask + 1, sizeof(*st->phandles));
+	if (!st->phandles)
+		return -FDT_ERR_NOSPACE;
+	for (offset = 0; offset >= 0;
+	     offset = fdt_next_node(fdt, offset, NULL)) {
+		uint32_t phandle = fdt_get_phandle(fdt, offset);
+
+		if (phandle == (uint32_t)-1)
+			return -FDT_ERR_BADPHANDLE;
+		if (phandle)
+			overlay_add_phandle(st, phandle, offset);
+	}
+	if (offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	/* Only record the symbols here; their nodes are found when needed */
+	count = 0;
+	symbols = fdt_path_offset(fdt, "/__symbols__");
+	if (symbols >= 0) {
+		fdt_for_each_property_offset(offset, fdt, symbols)
+			count++;
+	}
+	st->symbol_mask = overlay_table_mask(count);
+	st->symbols = calloc(st->symbol_mask + 1, sizeof(*st->symbols));
+	st->paths = calloc(st->symbol_mask + 1, sizeof(*st->paths));
+	if (!st->symbols || !st->paths)
+		return -FDT_ERR_NOSPACE;
+	if (symbols < 0)
+		return 0;
+	fdt_for_each_property_offset(offset, fdt, symbols) {
+		struct overlay_symbol *entry;
+		const char *name, *path;
+		int len;
+
+		path = fdt_getprop_by_offset(fdt, offset, &name, &len);
+		if (!path)
+			return len;
+		entry = overlay_find_symbol(st, name);
+		if (entry->name)
+			continue;
+		entry->name = name;
+		entry->path = path;
+
+		/* Labels for the same node follow each other in the table */
+		*overlay_find_path(st, path, overlay_hash(path, strlen(path))) =
+			entry;
+	}
+
+	return 0;
+}
+
+static int overlay_found_symbol(struct overlay_state *st, const char *path,
+				int len, int offset)
+{
+	struct overlay_symbol **entry;
+	uint32_t i;
+
+	if (!path)
+		return 0;
+	i = overlay_hash(path, len);
+	for (entry = overlay_find_path(st, path, i); *entry;
+	     entry = overlay_find_path(st, path, i + 1)) {
+		i = entry - st->paths;
+		(*entry)->phandle = fdt_get_phandle(st->batch.fdt, offset);
+	}
+
+	return 0;
+}
+
+static int overlay_symbol_phandle(struct overlay_state *st, const char *label,
+				  uint32_t *phandlep)
+{
+	struct overlay_symbol *entry;
+	int offset, ret;
+
+	/* Find the nodes for all the symbols in one walk of the tree */
+	if (!st->symbols_found) {
+		ret = overlay_walk(st, st->batch.fdt, 0, overlay_found_symbol);
+		if (ret)
+			return ret;
+		st->symbols_found = true;
+	}
+	entry = overlay_find_symbol(st, label);
+	if (!entry->name)
+		return -FDT_ERR_NOTFOUND;
+	if (!entry->phandle) {
+		/* The walk only finds paths in the usual form */
+		offset = fdt_path_offset(st->batch.fdt, entry->path);
+		if (offset < 0)
+			return offset;
+		entry->phandle = fdt_get_phandle(st->batch.fdt, offset);
+		if (!entry->phandle)
+			return -FDT_ERR_NOTFOUND;
+	}
+	*phandlep = entry->phandle;
+
+	return 0;
+}
+
+static struct overlay_node *overlay_find_node(struct overlay_state *st,
+					      const char *path, int len)
+{
+	uint32_t i = overlay_hash(path, len);
+
+	for (;; i++) {
+		struct overlay_node *entry;
+
+		entry = &st->nodes[i & st->node_mask];
+		if (!entry->pathoff)
+			return entry;
+		if (entry->len == len &&
+		    !memcmp(st->node_paths + entry->pathoff - 1, path, len))
+			return entry;
+	}
+}
+
+static int overlay_add_node(struct overlay_state *st, const char *path,
+			    int len, int offset)
+{
+	struct overlay_node *entry;
+	int size;
+	char *buf;
+
+	if (!path)
+		return 0;
+	if (st->node_paths_size + len > st->node_paths_max) {
+		size = max(st->node_paths_max * 2, st->node_paths_size + len);
+		buf = realloc(st->node_paths, size);
+		if (!buf)
+			return -FDT_ERR_NOSPACE;
+		st->node_paths = buf;
+		st->node_paths_max = size;
+	}
+	entry = overlay_find_node(st, path, len);
+	if (entry->pathoff)
+		return 0;
+	memcpy(st->node_paths + st->node_paths_size, path, len);
+	entry->pathoff = st->node_paths_size + 1;
+	entry->len = len;
+	entry->offset = offset;
+	st->node_paths_size += len;
+
+	return 0;
+}
+
+/* Find a node in the overlay from its path */
+static int overlay_node_offset(struct overlay_state *st, const char *path,
+			       int len)
+{
+	struct overlay_node *entry;
+
+	entry = overlay_find_node(st, path, len);
+	if (entry->pathoff)
+		return entry->offset;
+
+	/* The index only holds paths in the usual form */
+	return fdt_path_offset_namelen(st->fdto, path, len);
+}
+
+/* Add @delta to a phandle property in the overlay, if present */
+static int overlay_adjust_phandle(void *fdto, int node, const char *name,
+				  uint32_t delta)
+{
+	fdt32_t *val;
+	uint32_t adj_val;
+	int len;
+
+	val = fdt_getprop_w(fdto, node, name, &len);
+	if (!val)
+		return len == -FDT_ERR_NOTFOUND ? 0 : len;
+	if (len != sizeof(*val))
+		return -FDT_ERR_BADSTRUCTURE;
+	adj_val = fdt32_to_cpu(*val);
+	if (adj_val + delta < adj_val)
+		return -FDT_ERR_BADPHANDLE;
+	*val = cpu_to_fdt32(adj_val + delta);
+
+	return 0;
+}
+
+/* Index a node of the overlay and adjust its phandle */
+static int overlay_prepare_node(struct overlay_state *st, const char *path,
+				int len, int offset)
+{
+	int ret;
+
+	ret = overlay_adjust_phandle(st->fdto, offset, "phandle", st->delta);
+	if (!ret)
+		ret = overlay_adjust_phandle(st->fdto, offset, "linux,phandle",
+					     st->delta);
+	if (!ret)
+		ret = overlay_add_node(st, path, len, offset);
+
+	return ret;
+}
+
+/* Adjust references to local phandles for one node of /__local_fixups__ */
+static int overlay_local_fixup(struct overlay_state *st, const char *path,
+			       int len, int fixup_node)
+{
+	void *fdto = st->fdto;
+	int fixup_prop, node;
+
+	if (!path)
+		return -FDT_ERR_BADPATH;
+	node = overlay_node_offset(st, path, len);
+	if (node < 0)
+		return node;
+
+	fdt_for_each_property_offset(fixup_prop, fdto, fixup_node) {
+		const fdt32_t *index;
+		const char *name;
+		uint8_t *tree_val;
+		fdt32_t adj_val;
+		int i, tree_len;
+
+		index = fdt_getprop_by_offset(fdto, fixup_prop, &name, &len);
+		if (!index)
+			return len;
+		tree_val = fdt_getprop_w(fdto, node, name, &tree_len);
+		if (!tree_val)
+			return tree_len;
+		for (i = 0; i < len / sizeof(*index); i++) {
+			uint32_t pos = fdt32_to_cpu(index[i]);
+
+			if (tree_len < sizeof(adj_val) ||
+			    pos > tree_len - sizeof(adj_val))
+				return -FDT_ERR_NOSPACE;
+
+			/* The phandles may not be aligned */
+			memcpy(&adj_val, tree_val + pos, sizeof(adj_val));
+			adj_val = cpu_to_fdt32(fdt32_to_cpu(adj_val) +
+					       st->delta);
+			memcpy(tree_val + pos, &adj_val, sizeof(adj_val));
+		}
+	}
+
+	return 0;
+}
+
+/* Apply one "path:property:offset" entry from /__fixups__ */
+static int overlay_fixup_one(struct overlay_state *st, const char *fixup,
+			     int len, uint32_t phandle)
+{
+	const char *name, *sep, *end = fixup + len;
+	fdt32_t *val, tmp;
+	uint32_t pos;
+	char *endp;
+	int node;
+
+	sep = memchr(fixup, ':', len);
+	if (!sep)
+		return -FDT_ERR_BADSTRUCTURE;
+	name = sep + 1;
+	sep = memchr(name, ':', end - name);
+	if (!sep || sep + 1 == end)
+		return -FDT_ERR_BADSTRUCTURE;
+	pos = simple_strtoul(sep + 1, &endp, 10);
+	if (endp != end)
+		return -FDT_ERR_BADSTRUCTURE;
+
+	node = overlay_node_offset(st, fixup, name - 1 - fixup);
+	if (node < 0)
+		return node;
+	val = fdt_getprop_namelen_w(st->fdto, node, name, sep - name, &len);
+	if (!val)
+		return len;
+	if (len < sizeof(tmp) || pos > len - sizeof(tmp))
+		return -FDT_ERR_NOSPACE;
+	tmp = cpu_to_fdt32(phandle);
+	memcpy((char *)val + pos, &tmp, sizeof(tmp));
+
+	return 0;
+}
+
+static int overlay_fixup_phandles(struct overlay_state *st)
+{
+	void *fdto = st->fdto;
+	int fixups, prop;
+
+	fixups = fdt_path_offset(fdto, "/__fixups__");
+	if (fixups == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (fixups < 0)
+		return fixups;
+
+	fdt_for_each_property_offset(prop, fdto, fixups) {
+		const char *label, *val;
+		uint32_t phandle;
+		int len, ret;
+
+		val = fdt_getprop_by_offset(fdto, prop, &label, &len);
+		if (!val)
+			return len;
+		ret = overlay_symbol_phandle(st, label, &phandle);
+		if (ret)
+			return ret;
+		while (len > 0) {
+			int fixup_len = strnlen(val, len);
+
+			ret = overlay_fixup_one(st, val, fixup_len, phandle);
+			if (ret)
+				return ret;
+			val += fixup_len + 1;
+			len -= fixup_len + 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Find a node from its full path, including nodes added by the batch */
+static int overlay_path_offset(struct overlay_state *st, const char *path)
+{
+	char name[OVERLAY_MAX_NAME];
+	const char *end;
+	int offset = 0;
+	int len;
+
+	if (*path != '/')
+		return fdt_path_offset(st->batch.fdt, path);
+	for (; *path; path += len) {
+		while (*path == '/')
+			path++;
+		end = strchr(path, '/');
+		len = end ? end - path : strlen(path);
+		if (!len)
+			break;
+		if (len >= sizeof(name))
+			return -FDT_ERR_BADPATH;
+		memcpy(name, path, len);
+		name[len] = '\0';
+		offset = fdt_batch_subnode_offset(&st->batch, offset, name);
+		if (offset < 0)
+			return offset;
+	}
+
+	return offset;
+}
+
+static int overlay_get_target(struct overlay_state *st, int fragment)
+{
+	struct overlay_phandle *entry;
+	const fdt32_t *val;
+	const char *path;
+	int len;
+
+	val = fdt_getprop(st->fdto, fragment, "target", &len);
+	if (val) {
+		if (len != sizeof(*val) || *val == (fdt32_t)-1)
+			return -FDT_ERR_BADPHANDLE;
+		entry = overlay_find_phandle(st, fdt32_to_cpu(*val));
+		if (!entry->phandle)
+			return -FDT_ERR_NOTFOUND;
+		return entry->offset;
+	}
+
+	path = fdt_getprop(st->fdto, fragment, "target-path", NULL);
+	if (!path)
+		return -FDT_ERR_NOTFOUND;
+
+	return overlay_path_offset(st, path);
+}
+
+static int overlay_apply_node(struct overlay_state *st, int target, int node)
+{
+	const void *fdto = st->fdto;
+	int prop, subnode, ret;
+
+	fdt_for_each_property_offset(prop, fdto, node) {
+		const char *name;
+		const void *val;
+		int len;
+
+		val = fdt_getprop_by_offset(fdto, prop, &name, &len);
+		if (!val)
+			return len;
+		ret = fdt_batch_setprop(&st->batch, target, name, val, len);
+		if (ret)
+			return ret;
+
+		/* Keep the index up to date for the next overlay */
+		if (len == sizeof(fdt32_t) && (!strcmp(name, "phandle") ||
+					       !strcmp(name, "linux,phandle")))
+			overlay_add_phandle(st, fdt32_to_cpu(*(fdt32_t *)val),
+					    target);
+	}
+
+	fdt_for_each_subnode(fdto, subnode, node) {
+		const char *name = fdt_get_name(fdto, subnode, NULL);
+		int child;
+
+		child = fdt_batch_add_subnode(&st->batch, target, name);
+		if (child == -FDT_ERR_EXISTS)
+			child = fdt_batch_subnode_offset(&st->batch, target,
+							 name);
+		if (child < 0)
+			return child;
+		ret = overlay_apply_node(st, child, subnode);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int overlay_apply_one(struct overlay_state *st, void *fdto)
+{
+	int fragment, ret;
+
+	st->fdto = fdto;
+	st->delta = st->max_phandle + 1;
+	ret = overlay_count_nodes(fdto);
+	if (ret < 0)
+		return ret;
+	st->node_mask = overlay_table_mask(ret);
+	free(st->nodes);
+	st->nodes = calloc(st->node_mask + 1, sizeof(*st->nodes));
+	if (!st->nodes)
+		return -FDT_ERR_NOSPACE;
+	st->node_paths_size = 0;
+
+	ret = overlay_walk(st, fdto, 0, overlay_prepare_node);
+	if (ret)
+		return ret;
+	ret = fdt_path_offset(fdto, "/__local_fixups__");
+	if (ret >= 0)
+		ret = overlay_walk(st, fdto, ret, overlay_local_fixup);
+	if (ret && ret != -FDT_ERR_NOTFOUND)
+		return ret;
+	ret = overlay_fixup_phandles(st);
+	if (ret)
+		return ret;
+
+	fdt_for_each_subnode(fdto, fragment, 0) {
+		int target, overlay;
+
+		/* Like fdt_overlay_apply(), skip fragments with no target */
+		target = overlay_get_target(st, fragment);
+		if (target < 0)
+			continue;
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay < 0)
+			return overlay;
+		ret = overlay_apply_node(st, target, overlay);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int fdt_overlay_apply_list(void *fdt, void *const fdtos[], int count)
+{
+	struct overlay_state st;
+	int i, nodes, ret;
+	int used = 0;
+
+	memset(&st, '\0', sizeof(st));
+	ret = fdt_batch_init(&st.batch, fdt);
+	if (ret)
+		goto err;
+	nodes = overlay_count_nodes(fdt);
+	for (i = 0; i < count && nodes >= 0; i++) {
+		ret = fdt_check_header(fdtos[i]);
+		if (ret) {
+			nodes = ret;
+			break;
+		}
+		ret = overlay_count_nodes(fdtos[i]);
+		nodes = ret < 0 ? ret : nodes + ret;
+	}
+	if (nodes < 0) {
+		ret = nodes;
+		goto err;
+	}
+	ret = overlay_build_index(&st, nodes);
+	if (ret)
+		goto err;
+
+	for (i = 0; i < count; i++) {
+		/* This fixes up the overlay's phandles in place */
+		used = i + 1;
+		ret = overlay_apply_one(&st, fdtos[i]);
+		if (ret)
+			goto err;
+	}
+	ret = fdt_batch_commit(&st.batch);
+
+err:
+	fdt_batch_free(&st.batch);
+	free(st.node_paths);
+	free(st.nodes);
+	free(st.paths);
+	free(st.symbols);
+	free(st.phandles);
+
+	/* Erase the magic of the overlays which have been fixed up */
+	for (i = 0; i < used; i++)
+		fdt_set_magic(fdtos[i], ~0);
+
+	return ret;
+}
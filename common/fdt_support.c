@@ -14,6 +14,7 @@
 #include <linux/types.h>
 #include <asm/global_data.h>
 #include <libfdt.h>
+#include <fdt_batch.h>
 #include <fdt_support.h>
 #include <exports.h>
 #include <fdtdec.h>
@@ -331,7 +332,8 @@ void do_fixup_by_prop(void *fdt,
 		      const char *prop, const void *val, int len,
 		      int create)
 {
-	int off;
+	struct fdt_batch batch;
+	int off, ret;
 #if defined(DEBUG)
 	int i;
 	debug("Updating property '%s' = ", prop);
@@ -339,12 +341,18 @@ void do_fixup_by_prop(void *fdt,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	if (fdt_batch_init(&batch, fdt))
+		return;
 	off = fdt_node_offset_by_prop_value(fdt, -1, pname, pval, plen);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+			fdt_batch_setprop(&batch, off, prop, val, len);
 		off = fdt_node_offset_by_prop_value(fdt, off, pname, pval, plen);
 	}
+	ret = fdt_batch_commit(&batch);
+	if (ret)
+		printf("Unable to update property %s, err=%s\n", prop,
+		       fdt_strerror(ret));
 }
 
 void do_fixup_by_prop_u32(void *fdt,
@@ -358,7 +366,8 @@ void do_fixup_by_prop_u32(void *fdt,
 void do_fixup_by_compat(void *fdt, const char *compat,
 			const char *prop, const void *val, int len, int create)
 {
-	int off = -1;
+	struct fdt_batch batch;
+	int off, ret;
 #if defined(DEBUG)
 	int i;
 	debug("Updating property '%s' = ", prop);
@@ -366,12 +375,19 @@ void do_fixup_by_compat(void *fdt, const char *compat,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	/* Collect the changes and write the tree once, at the end */
+	if (fdt_batch_init(&batch, fdt))
+		return;
 	off = fdt_node_offset_by_compatible(fdt, -1, compat);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+			fdt_batch_setprop(&batch, off, prop, val, len);
 		off = fdt_node_offset_by_compatible(fdt, off, compat);
 	}
+	ret = fdt_batch_commit(&batch);
+	if (ret)
+		printf("Unable to update property %s, err=%s\n", prop,
+		       fdt_strerror(ret));
 }
 
 void do_fixup_by_compat_u32(void *fdt, const char *compat,
@@ -465,33 +481,47 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 	return fdt_fixup_memory_banks(blob, &start, &size, 1);
 }
 
+/* Batch version of do_fixup_by_path() */
+static void batch_fixup_by_path(struct fdt_batch *batch, const char *path,
+				const char *prop, const void *val, int len,
+				int create)
+{
+	int node, ret;
+
+	node = fdt_path_offset(batch->fdt, path);
+	ret = node;
+	if (node >= 0) {
+		if (!create && !fdt_batch_getprop(batch, node, prop, NULL))
+			return;
+		ret = fdt_batch_setprop(batch, node, prop, val, len);
+	}
+	if (ret)
+		printf("Unable to update property %s:%s, err=%s\n",
+		       path, prop, fdt_strerror(ret));
+}
+
 void fdt_fixup_ethernet(void *fdt)
 {
-	int i, j, prop;
+	struct fdt_batch batch;
+	int i, j, ret;
 	char *tmp, *end;
 	char mac[16];
 	const char *path;
 	unsigned char mac_addr[6];
-	int offset;
+	int node, offset;
 
-	if (fdt_path_offset(fdt, "/aliases") < 0)
+	node = fdt_path_offset(fdt, "/aliases");
+	if (node < 0)
 		return;
+	ret = fdt_batch_init(&batch, fdt);
+	if (ret)
+		goto err;
 
-	/* Cycle through all aliases */
-	for (prop = 0; ; prop++) {
+	/* Cycle through all aliases; the FDT is not changed until the end */
+	fdt_for_each_property_offset(offset, fdt, node) {
 		const char *name;
 		int len = strlen("ethernet");
 
-		/* FDT might have been edited, recompute the offset */
-		offset = fdt_first_property_offset(fdt,
-			fdt_path_offset(fdt, "/aliases"));
-		/* Select property number 'prop' */
-		for (i = 0; i < prop; i++)
-			offset = fdt_next_property_offset(fdt, offset);
-
-		if (offset < 0)
-			break;
-
 		path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
 		if (!strncmp(name, "ethernet", len)) {
 			i = trailing_strtol(name);
@@ -514,12 +544,17 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			batch_fixup_by_path(&batch, path, "mac-address",
+					    &mac_addr, 6, 0);
+			batch_fixup_by_path(&batch, path, "local-mac-address",
+					    &mac_addr, 6, 1);
 		}
 	}
+	ret = fdt_batch_commit(&batch);
+	if (!ret)
+		return;
+err:
+	printf("Unable to update MAC addresses, err=%s\n", fdt_strerror(ret));
 }
 
 /* Resize the fdt to its actual size + a bit of padding */
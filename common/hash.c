@@ -13,6 +13,8 @@
 #ifndef USE_HOSTCC
 #include <common.h>
 #include <command.h>
+#include <div64.h>
+#include <dm.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <hw_sha.h>
@@ -30,6 +32,13 @@
 #include <u-boot/sha256.h>
 #include <u-boot/md5.h>
 
+#ifndef USE_HOSTCC
+#if CONFIG_IS_ENABLED(DM_HASH)
+#include <u-boot/hash-engine.h>
+#define HASH_ENGINE
+#endif
+#endif
+
 #ifdef CONFIG_SHA1
 static int hash_init_sha1(struct hash_algo *algo, void **ctxp)
 {
@@ -193,13 +202,108 @@ static struct hash_algo hash_algo[] = {
 #define multi_hash()	0
 #endif
 
+#ifdef HASH_ENGINE
+/**
+ * struct hash_engine_algo - a hash algorithm implemented by a hash engine
+ *
+ * @algo:	Algorithm, with the progressive functions routed to @dev
+ * @dev:	Hash engine (UCLASS_HASH) selected for this algorithm
+ */
+struct hash_engine_algo {
+	struct hash_algo algo;
+	struct udevice *dev;
+};
+
+static struct hash_engine_algo hash_engine_algo[ARRAY_SIZE(hash_algo)];
+
+static struct udevice *hash_algo_to_engine(struct hash_algo *algo)
+{
+	return container_of(algo, struct hash_engine_algo, algo)->dev;
+}
+
+static int hash_init_engine(struct hash_algo *algo, void **ctxp)
+{
+	return hash_engine_init(hash_algo_to_engine(algo), algo->name, ctxp);
+}
+
+static int hash_update_engine(struct hash_algo *algo, void *ctx,
+			      const void *buf, unsigned int size, int is_last)
+{
+	struct udevice *dev = hash_algo_to_engine(algo);
+	int ret;
+
+	ret = hash_engine_update(dev, ctx, buf, size);
+	if (ret) {
+		uint8_t dummy[HASH_MAX_DIGEST_SIZE];
+
+		/* The context is freed on error, see struct hash_algo */
+		hash_engine_finish(dev, ctx, dummy, sizeof(dummy));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int hash_finish_engine(struct hash_algo *algo, void *ctx,
+			      void *dest_buf, int size)
+{
+	int ret;
+
+	ret = hash_engine_finish(hash_algo_to_engine(algo), ctx, dest_buf,
+				 size);
+	if (ret)
+		return ret == -ENOSPC ? ret : -1;
+
+	return 0;
+}
+
+static bool hash_algo_uses_engine(struct hash_algo *algo)
+{
+	return algo->hash_init == hash_init_engine;
+}
+
+/**
+ * hash_select_engine() - Route an algorithm to a hash engine if available
+ *
+ * @index:	Index of the algorithm in hash_algo[]
+ * @return the algorithm to use: either the entry from hash_algo[] or a copy
+ * with its progressive functions calling into the selected hash engine
+ */
+static struct hash_algo *hash_select_engine(int index)
+{
+	struct hash_engine_algo *ealgo = &hash_engine_algo[index];
+	struct udevice *dev;
+
+	if (hash_engine_get(hash_algo[index].name, &dev))
+		return &hash_algo[index];
+
+	ealgo->algo = hash_algo[index];
+	ealgo->algo.hash_init = hash_init_engine;
+	ealgo->algo.hash_update = hash_update_engine;
+	ealgo->algo.hash_finish = hash_finish_engine;
+	ealgo->dev = dev;
+
+	return &ealgo->algo;
+}
+#else
+static inline bool hash_algo_uses_engine(struct hash_algo *algo)
+{
+	return false;
+}
+
+static inline struct hash_algo *hash_select_engine(int index)
+{
+	return &hash_algo[index];
+}
+#endif
+
 int hash_lookup_algo(const char *algo_name, struct hash_algo **algop)
 {
 	int i;
 
 	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
 		if (!strcmp(algo_name, hash_algo[i].name)) {
-			*algop = &hash_algo[i];
+			*algop = hash_select_engine(i);
 			return 0;
 		}
 	}
@@ -216,7 +320,7 @@ int hash_progressive_lookup_algo(const char *algo_name,
 	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
 		if (!strcmp(algo_name, hash_algo[i].name)) {
 			if (hash_algo[i].hash_init) {
-				*algop = &hash_algo[i];
+				*algop = hash_select_engine(i);
 				return 0;
 			}
 		}
@@ -227,6 +331,32 @@ int hash_progressive_lookup_algo(const char *algo_name,
 }
 
 #ifndef USE_HOSTCC
+/**
+ * hash_digest() - Hash a buffer with the given algorithm
+ *
+ * This uses the hash engine behind @algo if there is one, otherwise the
+ * algorithm's built-in function.
+ *
+ * @algo:	Hash algorithm, as returned by hash_lookup_algo()
+ * @data:	Data to hash
+ * @len:	Length of data in bytes
+ * @output:	Place to put the digest (algo->digest_size bytes)
+ * @return 0 if ok, -ve on error
+ */
+static int hash_digest(struct hash_algo *algo, const void *data,
+		       unsigned int len, uint8_t *output)
+{
+#ifdef HASH_ENGINE
+	if (hash_algo_uses_engine(algo))
+		return hash_engine_digest(hash_algo_to_engine(algo),
+					  algo->name, data, len, output,
+					  algo->digest_size, algo->chunk_size);
+#endif
+	algo->hash_func_ws(data, len, output, algo->chunk_size);
+
+	return 0;
+}
+
 int hash_parse_string(const char *algo_name, const char *str, uint8_t *result)
 {
 	struct hash_algo *algo;
@@ -264,9 +394,8 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
 	}
 	if (output_size)
 		*output_size = algo->digest_size;
-	algo->hash_func_ws(data, len, output, algo->chunk_size);
 
-	return 0;
+	return hash_digest(algo, data, len, output);
 }
 
 #if defined(CONFIG_CMD_HASH) || defined(CONFIG_CMD_SHA1SUM) || defined(CONFIG_CMD_CRC32)
@@ -407,6 +536,7 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 		uint8_t output[HASH_MAX_DIGEST_SIZE];
 		uint8_t vsum[HASH_MAX_DIGEST_SIZE];
 		void *buf;
+		int ret;
 
 		if (hash_lookup_algo(algo_name, &algo)) {
 			printf("Unknown hash algorithm '%s'\n", algo_name);
@@ -420,8 +550,12 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 		}
 
 		buf = map_sysmem(addr, len);
-		algo->hash_func_ws(buf, len, output, algo->chunk_size);
+		ret = hash_digest(algo, buf, len, output);
 		unmap_sysmem(buf);
+		if (ret) {
+			printf("%s failed (err=%d)\n", algo->name, ret);
+			return 1;
+		}
 
 		/* Try to avoid code bloat when verify is not needed */
 #ifdef CONFIG_HASH_VERIFY
@@ -474,4 +608,82 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 	return 0;
 }
 #endif
+
+#ifdef CONFIG_CMD_HASH
+/**
+ * hash_bench_show() - Show the throughput for one algorithm/engine pair
+ *
+ * @algo:	Algorithm that was timed
+ * @engine:	Name of the engine, or "builtin" for the hash_algo[] table
+ * @bytes:	Total number of bytes hashed
+ * @us:		Time taken in microseconds
+ */
+static void hash_bench_show(struct hash_algo *algo, const char *engine,
+			    uint64_t bytes, ulong us)
+{
+	/* One byte per microsecond is 1MB/s; show one decimal place */
+	uint64_t rate = lldiv(bytes * 10, us ? us : 1);
+	ulong whole = lldiv(rate, 10);
+
+	printf("%-8s %-16s %8lu.%lu MB/s\n", algo->name, engine, whole,
+	       (ulong)(rate - whole * 10ULL));
+}
+
+int hash_bench(unsigned int size, unsigned int count)
+{
+	uint8_t output[HASH_MAX_DIGEST_SIZE];
+	uint64_t bytes = (uint64_t)size * count;
+	uint8_t *buf;
+	ulong start;
+	int i, j;
+#ifdef HASH_ENGINE
+	struct udevice *dev;
+#endif
+
+	buf = malloc(size);
+	if (!buf)
+		return -ENOMEM;
+	for (i = 0; i < size; i++)
+		buf[i] = i * 7 + (i >> 8);
+
+	printf("Hashing %u bytes x %u\n", size, count);
+	printf("%-8s %-16s %13s\n", "algo", "engine", "throughput");
+	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
+		struct hash_algo *algo = &hash_algo[i];
+
+		start = timer_get_us();
+		for (j = 0; j < count; j++)
+			algo->hash_func_ws(buf, size, output, algo->chunk_size);
+		hash_bench_show(algo, "builtin", bytes,
+				timer_get_us() - start);
+#ifdef HASH_ENGINE
+		for (uclass_first_device(UCLASS_HASH, &dev);
+		     dev;
+		     uclass_next_device(&dev)) {
+			int ret = 0;
+
+			if (hash_engine_supports(dev, algo->name))
+				continue;
+			start = timer_get_us();
+			for (j = 0; !ret && j < count; j++) {
+				ret = hash_engine_digest(dev, algo->name, buf,
+							 size, output,
+							 sizeof(output),
+							 algo->chunk_size);
+			}
+			if (ret) {
+				printf("%-8s %-16s failed (err=%d)\n",
+				       algo->name, dev->name, ret);
+				continue;
+			}
+			hash_bench_show(algo, dev->name, bytes,
+					timer_get_us() - start);
+		}
 #endif
+	}
+	free(buf);
+
+	return 0;
+}
+#endif /* CONFIG_CMD_HASH */
+#endif /* !USE_HOSTCC */
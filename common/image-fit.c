@@ -897,6 +897,84 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 	return 0;
 }
 
+#if IMAGE_ENABLE_HASH_CACHE
+/* Number of digests to remember; enough for a typical configuration */
+#define FIT_HASH_CACHE_SIZE	8
+
+struct fit_hash_cache_entry {
+	const void *data;
+	ulong size;
+	char algo[16];
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+};
+
+static struct {
+	bool active;
+	int next;
+	struct fit_hash_cache_entry entry[FIT_HASH_CACHE_SIZE];
+	struct fit_hash_cache_stats stats;
+} fit_hash_cache;
+
+void fit_hash_cache_start(void)
+{
+	memset(&fit_hash_cache, '\0', sizeof(fit_hash_cache));
+	fit_hash_cache.active = true;
+}
+
+void fit_hash_cache_stop(void)
+{
+	fit_hash_cache.active = false;
+	memset(fit_hash_cache.entry, '\0', sizeof(fit_hash_cache.entry));
+}
+
+int fit_hash_cache_lookup(const void *data, ulong size, const char *algo,
+			  uint8_t *value, int *value_len)
+{
+	struct fit_hash_cache_entry *entry;
+	int i;
+
+	if (!fit_hash_cache.active)
+		return -ENOENT;
+	for (i = 0; i < FIT_HASH_CACHE_SIZE; i++) {
+		entry = &fit_hash_cache.entry[i];
+		if (*entry->algo && entry->data == data &&
+		    entry->size == size && !strcmp(entry->algo, algo)) {
+			memcpy(value, entry->value, entry->value_len);
+			*value_len = entry->value_len;
+			fit_hash_cache.stats.hits++;
+			return 0;
+		}
+	}
+	fit_hash_cache.stats.misses++;
+	fit_hash_cache.stats.bytes += size;
+
+	return -ENOENT;
+}
+
+void fit_hash_cache_add(const void *data, ulong size, const char *algo,
+			const uint8_t *value, int value_len)
+{
+	struct fit_hash_cache_entry *entry;
+
+	if (!fit_hash_cache.active || value_len > FIT_MAX_HASH_LEN ||
+	    strlen(algo) >= sizeof(entry->algo))
+		return;
+	entry = &fit_hash_cache.entry[fit_hash_cache.next];
+	fit_hash_cache.next = (fit_hash_cache.next + 1) % FIT_HASH_CACHE_SIZE;
+	entry->data = data;
+	entry->size = size;
+	strcpy(entry->algo, algo);
+	memcpy(entry->value, value, value_len);
+	entry->value_len = value_len;
+}
+
+void fit_hash_cache_get_stats(struct fit_hash_cache_stats *stats)
+{
+	*stats = fit_hash_cache.stats;
+}
+#endif /* IMAGE_ENABLE_HASH_CACHE */
+
 /**
  * calculate_hash - calculate and return hash for provided input data
  * @data: pointer to the input data
@@ -907,7 +985,8 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
  * value_len: length of the calculated hash
  *
  * calculate_hash() computes input data hash according to the requested
- * algorithm.
+ * algorithm. If the FIT hash cache is active and already holds the digest
+ * for this data, that is returned instead.
  * Resulting hash value is placed in caller provided 'value' buffer, length
  * of the calculated hash is returned via value_len pointer argument.
  *
@@ -918,6 +997,24 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len)
 {
+	if (!fit_hash_cache_lookup(data, data_len, algo, value, value_len))
+		return 0;
+#ifndef USE_HOSTCC
+#if CONFIG_IS_ENABLED(DM_HASH)
+	/*
+	 * Use a hash engine if one is available. The crc32 value is stored
+	 * big-endian in the FIT so it is left to the code below.
+	 */
+	if (strcmp(algo, "crc32")) {
+		*value_len = FIT_MAX_HASH_LEN;
+		if (!hash_block(algo, data, data_len, value, value_len)) {
+			fit_hash_cache_add(data, data_len, algo, value,
+					   *value_len);
+			return 0;
+		}
+	}
+#endif
+#endif
 	if (IMAGE_ENABLE_CRC32 && strcmp(algo, "crc32") == 0) {
 		*((uint32_t *)value) = crc32_wd(0, data, data_len,
 							CHUNKSZ_CRC32);
@@ -938,6 +1035,8 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 		debug("Unsupported hash alogrithm\n");
 		return -1;
 	}
+	fit_hash_cache_add(data, data_len, algo, value, *value_len);
+
 	return 0;
 }
 
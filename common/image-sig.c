@@ -15,6 +15,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #include <image.h>
 #include <u-boot/rsa.h>
 #include <u-boot/rsa-checksum.h>
+#include <u-boot/ecdsa.h>
 
 #define IMAGE_MAX_HASHED_NODES		100
 
@@ -60,6 +61,26 @@ struct checksum_algo checksum_algos[] = {
 #endif
 		hash_calculate,
 		padding_sha256_rsa4096,
+	},
+	{
+		"sha256",
+		SHA256_SUM_LEN,
+		RSA3072_BYTES,
+#if IMAGE_ENABLE_SIGN
+		EVP_sha256,
+#endif
+		hash_calculate,
+		padding_sha256_rsa3072,
+	},
+	{
+		"sha256",
+		SHA256_SUM_LEN,
+		ECDSA_P256_SIG_BYTES,
+#if IMAGE_ENABLE_SIGN
+		EVP_sha256,
+#endif
+		hash_calculate,
+		NULL,
 	}
 
 };
@@ -85,6 +106,20 @@ struct image_sig_algo image_sig_algos[] = {
 		rsa_add_verify_data,
 		rsa_verify,
 		&checksum_algos[2],
+	},
+	{
+		"sha256,rsa3072",
+		rsa_sign,
+		rsa_add_verify_data,
+		rsa_verify,
+		&checksum_algos[3],
+	},
+	{
+		"sha256,ecdsa256",
+		ecdsa_sign,
+		ecdsa_add_verify_data,
+		ecdsa_verify,
+		&checksum_algos[4],
 	}
 
 };
@@ -451,6 +451,7 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	spl_board_init();
 #endif
 
+	bootstage_mark_name(BOOTSTAGE_ID_SPL_LOAD, "spl_load");
 	board_boot_order(spl_boot_list);
 	for (i = 0; i < ARRAY_SIZE(spl_boot_list) &&
 			spl_boot_list[i] != BOOT_DEVICE_NONE; i++) {
@@ -465,6 +466,13 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 		hang();
 	}
 
+	bootstage_mark_name(BOOTSTAGE_ID_END_SPL, "end_spl");
+#ifdef CONFIG_SPL_BOOTSTAGE
+	/* Pass the timings on to U-Boot, which reads them in board_init_f() */
+	bootstage_stash((void *)CONFIG_BOOTSTAGE_STASH_ADDR,
+			CONFIG_BOOTSTAGE_STASH_SIZE);
+#endif
+
 	switch (spl_image.os) {
 	case IH_OS_U_BOOT:
 		debug("Jumping to U-Boot\n");
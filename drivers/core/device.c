@@ -14,6 +14,7 @@
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
+#include <uthread.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -29,9 +30,10 @@ DECLARE_GLOBAL_DATA_PTR;
 
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *platdata,
-			      ulong driver_data, int of_offset,
+			      ulong driver_data, ofnode node,
 			      uint of_platdata_size, struct udevice **devp)
 {
+	int of_offset = ofnode_to_offset(node);
 	struct udevice *dev;
 	struct uclass *uc;
 	int size, ret = 0;
@@ -61,6 +63,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	dev->driver_data = driver_data;
 	dev->name = name;
 	dev->of_offset = of_offset;
+	dev->node = node;
 	dev->parent = parent;
 	dev->driver = drv;
 	dev->uclass = uc;
@@ -215,19 +218,19 @@ fail_alloc1:
 
 int device_bind_with_driver_data(struct udevice *parent,
 				 const struct driver *drv, const char *name,
-				 ulong driver_data, int of_offset,
+				 ulong driver_data, ofnode node,
 				 struct udevice **devp)
 {
 	return device_bind_common(parent, drv, name, NULL, driver_data,
-				  of_offset, 0, devp);
+				  node, 0, devp);
 }
 
 int device_bind(struct udevice *parent, const struct driver *drv,
 		const char *name, void *platdata, int of_offset,
 		struct udevice **devp)
 {
-	return device_bind_common(parent, drv, name, platdata, 0, of_offset, 0,
-				  devp);
+	return device_bind_common(parent, drv, name, platdata, 0,
+				  offset_to_ofnode(of_offset), 0, devp);
 }
 
 int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
@@ -246,7 +249,8 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
 	platdata_size = info->platdata_size;
 #endif
 	return device_bind_common(parent, drv, info->name,
-			(void *)info->platdata, 0, -1, platdata_size, devp);
+			(void *)info->platdata, 0, ofnode_null(), platdata_size,
+			devp);
 }
 
 static void *alloc_priv(int size, uint flags)
@@ -264,6 +268,43 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
+#ifdef CONFIG_UTHREAD
+/*
+ * A device is marked as activated before its driver's probe method runs, so
+ * that children probed from that method find it ready. The probe method may
+ * give way to other threads in udelay(), so another thread which finds the
+ * device activated must wait until it has been probed. Returns true if the
+ * device is then active.
+ */
+static bool device_probe_wait(struct udevice *dev)
+{
+	while ((dev->flags & DM_FLAG_PROBING) &&
+	       dev->prober != uthread_self()) {
+		if (uthread_self())
+			uthread_schedule();
+		else
+			uthread_step();
+	}
+
+	return dev->flags & DM_FLAG_ACTIVATED;
+}
+
+static void device_set_probing(struct udevice *dev)
+{
+	dev->flags |= DM_FLAG_PROBING;
+	dev->prober = uthread_self();
+}
+#else
+static bool device_probe_wait(struct udevice *dev)
+{
+	return dev->flags & DM_FLAG_ACTIVATED;
+}
+
+static void device_set_probing(struct udevice *dev)
+{
+}
+#endif
+
 int device_probe(struct udevice *dev)
 {
 	const struct driver *drv;
@@ -274,7 +315,7 @@ int device_probe(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
-	if (dev->flags & DM_FLAG_ACTIVATED)
+	if (device_probe_wait(dev))
 		return 0;
 
 	drv = dev->driver;
@@ -323,7 +364,7 @@ int device_probe(struct udevice *dev)
 		 * (e.g. PCI bridge devices). Test the flags again
 		 * so that we don't mess up the device.
 		 */
-		if (dev->flags & DM_FLAG_ACTIVATED)
+		if (device_probe_wait(dev))
 			return 0;
 	}
 
@@ -335,6 +376,7 @@ int device_probe(struct udevice *dev)
 	dev->seq = seq;
 
 	dev->flags |= DM_FLAG_ACTIVATED;
+	device_set_probing(dev);
 
 	/*
 	 * Process pinctrl for everything except the root device, and
@@ -375,6 +417,7 @@ int device_probe(struct udevice *dev)
 
 	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
 		pinctrl_select_state(dev, "default");
+	dev->flags &= ~DM_FLAG_PROBING;
 
 	return 0;
 fail_uclass:
@@ -383,7 +426,7 @@ fail_uclass:
 			__func__, dev->name);
 	}
 fail:
-	dev->flags &= ~DM_FLAG_ACTIVATED;
+	dev->flags &= ~(DM_FLAG_ACTIVATED | DM_FLAG_PROBING);
 
 	dev->seq = -1;
 	device_free(dev);
@@ -775,9 +818,7 @@ int device_set_name(struct udevice *dev, const char *name)
 
 bool of_device_is_compatible(struct udevice *dev, const char *compat)
 {
-	const void *fdt = gd->fdt_blob;
-
-	return !fdt_node_check_compatible(fdt, dev->of_offset, compat);
+	return ofnode_device_is_compatible(dev_ofnode(dev), compat);
 }
 
 bool of_machine_is_compatible(const char *compat)
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Functions for reading the live device tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <libfdt.h>
+#include <dm/of_access.h>
+
+struct property *of_find_property(const struct device_node *np,
+				  const char *name, int *lenp)
+{
+	struct property *pp;
+
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (!strcmp(pp->name, name)) {
+			if (lenp)
+				*lenp = pp->length;
+			return pp;
+		}
+	}
+	if (lenp)
+		*lenp = -FDT_ERR_NOTFOUND;
+
+	return NULL;
+}
+
+const void *of_get_property(const struct device_node *np, const char *name,
+			    int *lenp)
+{
+	struct property *pp = of_find_property(np, name, lenp);
+
+	return pp ? pp->value : NULL;
+}
+
+int of_read_u32_array(const struct device_node *np, const char *propname,
+		      u32 *out_values, size_t sz)
+{
+	const fdt32_t *val;
+	int len;
+
+	val = of_get_property(np, propname, &len);
+	if (!val)
+		return -EINVAL;
+	if (len < sz * sizeof(*val))
+		return -EOVERFLOW;
+	while (sz--)
+		*out_values++ = fdt32_to_cpu(*val++);
+
+	return 0;
+}
+
+int of_read_u32(const struct device_node *np, const char *propname, u32 *outp)
+{
+	return of_read_u32_array(np, propname, outp, 1);
+}
+
+bool of_device_is_available(const struct device_node *np)
+{
+	const char *status;
+	int len;
+
+	status = of_get_property(np, "status", &len);
+	if (!status)
+		return true;
+
+	/* Only "okay", as with fdtdec_get_is_enabled() for the flat tree */
+	return len > 0 && !strcmp(status, "okay");
+}
+
+bool of_node_is_compatible(const struct device_node *np, const char *compat)
+{
+	const char *list, *end;
+	int len;
+
+	list = of_get_property(np, "compatible", &len);
+	if (!list)
+		return false;
+	for (end = list + len; list < end; list += strlen(list) + 1) {
+		if (!strcmp(list, compat))
+			return true;
+	}
+
+	return false;
+}
+
+struct device_node *of_find_subnode(const struct device_node *np,
+				    const char *name, int len)
+{
+	struct device_node *child;
+
+	for (child = np->child; child; child = child->sibling) {
+		if (!strncmp(child->name, name, len) &&
+		    (!child->name[len] ||
+		     (!memchr(name, '@', len) && child->name[len] == '@')))
+			return child;
+	}
+
+	return NULL;
+}
+
+/* Look up an alias, returning its path or NULL if not found */
+static const char *of_find_alias(const struct device_node *root,
+				 const char *name, int len)
+{
+	struct device_node *aliases;
+	struct property *pp;
+
+	aliases = of_find_subnode(root, "aliases", 7);
+	if (!aliases)
+		return NULL;
+	for (pp = aliases->properties; pp; pp = pp->next) {
+		if (!strncmp(pp->name, name, len) && !pp->name[len])
+			return pp->value;
+	}
+
+	return NULL;
+}
+
+struct device_node *of_find_node_by_path(const struct device_node *root,
+					 const char *path)
+{
+	const struct device_node *np = root;
+	const char *end = path + strlen(path);
+	const char *p = path, *q;
+
+	if (*path != '/') {
+		const char *alias;
+
+		q = strchr(path, '/');
+		if (!q)
+			q = end;
+		alias = of_find_alias(root, path, q - path);
+		if (!alias || *alias != '/')
+			return NULL;
+		np = of_find_node_by_path(root, alias);
+		p = q;
+	}
+
+	while (np && p < end) {
+		while (*p == '/')
+			p++;
+		if (p == end)
+			break;
+		q = strchr(p, '/');
+		if (!q)
+			q = end;
+		np = of_find_subnode(np, p, q - p);
+		p = q;
+	}
+
+	return (struct device_node *)np;
+}
+
+/* Move to the next node in depth-first order, or NULL at the end */
+static const struct device_node *of_next_node(const struct device_node *np)
+{
+	if (np->child)
+		return np->child;
+	while (np && !np->sibling)
+		np = np->parent;
+
+	return np ? np->sibling : NULL;
+}
+
+struct device_node *of_find_node_by_phandle(const struct device_node *root,
+					    uint32_t phandle)
+{
+	const struct device_node *np;
+
+	if (!phandle)
+		return NULL;
+	for (np = root; np; np = of_next_node(np)) {
+		if (np->phandle == phandle)
+			return (struct device_node *)np;
+	}
+
+	return NULL;
+}
+
+struct device_node *of_find_node_by_offset(const struct device_node *root,
+					   int offset)
+{
+	const struct device_node *np = root, *child, *best;
+
+	while (np && np->of_offset != offset) {
+		/*
+		 * Children are in offset order and each one's subtree ends
+		 * before the next starts, so the node is below the last
+		 * child that starts before it.
+		 */
+		best = NULL;
+		for (child = np->child; child; child = child->sibling) {
+			if (child->of_offset > offset)
+				break;
+			best = child;
+		}
+		np = best;
+	}
+
+	return (struct device_node *)np;
+}
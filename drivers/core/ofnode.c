@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Device tree access which works with either the live tree or the flat tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <fdtdec.h>
+#include <libfdt.h>
+#include <dm/of_access.h>
+#include <dm/ofnode.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+ofnode offset_to_ofnode(int of_offset)
+{
+	ofnode node;
+
+	if (of_live_active())
+		node.np = of_offset < 0 ? NULL :
+			of_find_node_by_offset(gd_of_root(), of_offset);
+	else
+		node.of_offset = of_offset;
+
+	return node;
+}
+
+ofnode ofnode_root(void)
+{
+	if (of_live_active())
+		return np_to_ofnode(gd_of_root());
+
+	return offset_to_ofnode(0);
+}
+
+const void *ofnode_read_prop(ofnode node, const char *propname, int *lenp)
+{
+	if (of_live_active())
+		return of_get_property(ofnode_to_np(node), propname, lenp);
+
+	return fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
+			   lenp);
+}
+
+int ofnode_read_u32_array(ofnode node, const char *propname,
+			  u32 *out_values, size_t sz)
+{
+	const fdt32_t *val;
+	int len;
+
+	if (of_live_active())
+		return of_read_u32_array(ofnode_to_np(node), propname,
+					 out_values, sz);
+
+	val = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
+			  &len);
+	if (!val)
+		return -EINVAL;
+	if (len < sz * sizeof(*val))
+		return -EOVERFLOW;
+	while (sz--)
+		*out_values++ = fdt32_to_cpu(*val++);
+
+	return 0;
+}
+
+int ofnode_read_u32(ofnode node, const char *propname, u32 *outp)
+{
+	return ofnode_read_u32_array(node, propname, outp, 1);
+}
+
+u32 ofnode_read_u32_default(ofnode node, const char *propname, u32 def)
+{
+	ofnode_read_u32(node, propname, &def);
+
+	return def;
+}
+
+const char *ofnode_read_string(ofnode node, const char *propname)
+{
+	const char *str;
+	int len;
+
+	str = ofnode_read_prop(node, propname, &len);
+	if (!str || len < 1 || strnlen(str, len) >= len)
+		return NULL;
+
+	return str;
+}
+
+bool ofnode_read_bool(ofnode node, const char *propname)
+{
+	return ofnode_read_prop(node, propname, NULL) != NULL;
+}
+
+const char *ofnode_get_name(ofnode node)
+{
+	if (of_live_active())
+		return ofnode_to_np(node)->name;
+
+	return fdt_get_name(gd->fdt_blob, ofnode_to_offset(node), NULL);
+}
+
+uint32_t ofnode_get_phandle(ofnode node)
+{
+	if (of_live_active())
+		return ofnode_to_np(node)->phandle;
+
+	return fdt_get_phandle(gd->fdt_blob, ofnode_to_offset(node));
+}
+
+bool ofnode_is_available(ofnode node)
+{
+	if (of_live_active())
+		return of_device_is_available(ofnode_to_np(node));
+
+	return fdtdec_get_is_enabled(gd->fdt_blob, ofnode_to_offset(node));
+}
+
+bool ofnode_device_is_compatible(ofnode node, const char *compat)
+{
+	if (of_live_active())
+		return of_node_is_compatible(ofnode_to_np(node), compat);
+
+	return !fdt_node_check_compatible(gd->fdt_blob, ofnode_to_offset(node),
+					  compat);
+}
+
+ofnode ofnode_first_subnode(ofnode node)
+{
+	if (of_live_active())
+		return np_to_ofnode(ofnode_to_np(node)->child);
+
+	return offset_to_ofnode(fdt_first_subnode(gd->fdt_blob,
+						  ofnode_to_offset(node)));
+}
+
+ofnode ofnode_next_subnode(ofnode node)
+{
+	if (of_live_active())
+		return np_to_ofnode(ofnode_to_np(node)->sibling);
+
+	return offset_to_ofnode(fdt_next_subnode(gd->fdt_blob,
+						 ofnode_to_offset(node)));
+}
+
+ofnode ofnode_find_subnode(ofnode node, const char *name)
+{
+	if (of_live_active())
+		return np_to_ofnode(of_find_subnode(ofnode_to_np(node), name,
+						    strlen(name)));
+
+	return offset_to_ofnode(fdt_subnode_offset(gd->fdt_blob,
+						   ofnode_to_offset(node),
+						   name));
+}
+
+ofnode ofnode_get_parent(ofnode node)
+{
+	if (of_live_active())
+		return np_to_ofnode(ofnode_to_np(node)->parent);
+
+	return offset_to_ofnode(fdt_parent_offset(gd->fdt_blob,
+						  ofnode_to_offset(node)));
+}
+
+ofnode ofnode_path(const char *path)
+{
+	if (of_live_active())
+		return np_to_ofnode(of_find_node_by_path(gd_of_root(), path));
+
+	return offset_to_ofnode(fdt_path_offset(gd->fdt_blob, path));
+}
+
+ofnode ofnode_get_by_phandle(uint32_t phandle)
+{
+	if (of_live_active())
+		return np_to_ofnode(of_find_node_by_phandle(gd_of_root(),
+							    phandle));
+
+	return offset_to_ofnode(fdt_node_offset_by_phandle(gd->fdt_blob,
+							   phandle));
+}
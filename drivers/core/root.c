@@ -159,6 +159,7 @@ int dm_init(void)
 		return ret;
 #if CONFIG_IS_ENABLED(OF_CONTROL)
 	DM_ROOT_NON_CONST->of_offset = 0;
+	DM_ROOT_NON_CONST->node = ofnode_root();
 #endif
 	ret = device_probe(DM_ROOT_NON_CONST);
 	if (ret)
@@ -189,26 +190,32 @@ int dm_scan_platdata(bool pre_reloc_only)
 }
 
 #if CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)
-int dm_scan_fdt_node(struct udevice *parent, const void *blob, int offset,
-		     bool pre_reloc_only)
+/**
+ * dm_scan_fdt_ofnode() - Bind the subnodes of a node
+ *
+ * @parent:		Parent device for the devices that are bound
+ * @parent_node:	Node whose subnodes are scanned
+ * @pre_reloc_only:	If true, bind only nodes marked u-boot,dm-pre-reloc
+ * @return 0 if OK, -ve on error
+ */
+static int dm_scan_fdt_ofnode(struct udevice *parent, ofnode parent_node,
+			      bool pre_reloc_only)
 {
 	int ret = 0, err;
+	ofnode node;
 
-	for (offset = fdt_first_subnode(blob, offset);
-	     offset > 0;
-	     offset = fdt_next_subnode(blob, offset)) {
+	ofnode_for_each_subnode(node, parent_node) {
 		if (pre_reloc_only &&
-		    !fdt_getprop(blob, offset, "u-boot,dm-pre-reloc", NULL))
+		    !ofnode_read_bool(node, "u-boot,dm-pre-reloc"))
 			continue;
-		if (!fdtdec_get_is_enabled(blob, offset)) {
+		if (!ofnode_is_available(node)) {
 			dm_dbg("   - ignoring disabled device\n");
 			continue;
 		}
-		err = lists_bind_fdt(parent, blob, offset, NULL);
+		err = lists_bind_fdt(parent, node, NULL);
 		if (err && !ret) {
 			ret = err;
-			debug("%s: ret=%d\n", fdt_get_name(blob, offset, NULL),
-			      ret);
+			debug("%s: ret=%d\n", ofnode_get_name(node), ret);
 		}
 	}
 
@@ -218,18 +225,25 @@ int dm_scan_fdt_node(struct udevice *parent, const void *blob, int offset,
 	return ret;
 }
 
+int dm_scan_fdt_node(struct udevice *parent, const void *blob, int offset,
+		     bool pre_reloc_only)
+{
+	return dm_scan_fdt_ofnode(parent, offset_to_ofnode(offset),
+				  pre_reloc_only);
+}
+
 int dm_scan_fdt_dev(struct udevice *dev)
 {
-	if (dev->of_offset == -1)
+	if (!ofnode_valid(dev_ofnode(dev)))
 		return 0;
 
-	return dm_scan_fdt_node(dev, gd->fdt_blob, dev->of_offset,
-				gd->flags & GD_FLG_RELOC ? false : true);
+	return dm_scan_fdt_ofnode(dev, dev_ofnode(dev),
+				  gd->flags & GD_FLG_RELOC ? false : true);
 }
 
 int dm_scan_fdt(const void *blob, bool pre_reloc_only)
 {
-	return dm_scan_fdt_node(gd->dm_root, blob, 0, pre_reloc_only);
+	return dm_scan_fdt_ofnode(gd->dm_root, ofnode_root(), pre_reloc_only);
 }
 #endif
 
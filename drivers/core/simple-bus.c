@@ -30,8 +30,8 @@ static int simple_bus_post_bind(struct udevice *dev)
 	u32 cell[3];
 	int ret;
 
-	ret = fdtdec_get_int_array(gd->fdt_blob, dev->of_offset, "ranges",
-				   cell, ARRAY_SIZE(cell));
+	ret = ofnode_read_u32_array(dev_ofnode(dev), "ranges", cell,
+				    ARRAY_SIZE(cell));
 	if (!ret) {
 		struct simple_bus_plat *plat = dev_get_uclass_platdata(dev);
 
@@ -290,8 +290,7 @@ static int uclass_find_device_by_phandle(enum uclass_id id,
 	int ret;
 
 	*devp = NULL;
-	find_phandle = fdtdec_get_int(gd->fdt_blob, parent->of_offset, name,
-				      -1);
+	find_phandle = ofnode_read_u32_default(dev_ofnode(parent), name, -1);
 	if (find_phandle <= 0)
 		return -ENOENT;
 	ret = uclass_get(id, &uc);
@@ -299,9 +298,9 @@ static int uclass_find_device_by_phandle(enum uclass_id id,
 		return ret;
 
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
-		uint phandle = fdt_get_phandle(gd->fdt_blob, dev->of_offset);
-
-		if (phandle == find_phandle) {
+		if (!ofnode_valid(dev_ofnode(dev)))
+			continue;
+		if (ofnode_get_phandle(dev_ofnode(dev)) == find_phandle) {
 			*devp = dev;
 			return 0;
 		}
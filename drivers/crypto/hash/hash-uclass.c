@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <watchdog.h>
+#include <u-boot/hash-engine.h>
+
+int hash_engine_supports(struct udevice *dev, const char *algo_name)
+{
+	struct hash_ops *ops = hash_get_ops(dev);
+
+	if (!ops->supports)
+		return -ENOSYS;
+
+	return ops->supports(dev, algo_name);
+}
+
+int hash_engine_get(const char *algo_name, struct udevice **devp)
+{
+	struct udevice *dev;
+	const char *name;
+	int ret;
+
+	name = getenv("hash_engine");
+	if (name) {
+		if (!strcmp(name, "none"))
+			return -ENODEV;
+		ret = uclass_get_device_by_name(UCLASS_HASH, name, &dev);
+		if (ret) {
+			debug("%s: Hash engine '%s' not found\n", __func__,
+			      name);
+			return -ENODEV;
+		}
+		if (hash_engine_supports(dev, algo_name))
+			return -ENODEV;
+		*devp = dev;
+		return 0;
+	}
+
+	for (uclass_first_device(UCLASS_HASH, &dev);
+	     dev;
+	     uclass_next_device(&dev)) {
+		if (!hash_engine_supports(dev, algo_name)) {
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+int hash_engine_init(struct udevice *dev, const char *algo_name, void **ctxp)
+{
+	struct hash_ops *ops = hash_get_ops(dev);
+
+	if (!ops->init)
+		return -ENOSYS;
+
+	return ops->init(dev, algo_name, ctxp);
+}
+
+int hash_engine_update(struct udevice *dev, void *ctx, const void *buf,
+		       unsigned int size)
+{
+	struct hash_ops *ops = hash_get_ops(dev);
+
+	if (!ops->update)
+		return -ENOSYS;
+
+	return ops->update(dev, ctx, buf, size);
+}
+
+int hash_engine_update_async(struct udevice *dev, void *ctx, const void *buf,
+			     unsigned int size)
+{
+	struct hash_ops *ops = hash_get_ops(dev);
+
+	if (!ops->update_async)
+		return hash_engine_update(dev, ctx, buf, size);
+
+	return ops->update_async(dev, ctx, buf, size);
+}
+
+int hash_engine_wait(struct udevice *dev, void *ctx, ulong timeout_ms)
+{
+	struct hash_ops *ops = hash_get_ops(dev);
+
+	if (!ops->wait)
+		return 0;
+
+	return ops->wait(dev, ctx, timeout_ms);
+}
+
+int hash_engine_finish(struct udevice *dev, void *ctx, void *dest_buf,
+		       int size)
+{
+	struct hash_ops *ops = hash_get_ops(dev);
+	int ret;
+
+	if (!ops->finish)
+		return -ENOSYS;
+
+	/* Make sure that any outstanding update has been absorbed */
+	ret = hash_engine_wait(dev, ctx, ~0UL);
+	if (ret)
+		debug("%s: Outstanding update failed: %d\n", __func__, ret);
+
+	return ops->finish(dev, ctx, dest_buf, size);
+}
+
+int hash_engine_digest(struct udevice *dev, const char *algo_name,
+		       const void *buf, unsigned int len, void *output,
+		       int size, unsigned int chunk_size)
+{
+	const char *ptr = buf;
+	void *ctx;
+	int ret;
+
+	ret = hash_engine_init(dev, algo_name, &ctx);
+	if (ret)
+		return ret;
+
+	if (!chunk_size)
+		chunk_size = len;
+	while (len) {
+		unsigned int todo = min(len, chunk_size);
+
+		ret = hash_engine_update(dev, ctx, ptr, todo);
+		if (ret) {
+			hash_engine_finish(dev, ctx, output, size);
+			return ret;
+		}
+		ptr += todo;
+		len -= todo;
+		WATCHDOG_RESET();
+	}
+
+	return hash_engine_finish(dev, ctx, output, size);
+}
+
+UCLASS_DRIVER(hash) = {
+	.id		= UCLASS_HASH,
+	.name		= "hash",
+};
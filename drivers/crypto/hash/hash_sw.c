@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Software hash engine, wrapping the algorithms in lib/
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <malloc.h>
+#include <asm/unaligned.h>
+#include <u-boot/crc.h>
+#include <u-boot/hash-engine.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+enum hash_sw_algo {
+	HASH_SW_CRC32,
+	HASH_SW_SHA1,
+	HASH_SW_SHA256,
+
+	HASH_SW_COUNT,
+};
+
+static const struct {
+	const char *name;
+	int digest_size;
+} hash_sw_algos[HASH_SW_COUNT] = {
+	[HASH_SW_CRC32]		= { "crc32", 4 },
+	[HASH_SW_SHA1]		= { "sha1", SHA1_SUM_LEN },
+	[HASH_SW_SHA256]	= { "sha256", SHA256_SUM_LEN },
+};
+
+/**
+ * struct hash_sw_ctx - context for a software hash
+ *
+ * @algo:	Algorithm being computed
+ * @pending:	Data queued by update_async(), not yet hashed
+ * @pending_size: Number of bytes at @pending
+ */
+struct hash_sw_ctx {
+	enum hash_sw_algo algo;
+	const void *pending;
+	unsigned int pending_size;
+	union {
+		uint32_t crc;
+#ifdef CONFIG_SHA1
+		sha1_context sha1;
+#endif
+#ifdef CONFIG_SHA256
+		sha256_context sha256;
+#endif
+	};
+};
+
+static int hash_sw_find(const char *algo_name)
+{
+	if (!strcmp(algo_name, "crc32"))
+		return HASH_SW_CRC32;
+#ifdef CONFIG_SHA1
+	if (!strcmp(algo_name, "sha1"))
+		return HASH_SW_SHA1;
+#endif
+#ifdef CONFIG_SHA256
+	if (!strcmp(algo_name, "sha256"))
+		return HASH_SW_SHA256;
+#endif
+
+	return -EPROTONOSUPPORT;
+}
+
+static int hash_sw_supports(struct udevice *dev, const char *algo_name)
+{
+	int algo = hash_sw_find(algo_name);
+
+	return algo < 0 ? algo : 0;
+}
+
+static int hash_sw_init(struct udevice *dev, const char *algo_name,
+			void **ctxp)
+{
+	struct hash_sw_ctx *ctx;
+	int algo;
+
+	algo = hash_sw_find(algo_name);
+	if (algo < 0)
+		return algo;
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+	ctx->algo = algo;
+	ctx->pending = NULL;
+	ctx->pending_size = 0;
+
+	switch (ctx->algo) {
+	case HASH_SW_CRC32:
+		ctx->crc = 0;
+		break;
+#ifdef CONFIG_SHA1
+	case HASH_SW_SHA1:
+		sha1_starts(&ctx->sha1);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_SW_SHA256:
+		sha256_starts(&ctx->sha256);
+		break;
+#endif
+	default:
+		break;
+	}
+	*ctxp = ctx;
+
+	return 0;
+}
+
+static int hash_sw_update(struct udevice *dev, void *vctx, const void *buf,
+			  unsigned int size)
+{
+	struct hash_sw_ctx *ctx = vctx;
+
+	switch (ctx->algo) {
+	case HASH_SW_CRC32:
+		ctx->crc = crc32(ctx->crc, buf, size);
+		break;
+#ifdef CONFIG_SHA1
+	case HASH_SW_SHA1:
+		sha1_update(&ctx->sha1, buf, size);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_SW_SHA256:
+		sha256_update(&ctx->sha256, buf, size);
+		break;
+#endif
+	default:
+		return -EPROTONOSUPPORT;
+	}
+
+	return 0;
+}
+
+/*
+ * There is no hardware to hand the data to, so an asynchronous update is
+ * simply recorded and then performed when the caller waits for it. This
+ * keeps the calling sequence identical to a real accelerator.
+ */
+static int hash_sw_update_async(struct udevice *dev, void *vctx,
+				const void *buf, unsigned int size)
+{
+	struct hash_sw_ctx *ctx = vctx;
+
+	if (ctx->pending)
+		return -EBUSY;
+	ctx->pending = buf;
+	ctx->pending_size = size;
+
+	return 0;
+}
+
+static int hash_sw_wait(struct udevice *dev, void *vctx, ulong timeout_ms)
+{
+	struct hash_sw_ctx *ctx = vctx;
+	int ret;
+
+	if (!ctx->pending)
+		return 0;
+	ret = hash_sw_update(dev, ctx, ctx->pending, ctx->pending_size);
+	ctx->pending = NULL;
+	ctx->pending_size = 0;
+
+	return ret;
+}
+
+static int hash_sw_finish(struct udevice *dev, void *vctx, void *dest_buf,
+			  int size)
+{
+	struct hash_sw_ctx *ctx = vctx;
+	int ret = 0;
+
+	if (size < hash_sw_algos[ctx->algo].digest_size) {
+		ret = -ENOSPC;
+		goto done;
+	}
+
+	switch (ctx->algo) {
+	case HASH_SW_CRC32:
+		/* Match crc32_wd_buf(), which stores the CRC big-endian */
+		put_unaligned(cpu_to_be32(ctx->crc), (uint32_t *)dest_buf);
+		break;
+#ifdef CONFIG_SHA1
+	case HASH_SW_SHA1:
+		sha1_finish(&ctx->sha1, dest_buf);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_SW_SHA256:
+		sha256_finish(&ctx->sha256, dest_buf);
+		break;
+#endif
+	default:
+		ret = -EPROTONOSUPPORT;
+		break;
+	}
+done:
+	free(ctx);
+
+	return ret;
+}
+
+static const struct hash_ops hash_sw_ops = {
+	.supports	= hash_sw_supports,
+	.init		= hash_sw_init,
+	.update		= hash_sw_update,
+	.update_async	= hash_sw_update_async,
+	.wait		= hash_sw_wait,
+	.finish		= hash_sw_finish,
+};
+
+U_BOOT_DRIVER(hash_sw) = {
+	.name	= "hash_sw",
+	.id	= UCLASS_HASH,
+	.ops	= &hash_sw_ops,
+	.flags	= DM_FLAG_PRE_RELOC,
+};
+
+U_BOOT_DEVICE(hash_sw) = {
+	.name = "hash_sw",
+};
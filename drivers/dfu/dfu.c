@@ -14,6 +14,8 @@
 #include <fat.h>
 #include <dfu.h>
 #include <hash.h>
+#include <uthread.h>
+#include <u-boot/crc.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
 
@@ -76,12 +78,290 @@ int dfu_init_env_entities(char *interface, char *devstr)
 }
 
 static unsigned char *dfu_buf;
+static unsigned char *dfu_buf2;
 static unsigned long dfu_buf_size;
 
+#ifdef CONFIG_DFU_RESUME
+/* Maximum number of buffers recorded for resuming a transfer */
+#define DFU_RESUME_MAX_CHUNKS	1024
+
+/**
+ * struct dfu_chunk - a buffer which reached the medium
+ *
+ * @offset:	Offset on the medium
+ * @len:	Number of bytes of data in the buffer
+ * @written:	Number of bytes the medium moved on by
+ * @crc:	CRC32 of the data
+ */
+struct dfu_chunk {
+	u64 offset;
+	long len;
+	long written;
+	u32 crc;
+};
+
+/**
+ * struct dfu_resume_info - buffers of the last transfer which were written
+ *
+ * This outlives the entity, so that a transfer which is interrupted and then
+ * started again, even by a new dfu command, can skip buffers which are
+ * already on the medium.
+ *
+ * @name:	Name of the entity being written
+ * @alt:	Alt setting of the entity
+ * @count:	Number of buffers written, in order
+ * @next:	Next buffer to compare while skipping
+ * @skipping:	true while the new transfer matches what was written
+ * @chunk:	Buffers written
+ */
+static struct dfu_resume_info {
+	char name[DFU_NAME_SIZE];
+	int alt;
+	int count;
+	int next;
+	bool skipping;
+	struct dfu_chunk chunk[DFU_RESUME_MAX_CHUNKS];
+} dfu_resume;
+
+/*
+ * Skipping a buffer is only safe if writing it again would do exactly the
+ * same thing. NAND writes move on past bad blocks and file systems are only
+ * written when the transfer is complete, so these are not tracked.
+ */
+static bool dfu_can_resume(struct dfu_entity *dfu)
+{
+	return dfu->layout == DFU_RAW_ADDR && dfu->dev_type != DFU_DEV_NAND;
+}
+
+static bool dfu_resume_match(struct dfu_entity *dfu)
+{
+	return dfu_resume.alt == dfu->alt &&
+		!strcmp(dfu_resume.name, dfu->name);
+}
+
+/* Called at the start of each write transfer */
+static void dfu_resume_start(struct dfu_entity *dfu)
+{
+	dfu_resume.next = 0;
+	dfu_resume.skipping = false;
+	if (!dfu_can_resume(dfu))
+		return;
+	if (dfu_resume_match(dfu)) {
+		dfu_resume.skipping = dfu_resume.count > 0;
+		return;
+	}
+	strlcpy(dfu_resume.name, dfu->name, sizeof(dfu_resume.name));
+	dfu_resume.alt = dfu->alt;
+	dfu_resume.count = 0;
+}
+
+static void dfu_resume_stop(void)
+{
+	struct dfu_chunk *chunk;
+
+	dfu_resume.skipping = false;
+	dfu_resume.count = dfu_resume.next;
+	if (dfu_resume.next) {
+		chunk = &dfu_resume.chunk[dfu_resume.next - 1];
+		printf("\nDFU: resumed after 0x%llx bytes already written\n",
+		       chunk->offset + chunk->written);
+	}
+}
+
+/*
+ * Check whether a buffer was written by an earlier attempt at the same
+ * transfer. If so, move on past it and return true.
+ */
+static bool dfu_resume_skip(struct dfu_entity *dfu, long len, u32 crc)
+{
+	struct dfu_chunk *chunk;
+
+	if (!dfu_resume.skipping)
+		return false;
+	chunk = &dfu_resume.chunk[dfu_resume.next];
+	if (dfu_resume.next == dfu_resume.count ||
+	    chunk->offset != dfu->offset || chunk->len != len ||
+	    chunk->crc != crc) {
+		dfu_resume_stop();
+		return false;
+	}
+	dfu->offset += chunk->written;
+	if (++dfu_resume.next == dfu_resume.count)
+		dfu_resume_stop();
+
+	return true;
+}
+
+/* Record that a buffer has reached the medium */
+static void dfu_resume_commit(struct dfu_entity *dfu, u64 offset, long len,
+			      long written, u32 crc)
+{
+	struct dfu_chunk *chunk;
+
+	if (!dfu_can_resume(dfu) || !dfu_resume_match(dfu) ||
+	    dfu_resume.skipping || dfu_resume.count == DFU_RESUME_MAX_CHUNKS)
+		return;
+	chunk = &dfu_resume.chunk[dfu_resume.count++];
+	chunk->offset = offset;
+	chunk->len = len;
+	chunk->written = written;
+	chunk->crc = crc;
+	dfu_resume.next = dfu_resume.count;
+}
+
+/* Forget the record once a transfer has completed */
+static void dfu_resume_done(void)
+{
+	dfu_resume.name[0] = '\0';
+	dfu_resume.count = 0;
+	dfu_resume.next = 0;
+	dfu_resume.skipping = false;
+}
+
+static u32 dfu_chunk_crc(const void *buf, long len)
+{
+	return crc32(0, buf, len);
+}
+#else
+static inline void dfu_resume_start(struct dfu_entity *dfu)
+{
+}
+
+static inline bool dfu_resume_skip(struct dfu_entity *dfu, long len, u32 crc)
+{
+	return false;
+}
+
+static inline void dfu_resume_commit(struct dfu_entity *dfu, u64 offset,
+				     long len, long written, u32 crc)
+{
+}
+
+static inline void dfu_resume_done(void)
+{
+}
+
+static inline u32 dfu_chunk_crc(const void *buf, long len)
+{
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_DFU_WRITE_ASYNC
+/**
+ * struct dfu_pending - a buffer being written to the medium in a thread
+ *
+ * @dfu:	Entity being written, or NULL if there is no write running
+ * @buf:	Buffer being written
+ * @offset:	Offset on the medium
+ * @len:	Number of bytes in @buf
+ * @written:	Number of bytes the medium moved on by
+ * @crc:	CRC32 of the data, for resuming
+ * @ret:	Result of the write
+ */
+static struct dfu_pending {
+	struct dfu_entity *dfu;
+	u8 *buf;
+	u64 offset;
+	long len;
+	long written;
+	u32 crc;
+	int ret;
+} dfu_pending;
+
+static int dfu_write_thread(void *arg)
+{
+	struct dfu_pending *dp = arg;
+
+	dp->written = dp->len;
+	dp->ret = dp->dfu->write_medium(dp->dfu, dp->offset, dp->buf,
+					&dp->written);
+
+	return dp->ret;
+}
+
+/* Wait for the buffer being written in the background, if any */
+static int dfu_write_wait(void)
+{
+	struct dfu_pending *dp = &dfu_pending;
+	struct dfu_entity *dfu = dp->dfu;
+
+	if (!dfu)
+		return 0;
+	uthread_join_all();
+	dp->dfu = NULL;
+	if (dp->ret) {
+		debug("%s: Write error!\n", __func__);
+		return dp->ret;
+	}
+	dfu->offset += dp->written;
+	dfu_resume_commit(dfu, dp->offset, dp->len, dp->written, dp->crc);
+
+	return 0;
+}
+
+/*
+ * Start writing the current buffer in the background and carry on with the
+ * other one. Returns -EAGAIN if this is not possible, in which case the
+ * buffer must be written straight away.
+ */
+static int dfu_write_start(struct dfu_entity *dfu, long len, u32 crc)
+{
+	struct dfu_pending *dp = &dfu_pending;
+	u8 *other;
+	int ret;
+
+	ret = dfu_write_wait();
+	if (ret)
+		return ret;
+	if (!dfu_buf2)
+		dfu_buf2 = memalign(CONFIG_SYS_CACHELINE_SIZE, dfu_buf_size);
+	if (!dfu_buf2)
+		return -EAGAIN;
+
+	dp->dfu = dfu;
+	dp->buf = dfu->i_buf_start;
+	dp->offset = dfu->offset;
+	dp->len = len;
+	dp->crc = crc;
+	if (uthread_create(dfu_write_thread, dp, "dfu")) {
+		dp->dfu = NULL;
+		return -EAGAIN;
+	}
+
+	other = dfu->i_buf_start == dfu_buf ? dfu_buf2 : dfu_buf;
+	dfu->i_buf_start = other;
+	dfu->i_buf_end = other + dfu_buf_size;
+	dfu->i_buf = other;
+	puts("#");
+
+	return 0;
+}
+
+void dfu_write_poll(void)
+{
+	if (dfu_pending.dfu)
+		uthread_step();
+}
+#else
+static inline int dfu_write_wait(void)
+{
+	return 0;
+}
+
+static inline int dfu_write_start(struct dfu_entity *dfu, long len, u32 crc)
+{
+	return -EAGAIN;
+}
+#endif
+
 unsigned char *dfu_free_buf(void)
 {
+	dfu_write_wait();
 	free(dfu_buf);
 	dfu_buf = NULL;
+	free(dfu_buf2);
+	dfu_buf2 = NULL;
 	return dfu_buf;
 }
 
@@ -132,9 +412,23 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
-static int dfu_write_buffer_drain(struct dfu_entity *dfu)
+/* Is this buffer one of ours, which could be written in the background? */
+static bool dfu_buf_owns(const void *buf)
 {
-	long w_size;
+	const u8 *p = buf;
+
+	return (dfu_buf && p >= dfu_buf && p < dfu_buf + dfu_buf_size) ||
+		(dfu_buf2 && p >= dfu_buf2 && p < dfu_buf2 + dfu_buf_size);
+}
+
+/*
+ * Write out the buffer. If @async is true this may be done in the background
+ * while the other buffer is filled.
+ */
+static int dfu_write_buffer_drain(struct dfu_entity *dfu, bool async)
+{
+	long w_size, len;
+	u32 crc;
 	int ret;
 
 	/* flush size? */
@@ -146,9 +440,28 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
 					   dfu->i_buf_start, w_size, 0);
 
+	crc = dfu_chunk_crc(dfu->i_buf_start, w_size);
+	if (dfu_resume_skip(dfu, w_size, crc)) {
+		dfu->i_buf = dfu->i_buf_start;
+		puts("#");
+		return 0;
+	}
+
+	if (async) {
+		ret = dfu_write_start(dfu, w_size, crc);
+		if (ret != -EAGAIN)
+			return ret;
+	}
+	ret = dfu_write_wait();
+	if (ret)
+		return ret;
+
+	len = w_size;
 	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
 	if (ret)
 		debug("%s: Write error!\n", __func__);
+	else
+		dfu_resume_commit(dfu, dfu->offset, len, w_size, crc);
 
 	/* point back */
 	dfu->i_buf = dfu->i_buf_start;
@@ -163,6 +476,9 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 
 void dfu_write_transaction_cleanup(struct dfu_entity *dfu)
 {
+	/* A buffer may still be on its way to the medium */
+	dfu_write_wait();
+
 	/* clear everything */
 	dfu->crc = 0;
 	dfu->offset = 0;
@@ -177,12 +493,16 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
 	int ret = 0;
 
-	ret = dfu_write_buffer_drain(dfu);
+	ret = dfu_write_buffer_drain(dfu, false);
+	if (!ret)
+		ret = dfu_write_wait();
 	if (ret)
 		return ret;
 
 	if (dfu->flush_medium)
 		ret = dfu->flush_medium(dfu);
+	if (!ret)
+		dfu_resume_done();
 
 	if (dfu_hash_algo)
 		printf("\nDFU complete %s: 0x%08x\n", dfu_hash_algo->name,
@@ -212,6 +532,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 			return -ENOMEM;
 		dfu->i_buf_end = dfu_get_buf(dfu) + dfu_buf_size;
 		dfu->i_buf = dfu->i_buf_start;
+		dfu_resume_start(dfu);
 
 		dfu->inited = 1;
 	}
@@ -241,7 +562,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* flush buffer if overflow */
 	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_drain(dfu, !dfu_buf_owns(buf));
 		if (ret) {
 			dfu_write_transaction_cleanup(dfu);
 			return ret;
@@ -261,7 +582,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* if end or if buffer full flush */
 	if (size == 0 || (dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_drain(dfu, !dfu_buf_owns(buf));
 		if (ret) {
 			dfu_write_transaction_cleanup(dfu);
 			return ret;
@@ -331,6 +652,9 @@ int dfu_read(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	       __func__, dfu->name, buf, size, blk_seq_num, dfu->i_buf);
 
 	if (!dfu->inited) {
+		ret = dfu_write_wait();
+		if (ret)
+			return ret;
 		dfu->i_buf_start = dfu_get_buf(dfu);
 		if (dfu->i_buf_start == NULL)
 			return -ENOMEM;
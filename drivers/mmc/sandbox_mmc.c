@@ -14,20 +14,39 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* The card is high-capacity, so C_SIZE_MULT is taken to be 8: 1MiB */
+#define MMC_CSIZE		0
+#define MMC_CMULT		8
+#define MMC_BL_LEN_SHIFT	10
+#define MMC_CAPACITY		(((MMC_CSIZE + 1) << (MMC_CMULT + 2)) << \
+				 MMC_BL_LEN_SHIFT)
+
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
 };
 
+/**
+ * struct sandbox_mmc_priv - private data for the emulated card
+ *
+ * @buf: Contents of the card
+ */
+struct sandbox_mmc_priv {
+	u8 buf[MMC_CAPACITY];
+};
+
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * This emulate a 1MiB SD card version 2, which is held in memory. It starts
+ * off with a test string in the first block and zeroes elsewhere.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	ulong start, size;
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		break;
@@ -45,7 +64,10 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		break;
 	case MMC_CMD_SEND_CSD:
 		cmd->response[0] = 0;
-		cmd->response[1] = 10 << 16;	/* 1 << block_len */
+		cmd->response[1] = MMC_BL_LEN_SHIFT << 16 |
+				   ((MMC_CSIZE >> 16) & 0x3f);
+		cmd->response[2] = (MMC_CSIZE & 0xffff) << 16;
+		cmd->response[3] = 0;
 		break;
 	case SD_CMD_SWITCH_FUNC: {
 		u32 *resp = (u32 *)data->dest;
@@ -54,10 +76,18 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		break;
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
-		memset(data->dest, '\0', data->blocksize);
-		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
-		strcpy(data->dest, "this is a test");
+	case MMC_CMD_WRITE_SINGLE_BLOCK:
+	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		/* The card is high-capacity, so the argument is a block */
+		start = (ulong)cmd->cmdarg * data->blocksize;
+		size = data->blocks * data->blocksize;
+		if (start + size > MMC_CAPACITY)
+			return -EINVAL;
+		if (data->flags & MMC_DATA_READ)
+			memcpy(data->dest, priv->buf + start, size);
+		else
+			memcpy(priv->buf + start, data->src, size);
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
@@ -104,6 +134,9 @@ static const struct dm_mmc_ops sandbox_mmc_ops = {
 int sandbox_mmc_probe(struct udevice *dev)
 {
 	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	strcpy((char *)priv->buf, "this is a test");
 
 	return mmc_init(&plat->mmc);
 }
@@ -143,5 +176,6 @@ U_BOOT_DRIVER(mmc_sandbox) = {
 	.bind		= sandbox_mmc_bind,
 	.unbind		= sandbox_mmc_unbind,
 	.probe		= sandbox_mmc_probe,
+	.priv_auto_alloc_size = sizeof(struct sandbox_mmc_priv),
 	.platdata_auto_alloc_size = sizeof(struct sandbox_mmc_plat),
 };
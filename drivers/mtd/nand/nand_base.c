@@ -1500,6 +1500,33 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+/**
+ * nand_cache_read_last - [INTERN] Find the last page for a cache read
+ * @mtd: MTD device structure
+ * @page: first page to read
+ * @end: offset just after the last byte to read
+ *
+ * Cache reads are used for sequential reads of two or more pages within an
+ * eraseblock. While one page is transferred from the cache register the chip
+ * reads the next one from the array, hiding tR.
+ *
+ * Returns the last page to read with cache read commands, or -1 if a normal
+ * page read should be used.
+ */
+static int nand_cache_read_last(struct mtd_info *mtd, int page, loff_t end)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	int ppb = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int last;
+
+	if (!NAND_HAS_CACHE_READ(chip))
+		return -1;
+
+	last = min_t(int, (end - 1) >> chip->page_shift, page | (ppb - 1));
+
+	return last > page ? last : -1;
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -1523,6 +1550,9 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	unsigned int max_bitflips = 0;
 	int retry_mode = 0;
 	bool ecc_fail = false;
+	/* last page of an ongoing cache read, or -1 */
+	int cache_last = -1;
+	bool cached;
 
 	chipnr = (int)(from >> chip->chip_shift);
 	chip->select_chip(mtd, chipnr);
@@ -1548,8 +1578,11 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		else
 			use_bufpoi = 0;
 
-		/* Is the current page in the buffer? */
-		if (realpage != chip->pagebuf || oob) {
+		/*
+		 * Is the current page in the buffer? A cache read must go on
+		 * to the next page, so the buffer cannot be used then.
+		 */
+		if (realpage != chip->pagebuf || oob || cache_last != -1) {
 			bufpoi = use_bufpoi ? chip->buffers->databuf : buf;
 
 			if (use_bufpoi && aligned)
@@ -1557,7 +1590,25 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 						 __func__, buf);
 
 read_retry:
-			chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+			cached = cache_last != -1;
+			if (cached) {
+				chip->cmdfunc(mtd, page == cache_last ?
+					      NAND_CMD_READCACHEEND :
+					      NAND_CMD_READCACHESEQ, -1, -1);
+			} else {
+				chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+				if (!retry_mode)
+					cache_last = nand_cache_read_last(mtd,
+						page, from + ops->len);
+				if (cache_last != -1) {
+					chip->cmdfunc(mtd,
+						      NAND_CMD_READCACHESEQ,
+						      -1, -1);
+					cached = true;
+				}
+			}
+			if (page == cache_last)
+				cache_last = -1;
 
 			/*
 			 * Now read the page into the buffer.  Absent an error,
@@ -1568,7 +1619,7 @@ read_retry:
 							      oob_required,
 							      page);
 			else if (!aligned && NAND_HAS_SUBPAGE_READ(chip) &&
-				 !oob)
+				 !oob && !cached)
 				ret = chip->ecc.read_subpage(mtd, chip,
 							col, bytes, bufpoi,
 							page);
@@ -1618,6 +1669,13 @@ read_retry:
 
 			if (mtd->ecc_stats.failed - ecc_failures) {
 				if (retry_mode + 1 < chip->read_retries) {
+					/* Finish any cache read first */
+					if (cache_last != -1) {
+						chip->cmdfunc(mtd,
+							NAND_CMD_READCACHEEND,
+							-1, -1);
+						cache_last = -1;
+					}
 					retry_mode++;
 					ret = nand_setup_read_retry(mtd,
 							retry_mode);
@@ -1667,6 +1725,9 @@ read_retry:
 			chip->select_chip(mtd, chipnr);
 		}
 	}
+	/* Leave the chip idle if a cache read was cut short by an error */
+	if (cache_last != -1)
+		chip->cmdfunc(mtd, NAND_CMD_READCACHEEND, -1, -1);
 	chip->select_chip(mtd, -1);
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -4174,18 +4235,32 @@ int nand_scan_tail(struct mtd_info *mtd)
 	/* Invalidate the pagebuffer reference */
 	chip->pagebuf = -1;
 
-	/* Large page NAND with SOFT_ECC should support subpage reads */
+	/*
+	 * Large page NAND with SOFT_ECC should support subpage reads, and cache
+	 * reads if the generic command function is in use
+	 */
 	switch (ecc->mode) {
 	case NAND_ECC_SOFT:
 	case NAND_ECC_SOFT_BCH:
 		if (chip->page_shift > 9)
 			chip->options |= NAND_SUBPAGE_READ;
+		if (chip->cmdfunc == nand_command_lp)
+			chip->options |= NAND_CACHE_READ;
 		break;
 
 	default:
 		break;
 	}
 
+	/* Only use cache reads if the chip says it has them */
+#ifdef CONFIG_SYS_NAND_ONFI_DETECTION
+	if (!(onfi_opt_cmd(chip) & ONFI_OPT_CMD_READ_CACHE) ||
+	    chip->page_shift <= 9)
+		chip->options &= ~NAND_CACHE_READ;
+#else
+	chip->options &= ~NAND_CACHE_READ;
+#endif
+
 	/* Fill in remaining MTD driver data */
 	mtd->type = nand_is_slc(chip) ? MTD_NANDFLASH : MTD_MLCNANDFLASH;
 	mtd->flags = (chip->options & NAND_ROM) ? MTD_CAP_ROM :
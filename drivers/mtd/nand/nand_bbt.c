@@ -26,6 +26,11 @@
  * If no BBT exists at all then the device is scanned for factory marked
  * good / bad blocks and the bad block tables are created.
  *
+ * With CONFIG_SYS_NAND_BBT_ON_DEMAND and no flash based BBT, the device is not
+ * scanned up front. Instead each block's markers are checked the first time
+ * that block is looked up, so that reading a small part of a large device
+ * only reads the markers of the blocks involved.
+ *
  * For manufacturer created BBTs like the one found on M-SYS DOC devices
  * the BBT is searched and read but never created
  *
@@ -90,6 +95,16 @@ static inline void bbt_mark_entry(struct nand_chip *chip, int block,
 	chip->bbt[block >> BBT_ENTRY_SHIFT] |= msk;
 }
 
+static inline int bbt_is_scanned(struct nand_chip *chip, int block)
+{
+	return chip->bbt_scanned[block >> 3] & (1 << (block & 7));
+}
+
+static inline void bbt_set_scanned(struct nand_chip *chip, int block)
+{
+	chip->bbt_scanned[block >> 3] |= 1 << (block & 7);
+}
+
 static int check_pattern_no_oob(uint8_t *buf, struct nand_bbt_descr *td)
 {
 	if (memcmp(buf, td->pattern, td->len))
@@ -438,6 +453,48 @@ static int scan_block_fast(struct mtd_info *mtd, struct nand_bbt_descr *bd,
 	return 0;
 }
 
+/**
+ * scan_block - [GENERIC] Check the bad block markers of one block
+ * @mtd: MTD device structure
+ * @buf: temporary buffer
+ * @bd: descriptor for the good/bad block search pattern
+ * @block: block number to check
+ *
+ * Check the given block for the good/bad block pattern and mark it in the
+ * memory based bad block table if it is bad.
+ */
+static int scan_block(struct mtd_info *mtd, uint8_t *buf,
+		      struct nand_bbt_descr *bd, int block)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+	loff_t from = (loff_t)block << this->bbt_erase_shift;
+	int numpages;
+	int ret;
+
+	BUG_ON(bd->options & NAND_BBT_NO_OOB);
+
+	if (bd->options & NAND_BBT_SCAN2NDPAGE)
+		numpages = 2;
+	else
+		numpages = 1;
+
+	if (this->bbt_options & NAND_BBT_SCANLASTPAGE)
+		from += mtd->erasesize - (mtd->writesize * numpages);
+
+	ret = scan_block_fast(mtd, bd, from, buf, numpages);
+	if (ret < 0)
+		return ret;
+
+	if (ret) {
+		bbt_mark_entry(this, block, BBT_BLOCK_FACTORY_BAD);
+		pr_warn("Bad eraseblock %d at 0x%012llx\n",
+			block, (unsigned long long)from);
+		mtd->ecc_stats.badblocks++;
+	}
+
+	return 0;
+}
+
 /**
  * create_bbt - [GENERIC] Create a bad block table by scanning the device
  * @mtd: MTD device structure
@@ -453,21 +510,14 @@ static int create_bbt(struct mtd_info *mtd, uint8_t *buf,
 	struct nand_bbt_descr *bd, int chip)
 {
 	struct nand_chip *this = mtd_to_nand(mtd);
-	int i, numblocks, numpages;
+	int i, numblocks;
 	int startblock;
-	loff_t from;
 
 	pr_info("Scanning device for bad blocks\n");
 
-	if (bd->options & NAND_BBT_SCAN2NDPAGE)
-		numpages = 2;
-	else
-		numpages = 1;
-
 	if (chip == -1) {
 		numblocks = mtd->size >> this->bbt_erase_shift;
 		startblock = 0;
-		from = 0;
 	} else {
 		if (chip >= this->numchips) {
 			pr_warn("create_bbt(): chipnr (%d) > available chips (%d)\n",
@@ -477,29 +527,14 @@ static int create_bbt(struct mtd_info *mtd, uint8_t *buf,
 		numblocks = this->chipsize >> this->bbt_erase_shift;
 		startblock = chip * numblocks;
 		numblocks += startblock;
-		from = (loff_t)startblock << this->bbt_erase_shift;
 	}
 
-	if (this->bbt_options & NAND_BBT_SCANLASTPAGE)
-		from += mtd->erasesize - (mtd->writesize * numpages);
-
 	for (i = startblock; i < numblocks; i++) {
 		int ret;
 
-		BUG_ON(bd->options & NAND_BBT_NO_OOB);
-
-		ret = scan_block_fast(mtd, bd, from, buf, numpages);
+		ret = scan_block(mtd, buf, bd, i);
 		if (ret < 0)
 			return ret;
-
-		if (ret) {
-			bbt_mark_entry(this, i, BBT_BLOCK_FACTORY_BAD);
-			pr_warn("Bad eraseblock %d at 0x%012llx\n",
-				i, (unsigned long long)from);
-			mtd->ecc_stats.badblocks++;
-		}
-
-		from += (1 << this->bbt_erase_shift);
 	}
 	return 0;
 }
@@ -1077,15 +1112,24 @@ static int nand_scan_bbt(struct mtd_info *mtd, struct nand_bbt_descr *bd)
 	uint8_t *buf;
 	struct nand_bbt_descr *td = this->bbt_td;
 	struct nand_bbt_descr *md = this->bbt_md;
+	int scanned_len = 0;
 
 	len = (mtd->size >> (this->bbt_erase_shift + 2)) ? : 1;
+#ifdef CONFIG_SYS_NAND_BBT_ON_DEMAND
+	/* Blocks are scanned when first looked up; track which ones are done */
+	if (!td)
+		scanned_len = (mtd->size >> (this->bbt_erase_shift + 3)) ? : 1;
+#endif
 	/*
 	 * Allocate memory (2bit per block) and clear the memory bad block
 	 * table.
 	 */
-	this->bbt = kzalloc(len, GFP_KERNEL);
+	this->bbt = kzalloc(len + scanned_len, GFP_KERNEL);
 	if (!this->bbt)
 		return -ENOMEM;
+	this->bbt_scanned = scanned_len ? this->bbt + len : NULL;
+	if (this->bbt_scanned)
+		return 0;
 
 	/*
 	 * If no primary table decriptor is given, scan the device to build a
@@ -1334,6 +1378,16 @@ int nand_isbad_bbt(struct mtd_info *mtd, loff_t offs, int allowbbt)
 	int block, res;
 
 	block = (int)(offs >> this->bbt_erase_shift);
+	if (this->bbt_scanned && !bbt_is_scanned(this, block)) {
+		res = scan_block(mtd, this->buffers->databuf,
+				 this->badblock_pattern, block);
+		/* The scan used the page buffer and may have deselected */
+		this->pagebuf = -1;
+		this->select_chip(mtd, (int)(offs >> this->chip_shift));
+		if (res)
+			return res;
+		bbt_set_scanned(this, block);
+	}
 	res = bbt_get_entry(this, block);
 
 	pr_debug("nand_isbad_bbt(): bbt info for offs 0x%08x: (block %d) 0x%02x\n",
@@ -1364,6 +1418,8 @@ int nand_markbad_bbt(struct mtd_info *mtd, loff_t offs)
 
 	/* Mark bad block in memory */
 	bbt_mark_entry(this, block, BBT_BLOCK_WORN);
+	if (this->bbt_scanned)
+		bbt_set_scanned(this, block);
 
 	/* Update flash-based bad block table */
 	if (this->bbt_options & NAND_BBT_USE_FLASH)
@@ -93,6 +93,7 @@ int nand_erase_opts(struct mtd_info *mtd,
 			kfree(chip->bbt);
 		}
 		chip->bbt = NULL;
+		chip->bbt_scanned = NULL;
 		chip->options &= ~NAND_BBT_SCANNED;
 	}
 
@@ -761,10 +762,13 @@ int nand_read_skip_bad(struct mtd_info *mtd, loff_t offset, size_t *length,
 			continue;
 		}
 
-		if (left_to_read < (mtd->erasesize - block_offset))
+		/* Read up to the next bad block in one go */
+		read_length = mtd->erasesize - block_offset;
+		while (read_length < left_to_read &&
+		       !nand_block_isbad(mtd, offset + read_length))
+			read_length += mtd->erasesize;
+		if (read_length > left_to_read)
 			read_length = left_to_read;
-		else
-			read_length = mtd->erasesize - block_offset;
 
 		rval = nand_read(mtd, offset, &read_length, p_buffer);
 		if (rval && rval != -EUCLEAN) {
@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Model of an ONFI NAND flash chip for sandbox
+ *
+ * The chip sits behind a trivial controller which passes command, address
+ * and data cycles straight through, so all of the generic NAND code is used.
+ * The array is held in memory and starts off erased.
+ *
+ * Nothing takes real time on sandbox, so the model keeps a virtual clock
+ * instead. Each bus cycle advances it and array operations keep the chip
+ * busy for tR, tPROG or tBERS; waiting for ready moves the clock on to the
+ * end of the busy period. READ CACHE SEQUENTIAL is supported, so the effect
+ * of overlapping tR with data output can be measured.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <nand.h>
+#include <os.h>
+#include <linux/mtd/nand.h>
+#include <asm/test.h>
+
+/* Geometry: 2KiB pages, 128KiB blocks, 16MiB */
+#define SB_NAND_PAGE_SIZE	2048
+#define SB_NAND_OOB_SIZE	64
+#define SB_NAND_RAW_SIZE	(SB_NAND_PAGE_SIZE + SB_NAND_OOB_SIZE)
+#define SB_NAND_PAGES_PER_BLOCK	64
+#define SB_NAND_BLOCKS		128
+#define SB_NAND_PAGES		(SB_NAND_PAGES_PER_BLOCK * SB_NAND_BLOCKS)
+
+#define SB_NAND_MFR_ID		0x5b
+#define SB_NAND_DEV_ID		0x01
+
+/* Timings in ns, roughly those of an SLC chip in ONFI timing mode 4 */
+#define SB_NAND_T_CYCLE		25
+#define SB_NAND_T_R		25000
+#define SB_NAND_T_RCBSY		3000
+#define SB_NAND_T_PROG		250000
+#define SB_NAND_T_BERS		2000000
+#define SB_NAND_T_RST		5000
+
+/* What the chip outputs when the host reads data */
+enum sb_nand_output {
+	SB_NAND_OUT_NONE,
+	SB_NAND_OUT_ID,
+	SB_NAND_OUT_PARAM,
+	SB_NAND_OUT_STATUS,
+	SB_NAND_OUT_CACHE,
+};
+
+/**
+ * struct sandbox_nand - State of the sandbox NAND chip
+ *
+ * @chip:	NAND chip for the generic NAND code
+ * @array:	Flash array, SB_NAND_RAW_SIZE bytes for each page
+ * @data_reg:	Data (page) register, loaded from the array
+ * @cache_reg:	Cache register, used for data input and output
+ * @cmd:	Last command byte received
+ * @addr:	Address cycles received since @cmd
+ * @addr_cycles: Number of address cycles received
+ * @col:	Column for the next data input or output
+ * @row:	Page address of @data_reg
+ * @output:	What data output reads from
+ * @out_pos:	Position in the ID or parameter page output
+ * @fail:	true if the last program or erase failed
+ * @cache_seq:	true while a cache read is in progress
+ * @now:	Current virtual time
+ * @ready_at:	Time at which the chip becomes ready (RDY)
+ * @array_ready_at: Time at which the array becomes idle (ARDY)
+ * @start:	Virtual time when the statistics were cleared
+ * @stats:	Activity counters
+ * @params:	ONFI parameter page
+ */
+struct sandbox_nand {
+	struct nand_chip chip;
+	uint8_t *array;
+	uint8_t data_reg[SB_NAND_RAW_SIZE];
+	uint8_t cache_reg[SB_NAND_RAW_SIZE];
+	uint8_t cmd;
+	uint8_t addr[5];
+	int addr_cycles;
+	int col;
+	int row;
+	enum sb_nand_output output;
+	int out_pos;
+	bool fail;
+	bool cache_seq;
+	u64 now;
+	u64 ready_at;
+	u64 array_ready_at;
+	u64 start;
+	struct sandbox_nand_stats stats;
+	struct nand_onfi_params params;
+};
+
+static struct sandbox_nand sb_nand;
+
+/* ONFI CRC-16, as used for the parameter page */
+static u16 sb_nand_crc16(u16 crc, const u8 *p, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *p++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = (crc << 1) ^ ((crc & 0x8000) ? 0x8005 : 0);
+	}
+
+	return crc;
+}
+
+static void sb_nand_setup_params(struct nand_onfi_params *p)
+{
+	memset(p, '\0', sizeof(*p));
+	memcpy(p->sig, "ONFI", 4);
+	p->revision = cpu_to_le16(1 << 2);	/* ONFI 2.0 */
+	p->opt_cmd = cpu_to_le16(ONFI_OPT_CMD_READ_CACHE);
+	memcpy(p->manufacturer, "SANDBOX     ", sizeof(p->manufacturer));
+	memcpy(p->model, "SANDBOX NAND 16MiB  ", sizeof(p->model));
+	p->jedec_id = SB_NAND_MFR_ID;
+	p->byte_per_page = cpu_to_le32(SB_NAND_PAGE_SIZE);
+	p->spare_bytes_per_page = cpu_to_le16(SB_NAND_OOB_SIZE);
+	p->pages_per_block = cpu_to_le32(SB_NAND_PAGES_PER_BLOCK);
+	p->blocks_per_lun = cpu_to_le32(SB_NAND_BLOCKS);
+	p->lun_count = 1;
+	p->addr_cycles = 0x22;			/* 2 column, 2 row */
+	p->bits_per_cell = 1;
+	p->programs_per_page = 4;
+	p->ecc_bits = 1;
+	p->async_timing_mode = cpu_to_le16(0x1f);
+	p->t_prog = cpu_to_le16(SB_NAND_T_PROG / 1000);
+	p->t_bers = cpu_to_le16(SB_NAND_T_BERS / 1000);
+	p->t_r = cpu_to_le16(SB_NAND_T_R / 1000);
+	p->crc = cpu_to_le16(sb_nand_crc16(ONFI_CRC_BASE, (u8 *)p, 254));
+}
+
+static uint8_t *sb_nand_page(struct sandbox_nand *priv, int row)
+{
+	return priv->array + (ulong)row * SB_NAND_RAW_SIZE;
+}
+
+/* Wait for the array to finish what it is doing, returning the time */
+static u64 sb_nand_array_wait(struct sandbox_nand *priv)
+{
+	return max(priv->now, priv->array_ready_at);
+}
+
+/* Start reading the page at @row into the data register */
+static void sb_nand_array_read(struct sandbox_nand *priv, int row, u64 start)
+{
+	priv->row = row;
+	if (row < SB_NAND_PAGES)
+		memcpy(priv->data_reg, sb_nand_page(priv, row),
+		       SB_NAND_RAW_SIZE);
+	else
+		memset(priv->data_reg, 0xff, SB_NAND_RAW_SIZE);
+	priv->array_ready_at = start + SB_NAND_T_R;
+	priv->stats.page_reads++;
+}
+
+/* Copy the data register to the cache register, for cache reads */
+static void sb_nand_cache_copy(struct sandbox_nand *priv, u64 start)
+{
+	memcpy(priv->cache_reg, priv->data_reg, SB_NAND_RAW_SIZE);
+	priv->col = 0;
+	priv->ready_at = start + SB_NAND_T_RCBSY;
+	priv->output = SB_NAND_OUT_CACHE;
+}
+
+/* Decode the address cycles received for the current command */
+static void sb_nand_latch_addr(struct sandbox_nand *priv)
+{
+	const uint8_t *addr = priv->addr;
+	int cycles = priv->addr_cycles;
+
+	if (!cycles)
+		return;
+	switch (priv->cmd) {
+	case NAND_CMD_READ0:
+	case NAND_CMD_SEQIN:
+		priv->col = addr[0] | addr[1] << 8;
+		priv->row = addr[2] | addr[3] << 8;
+		if (cycles > 4)
+			priv->row |= addr[4] << 16;
+		break;
+	case NAND_CMD_RNDOUT:
+	case NAND_CMD_RNDIN:
+		priv->col = addr[0] | addr[1] << 8;
+		break;
+	case NAND_CMD_ERASE1:
+		priv->row = addr[0] | addr[1] << 8;
+		if (cycles > 2)
+			priv->row |= addr[2] << 16;
+		break;
+	case NAND_CMD_READID:
+	case NAND_CMD_PARAM:
+		priv->col = addr[0];
+		break;
+	}
+	priv->addr_cycles = 0;
+}
+
+static void sb_nand_command(struct sandbox_nand *priv, uint8_t cmd)
+{
+	u64 start;
+
+	sb_nand_latch_addr(priv);
+	switch (cmd) {
+	case NAND_CMD_RESET:
+		priv->cache_seq = false;
+		priv->fail = false;
+		priv->output = SB_NAND_OUT_NONE;
+		priv->ready_at = sb_nand_array_wait(priv) + SB_NAND_T_RST;
+		priv->array_ready_at = priv->ready_at;
+		break;
+	case NAND_CMD_READID:
+		priv->output = SB_NAND_OUT_ID;
+		priv->out_pos = 0;
+		break;
+	case NAND_CMD_PARAM:
+		priv->output = SB_NAND_OUT_PARAM;
+		priv->out_pos = 0;
+		priv->ready_at = priv->now + SB_NAND_T_R;
+		break;
+	case NAND_CMD_STATUS:
+		priv->output = SB_NAND_OUT_STATUS;
+		break;
+	case NAND_CMD_READ0:
+		/* Also used to leave status mode */
+		priv->output = SB_NAND_OUT_CACHE;
+		break;
+	case NAND_CMD_READSTART:
+		start = sb_nand_array_wait(priv);
+		priv->cache_seq = false;
+		sb_nand_array_read(priv, priv->row, start);
+		memcpy(priv->cache_reg, priv->data_reg, SB_NAND_RAW_SIZE);
+		priv->ready_at = priv->array_ready_at;
+		priv->output = SB_NAND_OUT_CACHE;
+		break;
+	case NAND_CMD_READCACHESEQ:
+		/* Output this page while the array reads the next one */
+		start = sb_nand_array_wait(priv);
+		sb_nand_cache_copy(priv, start);
+		sb_nand_array_read(priv, priv->row + 1, priv->ready_at);
+		priv->stats.cache_reads++;
+		priv->cache_seq = true;
+		break;
+	case NAND_CMD_READCACHEEND:
+		start = sb_nand_array_wait(priv);
+		sb_nand_cache_copy(priv, start);
+		priv->cache_seq = false;
+		break;
+	case NAND_CMD_RNDOUTSTART:
+		priv->output = SB_NAND_OUT_CACHE;
+		break;
+	case NAND_CMD_SEQIN:
+		memset(priv->cache_reg, 0xff, SB_NAND_RAW_SIZE);
+		priv->output = SB_NAND_OUT_NONE;
+		break;
+	case NAND_CMD_PAGEPROG:
+		start = sb_nand_array_wait(priv);
+		priv->fail = priv->row >= SB_NAND_PAGES;
+		if (!priv->fail) {
+			uint8_t *page = sb_nand_page(priv, priv->row);
+			int i;
+
+			/* Programming can only clear bits */
+			for (i = 0; i < SB_NAND_RAW_SIZE; i++)
+				page[i] &= priv->cache_reg[i];
+		}
+		priv->ready_at = start + SB_NAND_T_PROG;
+		priv->array_ready_at = priv->ready_at;
+		priv->stats.page_progs++;
+		break;
+	case NAND_CMD_ERASE2:
+		start = sb_nand_array_wait(priv);
+		priv->fail = priv->row >= SB_NAND_PAGES;
+		if (!priv->fail) {
+			memset(sb_nand_page(priv, priv->row &
+					    ~(SB_NAND_PAGES_PER_BLOCK - 1)),
+			       0xff,
+			       SB_NAND_RAW_SIZE * SB_NAND_PAGES_PER_BLOCK);
+		}
+		priv->ready_at = start + SB_NAND_T_BERS;
+		priv->array_ready_at = priv->ready_at;
+		priv->stats.block_erases++;
+		break;
+	}
+	priv->cmd = cmd;
+}
+
+static void sb_nand_cmd_ctrl(struct mtd_info *mtd, int dat, unsigned int ctrl)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+
+	if (dat == NAND_CMD_NONE)
+		return;
+	priv->now += SB_NAND_T_CYCLE;
+	if (ctrl & NAND_CLE) {
+		sb_nand_command(priv, dat);
+	} else if (ctrl & NAND_ALE) {
+		if (priv->addr_cycles < sizeof(priv->addr))
+			priv->addr[priv->addr_cycles++] = dat;
+	}
+}
+
+static uint8_t sb_nand_status(struct sandbox_nand *priv)
+{
+	uint8_t status = NAND_STATUS_WP;
+
+	if (priv->now >= priv->ready_at)
+		status |= NAND_STATUS_READY;
+	if (priv->now >= priv->array_ready_at)
+		status |= NAND_STATUS_TRUE_READY;
+	if (priv->fail)
+		status |= NAND_STATUS_FAIL;
+
+	return status;
+}
+
+static uint8_t sb_nand_read_byte(struct mtd_info *mtd)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+	static const uint8_t id[] = { SB_NAND_MFR_ID, SB_NAND_DEV_ID, 0, 0 };
+	uint8_t val = 0xff;
+
+	sb_nand_latch_addr(priv);
+	priv->now += SB_NAND_T_CYCLE;
+	switch (priv->output) {
+	case SB_NAND_OUT_ID:
+		if (priv->col == 0x20 && priv->out_pos < 4)
+			val = "ONFI"[priv->out_pos];
+		else if (priv->col != 0x20 && priv->out_pos < sizeof(id))
+			val = id[priv->out_pos];
+		else
+			val = 0;
+		priv->out_pos++;
+		break;
+	case SB_NAND_OUT_PARAM:
+		val = ((uint8_t *)&priv->params)[priv->out_pos++ %
+						 sizeof(priv->params)];
+		break;
+	case SB_NAND_OUT_STATUS:
+		val = sb_nand_status(priv);
+		break;
+	case SB_NAND_OUT_CACHE:
+		if (priv->col < SB_NAND_RAW_SIZE)
+			val = priv->cache_reg[priv->col++];
+		break;
+	case SB_NAND_OUT_NONE:
+		break;
+	}
+
+	return val;
+}
+
+static void sb_nand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+	int count;
+
+	sb_nand_latch_addr(priv);
+	if (priv->output != SB_NAND_OUT_CACHE) {
+		while (len--)
+			*buf++ = sb_nand_read_byte(mtd);
+		return;
+	}
+	priv->now += (u64)len * SB_NAND_T_CYCLE;
+	count = min(len, SB_NAND_RAW_SIZE - priv->col);
+	memcpy(buf, priv->cache_reg + priv->col, count);
+	memset(buf + count, 0xff, len - count);
+	priv->col += count;
+}
+
+static void sb_nand_write_buf(struct mtd_info *mtd, const uint8_t *buf,
+			      int len)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+	int count;
+
+	sb_nand_latch_addr(priv);
+	priv->now += (u64)len * SB_NAND_T_CYCLE;
+	count = min(len, SB_NAND_RAW_SIZE - priv->col);
+	memcpy(priv->cache_reg + priv->col, buf, count);
+	priv->col += count;
+}
+
+static int sb_nand_dev_ready(struct mtd_info *mtd)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+
+	/* Waiting takes no real time, just move the clock on */
+	priv->now = max(priv->now, priv->ready_at);
+
+	return 1;
+}
+
+static void sb_nand_select_chip(struct mtd_info *mtd, int chipnr)
+{
+}
+
+void sandbox_nand_get_stats(struct sandbox_nand_stats *stats)
+{
+	*stats = sb_nand.stats;
+	stats->time_ns = sb_nand.now - sb_nand.start;
+}
+
+void sandbox_nand_clear_stats(void)
+{
+	memset(&sb_nand.stats, '\0', sizeof(sb_nand.stats));
+	sb_nand.start = sb_nand.now;
+}
+
+void sandbox_nand_flip_bit(loff_t offset, int bit)
+{
+	int row = offset / SB_NAND_PAGE_SIZE;
+
+	sb_nand_page(&sb_nand, row)[offset % SB_NAND_PAGE_SIZE] ^= 1 << bit;
+}
+
+void sandbox_nand_mark_bad(int block)
+{
+	uint8_t *page = sb_nand_page(&sb_nand, block * SB_NAND_PAGES_PER_BLOCK);
+
+	/* Factory bad block marker: first OOB byte of the first page */
+	page[SB_NAND_PAGE_SIZE] = 0;
+}
+
+void board_nand_init(void)
+{
+	struct sandbox_nand *priv = &sb_nand;
+	struct nand_chip *chip = &priv->chip;
+	struct mtd_info *mtd = nand_to_mtd(chip);
+	int ret;
+
+	priv->array = os_malloc(SB_NAND_RAW_SIZE * SB_NAND_PAGES);
+	if (!priv->array) {
+		printf("%s: Cannot allocate NAND array\n", __func__);
+		return;
+	}
+	memset(priv->array, 0xff, SB_NAND_RAW_SIZE * SB_NAND_PAGES);
+	sb_nand_setup_params(&priv->params);
+
+	nand_set_controller_data(chip, priv);
+	chip->cmd_ctrl = sb_nand_cmd_ctrl;
+	chip->read_byte = sb_nand_read_byte;
+	chip->read_buf = sb_nand_read_buf;
+	chip->write_buf = sb_nand_write_buf;
+	chip->dev_ready = sb_nand_dev_ready;
+	chip->select_chip = sb_nand_select_chip;
+	chip->ecc.mode = NAND_ECC_SOFT;
+
+	ret = nand_scan(mtd, 1);
+	if (!ret)
+		ret = nand_register(0, mtd);
+	if (ret)
+		printf("%s: Cannot init NAND (err %d)\n", __func__, ret);
+}
@@ -1718,6 +1718,12 @@ static int sunxi_nand_chip_init(int node, struct sunxi_nfc *nfc, int devnum)
 
 	nand->options |= NAND_SUBPAGE_READ;
 
+	/*
+	 * The ECC read functions only use RNDOUT to move around the page, so
+	 * they also work on the cache register during a cache read
+	 */
+	nand->options |= NAND_CACHE_READ;
+
 	ret = sunxi_nand_chip_init_timings(chip);
 	if (ret) {
 		dev_err(dev, "could not configure chip timings: %d\n", ret);
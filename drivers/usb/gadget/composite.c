@@ -10,6 +10,7 @@
 
 #include <linux/bitops.h>
 #include <linux/usb/composite.h>
+#include <asm/unaligned.h>
 
 #define USB_BUFSIZ	4096
 
@@ -481,20 +482,21 @@ done:
  * the host side.
  */
 
-static void collect_langs(struct usb_gadget_strings **sp, __le16 *buf)
+static void collect_langs(struct usb_gadget_strings **sp, void *buf)
 {
 	const struct usb_gadget_strings	*s;
 	u16				language;
-	__le16				*tmp;
+	u8				*tmp, *end = buf + 126 * 2;
 
+	/* buf is the wData[] of a packed usb_string_descriptor */
 	while (*sp) {
 		s = *sp;
-		language = cpu_to_le16(s->language);
-		for (tmp = buf; *tmp && tmp < &buf[126]; tmp++) {
-			if (*tmp == language)
+		language = s->language;
+		for (tmp = buf; get_unaligned_le16(tmp) && tmp < end; tmp += 2) {
+			if (get_unaligned_le16(tmp) == language)
 				goto repeat;
 		}
-		*tmp++ = language;
+		put_unaligned_le16(language, tmp);
 repeat:
 		sp++;
 	}
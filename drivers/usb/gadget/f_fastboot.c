@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <fastboot.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
 #include <linux/usb/composite.h>
@@ -45,12 +46,28 @@
  * that expect bulk OUT requests to be divisible by maxpacket size.
  */
 
+/*
+ * FIXME: Ensure we always set these via Kconfig once all boards enable
+ * fastboot there
+ */
+#ifndef CONFIG_FASTBOOT_USB_REQS
+#define CONFIG_FASTBOOT_USB_REQS	4
+#endif
+
+#ifndef CONFIG_FASTBOOT_USB_REQ_SIZE
+#define CONFIG_FASTBOOT_USB_REQ_SIZE	0x10000
+#endif
+
 struct f_fastboot {
 	struct usb_function usb_function;
 
 	/* IN/OUT EP's and corresponding requests */
 	struct usb_ep *in_ep, *out_ep;
 	struct usb_request *in_req, *out_req;
+
+	/* Requests which receive downloads straight into the buffer */
+	struct usb_request *dl_req[CONFIG_FASTBOOT_USB_REQS];
+	bool dl_busy[CONFIG_FASTBOOT_USB_REQS];
 };
 
 static inline struct f_fastboot *func_to_fastboot(struct usb_function *f)
@@ -61,6 +78,7 @@ static inline struct f_fastboot *func_to_fastboot(struct usb_function *f)
 static struct f_fastboot *fastboot_func;
 static unsigned int download_size;
 static unsigned int download_bytes;
+static unsigned int download_queued;
 
 static struct usb_endpoint_descriptor fs_ep_in = {
 	.bLength            = USB_DT_ENDPOINT_SIZE,
@@ -148,6 +166,7 @@ static struct usb_gadget_strings *fastboot_strings[] = {
 };
 
 static void rx_handler_command(struct usb_ep *ep, struct usb_request *req);
+static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req);
 static int strcmp_l1(const char *s1, const char *s2);
 
 
@@ -227,10 +246,20 @@ static void fastboot_unbind(struct usb_configuration *c, struct usb_function *f)
 static void fastboot_disable(struct usb_function *f)
 {
 	struct f_fastboot *f_fb = func_to_fastboot(f);
+	int i;
 
 	usb_ep_disable(f_fb->out_ep);
 	usb_ep_disable(f_fb->in_ep);
 
+	/* These point into the download buffer, so there is nothing to free */
+	for (i = 0; i < CONFIG_FASTBOOT_USB_REQS; i++) {
+		if (f_fb->dl_req[i]) {
+			usb_ep_free_request(f_fb->out_ep, f_fb->dl_req[i]);
+			f_fb->dl_req[i] = NULL;
+		}
+		f_fb->dl_busy[i] = false;
+	}
+
 	if (f_fb->out_req) {
 		free(f_fb->out_req->buf);
 		usb_ep_free_request(f_fb->out_ep, f_fb->out_req);
@@ -270,6 +299,8 @@ static int fastboot_set_alt(struct usb_function *f,
 	struct usb_gadget *gadget = cdev->gadget;
 	struct f_fastboot *f_fb = func_to_fastboot(f);
 	const struct usb_endpoint_descriptor *d;
+	struct usb_request *req;
+	int i;
 
 	debug("%s: func: %s intf: %d alt: %d\n",
 	      __func__, f->name, interface, alt);
@@ -289,6 +320,17 @@ static int fastboot_set_alt(struct usb_function *f,
 	}
 	f_fb->out_req->complete = rx_handler_command;
 
+	for (i = 0; i < CONFIG_FASTBOOT_USB_REQS; i++) {
+		req = usb_ep_alloc_request(f_fb->out_ep, 0);
+		if (!req) {
+			puts("failed to alloc download req\n");
+			ret = -EINVAL;
+			goto err;
+		}
+		req->complete = rx_handler_dl_image;
+		f_fb->dl_req[i] = req;
+	}
+
 	d = fb_ep_desc(gadget, &fs_ep_in, &hs_ep_in);
 	ret = usb_ep_enable(f_fb->in_ep, d);
 	if (ret) {
@@ -446,6 +488,11 @@ static void cb_getvar(struct usb_ep *ep, struct usb_request *req)
 	fastboot_tx_write_str(response);
 }
 
+static void *fastboot_buf(void)
+{
+	return map_sysmem(CONFIG_FASTBOOT_BUF_ADDR, CONFIG_FASTBOOT_BUF_SIZE);
+}
+
 static unsigned int rx_bytes_expected(struct usb_ep *ep)
 {
 	int rx_remain = download_size - download_bytes;
@@ -470,6 +517,90 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 	return rx_remain;
 }
 
+/* Find which download request this is, or -1 for the command request */
+static int fastboot_dl_index(struct usb_request *req)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_FASTBOOT_USB_REQS; i++) {
+		if (fastboot_func->dl_req[i] == req)
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Queue requests to receive the next parts of the download straight into
+ * the buffer, so that the host can keep sending while each one is dealt
+ * with. A part which is not aligned for DMA, or which would run past the
+ * end of the buffer once rounded up to whole packets, is instead received
+ * a packet buffer at a time with the command request and copied. That
+ * waits until the other requests have finished, to keep the data in order.
+ */
+static void fastboot_dl_queue(struct usb_ep *ep)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	unsigned int maxpacket = ep->maxpacket;
+	unsigned int remain, len;
+	struct usb_request *req;
+	bool busy = false;
+	ulong dest;
+	int i;
+
+	for (i = 0; i < CONFIG_FASTBOOT_USB_REQS; i++)
+		busy |= f_fb->dl_busy[i];
+	for (i = 0; i < CONFIG_FASTBOOT_USB_REQS &&
+	     download_queued < download_size; i++) {
+		if (f_fb->dl_busy[i])
+			continue;
+		remain = download_size - download_queued;
+		len = roundup(min_t(unsigned int, remain,
+				    CONFIG_FASTBOOT_USB_REQ_SIZE), maxpacket);
+		dest = (ulong)fastboot_buf() + download_queued;
+		if (!IS_ALIGNED(dest, ARCH_DMA_MINALIGN) ||
+		    download_queued + len > CONFIG_FASTBOOT_BUF_SIZE)
+			break;
+
+		req = f_fb->dl_req[i];
+		req->buf = (void *)dest;
+		req->length = len;
+		req->actual = 0;
+		if (usb_ep_queue(ep, req, 0))
+			break;
+		f_fb->dl_busy[i] = true;
+		busy = true;
+		download_queued += min(remain, len);
+	}
+
+	if (!busy && download_bytes < download_size) {
+		req = f_fb->out_req;
+		req->complete = rx_handler_dl_image;
+		req->length = rx_bytes_expected(ep);
+		req->actual = 0;
+		usb_ep_queue(ep, req, 0);
+	}
+}
+
+/*
+ * The host sent less than a full request before the end of the download,
+ * so the data for the other requests will not go where they expect. Cancel
+ * them and carry on from where the data got to.
+ */
+static void fastboot_dl_cancel(struct usb_ep *ep)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	int i;
+
+	for (i = 0; i < CONFIG_FASTBOOT_USB_REQS; i++) {
+		if (f_fb->dl_busy[i]) {
+			usb_ep_dequeue(ep, f_fb->dl_req[i]);
+			f_fb->dl_busy[i] = false;
+		}
+	}
+	download_queued = download_bytes;
+}
+
 #define BYTES_PER_DOT	0x20000
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
@@ -478,17 +609,23 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	const unsigned char *buffer = req->buf;
 	unsigned int buffer_size = req->actual;
 	unsigned int pre_dot_num, now_dot_num;
+	int index = fastboot_dl_index(req);
 
+	if (index >= 0)
+		fastboot_func->dl_busy[index] = false;
 	if (req->status != 0) {
-		printf("Bad status: %d\n", req->status);
+		/* Requests cancelled by fastboot_dl_cancel() end up here */
+		if (req->status != -ECONNRESET)
+			printf("Bad status: %d\n", req->status);
 		return;
 	}
 
 	if (buffer_size < transfer_size)
 		transfer_size = buffer_size;
 
-	memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
-	       buffer, transfer_size);
+	/* Download requests put the data in the right place already */
+	if (index < 0)
+		memcpy(fastboot_buf() + download_bytes, buffer, transfer_size);
 
 	pre_dot_num = download_bytes / BYTES_PER_DOT;
 	download_bytes += transfer_size;
@@ -507,6 +644,7 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 		 * it will be used in the next possible flashing command
 		 */
 		download_size = 0;
+		req = fastboot_func->out_req;
 		req->complete = rx_handler_command;
 		req->length = EP_BUFFER_SIZE;
 
@@ -514,6 +652,11 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 		fastboot_tx_write_str(response);
 
 		printf("\ndownloading of %d bytes finished\n", download_bytes);
+	} else if (index >= 0) {
+		if (req->actual < req->length)
+			fastboot_dl_cancel(ep);
+		fastboot_dl_queue(ep);
+		return;
 	} else {
 		req->length = rx_bytes_expected(ep);
 	}
@@ -530,6 +673,7 @@ static void cb_download(struct usb_ep *ep, struct usb_request *req)
 	strsep(&cmd, ":");
 	download_size = simple_strtoul(cmd, NULL, 16);
 	download_bytes = 0;
+	download_queued = 0;
 
 	printf("Starting download of %d bytes\n", download_size);
 
@@ -539,9 +683,8 @@ static void cb_download(struct usb_ep *ep, struct usb_request *req)
 		download_size = 0;
 		strcpy(response, "FAILdata too large");
 	} else {
+		/* rx_handler_command() queues the requests for the data */
 		sprintf(response, "DATA%08x", download_size);
-		req->complete = rx_handler_dl_image;
-		req->length = rx_bytes_expected(ep);
 	}
 	fastboot_tx_write_str(response);
 }
@@ -582,6 +725,8 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 {
 	char *cmd = req->buf;
 	char response[FASTBOOT_RESPONSE_LEN];
+	char *part, *end;
+	u64 offset = 0;
 
 	strsep(&cmd, ":");
 	if (!cmd) {
@@ -590,18 +735,28 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 		return;
 	}
 
+	/* An image too large for the buffer is flashed in parts at offsets */
+	part = strsep(&cmd, ":");
+	if (cmd) {
+		offset = simple_strtoull(cmd, &end, 16);
+		if (!*cmd || *end) {
+			fastboot_tx_write_str("FAILinvalid offset");
+			return;
+		}
+	}
+
 	/* initialize the response buffer */
 	fb_response_str = response;
 
 	fastboot_fail("no flash device defined");
 #ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
-	fb_mmc_flash_write(cmd, (void *)CONFIG_FASTBOOT_BUF_ADDR,
-			   download_bytes);
+	fb_mmc_flash_write(part, offset, fastboot_buf(), download_bytes);
 #endif
 #ifdef CONFIG_FASTBOOT_FLASH_NAND_DEV
-	fb_nand_flash_write(cmd,
-			    (void *)CONFIG_FASTBOOT_BUF_ADDR,
-			    download_bytes);
+	if (offset)
+		fastboot_fail("offset not supported on NAND");
+	else
+		fb_nand_flash_write(part, fastboot_buf(), download_bytes);
 #endif
 	fastboot_tx_write_str(response);
 }
@@ -725,5 +880,10 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 
 	*cmdbuf = '\0';
 	req->actual = 0;
-	usb_ep_queue(ep, req, 0);
+
+	/* The download data goes straight into the buffer if it can */
+	if (download_size)
+		fastboot_dl_queue(ep);
+	else
+		usb_ep_queue(ep, req, 0);
 }
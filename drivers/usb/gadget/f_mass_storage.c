@@ -319,6 +319,20 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	buffhds[FSG_NUM_BUFFERS];
 
+	/* Read-ahead and write-back buffers, sizes in sectors */
+	u8			*ra_buf;
+	u32			ra_size;
+	unsigned int		ra_lun;
+	u32			ra_start;
+	u32			ra_count;
+	u32			next_lba;	/* Sector after the last read */
+	u8			*wb_buf;
+	u32			wb_size;
+	unsigned int		wb_lun;
+	u32			wb_start;
+	u32			wb_count;
+	ulong			wb_time;	/* When last written to */
+
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
 
@@ -663,6 +677,217 @@ static void busy_indicator(void)
 		state = 0;
 }
 
+/*-------------------------------------------------------------------------*/
+
+/*
+ * Read-ahead and write-back
+ *
+ * Each call to read_sector() or write_sector() costs a command on the
+ * medium, which for eMMC can take longer than moving a buffer over USB. So
+ * a read which carries on from the last one, or which has more to come,
+ * fills a larger read-ahead buffer, and consecutive writes are gathered in
+ * a write-back buffer and written out together. Both are shared by the LUNs.
+ *
+ * Buffered writes go to the medium when the buffer is full, when the host
+ * writes elsewhere or reads what is buffered, for SYNCHRONIZE CACHE, a write
+ * with FUA, START STOP UNIT or PREVENT ALLOW MEDIUM REMOVAL, once the host
+ * has been idle for FSG_WB_IDLE_MS, and when the function is unbound. If that
+ * fails the next WRITE or SYNCHRONIZE CACHE for the LUN reports the error.
+ */
+
+#ifndef CONFIG_UMS_READ_AHEAD_SIZE
+#define CONFIG_UMS_READ_AHEAD_SIZE	0
+#endif
+#ifndef CONFIG_UMS_WRITE_BACK_SIZE
+#define CONFIG_UMS_WRITE_BACK_SIZE	0
+#endif
+
+#define FSG_WB_IDLE_MS		1000
+
+/* Value of next_lba before the first read, which nothing follows on from */
+#define FSG_NO_LBA		(~0U)
+
+static void fsg_cache_init(struct fsg_common *common)
+{
+	/* Buffers smaller than a transfer would not help */
+	if (CONFIG_UMS_READ_AHEAD_SIZE >= FSG_BUFLEN)
+		common->ra_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+					  CONFIG_UMS_READ_AHEAD_SIZE);
+	if (common->ra_buf)
+		common->ra_size = CONFIG_UMS_READ_AHEAD_SIZE / SECTOR_SIZE;
+	if (CONFIG_UMS_WRITE_BACK_SIZE >= FSG_BUFLEN)
+		common->wb_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+					  CONFIG_UMS_WRITE_BACK_SIZE);
+	if (common->wb_buf)
+		common->wb_size = CONFIG_UMS_WRITE_BACK_SIZE / SECTOR_SIZE;
+	common->next_lba = FSG_NO_LBA;
+}
+
+static bool fsg_overlaps(u32 start, u32 count, u32 other, u32 other_count)
+{
+	return start < other + other_count && other < start + count;
+}
+
+/* Write out the write-back buffer */
+static int fsg_flush(struct fsg_common *common)
+{
+	struct ums *ums_dev = &ums[common->wb_lun];
+	int rc;
+
+	if (!common->wb_count)
+		return 0;
+	rc = ums_dev->write_sector(ums_dev, common->wb_start,
+				   common->wb_count, common->wb_buf);
+	ums_dev->stats.dev_writes++;
+	if (rc != common->wb_count) {
+		printf("write-back of %u sectors at %u failed\n",
+		       common->wb_count, common->wb_start);
+		common->luns[common->wb_lun].wb_error = 1;
+		rc = -EIO;
+	} else {
+		rc = 0;
+	}
+	common->wb_count = 0;
+
+	return rc;
+}
+
+static void fsg_cache_release(struct fsg_common *common)
+{
+	fsg_flush(common);
+	free(common->ra_buf);
+	free(common->wb_buf);
+	common->ra_buf = NULL;
+	common->wb_buf = NULL;
+	common->ra_size = 0;
+	common->ra_count = 0;
+	common->wb_size = 0;
+}
+
+/* Report a failed write-back to the host, once */
+static int fsg_check_wb_error(struct fsg_lun *curlun)
+{
+	if (!curlun->wb_error)
+		return 0;
+	curlun->wb_error = 0;
+	curlun->sense_data = SS_WRITE_ERROR;
+
+	return -EIO;
+}
+
+/* Check whether the host is reading anything it has written to the buffer */
+static bool fsg_wb_overlaps(struct fsg_common *common, u32 lba, u32 count)
+{
+	return common->wb_count && common->wb_lun == common->lun &&
+		fsg_overlaps(lba, count, common->wb_start, common->wb_count);
+}
+
+static bool fsg_ra_hit(struct fsg_common *common, u32 lba, u32 count)
+{
+	return common->ra_count && common->ra_lun == common->lun &&
+		lba >= common->ra_start &&
+		lba + count <= common->ra_start + common->ra_count;
+}
+
+/*
+ * Read @count sectors at @lba for the host, where @left sectors including
+ * these are still to come for this command. Returns the number read.
+ */
+static int fsg_read_sectors(struct fsg_common *common, u32 lba, u32 count,
+			    u32 left, void *buf)
+{
+	struct fsg_lun *curlun = &common->luns[common->lun];
+	struct ums *ums_dev = &ums[common->lun];
+	u32 avail, n;
+	int rc;
+
+	if (!fsg_ra_hit(common, lba, count)) {
+		avail = lba < curlun->num_sectors ?
+			curlun->num_sectors - lba : 0;
+		n = lba == common->next_lba ? common->ra_size : left;
+		n = min3(n, common->ra_size, avail);
+		if (n > count) {
+			if (fsg_wb_overlaps(common, lba, n) &&
+			    fsg_flush(common))
+				return 0;
+			common->ra_count = 0;
+			rc = ums_dev->read_sector(ums_dev, lba, n,
+						  common->ra_buf);
+			ums_dev->stats.dev_reads++;
+			if (rc == n) {
+				common->ra_lun = common->lun;
+				common->ra_start = lba;
+				common->ra_count = n;
+			}
+		}
+	}
+	common->next_lba = lba + count;
+
+	if (fsg_ra_hit(common, lba, count)) {
+		memcpy(buf, common->ra_buf +
+		       (lba - common->ra_start) * SECTOR_SIZE,
+		       count * SECTOR_SIZE);
+		ums_dev->stats.ra_bytes += count * SECTOR_SIZE;
+		rc = count;
+	} else {
+		if (fsg_wb_overlaps(common, lba, count) && fsg_flush(common))
+			return 0;
+		rc = ums_dev->read_sector(ums_dev, lba, count, buf);
+		ums_dev->stats.dev_reads++;
+	}
+	if (rc > 0)
+		ums_dev->stats.read_bytes += rc * SECTOR_SIZE;
+
+	return rc;
+}
+
+/*
+ * Write @count sectors at @lba for the host, straight to the medium if @fua
+ * is set. Returns the number written or buffered.
+ */
+static int fsg_write_sectors(struct fsg_common *common, u32 lba, u32 count,
+			     const void *buf, bool fua)
+{
+	struct ums *ums_dev = &ums[common->lun];
+	int rc;
+
+	/* Drop anything read ahead which this replaces */
+	if (common->ra_lun == common->lun &&
+	    fsg_overlaps(lba, count, common->ra_start, common->ra_count))
+		common->ra_count = 0;
+
+	/* Only what carries on from the buffered data can join it */
+	if (common->wb_count &&
+	    (common->wb_lun != common->lun ||
+	     lba != common->wb_start + common->wb_count ||
+	     common->wb_count + count > common->wb_size))
+		fsg_flush(common);
+
+	if (fua || count > common->wb_size) {
+		rc = ums_dev->write_sector(ums_dev, lba, count, buf);
+		ums_dev->stats.dev_writes++;
+		if (rc > 0)
+			ums_dev->stats.write_bytes += rc * SECTOR_SIZE;
+		return rc;
+	}
+
+	if (!common->wb_count) {
+		common->wb_lun = common->lun;
+		common->wb_start = lba;
+	}
+	memcpy(common->wb_buf + common->wb_count * SECTOR_SIZE, buf,
+	       count * SECTOR_SIZE);
+	common->wb_count += count;
+	common->wb_time = get_timer(0);
+	ums_dev->stats.write_bytes += count * SECTOR_SIZE;
+	if (common->wb_count == common->wb_size)
+		fsg_flush(common);
+
+	return count;
+}
+
+/*-------------------------------------------------------------------------*/
+
 static int sleep_thread(struct fsg_common *common)
 {
 	int	rc = 0;
@@ -677,6 +902,11 @@ static int sleep_thread(struct fsg_common *common)
 			busy_indicator();
 			i = 0;
 			k++;
+
+			/* Write out buffered data once the host goes quiet */
+			if (common->wb_count &&
+			    get_timer(common->wb_time) > FSG_WB_IDLE_MS)
+				fsg_flush(common);
 		}
 
 		if (k == 10) {
@@ -773,13 +1003,10 @@ static int do_read(struct fsg_common *common)
 		}
 
 		/* Perform the read */
-		rc = ums[common->lun].read_sector(&ums[common->lun],
-				      file_offset / SECTOR_SIZE,
+		rc = fsg_read_sectors(common, file_offset / SECTOR_SIZE,
 				      amount / SECTOR_SIZE,
+				      amount_left / SECTOR_SIZE,
 				      (char __user *)bh->buf);
-		if (!rc)
-			return -EIO;
-
 		nread = rc * SECTOR_SIZE;
 
 		VLDBG(curlun, "file read %u @ %llu -> %d\n", amount,
@@ -837,12 +1064,15 @@ static int do_write(struct fsg_common *common)
 	unsigned int		amount;
 	unsigned int		partial_page;
 	ssize_t			nwritten;
+	bool			fua = false;
 	int			rc;
 
 	if (curlun->ro) {
 		curlun->sense_data = SS_WRITE_PROTECTED;
 		return -EINVAL;
 	}
+	if (fsg_check_wb_error(curlun))
+		return -EINVAL;
 
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
@@ -859,6 +1089,7 @@ static int do_write(struct fsg_common *common)
 			curlun->sense_data = SS_INVALID_FIELD_IN_CDB;
 			return -EINVAL;
 		}
+		fua = !curlun->nofua && (common->cmnd[1] & 0x08);
 	}
 	if (lba >= curlun->num_sectors) {
 		curlun->sense_data = SS_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE;
@@ -947,12 +1178,10 @@ static int do_write(struct fsg_common *common)
 			amount = bh->outreq->actual;
 
 			/* Perform the write */
-			rc = ums[common->lun].write_sector(&ums[common->lun],
+			rc = fsg_write_sectors(common,
 					       file_offset / SECTOR_SIZE,
 					       amount / SECTOR_SIZE,
-					       (char __user *)bh->buf);
-			if (!rc)
-				return -EIO;
+					       (char __user *)bh->buf, fua);
 			nwritten = rc * SECTOR_SIZE;
 
 			VLDBG(curlun, "file write %u @ %llu -> %d\n", amount,
@@ -1003,6 +1232,12 @@ static int do_write(struct fsg_common *common)
 
 static int do_synchronize_cache(struct fsg_common *common)
 {
+	struct fsg_lun	*curlun = &common->luns[common->lun];
+
+	/* We ignore the requested LBA and write out everything */
+	fsg_flush(common);
+	fsg_check_wb_error(curlun);
+
 	return 0;
 }
 
@@ -1044,6 +1279,7 @@ static int do_verify(struct fsg_common *common)
 	file_offset = ((loff_t) lba) << 9;
 
 	/* Write out all the dirty buffers before invalidating them */
+	fsg_flush(common);
 
 	/* Just try to read the requested blocks */
 	while (amount_left > 0) {
@@ -1067,6 +1303,7 @@ static int do_verify(struct fsg_common *common)
 				      file_offset / SECTOR_SIZE,
 				      amount / SECTOR_SIZE,
 				      (char __user *)bh->buf);
+		ums[common->lun].stats.dev_reads++;
 		if (!rc)
 			return -EIO;
 		nread = rc * SECTOR_SIZE;
@@ -1337,6 +1574,10 @@ static int do_start_stop(struct fsg_common *common)
 		return -EINVAL;
 	}
 
+	/* Finish writing before the medium is stopped or ejected */
+	if (!(common->cmnd[4] & 0x01))
+		fsg_flush(common);
+
 	return 0;
 }
 
@@ -1357,7 +1598,7 @@ static int do_prevent_allow(struct fsg_common *common)
 	}
 
 	if (curlun->prevent_medium_removal && !prevent)
-		fsg_lun_fsync_sub(curlun);
+		fsg_flush(common);
 	curlun->prevent_medium_removal = prevent;
 	return 0;
 }
@@ -2526,6 +2767,7 @@ buffhds_first_it:
 		}
 	} while (--i);
 	bh->next = common->buffhds;
+	fsg_cache_init(common);
 
 	snprintf(common->inquiry_string, sizeof common->inquiry_string,
 		 "%-8s%-16s%04x",
@@ -2654,6 +2896,7 @@ static void fsg_unbind(struct usb_configuration *c, struct usb_function *f)
 	struct fsg_dev		*fsg = fsg_from_func(f);
 
 	DBG(fsg, "unbind\n");
+	fsg_cache_release(fsg->common);
 	if (fsg->common->fsg == fsg) {
 		fsg->common->new_fsg = NULL;
 		raise_exception(fsg->common, FSG_STATE_CONFIG_CHANGE);
@@ -0,0 +1,398 @@
+/*
+ * Sandbox USB device controller
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This connects a gadget driver to a simulated high-speed USB host which
+ * tests can use to talk to it. There is one bulk endpoint in each direction.
+ * The host sends control requests for enumeration straight to the gadget
+ * driver's setup() method.
+ *
+ * A test can also give a function to act as the host, which is called each
+ * time the gadget polls the controller. This suits gadgets which wait for
+ * the host in a loop of their own, such as USB mass storage.
+ *
+ * Data moves as soon as the host asks for it, but the time it would take on
+ * the bus is recorded. This includes time lost when the host has data to
+ * send but the gadget has no OUT request queued, so the host must retry
+ * until the gadget has dealt with the last one and queued another.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <asm/test.h>
+#include <linux/list.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/gadget.h>
+
+/* Bus time for each packet: 13 bulk packets fit in a 125us microframe */
+#define SANDBOX_UDC_PACKET_NS	(125000 / 13)
+
+/* Time for the gadget to notice a finished request and queue another */
+#define SANDBOX_UDC_TURNAROUND_NS	125000
+
+#define SANDBOX_UDC_EP0_MAXPACKET	64
+
+enum {
+	SANDBOX_UDC_EP0,
+	SANDBOX_UDC_EP_IN,
+	SANDBOX_UDC_EP_OUT,
+
+	SANDBOX_UDC_EP_COUNT,
+};
+
+/**
+ * struct sandbox_udc_ep - an endpoint
+ *
+ * @ep:		Generic endpoint
+ * @queue:	Requests queued by the gadget, oldest first
+ * @starved:	true if the last request finished with no other queued
+ */
+struct sandbox_udc_ep {
+	struct usb_ep ep;
+	struct list_head queue;
+	bool starved;
+};
+
+struct sandbox_udc_req {
+	struct usb_request req;
+	struct list_head queue;
+};
+
+/**
+ * struct sandbox_udc - controller state
+ *
+ * @gadget:	Generic gadget
+ * @driver:	Gadget driver bound to the controller, or NULL
+ * @ep:		Endpoints
+ * @pullup:	true if the gadget has connected to the bus
+ * @connected:	true if the host has configured the gadget and not gone away
+ * @host_poll:	Function acting as the host, or NULL
+ * @host_priv:	Private data for @host_poll
+ * @busy_ns:	Bus time spent moving data
+ * @waits:	Number of times the host had to wait for an OUT request
+ */
+static struct sandbox_udc {
+	struct usb_gadget gadget;
+	struct usb_gadget_driver *driver;
+	struct sandbox_udc_ep ep[SANDBOX_UDC_EP_COUNT];
+	bool pullup;
+	bool connected;
+	void (*host_poll)(void *priv);
+	void *host_priv;
+	u64 busy_ns;
+	uint waits;
+} sandbox_udc;
+
+static inline struct sandbox_udc_ep *to_sandbox_ep(struct usb_ep *ep)
+{
+	return container_of(ep, struct sandbox_udc_ep, ep);
+}
+
+static inline struct sandbox_udc_req *to_sandbox_req(struct usb_request *req)
+{
+	return container_of(req, struct sandbox_udc_req, req);
+}
+
+/* Remove a request from its queue and hand it back to the gadget */
+static void sandbox_udc_done(struct sandbox_udc_ep *sep,
+			     struct sandbox_udc_req *sreq, int status)
+{
+	list_del_init(&sreq->queue);
+	sep->starved = list_empty(&sep->queue);
+	sreq->req.status = status;
+	if (sreq->req.complete)
+		sreq->req.complete(&sep->ep, &sreq->req);
+}
+
+static void sandbox_udc_nuke(struct sandbox_udc_ep *sep, int status)
+{
+	struct sandbox_udc_req *sreq;
+
+	while (!list_empty(&sep->queue)) {
+		sreq = list_first_entry(&sep->queue, struct sandbox_udc_req,
+					queue);
+		sandbox_udc_done(sep, sreq, status);
+	}
+}
+
+static int sandbox_udc_ep_enable(struct usb_ep *ep,
+				 const struct usb_endpoint_descriptor *desc)
+{
+	ep->desc = desc;
+	ep->maxpacket = usb_endpoint_maxp(desc);
+
+	return 0;
+}
+
+static int sandbox_udc_ep_disable(struct usb_ep *ep)
+{
+	sandbox_udc_nuke(to_sandbox_ep(ep), -ESHUTDOWN);
+	ep->desc = NULL;
+
+	return 0;
+}
+
+static struct usb_request *sandbox_udc_alloc_request(struct usb_ep *ep,
+						     gfp_t gfp_flags)
+{
+	struct sandbox_udc_req *sreq;
+
+	sreq = calloc(1, sizeof(*sreq));
+	if (!sreq)
+		return NULL;
+	INIT_LIST_HEAD(&sreq->queue);
+
+	return &sreq->req;
+}
+
+static void sandbox_udc_free_request(struct usb_ep *ep,
+				     struct usb_request *req)
+{
+	free(to_sandbox_req(req));
+}
+
+static int sandbox_udc_queue(struct usb_ep *ep, struct usb_request *req,
+			     gfp_t gfp_flags)
+{
+	struct sandbox_udc_ep *sep = to_sandbox_ep(ep);
+	struct sandbox_udc_req *sreq = to_sandbox_req(req);
+
+	if (!req->complete || !req->buf || !list_empty(&sreq->queue))
+		return -EINVAL;
+	req->actual = 0;
+	req->status = -EINPROGRESS;
+	list_add_tail(&sreq->queue, &sep->queue);
+
+	/* The host accepts control data and status stages straight away */
+	if (sep == &sandbox_udc.ep[SANDBOX_UDC_EP0]) {
+		req->actual = req->length;
+		sandbox_udc_done(sep, sreq, 0);
+	}
+
+	return 0;
+}
+
+static int sandbox_udc_dequeue(struct usb_ep *ep, struct usb_request *req)
+{
+	struct sandbox_udc_ep *sep = to_sandbox_ep(ep);
+	struct sandbox_udc_req *sreq = to_sandbox_req(req);
+
+	if (list_empty(&sreq->queue))
+		return -EINVAL;
+	sandbox_udc_done(sep, sreq, -ECONNRESET);
+
+	return 0;
+}
+
+static int sandbox_udc_set_halt(struct usb_ep *ep, int value)
+{
+	return 0;
+}
+
+static const struct usb_ep_ops sandbox_udc_ep_ops = {
+	.enable		= sandbox_udc_ep_enable,
+	.disable	= sandbox_udc_ep_disable,
+	.alloc_request	= sandbox_udc_alloc_request,
+	.free_request	= sandbox_udc_free_request,
+	.queue		= sandbox_udc_queue,
+	.dequeue	= sandbox_udc_dequeue,
+	.set_halt	= sandbox_udc_set_halt,
+};
+
+static int sandbox_udc_pullup(struct usb_gadget *gadget, int is_on)
+{
+	sandbox_udc.pullup = is_on;
+
+	return 0;
+}
+
+static const struct usb_gadget_ops sandbox_udc_ops = {
+	.pullup		= sandbox_udc_pullup,
+};
+
+static const char *const sandbox_udc_ep_name[SANDBOX_UDC_EP_COUNT] = {
+	"ep0", "ep1in", "ep2out",
+};
+
+int usb_gadget_register_driver(struct usb_gadget_driver *driver)
+{
+	struct sandbox_udc *udc = &sandbox_udc;
+	struct sandbox_udc_ep *sep;
+	int ret;
+	int i;
+
+	if (!driver || !driver->bind || !driver->setup)
+		return -EINVAL;
+	if (udc->driver)
+		return -EBUSY;
+
+	memset(udc, '\0', sizeof(*udc));
+	udc->gadget.ops = &sandbox_udc_ops;
+	udc->gadget.name = "sandbox_udc";
+	udc->gadget.speed = USB_SPEED_HIGH;
+	udc->gadget.max_speed = USB_SPEED_HIGH;
+	udc->gadget.is_dualspeed = 1;
+	udc->gadget.ep0 = &udc->ep[SANDBOX_UDC_EP0].ep;
+	INIT_LIST_HEAD(&udc->gadget.ep_list);
+	for (i = 0; i < SANDBOX_UDC_EP_COUNT; i++) {
+		sep = &udc->ep[i];
+		sep->ep.name = sandbox_udc_ep_name[i];
+		sep->ep.ops = &sandbox_udc_ep_ops;
+		usb_ep_set_maxpacket_limit(&sep->ep, i ? 512 :
+					   SANDBOX_UDC_EP0_MAXPACKET);
+		INIT_LIST_HEAD(&sep->queue);
+		if (i)
+			list_add_tail(&sep->ep.ep_list, &udc->gadget.ep_list);
+	}
+
+	ret = driver->bind(&udc->gadget);
+	if (ret)
+		return ret;
+	udc->driver = driver;
+
+	return 0;
+}
+
+int usb_gadget_unregister_driver(struct usb_gadget_driver *driver)
+{
+	struct sandbox_udc *udc = &sandbox_udc;
+	int i;
+
+	if (!udc->driver || driver != udc->driver)
+		return -EINVAL;
+	if (driver->disconnect)
+		driver->disconnect(&udc->gadget);
+	for (i = 0; i < SANDBOX_UDC_EP_COUNT; i++)
+		sandbox_udc_nuke(&udc->ep[i], -ESHUTDOWN);
+	driver->unbind(&udc->gadget);
+	udc->driver = NULL;
+	udc->connected = false;
+
+	return 0;
+}
+
+int usb_gadget_handle_interrupts(int index)
+{
+	/* Everything happens when the host asks for it */
+	if (sandbox_udc.host_poll)
+		sandbox_udc.host_poll(sandbox_udc.host_priv);
+
+	return 0;
+}
+
+int g_dnl_board_usb_cable_connected(void)
+{
+	return sandbox_udc.connected;
+}
+
+void sandbox_udc_set_host(void (*poll)(void *priv), void *priv)
+{
+	sandbox_udc.host_poll = poll;
+	sandbox_udc.host_priv = priv;
+}
+
+int sandbox_udc_connect(int config)
+{
+	struct sandbox_udc *udc = &sandbox_udc;
+	struct usb_ctrlrequest ctrl;
+	int ret;
+
+	if (!udc->driver || !udc->pullup)
+		return -ENOTCONN;
+	udc->busy_ns = 0;
+	udc->waits = 0;
+
+	memset(&ctrl, '\0', sizeof(ctrl));
+	ctrl.bRequestType = USB_DIR_OUT | USB_TYPE_STANDARD |
+		USB_RECIP_DEVICE;
+	ctrl.bRequest = USB_REQ_SET_CONFIGURATION;
+	ctrl.wValue = cpu_to_le16(config);
+	ret = udc->driver->setup(&udc->gadget, &ctrl);
+	if (ret < 0)
+		return ret;
+	udc->connected = true;
+
+	return 0;
+}
+
+void sandbox_udc_disconnect(void)
+{
+	struct sandbox_udc *udc = &sandbox_udc;
+
+	if (!udc->connected)
+		return;
+	udc->connected = false;
+	if (udc->driver->disconnect)
+		udc->driver->disconnect(&udc->gadget);
+}
+
+/* Account for sending @len bytes in one go on an endpoint */
+static void sandbox_udc_bus_time(struct sandbox_udc_ep *sep, uint len)
+{
+	struct sandbox_udc *udc = &sandbox_udc;
+
+	udc->busy_ns += (u64)DIV_ROUND_UP(len, sep->ep.maxpacket) *
+		SANDBOX_UDC_PACKET_NS;
+}
+
+int sandbox_udc_bulk_out(const void *buf, int len)
+{
+	struct sandbox_udc_ep *sep = &sandbox_udc.ep[SANDBOX_UDC_EP_OUT];
+	struct sandbox_udc_req *sreq;
+	struct usb_request *req;
+	int done = 0;
+	uint n;
+
+	while (done < len) {
+		if (list_empty(&sep->queue))
+			return done ? done : -EAGAIN;
+		if (sep->starved) {
+			sandbox_udc.waits++;
+			sep->starved = false;
+		}
+		sreq = list_first_entry(&sep->queue, struct sandbox_udc_req,
+					queue);
+		req = &sreq->req;
+		n = min_t(uint, len - done, req->length - req->actual);
+		memcpy(req->buf + req->actual, buf + done, n);
+		sandbox_udc_bus_time(sep, n);
+		req->actual += n;
+		done += n;
+
+		/* A request finishes when full or after a short packet */
+		if (req->actual == req->length ||
+		    (done == len && len % sep->ep.maxpacket))
+			sandbox_udc_done(sep, sreq, 0);
+	}
+
+	return done;
+}
+
+int sandbox_udc_bulk_in(void *buf, int maxlen)
+{
+	struct sandbox_udc_ep *sep = &sandbox_udc.ep[SANDBOX_UDC_EP_IN];
+	struct sandbox_udc_req *sreq;
+	struct usb_request *req;
+
+	if (list_empty(&sep->queue))
+		return -EAGAIN;
+	sreq = list_first_entry(&sep->queue, struct sandbox_udc_req, queue);
+	req = &sreq->req;
+	req->actual = min_t(uint, req->length, maxlen);
+	memcpy(buf, req->buf, req->actual);
+	sandbox_udc_bus_time(sep, req->actual);
+	sandbox_udc_done(sep, sreq, 0);
+
+	return req->actual;
+}
+
+void sandbox_udc_get_stats(struct sandbox_udc_stats *stats)
+{
+	stats->busy_ns = sandbox_udc.busy_ns;
+	stats->waits = sandbox_udc.waits;
+	stats->wait_ns = (u64)sandbox_udc.waits * SANDBOX_UDC_TURNAROUND_NS;
+}
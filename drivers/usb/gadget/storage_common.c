@@ -285,6 +285,7 @@ struct fsg_lun {
 	unsigned int	registered:1;
 	unsigned int	info_valid:1;
 	unsigned int	nofua:1;
+	unsigned int	wb_error:1;	/* Write-back failed, not reported */
 
 	u32		sense_data;
 	u32		sense_data_info;
@@ -305,8 +306,11 @@ static struct fsg_lun *fsg_lun_from_dev(struct device *dev)
 #define EP0_BUFSIZE	256
 #define DELAYED_STATUS	(EP0_BUFSIZE + 999)	/* An impossibly large value */
 
-/* Number of buffers we will use.  2 is enough for double-buffering */
-#define FSG_NUM_BUFFERS	2
+/*
+ * Number of buffers we will use.  2 is enough for double-buffering, but more
+ * let the controller keep moving data while we wait for the medium
+ */
+#define FSG_NUM_BUFFERS	4
 
 /* Default size of buffer length. */
 #define FSG_BUFLEN	((u32)16384)
@@ -586,15 +590,6 @@ static void fsg_lun_close(struct fsg_lun *curlun)
 
 /*-------------------------------------------------------------------------*/
 
-/*
- * Sync the file data, don't bother with the metadata.
- * This code was copied from fs/buffer.c:sys_fdatasync().
- */
-static int fsg_lun_fsync_sub(struct fsg_lun *curlun)
-{
-	return 0;
-}
-
 static void store_cdrom_address(u8 *dest, int msf, u32 addr)
 {
 	if (msf) {
@@ -0,0 +1,1132 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Read-only support for EROFS filesystems
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Inodes are found directly from their number, and the entries of each
+ * directory block are sorted, so a path is looked up by reading a few
+ * filesystem blocks. Those are read one at a time into a small cache, which
+ * also holds the cluster indexes of compressed files. erofs_close() leaves
+ * the cache alone; erofs_probe() only empties it if it finds a different
+ * device, partition or superblock.
+ *
+ * Uncompressed files are read straight into the load buffer. Compressed
+ * files are split into extents whose data is compressed into one block
+ * each. The cluster index gives the extent and block for any offset in the
+ * file, so reading part of a file only decompresses the extents covering
+ * that part. Extents which are wanted whole are decompressed straight into
+ * the load buffer; others are decompressed into a buffer which is kept for
+ * the next read. Compressed blocks are read through a window, so that
+ * consecutive blocks are read with one large read.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <erofs.h>
+#include <errno.h>
+#include <fs.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <part.h>
+#include <asm/unaligned.h>
+#include <linux/stat.h>
+
+#define EROFS_META_CACHE	8	/* filesystem blocks cached */
+#define EROFS_WINDOW_SIZE	(256 << 10)
+#define EROFS_MAX_LINKS		8	/* symbolic links followed in a path */
+#define EROFS_MAX_PATH		4096
+
+#define EROFS_NO_BLOCK		((u64)-1)
+
+/*
+ * Features which either do not change how the filesystem is read, or are
+ * checked for where they do, so that the files not using them can be read
+ */
+#define EROFS_FEATURE_INCOMPAT_KNOWN	(EROFS_FEATURE_INCOMPAT_ZERO_PADDING | \
+					 EROFS_FEATURE_INCOMPAT_COMPR_CFGS | \
+					 EROFS_FEATURE_INCOMPAT_CHUNKED_FILE | \
+					 EROFS_FEATURE_INCOMPAT_DEVICE_TABLE | \
+					 EROFS_FEATURE_INCOMPAT_ZTAILPACKING | \
+					 EROFS_FEATURE_INCOMPAT_FRAGMENTS | \
+					 EROFS_FEATURE_INCOMPAT_XATTR_PREFIXES)
+
+/**
+ * struct erofs_inode - the parts of an inode needed to use it
+ *
+ * @pos:	Offset of the inode in the partition
+ * @isize:	Size of the inode and its extended attributes
+ * @mode:	File type and permissions
+ * @layout:	Data layout (EROFS_INODE_...)
+ * @size:	Size of the file
+ * @blkaddr:	First data block of an uncompressed file
+ * @advise:	Flags from the map header of a compressed file
+ * @lclusterbits: log2 of the logical cluster size of a compressed file
+ */
+struct erofs_inode {
+	u64 pos;
+	u32 isize;
+	u16 mode;
+	int layout;
+	u64 size;
+	u32 blkaddr;
+	u16 advise;
+	int lclusterbits;
+};
+
+/**
+ * struct erofs_lcluster - the index entry of a logical cluster
+ *
+ * @type:	Cluster type (Z_EROFS_LCLUSTER_TYPE_...)
+ * @clusterofs:	Offset in the cluster at which an extent starts
+ * @delta:	Number of clusters back to the one which starts the extent
+ *		covering this one, for a NONHEAD cluster
+ * @pblk:	Block holding the data of the extent which starts here
+ */
+struct erofs_lcluster {
+	int type;
+	u32 clusterofs;
+	u32 delta;
+	u32 pblk;
+};
+
+/**
+ * struct erofs_extent - part of a compressed file stored in one block
+ *
+ * @start:	Offset of the extent in the file
+ * @len:	Number of bytes of the file in the extent
+ * @pblk:	Block holding the extent's data
+ * @plain:	true if the data is not compressed
+ */
+struct erofs_extent {
+	u64 start;
+	u32 len;
+	u32 pblk;
+	bool plain;
+};
+
+/**
+ * struct erofs_cache_entry - a filesystem block
+ *
+ * @blk:	Block number, EROFS_NO_BLOCK if unused
+ * @used:	Value of the clock when the entry was last used
+ * @data:	Contents of the block
+ */
+struct erofs_cache_entry {
+	u64 blk;
+	ulong used;
+	u8 *data;
+};
+
+/**
+ * struct erofs_info - state of the filesystem being used
+ *
+ * @desc:	Block device, NULL if no filesystem has been probed
+ * @part:	Partition holding the filesystem
+ * @sb:		Superblock, as found on the partition
+ * @blkszbits:	log2 of @blksz
+ * @blksz:	Size of a filesystem block
+ * @cache:	Cache of filesystem blocks
+ * @cache_size:	Size of the data buffer of each cache entry
+ * @clock:	Incremented each time a cache entry is used
+ * @win:	Window onto the partition
+ * @win_start:	Offset of the window in the partition
+ * @win_len:	Number of bytes held in the window
+ * @win_size:	Size of the window buffer
+ * @extent:	Last extent decompressed into @extent_buf
+ * @extent_buf:	Buffer for decompressing extents which are not wanted whole
+ * @extent_size: Size of @extent_buf
+ */
+static struct erofs_info {
+	struct blk_desc *desc;
+	disk_partition_t part;
+	struct erofs_super_block sb;
+	int blkszbits;
+	u32 blksz;
+	struct erofs_cache_entry cache[EROFS_META_CACHE];
+	u32 cache_size;
+	ulong clock;
+	u8 *win;
+	u64 win_start;
+	u32 win_len;
+	u32 win_size;
+	struct erofs_extent extent;
+	u8 *extent_buf;
+	u32 extent_size;
+} erofs;
+
+/**
+ * erofs_map() - Get a pointer to bytes of the partition
+ *
+ * If the bytes are not in the window, it is refilled starting at the sector
+ * holding @off. At least @ahead bytes are read if they fit, so that a caller
+ * working through the partition in order finds the next bytes there too.
+ *
+ * @off:	Offset in the partition
+ * @len:	Number of bytes wanted
+ * @ahead:	Number of bytes from @off to read if the window is refilled
+ * @return pointer to the bytes, or NULL on error
+ */
+static const u8 *erofs_map(u64 off, u32 len, u64 ahead)
+{
+	int log2blksz = erofs.desc->log2blksz;
+	u64 start, end, limit;
+	lbaint_t count;
+
+	if (off >= erofs.win_start &&
+	    off + len <= erofs.win_start + erofs.win_len)
+		return erofs.win + (off - erofs.win_start);
+
+	limit = (u64)erofs.part.size << log2blksz;
+	if (off + len > limit || len > erofs.win_size - erofs.desc->blksz)
+		return NULL;
+	start = off >> log2blksz << log2blksz;
+	end = off + max_t(u64, len, ahead);
+	end = min(end, start + erofs.win_size);
+	end = min(ALIGN(end, erofs.desc->blksz), limit);
+
+	erofs.win_len = 0;
+	count = (end - start) >> log2blksz;
+	if (blk_dread(erofs.desc, erofs.part.start + (start >> log2blksz),
+		      count, erofs.win) != count)
+		return NULL;
+	erofs.win_start = start;
+	erofs.win_len = end - start;
+
+	return erofs.win + (off - start);
+}
+
+/* Read bytes of the partition, whole sectors straight into @buf */
+static int erofs_read_direct(u64 off, u8 *buf, u64 len)
+{
+	int log2blksz = erofs.desc->log2blksz;
+	u32 mask = erofs.desc->blksz - 1;
+	const u8 *src;
+	lbaint_t count;
+	u32 part;
+
+	if (off + len > (u64)erofs.part.size << log2blksz)
+		return -EIO;
+	if (off & mask) {
+		part = min_t(u64, len, erofs.desc->blksz - (off & mask));
+		src = erofs_map(off, part, 0);
+		if (!src)
+			return -EIO;
+		memcpy(buf, src, part);
+		buf += part;
+		off += part;
+		len -= part;
+	}
+	count = len >> log2blksz;
+	if (count) {
+		if (blk_dread(erofs.desc, erofs.part.start + (off >> log2blksz),
+			      count, buf) != count)
+			return -EIO;
+		buf += count << log2blksz;
+		off += count << log2blksz;
+		len -= count << log2blksz;
+	}
+	if (len) {
+		src = erofs_map(off, len, 0);
+		if (!src)
+			return -EIO;
+		memcpy(buf, src, len);
+	}
+
+	return 0;
+}
+
+/* Get a filesystem block through the cache */
+static const u8 *erofs_get_block(u64 blk)
+{
+	struct erofs_cache_entry *entry, *victim = erofs.cache;
+	int shift = erofs.blkszbits - erofs.desc->log2blksz;
+	lbaint_t count = 1 << shift;
+	int i;
+
+	for (i = 0, entry = erofs.cache; i < EROFS_META_CACHE; i++, entry++) {
+		if (entry->blk == blk) {
+			entry->used = ++erofs.clock;
+			return entry->data;
+		}
+		if (entry->used < victim->used)
+			victim = entry;
+	}
+
+	victim->blk = EROFS_NO_BLOCK;
+	if ((blk + 1) << shift > erofs.part.size ||
+	    blk_dread(erofs.desc, erofs.part.start + (blk << shift), count,
+		      victim->data) != count)
+		return NULL;
+	victim->blk = blk;
+	victim->used = ++erofs.clock;
+
+	return victim->data;
+}
+
+/* Read bytes of the partition through the block cache */
+static int erofs_read_meta(u64 off, void *buf, u32 len)
+{
+	u32 offset, count;
+	const u8 *data;
+
+	while (len) {
+		data = erofs_get_block(off >> erofs.blkszbits);
+		if (!data)
+			return -EIO;
+		offset = off & (erofs.blksz - 1);
+		count = min(len, erofs.blksz - offset);
+		memcpy(buf, data + offset, count);
+		buf += count;
+		off += count;
+		len -= count;
+	}
+
+	return 0;
+}
+
+/* Set up the block cache for blocks of @size bytes, emptying it */
+static int erofs_cache_init(u32 size)
+{
+	struct erofs_cache_entry *entry;
+	int i;
+
+	for (i = 0, entry = erofs.cache; i < EROFS_META_CACHE; i++, entry++) {
+		entry->blk = EROFS_NO_BLOCK;
+		entry->used = 0;
+		if (erofs.cache_size == size && entry->data)
+			continue;
+		free(entry->data);
+		entry->data = malloc_cache_aligned(size);
+		if (!entry->data) {
+			erofs.cache_size = 0;
+			return -ENOMEM;
+		}
+	}
+	erofs.cache_size = size;
+
+	return 0;
+}
+
+static int erofs_read_inode(u64 nid, struct erofs_inode *inode)
+{
+	union {
+		struct erofs_inode_compact c;
+		struct erofs_inode_extended e;
+	} di;
+	u16 format, icount;
+	u64 pos;
+	int ret;
+
+	pos = ((u64)le32_to_cpu(erofs.sb.meta_blkaddr) << erofs.blkszbits) +
+		(nid << EROFS_ISLOTBITS);
+	ret = erofs_read_meta(pos, &di.c, sizeof(di.c));
+	if (ret)
+		return ret;
+
+	memset(inode, '\0', sizeof(*inode));
+	inode->pos = pos;
+	format = le16_to_cpu(di.c.i_format);
+	inode->layout = (format >> EROFS_I_DATALAYOUT_BIT) &
+		EROFS_I_DATALAYOUT_MASK;
+	inode->mode = le16_to_cpu(di.c.i_mode);
+	icount = le16_to_cpu(di.c.i_xattr_icount);
+	if (((format >> EROFS_I_VERSION_BIT) & 1) ==
+	    EROFS_INODE_LAYOUT_COMPACT) {
+		inode->isize = sizeof(di.c);
+		inode->size = le32_to_cpu(di.c.i_size);
+		inode->blkaddr = le32_to_cpu(di.c.i_u);
+	} else {
+		ret = erofs_read_meta(pos, &di.e, sizeof(di.e));
+		if (ret)
+			return ret;
+		inode->isize = sizeof(di.e);
+		inode->size = le64_to_cpu(di.e.i_size);
+		inode->blkaddr = le32_to_cpu(di.e.i_u);
+	}
+	if (icount) {
+		inode->isize += EROFS_XATTR_IBODY_HEADER_SIZE +
+			(icount - 1) * EROFS_XATTR_ENTRY_SIZE;
+	}
+
+	return 0;
+}
+
+static bool erofs_is_plain(struct erofs_inode *inode)
+{
+	return inode->layout == EROFS_INODE_FLAT_PLAIN ||
+		inode->layout == EROFS_INODE_FLAT_INLINE;
+}
+
+/**
+ * erofs_read_plain() - Read data of an uncompressed inode
+ *
+ * @inode:	Inode to read
+ * @buf:	Buffer for the data
+ * @offset:	Offset in the file
+ * @len:	Number of bytes to read, which must be in the file
+ * @direct:	true to read whole sectors straight into @buf, false to read
+ *		through the block cache
+ * @return 0 if OK, -EIO on error
+ */
+static int erofs_read_plain(struct erofs_inode *inode, u8 *buf, u64 offset,
+			    u64 len, bool direct)
+{
+	u64 disk = (u64)inode->blkaddr << erofs.blkszbits;
+	u64 nblocks, tail, count;
+	int ret;
+
+	/* The last block of an inline file is stored just after the inode */
+	nblocks = (inode->size + erofs.blksz - 1) >> erofs.blkszbits;
+	tail = inode->size;
+	if (inode->layout == EROFS_INODE_FLAT_INLINE && nblocks)
+		tail = (nblocks - 1) << erofs.blkszbits;
+
+	if (offset < tail) {
+		count = min(len, tail - offset);
+		if (direct)
+			ret = erofs_read_direct(disk + offset, buf, count);
+		else
+			ret = erofs_read_meta(disk + offset, buf, count);
+		if (ret)
+			return ret;
+		buf += count;
+		offset += count;
+		len -= count;
+	}
+	if (len) {
+		ret = erofs_read_meta(inode->pos + inode->isize + offset - tail,
+				      buf, len);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Check that a compressed file can be read, and set up to read it */
+static int erofs_init_zmap(struct erofs_inode *inode)
+{
+	u32 incompat = le32_to_cpu(erofs.sb.feature_incompat);
+	struct z_erofs_map_header h;
+	int ret;
+
+	ret = erofs_read_meta(ALIGN(inode->pos + inode->isize, 8), &h,
+			      sizeof(h));
+	if (ret)
+		return ret;
+	inode->advise = le16_to_cpu(h.h_advise);
+	inode->lclusterbits = erofs.blkszbits + (h.h_clusterbits & 7);
+
+	/*
+	 * Without zero padding the compressed data is followed by junk rather
+	 * than preceded by zeroes, so its length is not known
+	 */
+	if (!(incompat & EROFS_FEATURE_INCOMPAT_ZERO_PADDING) ||
+	    (inode->advise & ~Z_EROFS_ADVISE_COMPACTED_2B) ||
+	    (h.h_algorithmtype & 0xf) != Z_EROFS_COMPRESSION_LZ4 ||
+	    (h.h_clusterbits & ~7))
+		return -EOPNOTSUPP;
+	if (inode->layout == EROFS_INODE_COMPRESSED_COMPACT &&
+	    (inode->lclusterbits > 14 ||
+	     ((inode->advise & Z_EROFS_ADVISE_COMPACTED_2B) &&
+	      inode->lclusterbits > 12)))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+static u32 erofs_lclusters(struct erofs_inode *inode)
+{
+	return (inode->size + (1 << inode->lclusterbits) - 1) >>
+		inode->lclusterbits;
+}
+
+/* Offset of the cluster indexes, just after the map header */
+static u64 erofs_zmap_base(struct erofs_inode *inode)
+{
+	return ALIGN(inode->pos + inode->isize, 8) +
+		sizeof(struct z_erofs_map_header);
+}
+
+static int erofs_load_full(struct erofs_inode *inode, u32 lcn,
+			   struct erofs_lcluster *m)
+{
+	struct z_erofs_lcluster_index di;
+	u16 advise;
+	int ret;
+
+	/* The first 8 bytes after the map header are not used */
+	ret = erofs_read_meta(erofs_zmap_base(inode) + 8 + lcn * sizeof(di),
+			      &di, sizeof(di));
+	if (ret)
+		return ret;
+	advise = le16_to_cpu(di.di_advise);
+	if (advise & Z_EROFS_LI_PARTIAL_REF)
+		return -EOPNOTSUPP;
+	m->type = advise & Z_EROFS_LI_LCLUSTER_TYPE_MASK;
+	if (m->type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+		m->delta = le16_to_cpu(di.di_u.delta[0]);
+	} else {
+		m->clusterofs = le16_to_cpu(di.di_clusterofs);
+		m->pblk = le32_to_cpu(di.di_u.blkaddr);
+	}
+
+	return 0;
+}
+
+/* Get the value and type of entry @i of a pack of compact indexes */
+static u32 erofs_decode_compact(const u8 *pack, int lobits, int encodebits,
+				int i, int *type)
+{
+	int pos = encodebits * i;
+	u32 v = get_unaligned_le32(pack + pos / 8) >> (pos & 7);
+
+	*type = (v >> lobits) & Z_EROFS_LI_LCLUSTER_TYPE_MASK;
+
+	return v & ((1 << lobits) - 1);
+}
+
+/*
+ * Compact indexes are stored in packs of 2 clusters in 8 bytes or 16 in 32
+ * bytes. Each cluster has its type and either its clusterofs or its delta.
+ * The pack ends with a block number, from which those of its HEAD and PLAIN
+ * clusters follow since the blocks of a file are consecutive.
+ */
+static int erofs_load_compact(struct erofs_inode *inode, u32 lcn,
+			      struct erofs_lcluster *m)
+{
+	u64 ebase = erofs_zmap_base(inode);
+	u32 total = erofs_lclusters(inode);
+	int lobits = max(inode->lclusterbits, 12);
+	u32 initial, compacted_2b, vcnt, packsize, lo, nblk;
+	int shift, encodebits, i, type, ret;
+	u8 pack[32];
+	u64 pos;
+
+	/* 4-byte packs come first, up to a 32-byte boundary for 2-byte ones */
+	initial = (32 - ebase % 32) / 4;
+	if (initial == 32 / 4)
+		initial = 0;
+	compacted_2b = 0;
+	if ((inode->advise & Z_EROFS_ADVISE_COMPACTED_2B) && initial < total)
+		compacted_2b = rounddown(total - initial, 16);
+
+	pos = ebase;
+	if (lcn < initial) {
+		shift = 2;
+	} else if (lcn - initial < compacted_2b) {
+		shift = 1;
+		pos += initial * 4;
+		lcn -= initial;
+	} else {
+		shift = 2;
+		pos += initial * 4 + compacted_2b * 2;
+		lcn -= initial + compacted_2b;
+	}
+	pos += lcn << shift;
+
+	vcnt = shift == 2 ? 2 : 16;
+	packsize = vcnt << shift;
+	encodebits = (packsize - sizeof(__le32)) * 8 / vcnt;
+	ret = erofs_read_meta(rounddown(pos, packsize), pack, packsize);
+	if (ret)
+		return ret;
+	i = (pos % packsize) >> shift;
+
+	lo = erofs_decode_compact(pack, lobits, encodebits, i, &type);
+	m->type = type;
+	if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+		if (i + 1 == vcnt) {
+			/*
+			 * The last cluster of a pack holds the distance to the
+			 * next extent instead, so use the cluster before it
+			 */
+			lo = erofs_decode_compact(pack, lobits, encodebits,
+						  i - 1, &type);
+			m->delta = type == Z_EROFS_LCLUSTER_TYPE_NONHEAD ?
+				lo + 1 : 1;
+		} else {
+			m->delta = lo;
+		}
+		/* Only extents of several blocks use this */
+		if (m->delta & Z_EROFS_LI_D0_CBLKCNT)
+			return -EOPNOTSUPP;
+		return 0;
+	}
+
+	m->clusterofs = lo;
+	for (nblk = 1; i > 0;) {
+		lo = erofs_decode_compact(pack, lobits, encodebits, --i,
+					  &type);
+		if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD)
+			i -= lo;
+		if (i >= 0)
+			nblk++;
+	}
+	m->pblk = get_unaligned_le32(pack + packsize - sizeof(__le32)) + nblk;
+
+	return 0;
+}
+
+static int erofs_load_lcluster(struct erofs_inode *inode, u32 lcn,
+			       struct erofs_lcluster *m)
+{
+	if (lcn >= erofs_lclusters(inode))
+		return -EIO;
+	if (inode->layout == EROFS_INODE_COMPRESSED_FULL)
+		return erofs_load_full(inode, lcn, m);
+
+	return erofs_load_compact(inode, lcn, m);
+}
+
+/* Find the extent of a compressed file which holds offset @pos */
+static int erofs_map_extent(struct erofs_inode *inode, u64 pos,
+			    struct erofs_extent *ext)
+{
+	int bits = inode->lclusterbits;
+	u32 total = erofs_lclusters(inode);
+	u32 lcn = pos >> bits;
+	struct erofs_lcluster m;
+	u64 end;
+	int ret;
+
+	ret = erofs_load_lcluster(inode, lcn, &m);
+	if (ret)
+		return ret;
+
+	/* The start of a cluster may belong to the extent before */
+	if (m.type != Z_EROFS_LCLUSTER_TYPE_NONHEAD &&
+	    (pos & ((1 << bits) - 1)) < m.clusterofs) {
+		if (!lcn)
+			return -EIO;
+		ret = erofs_load_lcluster(inode, --lcn, &m);
+		if (ret)
+			return ret;
+	}
+	if (m.type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+		if (!m.delta || m.delta > lcn)
+			return -EIO;
+		lcn -= m.delta;
+		ret = erofs_load_lcluster(inode, lcn, &m);
+		if (ret)
+			return ret;
+	}
+	switch (m.type) {
+	case Z_EROFS_LCLUSTER_TYPE_PLAIN:
+	case Z_EROFS_LCLUSTER_TYPE_HEAD1:
+		break;
+	case Z_EROFS_LCLUSTER_TYPE_HEAD2:
+		return -EOPNOTSUPP;
+	default:
+		return -EIO;
+	}
+	ext->start = ((u64)lcn << bits) + m.clusterofs;
+	ext->pblk = m.pblk;
+	ext->plain = m.type == Z_EROFS_LCLUSTER_TYPE_PLAIN;
+
+	/* The extent ends where the next one starts */
+	end = inode->size;
+	while (++lcn < total) {
+		ret = erofs_load_lcluster(inode, lcn, &m);
+		if (ret)
+			return ret;
+		if (m.type != Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+			end = min(end, ((u64)lcn << bits) + m.clusterofs);
+			break;
+		}
+	}
+	if (end <= ext->start || end - ext->start > U32_MAX ||
+	    (ext->plain && end - ext->start > erofs.blksz))
+		return -EIO;
+	ext->len = end - ext->start;
+
+	return 0;
+}
+
+/**
+ * erofs_decompress() - Decompress an extent
+ *
+ * @ext:	Extent to decompress
+ * @dst:	Buffer for all of the extent
+ * @ahead:	Number of bytes of compressed data likely to be wanted from
+ *		this extent's block onwards
+ * @return 0 if OK, -EIO on error
+ */
+static int erofs_decompress(struct erofs_extent *ext, void *dst, u64 ahead)
+{
+	size_t len = ext->len;
+	u32 margin = 0;
+	const u8 *src;
+
+	if (!IS_ENABLED(CONFIG_LZ4))
+		return -EOPNOTSUPP;
+	src = erofs_map((u64)ext->pblk << erofs.blkszbits, erofs.blksz, ahead);
+	if (!src)
+		return -EIO;
+
+	/* The compressed data is at the end of the block, after zeroes */
+	while (margin < erofs.blksz && !src[margin])
+		margin++;
+#ifdef CONFIG_LZ4
+	if (ulz4_block(src + margin, erofs.blksz - margin, dst, &len) ||
+	    len != ext->len)
+		return -EIO;
+#endif
+
+	return 0;
+}
+
+static int erofs_read_compressed(struct erofs_inode *inode, u8 *buf,
+				 u64 offset, u64 len)
+{
+	struct erofs_extent ext;
+	u64 pos, end, ahead;
+	const u8 *src;
+	u32 skip, count;
+	int ret;
+
+	for (pos = offset, end = offset + len; pos < end; pos += count) {
+		ret = erofs_map_extent(inode, pos, &ext);
+		if (ret)
+			return ret;
+		skip = pos - ext.start;
+		count = min(end, ext.start + ext.len) - pos;
+		ahead = end - pos;
+
+		if (ext.plain) {
+			src = erofs_map((u64)ext.pblk << erofs.blkszbits,
+					ext.len, ahead);
+			if (!src)
+				return -EIO;
+			memcpy(buf, src + skip, count);
+		} else if (!skip && count == ext.len) {
+			ret = erofs_decompress(&ext, buf, ahead);
+			if (ret)
+				return ret;
+		} else {
+			if (ext.pblk != erofs.extent.pblk ||
+			    ext.len != erofs.extent.len) {
+				if (ext.len > erofs.extent_size) {
+					free(erofs.extent_buf);
+					erofs.extent_size = 0;
+					erofs.extent_buf = malloc(ext.len);
+					if (!erofs.extent_buf)
+						return -ENOMEM;
+					erofs.extent_size = ext.len;
+				}
+				erofs.extent.len = 0;
+				ret = erofs_decompress(&ext, erofs.extent_buf,
+						       ahead);
+				if (ret)
+					return ret;
+				erofs.extent = ext;
+			}
+			memcpy(buf, erofs.extent_buf + skip, count);
+		}
+		buf += count;
+	}
+
+	return 0;
+}
+
+static int erofs_read_file(struct erofs_inode *inode, void *buf, u64 offset,
+			   u64 len, loff_t *actread)
+{
+	int ret;
+
+	*actread = 0;
+	if (offset >= inode->size)
+		return 0;
+	if (!len || len > inode->size - offset)
+		len = inode->size - offset;
+
+	switch (inode->layout) {
+	case EROFS_INODE_FLAT_PLAIN:
+	case EROFS_INODE_FLAT_INLINE:
+		ret = erofs_read_plain(inode, buf, offset, len, true);
+		break;
+	case EROFS_INODE_COMPRESSED_FULL:
+	case EROFS_INODE_COMPRESSED_COMPACT:
+		ret = erofs_init_zmap(inode);
+		if (!ret)
+			ret = erofs_read_compressed(inode, buf, offset, len);
+		break;
+	default:
+		ret = -EOPNOTSUPP;
+		break;
+	}
+	if (!ret)
+		*actread = len;
+
+	return ret;
+}
+
+/**
+ * erofs_dirent_name() - Get the name of an entry in a directory block
+ *
+ * @blk:	Directory block
+ * @len:	Number of bytes in the block
+ * @count:	Number of entries in the block
+ * @i:		Entry to look at
+ * @namelen:	Returns the length of the name, which is not terminated
+ * @return the name, or NULL if the block is corrupt
+ */
+static const char *erofs_dirent_name(const u8 *blk, u32 len, u32 count,
+				     u32 i, u32 *namelen)
+{
+	const struct erofs_dirent *de = (const void *)blk;
+	u32 nameoff = le16_to_cpu(de[i].nameoff);
+	u32 nameend = i + 1 < count ? le16_to_cpu(de[i + 1].nameoff) : len;
+
+	if (nameoff < count * sizeof(*de) || nameoff >= nameend ||
+	    nameend > len)
+		return NULL;
+
+	/* The last name runs to the end of the block, or to a NUL */
+	if (i + 1 == count)
+		nameend = nameoff + strnlen((const char *)blk + nameoff,
+					    nameend - nameoff);
+	*namelen = nameend - nameoff;
+
+	return (const char *)blk + nameoff;
+}
+
+/**
+ * erofs_dir_block() - Read a block of a directory
+ *
+ * @dir:	Directory inode
+ * @offset:	Offset of the block in the directory
+ * @blk:	Buffer for the block
+ * @len:	Returns the number of bytes in the block
+ * @count:	Returns the number of entries in the block
+ * @return 0 if OK, -EIO on error
+ */
+static int erofs_dir_block(struct erofs_inode *dir, u64 offset, u8 *blk,
+			   u32 *len, u32 *count)
+{
+	const struct erofs_dirent *de = (const void *)blk;
+	u32 nameoff;
+	int ret;
+
+	*len = min_t(u64, erofs.blksz, dir->size - offset);
+	if (*len < sizeof(*de))
+		return -EIO;
+	ret = erofs_read_plain(dir, blk, offset, *len, false);
+	if (ret)
+		return ret;
+	nameoff = le16_to_cpu(de->nameoff);
+	if (nameoff < sizeof(*de) || nameoff >= *len)
+		return -EIO;
+	*count = nameoff / sizeof(*de);
+
+	return 0;
+}
+
+/**
+ * erofs_dir_iterate() - Call a function for each entry of a directory
+ *
+ * @dir:	Directory inode
+ * @func:	Function to call with the name, its length, the file type and
+ *		the inode number of each entry. It returns 0 to carry on, or
+ *		anything else to stop and return that value.
+ * @priv:	Private data for @func
+ * @return 0 if @func returned 0 for every entry, the value it returned
+ * otherwise, or -ve on error
+ */
+static int erofs_dir_iterate(struct erofs_inode *dir,
+			     int (*func)(void *priv, const char *name,
+					 u32 namelen, int type, u64 nid),
+			     void *priv)
+{
+	const struct erofs_dirent *de;
+	u32 len, count, namelen, i;
+	const char *name;
+	u64 offset;
+	u8 *blk;
+	int ret = 0;
+
+	if (!erofs_is_plain(dir))
+		return -EOPNOTSUPP;
+	blk = malloc(erofs.blksz);
+	if (!blk)
+		return -ENOMEM;
+	de = (const void *)blk;
+
+	for (offset = 0; !ret && offset < dir->size; offset += erofs.blksz) {
+		ret = erofs_dir_block(dir, offset, blk, &len, &count);
+		for (i = 0; !ret && i < count; i++) {
+			name = erofs_dirent_name(blk, len, count, i, &namelen);
+			if (!name)
+				ret = -EIO;
+			else
+				ret = func(priv, name, namelen,
+					   de[i].file_type,
+					   le64_to_cpu(de[i].nid));
+		}
+	}
+	free(blk);
+
+	return ret;
+}
+
+static int erofs_namecmp(const char *name, u32 len, const char *ent,
+			 u32 entlen)
+{
+	int cmp = memcmp(name, ent, min(len, entlen));
+
+	return cmp ? cmp : (int)len - (int)entlen;
+}
+
+/* Look up a name in a directory, whose blocks are sorted by name */
+static int erofs_lookup(struct erofs_inode *dir, const char *name, u64 *nid)
+{
+	const struct erofs_dirent *de;
+	u32 len, count, namelen, lo, hi, mid;
+	u32 target = strlen(name);
+	const char *ent;
+	u64 offset;
+	u8 *blk;
+	int cmp, ret = -ENOENT;
+
+	if (!erofs_is_plain(dir))
+		return -EOPNOTSUPP;
+	blk = malloc(erofs.blksz);
+	if (!blk)
+		return -ENOMEM;
+	de = (const void *)blk;
+
+	for (offset = 0; offset < dir->size; offset += erofs.blksz) {
+		ret = erofs_dir_block(dir, offset, blk, &len, &count);
+		if (ret)
+			break;
+		ret = -ENOENT;
+		for (lo = 0, hi = count; lo < hi;) {
+			mid = (lo + hi) / 2;
+			ent = erofs_dirent_name(blk, len, count, mid, &namelen);
+			if (!ent) {
+				ret = -EIO;
+				break;
+			}
+			cmp = erofs_namecmp(name, target, ent, namelen);
+			if (!cmp) {
+				*nid = le64_to_cpu(de[mid].nid);
+				ret = 0;
+				break;
+			}
+			if (cmp < 0)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+
+		/* Stop unless the name sorts after all of this block */
+		if (ret != -ENOENT || lo < count)
+			break;
+	}
+	free(blk);
+
+	return ret;
+}
+
+/**
+ * erofs_find() - Find the inode for a path, following symbolic links
+ *
+ * @path:	Path to look up, from the root directory
+ * @inode:	Returns the inode found
+ * @links:	Number of symbolic links already followed
+ * @return 0 if OK, -ENOENT if not found, other -ve value on error
+ */
+static int erofs_find(const char *path, struct erofs_inode *inode, int links)
+{
+	char *copy, *rest, *name, *target, *newpath;
+	u64 nid;
+	int ret;
+
+	ret = erofs_read_inode(le16_to_cpu(erofs.sb.root_nid), inode);
+	if (ret)
+		return ret;
+	copy = fs_clean_path(path);
+	if (!copy)
+		return -ENOMEM;
+
+	for (rest = copy; !ret && rest && *rest;) {
+		name = strsep(&rest, "/");
+		if (!S_ISDIR(inode->mode)) {
+			ret = -ENOTDIR;
+			break;
+		}
+		ret = erofs_lookup(inode, name, &nid);
+		if (!ret)
+			ret = erofs_read_inode(nid, inode);
+		if (ret || !S_ISLNK(inode->mode))
+			continue;
+
+		/* Stop at a loop of links, or a target which is compressed */
+		if (links >= EROFS_MAX_LINKS || inode->size > EROFS_MAX_PATH ||
+		    !erofs_is_plain(inode)) {
+			ret = -ELOOP;
+			break;
+		}
+		target = malloc(inode->size + 1);
+		if (!target) {
+			ret = -ENOMEM;
+			break;
+		}
+		ret = erofs_read_plain(inode, (u8 *)target, 0, inode->size,
+				       false);
+		if (!ret) {
+			target[inode->size] = '\0';
+			newpath = fs_link_path(copy, name, target, rest);
+			ret = newpath ? erofs_find(newpath, inode, links + 1) :
+				-ENOMEM;
+			free(newpath);
+		}
+		free(target);
+		break;
+	}
+	free(copy);
+
+	return ret;
+}
+
+int erofs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
+{
+	struct erofs_super_block old = erofs.sb;
+	struct blk_desc *old_desc = erofs.desc;
+	lbaint_t old_start = erofs.part.start;
+	const struct erofs_super_block *sb;
+	u32 size = EROFS_WINDOW_SIZE + fs_dev_desc->blksz;
+	int blkszbits;
+	bool same;
+
+	erofs.desc = fs_dev_desc;
+	erofs.part = *fs_partition;
+	erofs.win_len = 0;
+	if (erofs.win_size != size) {
+		free(erofs.win);
+		erofs.win = memalign(ARCH_DMA_MINALIGN, size);
+		erofs.win_size = erofs.win ? size : 0;
+		if (!erofs.win)
+			goto err;
+	}
+
+	sb = (const void *)erofs_map(EROFS_SUPER_OFFSET, sizeof(*sb), 0);
+	if (!sb || le32_to_cpu(sb->magic) != EROFS_SUPER_MAGIC)
+		goto err;
+	blkszbits = sb->blkszbits;
+	if (blkszbits < max(EROFS_MIN_BLKSZBITS, fs_dev_desc->log2blksz) ||
+	    blkszbits > EROFS_MAX_BLKSZBITS ||
+	    (le32_to_cpu(sb->feature_incompat) &
+	     ~EROFS_FEATURE_INCOMPAT_KNOWN) ||
+	    le16_to_cpu(sb->extra_devices)) {
+		printf("** Unsupported EROFS filesystem **\n");
+		goto err;
+	}
+
+	same = old_desc == fs_dev_desc && old_start == fs_partition->start &&
+		!memcmp(&old, sb, sizeof(old));
+	erofs.sb = *sb;
+	erofs.blkszbits = blkszbits;
+	erofs.blksz = 1 << blkszbits;
+	if (same)
+		return 0;
+
+	/* The cache holds blocks of another filesystem, if any */
+	erofs.extent.len = 0;
+	if (erofs_cache_init(erofs.blksz))
+		goto err;
+
+	return 0;
+
+err:
+	erofs.desc = NULL;
+	memset(&erofs.sb, '\0', sizeof(erofs.sb));
+
+	return -1;
+}
+
+static int erofs_ls_entry(void *priv, const char *name, u32 namelen,
+			  int type, u64 nid)
+{
+	struct erofs_inode inode;
+
+	if (erofs_read_inode(nid, &inode))
+		return -EIO;
+	switch (type) {
+	case EROFS_FT_DIR:
+		printf("<DIR> ");
+		break;
+	case EROFS_FT_SYMLINK:
+		printf("<SYM> ");
+		break;
+	case EROFS_FT_REG_FILE:
+		printf("      ");
+		break;
+	default:
+		printf("< ? > ");
+		break;
+	}
+	printf("%10llu %.*s\n", S_ISDIR(inode.mode) ? 0 : inode.size,
+	       (int)namelen, name);
+
+	return 0;
+}
+
+int erofs_ls(const char *dirname)
+{
+	struct erofs_inode inode;
+
+	if (erofs_find(dirname, &inode, 0) || !S_ISDIR(inode.mode)) {
+		printf("** Can not find directory. **\n");
+		return -1;
+	}
+
+	return erofs_dir_iterate(&inode, erofs_ls_entry, NULL) ? -1 : 0;
+}
+
+int erofs_exists(const char *filename)
+{
+	struct erofs_inode inode;
+
+	return erofs_find(filename, &inode, 0) == 0;
+}
+
+int erofs_size(const char *filename, loff_t *size)
+{
+	struct erofs_inode inode;
+
+	if (erofs_find(filename, &inode, 0) || !S_ISREG(inode.mode))
+		return -1;
+	*size = inode.size;
+
+	return 0;
+}
+
+int erofs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	       loff_t *actread)
+{
+	struct erofs_inode inode;
+	int ret;
+
+	if (erofs_find(filename, &inode, 0) || !S_ISREG(inode.mode)) {
+		printf("** File not found %s **\n", filename);
+		return -1;
+	}
+	ret = erofs_read_file(&inode, buf, offset, len, actread);
+	if (ret == -EOPNOTSUPP) {
+		printf("** %s uses an unsupported EROFS layout **\n", filename);
+		return -1;
+	} else if (ret) {
+		printf("** Error reading file %s **\n", filename);
+		return -1;
+	}
+
+	return 0;
+}
+
+void erofs_close(void)
+{
+	erofs.win_len = 0;
+}
@@ -169,6 +169,81 @@ uint64_t ext4fs_bg_get_inode_id(const struct ext2_block_group *bg,
 		block_nr += (uint64_t)le32_to_cpu(bg->inode_id_high) << 32;
 	return block_nr;
 }
+
+/*
+ * Bitmaps are read from the disk the first time that their group is used,
+ * so that a small write to a large partition does not read and write the
+ * bitmaps of every group. A bitmap which has not been initialised is taken
+ * to be empty.
+ */
+static unsigned char *ext4fs_load_bmap(unsigned char **bmaps, int index,
+				       uint64_t blknr, int uninit)
+{
+	struct ext_filesystem *fs = get_fs();
+
+	if (bmaps[index])
+		return bmaps[index];
+
+	bmaps[index] = zalloc(fs->blksz);
+	if (!bmaps[index]) {
+		printf("No memory\n");
+		return NULL;
+	}
+	if (!uninit && !ext4fs_devread(blknr * fs->sect_perblk, 0, fs->blksz,
+				       (char *)bmaps[index])) {
+		printf("Error reading bitmap of block group %d\n", index);
+		free(bmaps[index]);
+		bmaps[index] = NULL;
+	}
+
+	return bmaps[index];
+}
+
+unsigned char *ext4fs_get_block_bmap(int index)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd = ext4fs_get_group_descriptor(fs, index);
+	uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
+
+	return ext4fs_load_bmap(fs->blk_bmaps, index,
+				ext4fs_bg_get_block_id(bgd, fs),
+				bg_flags & EXT4_BG_BLOCK_UNINIT);
+}
+
+unsigned char *ext4fs_get_inode_bmap(int index)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd = ext4fs_get_group_descriptor(fs, index);
+	uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
+
+	return ext4fs_load_bmap(fs->inode_bmaps, index,
+				ext4fs_bg_get_inode_id(bgd, fs),
+				bg_flags & EXT4_BG_INODE_UNINIT);
+}
+
+/*
+ * Get the block bitmap of a group to allocate from it, initialising the
+ * bitmap first if no block of the group has been used yet
+ */
+static unsigned char *ext4fs_get_alloc_block_bmap(int index)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd = ext4fs_get_group_descriptor(fs, index);
+	uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
+	unsigned char *bmap;
+
+	bmap = ext4fs_get_block_bmap(index);
+	if (bmap && (bg_flags & EXT4_BG_BLOCK_UNINIT)) {
+		memset(bmap, '\0', fs->blksz);
+		put_ext4(ext4fs_bg_get_block_id(bgd, fs) * fs->blksz, bmap,
+			 fs->blksz);
+		bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
+		ext4fs_bg_set_flags(bgd, bg_flags);
+		fs->bmap_dirty[index] |= EXT4_BMAP_BLOCK_DIRTY;
+	}
+
+	return bmap;
+}
 #endif
 
 /* Block number of the inode table */
@@ -313,6 +388,7 @@ int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index)
 	int blocksize = EXT2_BLOCK_SIZE(ext4fs_root);
 
 	i = i - (index * blocksize);
+	get_fs()->bmap_dirty[index] |= EXT4_BMAP_BLOCK_DIRTY;
 	if (blocksize != 1024) {
 		ptr = ptr + i;
 		operand = 1 << remainder;
@@ -348,7 +424,10 @@ void ext4fs_reset_block_bmap(long int blockno, unsigned char *buffer, int index)
 	remainder = blockno % 8;
 	int blocksize = EXT2_BLOCK_SIZE(ext4fs_root);
 
+	if (!buffer)
+		return;
 	i = i - (index * blocksize);
+	get_fs()->bmap_dirty[index] |= EXT4_BMAP_BLOCK_DIRTY;
 	if (blocksize != 1024) {
 		ptr = ptr + i;
 		operand = (1 << remainder);
@@ -390,6 +469,7 @@ int ext4fs_set_inode_bmap(int inode_no, unsigned char *buffer, int index)
 		return -1;
 
 	*ptr = *ptr | operand;
+	get_fs()->bmap_dirty[index] |= EXT4_BMAP_INODE_DIRTY;
 
 	return 0;
 }
@@ -400,6 +480,9 @@ void ext4fs_reset_inode_bmap(int inode_no, unsigned char *buffer, int index)
 	unsigned char *ptr = buffer;
 	unsigned char operand;
 
+	if (!buffer)
+		return;
+	get_fs()->bmap_dirty[index] |= EXT4_BMAP_INODE_DIRTY;
 	inode_no -= (index * le32_to_cpu(ext4fs_root->sblock.inodes_per_group));
 	i = inode_no / 8;
 	remainder = inode_no % 8;
@@ -958,9 +1041,9 @@ uint32_t ext4fs_get_new_blk_no(void)
 	static int prev_bg_bitmap_index = -1;
 	unsigned int blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
 	struct ext_filesystem *fs = get_fs();
+	unsigned char *bmap;
 	char *journal_buffer = zalloc(fs->blksz);
-	char *zero_buffer = zalloc(fs->blksz);
-	if (!journal_buffer || !zero_buffer)
+	if (!journal_buffer)
 		goto fail;
 
 	if (fs->first_pass_bbmap == 0) {
@@ -968,22 +1051,16 @@ uint32_t ext4fs_get_new_blk_no(void)
 			struct ext2_block_group *bgd = NULL;
 			bgd = ext4fs_get_group_descriptor(fs, i);
 			if (ext4fs_bg_get_free_blocks(bgd, fs)) {
-				uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
 				uint64_t b_bitmap_blk =
 					ext4fs_bg_get_block_id(bgd, fs);
-				if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
-					memcpy(fs->blk_bmaps[i], zero_buffer,
-					       fs->blksz);
-					put_ext4(b_bitmap_blk * fs->blksz,
-						 fs->blk_bmaps[i], fs->blksz);
-					bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
-					ext4fs_bg_set_flags(bgd, bg_flags);
-				}
-				fs->curr_blkno =
-				    _get_new_blk_no(fs->blk_bmaps[i]);
+				bmap = ext4fs_get_alloc_block_bmap(i);
+				if (!bmap)
+					goto fail;
+				fs->curr_blkno = _get_new_blk_no(bmap);
 				if (fs->curr_blkno == -1)
 					/* block bitmap is completely filled */
 					continue;
+				fs->bmap_dirty[i] |= EXT4_BMAP_BLOCK_DIRTY;
 				fs->curr_blkno = fs->curr_blkno +
 						(i * fs->blksz * 8);
 				fs->first_pass_bbmap++;
@@ -1033,18 +1110,12 @@ restart:
 			goto restart;
 		}
 
-		uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
 		uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-		if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
-			memcpy(fs->blk_bmaps[bg_idx], zero_buffer, fs->blksz);
-			put_ext4(b_bitmap_blk * fs->blksz,
-				 zero_buffer, fs->blksz);
-			bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
-			ext4fs_bg_set_flags(bgd, bg_flags);
-		}
+		bmap = ext4fs_get_alloc_block_bmap(bg_idx);
+		if (!bmap)
+			goto fail;
 
-		if (ext4fs_set_block_bmap(fs->curr_blkno, fs->blk_bmaps[bg_idx],
-				   bg_idx) != 0) {
+		if (ext4fs_set_block_bmap(fs->curr_blkno, bmap, bg_idx) != 0) {
 			debug("going for restart for the block no %ld %u\n",
 			      fs->curr_blkno, bg_idx);
 			fs->curr_blkno++;
@@ -1068,16 +1139,102 @@ restart:
 	}
 success:
 	free(journal_buffer);
-	free(zero_buffer);
 
 	return fs->curr_blkno;
 fail:
 	free(journal_buffer);
-	free(zero_buffer);
 
 	return -1;
 }
 
+/*
+ * Allocate a run of up to @max free blocks which follow each other on the
+ * disk, carrying on after the last block allocated. Returns the first block
+ * and sets @count to the number of blocks, or returns -1 if there is no free
+ * block left.
+ */
+long int ext4fs_get_new_blk_run(unsigned int max, unsigned int *count)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_sblock *sblock = &ext4fs_root->sblock;
+	uint32_t blk_per_grp = le32_to_cpu(sblock->blocks_per_group);
+	uint32_t first_data_block = le32_to_cpu(sblock->first_data_block);
+	uint32_t data_blocks = le32_to_cpu(sblock->total_blocks) -
+		first_data_block;
+	struct ext2_block_group *bgd;
+	uint32_t start_idx, bg_idx, bit, first, end, n;
+	unsigned char *bmap;
+	uint64_t b_bitmap_blk;
+	long int blknr = -1;
+	char *journal_buffer;
+	int i;
+
+	journal_buffer = zalloc(fs->blksz);
+	if (!journal_buffer)
+		return -1;
+
+	bit = 0;
+	if (fs->first_pass_bbmap)
+		bit = fs->curr_blkno + 1 - first_data_block;
+	start_idx = bit / blk_per_grp;
+	bit %= blk_per_grp;
+	if (start_idx >= fs->no_blkgrp) {
+		start_idx = 0;
+		bit = 0;
+	}
+
+	for (i = 0; i < fs->no_blkgrp; i++, bit = 0) {
+		bg_idx = (start_idx + i) % fs->no_blkgrp;
+		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
+		if (!ext4fs_bg_get_free_blocks(bgd, fs))
+			continue;
+		bmap = ext4fs_get_alloc_block_bmap(bg_idx);
+		if (!bmap)
+			goto out;
+
+		/* the last group may be shorter than the others */
+		end = min(blk_per_grp, data_blocks - bg_idx * blk_per_grp);
+		while (bit < end) {
+			if (!(bit & 7) && bmap[bit / 8] == 0xff)
+				bit += 8;
+			else if (bmap[bit / 8] & (1 << (bit & 7)))
+				bit++;
+			else
+				break;
+		}
+		if (bit >= end)
+			continue;
+
+		/* journal backup */
+		b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
+		if (!ext4fs_devread(b_bitmap_blk * fs->sect_perblk, 0,
+				    fs->blksz, journal_buffer) ||
+		    ext4fs_log_journal(journal_buffer, b_bitmap_blk))
+			goto out;
+
+		for (first = bit; bit < end && bit - first < max; bit++) {
+			if (bmap[bit / 8] & (1 << (bit & 7)))
+				break;
+			bmap[bit / 8] |= 1 << (bit & 7);
+		}
+		fs->bmap_dirty[bg_idx] |= EXT4_BMAP_BLOCK_DIRTY;
+		for (n = first; n < bit; n++) {
+			ext4fs_bg_free_blocks_dec(bgd, fs);
+			ext4fs_sb_free_blocks_dec(fs->sb);
+		}
+
+		blknr = first_data_block + bg_idx * blk_per_grp + first;
+		*count = bit - first;
+		fs->curr_blkno = blknr + *count - 1;
+		fs->first_pass_bbmap = 1;
+		break;
+	}
+out:
+	free(journal_buffer);
+
+	return blknr;
+}
+
 int ext4fs_get_new_inode_no(void)
 {
 	short i;
@@ -1086,6 +1243,7 @@ int ext4fs_get_new_inode_no(void)
 	static int prev_inode_bitmap_index = -1;
 	unsigned int inodes_per_grp = le32_to_cpu(ext4fs_root->sblock.inodes_per_group);
 	struct ext_filesystem *fs = get_fs();
+	unsigned char *bmap;
 	char *journal_buffer = zalloc(fs->blksz);
 	char *zero_buffer = zalloc(fs->blksz);
 	if (!journal_buffer || !zero_buffer)
@@ -1105,19 +1263,21 @@ int ext4fs_get_new_inode_no(void)
 					ext4fs_bg_get_inode_id(bgd, fs);
 				if (has_gdt_chksum)
 					bgd->bg_itable_unused = free_inodes;
+				bmap = ext4fs_get_inode_bmap(i);
+				if (!bmap)
+					goto fail;
 				if (bg_flags & EXT4_BG_INODE_UNINIT) {
 					put_ext4(i_bitmap_blk * fs->blksz,
 						 zero_buffer, fs->blksz);
 					bg_flags &= ~EXT4_BG_INODE_UNINIT;
 					ext4fs_bg_set_flags(bgd, bg_flags);
-					memcpy(fs->inode_bmaps[i],
-					       zero_buffer, fs->blksz);
+					memcpy(bmap, zero_buffer, fs->blksz);
 				}
-				fs->curr_inode_no =
-				    _get_new_inode_no(fs->inode_bmaps[i]);
+				fs->curr_inode_no = _get_new_inode_no(bmap);
 				if (fs->curr_inode_no == -1)
 					/* inode bitmap is completely filled */
 					continue;
+				fs->bmap_dirty[i] |= EXT4_BMAP_INODE_DIRTY;
 				fs->curr_inode_no = fs->curr_inode_no +
 							(i * inodes_per_grp);
 				fs->first_pass_ibmap++;
@@ -1149,17 +1309,18 @@ restart:
 		uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
 		uint64_t i_bitmap_blk = ext4fs_bg_get_inode_id(bgd, fs);
 
+		bmap = ext4fs_get_inode_bmap(ibmap_idx);
+		if (!bmap)
+			goto fail;
 		if (bg_flags & EXT4_BG_INODE_UNINIT) {
 			put_ext4(i_bitmap_blk * fs->blksz,
 				 zero_buffer, fs->blksz);
 			bg_flags &= ~EXT4_BG_INODE_UNINIT;
 			ext4fs_bg_set_flags(bgd, bg_flags);
-			memcpy(fs->inode_bmaps[ibmap_idx], zero_buffer,
-				fs->blksz);
+			memcpy(bmap, zero_buffer, fs->blksz);
 		}
 
-		if (ext4fs_set_inode_bmap(fs->curr_inode_no,
-					  fs->inode_bmaps[ibmap_idx],
+		if (ext4fs_set_inode_bmap(fs->curr_inode_no, bmap,
 					  ibmap_idx) != 0) {
 			debug("going for restart for the block no %d %u\n",
 			      fs->curr_inode_no, ibmap_idx);
@@ -1514,6 +1675,113 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 	*total_no_of_block += no_blks_reqd;
 }
 
+/*
+ * Allocate the blocks of a new file in as few runs as possible and describe
+ * them with extents. Up to EXT4_EXT_ROOT_ENTRIES extents are held in the
+ * inode; more are put in leaf blocks, which the inode points to.
+ */
+int ext4fs_allocate_extents(struct ext2_inode *file_inode,
+			    unsigned int total_remaining_blocks,
+			    unsigned int *total_no_of_block)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext4_extent_header *eh =
+		(struct ext4_extent_header *)file_inode->b.blocks.dir_blocks;
+	unsigned int per_leaf = (fs->blksz - sizeof(*eh)) /
+		sizeof(struct ext4_extent);
+	unsigned int max_extents = EXT4_EXT_ROOT_ENTRIES * per_leaf;
+	struct ext4_extent_header *leaf = NULL;
+	struct ext4_extent_idx *idx;
+	struct ext4_extent *extents, *ext;
+	unsigned int nr = 0, fileblock = 0;
+	unsigned int count, len = 0, i;
+	uint64_t start = 0;
+	long int blknr;
+	uint32_t leaf_blk;
+	int ret = -1;
+
+	extents = zalloc(max_extents * sizeof(*extents));
+	if (!extents)
+		return -ENOMEM;
+
+	while (total_remaining_blocks) {
+		count = min(total_remaining_blocks,
+			    (unsigned int)EXT4_EXT_MAX_LEN);
+		blknr = ext4fs_get_new_blk_run(count, &count);
+		if (blknr == -1) {
+			printf("no block left to assign\n");
+			goto fail;
+		}
+		debug("EXT %ld: %u\n", blknr, count);
+
+		/* a run which carries on from the last one extends it */
+		ext = nr ? &extents[nr - 1] : NULL;
+		if (ext) {
+			len = le16_to_cpu(ext->ee_len);
+			start = le16_to_cpu(ext->ee_start_hi);
+			start = (start << 32) + le32_to_cpu(ext->ee_start_lo);
+		}
+		if (ext && start + len == blknr &&
+		    len + count <= EXT4_EXT_MAX_LEN) {
+			ext->ee_len = cpu_to_le16(len + count);
+		} else {
+			if (nr == max_extents) {
+				printf("file is too fragmented\n");
+				goto fail;
+			}
+			ext = &extents[nr++];
+			ext->ee_block = cpu_to_le32(fileblock);
+			ext->ee_len = cpu_to_le16(count);
+			ext->ee_start_hi = cpu_to_le16((uint64_t)blknr >> 32);
+			ext->ee_start_lo = cpu_to_le32(blknr);
+		}
+		fileblock += count;
+		total_remaining_blocks -= count;
+	}
+
+	memset(eh, '\0', sizeof(file_inode->b));
+	eh->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+	eh->eh_max = cpu_to_le16(EXT4_EXT_ROOT_ENTRIES);
+	if (nr <= EXT4_EXT_ROOT_ENTRIES) {
+		eh->eh_entries = cpu_to_le16(nr);
+		memcpy(eh + 1, extents, nr * sizeof(*extents));
+	} else {
+		leaf = zalloc(fs->blksz);
+		if (!leaf)
+			goto fail;
+		idx = (struct ext4_extent_idx *)(eh + 1);
+		for (i = 0; i * per_leaf < nr; i++) {
+			count = min(nr - i * per_leaf, per_leaf);
+			leaf_blk = ext4fs_get_new_blk_no();
+			if (leaf_blk == -1) {
+				printf("no block left to assign\n");
+				goto fail;
+			}
+			debug("EXTL %u: %u\n", leaf_blk, count);
+			memset(leaf, '\0', fs->blksz);
+			leaf->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+			leaf->eh_entries = cpu_to_le16(count);
+			leaf->eh_max = cpu_to_le16(per_leaf);
+			memcpy(leaf + 1, &extents[i * per_leaf],
+			       count * sizeof(*extents));
+			put_ext4((uint64_t)leaf_blk * fs->blksz, leaf,
+				 fs->blksz);
+			idx[i].ei_block = extents[i * per_leaf].ee_block;
+			idx[i].ei_leaf_lo = cpu_to_le32(leaf_blk);
+			(*total_no_of_block)++;
+		}
+		eh->eh_entries = cpu_to_le16(i);
+		eh->eh_depth = cpu_to_le16(1);
+	}
+	file_inode->flags |= cpu_to_le32(EXT4_EXTENTS_FL);
+	ret = 0;
+fail:
+	free(leaf);
+	free(extents);
+
+	return ret;
+}
+
 #endif
 
 static struct ext4_extent_header *ext4fs_get_extent_block
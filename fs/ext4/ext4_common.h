@@ -41,6 +41,10 @@
 #define SUPERBLOCK_SIZE	1024
 #define F_FILE			1
 
+/* Flags in ext_filesystem.bmap_dirty */
+#define EXT4_BMAP_BLOCK_DIRTY	(1 << 0)
+#define EXT4_BMAP_INODE_DIRTY	(1 << 1)
+
 static inline void *zalloc(size_t size)
 {
 	void *p = memalign(ARCH_DMA_MINALIGN, size);
@@ -63,6 +67,9 @@ uint16_t ext4fs_checksum_update(unsigned int i);
 int ext4fs_get_parent_inode_num(const char *dirname, char *dname, int flags);
 int ext4fs_update_parent_dentry(char *filename, int file_type);
 uint32_t ext4fs_get_new_blk_no(void);
+long int ext4fs_get_new_blk_run(unsigned int max, unsigned int *count);
+unsigned char *ext4fs_get_block_bmap(int index);
+unsigned char *ext4fs_get_inode_bmap(int index);
 int ext4fs_get_new_inode_no(void);
 void ext4fs_reset_block_bmap(long int blockno, unsigned char *buffer,
 					int index);
@@ -73,6 +80,9 @@ int ext4fs_iget(int inode_no, struct ext2_inode *inode);
 void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 				unsigned int total_remaining_blocks,
 				unsigned int *total_no_of_block);
+int ext4fs_allocate_extents(struct ext2_inode *file_inode,
+			    unsigned int total_remaining_blocks,
+			    unsigned int *total_no_of_block);
 void put_ext4(uint64_t off, void *buf, uint32_t size);
 struct ext2_block_group *ext4fs_get_group_descriptor
 	(const struct ext_filesystem *fs, uint32_t bg_idx);
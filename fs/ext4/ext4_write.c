@@ -66,7 +66,7 @@ static inline void ext4fs_bg_free_blocks_inc
 
 static void ext4fs_update(void)
 {
-	short i;
+	int i;
 	ext4fs_update_journal();
 	struct ext_filesystem *fs = get_fs();
 	struct ext2_block_group *bgd = NULL;
@@ -75,21 +75,21 @@ static void ext4fs_update(void)
 	put_ext4((uint64_t)(SUPERBLOCK_SIZE),
 		 (struct ext2_sblock *)fs->sb, (uint32_t)SUPERBLOCK_SIZE);
 
-	/* update block bitmaps */
+	/* update the bitmaps which were changed */
 	for (i = 0; i < fs->no_blkgrp; i++) {
 		bgd = ext4fs_get_group_descriptor(fs, i);
 		bgd->bg_checksum = cpu_to_le16(ext4fs_checksum_update(i));
-		uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-		put_ext4(b_bitmap_blk * fs->blksz,
-			 fs->blk_bmaps[i], fs->blksz);
-	}
-
-	/* update inode bitmaps */
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		bgd = ext4fs_get_group_descriptor(fs, i);
-		uint64_t i_bitmap_blk = ext4fs_bg_get_inode_id(bgd, fs);
-		put_ext4(i_bitmap_blk * fs->blksz,
-			 fs->inode_bmaps[i], fs->blksz);
+		if (fs->bmap_dirty[i] & EXT4_BMAP_BLOCK_DIRTY) {
+			uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
+			put_ext4(b_bitmap_blk * fs->blksz,
+				 fs->blk_bmaps[i], fs->blksz);
+		}
+		if (fs->bmap_dirty[i] & EXT4_BMAP_INODE_DIRTY) {
+			uint64_t i_bitmap_blk = ext4fs_bg_get_inode_id(bgd, fs);
+			put_ext4(i_bitmap_blk * fs->blksz,
+				 fs->inode_bmaps[i], fs->blksz);
+		}
+		fs->bmap_dirty[i] = 0;
 	}
 
 	/* update the block group descriptor table */
@@ -159,7 +159,8 @@ static void delete_single_indirect_block(struct ext2_inode *inode)
 			if (!remainder)
 				bg_idx--;
 		}
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx], bg_idx);
+		ext4fs_reset_block_bmap(blknr, ext4fs_get_block_bmap(bg_idx),
+					bg_idx);
 		/* get  block group descriptor table */
 		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
 		ext4fs_bg_free_blocks_inc(bgd, fs);
@@ -224,7 +225,8 @@ static void delete_double_indirect_block(struct ext2_inode *inode)
 			/* get  block group descriptor table */
 			bgd = ext4fs_get_group_descriptor(fs, bg_idx);
 			ext4fs_reset_block_bmap(le32_to_cpu(*di_buffer),
-					fs->blk_bmaps[bg_idx], bg_idx);
+					ext4fs_get_block_bmap(bg_idx),
+					bg_idx);
 			di_buffer++;
 			ext4fs_bg_free_blocks_inc(bgd, fs);
 			ext4fs_sb_free_blocks_inc(fs->sb);
@@ -256,7 +258,8 @@ static void delete_double_indirect_block(struct ext2_inode *inode)
 		}
 		/* get  block group descriptor table */
 		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx], bg_idx);
+		ext4fs_reset_block_bmap(blknr, ext4fs_get_block_bmap(bg_idx),
+					bg_idx);
 		ext4fs_bg_free_blocks_inc(bgd, fs);
 		ext4fs_sb_free_blocks_inc(fs->sb);
 		/* journal backup */
@@ -332,8 +335,7 @@ static void delete_triple_indirect_block(struct ext2_inode *inode)
 				}
 
 				ext4fs_reset_block_bmap(le32_to_cpu(*tip_buffer),
-							fs->blk_bmaps[bg_idx],
-							bg_idx);
+					ext4fs_get_block_bmap(bg_idx), bg_idx);
 
 				tip_buffer++;
 				/* get  block group descriptor table */
@@ -373,7 +375,8 @@ static void delete_triple_indirect_block(struct ext2_inode *inode)
 					bg_idx--;
 			}
 			ext4fs_reset_block_bmap(le32_to_cpu(*tigp_buffer),
-						fs->blk_bmaps[bg_idx], bg_idx);
+						ext4fs_get_block_bmap(bg_idx),
+						bg_idx);
 
 			tigp_buffer++;
 			/* get  block group descriptor table */
@@ -407,7 +410,8 @@ static void delete_triple_indirect_block(struct ext2_inode *inode)
 			if (!remainder)
 				bg_idx--;
 		}
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx], bg_idx);
+		ext4fs_reset_block_bmap(blknr, ext4fs_get_block_bmap(bg_idx),
+					bg_idx);
 		/* get  block group descriptor table */
 		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
 		ext4fs_bg_free_blocks_inc(bgd, fs);
@@ -432,6 +436,76 @@ fail:
 	free(journal_buffer);
 }
 
+/* Release a block of metadata which belongs to a file being deleted */
+static int ext4fs_release_block(uint64_t blknr)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_sblock *sblock = &ext4fs_root->sblock;
+	uint32_t bg_idx;
+	struct ext2_block_group *bgd;
+	uint64_t b_bitmap_blk;
+	char *journal_buffer;
+	int ret = -1;
+
+	bg_idx = lldiv(blknr - le32_to_cpu(sblock->first_data_block),
+		       le32_to_cpu(sblock->blocks_per_group));
+	bgd = ext4fs_get_group_descriptor(fs, bg_idx);
+	b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
+
+	/* journal backup */
+	journal_buffer = zalloc(fs->blksz);
+	if (!journal_buffer)
+		return -ENOMEM;
+	if (!ext4fs_devread(b_bitmap_blk * fs->sect_perblk, 0, fs->blksz,
+			    journal_buffer) ||
+	    ext4fs_log_journal(journal_buffer, b_bitmap_blk))
+		goto fail;
+
+	ext4fs_reset_block_bmap(blknr, ext4fs_get_block_bmap(bg_idx), bg_idx);
+	ext4fs_bg_free_blocks_inc(bgd, fs);
+	ext4fs_sb_free_blocks_inc(fs->sb);
+	ret = 0;
+fail:
+	free(journal_buffer);
+
+	return ret;
+}
+
+/* Release the index and leaf blocks below an extent tree node */
+static int delete_extent_index_blocks(struct ext4_extent_header *eh)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext4_extent_idx *idx = (struct ext4_extent_idx *)(eh + 1);
+	char *buf;
+	uint64_t blknr;
+	int i, ret = 0;
+
+	if (le16_to_cpu(eh->eh_magic) != EXT4_EXT_MAGIC)
+		return -EINVAL;
+	if (!eh->eh_depth)
+		return 0;
+
+	buf = zalloc(fs->blksz);
+	if (!buf)
+		return -ENOMEM;
+	for (i = 0; !ret && i < le16_to_cpu(eh->eh_entries); i++) {
+		blknr = ((uint64_t)le16_to_cpu(idx[i].ei_leaf_hi) << 32) +
+			le32_to_cpu(idx[i].ei_leaf_lo);
+		debug("EXTI releasing %llu\n", blknr);
+		if (!ext4fs_devread(blknr * fs->sect_perblk, 0, fs->blksz,
+				    buf))
+			ret = -EIO;
+		else
+			ret = delete_extent_index_blocks(
+					(struct ext4_extent_header *)buf);
+		if (!ret)
+			ret = ext4fs_release_block(blknr);
+	}
+	free(buf);
+
+	return ret;
+}
+
 static int ext4fs_delete_file(int inodeno)
 {
 	struct ext2_inode inode;
@@ -467,11 +541,12 @@ static int ext4fs_delete_file(int inodeno)
 		no_blocks++;
 
 	if (le32_to_cpu(inode.flags) & EXT4_EXTENTS_FL) {
-		/* FIXME delete extent index blocks, i.e. eh_depth >= 1 */
 		struct ext4_extent_header *eh =
 			(struct ext4_extent_header *)
 				inode.b.blocks.dir_blocks;
 		debug("del: dep=%d entries=%d\n", eh->eh_depth, eh->eh_entries);
+		if (delete_extent_index_blocks(eh))
+			goto fail;
 	} else {
 		delete_single_indirect_block(&inode);
 		delete_double_indirect_block(&inode);
@@ -491,7 +566,7 @@ static int ext4fs_delete_file(int inodeno)
 			if (!remainder)
 				bg_idx--;
 		}
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx],
+		ext4fs_reset_block_bmap(blknr, ext4fs_get_block_bmap(bg_idx),
 					bg_idx);
 		debug("EXT4 Block releasing %ld: %d\n", blknr, bg_idx);
 
@@ -551,7 +626,8 @@ static int ext4fs_delete_file(int inodeno)
 
 	/* update the respective inode bitmaps */
 	inodeno++;
-	ext4fs_reset_inode_bmap(inodeno, fs->inode_bmaps[ibmap_idx], ibmap_idx);
+	ext4fs_reset_inode_bmap(inodeno, ext4fs_get_inode_bmap(ibmap_idx),
+				ibmap_idx);
 	ext4fs_bg_free_inodes_inc(bgd, fs);
 	ext4fs_sb_free_inodes_inc(fs->sb);
 	/* journal backup */
@@ -585,7 +661,6 @@ fail:
 
 int ext4fs_init(void)
 {
-	short status;
 	int i;
 	uint32_t real_free_blocks = 0;
 	struct ext_filesystem *fs = get_fs();
@@ -618,46 +693,12 @@ int ext4fs_init(void)
 		goto fail;
 	}
 
-	/* load all the available bitmap block of the partition */
+	/* bitmaps are only read when their block group is used */
 	fs->blk_bmaps = zalloc(fs->no_blkgrp * sizeof(char *));
-	if (!fs->blk_bmaps)
-		goto fail;
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		fs->blk_bmaps[i] = zalloc(fs->blksz);
-		if (!fs->blk_bmaps[i])
-			goto fail;
-	}
-
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		struct ext2_block_group *bgd =
-			ext4fs_get_group_descriptor(fs, i);
-		status = ext4fs_devread(ext4fs_bg_get_block_id(bgd, fs) *
-				   fs->sect_perblk, 0,
-				   fs->blksz, (char *)fs->blk_bmaps[i]);
-		if (status == 0)
-			goto fail;
-	}
-
-	/* load all the available inode bitmap of the partition */
 	fs->inode_bmaps = zalloc(fs->no_blkgrp * sizeof(unsigned char *));
-	if (!fs->inode_bmaps)
+	fs->bmap_dirty = zalloc(fs->no_blkgrp);
+	if (!fs->blk_bmaps || !fs->inode_bmaps || !fs->bmap_dirty)
 		goto fail;
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		fs->inode_bmaps[i] = zalloc(fs->blksz);
-		if (!fs->inode_bmaps[i])
-			goto fail;
-	}
-
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		struct ext2_block_group *bgd =
-			ext4fs_get_group_descriptor(fs, i);
-		status = ext4fs_devread(ext4fs_bg_get_inode_id(bgd, fs) *
-					fs->sect_perblk,
-					0, fs->blksz,
-					(char *)fs->inode_bmaps[i]);
-		if (status == 0)
-			goto fail;
-	}
 
 	/*
 	 * check filesystem consistency with free blocks of file system
@@ -734,7 +775,8 @@ void ext4fs_deinit(void)
 		free(fs->inode_bmaps);
 		fs->inode_bmaps = NULL;
 	}
-
+	free(fs->bmap_dirty);
+	fs->bmap_dirty = NULL;
 
 	free(fs->gdtable);
 	fs->gdtable = NULL;
@@ -920,8 +962,15 @@ int ext4fs_write(const char *fname, unsigned char *buffer,
 	file_inode->size = cpu_to_le32(sizebytes);
 
 	/* Allocate data blocks */
-	ext4fs_allocate_blocks(file_inode, blocks_remaining,
-			       &blks_reqd_for_file);
+	if (le32_to_cpu(fs->sb->feature_incompat) &
+	    EXT4_FEATURE_INCOMPAT_EXTENTS) {
+		if (ext4fs_allocate_extents(file_inode, blocks_remaining,
+					    &blks_reqd_for_file))
+			goto fail;
+	} else {
+		ext4fs_allocate_blocks(file_inode, blocks_remaining,
+				       &blks_reqd_for_file);
+	}
 	file_inode->blockcnt = cpu_to_le32((blks_reqd_for_file * fs->blksz) >>
 		fs->dev_desc->log2blksz);
 
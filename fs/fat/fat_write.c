@@ -101,57 +101,183 @@ static void set_name(dir_entry *dirent, const char *filename)
 }
 
 static __u8 num_of_fats;
+
 /*
- * Write fat buffer into block device
+ * While writing, the FAT is cached in windows of FAT_CACHE_BLOCKS sectors, a
+ * multiple of three so that no FAT12 entry is split between two windows.
+ * Changed sectors are written back, to every copy of the FAT, only when their
+ * window is reused or at the end of the operation.
+ */
+#define FAT_CACHE_BLOCKS	48
+#define FAT_CACHE_WINDOWS	8
+#define FAT_CACHE_SIZE		(mydata->sect_size * FAT_CACHE_BLOCKS)
+
+struct fat_cache_window {
+	__u8 *buf;
+	int bufnum;		/* window of the FAT held, or -1 */
+	__u64 dirty;		/* one bit for each sector changed */
+	__u32 last_used;
+};
+
+static struct fat_cache_window fat_cache[FAT_CACHE_WINDOWS];
+static __u32 fat_cache_tick;
+
+/*
+ * Which clusters are in use, built from the FAT a window at a time as the
+ * allocator reaches it. Bits are only valid in windows marked in 'filled'.
+ */
+static struct {
+	__u8 *used;
+	__u8 *filled;
+	__u32 count;		/* number of clusters, including 0 and 1 */
+	__u32 next;		/* where to look for a free cluster next */
+	int free_delta;		/* change in the number of free clusters */
+} fat_space;
+
+/*
+ * Write the changed sectors of a window of the FAT to the block device
+ */
+static int fat_cache_flush_window(fsdata *mydata, struct fat_cache_window *win)
+{
+	__u32 startblock = win->bufnum * FAT_CACHE_BLOCKS;
+	int first, last, i;
+
+	debug("debug: evicting %d, dirty: %llx\n", win->bufnum,
+	      (unsigned long long)win->dirty);
+
+	for (first = 0; win->dirty; first = last) {
+		while (!(win->dirty & (1ULL << first)))
+			first++;
+		for (last = first; win->dirty & (1ULL << last); last++)
+			win->dirty &= ~(1ULL << last);
+
+		for (i = 0; i < num_of_fats; i++) {
+			__u32 sect = mydata->fat_sect + i * mydata->fatlength +
+				startblock + first;
+
+			if (disk_write(sect, last - first, win->buf +
+				       first * mydata->sect_size) < 0) {
+				debug("error: writing FAT blocks\n");
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Write all the changed FAT sectors into block device
  */
 static int flush_dirty_fat_buffer(fsdata *mydata)
 {
-	int getsize = FATBUFBLOCKS;
-	__u32 fatlength = mydata->fatlength;
-	__u8 *bufptr = mydata->fatbuf;
-	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS;
+	int i;
 
-	debug("debug: evicting %d, dirty: %d\n", mydata->fatbufnum,
-	      (int)mydata->fat_dirty);
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		if (fat_cache[i].bufnum != -1 &&
+		    fat_cache_flush_window(mydata, &fat_cache[i]) < 0)
+			return -1;
+	}
 
-	if ((!mydata->fat_dirty) || (mydata->fatbufnum == -1))
-		return 0;
+	return 0;
+}
 
-	startblock += mydata->fat_sect;
+/*
+ * Get a window of the FAT, reading it into the least recently used slot of
+ * the cache if it is not there already
+ */
+static struct fat_cache_window *fat_cache_get(fsdata *mydata, __u32 bufnum)
+{
+	struct fat_cache_window *win = &fat_cache[0];
+	__u32 startblock = bufnum * FAT_CACHE_BLOCKS;
+	int getsize = FAT_CACHE_BLOCKS;
+	int i;
 
-	if (getsize > fatlength)
-		getsize = fatlength;
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		if (fat_cache[i].bufnum == bufnum) {
+			win = &fat_cache[i];
+			goto found;
+		}
+		if (fat_cache[i].last_used < win->last_used)
+			win = &fat_cache[i];
+	}
 
-	/* Write FAT buf */
-	if (disk_write(startblock, getsize, bufptr) < 0) {
-		debug("error: writing FAT blocks\n");
-		return -1;
+	if (startblock >= mydata->fatlength)
+		return NULL;
+	if (startblock + getsize > mydata->fatlength)
+		getsize = mydata->fatlength - startblock;
+
+	/* Write back the window being replaced */
+	if (win->bufnum != -1 && fat_cache_flush_window(mydata, win) < 0)
+		return NULL;
+	win->bufnum = -1;
+	if (disk_read(mydata->fat_sect + startblock, getsize, win->buf) < 0) {
+		debug("Error reading FAT blocks\n");
+		return NULL;
 	}
+	win->bufnum = bufnum;
+found:
+	win->last_used = ++fat_cache_tick;
 
-	if (num_of_fats == 2) {
-		/* Update corresponding second FAT blocks */
-		startblock += mydata->fatlength;
-		if (disk_write(startblock, getsize, bufptr) < 0) {
-			debug("error: writing second FAT blocks\n");
+	return win;
+}
+
+static int fat_cache_init(fsdata *mydata)
+{
+	int i;
+
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		fat_cache[i].buf = memalign(ARCH_DMA_MINALIGN, FAT_CACHE_SIZE);
+		fat_cache[i].bufnum = -1;
+		fat_cache[i].dirty = 0;
+		fat_cache[i].last_used = 0;
+		if (!fat_cache[i].buf)
 			return -1;
-		}
 	}
-	mydata->fat_dirty = 0;
+	fat_cache_tick = 0;
 
 	return 0;
 }
 
+static void fat_cache_release(void)
+{
+	int i;
+
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		free(fat_cache[i].buf);
+		fat_cache[i].buf = NULL;
+	}
+	free(fat_space.used);
+	free(fat_space.filled);
+	fat_space.used = NULL;
+	fat_space.filled = NULL;
+}
+
+/* Number of FAT entries held in each window of the cache */
+static __u32 fat_cache_entries(fsdata *mydata)
+{
+	switch (mydata->fatsize) {
+	case 32:
+		return FAT_CACHE_SIZE / 4;
+	case 16:
+		return FAT_CACHE_SIZE / 2;
+	default:
+		return FAT_CACHE_SIZE * 2 / 3;
+	}
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
- * When bufnum is changed, write back the previous fatbuf to the disk.
  */
 static __u32 get_fatent_value(fsdata *mydata, __u32 entry)
 {
+	struct fat_cache_window *win;
 	__u32 bufnum;
 	__u32 off16, offset;
 	__u32 ret = 0x00;
 	__u16 val1, val2;
+	__u8 *buf;
 
 	if (CHECK_CLUST(entry, mydata->fatsize)) {
 		printf("Error: Invalid FAT entry: 0x%08x\n", entry);
@@ -160,16 +286,10 @@ static __u32 get_fatent_value(fsdata *mydata, __u32 entry)
 
 	switch (mydata->fatsize) {
 	case 32:
-		bufnum = entry / FAT32BUFSIZE;
-		offset = entry - bufnum * FAT32BUFSIZE;
-		break;
 	case 16:
-		bufnum = entry / FAT16BUFSIZE;
-		offset = entry - bufnum * FAT16BUFSIZE;
-		break;
 	case 12:
-		bufnum = entry / FAT12BUFSIZE;
-		offset = entry - bufnum * FAT12BUFSIZE;
+		bufnum = entry / fat_cache_entries(mydata);
+		offset = entry - bufnum * fat_cache_entries(mydata);
 		break;
 
 	default:
@@ -180,61 +300,43 @@ static __u32 get_fatent_value(fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%04x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		int getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		if (getsize > fatlength)
-			getsize = fatlength;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		/* Write back the fatbuf to the disk */
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return ret;
-		}
-		mydata->fatbufnum = bufnum;
-	}
+	win = fat_cache_get(mydata, bufnum);
+	if (!win)
+		return ret;
+	buf = win->buf;
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)buf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)buf)[offset]);
 		break;
 	case 12:
 		off16 = (offset * 3) / 4;
 
 		switch (offset & 0x3) {
 		case 0:
-			ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[off16]);
+			ret = FAT2CPU16(((__u16 *)buf)[off16]);
 			ret &= 0xfff;
 			break;
 		case 1:
-			val1 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			val1 = FAT2CPU16(((__u16 *)buf)[off16]);
 			val1 &= 0xf000;
-			val2 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16 + 1]);
+			val2 = FAT2CPU16(((__u16 *)buf)[off16 + 1]);
 			val2 &= 0x00ff;
 			ret = (val2 << 4) | (val1 >> 12);
 			break;
 		case 2:
-			val1 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			val1 = FAT2CPU16(((__u16 *)buf)[off16]);
 			val1 &= 0xff00;
-			val2 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16 + 1]);
+			val2 = FAT2CPU16(((__u16 *)buf)[off16 + 1]);
 			val2 &= 0x000f;
 			ret = (val2 << 8) | (val1 >> 8);
 			break;
 		case 3:
-			ret = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			ret = FAT2CPU16(((__u16 *)buf)[off16]);
 			ret = (ret & 0xfff0) >> 4;
 			break;
 		default:
@@ -465,89 +567,156 @@ get_long_file_name(fsdata *mydata, int curclust, __u8 *cluster,
 	return 0;
 }
 
+/*
+ * Read the FAT entries of the window holding 'clust' into the bitmap of
+ * clusters in use, if that has not been done yet
+ */
+static int fat_space_fill(fsdata *mydata, __u32 clust)
+{
+	__u32 per_window = fat_cache_entries(mydata);
+	__u32 window = clust / per_window;
+	__u32 entry, end;
+
+	if (fat_space.filled[window / 8] & (1 << (window % 8)))
+		return 0;
+
+	entry = max(window * per_window, (__u32)2);
+	end = min((window + 1) * per_window, fat_space.count);
+	for (; entry < end; entry++) {
+		if (get_fatent_value(mydata, entry))
+			fat_space.used[entry / 8] |= 1 << (entry % 8);
+	}
+	fat_space.filled[window / 8] |= 1 << (window % 8);
+
+	return 0;
+}
+
+static int fat_clust_used(fsdata *mydata, __u32 clust)
+{
+	fat_space_fill(mydata, clust);
+
+	return fat_space.used[clust / 8] & (1 << (clust % 8));
+}
+
+static int fat_space_init(fsdata *mydata, __u32 hint)
+{
+	__u32 windows, entries;
+
+	/*
+	 * data_begin is two clusters before the first data cluster, so this
+	 * is already one more than the highest cluster number. Not more
+	 * clusters than the FAT has entries for, though.
+	 */
+	entries = mydata->fatlength * mydata->sect_size * 8 / mydata->fatsize;
+	fat_space.count = (total_sector - mydata->data_begin) /
+		mydata->clust_size;
+	fat_space.count = min(fat_space.count, entries);
+	windows = DIV_ROUND_UP(fat_space.count, fat_cache_entries(mydata));
+	fat_space.used = calloc(DIV_ROUND_UP(fat_space.count, 8), 1);
+	fat_space.filled = calloc(DIV_ROUND_UP(windows, 8), 1);
+	if (!fat_space.used || !fat_space.filled)
+		return -1;
+	fat_space.next = hint >= 2 && hint < fat_space.count ? hint : 2;
+	fat_space.free_delta = 0;
+
+	return 0;
+}
+
 /*
  * Set the entry at index 'entry' in a FAT (16/32) table.
  */
 static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 {
-	__u32 bufnum, offset;
+	struct fat_cache_window *win;
+	__u32 bufnum, offset, old;
 
 	switch (mydata->fatsize) {
 	case 32:
-		bufnum = entry / FAT32BUFSIZE;
-		offset = entry - bufnum * FAT32BUFSIZE;
-		break;
 	case 16:
-		bufnum = entry / FAT16BUFSIZE;
-		offset = entry - bufnum * FAT16BUFSIZE;
+		bufnum = entry / fat_cache_entries(mydata);
+		offset = entry - bufnum * fat_cache_entries(mydata);
 		break;
 	default:
 		/* Unsupported FAT size */
 		return -1;
 	}
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		int getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		fatlength *= mydata->sect_size;
-		startblock += mydata->fat_sect;
-
-		if (getsize > fatlength)
-			getsize = fatlength;
-
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return -1;
-		}
-		mydata->fatbufnum = bufnum;
+	if (entry >= fat_space.count) {
+		printf("Error: Invalid FAT entry: 0x%08x\n", entry);
+		return -1;
 	}
+	old = get_fatent_value(mydata, entry);
+	win = fat_cache_get(mydata, bufnum);
+	if (!win)
+		return -1;
 
-	/* Mark as dirty */
-	mydata->fat_dirty = 1;
+	/* Mark the sector as dirty */
+	win->dirty |= 1ULL << (offset * mydata->fatsize / 8 /
+			       mydata->sect_size);
 
 	/* Set the actual entry */
 	switch (mydata->fatsize) {
 	case 32:
-		((__u32 *) mydata->fatbuf)[offset] = cpu_to_le32(entry_value);
+		((__u32 *)win->buf)[offset] = cpu_to_le32(entry_value);
 		break;
 	case 16:
-		((__u16 *) mydata->fatbuf)[offset] = cpu_to_le16(entry_value);
+		((__u16 *)win->buf)[offset] = cpu_to_le16(entry_value);
 		break;
 	default:
 		return -1;
 	}
 
+	/* Keep the bitmap of clusters in use up to date */
+	if (!old && entry_value) {
+		fat_space.used[entry / 8] |= 1 << (entry % 8);
+		fat_space.free_delta--;
+	} else if (old && !entry_value) {
+		fat_space.used[entry / 8] &= ~(1 << (entry % 8));
+		fat_space.free_delta++;
+	}
+
 	return 0;
 }
 
 /*
- * Determine the next free cluster after 'entry' in a FAT (16/32) table
- * and link it to 'entry'. EOC marker is not set on returned entry.
+ * Find the first free cluster from 'start' on, going back to the start of
+ * the FAT if needed. Return 0 if the filesystem is full.
  */
-static __u32 determine_fatent(fsdata *mydata, __u32 entry)
+static __u32 find_free_cluster(fsdata *mydata, __u32 start)
 {
-	__u32 next_fat, next_entry = entry + 1;
-
-	while (1) {
-		next_fat = get_fatent_value(mydata, next_entry);
-		if (next_fat == 0) {
-			/* found free entry, link to entry */
-			set_fatent_value(mydata, entry, next_entry);
-			break;
+	__u32 clust = start, i;
+
+	for (i = 2; i < fat_space.count; i++, clust++) {
+		if (clust >= fat_space.count)
+			clust = 2;
+		/* Skip over bytes of clusters which are all in use */
+		if (!(clust % 8) && clust + 8 <= fat_space.count) {
+			fat_space_fill(mydata, clust);
+			if (fat_space.used[clust / 8] == 0xff) {
+				clust += 7;
+				i += 7;
+				continue;
+			}
 		}
-		next_entry++;
+		if (!fat_clust_used(mydata, clust))
+			return clust;
 	}
-	debug("FAT%d: entry: %08x, entry_value: %04x\n",
-	       mydata->fatsize, entry, next_entry);
 
-	return next_entry;
+	return 0;
+}
+
+/*
+ * Count the free clusters from 'clust' on, up to 'max'
+ */
+static __u32 count_free_run(fsdata *mydata, __u32 clust, __u32 max)
+{
+	__u32 count = 0;
+
+	while (count < max && clust + count < fat_space.count &&
+	       !fat_clust_used(mydata, clust + count))
+		count++;
+
+	return count;
 }
 
 /*
@@ -615,18 +784,16 @@ set_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer,
 }
 
 /*
- * Find the first empty cluster
+ * Find the first empty cluster, carrying on from the last one allocated.
+ * Return -1 if there is none.
  */
 static int find_empty_cluster(fsdata *mydata)
 {
-	__u32 fat_val, entry = 3;
+	__u32 entry = find_free_cluster(mydata, fat_space.next);
 
-	while (1) {
-		fat_val = get_fatent_value(mydata, entry);
-		if (fat_val == 0)
-			break;
-		entry++;
-	}
+	if (!entry)
+		return -1;
+	fat_space.next = entry + 1;
 
 	return entry;
 }
@@ -645,6 +812,10 @@ static void flush_dir_table(fsdata *mydata, dir_entry **dentptr)
 		return;
 	}
 	dir_newclust = find_empty_cluster(mydata);
+	if (dir_newclust < 0) {
+		printf("error: no free cluster for directory entry\n");
+		return;
+	}
 	set_fatent_value(mydata, dir_curclust, dir_newclust);
 	if (mydata->fatsize == 32)
 		set_fatent_value(mydata, dir_newclust, 0xffffff8);
@@ -653,9 +824,6 @@ static void flush_dir_table(fsdata *mydata, dir_entry **dentptr)
 
 	dir_curclust = dir_newclust;
 
-	if (flush_dirty_fat_buffer(mydata) < 0)
-		return;
-
 	memset(get_dentfromdir_block, 0x00,
 		mydata->clust_size * mydata->sect_size);
 
@@ -682,16 +850,13 @@ static int clear_fatent(fsdata *mydata, __u32 entry)
 		entry = fat_val;
 	}
 
-	/* Flush fat buffer */
-	if (flush_dirty_fat_buffer(mydata) < 0)
-		return -1;
-
 	return 0;
 }
 
 /*
  * Write at most 'maxsize' bytes from 'buffer' into
- * the file associated with 'dentptr'
+ * the file associated with 'dentptr'. The file is given runs of free
+ * clusters which are next to each other, and each run is written at once.
  * Update the number of bytes written in *gotsize and return 0
  * or return -1 on fatal errors.
  */
@@ -702,7 +867,8 @@ set_contents(fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust = 0, newclust = 0;
+	__u32 endclust, newclust, eoc;
+	__u32 clusters, count;
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -721,43 +887,37 @@ set_contents(fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
 		return 0;
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = determine_fatent(mydata, endclust);
-
-			if ((newclust - 1) != endclust)
-				goto getit;
-
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("newclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
+	eoc = mydata->fatsize == 16 ? 0xffff : 0xfffffff;
+	clusters = div_u64(filesize + bytesperclust - 1, bytesperclust);
+	if (!clusters)
+		clusters = 1;
+	while (1) {
+		/* take the free clusters which follow, as far as needed */
+		count = 1 + count_free_run(mydata, curclust + 1, clusters - 1);
+		endclust = curclust + count - 1;
+		debug("run: %u clusters from %u\n", count, curclust);
+		for (newclust = curclust; newclust < endclust; newclust++) {
+			if (set_fatent_value(mydata, newclust, newclust + 1))
+				return -1;
 		}
-
-		/* set remaining bytes */
-		actsize = filesize;
-		if (set_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			debug("error: writing cluster\n");
+		if (set_fatent_value(mydata, endclust, eoc))
 			return -1;
-		}
-		*gotsize += actsize;
+		clusters -= count;
 
-		/* Mark end of file in FAT */
-		if (mydata->fatsize == 16)
-			newclust = 0xffff;
-		else if (mydata->fatsize == 32)
-			newclust = 0xfffffff;
-		set_fatent_value(mydata, endclust, newclust);
+		/* then link the next run, if any */
+		if (clusters) {
+			newclust = find_free_cluster(mydata, endclust + 1);
+			if (!newclust) {
+				printf("Error: no free cluster left\n");
+				return -1;
+			}
+			if (set_fatent_value(mydata, endclust, newclust))
+				return -1;
+		}
+		fat_space.next = endclust + 1;
 
-		return 0;
-getit:
-		if (set_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		actsize = min(filesize, (loff_t)count * bytesperclust);
+		if (set_cluster(mydata, curclust, buffer, actsize) != 0) {
 			debug("error: writing cluster\n");
 			return -1;
 		}
@@ -765,14 +925,10 @@ getit:
 		filesize -= actsize;
 		buffer += actsize;
 
-		if (CHECK_CLUST(newclust, mydata->fatsize)) {
-			debug("newclust: 0x%x\n", newclust);
-			debug("Invalid FAT entry\n");
+		if (!clusters)
 			return 0;
-		}
-		actsize = bytesperclust;
-		curclust = endclust = newclust;
-	} while (1);
+		curclust = newclust;
+	}
 }
 
 /*
@@ -802,29 +958,65 @@ static void fill_dentry(fsdata *mydata, dir_entry *dentptr,
 }
 
 /*
- * Check whether adding a file makes the file system to
- * exceed the size of the block device
- * Return -1 when overflow occurs, otherwise return 0
+ * Count the free clusters, stopping once 'max' have been found
+ */
+static __u32 count_free_clusters(fsdata *mydata, __u32 max)
+{
+	__u32 clust, count = 0;
+
+	for (clust = 2; clust < fat_space.count && count < max; clust++) {
+		/* Count whole bytes of the bitmap where possible */
+		if (!(clust % 8) && clust + 8 <= fat_space.count) {
+			fat_space_fill(mydata, clust);
+			count += 8 - generic_hweight8(fat_space.used[clust / 8]);
+			clust += 7;
+			continue;
+		}
+		if (!fat_clust_used(mydata, clust))
+			count++;
+	}
+
+	return count;
+}
+
+/*
+ * Count the clusters in the chain from 'entry' to the end of a file
  */
-static int check_overflow(fsdata *mydata, __u32 clustnum, loff_t size)
+static __u32 count_fatent(fsdata *mydata, __u32 entry)
 {
-	__u32 startsect, sect_num, offset;
+	__u32 fat_val, count = 0;
 
-	if (clustnum > 0) {
-		startsect = mydata->data_begin +
-				clustnum * mydata->clust_size;
-	} else {
-		startsect = mydata->rootdir_sect;
+	while (entry && count < fat_space.count) {
+		fat_val = get_fatent_value(mydata, entry);
+		if (!fat_val)
+			break;
+		count++;
+		if (fat_val == 0xfffffff || fat_val == 0xffff)
+			break;
+		entry = fat_val;
 	}
 
-	sect_num = div_u64_rem(size, mydata->sect_size, &offset);
+	return count;
+}
+
+/*
+ * Check whether there are enough free clusters to hold 'size' bytes, once
+ * the 'reuse' clusters of the file being replaced have been freed. Where
+ * the clusters are does not matter, since set_contents() goes back to the
+ * start of the FAT to find them.
+ * Return -1 when overflow occurs, otherwise return 0
+ */
+static int check_overflow(fsdata *mydata, loff_t size, __u32 reuse)
+{
+	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
+	__u32 need;
 
-	if (offset != 0)
-		sect_num++;
+	need = div_u64(size + bytesperclust - 1, bytesperclust);
+	if (need <= reuse)
+		return 0;
+	need -= reuse;
 
-	if (startsect + sect_num > cur_part_info.start + total_sector)
-		return -1;
-	return 0;
+	return count_free_clusters(mydata, need) < need ? -1 : 0;
 }
 
 /*
@@ -963,6 +1155,56 @@ static dir_entry *find_directory_entry(fsdata *mydata, int startsect,
 	return NULL;
 }
 
+/*
+ * Read the FSINFO sector of a FAT32 filesystem, returning NULL if there is
+ * none or it is not valid. The caller must free it.
+ */
+static struct fsinfo_sector *read_fsinfo(fsdata *mydata, boot_sector *bs)
+{
+	struct fsinfo_sector *info;
+
+	if (mydata->fatsize != 32 || !bs->info_sector ||
+	    bs->info_sector >= mydata->fat_sect)
+		return NULL;
+
+	info = memalign(ARCH_DMA_MINALIGN, mydata->sect_size);
+	if (!info)
+		return NULL;
+	if (disk_read(bs->info_sector, 1, info) < 0 ||
+	    FAT2CPU32(info->lead_sig) != FSINFO_LEAD_SIG ||
+	    FAT2CPU32(info->struct_sig) != FSINFO_STRUCT_SIG) {
+		free(info);
+		return NULL;
+	}
+
+	return info;
+}
+
+/*
+ * Update the free cluster count and the hint for the next free cluster in
+ * the FSINFO sector. A count which was not known is left alone.
+ */
+static int update_fsinfo(fsdata *mydata, boot_sector *bs)
+{
+	struct fsinfo_sector *info;
+	__u32 free_count;
+	int ret;
+
+	info = read_fsinfo(mydata, bs);
+	if (!info)
+		return 0;
+
+	free_count = FAT2CPU32(info->free_count);
+	if (free_count != FSINFO_UNKNOWN && free_count < fat_space.count)
+		info->free_count = cpu_to_le32(free_count +
+					       fat_space.free_delta);
+	info->next_free = cpu_to_le32(fat_space.next);
+	ret = disk_write(bs->info_sector, 1, info) < 0 ? -1 : 0;
+	free(info);
+
+	return ret;
+}
+
 static int do_fat_write(const char *filename, void *buffer, loff_t size,
 			loff_t *actwrite)
 {
@@ -973,6 +1215,8 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 	volume_info volinfo;
 	fsdata datablock;
 	fsdata *mydata = &datablock;
+	struct fsinfo_sector *info;
+	__u32 hint;
 	int cursect;
 	int ret = -1, name_len;
 	char l_filename[VFAT_MAXLEN_BYTES];
@@ -1018,12 +1262,13 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 					(mydata->clust_size * 2);
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
+	/* Start looking for free clusters where FSINFO suggests */
+	info = read_fsinfo(mydata, &bs);
+	hint = info ? FAT2CPU32(info->next_free) : 0;
+	free(info);
+	if (fat_cache_init(mydata) || fat_space_init(mydata, hint)) {
 		debug("Error: allocating memory\n");
-		return -1;
+		goto exit;
 	}
 
 	if (disk_read(cursect,
@@ -1053,8 +1298,8 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 
 		if (start_cluster) {
 			if (size) {
-				ret = check_overflow(mydata, start_cluster,
-							size);
+				ret = check_overflow(mydata, size,
+					count_fatent(mydata, start_cluster));
 				if (ret) {
 					printf("Error: %llu overflow\n", size);
 					goto exit;
@@ -1076,7 +1321,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 				goto exit;
 			}
 
-			ret = check_overflow(mydata, start_cluster, size);
+			ret = check_overflow(mydata, size, 0);
 			if (ret) {
 				printf("Error: %llu overflow\n", size);
 				goto exit;
@@ -1096,7 +1341,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 				goto exit;
 			}
 
-			ret = check_overflow(mydata, start_cluster, size);
+			ret = check_overflow(mydata, size, 0);
 			if (ret) {
 				printf("Error: %llu overflow\n", size);
 				goto exit;
@@ -1126,6 +1371,12 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 		goto exit;
 	}
 
+	ret = update_fsinfo(mydata, &bs);
+	if (ret) {
+		printf("Error: writing FSINFO sector\n");
+		goto exit;
+	}
+
 	/* Write directory table to device */
 	ret = set_cluster(mydata, dir_curclust, get_dentfromdir_block,
 			mydata->clust_size * mydata->sect_size);
@@ -1133,7 +1384,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 		printf("Error: writing directory entry\n");
 
 exit:
-	free(mydata->fatbuf);
+	fat_cache_release();
 	return ret;
 }
 
@@ -7,12 +7,16 @@
 #include <config.h>
 #include <errno.h>
 #include <common.h>
+#include <autoboot.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <part.h>
+#include <erofs.h>
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
 #include <sandboxfs.h>
+#include <squashfs.h>
 #include <ubifs_uboot.h>
 #include <asm/io.h>
 #include <div64.h>
@@ -162,6 +166,36 @@ static struct fstype_info fstypes[] = {
 		.write = fs_write_unsupported,
 		.uuid = fs_uuid_unsupported,
 	},
+#endif
+#ifdef CONFIG_FS_SQUASHFS
+	{
+		.fstype = FS_TYPE_SQUASHFS,
+		.name = "squashfs",
+		.null_dev_desc_ok = false,
+		.probe = sqfs_probe,
+		.close = sqfs_close,
+		.ls = sqfs_ls,
+		.exists = sqfs_exists,
+		.size = sqfs_size,
+		.read = sqfs_read,
+		.write = fs_write_unsupported,
+		.uuid = fs_uuid_unsupported,
+	},
+#endif
+#ifdef CONFIG_FS_EROFS
+	{
+		.fstype = FS_TYPE_EROFS,
+		.name = "erofs",
+		.null_dev_desc_ok = false,
+		.probe = erofs_probe,
+		.close = erofs_close,
+		.ls = erofs_ls,
+		.exists = erofs_exists,
+		.size = erofs_size,
+		.read = erofs_read,
+		.write = fs_write_unsupported,
+		.uuid = fs_uuid_unsupported,
+	},
 #endif
 	{
 		.fstype = FS_TYPE_ANY,
@@ -334,6 +368,65 @@ int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	return ret;
 }
 
+char *fs_clean_path(const char *path)
+{
+	char *out, *o;
+	const char *end;
+	size_t len;
+
+	out = malloc(strlen(path) + 1);
+	if (!out)
+		return NULL;
+	for (o = out; *path; path = end) {
+		while (*path == '/')
+			path++;
+		end = strchr(path, '/');
+		if (!end)
+			end = path + strlen(path);
+		len = end - path;
+		if (!len || (len == 1 && *path == '.'))
+			continue;
+		if (len == 2 && !strncmp(path, "..", 2)) {
+			while (o > out && o[-1] != '/')
+				o--;
+			if (o > out)
+				o--;
+			continue;
+		}
+		if (o > out)
+			*o++ = '/';
+		memcpy(o, path, len);
+		o += len;
+	}
+	*o = '\0';
+
+	return out;
+}
+
+char *fs_link_path(const char *path, const char *name, const char *target,
+		   const char *rest)
+{
+	size_t prefix = 0, i;
+	char *out;
+
+	/* A relative target is looked up from the directory holding the link */
+	if (*target != '/')
+		prefix = name - path;
+	out = malloc(prefix + strlen(target) + (rest ? strlen(rest) + 1 : 0) +
+		     1);
+	if (!out)
+		return NULL;
+	for (i = 0; i < prefix; i++)
+		out[i] = path[i] ? path[i] : '/';
+	strcpy(out + prefix, target);
+	if (rest) {
+		strcat(out, "/");
+		strcat(out, rest);
+	}
+
+	return out;
+}
+
 int do_size(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype)
 {
@@ -403,6 +496,15 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	else
 		pos = 0;
 
+	/* The whole file may have been loaded during the boot delay */
+	if (!pos && !bytes &&
+	    autoboot_prefetch_claim(argv[1], (argc >= 3) ? argv[2] : NULL,
+				    addr, filename, &len_read)) {
+		fs_close();
+		printf("%llu bytes already loaded\n", len_read);
+		goto done;
+	}
+
 	time = get_timer(0);
 	ret = fs_read(filename, addr, pos, bytes, &len_read);
 	time = get_timer(time);
@@ -417,6 +519,7 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	}
 	puts("\n");
 
+done:
 	setenv_hex("fileaddr", addr);
 	setenv_hex("filesize", len_read);
 
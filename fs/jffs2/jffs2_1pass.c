@@ -93,9 +93,12 @@
  *   if there are multiple copies of fragments for a certain file offset.
  *
  * The fragment sorting feature must be enabled by CONFIG_SYS_JFFS2_SORT_FRAGMENTS.
- * Sorting is done while adding fragments to the lists, which is more or less a
- * bubble sort. This takes a lot of time, and is most probably not an issue if
- * the boot filesystem is always mounted readonly.
+ * The lists are merge sorted once the scan is complete. The inode, version,
+ * name length and name CRC of each node are kept in the lists, so sorting and
+ * looking up nodes rarely needs to read the flash. Directory entries are
+ * sorted by the CRC of their names, not by the names themselves. Sorting is
+ * most probably not an issue if the boot filesystem is always mounted
+ * readonly.
  *
  * You should define it if the boot filesystem is mounted writable, and updates
  * to the boot files are done by copying files to that filesystem.
@@ -123,6 +126,7 @@
 #include <jffs2/jffs2_1pass.h>
 #include <linux/compat.h>
 #include <linux/errno.h>
+#include <asm/unaligned.h>
 
 #include "jffs2_private.h"
 
@@ -160,50 +164,74 @@ static struct part_info *current_part;
  *
  */
 
-#define NAND_PAGE_SIZE 512
-#define NAND_PAGE_SHIFT 9
-#define NAND_PAGE_MASK (~(NAND_PAGE_SIZE-1))
-
+/*
+ * Flash is read through a cache of up to NAND_CACHE_PAGES pages of the chip,
+ * filled from the page holding the first byte wanted and never past the end
+ * of that erase block. Only a read which carries on from the end of the cache
+ * fills all of it, so scanning a block takes a few large reads while reading
+ * a node or a summary elsewhere reads just the pages holding it.
+ */
 #ifndef NAND_CACHE_PAGES
 #define NAND_CACHE_PAGES 16
 #endif
-#define NAND_CACHE_SIZE (NAND_CACHE_PAGES*NAND_PAGE_SIZE)
 
 static u8* nand_cache = NULL;
 static u32 nand_cache_off = (u32)-1;
+static u32 nand_cache_len;
+static u32 nand_cache_size;
 
 static int read_nand_cached(u32 off, u32 size, u_char *buf)
 {
 	struct mtdids *id = current_part->dev->id;
+	struct mtd_info *mtd = nand_info[id->num];
 	u32 bytes_read = 0;
 	size_t retlen;
 	int cpy_bytes;
 
 	while (bytes_read < size) {
 		if ((off + bytes_read < nand_cache_off) ||
-		    (off + bytes_read >= nand_cache_off+NAND_CACHE_SIZE)) {
-			nand_cache_off = (off + bytes_read) & NAND_PAGE_MASK;
-			if (!nand_cache) {
+		    (off + bytes_read >= nand_cache_off + nand_cache_len)) {
+			bool ahead = off + bytes_read ==
+				nand_cache_off + nand_cache_len;
+			u32 block_end, want;
+
+			if (nand_cache_size !=
+			    NAND_CACHE_PAGES * mtd->writesize) {
 				/* This memory never gets freed but 'cause
 				   it's a bootloader, nobody cares */
-				nand_cache = malloc(NAND_CACHE_SIZE);
+				free(nand_cache);
+				nand_cache_size = NAND_CACHE_PAGES *
+					mtd->writesize;
+				nand_cache = malloc(nand_cache_size);
 				if (!nand_cache) {
 					printf("read_nand_cached: can't alloc cache size %d bytes\n",
-					       NAND_CACHE_SIZE);
+					       nand_cache_size);
+					nand_cache_size = 0;
 					return -1;
 				}
 			}
 
-			retlen = NAND_CACHE_SIZE;
-			if (nand_read(nand_info[id->num], nand_cache_off,
-						&retlen, nand_cache) != 0 ||
-					retlen != NAND_CACHE_SIZE) {
+			nand_cache_off = (off + bytes_read) &
+				~(mtd->writesize - 1);
+			block_end = (nand_cache_off | (mtd->erasesize - 1)) + 1;
+			want = ahead ? nand_cache_size :
+				roundup(off + size - nand_cache_off,
+					mtd->writesize);
+			nand_cache_len = min3(nand_cache_size, want,
+					      block_end - nand_cache_off);
+			retlen = nand_cache_len;
+			if (nand_read(mtd, nand_cache_off, &retlen,
+				      nand_cache) != 0 ||
+					retlen != nand_cache_len) {
 				printf("read_nand_cached: error reading nand off %#x size %d bytes\n",
-						nand_cache_off, NAND_CACHE_SIZE);
+						nand_cache_off, nand_cache_len);
+				nand_cache_off = (u32)-1;
+				nand_cache_len = 0;
 				return -1;
 			}
 		}
-		cpy_bytes = nand_cache_off + NAND_CACHE_SIZE - (off + bytes_read);
+		cpy_bytes = nand_cache_off + nand_cache_len -
+			(off + bytes_read);
 		if (cpy_bytes > size - bytes_read)
 			cpy_bytes = size - bytes_read;
 		memcpy(buf + bytes_read,
@@ -252,6 +280,13 @@ static void put_fl_mem_nand(void *buf)
 {
 	free(buf);
 }
+
+/* Forget what is cached, in case the flash has been written */
+static void flush_nand_cache(void)
+{
+	nand_cache_off = (u32)-1;
+	nand_cache_len = 0;
+}
 #endif
 
 #if defined(CONFIG_CMD_ONENAND)
@@ -420,7 +455,7 @@ static inline void *get_fl_mem(u32 off, u32 size, void *ext_buf)
 		printf("get_fl_mem: unknown device type, " \
 			"using raw offset!\n");
 	}
-	return (void*)off;
+	return (void *)(ulong)off;
 }
 
 static inline void *get_node_mem(u32 off, void *ext_buf)
@@ -448,7 +483,7 @@ static inline void *get_node_mem(u32 off, void *ext_buf)
 		printf("get_fl_mem: unknown device type, " \
 			"using raw offset!\n");
 	}
-	return (void*)off;
+	return (void *)(ulong)off;
 }
 
 static inline void put_fl_mem(void *buf, void *ext_buf)
@@ -569,18 +604,7 @@ insert_node(struct b_list *list, u32 offset)
  */
 static int compare_inodes(struct b_node *new, struct b_node *old)
 {
-	/*
-	 * Only read in the version info from flash, not the entire inode.
-	 * This can make a big difference to speed if flash is slow.
-	 */
-	u32 new_version;
-	u32 old_version;
-	get_fl_mem(new->offset + offsetof(struct jffs2_raw_inode, version),
-		   sizeof(new_version), &new_version);
-	get_fl_mem(old->offset + offsetof(struct jffs2_raw_inode, version),
-		   sizeof(old_version), &old_version);
-
-	return new_version > old_version;
+	return new->version > old->version;
 }
 
 /* Sort directory entries so all entries in the same directory
@@ -590,45 +614,39 @@ static int compare_inodes(struct b_node *new, struct b_node *old)
  */
 static int compare_dirents(struct b_node *new, struct b_node *old)
 {
+	struct jffs2_raw_dirent *jNew, *jOld;
+	int cmp;
+
+	/* ascending sort by pino */
+	if (new->pino != old->pino)
+		return new->pino > old->pino;
 	/*
-	 * Using NULL as the buffer for NOR flash prevents the entire node
-	 * being read. This makes most comparisons much quicker as only one
-	 * or two entries from the node will be used most of the time.
+	 * pino is the same, so use ascending sort by nsize and then by the
+	 * CRC of the name, so we don't read the names from flash unless we
+	 * really must. Entries for the same name still end up together.
 	 */
-	struct jffs2_raw_dirent *jNew = get_node_mem(new->offset, NULL);
-	struct jffs2_raw_dirent *jOld = get_node_mem(old->offset, NULL);
-	int cmp;
-	int ret;
+	if (new->nsize != old->nsize)
+		return new->nsize > old->nsize;
+	if (new->name_crc != old->name_crc)
+		return new->name_crc > old->name_crc;
 
-	if (jNew->pino != jOld->pino) {
-		/* ascending sort by pino */
-		ret = jNew->pino > jOld->pino;
-	} else if (jNew->nsize != jOld->nsize) {
-		/*
-		 * pino is the same, so use ascending sort by nsize,
-		 * so we don't do strncmp unless we really must.
-		 */
-		ret = jNew->nsize > jOld->nsize;
-	} else {
-		/*
-		 * length is also the same, so use ascending sort by name
-		 */
-		cmp = strncmp((char *)jNew->name, (char *)jOld->name,
-			jNew->nsize);
-		if (cmp != 0) {
-			ret = cmp > 0;
-		} else {
-			/*
-			 * we have duplicate names in this directory,
-			 * so use ascending sort by version
-			 */
-			ret = jNew->version > jOld->version;
-		}
-	}
+	/*
+	 * the CRC is also the same, so use ascending sort by name. Using NULL
+	 * as the buffer for NOR flash prevents the entire node being read.
+	 */
+	jNew = get_node_mem(new->offset, NULL);
+	jOld = get_node_mem(old->offset, NULL);
+	cmp = strncmp((char *)jNew->name, (char *)jOld->name, new->nsize);
 	put_fl_mem(jNew, NULL);
 	put_fl_mem(jOld, NULL);
+	if (cmp != 0)
+		return cmp > 0;
 
-	return ret;
+	/*
+	 * we have duplicate names in this directory, so use ascending sort
+	 * by version
+	 */
+	return new->version > old->version;
 }
 #endif
 
@@ -643,6 +661,7 @@ jffs2_free_cache(struct part_info *part)
 		free_nodes(&pL->dir);
 		free(pL->readbuf);
 		free(pL);
+		part->jffs2_priv = NULL;
 	}
 }
 
@@ -686,6 +705,8 @@ jffs2_1pass_read_inode(struct b_lists *pL, u32 inode, char *dest)
 	 * we will live with it.
 	 */
 	for (b = pL->frag.listHead; b != NULL; b = b->next) {
+		if (b->ino != inode)
+			continue;
 		jNode = (struct jffs2_raw_inode *) get_fl_mem(b->offset,
 			sizeof(struct jffs2_raw_inode), pL->readbuf);
 		if ((inode == jNode->ino)) {
@@ -706,6 +727,8 @@ jffs2_1pass_read_inode(struct b_lists *pL, u32 inode, char *dest)
 #endif
 
 	for (b = pL->frag.listHead; b != NULL; b = b->next) {
+		if (b->ino != inode)
+			continue;
 		/*
 		 * Copy just the node and not the data at this point,
 		 * since we don't yet know if we need this data.
@@ -819,13 +842,18 @@ jffs2_1pass_find_inode(struct b_lists * pL, const char *name, u32 pino)
 	u32 counter;
 	u32 version = 0;
 	u32 inode = 0;
+	u32 name_crc;
 
 	/* name is assumed slash free */
 	len = strlen(name);
+	name_crc = crc32_no_comp(0, (uchar *)name, len);
 
 	counter = 0;
 	/* we need to search all and return the inode with the highest version */
 	for(b = pL->dir.listHead; b; b = b->next, counter++) {
+		if (b->pino != pino || b->nsize != len ||
+		    b->name_crc != name_crc)
+			continue;
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
 		if ((pino == jDir->pino) && (len == jDir->nsize) &&
@@ -947,6 +975,8 @@ jffs2_1pass_list_inodes(struct b_lists * pL, u32 pino)
 	struct jffs2_raw_dirent *jDir;
 
 	for (b = pL->dir.listHead; b; b = b->next) {
+		if (b->pino != pino)
+			continue;
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
 		if (pino == jDir->pino) {
@@ -960,7 +990,9 @@ jffs2_1pass_list_inodes(struct b_lists * pL, u32 pino)
 			do {
 				struct b_node *next = b->next;
 				struct jffs2_raw_dirent *jDirNext;
-				if (!next)
+				if (!next || next->pino != b->pino ||
+				    next->nsize != b->nsize ||
+				    next->name_crc != b->name_crc)
 					break;
 				jDirNext = (struct jffs2_raw_dirent *)
 					get_node_mem(next->offset, NULL);
@@ -985,6 +1017,8 @@ jffs2_1pass_list_inodes(struct b_lists * pL, u32 pino)
 			}
 
 			for (b2 = pL->frag.listHead; b2; b2 = b2->next) {
+				if (b2->ino != jDir->ino)
+					continue;
 				jNode = (struct jffs2_raw_inode *)
 					get_fl_mem(b2->offset, sizeof(*jNode),
 						   NULL);
@@ -1086,6 +1120,8 @@ jffs2_1pass_resolve_inode(struct b_lists * pL, u32 ino)
 
 	/* we need to search all and return the inode with the highest version */
 	for(b = pL->dir.listHead; b; b = b->next) {
+		if (b->ino != ino)
+			continue;
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
 		if (ino == jDir->ino) {
@@ -1116,6 +1152,10 @@ jffs2_1pass_resolve_inode(struct b_lists * pL, u32 ino)
 	/* it's a soft link so we follow it again. */
 	b2 = pL->frag.listHead;
 	while (b2) {
+		if (b2->ino != jDirFoundIno) {
+			b2 = b2->next;
+			continue;
+		}
 		jNode = (struct jffs2_raw_inode *) get_node_mem(b2->offset,
 								pL->readbuf);
 		if (jNode->ino == jDirFoundIno) {
@@ -1200,6 +1240,9 @@ jffs2_1pass_rescan_needed(struct part_info *part)
 	struct jffs2_unknown_node onode;
 	struct jffs2_unknown_node *node;
 	struct b_lists *pL = (struct b_lists *)part->jffs2_priv;
+	u32 nr_sectors, sector;
+	u8 *checked;
+	int ret = 0;
 
 	if (part->jffs2_priv == 0){
 		DEBUGF ("rescan: First time in use\n");
@@ -1212,40 +1255,45 @@ jffs2_1pass_rescan_needed(struct part_info *part)
 		return 1;
 	}
 
-	/* but suppose someone reflashed a partition at the same offset... */
-	b = pL->dir.listHead;
-	while (b) {
+	/*
+	 * but suppose someone reflashed a partition at the same offset...
+	 * Flash is erased a sector at a time, so it is enough to check one
+	 * directory entry in each sector.
+	 */
+	nr_sectors = lldiv(part->size, part->sector_size);
+	checked = calloc(DIV_ROUND_UP(nr_sectors, 8), 1);
+	if (!checked)
+		return 1;
+	for (b = pL->dir.listHead; b; b = b->next) {
+		sector = (b->offset - (u32)part->offset) / part->sector_size;
+		if (sector < nr_sectors) {
+			if (checked[sector / 8] & (1 << (sector % 8)))
+				continue;
+			checked[sector / 8] |= 1 << (sector % 8);
+		}
 		node = (struct jffs2_unknown_node *) get_fl_mem(b->offset,
 			sizeof(onode), &onode);
 		if (node->nodetype != JFFS2_NODETYPE_DIRENT) {
 			DEBUGF ("rescan: fs changed beneath me? (%lx)\n",
 					(unsigned long) b->offset);
-			return 1;
+			ret = 1;
+			break;
 		}
-		b = b->next;
 	}
-	return 0;
+	free(checked);
+
+	return ret;
 }
 
 #ifdef CONFIG_JFFS2_SUMMARY
-static u32 sum_get_unaligned32(u32 *ptr)
+static u32 sum_get_unaligned32(const void *ptr)
 {
-	u32 val;
-	u8 *p = (u8 *)ptr;
-
-	val = *p | (*(p + 1) << 8) | (*(p + 2) << 16) | (*(p + 3) << 24);
-
-	return __le32_to_cpu(val);
+	return get_unaligned_le32(ptr);
 }
 
-static u16 sum_get_unaligned16(u16 *ptr)
+static u16 sum_get_unaligned16(const void *ptr)
 {
-	u16 val;
-	u8 *p = (u8 *)ptr;
-
-	val = *p | (*(p + 1) << 8);
-
-	return __le16_to_cpu(val);
+	return get_unaligned_le16(ptr);
 }
 
 #define dbg_summary(...) do {} while (0);
@@ -1256,11 +1304,11 @@ static u16 sum_get_unaligned16(u16 *ptr)
 
 static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 				struct jffs2_raw_summary *summary,
-				struct b_lists *pL)
+				struct b_lists *pL, u32 *max_totlen)
 {
+	struct b_node *ret;
 	void *sp;
 	int i, pass;
-	void *ret;
 
 	for (pass = 0; pass < 2; pass++) {
 		sp = summary->sum;
@@ -1282,6 +1330,14 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 								&spi->offset));
 						if (ret == NULL)
 							return -1;
+						ret->ino = sum_get_unaligned32(
+								&spi->inode);
+						ret->version =
+							sum_get_unaligned32(
+								&spi->version);
+						*max_totlen = max(*max_totlen,
+							sum_get_unaligned32(
+								&spi->totlen));
 					}
 
 					sp += JFFS2_SUMMARY_INODE_SIZE;
@@ -1299,6 +1355,19 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 								&spd->offset));
 						if (ret == NULL)
 							return -1;
+						ret->pino = sum_get_unaligned32(
+								&spd->pino);
+						ret->ino = sum_get_unaligned32(
+								&spd->ino);
+						ret->version =
+							sum_get_unaligned32(
+								&spd->version);
+						ret->nsize = spd->nsize;
+						ret->name_crc = crc32_no_comp(0,
+							spd->name, spd->nsize);
+						*max_totlen = max(*max_totlen,
+							sum_get_unaligned32(
+								&spd->totlen));
 					}
 
 					sp += JFFS2_SUMMARY_DIRENT_SIZE(
@@ -1326,7 +1395,7 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 /* Process the summary node - called from jffs2_scan_eraseblock() */
 int jffs2_sum_scan_sumnode(struct part_info *part, uint32_t offset,
 			   struct jffs2_raw_summary *summary, uint32_t sumsize,
-			   struct b_lists *pL)
+			   struct b_lists *pL, u32 *max_totlen)
 {
 	struct jffs2_unknown_node crcnode;
 	int ret, __maybe_unused ofs;
@@ -1373,7 +1442,8 @@ int jffs2_sum_scan_sumnode(struct part_info *part, uint32_t offset,
 	if (summary->cln_mkr)
 		dbg_summary("Summary : CLEANMARKER node \n");
 
-	ret = jffs2_sum_process_sum_data(part, offset, summary, pL);
+	ret = jffs2_sum_process_sum_data(part, offset, summary, pL,
+					 max_totlen);
 	if (ret == -EBADMSG)
 		return 0;
 	if (ret)
@@ -1466,6 +1536,8 @@ jffs2_1pass_build_lists(struct part_info * part)
 {
 	struct b_lists *pL;
 	struct jffs2_unknown_node *node;
+	struct jffs2_raw_dirent *dirent;
+	struct b_node *b;
 	u32 nr_sectors;
 	u32 i;
 	u32 counter4 = 0;
@@ -1516,7 +1588,8 @@ jffs2_1pass_build_lists(struct part_info * part)
 				buf_len, buf_len, buf + buf_size - buf_len);
 
 		sm = (void *)buf + buf_size - sizeof(*sm);
-		if (sm->magic == JFFS2_SUM_MAGIC) {
+		if (sm->magic == JFFS2_SUM_MAGIC &&
+		    sm->offset < part->sector_size) {
 			sumlen = part->sector_size - sm->offset;
 			sumptr = buf + buf_size - sumlen;
 
@@ -1546,7 +1619,7 @@ jffs2_1pass_build_lists(struct part_info * part)
 
 		if (sumptr) {
 			ret = jffs2_sum_scan_sumnode(part, sector_ofs, sumptr,
-					sumlen, pL);
+					sumlen, pL, &max_totlen);
 
 			if (buf_size && sumlen > buf_size)
 				free(sumptr);
@@ -1689,12 +1762,16 @@ jffs2_1pass_build_lists(struct part_info * part)
 				if (!inode_crc((struct jffs2_raw_inode *)node))
 					break;
 
-				if (insert_node(&pL->frag, (u32) part->offset +
-						ofs) == NULL) {
+				b = insert_node(&pL->frag, (u32)part->offset +
+						ofs);
+				if (!b) {
 					free(buf);
 					jffs2_free_cache(part);
 					return 0;
 				}
+				b->ino = ((struct jffs2_raw_inode *)node)->ino;
+				b->version = ((struct jffs2_raw_inode *)
+					      node)->version;
 				if (max_totlen < node->totlen)
 					max_totlen = node->totlen;
 				break;
@@ -1724,12 +1801,19 @@ jffs2_1pass_build_lists(struct part_info * part)
 					break;
 				if (! (counterN%100))
 					puts ("\b\b.  ");
-				if (insert_node(&pL->dir, (u32) part->offset +
-						ofs) == NULL) {
+				b = insert_node(&pL->dir, (u32)part->offset +
+						ofs);
+				if (!b) {
 					free(buf);
 					jffs2_free_cache(part);
 					return 0;
 				}
+				dirent = (struct jffs2_raw_dirent *)node;
+				b->pino = dirent->pino;
+				b->ino = dirent->ino;
+				b->version = dirent->version;
+				b->nsize = dirent->nsize;
+				b->name_crc = dirent->name_crc;
 				if (max_totlen < node->totlen)
 					max_totlen = node->totlen;
 				counterN++;
@@ -1845,6 +1929,9 @@ jffs2_get_list(struct part_info * part, const char *who)
 {
 	/* copy requested part_info struct pointer to global location */
 	current_part = part;
+#if defined(CONFIG_JFFS2_NAND) && defined(CONFIG_CMD_NAND)
+	flush_nand_cache();
+#endif
 
 	if (jffs2_1pass_rescan_needed(part)) {
 		if (!jffs2_1pass_build_lists(part)) {
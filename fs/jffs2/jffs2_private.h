@@ -4,10 +4,21 @@
 #include <jffs2/jffs2.h>
 
 
+/*
+ * A node found on flash. The fields used to look nodes up and sort them
+ * are kept here, so that searching the lists does not need to read the
+ * flash: the inode and version of a data node, or the parent, version,
+ * inode, name length and name CRC of a directory entry.
+ */
 struct b_node {
 	u32 offset;
 	struct b_node *next;
 	enum { CRC_UNKNOWN = 0, CRC_OK, CRC_BAD } datacrc;
+	u32 ino;
+	u32 pino;
+	u32 version;
+	u32 name_crc;
+	u8 nsize;
 };
 
 struct b_list {
@@ -89,9 +100,8 @@ inode_crc(struct jffs2_raw_inode *node)
 static inline int
 data_crc(struct jffs2_raw_inode *node)
 {
-	if (node->data_crc != crc32_no_comp(0, (unsigned char *)
-					    ((int) &node->node_crc + sizeof (node->node_crc)),
-					     node->csize)) {
+	if (node->data_crc != crc32_no_comp(0, (unsigned char *)(node + 1),
+					    node->csize)) {
 		return 0;
 	} else {
 		return 1;
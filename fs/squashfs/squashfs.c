@@ -0,0 +1,980 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Read-only support for SquashFS 4.0 filesystems
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Metadata (inodes, directories and the fragment table) is stored in blocks
+ * of up to 8KiB which are compressed one by one. Decompressed metadata
+ * blocks are kept in a small cache, since looking up a path reads the same
+ * few blocks again and again. The ends of small files are packed together in
+ * fragment blocks, so loading several small files one after another would
+ * decompress the same fragment block each time; those are cached too.
+ *
+ * Both caches are kept after a command completes. They are used again if the
+ * next command probes the same device and partition and finds the same
+ * superblock there, so loading a kernel, device tree and ramdisk from the
+ * same filesystem does not decompress shared blocks more than once.
+ *
+ * The partition is read through a window. A data block is read together
+ * with those following it, up to the size of the window, so a large file
+ * is read with few large reads.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <errno.h>
+#include <fs.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <part.h>
+#include <squashfs.h>
+#include <asm/unaligned.h>
+#include <linux/lzo.h>
+#ifdef CONFIG_LZMA
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaDec.h>
+#include <lzma/LzmaTools.h>
+#endif
+
+#define SQFS_META_CACHE		16	/* metadata blocks cached */
+#define SQFS_FRAG_CACHE		4	/* fragment blocks cached */
+#define SQFS_WINDOW_SIZE	(256 << 10)
+#define SQFS_MAX_LINKS		8	/* symbolic links followed in a path */
+#define SQFS_MAX_NAME		256
+#define SQFS_MAX_PATH		4096
+
+#define SQFS_NO_BLOCK		((u64)-1)
+
+/**
+ * struct sqfs_cache_entry - a decompressed metadata or fragment block
+ *
+ * @disk:	Offset of the block in the partition, SQFS_NO_BLOCK if unused
+ * @next:	Offset of the block which follows it in the partition
+ * @len:	Number of bytes in @data
+ * @used:	Value of the cache's clock when the entry was last used
+ * @data:	Decompressed contents of the block
+ */
+struct sqfs_cache_entry {
+	u64 disk;
+	u64 next;
+	u32 len;
+	ulong used;
+	u8 *data;
+};
+
+/**
+ * struct sqfs_cache - a set of blocks, the least recently used replaced first
+ *
+ * @entry:	Entries of the cache
+ * @count:	Number of entries
+ * @size:	Size of the data buffer of each entry
+ * @clock:	Incremented each time an entry is used
+ */
+struct sqfs_cache {
+	struct sqfs_cache_entry *entry;
+	int count;
+	u32 size;
+	ulong clock;
+};
+
+/**
+ * struct sqfs_inode - the parts of an inode needed to use it
+ *
+ * @type:	Inode type (SQFS_..._TYPE)
+ * @size:	Size of the file, the directory listing or the link target
+ * @start:	Offset of the first data block of a file in the partition, or
+ *		of the directory listing in the directory table
+ * @frag:	Fragment holding the end of a file, or SQFS_INVALID_FRAG
+ * @frag_offset: Offset of the end of the file in the fragment block, or of
+ *		the directory listing in its metadata block
+ * @md_disk:	Metadata block holding the block list or link target
+ * @md_offset:	Offset of the block list or link target in @md_disk
+ */
+struct sqfs_inode {
+	int type;
+	u64 size;
+	u64 start;
+	u32 frag;
+	u32 frag_offset;
+	u64 md_disk;
+	u32 md_offset;
+};
+
+/**
+ * struct sqfs_info - state of the filesystem being used
+ *
+ * @desc:	Block device, NULL if no filesystem has been probed
+ * @part:	Partition holding the filesystem
+ * @sb:		Superblock, as found on the partition
+ * @block_size:	Size of a data block
+ * @block_log:	log2 of @block_size
+ * @comp:	Compression used (SQFS_COMP_...)
+ * @win:	Window onto the partition
+ * @win_start:	Offset of the window in the partition
+ * @win_len:	Number of bytes held in the window
+ * @win_size:	Size of the window buffer
+ * @meta:	Metadata block cache
+ * @frag:	Fragment block cache
+ * @scratch:	Buffer for decompressing parts of data blocks
+ */
+static struct sqfs_info {
+	struct blk_desc *desc;
+	disk_partition_t part;
+	struct sqfs_super_block sb;
+	u32 block_size;
+	int block_log;
+	int comp;
+	u8 *win;
+	u64 win_start;
+	u32 win_len;
+	u32 win_size;
+	struct sqfs_cache meta;
+	struct sqfs_cache frag;
+	u8 *scratch;
+} sqfs;
+
+static const char *const sqfs_comp_name[] = {
+	[SQFS_COMP_GZIP] = "gzip",
+	[SQFS_COMP_LZMA] = "lzma",
+	[SQFS_COMP_LZO] = "lzo",
+	[SQFS_COMP_XZ] = "xz",
+	[SQFS_COMP_LZ4] = "lz4",
+	[SQFS_COMP_ZSTD] = "zstd",
+};
+
+static bool sqfs_comp_supported(int comp)
+{
+	switch (comp) {
+#ifdef CONFIG_GZIP
+	case SQFS_COMP_GZIP:
+#endif
+#ifdef CONFIG_LZMA
+	case SQFS_COMP_LZMA:
+#endif
+#ifdef CONFIG_LZO
+	case SQFS_COMP_LZO:
+#endif
+#ifdef CONFIG_LZ4
+	case SQFS_COMP_LZ4:
+#endif
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * sqfs_decompress() - Decompress a block
+ *
+ * @dst:	Buffer for the decompressed data
+ * @dstlen:	Size of @dst; returns the number of bytes decompressed
+ * @src:	Compressed data
+ * @srclen:	Number of bytes of compressed data
+ * @return 0 if OK, -EIO if the data is corrupt
+ */
+static int sqfs_decompress(void *dst, u32 *dstlen, const void *src,
+			   u32 srclen)
+{
+	switch (sqfs.comp) {
+#ifdef CONFIG_GZIP
+	case SQFS_COMP_GZIP: {
+		unsigned long len = srclen;
+
+		/* Skip the two-byte zlib header */
+		if (zunzip(dst, *dstlen, (uchar *)src, &len, 1, 2))
+			return -EIO;
+		*dstlen = len;
+		return 0;
+	}
+#endif
+#ifdef CONFIG_LZMA
+	case SQFS_COMP_LZMA: {
+		SizeT len = *dstlen;
+
+		if (lzmaBuffToBuffDecompress(dst, &len, (uchar *)src,
+					     srclen) != SZ_OK)
+			return -EIO;
+		*dstlen = len;
+		return 0;
+	}
+#endif
+#ifdef CONFIG_LZO
+	case SQFS_COMP_LZO: {
+		size_t len = *dstlen;
+
+		if (lzo1x_decompress_safe(src, srclen, dst, &len) != LZO_E_OK)
+			return -EIO;
+		*dstlen = len;
+		return 0;
+	}
+#endif
+#ifdef CONFIG_LZ4
+	case SQFS_COMP_LZ4: {
+		size_t len = *dstlen;
+
+		if (ulz4_block(src, srclen, dst, &len))
+			return -EIO;
+		*dstlen = len;
+		return 0;
+	}
+#endif
+	default:
+		return -EPROTONOSUPPORT;
+	}
+}
+
+/**
+ * sqfs_map() - Get a pointer to bytes of the partition
+ *
+ * Unless the window already holds them, the bytes are read into it along
+ * with up to @ahead bytes from @off onwards, so that what follows can be used
+ * without reading the partition again.
+ *
+ * @off:	Offset in the partition
+ * @len:	Number of bytes wanted
+ * @ahead:	Number of bytes from @off to read if the window is refilled
+ * @return pointer to the bytes, or NULL on error
+ */
+static const u8 *sqfs_map(u64 off, u32 len, u32 ahead)
+{
+	int log2blksz = sqfs.desc->log2blksz;
+	u64 start, end, limit;
+	lbaint_t count;
+
+	if (off >= sqfs.win_start && off + len <= sqfs.win_start + sqfs.win_len)
+		return sqfs.win + (off - sqfs.win_start);
+
+	limit = (u64)sqfs.part.size << log2blksz;
+	if (off + len > limit || len > sqfs.win_size - sqfs.desc->blksz)
+		return NULL;
+	start = off >> log2blksz << log2blksz;
+	end = off + max(len, ahead);
+	end = min(end, start + sqfs.win_size);
+	end = min(ALIGN(end, sqfs.desc->blksz), limit);
+
+	sqfs.win_len = 0;
+	count = (end - start) >> log2blksz;
+	if (blk_dread(sqfs.desc, sqfs.part.start + (start >> log2blksz),
+		      count, sqfs.win) != count)
+		return NULL;
+	sqfs.win_start = start;
+	sqfs.win_len = end - start;
+
+	return sqfs.win + (off - start);
+}
+
+/* Make sure that the window can hold @len bytes, wherever they start */
+static int sqfs_alloc_window(u32 len)
+{
+	u32 size = max_t(u32, SQFS_WINDOW_SIZE, len) + sqfs.desc->blksz;
+
+	sqfs.win_len = 0;
+	if (sqfs.win_size >= size)
+		return 0;
+	free(sqfs.win);
+	sqfs.win = memalign(ARCH_DMA_MINALIGN, size);
+	sqfs.win_size = sqfs.win ? size : 0;
+
+	return sqfs.win ? 0 : -ENOMEM;
+}
+
+static void sqfs_cache_reset(struct sqfs_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < cache->count; i++)
+		cache->entry[i].disk = SQFS_NO_BLOCK;
+}
+
+/* Set up a cache whose entries hold @size bytes, keeping it if possible */
+static int sqfs_cache_init(struct sqfs_cache *cache, int count, u32 size)
+{
+	int i;
+
+	if (cache->entry && cache->size == size) {
+		sqfs_cache_reset(cache);
+		return 0;
+	}
+	if (cache->entry) {
+		for (i = 0; i < cache->count; i++)
+			free(cache->entry[i].data);
+		free(cache->entry);
+	}
+	cache->size = 0;
+	cache->count = 0;
+	cache->entry = calloc(count, sizeof(*cache->entry));
+	if (!cache->entry)
+		return -ENOMEM;
+	for (i = 0; i < count; i++) {
+		cache->entry[i].disk = SQFS_NO_BLOCK;
+		cache->entry[i].data = malloc(size);
+		if (!cache->entry[i].data)
+			return -ENOMEM;
+		cache->count = i + 1;
+	}
+	cache->size = size;
+
+	return 0;
+}
+
+static struct sqfs_cache_entry *sqfs_cache_find(struct sqfs_cache *cache,
+						u64 disk)
+{
+	struct sqfs_cache_entry *entry;
+	int i;
+
+	for (i = 0, entry = cache->entry; i < cache->count; i++, entry++) {
+		if (entry->disk == disk) {
+			entry->used = ++cache->clock;
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* Get the least recently used entry, to be filled with another block */
+static struct sqfs_cache_entry *sqfs_cache_victim(struct sqfs_cache *cache)
+{
+	struct sqfs_cache_entry *entry, *victim = cache->entry;
+	int i;
+
+	for (i = 0, entry = cache->entry; i < cache->count; i++, entry++) {
+		if (entry->used < victim->used)
+			victim = entry;
+	}
+	victim->disk = SQFS_NO_BLOCK;
+	victim->used = ++cache->clock;
+
+	return victim;
+}
+
+/* Get the metadata block at offset @disk, decompressing it if needed */
+static struct sqfs_cache_entry *sqfs_get_meta(u64 disk)
+{
+	struct sqfs_cache_entry *entry;
+	const u8 *src;
+	u32 hdr, csize, len;
+
+	entry = sqfs_cache_find(&sqfs.meta, disk);
+	if (entry)
+		return entry;
+
+	/* Read the whole block along with its header */
+	src = sqfs_map(disk, 2, 2 + SQFS_METADATA_SIZE);
+	if (!src)
+		return NULL;
+	hdr = get_unaligned_le16(src);
+	csize = hdr & ~SQFS_METADATA_UNCOMPRESSED;
+	if (!csize || csize > SQFS_METADATA_SIZE)
+		return NULL;
+	src = sqfs_map(disk + 2, csize, 0);
+	if (!src)
+		return NULL;
+
+	entry = sqfs_cache_victim(&sqfs.meta);
+	if (hdr & SQFS_METADATA_UNCOMPRESSED) {
+		memcpy(entry->data, src, csize);
+		len = csize;
+	} else {
+		len = SQFS_METADATA_SIZE;
+		if (sqfs_decompress(entry->data, &len, src, csize))
+			return NULL;
+	}
+	if (!len)
+		return NULL;
+	entry->disk = disk;
+	entry->next = disk + 2 + csize;
+	entry->len = len;
+
+	return entry;
+}
+
+/**
+ * sqfs_read_meta() - Read from a metadata table
+ *
+ * @disk:	Offset of the metadata block to start in; updated to the block
+ *		holding the byte after those read
+ * @offset:	Offset in that block once decompressed; updated likewise
+ * @buf:	Buffer for the data
+ * @len:	Number of bytes to read
+ * @return 0 if OK, -EIO on error
+ */
+static int sqfs_read_meta(u64 *disk, u32 *offset, void *buf, u32 len)
+{
+	struct sqfs_cache_entry *entry;
+	u32 count;
+
+	while (len) {
+		entry = sqfs_get_meta(*disk);
+		if (!entry)
+			return -EIO;
+		if (*offset >= entry->len) {
+			*offset -= entry->len;
+			*disk = entry->next;
+			continue;
+		}
+		count = min(len, entry->len - *offset);
+		memcpy(buf, entry->data + *offset, count);
+		buf += count;
+		len -= count;
+		*offset += count;
+	}
+
+	return 0;
+}
+
+/* Read the inode which @ref refers to */
+static int sqfs_read_inode(u64 ref, struct sqfs_inode *inode)
+{
+	u64 disk = le64_to_cpu(sqfs.sb.inode_table_start) + (ref >> 16);
+	u32 offset = ref & 0xffff;
+	union {
+		struct sqfs_base_inode base;
+		struct sqfs_dir_inode dir;
+		struct sqfs_ldir_inode ldir;
+		struct sqfs_reg_inode reg;
+		struct sqfs_lreg_inode lreg;
+		struct sqfs_symlink_inode symlink;
+	} i;
+	u32 size;
+	int ret;
+
+	ret = sqfs_read_meta(&disk, &offset, &i.base, sizeof(i.base));
+	if (ret)
+		return ret;
+	memset(inode, '\0', sizeof(*inode));
+	inode->type = le16_to_cpu(i.base.inode_type);
+	inode->frag = SQFS_INVALID_FRAG;
+	switch (inode->type) {
+	case SQFS_DIR_TYPE:
+		size = sizeof(i.dir);
+		break;
+	case SQFS_LDIR_TYPE:
+		size = sizeof(i.ldir);
+		break;
+	case SQFS_REG_TYPE:
+		size = sizeof(i.reg);
+		break;
+	case SQFS_LREG_TYPE:
+		size = sizeof(i.lreg);
+		break;
+	case SQFS_SYMLINK_TYPE:
+	case SQFS_LSYMLINK_TYPE:
+		size = sizeof(i.symlink);
+		break;
+	default:
+		/* Nothing else is needed about other types */
+		return 0;
+	}
+	ret = sqfs_read_meta(&disk, &offset, &i.base + 1,
+			     size - sizeof(i.base));
+	if (ret)
+		return ret;
+
+	switch (inode->type) {
+	case SQFS_DIR_TYPE:
+		inode->size = le16_to_cpu(i.dir.file_size);
+		inode->start = le32_to_cpu(i.dir.start_block);
+		inode->frag_offset = le16_to_cpu(i.dir.offset);
+		break;
+	case SQFS_LDIR_TYPE:
+		inode->size = le32_to_cpu(i.ldir.file_size);
+		inode->start = le32_to_cpu(i.ldir.start_block);
+		inode->frag_offset = le16_to_cpu(i.ldir.offset);
+		break;
+	case SQFS_REG_TYPE:
+		inode->size = le32_to_cpu(i.reg.file_size);
+		inode->start = le32_to_cpu(i.reg.start_block);
+		inode->frag = le32_to_cpu(i.reg.fragment);
+		inode->frag_offset = le32_to_cpu(i.reg.offset);
+		break;
+	case SQFS_LREG_TYPE:
+		inode->size = le64_to_cpu(i.lreg.file_size);
+		inode->start = le64_to_cpu(i.lreg.start_block);
+		inode->frag = le32_to_cpu(i.lreg.fragment);
+		inode->frag_offset = le32_to_cpu(i.lreg.offset);
+		break;
+	default:
+		inode->size = le32_to_cpu(i.symlink.symlink_size);
+		break;
+	}
+	inode->md_disk = disk;
+	inode->md_offset = offset;
+
+	return 0;
+}
+
+static bool sqfs_is_dir(struct sqfs_inode *inode)
+{
+	return inode->type == SQFS_DIR_TYPE || inode->type == SQFS_LDIR_TYPE;
+}
+
+static bool sqfs_is_reg(struct sqfs_inode *inode)
+{
+	return inode->type == SQFS_REG_TYPE || inode->type == SQFS_LREG_TYPE;
+}
+
+static bool sqfs_is_symlink(struct sqfs_inode *inode)
+{
+	return inode->type == SQFS_SYMLINK_TYPE ||
+		inode->type == SQFS_LSYMLINK_TYPE;
+}
+
+/**
+ * sqfs_dir_iterate() - Call a function for each entry of a directory
+ *
+ * @dir:	Directory inode
+ * @func:	Function to call with the name, type and inode reference of
+ *		each entry. It returns 0 to carry on, or anything else to stop
+ *		and return that value.
+ * @priv:	Private data for @func
+ * @return 0 if @func returned 0 for every entry, the value it returned
+ * otherwise, or -EIO on error
+ */
+static int sqfs_dir_iterate(struct sqfs_inode *dir,
+			    int (*func)(void *priv, const char *name,
+					int type, u64 ref),
+			    void *priv)
+{
+	u64 disk = le64_to_cpu(sqfs.sb.directory_table_start) + dir->start;
+	u32 offset = dir->frag_offset;
+	struct sqfs_dir_header hdr;
+	struct sqfs_dir_entry ent;
+	char name[SQFS_MAX_NAME + 1];
+	u64 left, ref;
+	u32 count, size;
+	int ret;
+
+	/* The size includes the "." and ".." entries, which are not stored */
+	left = dir->size > 3 ? dir->size - 3 : 0;
+	while (left >= sizeof(hdr)) {
+		ret = sqfs_read_meta(&disk, &offset, &hdr, sizeof(hdr));
+		if (ret)
+			return ret;
+		left -= sizeof(hdr);
+		for (count = le32_to_cpu(hdr.count) + 1; count; count--) {
+			ret = sqfs_read_meta(&disk, &offset, &ent, sizeof(ent));
+			if (ret)
+				return ret;
+			size = le16_to_cpu(ent.size) + 1;
+			if (size >= sizeof(name) || left < sizeof(ent) + size)
+				return -EIO;
+			ret = sqfs_read_meta(&disk, &offset, name, size);
+			if (ret)
+				return ret;
+			name[size] = '\0';
+			left -= sizeof(ent) + size;
+
+			ref = (u64)le32_to_cpu(hdr.start_block) << 16 |
+				le16_to_cpu(ent.offset);
+			ret = func(priv, name, le16_to_cpu(ent.type), ref);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+struct sqfs_lookup {
+	const char *name;
+	u64 ref;
+};
+
+static int sqfs_lookup_entry(void *priv, const char *name, int type, u64 ref)
+{
+	struct sqfs_lookup *lookup = priv;
+	int cmp = strcmp(name, lookup->name);
+
+	if (!cmp) {
+		lookup->ref = ref;
+		return 1;
+	}
+
+	/* Entries are sorted by name, so it is not there */
+	return cmp > 0 ? -ENOENT : 0;
+}
+
+/**
+ * sqfs_find() - Find the inode for a path, following symbolic links
+ *
+ * @path:	Path to look up, from the root directory
+ * @inode:	Returns the inode found
+ * @links:	Number of symbolic links already followed
+ * @return 0 if OK, -ENOENT if not found, other -ve value on error
+ */
+static int sqfs_find(const char *path, struct sqfs_inode *inode, int links)
+{
+	struct sqfs_lookup lookup;
+	char *copy, *rest, *name, *target, *newpath;
+	int ret;
+
+	ret = sqfs_read_inode(le64_to_cpu(sqfs.sb.root_inode), inode);
+	if (ret)
+		return ret;
+	copy = fs_clean_path(path);
+	if (!copy)
+		return -ENOMEM;
+
+	for (rest = copy; !ret && rest && *rest;) {
+		name = strsep(&rest, "/");
+		if (!sqfs_is_dir(inode)) {
+			ret = -ENOTDIR;
+			break;
+		}
+		lookup.name = name;
+		ret = sqfs_dir_iterate(inode, sqfs_lookup_entry, &lookup);
+		if (ret != 1) {
+			ret = ret ? ret : -ENOENT;
+			break;
+		}
+		ret = sqfs_read_inode(lookup.ref, inode);
+		if (ret || !sqfs_is_symlink(inode))
+			continue;
+
+		/* Guard against loops and over-long targets */
+		if (links >= SQFS_MAX_LINKS || inode->size > SQFS_MAX_PATH) {
+			ret = -ELOOP;
+			break;
+		}
+		target = malloc(inode->size + 1);
+		if (!target) {
+			ret = -ENOMEM;
+			break;
+		}
+		ret = sqfs_read_meta(&inode->md_disk, &inode->md_offset,
+				     target, inode->size);
+		if (!ret) {
+			target[inode->size] = '\0';
+			newpath = fs_link_path(copy, name, target, rest);
+			ret = newpath ? sqfs_find(newpath, inode, links + 1) :
+				-ENOMEM;
+			free(newpath);
+		}
+		free(target);
+		break;
+	}
+	free(copy);
+
+	return ret;
+}
+
+/* Find a fragment block and decompress it if needed */
+static struct sqfs_cache_entry *sqfs_get_fragment(u32 frag)
+{
+	struct sqfs_fragment_entry fe;
+	struct sqfs_cache_entry *entry;
+	const u8 *src;
+	u64 disk, start;
+	u32 offset, size, csize, len;
+
+	if (frag >= le32_to_cpu(sqfs.sb.fragments))
+		return NULL;
+
+	/* The fragment table is found through an index of its blocks */
+	src = sqfs_map(le64_to_cpu(sqfs.sb.fragment_table_start) +
+		       frag / SQFS_FRAGMENTS_PER_BLOCK * sizeof(u64),
+		       sizeof(u64), 0);
+	if (!src)
+		return NULL;
+	disk = get_unaligned_le64(src);
+	offset = frag % SQFS_FRAGMENTS_PER_BLOCK * sizeof(fe);
+	if (sqfs_read_meta(&disk, &offset, &fe, sizeof(fe)))
+		return NULL;
+
+	start = le64_to_cpu(fe.start_block);
+	entry = sqfs_cache_find(&sqfs.frag, start);
+	if (entry)
+		return entry;
+
+	size = le32_to_cpu(fe.size);
+	csize = size & ~SQFS_BLOCK_UNCOMPRESSED;
+	if (!csize || csize > sqfs.block_size)
+		return NULL;
+	src = sqfs_map(start, csize, 0);
+	if (!src)
+		return NULL;
+	entry = sqfs_cache_victim(&sqfs.frag);
+	if (size & SQFS_BLOCK_UNCOMPRESSED) {
+		memcpy(entry->data, src, csize);
+		len = csize;
+	} else {
+		len = sqfs.block_size;
+		if (sqfs_decompress(entry->data, &len, src, csize))
+			return NULL;
+	}
+	entry->disk = start;
+	entry->next = start + csize;
+	entry->len = len;
+
+	return entry;
+}
+
+/**
+ * sqfs_read_block() - Read part of a data block of a file
+ *
+ * @disk:	Offset of the block in the partition
+ * @size:	Size of the block, from the block list
+ * @block_len:	Size of the block once decompressed
+ * @in_block:	Offset of the first byte wanted in the block
+ * @len:	Number of bytes wanted
+ * @dst:	Buffer for the data
+ * @ahead:	Number of bytes of the file's data from @disk onwards
+ * @return 0 if OK, -EIO on error
+ */
+static int sqfs_read_block(u64 disk, u32 size, u32 block_len, u32 in_block,
+			   u32 len, void *dst, u32 ahead)
+{
+	u32 csize = size & ~SQFS_BLOCK_UNCOMPRESSED;
+	const u8 *src;
+	u32 out;
+
+	/* A sparse block of zeroes is not stored */
+	if (!csize) {
+		memset(dst, '\0', len);
+		return 0;
+	}
+	if (csize > sqfs.block_size)
+		return -EIO;
+	src = sqfs_map(disk, csize, ahead);
+	if (!src)
+		return -EIO;
+	if (size & SQFS_BLOCK_UNCOMPRESSED) {
+		if (in_block + len > csize)
+			return -EIO;
+		memcpy(dst, src + in_block, len);
+		return 0;
+	}
+
+	/* Decompress straight into the buffer if all of the block is wanted */
+	out = block_len;
+	if (!in_block && len == block_len) {
+		if (sqfs_decompress(dst, &out, src, csize) || out != block_len)
+			return -EIO;
+		return 0;
+	}
+	if (sqfs_decompress(sqfs.scratch, &out, src, csize) ||
+	    out != block_len)
+		return -EIO;
+	memcpy(dst, sqfs.scratch + in_block, len);
+
+	return 0;
+}
+
+static int sqfs_read_file(struct sqfs_inode *inode, void *buf, u64 offset,
+			  u64 len, loff_t *actread)
+{
+	u32 block_size = sqfs.block_size;
+	int block_log = sqfs.block_log;
+	u32 nblocks, first, last, i, in_block, count, block_len;
+	struct sqfs_cache_entry *entry;
+	u64 disk, pos, end, ahead;
+	u32 *sizes = NULL;
+	int ret = 0;
+
+	*actread = 0;
+	if (offset >= inode->size)
+		return 0;
+	if (!len || len > inode->size - offset)
+		len = inode->size - offset;
+	end = offset + len;
+
+	/* The end of the file may be in a fragment rather than a block */
+	if (inode->frag == SQFS_INVALID_FRAG)
+		nblocks = (inode->size + block_size - 1) >> block_log;
+	else
+		nblocks = inode->size >> block_log;
+	first = offset >> block_log;
+	last = (end - 1) >> block_log;
+
+	/* Block sizes are needed to skip to the first block wanted */
+	if (nblocks) {
+		count = min(last + 1, nblocks);
+		sizes = malloc(count * sizeof(*sizes));
+		if (!sizes)
+			return -ENOMEM;
+		ret = sqfs_read_meta(&inode->md_disk, &inode->md_offset,
+				     sizes, count * sizeof(*sizes));
+		if (ret)
+			goto out;
+	}
+
+	disk = inode->start;
+	for (i = 0; i < first && i < nblocks; i++)
+		disk += le32_to_cpu(sizes[i]) & ~SQFS_BLOCK_UNCOMPRESSED;
+	for (i = first, pos = offset; pos < end; i++) {
+		in_block = pos - ((u64)i << block_log);
+		count = min_t(u64, block_size - in_block, end - pos);
+		if (i < nblocks) {
+			block_len = min_t(u64, block_size,
+					  inode->size - ((u64)i << block_log));
+			ahead = (u64)(min(last + 1, nblocks) - i) << block_log;
+			ret = sqfs_read_block(disk, le32_to_cpu(sizes[i]),
+					      block_len, in_block, count,
+					      buf, min_t(u64, ahead,
+							 sqfs.win_size));
+			disk += le32_to_cpu(sizes[i]) &
+				~SQFS_BLOCK_UNCOMPRESSED;
+		} else {
+			entry = sqfs_get_fragment(inode->frag);
+			in_block += inode->frag_offset;
+			if (!entry || in_block + count > entry->len)
+				ret = -EIO;
+			else
+				memcpy(buf, entry->data + in_block, count);
+		}
+		if (ret)
+			goto out;
+		buf += count;
+		pos += count;
+	}
+	*actread = len;
+
+out:
+	free(sizes);
+	return ret;
+}
+
+int sqfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
+{
+	struct sqfs_super_block old = sqfs.sb;
+	struct blk_desc *old_desc = sqfs.desc;
+	lbaint_t old_start = sqfs.part.start;
+	const struct sqfs_super_block *sb;
+	u32 block_size;
+	int comp, block_log;
+	bool same;
+
+	sqfs.desc = fs_dev_desc;
+	sqfs.part = *fs_partition;
+	if (sqfs_alloc_window(0))
+		goto err;
+
+	sb = (const void *)sqfs_map(0, sizeof(*sb), 0);
+	if (!sb || le32_to_cpu(sb->s_magic) != SQFS_MAGIC)
+		goto err;
+	block_size = le32_to_cpu(sb->block_size);
+	block_log = le16_to_cpu(sb->block_log);
+	if (le16_to_cpu(sb->s_major) != SQFS_MAJOR ||
+	    block_log < SQFS_MIN_BLOCK_LOG || block_log > SQFS_MAX_BLOCK_LOG ||
+	    block_size != 1 << block_log) {
+		printf("** Unsupported SquashFS filesystem **\n");
+		goto err;
+	}
+	comp = le16_to_cpu(sb->compression);
+	if (!sqfs_comp_supported(comp)) {
+		printf("** SquashFS %s compression is not supported **\n",
+		       comp < ARRAY_SIZE(sqfs_comp_name) &&
+		       sqfs_comp_name[comp] ? sqfs_comp_name[comp] :
+		       "unknown");
+		goto err;
+	}
+
+	same = old_desc == fs_dev_desc && old_start == fs_partition->start &&
+		!memcmp(&old, sb, sizeof(old));
+	sqfs.sb = *sb;
+	sqfs.block_size = block_size;
+	sqfs.block_log = block_log;
+	sqfs.comp = comp;
+	if (sqfs_alloc_window(block_size))
+		goto err;
+	if (same)
+		return 0;
+
+	/* The caches hold blocks of another filesystem, if any */
+	free(sqfs.scratch);
+	sqfs.scratch = malloc(block_size);
+	if (!sqfs.scratch ||
+	    sqfs_cache_init(&sqfs.meta, SQFS_META_CACHE, SQFS_METADATA_SIZE) ||
+	    sqfs_cache_init(&sqfs.frag, SQFS_FRAG_CACHE, block_size))
+		goto err;
+
+	return 0;
+
+err:
+	sqfs.desc = NULL;
+	memset(&sqfs.sb, '\0', sizeof(sqfs.sb));
+
+	return -1;
+}
+
+static int sqfs_ls_entry(void *priv, const char *name, int type, u64 ref)
+{
+	struct sqfs_inode inode;
+
+	if (sqfs_read_inode(ref, &inode))
+		return -EIO;
+	switch (type) {
+	case SQFS_DIR_TYPE:
+		printf("<DIR> ");
+		break;
+	case SQFS_SYMLINK_TYPE:
+		printf("<SYM> ");
+		break;
+	case SQFS_REG_TYPE:
+		printf("      ");
+		break;
+	default:
+		printf("< ? > ");
+		break;
+	}
+	printf("%10llu %s\n", sqfs_is_dir(&inode) ? 0 : inode.size, name);
+
+	return 0;
+}
+
+int sqfs_ls(const char *dirname)
+{
+	struct sqfs_inode inode;
+
+	if (sqfs_find(dirname, &inode, 0) || !sqfs_is_dir(&inode)) {
+		printf("** Can not find directory. **\n");
+		return -1;
+	}
+
+	return sqfs_dir_iterate(&inode, sqfs_ls_entry, NULL) ? -1 : 0;
+}
+
+int sqfs_exists(const char *filename)
+{
+	struct sqfs_inode inode;
+
+	return sqfs_find(filename, &inode, 0) == 0;
+}
+
+int sqfs_size(const char *filename, loff_t *size)
+{
+	struct sqfs_inode inode;
+
+	if (sqfs_find(filename, &inode, 0) || !sqfs_is_reg(&inode))
+		return -1;
+	*size = inode.size;
+
+	return 0;
+}
+
+int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread)
+{
+	struct sqfs_inode inode;
+
+	if (sqfs_find(filename, &inode, 0) || !sqfs_is_reg(&inode)) {
+		printf("** File not found %s **\n", filename);
+		return -1;
+	}
+	if (sqfs_read_file(&inode, buf, offset, len, actread)) {
+		printf("** Error reading file %s **\n", filename);
+		return -1;
+	}
+
+	return 0;
+}
+
+void sqfs_close(void)
+{
+	/* The caches are kept, in case the same filesystem is used next */
+	sqfs.win_len = 0;
+}
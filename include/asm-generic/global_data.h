@@ -70,6 +70,9 @@ typedef struct global_data {
 #endif
 
 	const void *fdt_blob;		/* Our device tree, NULL if none */
+#ifdef CONFIG_OF_LIVE
+	struct device_node *of_root;	/* Live tree built from fdt_blob */
+#endif
 	void *new_fdt;			/* Relocated FDT */
 	unsigned long fdt_size;		/* Space reserved for relocated FDT */
 	struct jt_funcs *jt;		/* jump table */
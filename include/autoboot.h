@@ -44,4 +44,78 @@ static inline void autoboot_command(const char *s)
 }
 #endif
 
+#ifdef CONFIG_AUTOBOOT_PREFETCH
+/**
+ * autoboot_prefetch_start() - start loading files during the boot delay
+ *
+ * Any previous prefetch is cancelled. @spec is a list of files separated by
+ * ';', each given as:
+ *
+ *	<interface> <dev[:part]> <addr> <filename>
+ *
+ * as for the 'load' command. The size of each file is found and its first
+ * chunk is read, so that any messages from the filesystem appear before the
+ * countdown starts. The rest is read by autoboot_prefetch_step().
+ *
+ * @spec: List of files to load (normally the "bootprefetch" variable)
+ */
+void autoboot_prefetch_start(const char *spec);
+
+/**
+ * autoboot_prefetch_step() - do a small amount of prefetch work
+ *
+ * This reads one chunk of a file (CONFIG_AUTOBOOT_PREFETCH_CHUNK bytes) or
+ * checks one image once a file is loaded. Files which cannot be read or
+ * which fail verification are dropped.
+ *
+ * @return true if work was done, false if there is nothing left to do
+ */
+bool autoboot_prefetch_step(void);
+
+/**
+ * autoboot_prefetch_cancel() - forget about all prefetched files
+ *
+ * This is called when autoboot is stopped, or once the boot command has
+ * finished, so that a later 'load' always reads from the device.
+ */
+void autoboot_prefetch_cancel(void);
+
+/**
+ * autoboot_prefetch_claim() - use a prefetched file instead of loading it
+ *
+ * The file must have been completely loaded and verified, with the same
+ * interface, device, address and filename. Its CRC32 is checked again in
+ * case the memory has been changed since it was loaded.
+ *
+ * @ifname:	Interface name, e.g. "mmc"
+ * @dev_part:	Device and partition, e.g. "0:1", or NULL
+ * @addr:	Address to load to
+ * @filename:	Name of file
+ * @sizep:	Returns the size of the file
+ * @return true if the file is present at @addr, false if it must be read
+ */
+bool autoboot_prefetch_claim(const char *ifname, const char *dev_part,
+			     ulong addr, const char *filename, loff_t *sizep);
+#else
+static inline void autoboot_prefetch_start(const char *spec)
+{
+}
+
+static inline bool autoboot_prefetch_step(void)
+{
+	return false;
+}
+
+static inline void autoboot_prefetch_cancel(void)
+{
+}
+
+static inline bool autoboot_prefetch_claim(const char *ifname,
+					   const char *dev_part, ulong addr,
+					   const char *filename, loff_t *sizep)
+{
+	return false;
+}
+#endif
+
 #endif
@@ -198,7 +198,11 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_SCSI,
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_OF_LIVE,
 	BOOTSTAGE_ID_FPGA_INIT,
+	BOOTSTAGE_ID_SPL_LOAD,
+	BOOTSTAGE_ID_END_SPL,
+	BOOTSTAGE_ID_RELOCATE,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -225,8 +229,8 @@ ulong timer_get_boot_us(void);
 void show_boot_progress(int val);
 #endif
 
-#if defined(CONFIG_BOOTSTAGE) && !defined(CONFIG_SPL_BUILD) && \
-	!defined(USE_HOSTCC)
+#if defined(CONFIG_BOOTSTAGE) && !defined(USE_HOSTCC) && \
+	(!defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_BOOTSTAGE))
 /* This is the full bootstage implementation */
 
 /**
@@ -35,6 +35,11 @@
 
 #define CONFIG_LMB
 #define CONFIG_ANDROID_BOOT_IMAGE
+#define CONFIG_USB_FUNCTION_MASS_STORAGE
+#define CONFIG_BCH
+
+#define CONFIG_SYS_MAX_NAND_DEVICE	1
+#define CONFIG_SYS_NAND_ONFI_DETECTION
 
 #define CONFIG_CMD_PCI
 #define CONFIG_PCI_PNP
@@ -46,6 +51,11 @@
 #define CONFIG_EXT4_WRITE
 #define CONFIG_CMD_CBFS
 #define CONFIG_CMD_CRAMFS
+#define CONFIG_CMD_JFFS2
+#define CONFIG_JFFS2_NAND
+#define CONFIG_JFFS2_DEV		"nand0"
+#define CONFIG_JFFS2_SUMMARY
+#define CONFIG_SYS_JFFS2_SORT_FRAGMENTS
 #define CONFIG_CMD_PART
 #define CONFIG_DOS_PARTITION
 #define CONFIG_HOST_MAX_DEVICES 4
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Block-level delta updates, from an A slot to a B slot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __DELTA_H
+#define __DELTA_H
+
+#include "compiler.h"
+#include <u-boot/sha256.h>
+
+/*
+ * A delta describes a target image in terms of a source image, one block at
+ * a time, so that an update only has to carry the blocks which changed. It
+ * is laid out as:
+ *
+ *	struct delta_header
+ *	struct delta_op		ops[op_count]
+ *	u8			hash[dst_blocks][DELTA_HASH_SIZE]
+ *	u8			data[][block_size]
+ *
+ * The ops describe the target from its first block to its last. Each covers
+ * @count blocks, which are copied from the source, filled with zeroes or
+ * taken in turn from the data at the end of the delta. The SHA-256 hash of
+ * every target block is included, so each block can be checked before it is
+ * written and a target which was partly written can be recognised. All
+ * values are big-endian.
+ */
+#define DELTA_MAGIC		0x444c5441	/* "DLTA" */
+#define DELTA_VERSION		1
+#define DELTA_HASH_SIZE		SHA256_SUM_LEN
+#define DELTA_MIN_BLOCK_SIZE	512
+#define DELTA_MAX_BLOCK_SIZE	(1 << 20)
+
+enum delta_op_type {
+	DELTA_OP_COPY = 1,	/* copy from source block @arg onwards */
+	DELTA_OP_ZERO,		/* fill with zeroes */
+	DELTA_OP_DATA,		/* take the next blocks from the data */
+};
+
+/**
+ * struct delta_header - header at the start of a delta
+ *
+ * @magic:	DELTA_MAGIC
+ * @version:	DELTA_VERSION
+ * @block_size:	Size of each block in bytes, a power of two
+ * @src_blocks:	Size of the source image in blocks
+ * @dst_blocks:	Size of the target image in blocks
+ * @op_count:	Number of ops
+ * @size:	Total size of the delta in bytes, including this header
+ * @reserved:	Set to 0
+ * @body_hash:	SHA-256 hash of everything after the header
+ */
+struct delta_header {
+	__be32 magic;
+	__be32 version;
+	__be32 block_size;
+	__be32 src_blocks;
+	__be32 dst_blocks;
+	__be32 op_count;
+	__be32 size;
+	__be32 reserved;
+	uint8_t body_hash[DELTA_HASH_SIZE];
+};
+
+/**
+ * struct delta_op - how to produce a run of target blocks
+ *
+ * @type:	Operation (enum delta_op_type)
+ * @count:	Number of blocks
+ * @arg:	For DELTA_OP_COPY, the first source block; otherwise 0
+ * @reserved:	Set to 0
+ */
+struct delta_op {
+	__be32 type;
+	__be32 count;
+	__be32 arg;
+	__be32 reserved;
+};
+
+#ifndef USE_HOSTCC
+#include <part.h>
+
+/**
+ * struct delta_stats - what delta_apply() did, in blocks
+ *
+ * @copied:	Blocks copied from the source
+ * @zeroed:	Blocks filled with zeroes
+ * @data:	Blocks written from the delta's data
+ * @skipped:	Blocks which the target already held, from an earlier
+ *		attempt which was interrupted
+ */
+struct delta_stats {
+	ulong copied;
+	ulong zeroed;
+	ulong data;
+	ulong skipped;
+};
+
+/**
+ * delta_check() - Check that a delta is complete and intact
+ *
+ * @delta:	The delta
+ * @size:	Number of bytes available at @delta
+ * @return 0 if OK, -ENOEXEC if it is not a delta, -EPROTONOSUPPORT if it is
+ * a version we do not understand, -EINVAL if it is inconsistent, -E2BIG if
+ * it runs past @size, -EBADMSG if its hash does not match
+ */
+int delta_check(const struct delta_header *delta, ulong size);
+
+/**
+ * delta_apply() - Write the target image of a delta
+ *
+ * The source is only read and the target is written from start to end, so
+ * the source slot stays bootable throughout. Each target block is checked
+ * against its hash before it is written; a mismatch means that the source is
+ * not the image which the delta was made from.
+ *
+ * If an earlier attempt was interrupted, e.g. by a power failure, calling
+ * this again with the same delta finishes the job. The blocks which the
+ * target already holds are found by their hashes and are not written again,
+ * up to the first one which differs. Only the whole target is correct once
+ * this returns 0, so the target slot should not be marked bootable before
+ * that.
+ *
+ * @delta:	The delta, already checked with delta_check()
+ * @src_desc:	Block device holding the source slot
+ * @src:	Source partition, or a whole device (start 0, size in blocks)
+ * @dst_desc:	Block device holding the target slot
+ * @dst:	Target partition, likewise
+ * @stats:	Returns what was done
+ * @return 0 if OK, -EINVAL if the slots are too small, do not fit the block
+ * size or are the same, -ENOMEM if out of memory, -EIO on a read or write
+ * error, -EILSEQ if a block does not match its hash
+ */
+int delta_apply(const struct delta_header *delta, struct blk_desc *src_desc,
+		disk_partition_t *src, struct blk_desc *dst_desc,
+		disk_partition_t *dst, struct delta_stats *stats);
+#endif
+
+#endif
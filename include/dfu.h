@@ -162,6 +162,20 @@ bool dfu_usb_get_reset(void);
 int dfu_read(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_write(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_flush(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
+void dfu_write_transaction_cleanup(struct dfu_entity *dfu);
+
+#ifdef CONFIG_DFU_WRITE_ASYNC
+/**
+ * dfu_write_poll - let a buffer being written in the background make progress
+ *
+ * This should be called often while waiting for data from the host.
+ */
+void dfu_write_poll(void);
+#else
+static inline void dfu_write_poll(void)
+{
+}
+#endif
 
 /*
  * dfu_defer_flush - pointer to store dfu_entity for deferred flashing.
@@ -11,6 +11,7 @@
 #ifndef _DM_DEVICE_H
 #define _DM_DEVICE_H
 
+#include <dm/ofnode.h>
 #include <dm/uclass-id.h>
 #include <fdtdec.h>
 #include <linker_lists.h>
@@ -19,6 +20,7 @@
 #include <linux/list.h>
 
 struct driver_info;
+struct uthread;
 
 /* Driver is active (probed). Cleared when it is removed */
 #define DM_FLAG_ACTIVATED		(1 << 0)
@@ -46,6 +48,9 @@ struct driver_info;
 
 #define DM_FLAG_OF_PLATDATA		(1 << 8)
 
+/* Device is being probed, by the thread in @prober */
+#define DM_FLAG_PROBING			(1 << 9)
+
 /**
  * struct udevice - An instance of a driver
  *
@@ -69,6 +74,8 @@ struct driver_info;
  * @parent_platdata: The parent bus's configuration data for this device
  * @uclass_platdata: The uclass's configuration data for this device
  * @of_offset: Device tree node offset for this device (- for none)
+ * @node: Reference to the device tree node for this device, which can be
+ *	used with either the live tree or the flat tree
  * @driver_data: Driver data word for the entry that matched this device with
  *		its driver
  * @parent: Parent of this device, or NULL for the top level device
@@ -87,6 +94,8 @@ struct driver_info;
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
  *		automatically when the device is removed / unbound
+ * @prober: Thread probing this device while DM_FLAG_PROBING is set, or NULL
+ *		for the main thread
  */
 struct udevice {
 	const struct driver *driver;
@@ -95,6 +104,7 @@ struct udevice {
 	void *parent_platdata;
 	void *uclass_platdata;
 	int of_offset;
+	ofnode node;
 	ulong driver_data;
 	struct udevice *parent;
 	void *priv;
@@ -110,8 +120,22 @@ struct udevice {
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
+#ifdef CONFIG_UTHREAD
+	struct uthread *prober;
+#endif
 };
 
+/**
+ * dev_ofnode() - get the device tree node for a device
+ *
+ * @dev:	Device to check
+ * @return reference to the node, which is not valid if the device has none
+ */
+static inline ofnode dev_ofnode(struct udevice *dev)
+{
+	return dev->node;
+}
+
 /* Maximum sequence number supported */
 #define DM_MAX_SEQ	999
 
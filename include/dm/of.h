@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Live (unflattened) device tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _DM_OF_H
+#define _DM_OF_H
+
+#include <asm/u-boot.h>
+#include <asm/global_data.h>
+
+/**
+ * struct property - A property in the live tree
+ *
+ * @name:	Property name, pointing into the flat tree
+ * @length:	Length of the value in bytes
+ * @value:	Property value, pointing into the flat tree
+ * @next:	Next property in the same node, or NULL if none
+ */
+struct property {
+	const char *name;
+	int length;
+	const void *value;
+	struct property *next;
+};
+
+/**
+ * struct device_node - A node in the live tree
+ *
+ * The live tree is built from the flat tree once, after relocation. Names
+ * and values point into the flat tree, which must therefore stay where it
+ * is. Each node remembers its offset in the flat tree, so that code which
+ * still uses offsets keeps working.
+ *
+ * @name:	Node name, without the unit address, e.g. "serial"
+ * @full_name:	Node name as it appears in the tree, e.g. "serial@f00"
+ * @phandle:	Phandle of the node, or 0 if none
+ * @of_offset:	Offset of this node in the flat tree
+ * @properties:	First property, or NULL if none
+ * @parent:	Parent node, or NULL for the root
+ * @child:	First child node, or NULL if none
+ * @sibling:	Next node with the same parent, or NULL if none
+ */
+struct device_node {
+	const char *name;
+	const char *full_name;
+	uint32_t phandle;
+	int of_offset;
+	struct property *properties;
+	struct device_node *parent;
+	struct device_node *child;
+	struct device_node *sibling;
+};
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * of_live_active() - check if the live tree is in use
+ *
+ * @return true if driver model should use the live tree, false if it should
+ * use the flat tree
+ */
+static inline bool of_live_active(void)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE)
+	return gd->of_root != NULL;
+#else
+	return false;
+#endif
+}
+
+/**
+ * gd_of_root() - get the root of the live tree
+ *
+ * @return root node, or NULL if the live tree is not in use
+ */
+static inline struct device_node *gd_of_root(void)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE)
+	return gd->of_root;
+#else
+	return NULL;
+#endif
+}
+
+#endif
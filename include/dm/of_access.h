@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Functions for reading the live device tree. These are modelled on the
+ * Linux functions of the same name.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _DM_OF_ACCESS_H
+#define _DM_OF_ACCESS_H
+
+#include <dm/of.h>
+
+/**
+ * of_find_property() - Find a property in a node
+ *
+ * @np:		Node to look in
+ * @name:	Name of property
+ * @lenp:	If non-NULL, returns the length of the property value
+ * @return property, or NULL if not found
+ */
+struct property *of_find_property(const struct device_node *np,
+				  const char *name, int *lenp);
+
+/**
+ * of_get_property() - Get the value of a property
+ *
+ * @np:		Node to look in
+ * @name:	Name of property
+ * @lenp:	If non-NULL, returns the length of the property value
+ * @return pointer to value, or NULL if not found
+ */
+const void *of_get_property(const struct device_node *np, const char *name,
+			    int *lenp);
+
+/**
+ * of_read_u32_array() - Read an array of 32-bit integers from a property
+ *
+ * @np:		Node to look in
+ * @propname:	Name of property
+ * @out_values:	Returns the values, in CPU byte order
+ * @sz:		Number of values to read
+ * @return 0 if OK, -EINVAL if the property does not exist, -EOVERFLOW if it
+ * is too short
+ */
+int of_read_u32_array(const struct device_node *np, const char *propname,
+		      u32 *out_values, size_t sz);
+
+/**
+ * of_read_u32() - Read a 32-bit integer from a property
+ *
+ * @np:		Node to look in
+ * @propname:	Name of property
+ * @outp:	Returns the value, in CPU byte order
+ * @return 0 if OK, -EINVAL if the property does not exist, -EOVERFLOW if it
+ * is too short
+ */
+int of_read_u32(const struct device_node *np, const char *propname, u32 *outp);
+
+/**
+ * of_device_is_available() - Check if a node is enabled
+ *
+ * @np:		Node to check
+ * @return true if the status property is missing or "okay"
+ */
+bool of_device_is_available(const struct device_node *np);
+
+/**
+ * of_node_is_compatible() - Check if a node has a compatible string
+ *
+ * @np:		Node to check
+ * @compat:	Compatible string to look for
+ * @return true if @compat is in the node's compatible list
+ */
+bool of_node_is_compatible(const struct device_node *np, const char *compat);
+
+/**
+ * of_find_subnode() - Find a subnode by name
+ *
+ * As with fdt_subnode_offset(), a name without a unit address matches a
+ * node that has one.
+ *
+ * @np:		Parent node
+ * @name:	Name of subnode, possibly including a unit address
+ * @len:	Length of @name
+ * @return subnode, or NULL if not found
+ */
+struct device_node *of_find_subnode(const struct device_node *np,
+				    const char *name, int len);
+
+/**
+ * of_find_node_by_path() - Find a node by path or alias
+ *
+ * @root:	Root of the tree
+ * @path:	Full path, or alias optionally followed by a path
+ * @return node, or NULL if not found
+ */
+struct device_node *of_find_node_by_path(const struct device_node *root,
+					 const char *path);
+
+/**
+ * of_find_node_by_phandle() - Find a node by phandle
+ *
+ * @root:	Root of the tree
+ * @phandle:	Phandle to look for
+ * @return node, or NULL if not found
+ */
+struct device_node *of_find_node_by_phandle(const struct device_node *root,
+					    uint32_t phandle);
+
+/**
+ * of_find_node_by_offset() - Find the node for an offset in the flat tree
+ *
+ * This descends from the root, only looking at the children of each node
+ * on the way, so takes time in proportion to the depth of the node.
+ *
+ * @root:	Root of the tree
+ * @offset:	Offset of node in the flat tree the live tree was built from
+ * @return node, or NULL if not found
+ */
+struct device_node *of_find_node_by_offset(const struct device_node *root,
+					   int offset);
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * A reference to a device tree node which works with either the live tree
+ * or the flat tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _DM_OFNODE_H
+#define _DM_OFNODE_H
+
+#include <dm/of.h>
+
+/**
+ * ofnode - reference to a device tree node
+ *
+ * This union can hold either a pointer to a live tree node or an offset into
+ * the flat tree. Which one is used depends on of_live_active(), so code that
+ * uses the functions below works unchanged with either tree.
+ *
+ * With the live tree, moving to the parent, first child or next sibling just
+ * follows a pointer. With the flat tree, each of these requires a walk
+ * through the structure block, and finding the parent requires a walk from
+ * the start of the tree.
+ *
+ * @np: Pointer to the node in the live tree, or NULL if none
+ * @of_offset: Offset of the node in the flat tree, or -1 if none
+ */
+typedef union ofnode_union {
+	const struct device_node *np;
+	long of_offset;
+} ofnode;
+
+/**
+ * ofnode_to_np() - Get the live tree node for an ofnode
+ *
+ * This must only be used when the live tree is active.
+ *
+ * @node: Reference to node
+ * @return live tree node, or NULL if none
+ */
+static inline const struct device_node *ofnode_to_np(ofnode node)
+{
+	return node.np;
+}
+
+/**
+ * ofnode_to_offset() - Get the flat tree offset for an ofnode
+ *
+ * This works with both trees, since each live tree node records its offset
+ * in the flat tree.
+ *
+ * @node: Reference to node
+ * @return offset of the node in gd->fdt_blob, or -1 if none
+ */
+static inline int ofnode_to_offset(ofnode node)
+{
+	if (of_live_active())
+		return node.np ? node.np->of_offset : -1;
+
+	return node.of_offset;
+}
+
+/**
+ * ofnode_valid() - Check if an ofnode refers to a node
+ *
+ * @node: Reference to check
+ * @return true if it refers to a node, false if not
+ */
+static inline bool ofnode_valid(ofnode node)
+{
+	if (of_live_active())
+		return node.np != NULL;
+
+	return node.of_offset >= 0;
+}
+
+/**
+ * ofnode_null() - Get an ofnode which does not refer to any node
+ *
+ * @return null reference
+ */
+static inline ofnode ofnode_null(void)
+{
+	ofnode node;
+
+	if (of_live_active())
+		node.np = NULL;
+	else
+		node.of_offset = -1;
+
+	return node;
+}
+
+/**
+ * np_to_ofnode() - Get an ofnode for a live tree node
+ *
+ * @np: Live tree node
+ * @return reference to the node
+ */
+static inline ofnode np_to_ofnode(const struct device_node *np)
+{
+	ofnode node;
+
+	node.np = np;
+
+	return node;
+}
+
+/**
+ * ofnode_equal() - Check if two ofnodes refer to the same node
+ *
+ * @a: First reference
+ * @b: Second reference
+ * @return true if they are the same
+ */
+static inline bool ofnode_equal(ofnode a, ofnode b)
+{
+	/* Both members are the same size, so this works for both trees */
+	return a.of_offset == b.of_offset;
+}
+
+/**
+ * offset_to_ofnode() - Get an ofnode for an offset in the flat tree
+ *
+ * With the live tree this has to find the node, which takes time in
+ * proportion to its depth in the tree. Code that walks the tree should use
+ * the ofnode functions throughout rather than converting offsets.
+ *
+ * @of_offset: Offset in gd->fdt_blob, or -1 for none
+ * @return reference to the node, or a null reference if not found
+ */
+ofnode offset_to_ofnode(int of_offset);
+
+/**
+ * ofnode_root() - Get the root node of the tree
+ *
+ * @return reference to the root node
+ */
+ofnode ofnode_root(void);
+
+/**
+ * ofnode_read_prop() - Read the value of a property
+ *
+ * @node:	Node to read from
+ * @propname:	Name of property
+ * @lenp:	If non-NULL, returns the length of the value, or -FDT_ERR_...
+ *		if not found
+ * @return pointer to value, or NULL if not found
+ */
+const void *ofnode_read_prop(ofnode node, const char *propname, int *lenp);
+
+/**
+ * ofnode_read_u32() - Read a 32-bit integer from a property
+ *
+ * @node:	Node to read from
+ * @propname:	Name of property
+ * @outp:	Returns the value, in CPU byte order
+ * @return 0 if OK, -EINVAL if the property does not exist, -EOVERFLOW if it
+ * is too short
+ */
+int ofnode_read_u32(ofnode node, const char *propname, u32 *outp);
+
+/**
+ * ofnode_read_u32_default() - Read a 32-bit integer from a property
+ *
+ * This is the ofnode version of fdtdec_get_int().
+ *
+ * @node:	Node to read from
+ * @propname:	Name of property
+ * @def:	Value to return if the property cannot be read
+ * @return value read, or @def
+ */
+u32 ofnode_read_u32_default(ofnode node, const char *propname, u32 def);
+
+/**
+ * ofnode_read_u32_array() - Read an array of 32-bit integers from a property
+ *
+ * This is the ofnode version of fdtdec_get_int_array().
+ *
+ * @node:	Node to read from
+ * @propname:	Name of property
+ * @out_values:	Returns the values, in CPU byte order
+ * @sz:		Number of values to read
+ * @return 0 if OK, -EINVAL if the property does not exist, -EOVERFLOW if it
+ * is too short
+ */
+int ofnode_read_u32_array(ofnode node, const char *propname,
+			  u32 *out_values, size_t sz);
+
+/**
+ * ofnode_read_string() - Read a string from a property
+ *
+ * @node:	Node to read from
+ * @propname:	Name of property
+ * @return string, or NULL if the property does not exist or is not a
+ * nul-terminated string
+ */
+const char *ofnode_read_string(ofnode node, const char *propname);
+
+/**
+ * ofnode_read_bool() - Check if a property is present
+ *
+ * @node:	Node to read from
+ * @propname:	Name of property
+ * @return true if present, false if not
+ */
+bool ofnode_read_bool(ofnode node, const char *propname);
+
+/**
+ * ofnode_get_name() - Get the name of a node
+ *
+ * @node:	Node to check
+ * @return name, including any unit address
+ */
+const char *ofnode_get_name(ofnode node);
+
+/**
+ * ofnode_get_phandle() - Get the phandle of a node
+ *
+ * @node:	Node to check
+ * @return phandle, or 0 if none
+ */
+uint32_t ofnode_get_phandle(ofnode node);
+
+/**
+ * ofnode_is_available() - Check if a node is enabled
+ *
+ * This is the ofnode version of fdtdec_get_is_enabled().
+ *
+ * @node:	Node to check
+ * @return true if the status property is missing, "okay" or "ok"
+ */
+bool ofnode_is_available(ofnode node);
+
+/**
+ * ofnode_device_is_compatible() - Check if a node has a compatible string
+ *
+ * @node:	Node to check
+ * @compat:	Compatible string to look for
+ * @return true if @compat is in the node's compatible list
+ */
+bool ofnode_device_is_compatible(ofnode node, const char *compat);
+
+/**
+ * ofnode_first_subnode() - Get the first subnode of a node
+ *
+ * @node:	Parent node
+ * @return first subnode, or a null reference if none
+ */
+ofnode ofnode_first_subnode(ofnode node);
+
+/**
+ * ofnode_next_subnode() - Get the next sibling of a node
+ *
+ * @node:	Current node
+ * @return next node with the same parent, or a null reference if none
+ */
+ofnode ofnode_next_subnode(ofnode node);
+
+/**
+ * ofnode_find_subnode() - Find a subnode by name
+ *
+ * @node:	Parent node
+ * @name:	Name of subnode
+ * @return subnode, or a null reference if not found
+ */
+ofnode ofnode_find_subnode(ofnode node, const char *name);
+
+/**
+ * ofnode_get_parent() - Get the parent of a node
+ *
+ * @node:	Node to check
+ * @return parent, or a null reference for the root node
+ */
+ofnode ofnode_get_parent(ofnode node);
+
+/**
+ * ofnode_path() - Find a node by path or alias
+ *
+ * @path:	Full path, or alias optionally followed by a path
+ * @return node, or a null reference if not found
+ */
+ofnode ofnode_path(const char *path);
+
+/**
+ * ofnode_get_by_phandle() - Find a node by phandle
+ *
+ * @phandle:	Phandle to look for
+ * @return node, or a null reference if not found
+ */
+ofnode ofnode_get_by_phandle(uint32_t phandle);
+
+/**
+ * ofnode_for_each_subnode() - Iterate over the subnodes of a node
+ *
+ * @node:	Variable used as the iterator (ofnode)
+ * @parent:	Parent node (ofnode)
+ */
+#define ofnode_for_each_subnode(node, parent) \
+	for (node = ofnode_first_subnode(parent); \
+	     ofnode_valid(node); \
+	     node = ofnode_next_subnode(node))
+
+#endif
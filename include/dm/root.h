@@ -38,7 +38,8 @@ int dm_scan_platdata(bool pre_reloc_only);
  * This scans the device tree and creates a driver for each node. Only
  * the top-level subnodes are examined.
  *
- * @blob: Pointer to device tree blob
+ * @blob: Pointer to device tree blob, which must be gd->fdt_blob. If the
+ * live tree is active it is scanned instead.
  * @pre_reloc_only: If true, bind only drivers with the DM_FLAG_PRE_RELOC
  * flag. If false bind all drivers.
  * @return 0 if OK, -ve on error
@@ -52,7 +53,8 @@ int dm_scan_fdt(const void *blob, bool pre_reloc_only);
  * for each one.
  *
  * @parent: Parent device for the devices that will be created
- * @blob: Pointer to device tree blob
+ * @blob: Pointer to device tree blob, which must be gd->fdt_blob. If the
+ * live tree is active it is scanned instead.
  * @offset: Offset of node to scan
  * @pre_reloc_only: If true, bind only drivers with the DM_FLAG_PRE_RELOC
  * flag. If false bind all drivers.
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * EROFS on-disk format and read-only filesystem support
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __EROFS_H
+#define __EROFS_H
+
+#include <part.h>
+
+#define EROFS_SUPER_OFFSET	1024
+#define EROFS_SUPER_MAGIC	0xe0f5e1e2
+
+#define EROFS_MIN_BLKSZBITS	9
+#define EROFS_MAX_BLKSZBITS	16
+
+/* Inodes are found at meta_blkaddr plus their nid times the slot size */
+#define EROFS_ISLOTBITS		5
+
+#define EROFS_FEATURE_COMPAT_SB_CHKSUM		0x00000001
+
+#define EROFS_FEATURE_INCOMPAT_ZERO_PADDING	0x00000001
+#define EROFS_FEATURE_INCOMPAT_COMPR_CFGS	0x00000002
+#define EROFS_FEATURE_INCOMPAT_BIG_PCLUSTER	0x00000002
+#define EROFS_FEATURE_INCOMPAT_CHUNKED_FILE	0x00000004
+#define EROFS_FEATURE_INCOMPAT_DEVICE_TABLE	0x00000008
+#define EROFS_FEATURE_INCOMPAT_ZTAILPACKING	0x00000010
+#define EROFS_FEATURE_INCOMPAT_FRAGMENTS	0x00000020
+#define EROFS_FEATURE_INCOMPAT_XATTR_PREFIXES	0x00000040
+
+struct erofs_super_block {
+	__le32 magic;
+	__le32 checksum;
+	__le32 feature_compat;
+	__u8 blkszbits;
+	__u8 sb_extslots;
+	__le16 root_nid;
+	__le64 inos;
+	__le64 build_time;
+	__le32 build_time_nsec;
+	__le32 blocks;
+	__le32 meta_blkaddr;
+	__le32 xattr_blkaddr;
+	__u8 uuid[16];
+	__u8 volume_name[16];
+	__le32 feature_incompat;
+	__le16 available_compr_algs;
+	__le16 extra_devices;
+	__le16 devt_slotoff;
+	__u8 reserved[38];
+} __packed;
+
+/* i_format holds the version in bit 0 and the data layout above it */
+#define EROFS_I_VERSION_BIT		0
+#define EROFS_I_DATALAYOUT_BIT		1
+#define EROFS_I_DATALAYOUT_MASK		0x7
+
+#define EROFS_INODE_LAYOUT_COMPACT	0
+#define EROFS_INODE_LAYOUT_EXTENDED	1
+
+enum {
+	EROFS_INODE_FLAT_PLAIN,		/* data blocks from raw_blkaddr */
+	EROFS_INODE_COMPRESSED_FULL,	/* 8-byte cluster indexes */
+	EROFS_INODE_FLAT_INLINE,	/* as plain, last block after inode */
+	EROFS_INODE_COMPRESSED_COMPACT,	/* packed cluster indexes */
+	EROFS_INODE_CHUNK_BASED,
+};
+
+struct erofs_inode_compact {
+	__le16 i_format;
+	__le16 i_xattr_icount;
+	__le16 i_mode;
+	__le16 i_nlink;
+	__le32 i_size;
+	__le32 i_reserved;
+	__le32 i_u;		/* raw_blkaddr, compressed_blocks or rdev */
+	__le32 i_ino;
+	__le16 i_uid;
+	__le16 i_gid;
+	__le32 i_reserved2;
+} __packed;
+
+struct erofs_inode_extended {
+	__le16 i_format;
+	__le16 i_xattr_icount;
+	__le16 i_mode;
+	__le16 i_reserved;
+	__le64 i_size;
+	__le32 i_u;
+	__le32 i_ino;
+	__le32 i_uid;
+	__le32 i_gid;
+	__le64 i_mtime;
+	__le32 i_mtime_nsec;
+	__le32 i_nlink;
+	__u8 i_reserved2[16];
+} __packed;
+
+/*
+ * Extended attributes follow the inode: a 12-byte header and then
+ * i_xattr_icount - 1 further 4-byte slots
+ */
+#define EROFS_XATTR_IBODY_HEADER_SIZE	12
+#define EROFS_XATTR_ENTRY_SIZE		4
+
+/*
+ * Each directory block starts with an array of entries. The name offset of
+ * the first one gives the number of entries; names are not terminated.
+ */
+struct erofs_dirent {
+	__le64 nid;
+	__le16 nameoff;
+	__u8 file_type;
+	__u8 reserved;
+} __packed;
+
+enum {
+	EROFS_FT_UNKNOWN,
+	EROFS_FT_REG_FILE,
+	EROFS_FT_DIR,
+	EROFS_FT_CHRDEV,
+	EROFS_FT_BLKDEV,
+	EROFS_FT_FIFO,
+	EROFS_FT_SOCK,
+	EROFS_FT_SYMLINK,
+};
+
+/* Compressed files: a map header at the next 8-byte boundary after xattrs */
+#define Z_EROFS_ADVISE_COMPACTED_2B		0x0001
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_1		0x0002
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_2		0x0004
+#define Z_EROFS_ADVISE_INLINE_PCLUSTER		0x0008
+#define Z_EROFS_ADVISE_INTERLACED_PCLUSTER	0x0010
+#define Z_EROFS_ADVISE_FRAGMENT_PCLUSTER	0x0020
+
+#define Z_EROFS_COMPRESSION_LZ4		0
+
+struct z_erofs_map_header {
+	__le32 h_reserved1;
+	__le16 h_advise;
+	__u8 h_algorithmtype;	/* low 4 bits for HEAD1 clusters */
+	__u8 h_clusterbits;	/* low 3 bits: lcluster bits - blkszbits */
+} __packed;
+
+/* Logical cluster types */
+enum {
+	Z_EROFS_LCLUSTER_TYPE_PLAIN,
+	Z_EROFS_LCLUSTER_TYPE_HEAD1,
+	Z_EROFS_LCLUSTER_TYPE_NONHEAD,
+	Z_EROFS_LCLUSTER_TYPE_HEAD2,
+};
+
+#define Z_EROFS_LI_LCLUSTER_TYPE_MASK	0x3
+#define Z_EROFS_LI_PARTIAL_REF		(1 << 15)
+#define Z_EROFS_LI_D0_CBLKCNT		(1 << 11)
+
+/*
+ * Full cluster indexes start 8 bytes after the map header, one per logical
+ * cluster. A HEAD or PLAIN cluster starts an extent at di_clusterofs and
+ * gives its physical block; a NONHEAD cluster gives the distance back to
+ * the cluster which started its extent in delta[0].
+ */
+struct z_erofs_lcluster_index {
+	__le16 di_advise;
+	__le16 di_clusterofs;
+	union {
+		__le32 blkaddr;
+		__le16 delta[2];
+	} di_u;
+} __packed;
+
+int erofs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition);
+int erofs_ls(const char *dirname);
+int erofs_exists(const char *filename);
+int erofs_size(const char *filename, loff_t *size);
+int erofs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	       loff_t *actread);
+void erofs_close(void);
+
+#endif /* __EROFS_H */
@@ -134,6 +134,21 @@ typedef struct volume_info
 	/* Boot sign comes last, 2 bytes */
 } volume_info;
 
+/* FAT32 filesystem information sector */
+#define FSINFO_LEAD_SIG		0x41615252
+#define FSINFO_STRUCT_SIG	0x61417272
+#define FSINFO_UNKNOWN		0xffffffff
+
+struct fsinfo_sector {
+	__u32	lead_sig;	/* FSINFO_LEAD_SIG */
+	__u8	reserved1[480];
+	__u32	struct_sig;	/* FSINFO_STRUCT_SIG */
+	__u32	free_count;	/* Free clusters, or FSINFO_UNKNOWN */
+	__u32	next_free;	/* Where to look for a free cluster */
+	__u8	reserved2[12];
+	__u32	trail_sig;	/* 0xaa550000 */
+};
+
 typedef struct dir_entry {
 	char	name[8],ext[3];	/* Name and extension */
 	__u8	attr;		/* Attribute bits */
@@ -4,6 +4,19 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
-void fb_mmc_flash_write(const char *cmd, void *download_buffer,
+/**
+ * fb_mmc_flash_write() - write a downloaded image to an eMMC partition
+ *
+ * The result is reported with fastboot_okay() or fastboot_fail().
+ *
+ * @cmd:		Name of the partition, or of the partition table
+ * @offset:		Byte offset within the partition at which to write a
+ *			raw image, so that an image larger than the download
+ *			buffer can be written in parts. This must be 0 for
+ *			sparse images and partition tables.
+ * @download_buffer:	Image to write
+ * @download_bytes:	Size of the image in bytes
+ */
+void fb_mmc_flash_write(const char *cmd, u64 offset, void *download_buffer,
 			unsigned int download_bytes);
 void fb_mmc_erase(const char *cmd);
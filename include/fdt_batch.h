@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Batched editing of a flattened device tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __FDT_BATCH_H
+#define __FDT_BATCH_H
+
+#include <libfdt.h>
+
+/* Number of property names remembered by a batch */
+#define FDT_BATCH_STRING_CACHE	64
+
+/**
+ * struct fdt_batch - A set of edits waiting to be applied to a device tree
+ *
+ * Each call to fdt_setprop() or fdt_add_subnode() moves everything after
+ * the change, so making many changes to a large tree takes time in
+ * proportion to the number of changes multiplied by the size of the tree.
+ * A batch collects the changes instead, leaving the tree untouched, then
+ * writes the final tree in a single pass when it is committed.
+ *
+ * Since the tree does not change until the batch is committed, node offsets
+ * obtained from the tree stay valid while the batch is built. Nodes added by
+ * the batch are given offsets beyond the end of the tree, which can be used
+ * with the batch functions but not with libfdt.
+ *
+ * The result is the same tree as making the changes one by one with libfdt.
+ * In particular, new properties go at the start of their node and new
+ * subnodes go after the properties of their parent, so the most recent
+ * addition comes first in each case.
+ *
+ * @fdt:		Device tree being edited
+ * @struct_size:	Size of its structure block
+ * @strings:		Property names added by the batch
+ * @strings_size:	Number of bytes used in @strings
+ * @strings_max:	Number of bytes allocated for @strings
+ * @vals:		Property values and node names used by the batch
+ * @vals_size:		Number of bytes used in @vals
+ * @vals_max:		Number of bytes allocated for @vals
+ * @props:		Property edits, in the order they were made
+ * @prop_count:		Number of entries used in @props
+ * @prop_max:		Number of entries allocated for @props
+ * @nodes:		Nodes added, in the order they were added
+ * @node_count:		Number of entries used in @nodes
+ * @node_max:		Number of entries allocated for @nodes
+ * @out:		Buffer used while writing the new tree
+ * @out_pos:		Number of bytes written to @out
+ * @string_cache:	Offsets of recently used property names plus one,
+ *			indexed by a hash of the name, or 0 if unused
+ */
+struct fdt_batch {
+	void *fdt;
+	int struct_size;
+	char *strings;
+	int strings_size;
+	int strings_max;
+	char *vals;
+	int vals_size;
+	int vals_max;
+	struct fdt_batch_prop *props;
+	int prop_count;
+	int prop_max;
+	struct fdt_batch_node *nodes;
+	int node_count;
+	int node_max;
+	char *out;
+	int out_pos;
+	int string_cache[FDT_BATCH_STRING_CACHE];
+};
+
+/**
+ * fdt_batch_init() - Start a new batch of edits to a device tree
+ *
+ * @batch:	Batch to set up
+ * @fdt:	Device tree to edit
+ * @return 0 if OK, -FDT_ERR_... if the tree cannot be edited
+ */
+int fdt_batch_init(struct fdt_batch *batch, void *fdt);
+
+/**
+ * fdt_batch_setprop() - Set the value of a property, creating it if needed
+ *
+ * This is the batch version of fdt_setprop().
+ *
+ * @batch:	Batch to add to
+ * @nodeoffset:	Offset of node, from the tree or fdt_batch_add_subnode()
+ * @name:	Name of property
+ * @val:	Value of property (copied into the batch)
+ * @len:	Length of value in bytes
+ * @return 0 if OK, -FDT_ERR_... on error
+ */
+int fdt_batch_setprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name, const void *val, int len);
+
+static inline int fdt_batch_setprop_u32(struct fdt_batch *batch,
+					int nodeoffset, const char *name,
+					uint32_t val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return fdt_batch_setprop(batch, nodeoffset, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_string(struct fdt_batch *batch,
+					   int nodeoffset, const char *name,
+					   const char *str)
+{
+	return fdt_batch_setprop(batch, nodeoffset, name, str,
+				 strlen(str) + 1);
+}
+
+/**
+ * fdt_batch_getprop() - Get the value a property will have after the batch
+ *
+ * @batch:	Batch to check
+ * @nodeoffset:	Offset of node, from the tree or fdt_batch_add_subnode()
+ * @name:	Name of property
+ * @lenp:	If non-NULL, returns the length of the value, or -FDT_ERR_...
+ *		if there is no value
+ * @return pointer to the value, or NULL if the property will not exist
+ */
+const void *fdt_batch_getprop(struct fdt_batch *batch, int nodeoffset,
+			      const char *name, int *lenp);
+
+/**
+ * fdt_batch_delprop() - Delete a property
+ *
+ * This is the batch version of fdt_delprop().
+ *
+ * @batch:	Batch to add to
+ * @nodeoffset:	Offset of node, from the tree or fdt_batch_add_subnode()
+ * @name:	Name of property
+ * @return 0 if OK, -FDT_ERR_NOTFOUND if there is no such property
+ */
+int fdt_batch_delprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name);
+
+/**
+ * fdt_batch_subnode_offset() - Find a subnode, including those to be added
+ *
+ * This is the batch version of fdt_subnode_offset().
+ *
+ * @batch:	Batch to check
+ * @parentoffset: Offset of parent node
+ * @name:	Name of subnode
+ * @return offset of subnode, -FDT_ERR_NOTFOUND if none, or other
+ * -FDT_ERR_... on error
+ */
+int fdt_batch_subnode_offset(struct fdt_batch *batch, int parentoffset,
+			     const char *name);
+
+/**
+ * fdt_batch_add_subnode() - Add a new subnode to a node
+ *
+ * This is the batch version of fdt_add_subnode().
+ *
+ * @batch:	Batch to add to
+ * @parentoffset: Offset of parent node
+ * @name:	Name of subnode
+ * @return offset of new subnode (for use with this batch only),
+ * -FDT_ERR_EXISTS if it already exists, or other -FDT_ERR_... on error
+ */
+int fdt_batch_add_subnode(struct fdt_batch *batch, int parentoffset,
+			  const char *name);
+
+/**
+ * fdt_batch_commit() - Apply a batch of edits to the device tree
+ *
+ * This writes the new tree in a single pass and frees the batch. If there
+ * is not enough space in the tree for the edits, it is left unchanged.
+ *
+ * @batch:	Batch to apply
+ * @return 0 if OK, -FDT_ERR_NOSPACE if the tree is too small, or other
+ * -FDT_ERR_... on error
+ */
+int fdt_batch_commit(struct fdt_batch *batch);
+
+/**
+ * fdt_batch_free() - Drop a batch of edits without applying them
+ *
+ * @batch:	Batch to free
+ */
+void fdt_batch_free(struct fdt_batch *batch);
+
+#endif
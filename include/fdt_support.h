@@ -248,6 +248,26 @@ int arch_fixup_memory_node(void *blob);
 int fdt_setup_simplefb_node(void *fdt, int node, u64 base_address, u32 width,
 			    u32 height, u32 stride, const char *format);
 
+/**
+ * fdt_overlay_apply_list() - Apply a list of overlays to a device tree
+ *
+ * This gives the same result as calling fdt_overlay_apply() for each
+ * overlay in turn, but is much faster when there are many fixups or
+ * overlays. The phandles and symbols in the base tree are indexed once,
+ * then the overlays are merged and the new tree written in a single pass.
+ *
+ * Unlike fdt_overlay_apply(), the base tree is left unchanged if there is
+ * an error. Each overlay which has been fixed up is changed, and its magic
+ * erased: that is all of them on success, and on error those up to and
+ * including the one which failed. Any later overlays are left alone.
+ *
+ * @fdt:	Base device tree, with enough space for the result
+ * @fdtos:	Overlays to apply, in order
+ * @count:	Number of overlays
+ * @return 0 if OK, -FDT_ERR_... on error
+ */
+int fdt_overlay_apply_list(void *fdt, void *const fdtos[], int count);
+
 #endif /* ifdef CONFIG_OF_LIBFDT */
 
 #ifdef USE_HOSTCC
@@ -13,6 +13,8 @@
 #define FS_TYPE_EXT	2
 #define FS_TYPE_SANDBOX	3
 #define FS_TYPE_UBIFS	4
+#define FS_TYPE_SQUASHFS 5
+#define FS_TYPE_EROFS	6
 
 /*
  * Tell the fs layer which block device an partition to use for future
@@ -78,6 +80,32 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	     loff_t *actwrite);
 
+/**
+ * fs_clean_path() - Tidy up a path before looking it up
+ *
+ * @path:	Path to tidy up
+ * @return a copy of @path, allocated with malloc(), without any empty, "."
+ * or ".." components nor a leading slash; NULL if out of memory
+ */
+char *fs_clean_path(const char *path);
+
+/**
+ * fs_link_path() - Work out the path to look up in place of a symbolic link
+ *
+ * This is for filesystems which look up a path from fs_clean_path() by
+ * splitting off one component at a time with strsep(), so that the
+ * directories before @name are separated by NULs rather than slashes.
+ *
+ * @path:	Path being looked up, as returned by fs_clean_path()
+ * @name:	Component of @path which is a symbolic link
+ * @target:	Target of the link, from the root if it starts with a slash,
+ *		else from the directory holding the link
+ * @rest:	Components of @path after @name, or NULL if none
+ * @return new path, allocated with malloc(), or NULL if out of memory
+ */
+char *fs_link_path(const char *path, const char *name, const char *target,
+		   const char *rest);
+
 /*
  * Common implementation for various filesystem commands, optionally limited
  * to a specific filesystem type via the fstype parameter.
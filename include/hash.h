@@ -114,6 +114,18 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+/**
+ * hash_bench() - Measure the throughput of each hash algorithm and engine
+ *
+ * Each algorithm in the built-in table is timed, followed by each hash
+ * engine (UCLASS_HASH) which supports it. The results are printed in MB/s.
+ *
+ * @size:	Number of bytes to hash in each pass
+ * @count:	Number of passes for each algorithm/engine pair
+ * @return 0 if ok, -ENOMEM if the test buffer could not be allocated
+ */
+int hash_bench(unsigned int size, unsigned int count);
+
 #endif /* !USE_HOSTCC */
 
 /**
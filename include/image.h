@@ -889,6 +889,103 @@ int bootz_setup(ulong image, ulong *start, ulong *end);
 
 #define FIT_MAX_HASH_LEN	HASH_MAX_DIGEST_SIZE
 
+#if defined(CONFIG_FIT_HASH_CACHE) && !defined(USE_HOSTCC) && \
+	!defined(CONFIG_SPL_BUILD)
+# define IMAGE_ENABLE_HASH_CACHE	1
+#else
+# define IMAGE_ENABLE_HASH_CACHE	0
+#endif
+
+/**
+ * struct fit_hash_cache_stats - Statistics about the FIT hash cache
+ *
+ * @hits:	Number of digests found in the cache
+ * @misses:	Number of digests which had to be calculated
+ * @bytes:	Number of bytes hashed on a miss
+ */
+struct fit_hash_cache_stats {
+	uint hits;
+	uint misses;
+	ulong bytes;
+};
+
+#if IMAGE_ENABLE_HASH_CACHE
+/**
+ * fit_hash_cache_start() - Start remembering digests of FIT data
+ *
+ * This empties the cache and resets the statistics. Until
+ * fit_hash_cache_stop() is called, digests of image data calculated while
+ * verifying a FIT are remembered, keyed by the data address, size and
+ * algorithm, so that the same data is not hashed again. The caller must
+ * make sure that the data does not change in the meantime.
+ */
+void fit_hash_cache_start(void);
+
+/**
+ * fit_hash_cache_stop() - Stop using the FIT hash cache
+ *
+ * Remembered digests are discarded. The statistics remain available.
+ */
+void fit_hash_cache_stop(void);
+
+/**
+ * fit_hash_cache_lookup() - Look up the digest of some data
+ *
+ * @data:	Start of data
+ * @size:	Size of data in bytes
+ * @algo:	Hash algorithm name (e.g. "sha256")
+ * @value:	Returns the digest, if found
+ * @value_len:	Returns the size of the digest in bytes, if found
+ * @return 0 if found, -ve if not (or the cache is not active)
+ */
+int fit_hash_cache_lookup(const void *data, ulong size, const char *algo,
+			  uint8_t *value, int *value_len);
+
+/**
+ * fit_hash_cache_add() - Remember the digest of some data
+ *
+ * This does nothing if the cache is not active.
+ *
+ * @data:	Start of data
+ * @size:	Size of data in bytes
+ * @algo:	Hash algorithm name (e.g. "sha256")
+ * @value:	Digest
+ * @value_len:	Size of the digest in bytes
+ */
+void fit_hash_cache_add(const void *data, ulong size, const char *algo,
+			const uint8_t *value, int value_len);
+
+/**
+ * fit_hash_cache_get_stats() - Get statistics about the cache
+ *
+ * @stats:	Returns the statistics since fit_hash_cache_start()
+ */
+void fit_hash_cache_get_stats(struct fit_hash_cache_stats *stats);
+#else
+static inline void fit_hash_cache_start(void) {}
+static inline void fit_hash_cache_stop(void) {}
+
+static inline int fit_hash_cache_lookup(const void *data, ulong size,
+					const char *algo, uint8_t *value,
+					int *value_len)
+{
+	return -1;
+}
+
+static inline void fit_hash_cache_add(const void *data, ulong size,
+				      const char *algo, const uint8_t *value,
+				      int value_len)
+{
+}
+
+static inline void fit_hash_cache_get_stats(struct fit_hash_cache_stats *stats)
+{
+	stats->hits = 0;
+	stats->misses = 0;
+	stats->bytes = 0;
+}
+#endif
+
 #if IMAGE_ENABLE_FIT
 /* cmdline argument format parsing */
 int fit_parse_conf(const char *spec, ulong addr_curr,
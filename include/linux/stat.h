@@ -68,7 +68,8 @@ struct stat {
 #endif	/* __PPC__ */
 
 #if defined (__ARM__) || defined (__I386__) || defined (__M68K__) || defined (__bfin__) ||\
-	defined (__microblaze__) || defined (__nios2__)
+	defined (__microblaze__) || defined (__nios2__) ||\
+	defined(CONFIG_SANDBOX)
 
 struct stat {
 	unsigned short st_dev;
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __MEMTEST_H
+#define __MEMTEST_H
+
+/* Maximum number of errors printed by a test run */
+#define MEMTEST_MAX_REPORT	10
+
+/**
+ * struct memtest_result - Result of a memory test
+ *
+ * @errors:	Number of words which read back incorrectly
+ * @first_fail:	Address of the first word which read back incorrectly
+ * @fail_bits:	Bit map of the data bits which were seen to fail
+ * @bytes:	Number of bytes written and read back by the test
+ */
+struct memtest_result {
+	ulong errors;
+	ulong first_fail;
+	u64 fail_bits;
+	u64 bytes;
+};
+
+/**
+ * memtest_run() - Run all memory test patterns over an area of memory
+ *
+ * This runs walking-bit, own-address and moving-inversions patterns over the
+ * area using 64-bit accesses. The area is processed in chunks; the cache is
+ * flushed after each chunk is written so that data is read back from memory,
+ * not from the cache. The first MEMTEST_MAX_REPORT errors are printed.
+ * The worker pool is started if available and used for passes which do
+ * not need to visit the memory in order.
+ *
+ * @start:	Start address of area (must be 8-byte aligned)
+ * @size:	Size of area in bytes (must be a multiple of 8)
+ * @res:	Updated with the results; the caller should zero it first
+ * @return 0 if the test ran to the end (see @res for errors), -EINTR if it
+ * was interrupted by Ctrl-C, -EINVAL if the area is not aligned, -ENOMEM
+ * if out of memory
+ */
+int memtest_run(ulong start, ulong size, struct memtest_result *res);
+
+/**
+ * memtest_fill() - Fill an area of memory with a 64-bit pattern
+ *
+ * @start:	Start address of area (must be 8-byte aligned)
+ * @size:	Size of area in bytes (must be a multiple of 8)
+ * @pattern:	Value to write to each word
+ */
+void memtest_fill(ulong start, ulong size, u64 pattern);
+
+/**
+ * memtest_check() - Check that an area of memory holds a 64-bit pattern
+ *
+ * Errors are recorded in @res and the first MEMTEST_MAX_REPORT are printed.
+ *
+ * @start:	Start address of area (must be 8-byte aligned)
+ * @size:	Size of area in bytes (must be a multiple of 8)
+ * @pattern:	Value expected in each word
+ * @res:	Updated with the results
+ * @return 0 if the check completed, -EINTR if interrupted by Ctrl-C
+ */
+int memtest_check(ulong start, ulong size, u64 pattern,
+		  struct memtest_result *res);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Building a live device tree from a flat one
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __OF_LIVE_H
+#define __OF_LIVE_H
+
+struct device_node;
+
+/**
+ * of_live_build() - Build a live tree from a flat tree
+ *
+ * The nodes and properties are placed in a single allocation, which can be
+ * released with free(*rootp). Names and values are not copied: they point
+ * into @blob, which must not move or change while the live tree is in use.
+ *
+ * @blob:	Flat device tree to read
+ * @rootp:	Returns the root node of the new tree
+ * @return 0 if OK, -EINVAL if the flat tree is invalid, -ENOMEM if there is
+ * not enough memory
+ */
+int of_live_build(const void *blob, struct device_node **rootp);
+
+#endif
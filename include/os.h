@@ -321,4 +321,49 @@ int os_spl_to_uboot(const char *fname);
  */
 void os_localtime(struct rtc_time *rt);
 
+/**
+ * os_context_create() - Create a context for a cooperative thread
+ *
+ * @entry:	Function to run on the new stack, or NULL to create a context
+ *		which can only be used to save the current one
+ * @stack:	Stack to use
+ * @size:	Size of @stack in bytes
+ * @return context, or NULL if out of memory
+ */
+void *os_context_create(void (*entry)(void), void *stack, size_t size);
+
+/**
+ * os_context_switch() - Save the current context and switch to another
+ *
+ * @from:	Context to save into
+ * @to:		Context to switch to
+ */
+void os_context_switch(void *from, void *to);
+
+/**
+ * os_context_free() - Free a context created by os_context_create()
+ *
+ * @ctx:	Context to free
+ */
+void os_context_free(void *ctx);
+
+/**
+ * os_thread_create() - Create a host thread which runs alongside U-Boot
+ *
+ * The thread runs at the same time as the caller, so must not use anything
+ * which is not safe for that, such as the console or malloc().
+ *
+ * @entry:	Function to run in the thread
+ * @arg:	Argument to pass to @entry
+ * @return thread, or NULL if it could not be created
+ */
+void *os_thread_create(void (*entry)(int arg), int arg);
+
+/**
+ * os_thread_join() - Wait for a thread to finish, then free it
+ *
+ * @thread:	Thread returned by os_thread_create()
+ */
+void os_thread_join(void *thread);
+
 #endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SquashFS 4.0 on-disk format and read-only filesystem support
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __SQUASHFS_H
+#define __SQUASHFS_H
+
+#include <part.h>
+
+#define SQFS_MAGIC		0x73717368	/* "hsqs" */
+#define SQFS_MAJOR		4
+
+/* Metadata blocks hold this much once uncompressed, after a 16-bit size */
+#define SQFS_METADATA_SIZE	8192
+#define SQFS_METADATA_UNCOMPRESSED	(1 << 15)
+
+/* Data block sizes in block lists and fragment entries */
+#define SQFS_BLOCK_UNCOMPRESSED	(1 << 24)
+
+#define SQFS_MIN_BLOCK_LOG	12
+#define SQFS_MAX_BLOCK_LOG	20
+
+#define SQFS_INVALID_FRAG	0xffffffff
+
+/* Compression used for all blocks of a filesystem */
+enum {
+	SQFS_COMP_GZIP		= 1,
+	SQFS_COMP_LZMA,
+	SQFS_COMP_LZO,
+	SQFS_COMP_XZ,
+	SQFS_COMP_LZ4,
+	SQFS_COMP_ZSTD,
+};
+
+/* Inode types; directory entries use the basic ones */
+enum {
+	SQFS_DIR_TYPE		= 1,
+	SQFS_REG_TYPE,
+	SQFS_SYMLINK_TYPE,
+	SQFS_BLKDEV_TYPE,
+	SQFS_CHRDEV_TYPE,
+	SQFS_FIFO_TYPE,
+	SQFS_SOCKET_TYPE,
+	SQFS_LDIR_TYPE,
+	SQFS_LREG_TYPE,
+	SQFS_LSYMLINK_TYPE,
+	SQFS_LBLKDEV_TYPE,
+	SQFS_LCHRDEV_TYPE,
+	SQFS_LFIFO_TYPE,
+	SQFS_LSOCKET_TYPE,
+};
+
+/*
+ * Tables are found through the superblock. Inodes and directories are
+ * referred to by the offset of their metadata block from the start of the
+ * table, shifted left by 16, plus their offset in the uncompressed block.
+ */
+struct sqfs_super_block {
+	__le32 s_magic;
+	__le32 inodes;
+	__le32 mkfs_time;
+	__le32 block_size;
+	__le32 fragments;
+	__le16 compression;
+	__le16 block_log;
+	__le16 flags;
+	__le16 no_ids;
+	__le16 s_major;
+	__le16 s_minor;
+	__le64 root_inode;
+	__le64 bytes_used;
+	__le64 id_table_start;
+	__le64 xattr_id_table_start;
+	__le64 inode_table_start;
+	__le64 directory_table_start;
+	__le64 fragment_table_start;
+	__le64 lookup_table_start;
+} __packed;
+
+struct sqfs_base_inode {
+	__le16 inode_type;
+	__le16 mode;
+	__le16 uid;
+	__le16 guid;
+	__le32 mtime;
+	__le32 inode_number;
+} __packed;
+
+struct sqfs_dir_inode {
+	struct sqfs_base_inode base;
+	__le32 start_block;
+	__le32 nlink;
+	__le16 file_size;
+	__le16 offset;
+	__le32 parent_inode;
+} __packed;
+
+/* Followed by i_count directory index entries, which are not used */
+struct sqfs_ldir_inode {
+	struct sqfs_base_inode base;
+	__le32 nlink;
+	__le32 file_size;
+	__le32 start_block;
+	__le32 parent_inode;
+	__le16 i_count;
+	__le16 offset;
+	__le32 xattr;
+} __packed;
+
+/* Followed by the size of each data block, as __le32 */
+struct sqfs_reg_inode {
+	struct sqfs_base_inode base;
+	__le32 start_block;
+	__le32 fragment;
+	__le32 offset;
+	__le32 file_size;
+} __packed;
+
+struct sqfs_lreg_inode {
+	struct sqfs_base_inode base;
+	__le64 start_block;
+	__le64 file_size;
+	__le64 sparse;
+	__le32 nlink;
+	__le32 fragment;
+	__le32 offset;
+	__le32 xattr;
+} __packed;
+
+/* Followed by the target, which is not terminated */
+struct sqfs_symlink_inode {
+	struct sqfs_base_inode base;
+	__le32 nlink;
+	__le32 symlink_size;
+} __packed;
+
+/* Followed by count + 1 entries whose inodes are in the same block */
+struct sqfs_dir_header {
+	__le32 count;
+	__le32 start_block;
+	__le32 inode_number;
+} __packed;
+
+/* Followed by the name, size + 1 bytes which are not terminated */
+struct sqfs_dir_entry {
+	__le16 offset;
+	__le16 inode_number;
+	__le16 type;
+	__le16 size;
+} __packed;
+
+struct sqfs_fragment_entry {
+	__le64 start_block;
+	__le32 size;
+	__le32 unused;
+} __packed;
+
+#define SQFS_FRAGMENTS_PER_BLOCK	\
+	(SQFS_METADATA_SIZE / sizeof(struct sqfs_fragment_entry))
+
+int sqfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition);
+int sqfs_ls(const char *dirname);
+int sqfs_exists(const char *filename);
+int sqfs_size(const char *filename, loff_t *size);
+int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread);
+void sqfs_close(void);
+
+#endif /* __SQUASHFS_H */
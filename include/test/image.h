@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TEST_IMAGE_H__
+#define __TEST_IMAGE_H__
+
+#include <test/test.h>
+
+/* Declare a new image test */
+#define IMAGE_TEST(_name, _flags)	UNIT_TEST(_name, _flags, image_test)
+
+#endif /* __TEST_IMAGE_H__ */
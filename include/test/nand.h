@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TEST_NAND_H__
+#define __TEST_NAND_H__
+
+#include <test/test.h>
+
+/* Declare a new NAND test */
+#define NAND_TEST(_name, _flags)	UNIT_TEST(_name, _flags, nand_test)
+
+#endif /* __TEST_NAND_H__ */
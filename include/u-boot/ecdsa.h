@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _ECDSA_H
+#define _ECDSA_H
+
+#include <errno.h>
+#include <image.h>
+
+/* Sizes for the NIST P-256 (prime256v1) curve */
+#define ECDSA_P256_BYTES	(256 / 8)
+#define ECDSA_P256_SIG_BYTES	(ECDSA_P256_BYTES * 2)
+
+struct image_sign_info;
+
+/*
+ * ECDSA signing is always available in the host tools. On the device it
+ * must be enabled with CONFIG_ECDSA.
+ */
+#ifdef USE_HOSTCC
+# define IMAGE_ENABLE_ECDSA	IMAGE_ENABLE_VERIFY
+#elif CONFIG_IS_ENABLED(ECDSA)
+# define IMAGE_ENABLE_ECDSA	IMAGE_ENABLE_VERIFY
+#else
+# define IMAGE_ENABLE_ECDSA	0
+#endif
+
+#if IMAGE_ENABLE_SIGN
+/**
+ * ecdsa_sign() - calculate and return signature for given input data
+ *
+ * @info:	Specifies key and FIT information
+ * @region:	List of regions to sign
+ * @region_count: Number of regions
+ * @sigp:	Set to an allocated buffer holding the signature
+ * @sig_len:	Set to length of the calculated signature
+ *
+ * The signature is the concatenation of the big-endian r and s values. The
+ * caller should free *sigp.
+ *
+ * @return: 0, on success, -ve on error
+ */
+int ecdsa_sign(struct image_sign_info *info,
+	       const struct image_region region[],
+	       int region_count, uint8_t **sigp, uint *sig_len);
+
+/**
+ * ecdsa_add_verify_data() - Add verification information to FDT
+ *
+ * Add the public key (curve name and x/y coordinates of the public point)
+ * to the FDT node, suitable for verification at run-time.
+ *
+ * @info:	Specifies key and FIT information
+ * @keydest:	Destination FDT blob for public key data
+ * @return: 0, on success, -ENOSPC if the keydest FDT blob ran out of space,
+ *	other -ve value on error
+ */
+int ecdsa_add_verify_data(struct image_sign_info *info, void *keydest);
+#else
+static inline int ecdsa_sign(struct image_sign_info *info,
+		const struct image_region region[], int region_count,
+		uint8_t **sigp, uint *sig_len)
+{
+	return -ENXIO;
+}
+
+static inline int ecdsa_add_verify_data(struct image_sign_info *info,
+					void *keydest)
+{
+	return -ENXIO;
+}
+#endif
+
+#if IMAGE_ENABLE_ECDSA
+/**
+ * ecdsa_verify() - Verify a signature against some data
+ *
+ * @info:	Specifies key and FIT information
+ * @region:	List of regions covered by the signature
+ * @region_count: Number of regions
+ * @sig:	Signature (r followed by s, each big-endian)
+ * @sig_len:	Number of bytes in signature
+ * @return 0 if verified, -ve on error
+ */
+int ecdsa_verify(struct image_sign_info *info,
+		 const struct image_region region[], int region_count,
+		 uint8_t *sig, uint sig_len);
+#else
+static inline int ecdsa_verify(struct image_sign_info *info,
+		const struct image_region region[], int region_count,
+		uint8_t *sig, uint sig_len)
+{
+	return -ENXIO;
+}
+#endif
+
+/**
+ * ecdsa_p256_verify_hash() - Verify a P-256 signature over a hash
+ *
+ * @pub_x:	X coordinate of the public key (32 bytes, big-endian)
+ * @pub_y:	Y coordinate of the public key (32 bytes, big-endian)
+ * @hash:	Message hash; only the leftmost 256 bits are used
+ * @hash_len:	Length of hash in bytes
+ * @sig:	Signature (r followed by s, each 32 bytes big-endian)
+ * @return 0 if verified, -EINVAL if the key or signature is malformed,
+ * -EACCES if the signature does not match
+ */
+int ecdsa_p256_verify_hash(const uint8_t *pub_x, const uint8_t *pub_y,
+			   const uint8_t *hash, int hash_len,
+			   const uint8_t *sig);
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _HASH_ENGINE_H
+#define _HASH_ENGINE_H
+
+struct udevice;
+
+/**
+ * struct hash_ops - Driver model operations for a hash (digest) engine
+ *
+ * A hash engine computes message digests for one or more of the algorithms
+ * listed in common/hash.c. Algorithms are identified by their lower-case
+ * name, e.g. "sha256". Each hash in progress is tracked by a context which
+ * the driver allocates in init() and frees in finish().
+ */
+struct hash_ops {
+	/**
+	 * supports() - Check whether this engine implements an algorithm
+	 *
+	 * @dev:	Hash engine device
+	 * @algo_name:	Algorithm name (lower case)
+	 * @return 0 if supported, -EPROTONOSUPPORT if not
+	 */
+	int (*supports)(struct udevice *dev, const char *algo_name);
+
+	/**
+	 * init() - Start a new hash
+	 *
+	 * @dev:	Hash engine device
+	 * @algo_name:	Algorithm name (lower case)
+	 * @ctxp:	Returns a pointer to the new context
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*init)(struct udevice *dev, const char *algo_name, void **ctxp);
+
+	/**
+	 * update() - Add data to a hash, waiting for completion
+	 *
+	 * @dev:	Hash engine device
+	 * @ctx:	Context returned by init()
+	 * @buf:	Data to add
+	 * @size:	Size of data in bytes
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*update)(struct udevice *dev, void *ctx, const void *buf,
+		      unsigned int size);
+
+	/**
+	 * update_async() - Add data to a hash without waiting (optional)
+	 *
+	 * The engine may still be reading @buf when this returns, so the
+	 * caller must not change it until wait() returns 0. Only one
+	 * asynchronous update may be outstanding per context.
+	 *
+	 * @dev:	Hash engine device
+	 * @ctx:	Context returned by init()
+	 * @buf:	Data to add
+	 * @size:	Size of data in bytes
+	 * @return 0 if OK, -EBUSY if an update is already outstanding, other
+	 * -ve value on error
+	 */
+	int (*update_async)(struct udevice *dev, void *ctx, const void *buf,
+			    unsigned int size);
+
+	/**
+	 * wait() - Wait for an asynchronous update to complete (optional)
+	 *
+	 * @dev:	Hash engine device
+	 * @ctx:	Context returned by init()
+	 * @timeout_ms:	Maximum time to wait, 0 to just poll
+	 * @return 0 if no update is outstanding, -EBUSY if the update is still
+	 * running after @timeout_ms, other -ve value on error
+	 */
+	int (*wait)(struct udevice *dev, void *ctx, ulong timeout_ms);
+
+	/**
+	 * finish() - Finish a hash and write out the digest
+	 *
+	 * The context is freed by this function, even on error.
+	 *
+	 * @dev:	Hash engine device
+	 * @ctx:	Context returned by init()
+	 * @dest_buf:	Place to put the digest
+	 * @size:	Size of @dest_buf in bytes
+	 * @return 0 if OK, -ENOSPC if @dest_buf is too small, other -ve value
+	 * on error
+	 */
+	int (*finish)(struct udevice *dev, void *ctx, void *dest_buf,
+		      int size);
+};
+
+#define hash_get_ops(dev)	((struct hash_ops *)(dev)->driver->ops)
+
+/**
+ * hash_engine_get() - Select the hash engine to use for an algorithm
+ *
+ * If the 'hash_engine' environment variable is set, it names the device to
+ * use. The special value 'none' disables the uclass so that callers fall
+ * back to the built-in implementations in common/hash.c. Otherwise the first
+ * engine which supports @algo_name is used.
+ *
+ * @algo_name:	Algorithm name (lower case)
+ * @devp:	Returns the selected device
+ * @return 0 if OK, -ENODEV if no engine supports the algorithm
+ */
+int hash_engine_get(const char *algo_name, struct udevice **devp);
+
+/**
+ * hash_engine_supports() - Check whether an engine implements an algorithm
+ *
+ * @dev:	Hash engine device
+ * @algo_name:	Algorithm name (lower case)
+ * @return 0 if supported, -EPROTONOSUPPORT if not
+ */
+int hash_engine_supports(struct udevice *dev, const char *algo_name);
+
+/* See struct hash_ops for a description of these functions */
+int hash_engine_init(struct udevice *dev, const char *algo_name, void **ctxp);
+int hash_engine_update(struct udevice *dev, void *ctx, const void *buf,
+		       unsigned int size);
+int hash_engine_finish(struct udevice *dev, void *ctx, void *dest_buf,
+		       int size);
+
+/**
+ * hash_engine_update_async() - Start adding data to a hash
+ *
+ * Engines which do not support asynchronous operation process the data
+ * before returning, so callers can use this unconditionally.
+ *
+ * @dev:	Hash engine device
+ * @ctx:	Context returned by hash_engine_init()
+ * @buf:	Data to add, which must remain valid until hash_engine_wait()
+ *		returns 0
+ * @size:	Size of data in bytes
+ * @return 0 if OK, -ve on error
+ */
+int hash_engine_update_async(struct udevice *dev, void *ctx, const void *buf,
+			     unsigned int size);
+
+/**
+ * hash_engine_wait() - Wait for an asynchronous update to complete
+ *
+ * @dev:	Hash engine device
+ * @ctx:	Context returned by hash_engine_init()
+ * @timeout_ms:	Maximum time to wait, 0 to just poll
+ * @return 0 if no update is outstanding, -EBUSY if still running
+ */
+int hash_engine_wait(struct udevice *dev, void *ctx, ulong timeout_ms);
+
+/**
+ * hash_engine_digest() - Hash a complete buffer using an engine
+ *
+ * The data is passed to the engine in @chunk_size pieces so that the
+ * watchdog can be serviced in between.
+ *
+ * @dev:	Hash engine device
+ * @algo_name:	Algorithm name (lower case)
+ * @buf:	Data to hash
+ * @len:	Length of data in bytes
+ * @output:	Place to put the digest
+ * @size:	Size of @output in bytes
+ * @chunk_size:	Number of bytes to hash between watchdog resets
+ * @return 0 if OK, -ve on error
+ */
+int hash_engine_digest(struct udevice *dev, const char *algo_name,
+		       const void *buf, unsigned int len, void *output,
+		       int size, unsigned int chunk_size);
+
+#endif
@@ -13,6 +13,7 @@
 #include <u-boot/sha256.h>
 
 extern const uint8_t padding_sha256_rsa4096[];
+extern const uint8_t padding_sha256_rsa3072[];
 extern const uint8_t padding_sha256_rsa2048[];
 extern const uint8_t padding_sha1_rsa2048[];
 
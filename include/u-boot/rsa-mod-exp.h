@@ -25,8 +25,22 @@ struct key_prop {
 	uint32_t n0inv;		/* -1 / modulus[0] mod 2^32 */
 	int num_bits;		/* Key length in bits */
 	uint32_t exp_len;	/* Exponent length in number of uint8_t */
+	const void *decoded;	/* Key from rsa_key_decode(), or NULL */
 };
 
+/**
+ * rsa_key_decode() - Convert a key ready for rsa_mod_exp_sw()
+ *
+ * rsa_mod_exp_sw() converts the modulus and R^2 to little-endian words on
+ * each call. This does it once, so that a key used for several signatures
+ * can be stored in prop->decoded. The result must be freed with free().
+ *
+ * @prop:	Key to convert
+ * @decodedp:	Returns the converted key
+ * @return 0 if OK, -ENOMEM if out of memory, other -ve on invalid key
+ */
+int rsa_key_decode(const struct key_prop *prop, void **decodedp);
+
 /**
  * rsa_mod_exp_sw() - Perform RSA Modular Exponentiation in sw
  *
@@ -108,6 +108,7 @@ static inline int rsa_verify(struct image_sign_info *info,
 #endif
 
 #define RSA2048_BYTES	(2048 / 8)
+#define RSA3072_BYTES	(3072 / 8)
 #define RSA4096_BYTES	(4096 / 8)
 
 /* This is the minimum/maximum key size we support, in bits */
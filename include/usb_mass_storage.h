@@ -15,6 +15,23 @@
 /* Wait at maximum 60 seconds for cable connection */
 #define UMS_CABLE_READY_TIMEOUT	60
 
+/**
+ * struct ums_stats - I/O statistics for a UMS device
+ *
+ * @read_bytes:		Bytes read by the host
+ * @ra_bytes:		Bytes of @read_bytes from the read-ahead buffer
+ * @write_bytes:	Bytes written by the host
+ * @dev_reads:		Number of calls to read_sector()
+ * @dev_writes:		Number of calls to write_sector()
+ */
+struct ums_stats {
+	u64 read_bytes;
+	u64 ra_bytes;
+	u64 write_bytes;
+	unsigned int dev_reads;
+	unsigned int dev_writes;
+};
+
 struct ums {
 	int (*read_sector)(struct ums *ums_dev,
 			   ulong start, lbaint_t blkcnt, void *buf);
@@ -24,6 +41,7 @@ struct ums {
 	unsigned int num_sectors;
 	const char *name;
 	struct blk_desc block_dev;
+	struct ums_stats stats;
 };
 
 int fsg_init(struct ums *ums_devs, int count);
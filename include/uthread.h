@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __UTHREAD_H
+#define __UTHREAD_H
+
+struct uthread;
+
+/**
+ * uthread_fn - Function run by a thread
+ *
+ * @arg:	Argument passed to uthread_create()
+ * @return 0 if OK, -ve on error
+ */
+typedef int (*uthread_fn)(void *arg);
+
+#ifdef CONFIG_UTHREAD
+/**
+ * uthread_create() - Create a thread
+ *
+ * The thread does not start running until uthread_join_all() is called.
+ * Threads run in turn on the boot CPU, each until it calls
+ * uthread_schedule() (which udelay() does) or returns.
+ *
+ * @fn:		Function to run
+ * @arg:	Argument to pass to @fn
+ * @name:	Name of thread, for debugging
+ * @return 0 if OK, -ENOMEM if out of memory, -EPERM if called from a thread
+ */
+int uthread_create(uthread_fn fn, void *arg, const char *name);
+
+/**
+ * uthread_join_all() - Run all threads until they have finished
+ *
+ * Console output from threads is held back where needed, so that it
+ * appears in the order in which the threads were created.
+ *
+ * @return 0 if all threads returned 0, otherwise the first error returned,
+ * in order of creation
+ */
+int uthread_join_all(void);
+
+/**
+ * uthread_step() - Let each thread run until it next gives way
+ *
+ * This allows the main thread to keep doing its own work while threads make
+ * progress in the background, calling this from time to time. Use
+ * uthread_join_all() to wait for the threads and collect their errors.
+ *
+ * @return true if any threads have not yet been cleaned up, false if there
+ * are none or if called from a thread
+ */
+bool uthread_step(void);
+
+/**
+ * uthread_schedule() - Let other threads run
+ *
+ * This does nothing if not called from a thread.
+ */
+void uthread_schedule(void);
+
+/**
+ * uthread_self() - Get the current thread
+ *
+ * @return current thread, or NULL if not called from a thread
+ */
+struct uthread *uthread_self(void);
+
+/**
+ * uthread_udelay() - Delay, letting other threads run in the meantime
+ *
+ * This is used by udelay() when called from a thread.
+ *
+ * @usec:	Number of microseconds to wait
+ */
+void uthread_udelay(unsigned long usec);
+
+/**
+ * uthread_hold_output() - Hold back console output if needed
+ *
+ * Output from a thread is held back while any thread created before it is
+ * still running, then printed when that thread finishes.
+ *
+ * @s:		Output to hold
+ * @len:	Number of bytes in @s
+ * @return true if the output was held, false if it should be printed now
+ */
+bool uthread_hold_output(const char *s, int len);
+
+/* Provided by the architecture */
+
+/**
+ * arch_uthread_create() - Create a context for a thread
+ *
+ * @entry:	Function to run on the new stack, or NULL to create a context
+ *		which can only be used to save the current one
+ * @stack:	Stack to use
+ * @size:	Size of @stack in bytes
+ * @return context, or NULL if out of memory
+ */
+void *arch_uthread_create(void (*entry)(void), void *stack, size_t size);
+
+/**
+ * arch_uthread_switch() - Save the current context and switch to another
+ *
+ * @from:	Context to save into
+ * @to:		Context to switch to
+ */
+void arch_uthread_switch(void *from, void *to);
+
+/**
+ * arch_uthread_free() - Free a context
+ *
+ * @ctx:	Context to free, which must not be the current one
+ */
+void arch_uthread_free(void *ctx);
+#else
+static inline bool uthread_step(void)
+{
+	return false;
+}
+
+static inline struct uthread *uthread_self(void)
+{
+	return NULL;
+}
+
+static inline void uthread_schedule(void)
+{
+}
+
+static inline bool uthread_hold_output(const char *s, int len)
+{
+	return false;
+}
+#endif
+
+#endif
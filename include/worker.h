@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __WORKER_H
+#define __WORKER_H
+
+/**
+ * worker_fn - Function which does one part of a job
+ *
+ * This may run on any CPU, at the same time as other parts of the job, so
+ * it must only touch memory belonging to its own part. It must not use the
+ * console, malloc(), drivers or anything else which keeps global state.
+ *
+ * @arg:	Argument passed to worker_run()
+ * @part:	Part to do, from 0 to one less than the number of parts
+ */
+typedef void (*worker_fn)(void *arg, int part);
+
+#ifdef CONFIG_WORKER
+/**
+ * worker_start() - Start the secondary CPUs, if not already running
+ *
+ * This is called by worker_run() when needed, so need not be called
+ * directly.
+ *
+ * @return number of CPUs which run jobs, including the boot CPU
+ */
+int worker_start(void);
+
+/**
+ * worker_stop() - Return the secondary CPUs to their original state
+ *
+ * This must be called before booting an OS, so that it finds the secondary
+ * CPUs where it expects them to be. Jobs run on the boot CPU alone until
+ * worker_start() is next called.
+ */
+void worker_stop(void);
+
+/**
+ * worker_count() - Get the number of CPUs which run jobs
+ *
+ * @return number of CPUs, including the boot CPU, or 1 if the secondary
+ * CPUs are not running
+ */
+int worker_count(void);
+
+/**
+ * worker_run() - Run a job on all CPUs and wait for it to finish
+ *
+ * The parts are spread across the boot CPU and the secondary CPUs. If
+ * called from within a job, the parts all run on the calling CPU.
+ *
+ * @fn:		Function to run for each part
+ * @arg:	Argument to pass to @fn
+ * @count:	Number of parts
+ */
+void worker_run(worker_fn fn, void *arg, int count);
+
+/**
+ * worker_memcpy() - Copy memory, using all CPUs if worthwhile
+ *
+ * @dest:	Destination, which must not overlap @src
+ * @src:	Source
+ * @len:	Number of bytes to copy
+ */
+void worker_memcpy(void *dest, const void *src, size_t len);
+
+/**
+ * worker_memset() - Fill memory, using all CPUs if worthwhile
+ *
+ * @s:		Memory to fill
+ * @c:		Value to fill with
+ * @len:	Number of bytes to fill
+ */
+void worker_memset(void *s, int c, size_t len);
+
+/**
+ * worker_main() - Run jobs on a secondary CPU until worker_stop() is called
+ *
+ * This is called by the architecture on each secondary CPU which it starts.
+ *
+ * @cpu:	CPU number, from 1 to the number of secondary CPUs
+ */
+void worker_main(int cpu);
+
+/* Provided by the architecture */
+
+/**
+ * arch_worker_start() - Start secondary CPUs
+ *
+ * Each CPU must call worker_main() with its CPU number, with the same view
+ * of memory as the boot CPU.
+ *
+ * @max:	Maximum number of secondary CPUs to start
+ * @return number of secondary CPUs started, or -ve on error
+ */
+int arch_worker_start(int max);
+
+/**
+ * arch_worker_stop() - Wait for secondary CPUs to go back to where they were
+ *
+ * This is called once worker_main() has been told to return on each CPU.
+ */
+void arch_worker_stop(void);
+
+/**
+ * arch_worker_wait() - Wait a short while for another CPU to signal
+ *
+ * This may return early, or without any signal having been sent.
+ */
+void arch_worker_wait(void);
+
+/**
+ * arch_worker_kick() - Signal to other CPUs waiting in arch_worker_wait()
+ */
+void arch_worker_kick(void);
+#else
+static inline int worker_start(void)
+{
+	return 1;
+}
+
+static inline void worker_stop(void)
+{
+}
+
+static inline int worker_count(void)
+{
+	return 1;
+}
+
+static inline void worker_run(worker_fn fn, void *arg, int count)
+{
+	int part;
+
+	for (part = 0; part < count; part++)
+		fn(arg, part);
+}
+
+static inline void worker_memcpy(void *dest, const void *src, size_t len)
+{
+	memcpy(dest, src, len);
+}
+
+static inline void worker_memset(void *s, int c, size_t len)
+{
+	memset(s, c, len);
+}
+#endif
+
+#endif
@@ -35,7 +35,8 @@
  * remainder lookup tables.
  *
  * The final stage of decoding involves the following internal steps:
- * a. Syndrome computation
+ * a. Syndrome computation, processing 32 ecc bits at a time using lookup
+ *    tables; decoding stops here if all syndromes are zero (no errors)
  * b. Error locator polynomial computation using Berlekamp-Massey algorithm
  * c. Error locator root finding (by far the most expensive step)
  *
@@ -317,6 +318,40 @@ static inline int a_ilog(struct bch_control *bch, unsigned int x)
 	return mod_s(bch, GF_N(bch)-bch->a_log_tab[x]);
 }
 
+/*
+ * compute odd syndromes v(a^j) for j=1,3,..,2t-1 using the syndrome tables,
+ * one ecc word at a time (Horner's rule with a step of a^(32j))
+ */
+static void compute_syndromes_tab(struct bch_control *bch, const uint32_t *ecc,
+				  unsigned int *syn)
+{
+	const unsigned int n = GF_N(bch);
+	const unsigned int words = DIV_ROUND_UP(bch->ecc_bits, 32);
+	const unsigned int pad = 32*words-bch->ecc_bits;
+	const uint16_t *tab;
+	unsigned int i, j, v, step;
+	uint32_t poly;
+
+	for (j = 0; j < GF_T(bch); j++) {
+		tab = bch->syn_tab+j*4*256;
+		step = modulo(bch, 32*(2*j+1));
+		for (i = 0, v = 0; i < words; i++) {
+			poly = ecc[i];
+			if (v)
+				v = bch->a_pow_tab[mod_s(bch, a_log(bch, v)+
+							 step)];
+			v ^= tab[poly & 0xff]^tab[256+((poly >> 8) & 0xff)]^
+				tab[512+((poly >> 16) & 0xff)]^
+				tab[768+(poly >> 24)];
+		}
+		/* last word is left-aligned: divide by a^(pad*j) */
+		if (v && pad)
+			v = bch->a_pow_tab[mod_s(bch, a_log(bch, v)+n-
+						 modulo(bch, pad*(2*j+1)))];
+		syn[2*j] = v;
+	}
+}
+
 /*
  * compute 2t syndromes of ecc polynomial, i.e. ecc(a^j) for j=1..2t
  */
@@ -337,17 +372,21 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 	memset(syn, 0, 2*t*sizeof(*syn));
 
 	/* compute v(a^j) for j=1 .. 2t-1 */
-	do {
-		poly = *ecc++;
-		s -= 32;
-		while (poly) {
-			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
-
-			poly ^= (1 << i);
-		}
-	} while (s > 0);
+	if (bch->syn_tab) {
+		compute_syndromes_tab(bch, ecc, syn);
+	} else {
+		do {
+			poly = *ecc++;
+			s -= 32;
+			while (poly) {
+				i = deg(poly);
+				for (j = 0; j < 2*t; j += 2)
+					syn[j] ^= a_pow(bch, (j+1)*(i+s));
+
+				poly ^= (1 << i);
+			}
+		} while (s > 0);
+	}
 
 	/* v(a^(2j)) = v(a^j)^2 */
 	for (j = 0; j < t; j++)
@@ -1009,6 +1048,12 @@ int decode_bch(struct bch_control *bch, const uint8_t *data, unsigned int len,
 		syn = bch->syn;
 	}
 
+	/* all syndromes are zero in the usual case of an error-free read */
+	for (i = 0, sum = 0; i < 2*GF_T(bch); i++)
+		sum |= syn[i];
+	if (!sum)
+		return 0;
+
 	err = compute_error_locator_polynomial(bch, syn);
 	if (err > 0) {
 		nroots = find_poly_roots(bch, 1, bch->elp, errloc);
@@ -1133,6 +1178,27 @@ static int build_deg2_base(struct bch_control *bch)
 	return remaining ? -1 : 0;
 }
 
+/*
+ * compute syndrome lookup tables: for each odd syndrome a^(2j+1) and each
+ * byte b of a 32-bit ecc word, the value at a^(2j+1) of the 8 ecc polynomial
+ * terms held in b
+ */
+static void build_syn_tables(struct bch_control *bch)
+{
+	unsigned int i, j, b;
+	uint16_t *tab;
+
+	for (j = 0; j < GF_T(bch); j++) {
+		for (i = 0; i < 4; i++) {
+			tab = bch->syn_tab+(4*j+i)*256;
+			tab[0] = 0;
+			for (b = 1; b < 256; b++)
+				tab[b] = tab[b & (b-1)]^
+					a_pow(bch, (2*j+1)*(8*i+ffs(b)-1));
+		}
+	}
+}
+
 static void *bch_alloc(size_t size, int *err)
 {
 	void *ptr;
@@ -1313,6 +1379,14 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	if (err)
 		goto fail;
 
+	/*
+	 * syndrome tables are optional (2 KiB per correctable bit), fall back
+	 * to bit-serial syndrome computation if they cannot be allocated
+	 */
+	bch->syn_tab = kmalloc(t*4*256*sizeof(*bch->syn_tab), GFP_KERNEL);
+	if (bch->syn_tab)
+		build_syn_tables(bch);
+
 	return bch;
 
 fail:
@@ -1338,6 +1412,7 @@ void free_bch(struct bch_control *bch)
 		kfree(bch->syn);
 		kfree(bch->cache);
 		kfree(bch->elp);
+		kfree(bch->syn_tab);
 
 		for (i = 0; i < ARRAY_SIZE(bch->poly_2t); i++)
 			kfree(bch->poly_2t[i]);
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "mkimage.h"
+#include <stdio.h>
+#include <string.h>
+#include <image.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/pem.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/x509.h>
+#include <u-boot/ecdsa.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+static void ECDSA_SIG_get0(const ECDSA_SIG *sig, const BIGNUM **pr,
+			   const BIGNUM **ps)
+{
+	*pr = sig->r;
+	*ps = sig->s;
+}
+#endif
+
+static int ecdsa_err(const char *msg)
+{
+	unsigned long sslErr = ERR_get_error();
+
+	fprintf(stderr, "%s", msg);
+	fprintf(stderr, ": %s\n",
+		ERR_error_string(sslErr, 0));
+
+	return -1;
+}
+
+/* Check that a key uses the only curve we can verify on the device */
+static int ecdsa_check_curve(EC_KEY *ec)
+{
+	const EC_GROUP *group = EC_KEY_get0_group(ec);
+
+	if (!group || EC_GROUP_get_curve_name(group) != NID_X9_62_prime256v1) {
+		fprintf(stderr, "ECDSA key must use the prime256v1 curve\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * ecdsa_get_pub_key() - read a public key from a .crt file
+ *
+ * @keydir:	Directory containing the key
+ * @name	Name of key file (will have a .crt extension)
+ * @ecp		Returns EC_KEY object, or NULL on failure
+ * @return 0 if ok, -ve on error (in which case *ecp will be set to NULL)
+ */
+static int ecdsa_get_pub_key(const char *keydir, const char *name,
+			     EC_KEY **ecp)
+{
+	char path[1024];
+	EVP_PKEY *key;
+	X509 *cert;
+	EC_KEY *ec;
+	FILE *f;
+	int ret;
+
+	*ecp = NULL;
+	snprintf(path, sizeof(path), "%s/%s.crt", keydir, name);
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Couldn't open ECDSA certificate: '%s': %s\n",
+			path, strerror(errno));
+		return -EACCES;
+	}
+
+	cert = NULL;
+	if (!PEM_read_X509(f, &cert, NULL, NULL)) {
+		ecdsa_err("Couldn't read certificate");
+		ret = -EINVAL;
+		goto err_cert;
+	}
+
+	key = X509_get_pubkey(cert);
+	if (!key) {
+		ecdsa_err("Couldn't read public key");
+		ret = -EINVAL;
+		goto err_pubkey;
+	}
+
+	ec = EVP_PKEY_get1_EC_KEY(key);
+	if (!ec) {
+		ecdsa_err("Couldn't convert to an EC key");
+		ret = -EINVAL;
+		goto err_ec;
+	}
+	ret = ecdsa_check_curve(ec);
+	if (ret) {
+		EC_KEY_free(ec);
+		goto err_ec;
+	}
+	fclose(f);
+	EVP_PKEY_free(key);
+	X509_free(cert);
+	*ecp = ec;
+
+	return 0;
+
+err_ec:
+	EVP_PKEY_free(key);
+err_pubkey:
+	X509_free(cert);
+err_cert:
+	fclose(f);
+	return ret;
+}
+
+/**
+ * ecdsa_get_priv_key() - read a private key from a .key file
+ *
+ * @keydir:	Directory containing the key
+ * @name	Name of key file (will have a .key extension)
+ * @ecp		Returns EC_KEY object, or NULL on failure
+ * @return 0 if ok, -ve on error (in which case *ecp will be set to NULL)
+ */
+static int ecdsa_get_priv_key(const char *keydir, const char *name,
+			      EC_KEY **ecp)
+{
+	char path[1024];
+	EC_KEY *ec;
+	FILE *f;
+	int ret;
+
+	*ecp = NULL;
+	snprintf(path, sizeof(path), "%s/%s.key", keydir, name);
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Couldn't open ECDSA private key: '%s': %s\n",
+			path, strerror(errno));
+		return -ENOENT;
+	}
+
+	ec = PEM_read_ECPrivateKey(f, NULL, NULL, path);
+	fclose(f);
+	if (!ec) {
+		ecdsa_err("Failure reading private key");
+		return -EPROTO;
+	}
+	ret = ecdsa_check_curve(ec);
+	if (ret) {
+		EC_KEY_free(ec);
+		return ret;
+	}
+	*ecp = ec;
+
+	return 0;
+}
+
+/* Write a bignum as a fixed-size big-endian number */
+static int ecdsa_bn2bin(const BIGNUM *num, uint8_t *buf, int size)
+{
+	int len = BN_num_bytes(num);
+
+	if (len > size)
+		return -EINVAL;
+	memset(buf, '\0', size - len);
+	BN_bn2bin(num, buf + size - len);
+
+	return 0;
+}
+
+int ecdsa_sign(struct image_sign_info *info,
+	       const struct image_region region[], int region_count,
+	       uint8_t **sigp, uint *sig_len)
+{
+	uint8_t hash[EVP_MAX_MD_SIZE];
+	const BIGNUM *r, *s;
+	unsigned int hash_len;
+	EVP_MD_CTX *context;
+	ECDSA_SIG *ecsig;
+	uint8_t *sig;
+	EC_KEY *ec;
+	int ret, i;
+
+	ret = ecdsa_get_priv_key(info->keydir, info->keyname, &ec);
+	if (ret)
+		return ret;
+
+	context = EVP_MD_CTX_create();
+	if (!context) {
+		ret = ecdsa_err("EVP context creation failed");
+		goto err_ctx;
+	}
+	if (!EVP_DigestInit(context, info->algo->checksum->calculate_sign())) {
+		ret = ecdsa_err("Digest setup failed");
+		goto err_digest;
+	}
+	for (i = 0; i < region_count; i++) {
+		if (!EVP_DigestUpdate(context, region[i].data,
+				      region[i].size)) {
+			ret = ecdsa_err("Hashing data failed");
+			goto err_digest;
+		}
+	}
+	if (!EVP_DigestFinal(context, hash, &hash_len)) {
+		ret = ecdsa_err("Could not obtain hash");
+		goto err_digest;
+	}
+
+	ecsig = ECDSA_do_sign(hash, hash_len, ec);
+	if (!ecsig) {
+		ret = ecdsa_err("Could not obtain signature");
+		goto err_digest;
+	}
+
+	sig = malloc(ECDSA_P256_SIG_BYTES);
+	if (!sig) {
+		fprintf(stderr, "Out of memory for signature (%d bytes)\n",
+			ECDSA_P256_SIG_BYTES);
+		ret = -ENOMEM;
+		goto err_alloc;
+	}
+	ECDSA_SIG_get0(ecsig, &r, &s);
+	ret = ecdsa_bn2bin(r, sig, ECDSA_P256_BYTES);
+	if (!ret)
+		ret = ecdsa_bn2bin(s, sig + ECDSA_P256_BYTES,
+				   ECDSA_P256_BYTES);
+	if (ret) {
+		free(sig);
+		goto err_alloc;
+	}
+
+	*sigp = sig;
+	*sig_len = ECDSA_P256_SIG_BYTES;
+
+err_alloc:
+	ECDSA_SIG_free(ecsig);
+err_digest:
+	EVP_MD_CTX_destroy(context);
+err_ctx:
+	EC_KEY_free(ec);
+
+	return ret;
+}
+
+int ecdsa_add_verify_data(struct image_sign_info *info, void *keydest)
+{
+	uint8_t x_buf[ECDSA_P256_BYTES], y_buf[ECDSA_P256_BYTES];
+	const EC_POINT *point;
+	BIGNUM *x, *y;
+	int parent, node;
+	char name[100];
+	EC_KEY *ec;
+	int ret;
+
+	debug("%s: Getting verification data\n", __func__);
+	ret = ecdsa_get_pub_key(info->keydir, info->keyname, &ec);
+	if (ret)
+		return ret;
+
+	x = BN_new();
+	y = BN_new();
+	point = EC_KEY_get0_public_key(ec);
+	if (!x || !y || !point ||
+	    !EC_POINT_get_affine_coordinates_GFp(EC_KEY_get0_group(ec), point,
+						 x, y, NULL) ||
+	    ecdsa_bn2bin(x, x_buf, sizeof(x_buf)) ||
+	    ecdsa_bn2bin(y, y_buf, sizeof(y_buf))) {
+		ret = ecdsa_err("Couldn't get public key point");
+		goto done;
+	}
+
+	parent = fdt_subnode_offset(keydest, 0, FIT_SIG_NODENAME);
+	if (parent == -FDT_ERR_NOTFOUND) {
+		parent = fdt_add_subnode(keydest, 0, FIT_SIG_NODENAME);
+		if (parent < 0) {
+			ret = parent;
+			if (ret != -FDT_ERR_NOSPACE) {
+				fprintf(stderr, "Couldn't create signature node: %s\n",
+					fdt_strerror(parent));
+			}
+		}
+	}
+	if (ret)
+		goto done;
+
+	/* Either create or overwrite the named key node */
+	snprintf(name, sizeof(name), "key-%s", info->keyname);
+	node = fdt_subnode_offset(keydest, parent, name);
+	if (node == -FDT_ERR_NOTFOUND) {
+		node = fdt_add_subnode(keydest, parent, name);
+		if (node < 0) {
+			ret = node;
+			if (ret != -FDT_ERR_NOSPACE) {
+				fprintf(stderr, "Could not create key subnode: %s\n",
+					fdt_strerror(node));
+			}
+		}
+	} else if (node < 0) {
+		fprintf(stderr, "Cannot select keys parent: %s\n",
+			fdt_strerror(node));
+		ret = node;
+	}
+
+	if (!ret) {
+		ret = fdt_setprop_string(keydest, node, "key-name-hint",
+					 info->keyname);
+	}
+	if (!ret)
+		ret = fdt_setprop_string(keydest, node, "ecdsa,curve",
+					 "prime256v1");
+	if (!ret)
+		ret = fdt_setprop(keydest, node, "ecdsa,x-point", x_buf,
+				  sizeof(x_buf));
+	if (!ret)
+		ret = fdt_setprop(keydest, node, "ecdsa,y-point", y_buf,
+				  sizeof(y_buf));
+	if (!ret) {
+		ret = fdt_setprop_string(keydest, node, FIT_ALGO_PROP,
+					 info->algo->name);
+	}
+	if (!ret && info->require_keys) {
+		ret = fdt_setprop_string(keydest, node, "required",
+					 info->require_keys);
+	}
+done:
+	BN_free(x);
+	BN_free(y);
+	EC_KEY_free(ec);
+	if (ret)
+		return ret == -FDT_ERR_NOSPACE ? -ENOSPC : -EIO;
+
+	return 0;
+}
@@ -0,0 +1,575 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * ECDSA signature verification for the NIST P-256 (prime256v1) curve.
+ *
+ * Field and scalar arithmetic use 8 x 32-bit limbs (least significant limb
+ * first) in Montgomery form with R = 2^256. Points are kept in Jacobian
+ * coordinates so that only two inversions are needed per signature check.
+ * Verification only handles public data, so no attempt is made to make the
+ * code constant-time.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#include <fdtdec.h>
+#include <linux/errno.h>
+#else
+#include "fdt_host.h"
+#include "mkimage.h"
+#include <fdt_support.h>
+#endif
+#include <u-boot/ecdsa.h>
+
+#define EC_LIMBS	8
+
+typedef uint32_t ec_num[EC_LIMBS];
+
+/* Modulus with precomputed Montgomery constants */
+struct ec_mod {
+	ec_num m;		/* The modulus (p or n) */
+	ec_num rr;		/* R^2 mod m */
+	ec_num one;		/* R mod m, i.e. 1 in Montgomery form */
+	uint32_t n0inv;		/* -1 / m[0] mod 2^32 */
+};
+
+/* Point in Jacobian coordinates; Z == 0 is the point at infinity */
+struct ec_point {
+	ec_num x;
+	ec_num y;
+	ec_num z;
+};
+
+static const uint8_t p256_p[] = {
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+static const uint8_t p256_n[] = {
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84,
+	0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51,
+};
+
+static const uint8_t p256_b[] = {
+	0x5a, 0xc6, 0x35, 0xd8, 0xaa, 0x3a, 0x93, 0xe7,
+	0xb3, 0xeb, 0xbd, 0x55, 0x76, 0x98, 0x86, 0xbc,
+	0x65, 0x1d, 0x06, 0xb0, 0xcc, 0x53, 0xb0, 0xf6,
+	0x3b, 0xce, 0x3c, 0x3e, 0x27, 0xd2, 0x60, 0x4b,
+};
+
+static const uint8_t p256_gx[] = {
+	0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47,
+	0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+	0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0,
+	0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96,
+};
+
+static const uint8_t p256_gy[] = {
+	0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b,
+	0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+	0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce,
+	0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5,
+};
+
+static void ec_from_be(ec_num r, const uint8_t *buf, int len)
+{
+	int i;
+
+	memset(r, '\0', sizeof(ec_num));
+	for (i = 0; i < len && i < EC_LIMBS * 4; i++) {
+		int byte = len - 1 - i;
+
+		r[i / 4] |= (uint32_t)buf[byte] << (8 * (i % 4));
+	}
+}
+
+static int ec_is_zero(const ec_num a)
+{
+	uint32_t acc = 0;
+	int i;
+
+	for (i = 0; i < EC_LIMBS; i++)
+		acc |= a[i];
+
+	return acc == 0;
+}
+
+static int ec_cmp(const ec_num a, const ec_num b)
+{
+	int i;
+
+	for (i = EC_LIMBS - 1; i >= 0; i--) {
+		if (a[i] != b[i])
+			return a[i] > b[i] ? 1 : -1;
+	}
+
+	return 0;
+}
+
+static uint32_t ec_add(ec_num r, const ec_num a, const ec_num b)
+{
+	uint64_t acc = 0;
+	int i;
+
+	for (i = 0; i < EC_LIMBS; i++) {
+		acc += (uint64_t)a[i] + b[i];
+		r[i] = (uint32_t)acc;
+		acc >>= 32;
+	}
+
+	return (uint32_t)acc;
+}
+
+static uint32_t ec_sub(ec_num r, const ec_num a, const ec_num b)
+{
+	int64_t acc = 0;
+	int i;
+
+	for (i = 0; i < EC_LIMBS; i++) {
+		acc += (int64_t)a[i] - b[i];
+		r[i] = (uint32_t)acc;
+		acc >>= 32;
+	}
+
+	return acc ? 1 : 0;
+}
+
+static void mod_add(ec_num r, const ec_num a, const ec_num b,
+		    const struct ec_mod *mod)
+{
+	if (ec_add(r, a, b) || ec_cmp(r, mod->m) >= 0)
+		ec_sub(r, r, mod->m);
+}
+
+static void mod_sub(ec_num r, const ec_num a, const ec_num b,
+		    const struct ec_mod *mod)
+{
+	if (ec_sub(r, a, b))
+		ec_add(r, r, mod->m);
+}
+
+/**
+ * mod_mul() - Montgomery multiplication, r = a * b / R mod m
+ *
+ * This uses the Coarsely Integrated Operand Scanning method. Inputs must be
+ * less than the modulus and the result is fully reduced.
+ */
+static void mod_mul(ec_num r, const ec_num a, const ec_num b,
+		    const struct ec_mod *mod)
+{
+	uint32_t t[EC_LIMBS + 2];
+	uint64_t acc;
+	uint32_t m;
+	int i, j;
+
+	memset(t, '\0', sizeof(t));
+	for (i = 0; i < EC_LIMBS; i++) {
+		acc = 0;
+		for (j = 0; j < EC_LIMBS; j++) {
+			acc += (uint64_t)a[j] * b[i] + t[j];
+			t[j] = (uint32_t)acc;
+			acc >>= 32;
+		}
+		acc += t[EC_LIMBS];
+		t[EC_LIMBS] = (uint32_t)acc;
+		t[EC_LIMBS + 1] = (uint32_t)(acc >> 32);
+
+		m = t[0] * mod->n0inv;
+		acc = (uint64_t)m * mod->m[0] + t[0];
+		acc >>= 32;
+		for (j = 1; j < EC_LIMBS; j++) {
+			acc += (uint64_t)m * mod->m[j] + t[j];
+			t[j - 1] = (uint32_t)acc;
+			acc >>= 32;
+		}
+		acc += t[EC_LIMBS];
+		t[EC_LIMBS - 1] = (uint32_t)acc;
+		t[EC_LIMBS] = t[EC_LIMBS + 1] + (uint32_t)(acc >> 32);
+	}
+
+	if (t[EC_LIMBS] || ec_cmp(t, mod->m) >= 0)
+		ec_sub(t, t, mod->m);
+	memcpy(r, t, sizeof(ec_num));
+}
+
+static void mod_sqr(ec_num r, const ec_num a, const struct ec_mod *mod)
+{
+	mod_mul(r, a, a, mod);
+}
+
+static void mod_to_mont(ec_num r, const ec_num a, const struct ec_mod *mod)
+{
+	mod_mul(r, a, mod->rr, mod);
+}
+
+static void mod_from_mont(ec_num r, const ec_num a, const struct ec_mod *mod)
+{
+	ec_num one = { 1 };
+
+	mod_mul(r, a, one, mod);
+}
+
+/* r = 1 / a mod m, using Fermat's little theorem; a is in Montgomery form */
+static void mod_inv(ec_num r, const ec_num a, const struct ec_mod *mod)
+{
+	ec_num exp, two = { 2 };
+	ec_num acc;
+	int i;
+
+	ec_sub(exp, mod->m, two);
+	memcpy(acc, mod->one, sizeof(ec_num));
+	for (i = EC_LIMBS * 32 - 1; i >= 0; i--) {
+		mod_sqr(acc, acc, mod);
+		if (exp[i / 32] & (1U << (i % 32)))
+			mod_mul(acc, acc, a, mod);
+	}
+	memcpy(r, acc, sizeof(ec_num));
+}
+
+/**
+ * mod_setup() - Work out the Montgomery constants for a modulus
+ *
+ * Both P-256 moduli are larger than 2^255, so R mod m is simply 2^256 - m
+ * and R^2 mod m can be found by doubling that 256 times.
+ */
+static void mod_setup(struct ec_mod *mod, const uint8_t *modulus)
+{
+	ec_num zero = { 0 };
+	uint32_t inv;
+	int i;
+
+	ec_from_be(mod->m, modulus, ECDSA_P256_BYTES);
+	ec_sub(mod->one, zero, mod->m);
+	memcpy(mod->rr, mod->one, sizeof(ec_num));
+	for (i = 0; i < EC_LIMBS * 32; i++)
+		mod_add(mod->rr, mod->rr, mod->rr, mod);
+
+	/* Newton's method doubles the number of correct bits each time */
+	inv = mod->m[0];
+	for (i = 0; i < 4; i++)
+		inv *= 2 - mod->m[0] * inv;
+	mod->n0inv = -inv;
+}
+
+/*
+ * Curve parameters in Montgomery form. These are cheap to work out compared
+ * with a signature check, so are set up on the stack each time; this avoids
+ * needing writable data before relocation.
+ */
+struct ec_curve {
+	struct ec_mod p;
+	struct ec_mod n;
+	ec_num b;
+	struct ec_point g;
+};
+
+static void ec_curve_setup(struct ec_curve *curve)
+{
+	ec_num tmp;
+
+	mod_setup(&curve->p, p256_p);
+	mod_setup(&curve->n, p256_n);
+	ec_from_be(tmp, p256_b, sizeof(p256_b));
+	mod_to_mont(curve->b, tmp, &curve->p);
+	ec_from_be(tmp, p256_gx, sizeof(p256_gx));
+	mod_to_mont(curve->g.x, tmp, &curve->p);
+	ec_from_be(tmp, p256_gy, sizeof(p256_gy));
+	mod_to_mont(curve->g.y, tmp, &curve->p);
+	memcpy(curve->g.z, curve->p.one, sizeof(ec_num));
+}
+
+/* Point doubling for a = -3 (dbl-2001-b) */
+static void ec_double(struct ec_point *r, const struct ec_point *a,
+		      const struct ec_mod *p)
+{
+	ec_num delta, gamma, beta, alpha, t1, t2;
+
+	mod_sqr(delta, a->z, p);
+	mod_sqr(gamma, a->y, p);
+	mod_mul(beta, a->x, gamma, p);
+
+	/* alpha = 3 * (x - delta) * (x + delta) */
+	mod_sub(t1, a->x, delta, p);
+	mod_add(t2, a->x, delta, p);
+	mod_mul(alpha, t1, t2, p);
+	mod_add(t1, alpha, alpha, p);
+	mod_add(alpha, t1, alpha, p);
+
+	/* z3 = (y + z)^2 - gamma - delta */
+	mod_add(t1, a->y, a->z, p);
+	mod_sqr(t1, t1, p);
+	mod_sub(t1, t1, gamma, p);
+	mod_sub(r->z, t1, delta, p);
+
+	/* x3 = alpha^2 - 8 * beta */
+	mod_add(beta, beta, beta, p);
+	mod_add(beta, beta, beta, p);
+	mod_add(t2, beta, beta, p);
+	mod_sqr(t1, alpha, p);
+	mod_sub(r->x, t1, t2, p);
+
+	/* y3 = alpha * (4 * beta - x3) - 8 * gamma^2 */
+	mod_sub(t1, beta, r->x, p);
+	mod_mul(t1, alpha, t1, p);
+	mod_sqr(gamma, gamma, p);
+	mod_add(gamma, gamma, gamma, p);
+	mod_add(gamma, gamma, gamma, p);
+	mod_add(gamma, gamma, gamma, p);
+	mod_sub(r->y, t1, gamma, p);
+}
+
+/* General point addition (add-2007-bl) */
+static void ec_add_point(struct ec_point *r, const struct ec_point *a,
+			 const struct ec_point *b, const struct ec_mod *p)
+{
+	ec_num z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+
+	if (ec_is_zero(a->z)) {
+		*r = *b;
+		return;
+	}
+	if (ec_is_zero(b->z)) {
+		*r = *a;
+		return;
+	}
+
+	mod_sqr(z1z1, a->z, p);
+	mod_sqr(z2z2, b->z, p);
+	mod_mul(u1, a->x, z2z2, p);
+	mod_mul(u2, b->x, z1z1, p);
+	mod_mul(t, b->z, z2z2, p);
+	mod_mul(s1, a->y, t, p);
+	mod_mul(t, a->z, z1z1, p);
+	mod_mul(s2, b->y, t, p);
+
+	mod_sub(h, u2, u1, p);
+	mod_sub(rr, s2, s1, p);
+	if (ec_is_zero(h)) {
+		if (ec_is_zero(rr)) {
+			ec_double(r, a, p);
+		} else {
+			memset(r, '\0', sizeof(*r));
+			memcpy(r->x, p->one, sizeof(ec_num));
+			memcpy(r->y, p->one, sizeof(ec_num));
+		}
+		return;
+	}
+	mod_add(rr, rr, rr, p);
+
+	/* i = (2h)^2, j = h * i, v = u1 * i */
+	mod_add(i, h, h, p);
+	mod_sqr(i, i, p);
+	mod_mul(j, h, i, p);
+	mod_mul(v, u1, i, p);
+
+	/* z3 = ((z1 + z2)^2 - z1z1 - z2z2) * h */
+	mod_add(t, a->z, b->z, p);
+	mod_sqr(t, t, p);
+	mod_sub(t, t, z1z1, p);
+	mod_sub(t, t, z2z2, p);
+	mod_mul(r->z, t, h, p);
+
+	/* x3 = rr^2 - j - 2v */
+	mod_sqr(t, rr, p);
+	mod_sub(t, t, j, p);
+	mod_sub(t, t, v, p);
+	mod_sub(r->x, t, v, p);
+
+	/* y3 = rr * (v - x3) - 2 * s1 * j */
+	mod_sub(t, v, r->x, p);
+	mod_mul(t, rr, t, p);
+	mod_mul(s1, s1, j, p);
+	mod_add(s1, s1, s1, p);
+	mod_sub(r->y, t, s1, p);
+}
+
+/* Check that an affine point (in Montgomery form) satisfies the curve */
+static int ec_on_curve(const struct ec_curve *curve, const ec_num x,
+		       const ec_num y)
+{
+	const struct ec_mod *p = &curve->p;
+	ec_num lhs, rhs, t;
+
+	/* y^2 = x^3 - 3x + b */
+	mod_sqr(lhs, y, p);
+	mod_sqr(rhs, x, p);
+	mod_mul(rhs, rhs, x, p);
+	mod_add(t, x, x, p);
+	mod_add(t, t, x, p);
+	mod_sub(rhs, rhs, t, p);
+	mod_add(rhs, rhs, curve->b, p);
+
+	return !ec_cmp(lhs, rhs);
+}
+
+int ecdsa_p256_verify_hash(const uint8_t *pub_x, const uint8_t *pub_y,
+			   const uint8_t *hash, int hash_len,
+			   const uint8_t *sig)
+{
+	struct ec_curve curve_store, *curve = &curve_store;
+	struct ec_point q, gq, acc;
+	ec_num r, s, e, w, u1, u2, t;
+	int i;
+
+	ec_curve_setup(curve);
+
+	/* 0 < r, s < n */
+	ec_from_be(r, sig, ECDSA_P256_BYTES);
+	ec_from_be(s, sig + ECDSA_P256_BYTES, ECDSA_P256_BYTES);
+	if (ec_is_zero(r) || ec_cmp(r, curve->n.m) >= 0 ||
+	    ec_is_zero(s) || ec_cmp(s, curve->n.m) >= 0)
+		return -EACCES;
+
+	/* The public key must be a valid point on the curve */
+	ec_from_be(t, pub_x, ECDSA_P256_BYTES);
+	if (ec_cmp(t, curve->p.m) >= 0)
+		return -EINVAL;
+	mod_to_mont(q.x, t, &curve->p);
+	ec_from_be(t, pub_y, ECDSA_P256_BYTES);
+	if (ec_cmp(t, curve->p.m) >= 0)
+		return -EINVAL;
+	mod_to_mont(q.y, t, &curve->p);
+	memcpy(q.z, curve->p.one, sizeof(ec_num));
+	if (!ec_on_curve(curve, q.x, q.y))
+		return -EINVAL;
+
+	/* e is the leftmost 256 bits of the hash, reduced mod n */
+	ec_from_be(e, hash, hash_len < ECDSA_P256_BYTES ?
+		   hash_len : ECDSA_P256_BYTES);
+	if (ec_cmp(e, curve->n.m) >= 0)
+		ec_sub(e, e, curve->n.m);
+
+	/*
+	 * w = 1 / s, in Montgomery form. Multiplying by a number in normal
+	 * form then gives u1 = e * w and u2 = r * w in normal form.
+	 */
+	mod_to_mont(t, s, &curve->n);
+	mod_inv(w, t, &curve->n);
+	mod_mul(u1, e, w, &curve->n);
+	mod_mul(u2, r, w, &curve->n);
+
+	/* acc = u1 * G + u2 * Q, processing both scalars together */
+	ec_add_point(&gq, &curve->g, &q, &curve->p);
+	memset(&acc, '\0', sizeof(acc));
+	for (i = EC_LIMBS * 32 - 1; i >= 0; i--) {
+		int b1 = (u1[i / 32] >> (i % 32)) & 1;
+		int b2 = (u2[i / 32] >> (i % 32)) & 1;
+
+		ec_double(&acc, &acc, &curve->p);
+		if (b1 && b2)
+			ec_add_point(&acc, &acc, &gq, &curve->p);
+		else if (b1)
+			ec_add_point(&acc, &acc, &curve->g, &curve->p);
+		else if (b2)
+			ec_add_point(&acc, &acc, &q, &curve->p);
+	}
+	if (ec_is_zero(acc.z))
+		return -EACCES;
+
+	/* Convert x to affine and reduce mod n */
+	mod_inv(t, acc.z, &curve->p);
+	mod_sqr(t, t, &curve->p);
+	mod_mul(t, acc.x, t, &curve->p);
+	mod_from_mont(t, t, &curve->p);
+	if (ec_cmp(t, curve->n.m) >= 0)
+		ec_sub(t, t, curve->n.m);
+
+	return ec_cmp(t, r) ? -EACCES : 0;
+}
+
+static int ecdsa_verify_with_keynode(struct image_sign_info *info,
+				     const void *hash, uint8_t *sig,
+				     uint sig_len, int node)
+{
+	const void *blob = info->fdt_blob;
+	const uint8_t *x, *y;
+	const char *curve;
+	int len;
+
+	if (node < 0) {
+		debug("%s: Skipping invalid node", __func__);
+		return -EBADF;
+	}
+
+	curve = fdt_getprop(blob, node, "ecdsa,curve", NULL);
+	if (!curve || strcmp(curve, "prime256v1")) {
+		debug("%s: Key is not a P-256 key\n", __func__);
+		return -EFAULT;
+	}
+
+	x = fdt_getprop(blob, node, "ecdsa,x-point", &len);
+	if (!x || len != ECDSA_P256_BYTES)
+		return -EFAULT;
+	y = fdt_getprop(blob, node, "ecdsa,y-point", &len);
+	if (!y || len != ECDSA_P256_BYTES)
+		return -EFAULT;
+
+	return ecdsa_p256_verify_hash(x, y, hash,
+				      info->algo->checksum->checksum_len, sig);
+}
+
+int ecdsa_verify(struct image_sign_info *info,
+		 const struct image_region region[], int region_count,
+		 uint8_t *sig, uint sig_len)
+{
+	const void *blob = info->fdt_blob;
+	uint8_t hash[info->algo->checksum->checksum_len];
+	int ndepth, noffset;
+	int sig_node, node;
+	char name[100];
+	int ret;
+
+	if (sig_len != ECDSA_P256_SIG_BYTES) {
+		debug("%s: Signature is %u bytes, expected %d\n", __func__,
+		      sig_len, ECDSA_P256_SIG_BYTES);
+		return -EINVAL;
+	}
+
+	sig_node = fdt_subnode_offset(blob, 0, FIT_SIG_NODENAME);
+	if (sig_node < 0) {
+		debug("%s: No signature node found\n", __func__);
+		return -ENOENT;
+	}
+
+	ret = info->algo->checksum->calculate(info->algo->checksum->name,
+					region, region_count, hash);
+	if (ret < 0) {
+		debug("%s: Error in checksum calculation\n", __func__);
+		return -EINVAL;
+	}
+
+	/* See if we must use a particular key */
+	if (info->required_keynode != -1) {
+		ret = ecdsa_verify_with_keynode(info, hash, sig, sig_len,
+						info->required_keynode);
+		if (!ret)
+			return ret;
+	}
+
+	/* Look for a key that matches our hint */
+	snprintf(name, sizeof(name), "key-%s", info->keyname);
+	node = fdt_subnode_offset(blob, sig_node, name);
+	ret = ecdsa_verify_with_keynode(info, hash, sig, sig_len, node);
+	if (!ret)
+		return ret;
+
+	/* No luck, so try each of the keys in turn */
+	for (ndepth = 0, noffset = fdt_next_node(blob, sig_node, &ndepth);
+			(noffset >= 0) && (ndepth > 0);
+			noffset = fdt_next_node(blob, noffset, &ndepth)) {
+		if (ndepth == 1 && noffset != node) {
+			ret = ecdsa_verify_with_keynode(info, hash, sig,
+							sig_len, noffset);
+			if (!ret)
+				break;
+		}
+	}
+
+	return ret;
+}
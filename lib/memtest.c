@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Fast memory test, intended for testing all of DRAM in manufacturing
+ *
+ * All accesses are 64 bits wide and the inner loops are unrolled, with
+ * errors checked four words at a time. Progress, Ctrl-C and the watchdog are
+ * handled once per chunk rather than once per word. After each chunk is
+ * written the cache is flushed, so that read-back always comes from memory
+ * even for areas which would fit in the cache. Passes which only write or
+ * only read are split across the CPUs in the worker pool, one chunk each.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <console.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <watchdog.h>
+#include <worker.h>
+#include <linux/sizes.h>
+
+/* Amount of memory handled by each CPU between checks for Ctrl-C */
+#define MEMTEST_CHUNK		SZ_1M
+
+/* Maximum number of chunks handled at once by the worker pool */
+#define MEMTEST_MAX_PARTS	8
+
+/**
+ * struct memtest_fail - An error held back to be printed later
+ *
+ * @addr:	Address of the word
+ * @found:	Value read back
+ * @expect:	Value expected
+ */
+struct memtest_fail {
+	ulong addr;
+	u64 found;
+	u64 expect;
+};
+
+/**
+ * struct memtest_area - An area of memory being tested
+ *
+ * @buf:	Pointer to the start of the area
+ * @start:	Address of the start of the area
+ * @words:	Number of 64-bit words in the area
+ * @res:	Results of the test so far
+ * @held:	Errors held back, since they cannot be printed from a worker;
+ *		NULL to print them straight away
+ * @held_count:	Number of errors in @held
+ */
+struct memtest_area {
+	u64 *buf;
+	ulong start;
+	ulong words;
+	struct memtest_result *res;
+	struct memtest_fail *held;
+	int held_count;
+};
+
+typedef void (*memtest_op_t)(struct memtest_area *area, u64 *p, ulong count,
+			     u64 pattern);
+
+/* Flags for each step of a test */
+enum {
+	MT_WRITE	= 1 << 0,	/* step writes every word */
+	MT_READ		= 1 << 1,	/* step reads every word */
+	MT_DOWN		= 1 << 2,	/* step runs from the top down */
+};
+
+static inline ulong memtest_addr(struct memtest_area *area, u64 *p)
+{
+	return area->start + (p - area->buf) * sizeof(u64);
+}
+
+static void memtest_print_error(ulong addr, u64 found, u64 expect)
+{
+	printf("Mem error @ 0x%08lx: found %016llx, expected %016llx\n",
+	       addr, found, expect);
+}
+
+static void memtest_error(struct memtest_area *area, u64 *p, u64 expect)
+{
+	struct memtest_result *res = area->res;
+	ulong addr = memtest_addr(area, p);
+	u64 found = *p;
+	struct memtest_fail *fail;
+
+	if (!res->errors)
+		res->first_fail = addr;
+	if (res->errors < MEMTEST_MAX_REPORT) {
+		if (area->held) {
+			fail = &area->held[area->held_count++];
+			fail->addr = addr;
+			fail->found = found;
+			fail->expect = expect;
+		} else {
+			memtest_print_error(addr, found, expect);
+		}
+	}
+	res->errors++;
+	res->fail_bits |= found ^ expect;
+}
+
+static void memtest_fill_const(struct memtest_area *area, u64 *p,
+			       ulong count, u64 pattern)
+{
+	u64 *end = p + count;
+
+	for (; p + 4 <= end; p += 4) {
+		p[0] = pattern;
+		p[1] = pattern;
+		p[2] = pattern;
+		p[3] = pattern;
+	}
+	for (; p < end; p++)
+		*p = pattern;
+}
+
+static void memtest_check_const(struct memtest_area *area, u64 *p,
+				ulong count, u64 pattern)
+{
+	u64 *end = p + count;
+	int i;
+
+	for (; p + 4 <= end; p += 4) {
+		if (!((p[0] ^ pattern) | (p[1] ^ pattern) |
+		      (p[2] ^ pattern) | (p[3] ^ pattern)))
+			continue;
+		for (i = 0; i < 4; i++) {
+			if (p[i] != pattern)
+				memtest_error(area, p + i, pattern);
+		}
+	}
+	for (; p < end; p++) {
+		if (*p != pattern)
+			memtest_error(area, p, pattern);
+	}
+}
+
+/* Check for @pattern and write its inverse, from the bottom up */
+static void memtest_invert_up(struct memtest_area *area, u64 *p, ulong count,
+			      u64 pattern)
+{
+	u64 *end = p + count;
+
+	for (; p < end; p++) {
+		if (*p != pattern)
+			memtest_error(area, p, pattern);
+		*p = ~pattern;
+	}
+}
+
+/* Check for @pattern and write its inverse, from the top down */
+static void memtest_invert_down(struct memtest_area *area, u64 *p,
+				ulong count, u64 pattern)
+{
+	ulong i;
+
+	for (i = count; i-- > 0;) {
+		if (p[i] != pattern)
+			memtest_error(area, p + i, pattern);
+		p[i] = ~pattern;
+	}
+}
+
+/* Each word holds its own address, XORed with @pattern */
+static void memtest_fill_addr(struct memtest_area *area, u64 *p, ulong count,
+			      u64 pattern)
+{
+	u64 *end = p + count;
+	u64 addr = memtest_addr(area, p);
+
+	for (; p < end; p++, addr += sizeof(u64))
+		*p = addr ^ pattern;
+}
+
+static void memtest_check_addr(struct memtest_area *area, u64 *p, ulong count,
+			       u64 pattern)
+{
+	u64 *end = p + count;
+	u64 addr = memtest_addr(area, p);
+
+	for (; p < end; p++, addr += sizeof(u64)) {
+		if (*p != (addr ^ pattern))
+			memtest_error(area, p, addr ^ pattern);
+	}
+}
+
+/* A single bit set, moving up one place for each word; XORed with @pattern */
+static inline u64 memtest_walk_value(struct memtest_area *area, u64 *p,
+				     u64 pattern)
+{
+	return (1ULL << ((p - area->buf) & 63)) ^ pattern;
+}
+
+static void memtest_fill_walk(struct memtest_area *area, u64 *p, ulong count,
+			      u64 pattern)
+{
+	u64 *end = p + count;
+
+	for (; p < end; p++)
+		*p = memtest_walk_value(area, p, pattern);
+}
+
+static void memtest_check_walk(struct memtest_area *area, u64 *p, ulong count,
+			       u64 pattern)
+{
+	u64 *end = p + count;
+	u64 val;
+
+	for (; p < end; p++) {
+		val = memtest_walk_value(area, p, pattern);
+		if (*p != val)
+			memtest_error(area, p, val);
+	}
+}
+
+/**
+ * struct memtest_step - One pass over the area
+ *
+ * @op:		Operation to perform on each chunk
+ * @pattern:	Pattern passed to @op
+ * @flags:	MT_... flags
+ */
+struct memtest_step {
+	memtest_op_t op;
+	u64 pattern;
+	uint flags;
+};
+
+#define PAT_ZEROS	0ULL
+#define PAT_ONES	(~0ULL)
+#define PAT_ALT		0x5555555555555555ULL
+
+static const struct memtest_step memtest_steps[] = {
+	/* Walking ones and walking zeros, for data line faults */
+	{ memtest_fill_walk, PAT_ZEROS, MT_WRITE },
+	{ memtest_check_walk, PAT_ZEROS, MT_READ },
+	{ memtest_fill_walk, PAT_ONES, MT_WRITE },
+	{ memtest_check_walk, PAT_ONES, MT_READ },
+
+	/* Own address and its inverse, for address line faults */
+	{ memtest_fill_addr, PAT_ZEROS, MT_WRITE },
+	{ memtest_check_addr, PAT_ZEROS, MT_READ },
+	{ memtest_fill_addr, PAT_ONES, MT_WRITE },
+	{ memtest_check_addr, PAT_ONES, MT_READ },
+
+	/* Moving inversions, for stuck and coupled cells */
+	{ memtest_fill_const, PAT_ZEROS, MT_WRITE },
+	{ memtest_invert_up, PAT_ZEROS, MT_READ | MT_WRITE },
+	{ memtest_invert_down, PAT_ONES, MT_READ | MT_WRITE | MT_DOWN },
+	{ memtest_fill_const, PAT_ALT, MT_WRITE },
+	{ memtest_invert_up, PAT_ALT, MT_READ | MT_WRITE },
+	{ memtest_invert_down, ~PAT_ALT, MT_READ | MT_WRITE | MT_DOWN },
+	{ memtest_check_const, PAT_ALT, MT_READ },
+};
+
+/* Run an operation over the chunk which is @pos words from the start */
+static void memtest_chunk(struct memtest_area *area, memtest_op_t op,
+			  ulong pos, ulong count, u64 pattern, uint flags)
+{
+	u64 *p;
+
+	if (flags & MT_DOWN)
+		p = area->buf + area->words - pos - count;
+	else
+		p = area->buf + pos;
+	op(area, p, count, pattern);
+	if (flags & MT_WRITE) {
+		flush_cache(memtest_addr(area, p), count * sizeof(u64));
+		area->res->bytes += count * sizeof(u64);
+	}
+	if (flags & MT_READ)
+		area->res->bytes += count * sizeof(u64);
+}
+
+/**
+ * struct memtest_batch - Chunks handled at once by the worker pool
+ *
+ * @op:		Operation to perform on each chunk
+ * @pattern:	Pattern passed to @op
+ * @flags:	MT_... flags
+ * @pos:	Position of the first chunk, in words
+ * @words:	Number of words in the batch
+ * @part:	Area for each chunk, with its own results
+ * @res:	Results for each chunk
+ * @held:	Errors held back for each chunk
+ */
+struct memtest_batch {
+	memtest_op_t op;
+	u64 pattern;
+	uint flags;
+	ulong pos;
+	ulong words;
+	struct memtest_area part[MEMTEST_MAX_PARTS];
+	struct memtest_result res[MEMTEST_MAX_PARTS];
+	struct memtest_fail held[MEMTEST_MAX_PARTS][MEMTEST_MAX_REPORT];
+};
+
+static void memtest_batch_part(void *arg, int part)
+{
+	struct memtest_batch *batch = arg;
+	const ulong chunk = MEMTEST_CHUNK / sizeof(u64);
+	ulong pos = part * chunk;
+
+	memtest_chunk(&batch->part[part], batch->op, batch->pos + pos,
+		      min(chunk, batch->words - pos), batch->pattern,
+		      batch->flags);
+}
+
+/* Add the results of a chunk to the total, printing the errors it held */
+static void memtest_merge(struct memtest_result *res,
+			  struct memtest_area *part)
+{
+	struct memtest_result *pres = part->res;
+	struct memtest_fail *fail;
+	int i;
+
+	for (i = 0; i < part->held_count; i++) {
+		fail = &part->held[i];
+		if (res->errors + i < MEMTEST_MAX_REPORT)
+			memtest_print_error(fail->addr, fail->found,
+					    fail->expect);
+	}
+	if (pres->errors && !res->errors)
+		res->first_fail = pres->first_fail;
+	res->errors += pres->errors;
+	res->fail_bits |= pres->fail_bits;
+	res->bytes += pres->bytes;
+}
+
+/*
+ * Run a pass, several chunks at a time. This is only used for passes which
+ * do not both read and write, since the moving-inversions passes rely on
+ * the order in which words are visited.
+ */
+static int memtest_pass_parallel(struct memtest_area *area, memtest_op_t op,
+				 u64 pattern, uint flags, int parts)
+{
+	const ulong chunk = MEMTEST_CHUNK / sizeof(u64);
+	struct memtest_batch *batch;
+	int ret = 0;
+	int i;
+
+	batch = malloc(sizeof(*batch));
+	if (!batch)
+		return -ENOMEM;
+	batch->op = op;
+	batch->pattern = pattern;
+	batch->flags = flags;
+	for (batch->pos = 0; batch->pos < area->words;
+	     batch->pos += batch->words) {
+		batch->words = min(parts * chunk, area->words - batch->pos);
+		parts = DIV_ROUND_UP(batch->words, chunk);
+		for (i = 0; i < parts; i++) {
+			batch->part[i] = *area;
+			memset(&batch->res[i], '\0', sizeof(batch->res[i]));
+			batch->part[i].res = &batch->res[i];
+			batch->part[i].held = batch->held[i];
+			batch->part[i].held_count = 0;
+		}
+		worker_run(memtest_batch_part, batch, parts);
+		for (i = 0; i < parts; i++)
+			memtest_merge(area->res, &batch->part[i]);
+
+		WATCHDOG_RESET();
+		if (ctrlc()) {
+			ret = -EINTR;
+			break;
+		}
+	}
+	free(batch);
+
+	return ret;
+}
+
+static int memtest_pass(struct memtest_area *area, memtest_op_t op,
+			u64 pattern, uint flags)
+{
+	const ulong chunk = MEMTEST_CHUNK / sizeof(u64);
+	int parts = min(worker_count(), MEMTEST_MAX_PARTS);
+	ulong pos, count;
+
+	if (parts > 1 && !((flags & MT_READ) && (flags & MT_WRITE)))
+		return memtest_pass_parallel(area, op, pattern, flags, parts);
+
+	for (pos = 0; pos < area->words; pos += count) {
+		count = min(chunk, area->words - pos);
+		memtest_chunk(area, op, pos, count, pattern, flags);
+
+		WATCHDOG_RESET();
+		if (ctrlc())
+			return -EINTR;
+	}
+
+	return 0;
+}
+
+static int memtest_setup(struct memtest_area *area, ulong start, ulong size,
+			 struct memtest_result *res)
+{
+	if ((start | size) & (sizeof(u64) - 1))
+		return -EINVAL;
+	area->buf = map_sysmem(start, size);
+	area->start = start;
+	area->words = size / sizeof(u64);
+	area->res = res;
+	area->held = NULL;
+	area->held_count = 0;
+
+	return 0;
+}
+
+int memtest_run(ulong start, ulong size, struct memtest_result *res)
+{
+	const struct memtest_step *step;
+	struct memtest_area area;
+	int ret;
+
+	ret = memtest_setup(&area, start, size, res);
+	if (ret)
+		return ret;
+	worker_start();
+	for (step = memtest_steps;
+	     step < memtest_steps + ARRAY_SIZE(memtest_steps); step++) {
+		ret = memtest_pass(&area, step->op, step->pattern, step->flags);
+		if (ret)
+			break;
+	}
+	unmap_sysmem(area.buf);
+
+	return ret;
+}
+
+void memtest_fill(ulong start, ulong size, u64 pattern)
+{
+	struct memtest_result res;
+	struct memtest_area area;
+
+	memset(&res, '\0', sizeof(res));
+	if (memtest_setup(&area, start, size, &res))
+		return;
+	memtest_pass(&area, memtest_fill_const, pattern, MT_WRITE);
+	unmap_sysmem(area.buf);
+}
+
+int memtest_check(ulong start, ulong size, u64 pattern,
+		  struct memtest_result *res)
+{
+	struct memtest_area area;
+	int ret;
+
+	ret = memtest_setup(&area, start, size, res);
+	if (ret)
+		return ret;
+	ret = memtest_pass(&area, memtest_check_const, pattern, MT_READ);
+	unmap_sysmem(area.buf);
+
+	return ret;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Build a live device tree from a flat one
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <of_live.h>
+#include <dm/of.h>
+
+/**
+ * of_live_unflatten() - Walk the flat tree, building the live tree if needed
+ *
+ * This is called twice: once with @nodes set to NULL to count the nodes and
+ * properties, then again to fill them in.
+ *
+ * @blob:	Flat device tree to read
+ * @nodes:	Space for the nodes, or NULL to just count
+ * @props:	Space for the properties (ignored if @nodes is NULL)
+ * @node_countp: Returns the number of nodes
+ * @prop_countp: Returns the number of properties
+ * @return 0 if OK, -EINVAL if the flat tree is invalid
+ */
+static int of_live_unflatten(const void *blob, struct device_node *nodes,
+			     struct property *props, int *node_countp,
+			     int *prop_countp)
+{
+	struct device_node *cur = NULL, *prev = NULL, *np;
+	struct property **propp = NULL, *pp;
+	const struct fdt_property *prop;
+	int node_count = 0, prop_count = 0;
+	int offset, next, depth = 0;
+	uint32_t tag;
+
+	for (offset = 0; ; offset = next) {
+		tag = fdt_next_tag(blob, offset, &next);
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			depth++;
+			if (!nodes) {
+				node_count++;
+				break;
+			}
+			np = &nodes[node_count++];
+			np->name = fdt_get_name(blob, offset, NULL);
+			np->of_offset = offset;
+			np->parent = cur;
+			if (prev)
+				prev->sibling = np;
+			else if (cur)
+				cur->child = np;
+			propp = &np->properties;
+			cur = np;
+			prev = NULL;
+			break;
+		case FDT_END_NODE:
+			if (--depth < 0)
+				return -EINVAL;
+			if (nodes) {
+				prev = cur;
+				cur = cur->parent;
+				propp = NULL;
+			}
+			if (!depth)
+				goto done;
+			break;
+		case FDT_PROP:
+			if (!depth)
+				return -EINVAL;
+			if (!nodes) {
+				prop_count++;
+				break;
+			}
+			/* Properties must come before subnodes */
+			if (!propp)
+				return -EINVAL;
+			prop = fdt_offset_ptr(blob, offset, sizeof(*prop));
+			if (!prop)
+				return -EINVAL;
+			pp = &props[prop_count++];
+			pp->name = fdt_string(blob,
+					      fdt32_to_cpu(prop->nameoff));
+			pp->length = fdt32_to_cpu(prop->len);
+			pp->value = prop->data;
+			*propp = pp;
+			propp = &pp->next;
+			if (pp->length == sizeof(fdt32_t) &&
+			    (!strcmp(pp->name, "phandle") ||
+			     !strcmp(pp->name, "linux,phandle")))
+				cur->phandle =
+					fdt32_to_cpu(*(fdt32_t *)pp->value);
+			break;
+		case FDT_NOP:
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+done:
+	*node_countp = node_count;
+	*prop_countp = prop_count;
+
+	return node_count ? 0 : -EINVAL;
+}
+
+int of_live_build(const void *blob, struct device_node **rootp)
+{
+	struct device_node *nodes;
+	int node_count, prop_count;
+	int ret;
+
+	if (fdt_check_header(blob))
+		return -EINVAL;
+	ret = of_live_unflatten(blob, NULL, NULL, &node_count, &prop_count);
+	if (ret)
+		return ret;
+
+	nodes = calloc(1, node_count * sizeof(struct device_node) +
+		       prop_count * sizeof(struct property));
+	if (!nodes)
+		return -ENOMEM;
+	ret = of_live_unflatten(blob, nodes,
+				(struct property *)(nodes + node_count),
+				&node_count, &prop_count);
+	if (ret) {
+		free(nodes);
+		return ret;
+	}
+	debug("%s: %d nodes, %d properties\n", __func__, node_count,
+	      prop_count);
+	*rootp = nodes;
+
+	return 0;
+}
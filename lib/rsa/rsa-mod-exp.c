@@ -10,6 +10,7 @@
 #include <asm/types.h>
 #include <asm/byteorder.h>
 #include <linux/errno.h>
+#include <malloc.h>
 #include <asm/types.h>
 #include <asm/unaligned.h>
 #else
@@ -28,6 +29,16 @@
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+/*
+ * On 64-bit machines the Montgomery multiplication can work on 64-bit limbs
+ * using the compiler's 128-bit type. This quarters the number of inner-loop
+ * multiplications compared to 32-bit limbs.
+ */
+#if defined(__SIZEOF_INT128__) && (defined(USE_HOSTCC) || \
+	defined(CONFIG_ARM64) || defined(CONFIG_SANDBOX))
+#define RSA_MONT64
+#endif
+
 /**
  * subtract_modulus() - subtract modulus from the given value
  *
@@ -239,6 +250,205 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	return 0;
 }
 
+#ifdef RSA_MONT64
+/**
+ * struct rsa_public_key64 - public key using 64-bit limbs
+ *
+ * This holds the same information as struct rsa_public_key, but with the
+ * Montgomery constant and arrays made up of 64-bit words.
+ */
+struct rsa_public_key64 {
+	uint len;		/* len of modulus[] in number of uint64_t */
+	uint64_t n0inv;		/* -1 / modulus[0] mod 2^64 */
+	uint64_t *modulus;	/* modulus as little endian array */
+	uint64_t *rr;		/* R^2 as little endian array */
+	uint64_t exponent;	/* public exponent */
+};
+
+/**
+ * rsa_n0inv64() - Calculate the 64-bit Montgomery constant for a modulus
+ *
+ * The device tree only holds -1 / modulus[0] mod 2^32, so work out the 64-bit
+ * value using Newton's method. Each iteration doubles the number of correct
+ * bits; an odd modulus is its own inverse modulo 2^3.
+ *
+ * @m0:		Lowest 64-bit word of the modulus
+ * @return -1 / m0 mod 2^64
+ */
+static uint64_t rsa_n0inv64(uint64_t m0)
+{
+	uint64_t inv = m0;
+	int i;
+
+	for (i = 0; i < 5; i++)
+		inv *= 2 - m0 * inv;
+
+	return -inv;
+}
+
+static void subtract_modulus64(const struct rsa_public_key64 *key,
+			       uint64_t num[])
+{
+	uint64_t borrow = 0;
+	uint i;
+
+	for (i = 0; i < key->len; i++) {
+		__uint128_t diff;
+
+		diff = (__uint128_t)num[i] - key->modulus[i] - borrow;
+		num[i] = (uint64_t)diff;
+		borrow = (diff >> 64) ? 1 : 0;
+	}
+}
+
+static int greater_equal_modulus64(const struct rsa_public_key64 *key,
+				   uint64_t num[])
+{
+	int i;
+
+	for (i = (int)key->len - 1; i >= 0; i--) {
+		if (num[i] < key->modulus[i])
+			return 0;
+		if (num[i] > key->modulus[i])
+			return 1;
+	}
+
+	return 1;  /* equal */
+}
+
+/* As montgomery_mul_add_step(), but with 64-bit limbs */
+static void montgomery_mul_add_step64(const struct rsa_public_key64 *key,
+		uint64_t result[], const uint64_t a, const uint64_t b[])
+{
+	__uint128_t acc_a, acc_b;
+	uint64_t d0;
+	uint i;
+
+	acc_a = (__uint128_t)a * b[0] + result[0];
+	d0 = (uint64_t)acc_a * key->n0inv;
+	acc_b = (__uint128_t)d0 * key->modulus[0] + (uint64_t)acc_a;
+	for (i = 1; i < key->len; i++) {
+		acc_a = (acc_a >> 64) + (__uint128_t)a * b[i] + result[i];
+		acc_b = (acc_b >> 64) + (__uint128_t)d0 * key->modulus[i] +
+				(uint64_t)acc_a;
+		result[i - 1] = (uint64_t)acc_b;
+	}
+
+	acc_a = (acc_a >> 64) + (acc_b >> 64);
+
+	result[i - 1] = (uint64_t)acc_a;
+
+	if (acc_a >> 64)
+		subtract_modulus64(key, result);
+}
+
+static void montgomery_mul64(const struct rsa_public_key64 *key,
+		uint64_t result[], uint64_t a[], const uint64_t b[])
+{
+	uint i;
+
+	for (i = 0; i < key->len; ++i)
+		result[i] = 0;
+	for (i = 0; i < key->len; ++i)
+		montgomery_mul_add_step64(key, result, a[i], b);
+}
+
+/**
+ * get_be64_words() - Read a 64-bit value from a big-endian word array
+ *
+ * Device-tree properties are only 32-bit aligned, so read the two halves
+ * separately.
+ *
+ * @src:	Pointer to two big-endian 32-bit words
+ * @return value
+ */
+static uint64_t get_be64_words(const uint32_t *src)
+{
+	return (uint64_t)fdt32_to_cpu(src[0]) << 32 | fdt32_to_cpu(src[1]);
+}
+
+static void put_be64_words(uint64_t val, uint32_t *dst)
+{
+	put_unaligned_be32((uint32_t)(val >> 32), dst);
+	put_unaligned_be32((uint32_t)val, dst + 1);
+}
+
+/**
+ * pow_mod64() - in-place public exponentiation with 64-bit limbs
+ *
+ * This follows the same algorithm as pow_mod().
+ *
+ * @key:	RSA key
+ * @inout:	Big-endian word array containing value and result
+ */
+static int pow_mod64(const struct rsa_public_key64 *key, uint32_t *inout)
+{
+	uint64_t *result, exp;
+	uint32_t *ptr;
+	uint i;
+	int j, k;
+
+	uint64_t val[key->len], acc[key->len], tmp[key->len];
+	uint64_t a_scaled[key->len];
+	result = tmp;  /* Re-use location. */
+
+	/* Convert from big endian word array to little endian limb array. */
+	for (i = 0, ptr = inout + (key->len - 1) * 2; i < key->len;
+	     i++, ptr -= 2)
+		val[i] = get_be64_words(ptr);
+
+	for (k = 0, exp = key->exponent; exp; exp >>= 1)
+		k++;
+	if (k < 2) {
+		debug("Public exponent is too short (%d bits, minimum 2)\n",
+		      k);
+		return -EINVAL;
+	}
+
+	if (!(key->exponent & 1)) {
+		debug("LSB of RSA public exponent must be set.\n");
+		return -EINVAL;
+	}
+
+	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
+	montgomery_mul64(key, acc, val, key->rr);
+	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul64(key, tmp, acc, acc);
+
+		if (key->exponent & (1ULL << j))
+			montgomery_mul64(key, acc, tmp, a_scaled);
+		else
+			memcpy(acc, tmp, key->len * sizeof(acc[0]));
+	}
+
+	/* the bit at e[0] is always 1 */
+	montgomery_mul64(key, tmp, acc, acc);
+	montgomery_mul64(key, acc, tmp, val);
+	memcpy(result, acc, key->len * sizeof(result[0]));
+
+	/* Make sure result < mod; result is at most 1x mod too large. */
+	if (greater_equal_modulus64(key, result))
+		subtract_modulus64(key, result);
+
+	/* Convert to bigendian word array */
+	for (i = key->len - 1, ptr = inout; (int)i >= 0; i--, ptr += 2)
+		put_be64_words(result[i], ptr);
+
+	return 0;
+}
+
+static void rsa_convert_big_endian64(uint64_t *dst, const uint32_t *src,
+				     int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		dst[i] = get_be64_words(src + (len - 1 - i) * 2);
+}
+#endif /* RSA_MONT64 */
+
 static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 {
 	int i;
@@ -247,53 +457,138 @@ static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 		dst[i] = fdt32_to_cpu(src[len - 1 - i]);
 }
 
-int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
-		struct key_prop *prop, uint8_t *out)
-{
+/**
+ * struct rsa_decoded_key - a public key converted for pow_mod()
+ *
+ * @mont64:	true to use @key64 and pow_mod64(), false to use @key and
+ *		pow_mod()
+ * @key:	Key with 32-bit words
+ * @key64:	Key with 64-bit words
+ */
+struct rsa_decoded_key {
+	bool mont64;
 	struct rsa_public_key key;
-	int ret;
+#ifdef RSA_MONT64
+	struct rsa_public_key64 key64;
+#endif
+};
 
+/* Check that a key's properties are usable and return its exponent */
+static int rsa_check_prop(const struct key_prop *prop, uint64_t *exponentp)
+{
 	if (!prop) {
 		debug("%s: Skipping invalid prop", __func__);
 		return -EBADF;
 	}
-	key.n0inv = prop->n0inv;
-	key.len = prop->num_bits;
-
-	if (!prop->public_exponent)
-		key.exponent = RSA_DEFAULT_PUBEXP;
-	else
-		key.exponent =
-			fdt64_to_cpu(*((uint64_t *)(prop->public_exponent)));
-
-	if (!key.len || !prop->modulus || !prop->rr) {
+	if (!prop->num_bits || !prop->modulus || !prop->rr) {
 		debug("%s: Missing RSA key info", __func__);
 		return -EFAULT;
 	}
 
 	/* Sanity check for stack size */
-	if (key.len > RSA_MAX_KEY_BITS || key.len < RSA_MIN_KEY_BITS) {
-		debug("RSA key bits %u outside allowed range %d..%d\n",
-		      key.len, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
+	if (prop->num_bits > RSA_MAX_KEY_BITS ||
+	    prop->num_bits < RSA_MIN_KEY_BITS) {
+		debug("RSA key bits %d outside allowed range %d..%d\n",
+		      prop->num_bits, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
 		return -EFAULT;
 	}
-	key.len /= sizeof(uint32_t) * 8;
-	uint32_t key1[key.len], key2[key.len];
-
-	key.modulus = key1;
-	key.rr = key2;
-	rsa_convert_big_endian(key.modulus, (uint32_t *)prop->modulus, key.len);
-	rsa_convert_big_endian(key.rr, (uint32_t *)prop->rr, key.len);
-	if (!key.modulus || !key.rr) {
-		debug("%s: Out of memory", __func__);
-		return -ENOMEM;
+	if (!prop->public_exponent)
+		*exponentp = RSA_DEFAULT_PUBEXP;
+	else
+		*exponentp =
+			fdt64_to_cpu(*((uint64_t *)(prop->public_exponent)));
+
+	return 0;
+}
+
+/**
+ * rsa_decode_prop() - Convert a key's modulus and R^2 to little-endian words
+ *
+ * @prop:	Key to convert, already checked by rsa_check_prop()
+ * @exponent:	Public exponent
+ * @dk:		Returns the converted key
+ * @words:	Space for the modulus and R^2, prop->num_bits / 4 bytes
+ */
+static void rsa_decode_prop(const struct key_prop *prop, uint64_t exponent,
+			    struct rsa_decoded_key *dk, uint64_t *words)
+{
+	uint len = prop->num_bits / 32;
+
+#ifdef RSA_MONT64
+	/* All supported key sizes are a multiple of 64 bits */
+	if (!(prop->num_bits % 64)) {
+		struct rsa_public_key64 *key64 = &dk->key64;
+
+		dk->mont64 = true;
+		key64->len = len / 2;
+		key64->exponent = exponent;
+		key64->modulus = words;
+		key64->rr = words + key64->len;
+		rsa_convert_big_endian64(key64->modulus,
+					 (uint32_t *)prop->modulus, key64->len);
+		rsa_convert_big_endian64(key64->rr, (uint32_t *)prop->rr,
+					 key64->len);
+		key64->n0inv = rsa_n0inv64(key64->modulus[0]);
+
+		return;
 	}
+#endif
+	dk->mont64 = false;
+	dk->key.len = len;
+	dk->key.n0inv = prop->n0inv;
+	dk->key.exponent = exponent;
+	dk->key.modulus = (uint32_t *)words;
+	dk->key.rr = dk->key.modulus + len;
+	rsa_convert_big_endian(dk->key.modulus, (uint32_t *)prop->modulus, len);
+	rsa_convert_big_endian(dk->key.rr, (uint32_t *)prop->rr, len);
+}
+
+int rsa_key_decode(const struct key_prop *prop, void **decodedp)
+{
+	struct rsa_decoded_key *dk;
+	uint64_t exponent;
+	int ret;
 
+	ret = rsa_check_prop(prop, &exponent);
+	if (ret)
+		return ret;
+	dk = malloc(sizeof(*dk) + prop->num_bits / 4);
+	if (!dk)
+		return -ENOMEM;
+	rsa_decode_prop(prop, exponent, dk, (uint64_t *)(dk + 1));
+	*decodedp = dk;
+
+	return 0;
+}
+
+int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
+		struct key_prop *prop, uint8_t *out)
+{
+	const struct rsa_decoded_key *dk;
+	struct rsa_decoded_key tmp;
+	uint64_t exponent;
+	int ret;
+
+	ret = rsa_check_prop(prop, &exponent);
+	if (ret)
+		return ret;
 	uint32_t buf[sig_len / sizeof(uint32_t)];
+	uint64_t words[prop->num_bits / 32];
 
-	memcpy(buf, sig, sig_len);
+	/* Use the key as converted by rsa_key_decode(), if available */
+	dk = prop->decoded;
+	if (!dk) {
+		rsa_decode_prop(prop, exponent, &tmp, words);
+		dk = &tmp;
+	}
 
-	ret = pow_mod(&key, buf);
+	memcpy(buf, sig, sig_len);
+#ifdef RSA_MONT64
+	if (dk->mont64)
+		ret = pow_mod64(&dk->key64, buf);
+	else
+#endif
+		ret = pow_mod(&dk->key, buf);
 	if (ret)
 		return ret;
 
@@ -13,6 +13,7 @@
 #include <asm/types.h>
 #include <asm/unaligned.h>
 #include <dm.h>
+#include <malloc.h>
 #else
 #include "fdt_host.h"
 #include "mkimage.h"
@@ -24,6 +25,135 @@
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+#if !defined(USE_HOSTCC) && !defined(CONFIG_SPL_BUILD)
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * Verified boot checks several signatures against the same few keys, so
+ * remember recently used key nodes with their modulus and R^2 already
+ * converted by rsa_key_decode(), rather than converting them each time. The
+ * cache is only used for keys in the control FDT after relocation, when BSS
+ * and malloc() are available.
+ *
+ * Each entry keeps a copy of the key's properties. The node is read again
+ * for every check, and the entry only used if they are unchanged, so that
+ * a key replaced in the FDT, even in place, is never used by mistake.
+ */
+#define RSA_KEY_CACHE_SIZE	4
+
+struct rsa_key_cache {
+	const void *blob;
+	int node;
+	struct key_prop prop;
+	uint8_t *copy;
+};
+
+static struct rsa_key_cache rsa_key_cache[RSA_KEY_CACHE_SIZE];
+static int rsa_key_cache_next;
+
+static void rsa_key_cache_drop(struct rsa_key_cache *entry)
+{
+	free((void *)entry->prop.decoded);
+	free(entry->copy);
+	memset(entry, '\0', sizeof(*entry));
+}
+
+/* Check whether a cached key has the same properties as @prop */
+static bool rsa_key_cache_same(const struct key_prop *cached,
+			       const struct key_prop *prop)
+{
+	int len = prop->num_bits / 8;
+
+	if (cached->num_bits != prop->num_bits ||
+	    cached->n0inv != prop->n0inv || !prop->rr ||
+	    !cached->public_exponent != !prop->public_exponent)
+		return false;
+	if (prop->public_exponent &&
+	    memcmp(cached->public_exponent, prop->public_exponent,
+		   sizeof(uint64_t)))
+		return false;
+
+	return !memcmp(cached->modulus, prop->modulus, len) &&
+		!memcmp(cached->rr, prop->rr, len);
+}
+
+static struct key_prop *rsa_key_cache_find(const void *blob, int node,
+					   const struct key_prop *prop)
+{
+	struct rsa_key_cache *entry;
+	int i;
+
+	if (!(gd->flags & GD_FLG_RELOC) || blob != gd->fdt_blob)
+		return NULL;
+	for (i = 0; i < RSA_KEY_CACHE_SIZE; i++) {
+		entry = &rsa_key_cache[i];
+		if (!entry->blob)
+			continue;
+		if (entry->blob != blob) {
+			rsa_key_cache_drop(entry);
+			continue;
+		}
+		if (entry->node != node)
+			continue;
+		if (rsa_key_cache_same(&entry->prop, prop))
+			return &entry->prop;
+		rsa_key_cache_drop(entry);
+	}
+
+	return NULL;
+}
+
+static struct key_prop *rsa_key_cache_add(const void *blob, int node,
+					   const struct key_prop *prop)
+{
+	struct rsa_key_cache *entry;
+	int len = prop->num_bits / 8;
+	void *decoded;
+	uint8_t *copy;
+
+	if (!(gd->flags & GD_FLG_RELOC) || blob != gd->fdt_blob)
+		return NULL;
+	if (rsa_key_decode(prop, &decoded))
+		return NULL;
+	copy = malloc(len * 2 + sizeof(uint64_t));
+	if (!copy) {
+		free(decoded);
+		return NULL;
+	}
+	entry = &rsa_key_cache[rsa_key_cache_next];
+	rsa_key_cache_next = (rsa_key_cache_next + 1) % RSA_KEY_CACHE_SIZE;
+	rsa_key_cache_drop(entry);
+	entry->blob = blob;
+	entry->node = node;
+	entry->copy = copy;
+	entry->prop = *prop;
+	entry->prop.decoded = decoded;
+	memcpy(copy, prop->modulus, len);
+	entry->prop.modulus = copy;
+	memcpy(copy + len, prop->rr, len);
+	entry->prop.rr = copy + len;
+	if (prop->public_exponent) {
+		memcpy(copy + len * 2, prop->public_exponent,
+		       sizeof(uint64_t));
+		entry->prop.public_exponent = copy + len * 2;
+	}
+
+	return &entry->prop;
+}
+#else
+static inline struct key_prop *rsa_key_cache_find(const void *blob, int node,
+						  const struct key_prop *prop)
+{
+	return NULL;
+}
+
+static inline struct key_prop *rsa_key_cache_add(const void *blob, int node,
+						  const struct key_prop *prop)
+{
+	return NULL;
+}
+#endif
+
 /**
  * rsa_verify_key() - Verify a signature against some data using RSA Key
  *
@@ -121,6 +251,7 @@ static int rsa_verify_with_keynode(struct image_sign_info *info,
 				   uint sig_len, int node)
 {
 	const void *blob = info->fdt_blob;
+	struct key_prop *cached;
 	struct key_prop prop;
 	int length;
 	int ret = 0;
@@ -144,12 +275,17 @@ static int rsa_verify_with_keynode(struct image_sign_info *info,
 
 	prop.rr = fdt_getprop(blob, node, "rsa,r-squared", NULL);
 
+	prop.decoded = NULL;
+
 	if (!prop.num_bits || !prop.modulus) {
 		debug("%s: Missing RSA key info", __func__);
 		return -EFAULT;
 	}
-
-	ret = rsa_verify_key(&prop, sig, sig_len, hash, info->algo->checksum);
+	cached = rsa_key_cache_find(blob, node, &prop);
+	if (!cached)
+		cached = rsa_key_cache_add(blob, node, &prop);
+	ret = rsa_verify_key(cached ? cached : &prop, sig, sig_len, hash,
+			     info->algo->checksum);
 
 	return ret;
 }
@@ -207,9 +343,9 @@ int rsa_verify(struct image_sign_info *info,
 		return ret;
 
 	/* No luck, so try each of the keys in turn */
-	for (ndepth = 0, noffset = fdt_next_node(info->fit, sig_node, &ndepth);
+	for (ndepth = 0, noffset = fdt_next_node(blob, sig_node, &ndepth);
 			(noffset >= 0) && (ndepth > 0);
-			noffset = fdt_next_node(info->fit, noffset, &ndepth)) {
+			noffset = fdt_next_node(blob, noffset, &ndepth)) {
 		if (ndepth == 1 && noffset != node) {
 			ret = rsa_verify_with_keynode(info, hash, sig, sig_len,
 						      noffset);
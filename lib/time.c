@@ -9,6 +9,7 @@
 #include <dm.h>
 #include <errno.h>
 #include <timer.h>
+#include <uthread.h>
 #include <watchdog.h>
 #include <div64.h>
 #include <asm/io.h>
@@ -147,6 +148,12 @@ void udelay(unsigned long usec)
 {
 	ulong kv;
 
+	/* Let other threads run while this one waits */
+	if (uthread_self()) {
+		uthread_udelay(usec);
+		return;
+	}
+
 	do {
 		WATCHDOG_RESET();
 		kv = usec > CONFIG_WD_PERIOD ? CONFIG_WD_PERIOD : usec;
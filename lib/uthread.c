@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Cooperative threads, which take turns on the boot CPU
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <uthread.h>
+#include <watchdog.h>
+#include <linux/list.h>
+
+/**
+ * struct uthread - a cooperative thread
+ *
+ * @node:	Entry in the list of threads, in order of creation
+ * @fn:		Function to run
+ * @arg:	Argument to pass to @fn
+ * @name:	Name of thread, for debugging
+ * @ctx:	Context of the thread, from arch_uthread_create()
+ * @stack:	Stack for the thread
+ * @ret:	Value returned by @fn
+ * @done:	true once @fn has returned
+ * @out:	Console output held back until earlier threads have finished
+ * @out_len:	Number of bytes in @out, excluding the terminator
+ * @out_size:	Size of @out in bytes
+ */
+struct uthread {
+	struct list_head node;
+	uthread_fn fn;
+	void *arg;
+	const char *name;
+	void *ctx;
+	void *stack;
+	int ret;
+	bool done;
+	char *out;
+	int out_len;
+	int out_size;
+};
+
+/**
+ * struct uthread_info - scheduler state
+ *
+ * @threads:	List of threads which have not yet been cleaned up
+ * @current:	Thread currently running, or NULL for the main thread
+ * @main_ctx:	Saved context of the main thread while a thread is running
+ * @ret:	First error returned by a thread, in order of creation
+ */
+static struct uthread_info {
+	struct list_head threads;
+	struct uthread *current;
+	void *main_ctx;
+	int ret;
+} uti = {
+	.threads = LIST_HEAD_INIT(uti.threads),
+};
+
+static void uthread_entry(void)
+{
+	struct uthread *ut = uti.current;
+
+	ut->ret = ut->fn(ut->arg);
+	ut->done = true;
+	debug("%s: thread '%s' returned %d\n", __func__, ut->name, ut->ret);
+	arch_uthread_switch(ut->ctx, uti.main_ctx);
+
+	/* We are never switched back to */
+	hang();
+}
+
+int uthread_create(uthread_fn fn, void *arg, const char *name)
+{
+	struct uthread *ut;
+
+	if (uti.current)
+		return -EPERM;
+	if (!uti.main_ctx) {
+		uti.main_ctx = arch_uthread_create(NULL, NULL, 0);
+		if (!uti.main_ctx)
+			return -ENOMEM;
+	}
+	ut = calloc(1, sizeof(*ut));
+	if (!ut)
+		return -ENOMEM;
+	ut->stack = memalign(ARCH_DMA_MINALIGN, CONFIG_UTHREAD_STACK_SIZE);
+	if (ut->stack)
+		ut->ctx = arch_uthread_create(uthread_entry, ut->stack,
+					      CONFIG_UTHREAD_STACK_SIZE);
+	if (!ut->ctx) {
+		free(ut->stack);
+		free(ut);
+		return -ENOMEM;
+	}
+	ut->fn = fn;
+	ut->arg = arg;
+	ut->name = name;
+	list_add_tail(&ut->node, &uti.threads);
+
+	return 0;
+}
+
+/* Is this the oldest thread which has not been cleaned up? */
+static bool uthread_is_first(struct uthread *ut)
+{
+	return ut == list_first_entry(&uti.threads, struct uthread, node);
+}
+
+/*
+ * Clean up threads which have finished, in order of creation, printing
+ * any output held back for each new first thread
+ */
+static void uthread_reap(void)
+{
+	struct uthread *ut;
+
+	while (!list_empty(&uti.threads)) {
+		ut = list_first_entry(&uti.threads, struct uthread, node);
+		if (ut->out_len) {
+			ut->out_len = 0;
+			puts(ut->out);
+		}
+		if (!ut->done)
+			break;
+		if (ut->ret && !uti.ret)
+			uti.ret = ut->ret;
+		list_del(&ut->node);
+		arch_uthread_free(ut->ctx);
+		free(ut->stack);
+		free(ut->out);
+		free(ut);
+	}
+}
+
+bool uthread_step(void)
+{
+	struct uthread *ut;
+
+	if (uti.current)
+		return false;
+	list_for_each_entry(ut, &uti.threads, node) {
+		if (ut->done)
+			continue;
+		uti.current = ut;
+		arch_uthread_switch(uti.main_ctx, ut->ctx);
+		uti.current = NULL;
+	}
+	uthread_reap();
+
+	return !list_empty(&uti.threads);
+}
+
+int uthread_join_all(void)
+{
+	int ret;
+
+	if (uti.current)
+		return -EPERM;
+	while (uthread_step())
+		WATCHDOG_RESET();
+	ret = uti.ret;
+	uti.ret = 0;
+
+	return ret;
+}
+
+void uthread_schedule(void)
+{
+	struct uthread *ut = uti.current;
+
+	if (ut)
+		arch_uthread_switch(ut->ctx, uti.main_ctx);
+}
+
+struct uthread *uthread_self(void)
+{
+	return uti.current;
+}
+
+void uthread_udelay(unsigned long usec)
+{
+	ulong start = timer_get_us();
+
+	do {
+		uthread_schedule();
+	} while (timer_get_us() - start < usec);
+}
+
+bool uthread_hold_output(const char *s, int len)
+{
+	struct uthread *ut = uti.current;
+	char *out;
+	int size;
+
+	if (!ut || uthread_is_first(ut))
+		return false;
+	if (ut->out_len + len + 1 > ut->out_size) {
+		size = max(ut->out_size * 2, ut->out_len + len + 1);
+		out = realloc(ut->out, size);
+		if (!out)
+			return false;
+		ut->out = out;
+		ut->out_size = size;
+	}
+	memcpy(ut->out + ut->out_len, s, len);
+	ut->out_len += len;
+	ut->out[ut->out_len] = '\0';
+
+	return true;
+}
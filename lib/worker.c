@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Parallel jobs on the secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <worker.h>
+#include <asm/io.h>
+#include <linux/compiler.h>
+
+/**
+ * struct worker_cpu - mailbox for a secondary CPU
+ *
+ * Each field has a single writer, so no atomic operations are needed. Each
+ * mailbox has its own cache line, so that CPUs do not disturb each other
+ * while waiting.
+ *
+ * @go:		Incremented by the boot CPU to start a job
+ * @done:	Set to @go by the secondary CPU when its parts are done
+ */
+struct worker_cpu {
+	ulong go;
+	ulong done;
+} __aligned(ARCH_DMA_MINALIGN);
+
+/**
+ * struct worker_info - worker pool state
+ *
+ * @count:	Number of CPUs running jobs, including the boot CPU; 0 if the
+ *		secondary CPUs have not been started
+ * @busy:	true while a job is running
+ * @stop:	true to tell the secondary CPUs to return
+ * @fn:		Function for the current job
+ * @arg:	Argument for @fn
+ * @parts:	Number of parts in the current job
+ * @cpu:	Mailbox for each CPU; the boot CPU's is not used
+ */
+static struct worker_info {
+	int count;
+	bool busy;
+	bool stop;
+	worker_fn fn;
+	void *arg;
+	int parts;
+	struct worker_cpu cpu[CONFIG_WORKER_MAX_CPUS];
+} wi;
+
+/* Do the parts of the current job which belong to a CPU */
+static void worker_do_parts(int cpu)
+{
+	int part;
+
+	for (part = cpu; part < wi.parts; part += wi.count)
+		wi.fn(wi.arg, part);
+}
+
+void worker_main(int cpu)
+{
+	struct worker_cpu *wc = &wi.cpu[cpu];
+	ulong go;
+	ulong seq;
+
+	/* A job may already have been started, so do not go by @go here */
+	seq = READ_ONCE(wc->done);
+
+	for (;;) {
+		while ((go = READ_ONCE(wc->go)) == seq && !READ_ONCE(wi.stop))
+			arch_worker_wait();
+		if (go == seq)
+			break;
+		seq = go;
+		mb();	/* see the job set up by worker_run() */
+		worker_do_parts(cpu);
+		mb();	/* finish all writes before saying we are done */
+		WRITE_ONCE(wc->done, seq);
+		arch_worker_kick();
+	}
+}
+
+int worker_start(void)
+{
+	int ret;
+
+	if (wi.count)
+		return wi.count;
+	wi.stop = false;
+	mb();	/* new CPUs must not see the old stop request */
+	ret = arch_worker_start(CONFIG_WORKER_MAX_CPUS - 1);
+	if (ret < 0) {
+		debug("%s: Cannot start secondary CPUs (err=%d)\n", __func__,
+		      ret);
+		ret = 0;
+	}
+	wi.count = ret + 1;
+
+	return wi.count;
+}
+
+void worker_stop(void)
+{
+	if (!wi.count)
+		return;
+	WRITE_ONCE(wi.stop, true);
+	mb();	/* make the request visible before waking the CPUs */
+	arch_worker_kick();
+	if (wi.count > 1)
+		arch_worker_stop();
+	wi.count = 0;
+}
+
+int worker_count(void)
+{
+	return wi.count ? wi.count : 1;
+}
+
+void worker_run(worker_fn fn, void *arg, int count)
+{
+	struct worker_cpu *wc;
+	int cpu, part;
+
+	if (!wi.busy && count > 1)
+		worker_start();
+	if (wi.busy || wi.count < 2 || count < 2) {
+		for (part = 0; part < count; part++)
+			fn(arg, part);
+		return;
+	}
+
+	wi.busy = true;
+	wi.fn = fn;
+	wi.arg = arg;
+	wi.parts = count;
+	mb();	/* set up the job before starting any CPU on it */
+	for (cpu = 1; cpu < wi.count; cpu++)
+		WRITE_ONCE(wi.cpu[cpu].go, wi.cpu[cpu].go + 1);
+	mb();	/* make the mailboxes visible before waking the CPUs */
+	arch_worker_kick();
+
+	worker_do_parts(0);
+	for (cpu = 1; cpu < wi.count; cpu++) {
+		wc = &wi.cpu[cpu];
+		while (READ_ONCE(wc->done) != wc->go)
+			arch_worker_wait();
+	}
+	mb();	/* see everything written by the other CPUs */
+	wi.busy = false;
+}
+
+/**
+ * struct worker_mem - a memory operation split into parts
+ *
+ * @dest:	Destination
+ * @src:	Source, if @fill is false
+ * @c:		Value to fill with, if @fill is true
+ * @fill:	true to fill memory, false to copy it
+ * @len:	Total number of bytes
+ * @chunk:	Number of bytes in each part, except perhaps the last
+ */
+struct worker_mem {
+	char *dest;
+	const char *src;
+	int c;
+	bool fill;
+	size_t len;
+	size_t chunk;
+};
+
+static void worker_mem_part(void *arg, int part)
+{
+	struct worker_mem *wm = arg;
+	size_t offset = part * wm->chunk;
+	size_t len = min(wm->chunk, wm->len - offset);
+
+	if (wm->fill)
+		memset(wm->dest + offset, wm->c, len);
+	else
+		memcpy(wm->dest + offset, wm->src + offset, len);
+}
+
+/* Split a memory operation into one part per CPU, if it is large enough */
+static void worker_mem(struct worker_mem *wm)
+{
+	int count = 1;
+
+	if (wm->len >= CONFIG_WORKER_MIN_SIZE)
+		count = worker_start();
+	wm->chunk = roundup(DIV_ROUND_UP(wm->len, count), ARCH_DMA_MINALIGN);
+	count = DIV_ROUND_UP(wm->len, wm->chunk);
+	worker_run(worker_mem_part, wm, count);
+}
+
+void worker_memcpy(void *dest, const void *src, size_t len)
+{
+	struct worker_mem wm = { .dest = dest, .src = src, .len = len };
+
+	if (!len)
+		return;
+	worker_mem(&wm);
+}
+
+void worker_memset(void *s, int c, size_t len)
+{
+	struct worker_mem wm = {
+		.dest = s, .c = c, .fill = true, .len = len
+	};
+
+	if (!len)
+		return;
+	worker_mem(&wm);
+}
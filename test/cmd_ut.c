@@ -19,6 +19,15 @@ static cmd_tbl_t cmd_ut_sub[] = {
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_UT_IMAGE
+	U_BOOT_CMD_MKENT(image, CONFIG_SYS_MAXARGS, 1, do_ut_image, "", ""),
+#endif
+#ifdef CONFIG_UT_LIB
+	U_BOOT_CMD_MKENT(lib, CONFIG_SYS_MAXARGS, 1, do_ut_lib, "", ""),
+#endif
+#ifdef CONFIG_UT_NAND
+	U_BOOT_CMD_MKENT(nand, CONFIG_SYS_MAXARGS, 1, do_ut_nand, "", ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
@@ -71,6 +80,15 @@ static char ut_help_text[] =
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_UT_IMAGE
+	"ut image [test-name]\n"
+#endif
+#ifdef CONFIG_UT_LIB
+	"ut lib [test-name]\n"
+#endif
+#ifdef CONFIG_UT_NAND
+	"ut nand [test-name]\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
@@ -11,7 +11,9 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <malloc.h>
+#include <uthread.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/test.h>
@@ -796,3 +798,72 @@ static int dm_test_device_get_uclass_id(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_device_get_uclass_id, DM_TESTF_SCAN_PDATA);
+
+#ifdef CONFIG_UTHREAD
+static int dm_test_slow_probe_count;
+
+/* A probe method which gives way to other threads before it finishes */
+static int test_slow_probe(struct udevice *dev)
+{
+	int *priv = dev_get_priv(dev);
+
+	udelay(1000);
+	*priv = 1;
+	dm_test_slow_probe_count++;
+
+	return 0;
+}
+
+U_BOOT_DRIVER(test_slow_drv) = {
+	.name	= "test_slow_drv",
+	.id	= UCLASS_TEST,
+	.probe	= test_slow_probe,
+	.priv_auto_alloc_size = sizeof(int),
+};
+
+static int dm_test_probe_thread(void *arg)
+{
+	struct udevice *dev = arg;
+	int *priv;
+	int ret;
+
+	ret = device_probe(dev);
+	if (ret)
+		return ret;
+	priv = dev_get_priv(dev);
+
+	return *priv ? 0 : -EBUSY;
+}
+
+/* Test that a device being probed by one thread is not used by another */
+static int dm_test_device_probe_uthread(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev;
+
+	dms->skip_post_probe = 1;
+	dm_test_slow_probe_count = 0;
+	ut_assertok(device_bind_driver(dms->root, "test_slow_drv", "slow",
+				       &dev));
+
+	/* The second thread must wait for the first to finish probing */
+	ut_assertok(uthread_create(dm_test_probe_thread, dev, "probe1"));
+	ut_assertok(uthread_create(dm_test_probe_thread, dev, "probe2"));
+	ut_assertok(uthread_join_all());
+	ut_asserteq(1, dm_test_slow_probe_count);
+
+	/* So must the main thread, running the thread until it is done */
+	ut_assertok(device_remove(dev));
+	ut_assertok(uthread_create(dm_test_probe_thread, dev, "probe"));
+	ut_assert(uthread_step());
+	ut_assert(dev->flags & DM_FLAG_PROBING);
+	ut_assertok(device_probe(dev));
+	ut_asserteq(1, *(int *)dev_get_priv(dev));
+	ut_asserteq(2, dm_test_slow_probe_count);
+	ut_assertok(uthread_join_all());
+	ut_asserteq(2, dm_test_slow_probe_count);
+
+	return 0;
+}
+DM_TEST(dm_test_device_probe_uthread, 0);
+#endif
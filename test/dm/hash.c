@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <hash.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include <u-boot/hash-engine.h>
+#include <u-boot/sha256.h>
+
+/* SHA256 of "abc", from FIPS 180-2 */
+static const uint8_t sha256_abc[SHA256_SUM_LEN] = {
+	0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+	0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+	0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+};
+
+/* Basic test of the hash uclass */
+static int dm_test_hash_base(struct unit_test_state *uts)
+{
+	uint8_t digest[SHA256_SUM_LEN];
+	struct udevice *dev;
+
+	ut_assertok(hash_engine_get("sha256", &dev));
+	ut_asserteq_str("hash_sw", dev->name);
+	ut_asserteq(-ENODEV, hash_engine_get("md4", &dev));
+
+	ut_assertok(hash_engine_digest(dev, "sha256", "abc", 3, digest,
+				       sizeof(digest), 1));
+	ut_assertok(memcmp(sha256_abc, digest, sizeof(digest)));
+	ut_asserteq(-ENOSPC, hash_engine_digest(dev, "sha256", "abc", 3,
+						digest, 4, 0));
+
+	return 0;
+}
+DM_TEST(dm_test_hash_base, DM_TESTF_SCAN_PDATA);
+
+/* Test the asynchronous interface */
+static int dm_test_hash_async(struct unit_test_state *uts)
+{
+	uint8_t digest[SHA256_SUM_LEN];
+	struct udevice *dev;
+	void *ctx;
+
+	ut_assertok(hash_engine_get("sha256", &dev));
+	ut_assertok(hash_engine_init(dev, "sha256", &ctx));
+	ut_assertok(hash_engine_update_async(dev, ctx, "a", 1));
+	ut_asserteq(-EBUSY, hash_engine_update_async(dev, ctx, "b", 1));
+	ut_assertok(hash_engine_wait(dev, ctx, 0));
+	ut_assertok(hash_engine_update_async(dev, ctx, "bc", 2));
+	ut_assertok(hash_engine_finish(dev, ctx, digest, sizeof(digest)));
+	ut_assertok(memcmp(sha256_abc, digest, sizeof(digest)));
+
+	return 0;
+}
+DM_TEST(dm_test_hash_async, DM_TESTF_SCAN_PDATA);
+
+/* Test that common/hash.c routes algorithms through the selected engine */
+static int dm_test_hash_select(struct unit_test_state *uts)
+{
+	uint8_t digest[SHA256_SUM_LEN];
+	struct hash_algo *algo;
+	struct hash_algo *builtin;
+	int size = sizeof(digest);
+
+	setenv("hash_engine", "none");
+	ut_assertok(hash_lookup_algo("sha256", &builtin));
+	ut_asserteq_ptr(sha256_csum_wd, builtin->hash_func_ws);
+
+	setenv("hash_engine", "hash_sw");
+	ut_assertok(hash_lookup_algo("sha256", &algo));
+	ut_assert(algo != builtin);
+	ut_assertok(hash_block("sha256", "abc", 3, digest, &size));
+	ut_asserteq(SHA256_SUM_LEN, size);
+	ut_assertok(memcmp(sha256_abc, digest, sizeof(digest)));
+
+	setenv("hash_engine", "missing");
+	ut_assertok(hash_lookup_algo("sha256", &algo));
+	ut_asserteq_ptr(builtin, algo);
+	setenv("hash_engine", NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_hash_select, DM_TESTF_SCAN_PDATA);
+
+/* Test that the engine's crc32 matches the built-in algorithm byte-for-byte */
+static int dm_test_hash_crc32(struct unit_test_state *uts)
+{
+	/* crc32 of "aaa" is 0xf007732d, stored big-endian */
+	static const uint8_t crc32_aaa[4] = { 0xf0, 0x07, 0x73, 0x2d };
+	uint8_t builtin[4], digest[4];
+	int size;
+
+	setenv("hash_engine", "none");
+	size = sizeof(builtin);
+	ut_assertok(hash_block("crc32", "aaa", 3, builtin, &size));
+	ut_assertok(memcmp(crc32_aaa, builtin, sizeof(builtin)));
+
+	setenv("hash_engine", "hash_sw");
+	size = sizeof(digest);
+	ut_assertok(hash_block("crc32", "aaa", 3, digest, &size));
+	ut_asserteq(4, size);
+	ut_assertok(memcmp(builtin, digest, sizeof(digest)));
+	setenv("hash_engine", NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_hash_crc32, DM_TESTF_SCAN_PDATA);
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for ofnode, which are run with both the live tree and the flat tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <fdtdec.h>
+#include <libfdt.h>
+#include <dm/ofnode.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of times to walk the tree in dm_test_ofnode_perf() */
+#define OFNODE_PERF_LOOPS	20
+
+/* Check that every node matches the flat tree */
+static int dm_test_ofnode_tree(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	int offset, depth = 0;
+	ofnode node, other;
+
+	ut_asserteq(0, ofnode_to_offset(ofnode_root()));
+	ut_assert(!ofnode_valid(ofnode_get_parent(ofnode_root())));
+	ut_assert(!ofnode_valid(ofnode_null()));
+
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		node = offset_to_ofnode(offset);
+		ut_assert(ofnode_valid(node));
+		ut_asserteq(offset, ofnode_to_offset(node));
+		ut_asserteq_str(fdt_get_name(blob, offset, NULL),
+				ofnode_get_name(node));
+		ut_asserteq(fdt_get_phandle(blob, offset),
+			    ofnode_get_phandle(node));
+		ut_asserteq(fdtdec_get_is_enabled(blob, offset),
+			    ofnode_is_available(node));
+
+		if (offset) {
+			other = ofnode_get_parent(node);
+			ut_asserteq(fdt_parent_offset(blob, offset),
+				    ofnode_to_offset(other));
+		}
+
+		other = ofnode_first_subnode(node);
+		ut_asserteq(fdt_first_subnode(blob, offset) >= 0,
+			    ofnode_valid(other));
+		if (ofnode_valid(other)) {
+			ut_asserteq(fdt_first_subnode(blob, offset),
+				    ofnode_to_offset(other));
+		}
+
+		if (offset) {
+			other = ofnode_next_subnode(node);
+			ut_asserteq(fdt_next_subnode(blob, offset) >= 0,
+				    ofnode_valid(other));
+			if (ofnode_valid(other)) {
+				ut_asserteq(fdt_next_subnode(blob, offset),
+					    ofnode_to_offset(other));
+			}
+		}
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_tree, 0);
+
+/* Check reading properties and finding nodes */
+static int dm_test_ofnode_read(struct unit_test_state *uts)
+{
+	ofnode node, bus;
+	u32 cells[3];
+	u32 phandle;
+	u32 val;
+
+	node = ofnode_path("/a-test");
+	ut_assert(ofnode_valid(node));
+	ut_asserteq_str("a-test", ofnode_get_name(node));
+	ut_asserteq_str("denx,u-boot-fdt-test",
+			ofnode_read_string(node, "compatible"));
+	ut_assert(ofnode_device_is_compatible(node, "denx,u-boot-fdt-test"));
+	ut_assert(!ofnode_device_is_compatible(node, "not,compatible"));
+	ut_assert(ofnode_read_bool(node, "u-boot,dm-pre-reloc"));
+	ut_assert(!ofnode_read_bool(node, "missing"));
+	ut_assertok(ofnode_read_u32_array(node, "reg", cells, 2));
+	ut_asserteq(0, cells[0]);
+	ut_asserteq(1, cells[1]);
+	ut_asserteq(-EOVERFLOW, ofnode_read_u32_array(node, "reg", cells, 3));
+	ut_asserteq(-EINVAL, ofnode_read_u32(node, "missing", &val));
+	ut_asserteq(123, ofnode_read_u32_default(node, "missing", 123));
+	ut_assert(!ofnode_read_string(node, "missing"));
+
+	/* Paths, aliases and unit addresses */
+	bus = ofnode_path("/some-bus");
+	ut_assert(ofnode_valid(bus));
+	ut_assert(ofnode_equal(bus, ofnode_path("testbus3")));
+	node = ofnode_path("/some-bus/c-test@5");
+	ut_assert(ofnode_valid(node));
+	ut_asserteq(5, ofnode_read_u32_default(node, "ping-expect", 0));
+	ut_assert(ofnode_equal(node, ofnode_path("testfdt5")));
+	ut_assert(ofnode_equal(node, ofnode_path("testbus3/c-test@5")));
+	ut_assert(ofnode_equal(node, ofnode_path("/some-bus/c-test")));
+	ut_assert(ofnode_equal(node, ofnode_find_subnode(bus, "c-test@5")));
+	ut_assert(ofnode_equal(bus, ofnode_get_parent(node)));
+	node = ofnode_find_subnode(bus, "c-test@1");
+	ut_asserteq(7, ofnode_read_u32_default(node, "ping-expect", 0));
+	ut_assert(!ofnode_valid(ofnode_path("/some-bus/c-test@2")));
+	ut_assert(!ofnode_valid(ofnode_path("/missing")));
+	ut_assert(!ofnode_valid(ofnode_path("missing-alias")));
+	ut_assert(!ofnode_valid(ofnode_find_subnode(bus, "missing")));
+
+	/* Phandles */
+	node = ofnode_path("/clk-fixed");
+	phandle = ofnode_get_phandle(node);
+	ut_assert(phandle);
+	ut_assert(ofnode_equal(node, ofnode_get_by_phandle(phandle)));
+	ut_assert(!ofnode_valid(ofnode_get_by_phandle(0xfffffff)));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_read, 0);
+
+/* Check that devices are bound to the right node */
+static int dm_test_ofnode_dev(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+
+	ut_assertok(uclass_get_device(UCLASS_TEST_BUS, 0, &bus));
+	ut_assert(ofnode_equal(ofnode_path("/some-bus"), dev_ofnode(bus)));
+	ut_assertok(device_find_first_child(bus, &dev));
+	ut_assertnonnull(dev);
+	ut_assert(ofnode_equal(ofnode_first_subnode(dev_ofnode(bus)),
+			       dev_ofnode(dev)));
+	ut_asserteq(dev->of_offset, ofnode_to_offset(dev_ofnode(dev)));
+	ut_assert(ofnode_equal(dev_ofnode(bus),
+			       ofnode_get_parent(dev_ofnode(dev))));
+	ut_assert(ofnode_equal(ofnode_root(), dev_ofnode(dm_root())));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_dev, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Count the nodes below @parent, looking up the parent of each */
+static int ofnode_perf_walk(ofnode parent, int *depthp)
+{
+	ofnode node, up;
+	int count = 0;
+
+	ofnode_for_each_subnode(node, parent) {
+		if (!ofnode_read_prop(node, "compatible", NULL))
+			continue;
+		for (up = node; ofnode_valid(up); up = ofnode_get_parent(up))
+			(*depthp)++;
+		count += 1 + ofnode_perf_walk(node, depthp);
+	}
+
+	return count;
+}
+
+/*
+ * Time a walk of the tree which reads a property from each node and finds
+ * its parents. The time taken with each tree is shown if sandbox is run
+ * with -v.
+ */
+static int dm_test_ofnode_perf(struct unit_test_state *uts)
+{
+	int count, first_count = 0, depth, first_depth = 0;
+	ulong start;
+	int i;
+
+	start = get_timer(0);
+	for (i = 0; i < OFNODE_PERF_LOOPS; i++) {
+		depth = 0;
+		count = ofnode_perf_walk(ofnode_root(), &depth);
+		if (!i) {
+			first_count = count;
+			first_depth = depth;
+		}
+		ut_asserteq(first_count, count);
+		ut_asserteq(first_depth, depth);
+	}
+	ut_assert(count > 0);
+	printf("%s tree: %d walks of %d nodes in %lums\n",
+	       of_live_active() ? "Live" : "Flat", OFNODE_PERF_LOOPS, count,
+	       get_timer(start));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_perf, 0);
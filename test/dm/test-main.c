@@ -11,6 +11,7 @@
 #include <errno.h>
 #include <malloc.h>
 #include <asm/state.h>
+#include <dm/of.h>
 #include <dm/test.h>
 #include <dm/root.h>
 #include <dm/uclass-internal.h>
@@ -71,15 +72,58 @@ static int dm_test_destroy(struct unit_test_state *uts)
 	return 0;
 }
 
+/* Select the live tree (if it has been built) or the flat tree */
+static void dm_set_of_live(struct device_node *of_root)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE)
+	gd->of_root = of_root;
+#endif
+}
+
+static int dm_do_test(struct unit_test_state *uts, struct unit_test *test,
+		      bool of_live)
+{
+	struct sandbox_state *state = state_get_current();
+
+	printf("Test: %s%s\n", test->name, of_live ? " (live tree)" : "");
+	ut_assertok(dm_test_init(uts));
+
+	uts->start = mallinfo();
+	if (test->flags & DM_TESTF_SCAN_PDATA)
+		ut_assertok(dm_scan_platdata(false));
+	if (test->flags & DM_TESTF_PROBE_TEST)
+		ut_assertok(do_autoprobe(uts));
+	if (test->flags & DM_TESTF_SCAN_FDT)
+		ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
+
+	/*
+	 * Silence the console and rely on console reocrding to get
+	 * our output.
+	 */
+	console_record_reset();
+	if (!state->show_test_output)
+		gd->flags |= GD_FLG_SILENT;
+	test->func(uts);
+	gd->flags &= ~GD_FLG_SILENT;
+	state_set_skip_delays(false);
+
+	ut_assertok(dm_test_destroy(uts));
+
+	return 0;
+}
+
 static int dm_test_main(const char *test_name)
 {
 	struct unit_test *tests = ll_entry_start(struct unit_test, dm_test);
 	const int n_ents = ll_entry_count(struct unit_test, dm_test);
 	struct unit_test_state *uts = &global_dm_test_state;
-	struct sandbox_state *state = state_get_current();
+	struct device_node *of_root = gd_of_root();
 	uts->priv = &_global_priv_dm_test_state;
 	struct unit_test *test;
+	ulong live_time = 0, flat_time = 0;
+	ulong start;
 	int run_count;
+	int ret;
 
 	uts->fail_count = 0;
 
@@ -105,36 +149,33 @@ static int dm_test_main(const char *test_name)
 			name += 8;
 		if (test_name && strcmp(test_name, name))
 			continue;
-		printf("Test: %s\n", test->name);
 		run_count++;
-		ut_assertok(dm_test_init(uts));
-
-		uts->start = mallinfo();
-		if (test->flags & DM_TESTF_SCAN_PDATA)
-			ut_assertok(dm_scan_platdata(false));
-		if (test->flags & DM_TESTF_PROBE_TEST)
-			ut_assertok(do_autoprobe(uts));
-		if (test->flags & DM_TESTF_SCAN_FDT)
-			ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
 
 		/*
-		 * Silence the console and rely on console reocrding to get
-		 * our output.
+		 * Run each test with the live tree, if there is one, and
+		 * then with the flat tree, so that both are covered.
 		 */
-		console_record_reset();
-		if (!state->show_test_output)
-			gd->flags |= GD_FLG_SILENT;
-		test->func(uts);
-		gd->flags &= ~GD_FLG_SILENT;
-		state_set_skip_delays(false);
-
-		ut_assertok(dm_test_destroy(uts));
+		if (of_root) {
+			start = get_timer(0);
+			ut_assertok(dm_do_test(uts, test, true));
+			live_time += get_timer(start);
+		}
+		dm_set_of_live(NULL);
+		start = get_timer(0);
+		ret = dm_do_test(uts, test, false);
+		flat_time += get_timer(start);
+		dm_set_of_live(of_root);
+		ut_assertok(ret);
 	}
 
-	if (test_name && !run_count)
+	if (test_name && !run_count) {
 		printf("Test '%s' not found\n", test_name);
-	else
+	} else {
+		if (of_root)
+			printf("Time: live tree %lums, flat tree %lums\n",
+			       live_time, flat_time);
 		printf("Failures: %d\n", uts->fail_count);
+	}
 
 	gd->dm_root = NULL;
 	ut_assertok(dm_init());
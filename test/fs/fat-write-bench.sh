@@ -0,0 +1,106 @@
+#!/bin/bash
+
+# Copyright (c) 2026 agent <agent@local>
+#
+# SPDX-License-Identifier:	GPL-2.0+
+
+# This script times U-Boot's FAT write support on large, mostly empty FAT16
+# and FAT32 filesystems and checks what it wrote.
+#
+# While writing, the FAT is cached and each changed sector is written once,
+# at the end. Free clusters are tracked in a bitmap which is built from the
+# FAT as the allocator reaches it, starting where the FSINFO sector of a
+# FAT32 filesystem says. Files are given runs of clusters which are next to
+# each other and each run is written at once, so a large file is written
+# with few large writes.
+#
+# To execute the script, simply run it from the U-Boot source root directory:
+#
+#    cd u-boot
+#    ./test/fs/fat-write-bench.sh
+#
+# The script creates a sparse 512MiB FAT16 and a sparse 8GiB FAT32 filesystem
+# image and two files of random data, builds U-Boot sandbox and invokes it to
+# write both files to each image with the 'time' command, twice so that
+# replacing a file is timed too. The files are read back and compared by
+# U-Boot and each image is then checked with fsck.fat. The last line of the
+# output is either "PASS" or "FAILURE".
+#
+#    => time fatwrite host 0:0 1000000 small.cfg 200
+#    writing small.cfg
+#    512 bytes written
+#
+#    time: 0.001 seconds
+#    => time fatwrite host 0:0 1000000 big.bin 2000000
+#    writing big.bin
+#    33554432 bytes written
+#
+#    time: 0.023 seconds
+#
+# All temporary files used by this script are created in ./sandbox to avoid
+# polluting the source tree, as test/fs/fs-test.sh does.
+
+odir=sandbox
+fill=/dev/urandom
+small=${odir}/fat-bench-small.cfg
+big=${odir}/fat-bench-big.bin
+out=${odir}/fat-bench.out
+loadaddr=1000000
+readaddr=3000000
+
+for prereq in mkfs.fat fsck.fat truncate dd grep; do
+    if [ ! -x "`which $prereq`" ]; then
+        echo "Missing $prereq binary. Exiting!"
+        exit 1
+    fi
+done
+
+make O=${odir} -s sandbox_defconfig && make O=${odir} -s -j8
+
+dd if=${fill} of=${small} bs=512 count=1 >/dev/null 2>&1
+dd if=${fill} of=${big} bs=1M count=32 >/dev/null 2>&1
+
+result=PASS
+run() {
+    fat=$1
+    img=${odir}/fat${fat}-bench.img
+
+    rm -f ${img}
+    truncate -s $2 ${img}
+    mkfs.fat -F ${fat} -s $3 ${img} >/dev/null
+    if [ $? -ne 0 ]; then
+        echo Could not create FAT${fat} filesystem
+        exit $?
+    fi
+
+    ./${odir}/u-boot << EOF > ${out}
+host bind 0 ${img}
+sb load hostfs - ${loadaddr} ${small}
+time fatwrite host 0:0 ${loadaddr} small.cfg \$filesize
+time fatwrite host 0:0 ${loadaddr} small.cfg \$filesize
+fatload host 0:0 ${readaddr} small.cfg
+cmp.b ${loadaddr} ${readaddr} \$filesize
+sb load hostfs - ${loadaddr} ${big}
+time fatwrite host 0:0 ${loadaddr} big.bin \$filesize
+time fatwrite host 0:0 ${loadaddr} big.bin \$filesize
+fatload host 0:0 ${readaddr} big.bin
+cmp.b ${loadaddr} ${readaddr} \$filesize
+reset
+EOF
+    if [ $? -ne 0 ]; then
+        echo U-Boot exit status indicates an error
+        exit $?
+    fi
+    cat ${out}
+
+    if grep -q -e "!=" -e "Unable" -e "Error" ${out}; then
+        echo FAT${fat}: files could not be written or read back
+        result=FAILURE
+    fi
+    fsck.fat -n ${img} || result=FAILURE
+}
+
+run 16 512M 32
+run 32 8G 8
+rm -f ${out}
+echo ${result}
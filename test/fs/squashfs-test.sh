@@ -0,0 +1,133 @@
+#!/bin/bash
+
+# Copyright (c) 2026 agent <agent@local>
+#
+# SPDX-License-Identifier:	GPL-2.0+
+
+# This script tests U-Boot's SquashFS support and times how fast it reads
+# files with each compressor.
+#
+# Metadata blocks and fragment blocks are cached once decompressed, so
+# walking a directory or loading the small files which share a fragment
+# does not decompress the same block again. Data blocks are read from the
+# device in large runs and decompressed straight into the load buffer.
+#
+# To execute the script, simply run it from the U-Boot source root directory:
+#
+#    cd u-boot
+#    ./test/fs/squashfs-test.sh
+#
+# The script builds a small tree with a large random file, a compressible
+# file, a sparse file, many small files and some symbolic links, and creates
+# a SquashFS image of it with mksquashfs for each compressor U-Boot sandbox
+# supports. mksquashfs may not support all of them, in which case the image
+# is skipped. U-Boot sandbox lists each image, checks the size of a file,
+# times loading the files, as well as part of one, and compares them with
+# the originals loaded from the host. An image using xz, which U-Boot does
+# not support, must be rejected. The last line of the output is either
+# "PASS" or "FAILURE".
+#
+#    => time load host 0 1000000 /kernel
+#    8388608 bytes read in 24 ms (333.3 MiB/s)
+#
+#    time: 0.024 seconds
+#    => time run loaddtbs
+#
+#    time: 0.003 seconds
+#
+# All temporary files used by this script are created in ./sandbox to avoid
+# polluting the source tree, as test/fs/fs-test.sh does.
+
+odir=sandbox
+root=${odir}/sqfs-root
+out=${odir}/sqfs-test.out
+loadaddr=1000000
+readaddr=3000000
+dtbs="00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15"
+
+for prereq in mksquashfs base64 truncate stat dd grep; do
+    if [ ! -x "`which $prereq`" ]; then
+        echo "Missing $prereq binary. Exiting!"
+        exit 1
+    fi
+done
+
+make O=${odir} -s sandbox_defconfig && make O=${odir} -s -j8
+
+rm -rf ${root}
+mkdir -p ${root}/boot/dtbs ${root}/etc
+dd if=/dev/urandom of=${root}/boot/vmlinuz bs=1M count=8 >/dev/null 2>&1
+dd if=/dev/urandom bs=1M count=3 2>/dev/null | base64 > ${root}/boot/initrd
+for n in ${dtbs}; do
+    dd if=/dev/urandom bs=1k count=$((10#$n + 2)) 2>/dev/null | base64 > \
+        ${root}/boot/dtbs/board${n}.dtb
+done
+truncate -s 1M ${root}/sparse
+echo end >> ${root}/sparse
+ln -s boot/vmlinuz ${root}/kernel
+ln -s ../boot/dtbs ${root}/etc/dtbs
+
+loaddtbs="for n in ${dtbs}; do"
+loaddtbs="${loaddtbs} load host 0 ${loadaddr} /boot/dtbs/board\${n}.dtb; done"
+
+result=PASS
+run() {
+    comp=$1
+    img=${odir}/sqfs-${comp}.img
+
+    rm -f ${img}
+    mksquashfs ${root} ${img} -comp ${comp} -noappend -no-progress \
+        >/dev/null 2>&1
+    if [ $? -ne 0 ]; then
+        echo mksquashfs cannot create ${comp} images, skipped
+        return
+    fi
+
+    ./${odir}/u-boot << EOF > ${out}
+host bind 0 ${img}
+ls host 0 /
+ls host 0 /etc/dtbs
+size host 0 /boot/initrd
+printenv filesize
+time load host 0 ${loadaddr} /kernel
+sb load hostfs - ${readaddr} ${root}/boot/vmlinuz
+cmp.b ${loadaddr} ${readaddr} \$filesize
+time load host 0 ${loadaddr} /boot/initrd
+sb load hostfs - ${readaddr} ${root}/boot/initrd
+cmp.b ${loadaddr} ${readaddr} \$filesize
+load host 0 ${loadaddr} /boot/initrd 100000 1ff000
+cmp.b ${loadaddr} 31ff000 100000
+load host 0 ${loadaddr} /sparse
+sb load hostfs - ${readaddr} ${root}/sparse
+cmp.b ${loadaddr} ${readaddr} \$filesize
+setenv loaddtbs '${loaddtbs}'
+time run loaddtbs
+sb load hostfs - ${readaddr} ${root}/boot/dtbs/board15.dtb
+cmp.b ${loadaddr} ${readaddr} \$filesize
+reset
+EOF
+    if [ $? -ne 0 ]; then
+        echo U-Boot exit status indicates an error
+        exit $?
+    fi
+    cat ${out}
+
+    if [ "${comp}" = "xz" ]; then
+        grep -q "not supported" ${out} || result=FAILURE
+    elif grep -q -e "!=" -e "Unable" -e "Error" -e "not found" ${out}; then
+        echo ${comp}: files could not be read back
+        result=FAILURE
+    fi
+    size=`stat -c %s ${root}/boot/initrd`
+    if [ "${comp}" != "xz" ] && \
+       ! grep -q "^filesize=`printf %x ${size}`" ${out}; then
+        echo ${comp}: wrong size for /boot/initrd
+        result=FAILURE
+    fi
+}
+
+for comp in gzip lzma lzo lz4 xz; do
+    run ${comp}
+done
+rm -f ${out}
+echo ${result}
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for batched device tree fixups, checking that they give the same
+ * tree as making each change with libfdt
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_batch.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <test/image.h>
+#include <test/ut.h>
+
+#define FDT_SIZE		0x10000
+#define BENCH_FDT_SIZE		0x80000
+#define BENCH_NODES		2000
+
+/* Number of random edits made by the equivalence test */
+#define FUZZ_EDITS		400
+#define FUZZ_MAX_NODES		100
+
+/**
+ * make_tree() - Create a tree with a number of similar nodes
+ *
+ * Each node is called node@<n> and is compatible with "test,batch". Every
+ * third node has a subnode.
+ *
+ * @buf:	Buffer to hold the tree
+ * @size:	Size of buffer
+ * @count:	Number of nodes to create
+ * @return 0 if OK, -FDT_ERR_... on error
+ */
+static int make_tree(void *buf, int size, int count)
+{
+	char name[20];
+	int i;
+
+	fdt_create(buf, size);
+	fdt_finish_reservemap(buf);
+	fdt_begin_node(buf, "");
+	fdt_property_string(buf, "model", "Batch test");
+	fdt_property_u32(buf, "#address-cells", 1);
+	fdt_property_u32(buf, "#size-cells", 0);
+	for (i = 0; i < count; i++) {
+		snprintf(name, sizeof(name), "node@%d", i);
+		fdt_begin_node(buf, name);
+		fdt_property_string(buf, "compatible", "test,batch");
+		fdt_property_u32(buf, "reg", i);
+		if (!(i % 3)) {
+			fdt_property_string(buf, "status", "okay");
+			fdt_begin_node(buf, "sub");
+			fdt_property_u32(buf, "reg", i);
+			fdt_end_node(buf);
+		}
+		fdt_end_node(buf);
+	}
+	fdt_end_node(buf);
+	fdt_finish(buf);
+
+	return fdt_open_into(buf, buf, size);
+}
+
+/* Check that two trees have the same nodes, properties and strings */
+static int check_same_tree(struct unit_test_state *uts, const void *fdt,
+			   const void *expect)
+{
+	const struct fdt_property *prop, *eprop;
+	int offset, nextoffset, len, elen;
+	uint32_t tag;
+
+	ut_asserteq(fdt_size_dt_struct(expect), fdt_size_dt_struct(fdt));
+	ut_asserteq(fdt_size_dt_strings(expect), fdt_size_dt_strings(fdt));
+	ut_assertok(memcmp(fdt_string(expect, 0), fdt_string(fdt, 0),
+			   fdt_size_dt_strings(fdt)));
+
+	/* Padding may differ, so compare each tag rather than the bytes */
+	for (offset = 0; offset >= 0; offset = nextoffset) {
+		tag = fdt_next_tag(expect, offset, &nextoffset);
+		ut_asserteq(tag, fdt_next_tag(fdt, offset, &len));
+		ut_asserteq(nextoffset, len);
+		if (tag == FDT_END)
+			break;
+		if (tag == FDT_BEGIN_NODE) {
+			ut_asserteq_str(fdt_get_name(expect, offset, NULL),
+					fdt_get_name(fdt, offset, NULL));
+		} else if (tag == FDT_PROP) {
+			eprop = fdt_get_property_by_offset(expect, offset,
+							   &elen);
+			prop = fdt_get_property_by_offset(fdt, offset, &len);
+			ut_asserteq(fdt32_to_cpu(eprop->nameoff),
+				    fdt32_to_cpu(prop->nameoff));
+			ut_asserteq(elen, len);
+			ut_assertok(memcmp(eprop->data, prop->data, len));
+		}
+	}
+
+	return 0;
+}
+
+/* Simple xorshift generator, so that any failure can be reproduced */
+static uint fuzz_rand(uint *seed)
+{
+	uint x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+
+	return x;
+}
+
+/**
+ * struct fuzz_node - A node which the equivalence test can edit
+ *
+ * @path:	Full path of node
+ * @offset:	Offset of node, for use with the batch
+ */
+struct fuzz_node {
+	char path[80];
+	int offset;
+};
+
+static const char *const fuzz_prop_names[] = {
+	"compatible", "reg", "status", "model", "clocks", "interrupts",
+	"a-much-longer-property-name", "ts",
+};
+
+/* Make random edits with libfdt and with a batch and check they match */
+static int image_test_fdt_batch_fuzz(struct unit_test_state *uts)
+{
+	struct fuzz_node *nodes, *node;
+	int node_count = 0, ret, expect, len, elen;
+	const void *val, *eval;
+	struct fdt_batch batch;
+	const char *name;
+	char new_name[10];
+	uint seed = 1234;
+	void *fdt, *ref;
+	u8 data[20];
+	int i, j;
+
+	nodes = calloc(FUZZ_MAX_NODES, sizeof(*nodes));
+	ut_assertnonnull(nodes);
+	fdt = malloc(FDT_SIZE);
+	ut_assertnonnull(fdt);
+	ref = malloc(FDT_SIZE);
+	ut_assertnonnull(ref);
+	ut_assertok(make_tree(fdt, FDT_SIZE, 30));
+	memcpy(ref, fdt, FDT_SIZE);
+
+	strcpy(nodes[node_count++].path, "/");
+	for (i = 0; i < 30; i += 2)
+		snprintf(nodes[node_count++].path, 80, "/node@%d", i);
+	strcpy(nodes[node_count++].path, "/node@3/sub");
+	for (i = 0; i < node_count; i++) {
+		nodes[i].offset = fdt_path_offset(fdt, nodes[i].path);
+		ut_assert(nodes[i].offset >= 0);
+	}
+
+	ut_assertok(fdt_batch_init(&batch, fdt));
+	for (i = 0; i < FUZZ_EDITS; i++) {
+		uint r = fuzz_rand(&seed);
+
+		node = &nodes[(r >> 4) % node_count];
+		name = fuzz_prop_names[(r >> 12) % ARRAY_SIZE(fuzz_prop_names)];
+		switch (r % 8) {
+		case 0 ... 3:
+			len = (r >> 20) % sizeof(data);
+			for (j = 0; j < len; j++)
+				data[j] = fuzz_rand(&seed);
+			expect = fdt_setprop(ref, fdt_path_offset(ref,
+					     node->path), name, data, len);
+			ret = fdt_batch_setprop(&batch, node->offset, name,
+						data, len);
+			break;
+		case 4 ... 5:
+			expect = fdt_delprop(ref, fdt_path_offset(ref,
+					     node->path), name);
+			ret = fdt_batch_delprop(&batch, node->offset, name);
+			break;
+		case 6:
+			/* Sometimes use a name which is already there */
+			if (r & (1 << 20))
+				strcpy(new_name, "sub");
+			else
+				snprintf(new_name, sizeof(new_name), "n%d", i);
+			expect = fdt_add_subnode(ref, fdt_path_offset(ref,
+						 node->path), new_name);
+			ret = fdt_batch_add_subnode(&batch, node->offset,
+						    new_name);
+			ut_asserteq(expect < 0, ret < 0);
+			if (ret < 0)
+				break;
+			if (node_count < FUZZ_MAX_NODES &&
+			    strlen(node->path) < 60) {
+				snprintf(nodes[node_count].path, 80, "%s/%s",
+					 strcmp(node->path, "/") ?
+					 node->path : "", new_name);
+				nodes[node_count++].offset = ret;
+			}
+			continue;
+		default:
+			eval = fdt_getprop(ref, fdt_path_offset(ref,
+					   node->path), name, &elen);
+			val = fdt_batch_getprop(&batch, node->offset, name,
+						&len);
+			ut_asserteq(elen, len);
+			if (eval)
+				ut_assertok(memcmp(eval, val, len));
+			continue;
+		}
+		ut_asserteq(expect, ret);
+	}
+	ut_assertok(fdt_batch_commit(&batch));
+	ut_assertok(check_same_tree(uts, fdt, ref));
+
+	free(ref);
+	free(fdt);
+	free(nodes);
+
+	return 0;
+}
+IMAGE_TEST(image_test_fdt_batch_fuzz, 0);
+
+/* Test that a batch which does not fit leaves the tree unchanged */
+static int image_test_fdt_batch_nospace(struct unit_test_state *uts)
+{
+	struct fdt_batch batch;
+	void *fdt, *ref;
+	char big[0x100];
+	int size;
+
+	fdt = malloc(FDT_SIZE);
+	ut_assertnonnull(fdt);
+	ut_assertok(make_tree(fdt, FDT_SIZE, 4));
+	ut_assertok(fdt_pack(fdt));
+	size = fdt_totalsize(fdt);
+	ref = malloc(size);
+	ut_assertnonnull(ref);
+	memcpy(ref, fdt, size);
+
+	memset(big, 'x', sizeof(big));
+	ut_assertok(fdt_batch_init(&batch, fdt));
+	ut_assertok(fdt_batch_setprop(&batch, 0, "big", big, sizeof(big)));
+	ut_asserteq(-FDT_ERR_NOSPACE, fdt_batch_commit(&batch));
+	ut_assertok(memcmp(ref, fdt, size));
+
+	/* Bad offsets are caught when the edit is made */
+	ut_assertok(fdt_batch_init(&batch, fdt));
+	ut_asserteq(-FDT_ERR_BADOFFSET, fdt_batch_setprop(&batch, 4, "x",
+							  big, 1));
+	ut_asserteq(-FDT_ERR_EXISTS, fdt_batch_add_subnode(&batch, 0,
+							   "node@1"));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_batch_delprop(&batch, 0, "x"));
+	fdt_batch_free(&batch);
+
+	free(ref);
+	free(fdt);
+
+	return 0;
+}
+IMAGE_TEST(image_test_fdt_batch_nospace, 0);
+
+/* This is how do_fixup_by_compat() worked before it used a batch */
+static void fixup_by_compat_libfdt(void *fdt, const char *compat,
+				   const char *prop, const void *val, int len,
+				   int create)
+{
+	int off;
+
+	off = fdt_node_offset_by_compatible(fdt, -1, compat);
+	while (off != -FDT_ERR_NOTFOUND) {
+		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
+			fdt_setprop(fdt, off, prop, val, len);
+		off = fdt_node_offset_by_compatible(fdt, off, compat);
+	}
+}
+
+/* Check do_fixup_by_compat() against libfdt and show the speed of each */
+static int image_test_fdt_fixup_compat(struct unit_test_state *uts)
+{
+	ulong start, batch_us, libfdt_us;
+	void *fdt, *ref;
+
+	fdt = malloc(BENCH_FDT_SIZE);
+	ut_assertnonnull(fdt);
+	ref = malloc(BENCH_FDT_SIZE);
+	ut_assertnonnull(ref);
+	ut_assertok(make_tree(fdt, BENCH_FDT_SIZE, BENCH_NODES));
+	memcpy(ref, fdt, BENCH_FDT_SIZE);
+
+	start = timer_get_us();
+	fixup_by_compat_libfdt(ref, "test,batch", "clock-frequency", "1234",
+			       4, 1);
+	fixup_by_compat_libfdt(ref, "test,batch", "status", "disabled", 9, 0);
+	libfdt_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	do_fixup_by_compat(fdt, "test,batch", "clock-frequency", "1234", 4, 1);
+	do_fixup_by_compat(fdt, "test,batch", "status", "disabled", 9, 0);
+	batch_us = timer_get_us() - start;
+
+	ut_assertok(check_same_tree(uts, fdt, ref));
+	printf("%d nodes: libfdt %lu us, batch %lu us\n", BENCH_NODES,
+	       libfdt_us, batch_us);
+
+	free(ref);
+	free(fdt);
+
+	return 0;
+}
+IMAGE_TEST(image_test_fdt_fixup_compat, 0);
+
+/*
+ * Test that MAC addresses are updated from the environment. This uses the
+ * addresses in the sandbox environment, which cannot be changed.
+ */
+static int image_test_fdt_fixup_ethernet(struct unit_test_state *uts)
+{
+	const u8 mac0[] = { 0x00, 0x00, 0x11, 0x22, 0x33, 0x44 };
+	const u8 mac5[] = { 0x00, 0x00, 0x11, 0x22, 0x33, 0x47 };
+	const u8 old_mac[6] = { 0 };
+	const void *val;
+	void *fdt;
+	int node, len;
+
+	fdt = malloc(FDT_SIZE);
+	ut_assertnonnull(fdt);
+	ut_assertok(make_tree(fdt, FDT_SIZE, 3));
+	node = fdt_add_subnode(fdt, 0, "aliases");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fdt, node, "ethernet0", "/node@0"));
+	ut_assertok(fdt_setprop_string(fdt, node, "ethernet2", "/node@1"));
+	ut_assertok(fdt_setprop_string(fdt, node, "serial0", "/node@1"));
+	ut_assertok(fdt_setprop_string(fdt, node, "ethernet5", "/node@2"));
+	ut_assertok(fdt_setprop(fdt, fdt_path_offset(fdt, "/node@0"),
+				"mac-address", old_mac, sizeof(old_mac)));
+	fdt_fixup_ethernet(fdt);
+
+	/* mac-address is only updated if present; local-mac-address is added */
+	node = fdt_path_offset(fdt, "/node@0");
+	val = fdt_getprop(fdt, node, "mac-address", &len);
+	ut_asserteq(sizeof(mac0), len);
+	ut_assertok(memcmp(mac0, val, len));
+	val = fdt_getprop(fdt, node, "local-mac-address", &len);
+	ut_asserteq(sizeof(mac0), len);
+	ut_assertok(memcmp(mac0, val, len));
+
+	/* There is no eth2addr */
+	node = fdt_path_offset(fdt, "/node@1");
+	ut_asserteq_ptr(NULL, fdt_getprop(fdt, node, "local-mac-address",
+					  NULL));
+	node = fdt_path_offset(fdt, "/node@2");
+	ut_asserteq_ptr(NULL, fdt_getprop(fdt, node, "mac-address", NULL));
+	val = fdt_getprop(fdt, node, "local-mac-address", &len);
+	ut_asserteq(sizeof(mac5), len);
+	ut_assertok(memcmp(mac5, val, len));
+
+	free(fdt);
+
+	return 0;
+}
+IMAGE_TEST(image_test_fdt_fixup_ethernet, 0);
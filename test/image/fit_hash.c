@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for the FIT hash cache, which makes sure that image data is only
+ * hashed once while booting
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <image.h>
+#include <malloc.h>
+#include <libfdt.h>
+#include <test/image.h>
+#include <test/ut.h>
+
+#define FIT_SIZE		0x4000
+#define KERNEL_SIZE		0x1000
+#define FDT_SIZE		0x100
+
+/**
+ * add_hash() - Add a hash node with the correct digest to an image node
+ *
+ * @fit:	FIT to update
+ * @node:	Image node to add the hash to
+ * @name:	Name of the hash node
+ * @algo:	Hash algorithm to use
+ * @return 0 if OK, -ve on error
+ */
+static int add_hash(void *fit, int node, const char *name, const char *algo)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	const void *data;
+	int value_len;
+	size_t size;
+	int hash;
+
+	if (fit_image_get_data(fit, node, &data, &size))
+		return -EINVAL;
+	if (calculate_hash(data, size, algo, value, &value_len))
+		return -EINVAL;
+	hash = fdt_add_subnode(fit, node, name);
+	if (hash < 0)
+		return hash;
+	if (fdt_setprop_string(fit, hash, FIT_ALGO_PROP, algo) ||
+	    fdt_setprop(fit, hash, FIT_VALUE_PROP, value, value_len))
+		return -ENOSPC;
+
+	return 0;
+}
+
+static int add_image(void *fit, const char *name, int size, uint8_t fill)
+{
+	char data[KERNEL_SIZE];
+	int images, node;
+
+	images = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images < 0)
+		images = fdt_add_subnode(fit, 0, "images");
+	if (images < 0)
+		return images;
+	node = fdt_add_subnode(fit, images, name);
+	if (node < 0)
+		return node;
+	memset(data, fill, size);
+	if (fdt_setprop(fit, node, FIT_DATA_PROP, data, size))
+		return -ENOSPC;
+
+	return node;
+}
+
+/**
+ * make_fit() - Create a FIT with a kernel and an FDT
+ *
+ * The kernel has two SHA256 hashes and a CRC32, the FDT has one SHA256 hash.
+ * Digests are calculated before the cache is started.
+ *
+ * @return pointer to the allocated FIT, or NULL on error
+ */
+static void *make_fit(void)
+{
+	int kernel, fdt;
+	void *fit;
+
+	fit = malloc(FIT_SIZE);
+	if (!fit)
+		return NULL;
+	if (fdt_create_empty_tree(fit, FIT_SIZE))
+		goto err;
+
+	kernel = add_image(fit, "kernel@1", KERNEL_SIZE, 0xa5);
+	if (kernel < 0 ||
+	    add_hash(fit, kernel, "hash@1", "sha256") ||
+	    add_hash(fit, kernel, "hash@2", "crc32") ||
+	    add_hash(fit, kernel, "hash@3", "sha256"))
+		goto err;
+
+	fdt = add_image(fit, "fdt@1", FDT_SIZE, 0x5a);
+	if (fdt < 0 || add_hash(fit, fdt, "hash@1", "sha256"))
+		goto err;
+
+	return fit;
+err:
+	free(fit);
+	return NULL;
+}
+
+/* Test that each byte of image data is hashed once for each algorithm */
+static int image_test_fit_hash_once(struct unit_test_state *uts)
+{
+	struct fit_hash_cache_stats stats;
+	int kernel, fdt;
+	void *fit;
+
+	fit = make_fit();
+	ut_assertnonnull(fit);
+	kernel = fdt_path_offset(fit, "/images/kernel@1");
+	fdt = fdt_path_offset(fit, "/images/fdt@1");
+	ut_assert(kernel >= 0 && fdt >= 0);
+
+	fit_hash_cache_start();
+
+	/* The kernel is checked twice, as when it is also a loadable */
+	ut_asserteq(1, fit_image_verify(fit, kernel));
+	ut_asserteq(1, fit_image_verify(fit, kernel));
+	ut_asserteq(1, fit_image_verify(fit, fdt));
+
+	fit_hash_cache_get_stats(&stats);
+	ut_asserteq(KERNEL_SIZE * 2 + FDT_SIZE, stats.bytes);
+	ut_asserteq(3, stats.misses);
+	ut_asserteq(4, stats.hits);
+
+	fit_hash_cache_stop();
+	free(fit);
+
+	return 0;
+}
+IMAGE_TEST(image_test_fit_hash_once, 0);
+
+/* Test that a cached digest is still checked against each hash node */
+static int image_test_fit_hash_bad(struct unit_test_state *uts)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	struct fit_hash_cache_stats stats;
+	int kernel, hash, len;
+	uint8_t *fit_value;
+	void *fit;
+
+	fit = make_fit();
+	ut_assertnonnull(fit);
+	kernel = fdt_path_offset(fit, "/images/kernel@1");
+	ut_assert(kernel >= 0);
+
+	fit_hash_cache_start();
+	ut_asserteq(1, fit_image_verify(fit, kernel));
+
+	/* Corrupt a SHA256 value; the digest itself now comes from the cache */
+	hash = fdt_subnode_offset(fit, kernel, "hash@3");
+	ut_assert(hash >= 0);
+	ut_assertok(fit_image_hash_get_value(fit, hash, &fit_value, &len));
+	memcpy(value, fit_value, len);
+	value[0] ^= 1;
+	ut_assertok(fdt_setprop_inplace(fit, hash, FIT_VALUE_PROP, value,
+					len));
+	ut_asserteq(0, fit_image_verify(fit, kernel));
+	fit_hash_cache_get_stats(&stats);
+	ut_asserteq(KERNEL_SIZE * 2, stats.bytes);
+	fit_hash_cache_stop();
+
+	free(fit);
+
+	return 0;
+}
+IMAGE_TEST(image_test_fit_hash_bad, 0);
+
+/* Test that nothing is remembered once the cache is stopped */
+static int image_test_fit_hash_stopped(struct unit_test_state *uts)
+{
+	struct fit_hash_cache_stats stats;
+	int kernel;
+	void *fit;
+
+	fit = make_fit();
+	ut_assertnonnull(fit);
+	kernel = fdt_path_offset(fit, "/images/kernel@1");
+	ut_assert(kernel >= 0);
+
+	fit_hash_cache_start();
+	ut_asserteq(1, fit_image_verify(fit, kernel));
+	fit_hash_cache_stop();
+
+	/* The data may change after bootm, so it must be hashed again */
+	memset((void *)fdt_getprop(fit, kernel, FIT_DATA_PROP, NULL), '\0',
+	       KERNEL_SIZE);
+	ut_asserteq(0, fit_image_verify(fit, kernel));
+
+	/* Statistics are kept but not updated */
+	fit_hash_cache_get_stats(&stats);
+	ut_asserteq(KERNEL_SIZE * 2, stats.bytes);
+	ut_asserteq(2, stats.misses);
+	ut_asserteq(1, stats.hits);
+
+	free(fit);
+
+	return 0;
+}
+IMAGE_TEST(image_test_fit_hash_stopped, 0);
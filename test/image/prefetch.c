@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for loading boot images during the boot delay. These use a small
+ * FAT16 filesystem on a sandbox host block device.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <autoboot.h>
+#include <console.h>
+#include <fat.h>
+#include <image.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <membuff.h>
+#include <os.h>
+#include <sandboxblockdev.h>
+#include <test/image.h>
+#include <test/ut.h>
+#include <asm/unaligned.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define DISK_FILE		"prefetch_test.img"
+#define SECT_SIZE		512
+#define CLUST_SECTS		4
+#define CLUST_SIZE		(CLUST_SECTS * SECT_SIZE)
+#define FAT_SECTS		8
+#define ROOT_ENTRIES		512
+#define DATA_SECT		(1 + FAT_SECTS + \
+				 ROOT_ENTRIES * sizeof(dir_entry) / SECT_SIZE)
+#define DISK_CLUSTS		1300
+#define DISK_SIZE		((DATA_SECT + DISK_CLUSTS * CLUST_SECTS) * \
+				 SECT_SIZE)
+
+/* The kernel is larger than two chunks, so takes several steps to load */
+#define KERNEL_SIZE		0x240000
+#define FIT_SIZE		(KERNEL_SIZE + 0x1000)
+#define RAW_SIZE		0x1000
+#define FIT_ADDR		0x1000000
+#define RAW_ADDR		0x1800000
+
+#define PREFETCH_SPEC		"host 0:0 1000000 image.itb; " \
+				"host 0:0 1800000 raw.bin"
+
+/**
+ * struct prefetch_disk - a FAT16 filesystem being built
+ *
+ * @buf:	Contents of the disk
+ * @next_clust:	Next free cluster
+ * @next_dirent: Next free root directory entry
+ */
+struct prefetch_disk {
+	uint8_t *buf;
+	int next_clust;
+	int next_dirent;
+};
+
+/**
+ * add_file() - Add a file to the root directory, in contiguous clusters
+ *
+ * @disk:	Disk to update
+ * @name:	8.3 name, padded with spaces and without the dot
+ * @data:	File contents
+ * @size:	Size of file in bytes
+ * @return offset of the file contents from the start of the disk
+ */
+static int add_file(struct prefetch_disk *disk, const char *name,
+		    const void *data, int size)
+{
+	__le16 *fat = (__le16 *)(disk->buf + SECT_SIZE);
+	dir_entry *dent;
+	int clusts = DIV_ROUND_UP(size, CLUST_SIZE);
+	int start = disk->next_clust;
+	int offset, i;
+
+	dent = (dir_entry *)(disk->buf + (1 + FAT_SECTS) * SECT_SIZE);
+	dent += disk->next_dirent++;
+	memcpy(dent->name, name, sizeof(dent->name) + sizeof(dent->ext));
+	dent->attr = ATTR_ARCH;
+	dent->start = cpu_to_le16(start);
+	dent->size = cpu_to_le32(size);
+
+	for (i = start; i < start + clusts - 1; i++)
+		fat[i] = cpu_to_le16(i + 1);
+	fat[i] = cpu_to_le16(0xffff);
+	disk->next_clust += clusts;
+
+	offset = (DATA_SECT + (start - 2) * CLUST_SECTS) * SECT_SIZE;
+	memcpy(disk->buf + offset, data, size);
+
+	return offset;
+}
+
+static int add_hash(void *fit, int node, const char *name, const char *algo)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	const void *data;
+	int value_len;
+	size_t size;
+	int hash;
+
+	if (fit_image_get_data(fit, node, &data, &size) ||
+	    calculate_hash(data, size, algo, value, &value_len))
+		return -EINVAL;
+	hash = fdt_add_subnode(fit, node, name);
+	if (hash < 0)
+		return hash;
+	if (fdt_setprop_string(fit, hash, FIT_ALGO_PROP, algo) ||
+	    fdt_setprop(fit, hash, FIT_VALUE_PROP, value, value_len))
+		return -ENOSPC;
+
+	return 0;
+}
+
+/**
+ * make_fit() - Create a FIT with a kernel and an FDT, each with a hash
+ *
+ * @bad:	true to corrupt the kernel data after the hash is added
+ * @return pointer to the allocated FIT, or NULL on error
+ */
+static void *make_fit(bool bad)
+{
+	int images, kernel, fdt;
+	uint8_t *data;
+	void *fit;
+	int i;
+
+	fit = calloc(1, FIT_SIZE);
+	data = malloc(KERNEL_SIZE);
+	if (!fit || !data)
+		goto err;
+	for (i = 0; i < KERNEL_SIZE; i++)
+		data[i] = i * 7;
+	if (fdt_create_empty_tree(fit, FIT_SIZE) ||
+	    fdt_setprop_string(fit, 0, FIT_DESC_PROP, "Prefetch test") ||
+	    fdt_setprop_u32(fit, 0, FIT_TIMESTAMP_PROP, 0))
+		goto err;
+	images = fdt_add_subnode(fit, 0, "images");
+	kernel = fdt_add_subnode(fit, images, "kernel@1");
+	if (kernel < 0 ||
+	    fdt_setprop(fit, kernel, FIT_DATA_PROP, data, KERNEL_SIZE) ||
+	    add_hash(fit, kernel, "hash@1", "sha256"))
+		goto err;
+	fdt = fdt_add_subnode(fit, images, "fdt@1");
+	if (fdt < 0 || fdt_setprop(fit, fdt, FIT_DATA_PROP, data, 0x100) ||
+	    add_hash(fit, fdt, "hash@1", "crc32"))
+		goto err;
+	free(data);
+	if (bad) {
+		data = (uint8_t *)fdt_getprop(fit, kernel, FIT_DATA_PROP, NULL);
+		data[KERNEL_SIZE / 2] ^= 1;
+	}
+
+	return fit;
+err:
+	free(data);
+	free(fit);
+	return NULL;
+}
+
+/**
+ * setup_disk() - Write a FAT16 disk containing image.itb and raw.bin
+ *
+ * The disk is bound to host device 0.
+ *
+ * @uts:	Test state
+ * @bad:	true to corrupt the FIT data
+ * @fit_offsetp: Returns the offset of image.itb on the disk
+ * @return 0 if OK, -ve on error
+ */
+static int setup_disk(struct unit_test_state *uts, bool bad, int *fit_offsetp)
+{
+	struct prefetch_disk disk;
+	uint8_t raw[RAW_SIZE];
+	boot_sector *bs;
+	volume_info *vi;
+	__le16 *fat;
+	void *fit;
+	int fd;
+
+	disk.buf = calloc(1, DISK_SIZE);
+	ut_assertnonnull(disk.buf);
+	disk.next_clust = 2;
+	disk.next_dirent = 0;
+
+	bs = (boot_sector *)disk.buf;
+	memcpy(bs->system_id, "U-BOOT  ", sizeof(bs->system_id));
+	put_unaligned_le16(SECT_SIZE, bs->sector_size);
+	bs->cluster_size = CLUST_SECTS;
+	bs->reserved = cpu_to_le16(1);
+	bs->fats = 1;
+	put_unaligned_le16(ROOT_ENTRIES, bs->dir_entries);
+	bs->media = 0xf8;
+	bs->fat_length = cpu_to_le16(FAT_SECTS);
+	bs->total_sect = cpu_to_le32(DISK_SIZE / SECT_SIZE);
+	vi = (volume_info *)&bs->fat32_length;
+	vi->ext_boot_sign = 0x29;
+	memcpy(vi->volume_label, "PREFETCH   ", sizeof(vi->volume_label));
+	memcpy(vi->fs_type, FAT16_SIGN, sizeof(vi->fs_type));
+	disk.buf[SECT_SIZE - 2] = 0x55;
+	disk.buf[SECT_SIZE - 1] = 0xaa;
+	fat = (__le16 *)(disk.buf + SECT_SIZE);
+	fat[0] = cpu_to_le16(0xfff8);
+	fat[1] = cpu_to_le16(0xffff);
+
+	fit = make_fit(bad);
+	ut_assertnonnull(fit);
+	*fit_offsetp = add_file(&disk, "IMAGE   ITB", fit, FIT_SIZE);
+	free(fit);
+	memset(raw, 0x5a, sizeof(raw));
+	add_file(&disk, "RAW     BIN", raw, sizeof(raw));
+
+	fd = os_open(DISK_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(DISK_SIZE, os_write(fd, disk.buf, DISK_SIZE));
+	os_close(fd);
+	free(disk.buf);
+	ut_assertok(host_dev_bind(0, DISK_FILE));
+
+	return 0;
+}
+
+static int cleanup_disk(struct unit_test_state *uts)
+{
+	autoboot_prefetch_cancel();
+	ut_assertok(host_dev_bind(0, NULL));
+	ut_assertok(os_unlink(DISK_FILE));
+
+	return 0;
+}
+
+/* Run the prefetch to completion, returning the number of steps taken */
+static int run_prefetch(void)
+{
+	int steps = 0;
+
+	while (autoboot_prefetch_step())
+		steps++;
+
+	return steps;
+}
+
+static bool fit_is_loaded(void)
+{
+	const void *fit = map_sysmem(FIT_ADDR, FIT_SIZE);
+	bool loaded;
+
+	loaded = fit_check_format(fit) && fdt_totalsize(fit) == FIT_SIZE;
+	unmap_sysmem(fit);
+
+	return loaded;
+}
+
+/* Test that prefetched files are used by 'load' */
+static int image_test_prefetch_claim(struct unit_test_state *uts)
+{
+	uint8_t *kernel, old, value;
+	int fit_offset, fd;
+	loff_t size;
+
+	ut_assertok(setup_disk(uts, false, &fit_offset));
+	memset(map_sysmem(FIT_ADDR, FIT_SIZE), '\0', FIT_SIZE);
+
+	autoboot_prefetch_start(PREFETCH_SPEC);
+	ut_assert(!autoboot_prefetch_claim("host", "0:0", FIT_ADDR,
+					   "image.itb", &size));
+	ut_assert(run_prefetch() >= 2);
+	ut_assert(fit_is_loaded());
+
+	ut_assert(autoboot_prefetch_claim("host", "0:0", FIT_ADDR, "image.itb",
+					  &size));
+	ut_asserteq(FIT_SIZE, size);
+	ut_assert(autoboot_prefetch_claim("host", "0:0", RAW_ADDR, "raw.bin",
+					  &size));
+	ut_asserteq(RAW_SIZE, size);
+	ut_assert(!autoboot_prefetch_claim("host", "0:0", RAW_ADDR + 1,
+					   "raw.bin", &size));
+	ut_assert(!autoboot_prefetch_claim("host", NULL, RAW_ADDR, "raw.bin",
+					   &size));
+	ut_assert(!autoboot_prefetch_claim("host", "0:0", RAW_ADDR,
+					   "image.itb", &size));
+
+	/* Change the file on disk, so we can tell whether 'load' reads it */
+	kernel = map_sysmem(FIT_ADDR + FIT_SIZE / 2, 1);
+	old = *kernel;
+	value = ~old;
+	fd = os_open(DISK_FILE, OS_O_RDWR);
+	ut_assert(fd >= 0);
+	os_lseek(fd, fit_offset + FIT_SIZE / 2, OS_SEEK_SET);
+	ut_asserteq(1, os_write(fd, &value, 1));
+	os_close(fd);
+
+	ut_assertok(run_command("load host 0:0 1000000 image.itb", 0));
+	ut_asserteq(FIT_SIZE, getenv_hex("filesize", 0));
+	ut_asserteq(old, *kernel);
+
+	/* Once cancelled, the file must be read again */
+	autoboot_prefetch_cancel();
+	ut_assertok(run_command("load host 0:0 1000000 image.itb", 0));
+	ut_asserteq(value, *kernel);
+	unmap_sysmem(kernel);
+
+	return cleanup_disk(uts);
+}
+IMAGE_TEST(image_test_prefetch_claim, 0);
+
+/* Test that a corrupt image is not used */
+static int image_test_prefetch_bad(struct unit_test_state *uts)
+{
+	int fit_offset;
+	loff_t size;
+
+	ut_assertok(setup_disk(uts, true, &fit_offset));
+	autoboot_prefetch_start(PREFETCH_SPEC);
+	run_prefetch();
+	ut_assert(fit_is_loaded());
+	ut_assert(!autoboot_prefetch_claim("host", "0:0", FIT_ADDR,
+					   "image.itb", &size));
+	ut_assert(autoboot_prefetch_claim("host", "0:0", RAW_ADDR, "raw.bin",
+					  &size));
+
+	return cleanup_disk(uts);
+}
+IMAGE_TEST(image_test_prefetch_bad, 0);
+
+/* Test that a file is not used if its memory is changed after loading */
+static int image_test_prefetch_changed(struct unit_test_state *uts)
+{
+	int fit_offset;
+	uint8_t *raw;
+	loff_t size;
+
+	ut_assertok(setup_disk(uts, false, &fit_offset));
+	autoboot_prefetch_start(PREFETCH_SPEC);
+	run_prefetch();
+
+	raw = map_sysmem(RAW_ADDR, RAW_SIZE);
+	raw[RAW_SIZE - 1] = 0;
+	unmap_sysmem(raw);
+	ut_assert(!autoboot_prefetch_claim("host", "0:0", RAW_ADDR, "raw.bin",
+					   &size));
+	ut_assert(autoboot_prefetch_claim("host", "0:0", FIT_ADDR, "image.itb",
+					  &size));
+
+	/* Nothing can be claimed after the prefetch is cancelled */
+	autoboot_prefetch_cancel();
+	ut_assert(!autoboot_prefetch_claim("host", "0:0", FIT_ADDR,
+					   "image.itb", &size));
+
+	return cleanup_disk(uts);
+}
+IMAGE_TEST(image_test_prefetch_changed, 0);
+
+/* Test that stopping autoboot with a key press discards the prefetch */
+static int image_test_prefetch_abort(struct unit_test_state *uts)
+{
+	char *old_delay;
+	int fit_offset;
+	loff_t size;
+
+	ut_assertok(setup_disk(uts, false, &fit_offset));
+	old_delay = getenv("bootdelay");
+	if (old_delay)
+		old_delay = strdup(old_delay);
+	ut_assertok(setenv("bootprefetch", PREFETCH_SPEC));
+	ut_assertok(setenv("bootdelay", "1"));
+	bootdelay_process();
+
+	console_record_reset();
+	ut_asserteq(1, membuff_put(&gd->console_in, " ", 1));
+	autoboot_command("false");
+	ut_assert(!autoboot_prefetch_step());
+	ut_assert(!autoboot_prefetch_claim("host", "0:0", RAW_ADDR, "raw.bin",
+					   &size));
+
+	ut_assertok(setenv("bootprefetch", NULL));
+	ut_assertok(setenv("bootdelay", old_delay));
+	free(old_delay);
+
+	return cleanup_disk(uts);
+}
+IMAGE_TEST(image_test_prefetch_abort, 0);
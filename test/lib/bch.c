@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for the software BCH library used for NAND ECC
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <linux/bch.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+/* Number of random pages to decode for each set of parameters */
+#define BCH_TEST_COUNT		100
+
+/* Number of pages to decode in the speed test */
+#define BCH_SPEED_COUNT		10000
+
+#define BCH_MAX_LEN		1024
+
+struct bch_test_params {
+	int m;
+	int t;
+	int len;
+};
+
+/* Typical parameters for SLC and MLC NAND with 512- and 1024-byte steps */
+static const struct bch_test_params bch_test_params[] = {
+	{ 13, 4, 512 },
+	{ 13, 8, 512 },
+	{ 14, 24, 1024 },
+	{ 14, 40, 1024 },
+};
+
+struct bch_test_page {
+	uint8_t data[BCH_MAX_LEN];
+	uint8_t ecc[BCH_MAX_LEN / 8];
+	uint8_t calc_ecc[BCH_MAX_LEN / 8];
+	unsigned int errloc[64];
+};
+
+static uint32_t bch_test_seed = 1;
+
+/* A simple xorshift generator, so that test runs are repeatable */
+static uint32_t bch_test_rand(void)
+{
+	bch_test_seed ^= bch_test_seed << 13;
+	bch_test_seed ^= bch_test_seed >> 17;
+	bch_test_seed ^= bch_test_seed << 5;
+
+	return bch_test_seed;
+}
+
+static void bch_test_flip(struct bch_test_page *page, int len, uint bit)
+{
+	if (bit < len * 8)
+		page->data[bit / 8] ^= 1 << (bit % 8);
+	else
+		page->ecc[bit / 8 - len] ^= 1 << (bit % 8);
+}
+
+/**
+ * bch_test_inject() - Flip random bits in a page's data and ECC
+ *
+ * @bch:	BCH control structure
+ * @page:	Page to update
+ * @len:	Data length in bytes
+ * @count:	Number of bits to flip
+ * @bits:	Returns the positions of the flipped bits
+ */
+static void bch_test_inject(struct bch_control *bch,
+			    struct bch_test_page *page, int len, int count,
+			    uint *bits)
+{
+	/* avoid the unused bits at the end of the last ECC byte */
+	uint nbits = len * 8 + (bch->ecc_bits & ~7);
+	int i, j;
+
+	for (i = 0; i < count; i++) {
+		do {
+			bits[i] = bch_test_rand() % nbits;
+			for (j = 0; j < i && bits[j] != bits[i]; j++)
+				;
+		} while (j < i);
+		bch_test_flip(page, len, bits[i]);
+	}
+}
+
+static int bch_test_one(struct unit_test_state *uts,
+			const struct bch_test_params *params)
+{
+	uint8_t orig[BCH_MAX_LEN], orig_ecc[BCH_MAX_LEN / 8];
+	struct bch_test_page *page;
+	struct bch_control *bch;
+	uint bits[64];
+	int i, j, k, count;
+
+	bch = init_bch(params->m, params->t, 0);
+	ut_assertnonnull(bch);
+	page = malloc(sizeof(*page));
+	ut_assertnonnull(page);
+
+	for (i = 0; i < BCH_TEST_COUNT; i++) {
+		for (j = 0; j < params->len; j++)
+			orig[j] = bch_test_rand();
+		memset(orig_ecc, '\0', bch->ecc_bytes);
+		encode_bch(bch, orig, params->len, orig_ecc);
+
+		memcpy(page->data, orig, params->len);
+		memcpy(page->ecc, orig_ecc, bch->ecc_bytes);
+		count = i % (params->t + 1);
+		bch_test_inject(bch, page, params->len, count, bits);
+
+		/* as done by nand_bch: received and calculated ECC */
+		memset(page->calc_ecc, '\0', bch->ecc_bytes);
+		encode_bch(bch, page->data, params->len, page->calc_ecc);
+		ut_asserteq(count, decode_bch(bch, NULL, params->len, page->ecc,
+					      page->calc_ecc, NULL,
+					      page->errloc));
+
+		/* every flipped bit must be reported exactly once */
+		for (j = 0; j < count; j++) {
+			for (k = 0; k < count; k++) {
+				if (page->errloc[k] == bits[j])
+					break;
+			}
+			ut_assert(k < count);
+		}
+		for (j = 0; j < count; j++)
+			bch_test_flip(page, params->len, page->errloc[j]);
+		ut_assertok(memcmp(orig, page->data, params->len));
+		ut_assertok(memcmp(orig_ecc, page->ecc, bch->ecc_bytes));
+
+		/* data and received ECC only */
+		bch_test_inject(bch, page, params->len, count, bits);
+		ut_asserteq(count, decode_bch(bch, page->data, params->len,
+					      page->ecc, NULL, NULL,
+					      page->errloc));
+
+		/* ECC already XORed by the caller */
+		memset(page->calc_ecc, '\0', bch->ecc_bytes);
+		encode_bch(bch, page->data, params->len, page->calc_ecc);
+		for (j = 0; j < bch->ecc_bytes; j++)
+			page->calc_ecc[j] ^= page->ecc[j];
+		ut_asserteq(count, decode_bch(bch, NULL, params->len, NULL,
+					      page->calc_ecc, NULL,
+					      page->errloc));
+	}
+	free(page);
+	free_bch(bch);
+
+	return 0;
+}
+
+/* Test decoding pages with up to t random bit errors */
+static int lib_test_bch_decode(struct unit_test_state *uts)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bch_test_params); i++)
+		ut_assertok(bch_test_one(uts, &bch_test_params[i]));
+
+	return 0;
+}
+LIB_TEST(lib_test_bch_decode, 0);
+
+/* Test that too many errors are not reported as a clean page */
+static int lib_test_bch_uncorrectable(struct unit_test_state *uts)
+{
+	struct bch_test_page *page;
+	struct bch_control *bch;
+	uint bits[64];
+	int ret;
+
+	bch = init_bch(13, 8, 0);
+	ut_assertnonnull(bch);
+	page = calloc(1, sizeof(*page));
+	ut_assertnonnull(page);
+	encode_bch(bch, page->data, 512, page->ecc);
+	bch_test_inject(bch, page, 512, 2 * bch->t + 1, bits);
+	encode_bch(bch, page->data, 512, page->calc_ecc);
+	ret = decode_bch(bch, NULL, 512, page->ecc, page->calc_ecc, NULL,
+			 page->errloc);
+	ut_assert(ret != 0);
+
+	free(page);
+	free_bch(bch);
+
+	return 0;
+}
+LIB_TEST(lib_test_bch_uncorrectable, 0);
+
+/* Time decoding of clean pages and of pages with t/2 bit errors */
+static int lib_test_bch_speed(struct unit_test_state *uts)
+{
+	const struct bch_test_params *params;
+	struct bch_test_page *page;
+	struct bch_control *bch;
+	ulong clean, errors;
+	ulong start;
+	uint bits[64];
+	int i, j;
+
+	page = malloc(sizeof(*page));
+	ut_assertnonnull(page);
+	for (i = 0; i < ARRAY_SIZE(bch_test_params); i++) {
+		params = &bch_test_params[i];
+		bch = init_bch(params->m, params->t, 0);
+		ut_assertnonnull(bch);
+		for (j = 0; j < params->len; j++)
+			page->data[j] = bch_test_rand();
+		memset(page->calc_ecc, '\0', bch->ecc_bytes);
+		encode_bch(bch, page->data, params->len, page->calc_ecc);
+
+		start = get_timer(0);
+		for (j = 0; j < BCH_SPEED_COUNT; j++)
+			ut_assertok(decode_bch(bch, page->data, params->len,
+					       page->calc_ecc, NULL, NULL,
+					       page->errloc));
+		clean = max(get_timer(start), 1UL);
+
+		memcpy(page->ecc, page->calc_ecc, bch->ecc_bytes);
+		bch_test_inject(bch, page, params->len, params->t / 2, bits);
+		memset(page->calc_ecc, '\0', bch->ecc_bytes);
+		encode_bch(bch, page->data, params->len, page->calc_ecc);
+		start = get_timer(0);
+		for (j = 0; j < BCH_SPEED_COUNT; j++)
+			ut_asserteq(params->t / 2,
+				    decode_bch(bch, NULL, params->len,
+					       page->ecc, page->calc_ecc, NULL,
+					       page->errloc));
+		errors = max(get_timer(start), 1UL);
+
+		printf("bch m=%d t=%d: %lu clean, %lu with %d errors (pages/s)\n",
+		       params->m, params->t, BCH_SPEED_COUNT * 1000 / clean,
+		       BCH_SPEED_COUNT * 1000 / errors, params->t / 2);
+		free_bch(bch);
+	}
+	free(page);
+
+	return 0;
+}
+LIB_TEST(lib_test_bch_speed, 0);
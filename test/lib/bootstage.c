@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for stashing and unstashing bootstage records
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define STASH_SIZE	4096
+
+/* Unstashed records point into the first, so it must not be reused */
+static char stash_buf[STASH_SIZE];
+static char check_buf[STASH_SIZE];
+
+/* Start of the stash, as written by bootstage_stash() */
+struct stash_hdr {
+	u32 version;
+	u32 count;
+	u32 size;
+	u32 magic;
+};
+
+/* Test that stashed records can be read back, as U-Boot does for SPL */
+static int lib_test_bootstage_stash(struct unit_test_state *uts)
+{
+	struct stash_hdr *hdr = (struct stash_hdr *)stash_buf;
+	struct stash_hdr *check = (struct stash_hdr *)check_buf;
+	void *buf = stash_buf;
+	u32 count, size;
+
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "test_stash");
+	ut_assertok(bootstage_stash(buf, STASH_SIZE));
+	count = hdr->count;
+	size = hdr->size;
+	ut_assert(count > 0);
+	ut_assert(size > count * sizeof(*hdr));
+
+	/* Too little space */
+	ut_asserteq(-1, bootstage_stash(check_buf, size - 1));
+
+	/* Reading the stash back adds a copy of each record */
+	ut_assertok(bootstage_unstash(buf, STASH_SIZE));
+	ut_assertok(bootstage_stash(check_buf, STASH_SIZE));
+	ut_asserteq(2 * count, check->count);
+
+	/* Bad magic */
+	check->magic = 0;
+	ut_asserteq(-1, bootstage_unstash(check_buf, STASH_SIZE));
+
+	return 0;
+}
+LIB_TEST(lib_test_bootstage_stash, 0);
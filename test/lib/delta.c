@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for block-level delta updates, from one sandbox host block device
+ * to another
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <delta.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <part.h>
+#include <sandboxblockdev.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define SRC_FILE		"delta_test_a.img"
+#define DST_FILE		"delta_test_b.img"
+#define BLOCK_SIZE		4096
+
+/* More than one chunk, so that ops are split */
+#define BLOCKS			160
+#define IMAGE_SIZE		(BLOCKS * BLOCK_SIZE)
+#define DELTA_ADDR		0x1000000
+
+/* Contents of a block which are different for each @seed */
+static void delta_test_fill(u8 *buf, ulong blk, uint seed)
+{
+	int i;
+
+	for (i = 0; i < BLOCK_SIZE; i++)
+		buf[i] = i * 7 + blk * 13 + (i >> 8) + seed;
+}
+
+/* How the target is made from the source */
+static const struct {
+	enum delta_op_type type;
+	ulong count;
+	ulong arg;
+} delta_test_ops[] = {
+	{ DELTA_OP_COPY, 40, 0 },
+	{ DELTA_OP_DATA, 10 },
+	{ DELTA_OP_COPY, 50, 100 },	/* moved */
+	{ DELTA_OP_ZERO, 20 },
+	{ DELTA_OP_COPY, 40, 50 },
+};
+
+/**
+ * struct delta_test - images and delta for a test
+ *
+ * @src:	Source image, also written to host device 0
+ * @dst:	Target image which the delta should produce
+ * @delta:	The delta, at DELTA_ADDR
+ * @src_desc:	Host device 0, the A slot
+ * @dst_desc:	Host device 1, the B slot
+ * @src_part:	Whole of host device 0
+ * @dst_part:	Whole of host device 1
+ */
+struct delta_test {
+	u8 *src;
+	u8 *dst;
+	struct delta_header *delta;
+	struct blk_desc *src_desc;
+	struct blk_desc *dst_desc;
+	disk_partition_t src_part;
+	disk_partition_t dst_part;
+};
+
+static int delta_test_file(struct unit_test_state *uts, const char *fname,
+			   const u8 *buf)
+{
+	int fd;
+
+	fd = os_open(fname, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(IMAGE_SIZE, os_write(fd, buf, IMAGE_SIZE));
+	os_close(fd);
+
+	return 0;
+}
+
+/* Build the images and the delta, and set up the two slots */
+static int delta_test_setup(struct unit_test_state *uts, struct delta_test *dt)
+{
+	struct delta_header *delta;
+	struct delta_op *op;
+	ulong blk, data_blocks, i, j;
+	u8 *hash, *data;
+	ulong size;
+
+	dt->src = malloc(IMAGE_SIZE);
+	dt->dst = malloc(IMAGE_SIZE);
+	ut_assertnonnull(dt->src);
+	ut_assertnonnull(dt->dst);
+	for (blk = 0; blk < BLOCKS; blk++)
+		delta_test_fill(dt->src + blk * BLOCK_SIZE, blk, 0);
+
+	/* The B slot starts off with an older image */
+	for (blk = 0; blk < BLOCKS; blk++)
+		delta_test_fill(dt->dst + blk * BLOCK_SIZE, blk, 1);
+	ut_assertok(delta_test_file(uts, SRC_FILE, dt->src));
+	ut_assertok(delta_test_file(uts, DST_FILE, dt->dst));
+
+	for (i = 0, blk = 0, data_blocks = 0;
+	     i < ARRAY_SIZE(delta_test_ops); i++) {
+		for (j = 0; j < delta_test_ops[i].count; j++, blk++) {
+			u8 *buf = dt->dst + blk * BLOCK_SIZE;
+
+			switch (delta_test_ops[i].type) {
+			case DELTA_OP_COPY:
+				memcpy(buf, dt->src + (delta_test_ops[i].arg +
+				       j) * BLOCK_SIZE, BLOCK_SIZE);
+				break;
+			case DELTA_OP_ZERO:
+				memset(buf, '\0', BLOCK_SIZE);
+				break;
+			case DELTA_OP_DATA:
+				delta_test_fill(buf, blk, 2);
+				data_blocks++;
+				break;
+			}
+		}
+	}
+	ut_asserteq(BLOCKS, blk);
+
+	size = sizeof(*delta) + sizeof(*op) * ARRAY_SIZE(delta_test_ops) +
+		BLOCKS * DELTA_HASH_SIZE + data_blocks * BLOCK_SIZE;
+	delta = map_sysmem(DELTA_ADDR, size);
+	memset(delta, '\0', size);
+	delta->magic = cpu_to_be32(DELTA_MAGIC);
+	delta->version = cpu_to_be32(DELTA_VERSION);
+	delta->block_size = cpu_to_be32(BLOCK_SIZE);
+	delta->src_blocks = cpu_to_be32(BLOCKS);
+	delta->dst_blocks = cpu_to_be32(BLOCKS);
+	delta->op_count = cpu_to_be32(ARRAY_SIZE(delta_test_ops));
+	delta->size = cpu_to_be32(size);
+	op = (struct delta_op *)(delta + 1);
+	hash = (u8 *)(op + ARRAY_SIZE(delta_test_ops));
+	data = hash + BLOCKS * DELTA_HASH_SIZE;
+	for (i = 0, blk = 0; i < ARRAY_SIZE(delta_test_ops); i++, op++) {
+		op->type = cpu_to_be32(delta_test_ops[i].type);
+		op->count = cpu_to_be32(delta_test_ops[i].count);
+		op->arg = cpu_to_be32(delta_test_ops[i].arg);
+		for (j = 0; j < delta_test_ops[i].count; j++, blk++) {
+			if (delta_test_ops[i].type != DELTA_OP_DATA)
+				continue;
+			memcpy(data, dt->dst + blk * BLOCK_SIZE, BLOCK_SIZE);
+			data += BLOCK_SIZE;
+		}
+	}
+	for (blk = 0; blk < BLOCKS; blk++) {
+		sha256_csum_wd(dt->dst + blk * BLOCK_SIZE, BLOCK_SIZE,
+			       hash + blk * DELTA_HASH_SIZE, CHUNKSZ_SHA256);
+	}
+	sha256_csum_wd((u8 *)(delta + 1), size - sizeof(*delta),
+		       delta->body_hash, CHUNKSZ_SHA256);
+	ut_assertok(delta_check(delta, size));
+	dt->delta = delta;
+
+	ut_assertok(host_dev_bind(0, SRC_FILE));
+	ut_assertok(host_dev_bind(1, DST_FILE));
+	ut_asserteq(0, blk_get_device_part_str("host", "0", &dt->src_desc,
+					       &dt->src_part, 1));
+	ut_asserteq(0, blk_get_device_part_str("host", "1", &dt->dst_desc,
+					       &dt->dst_part, 1));
+
+	return 0;
+}
+
+static int delta_test_cleanup(struct unit_test_state *uts,
+			      struct delta_test *dt)
+{
+	ut_assertok(host_dev_bind(0, NULL));
+	ut_assertok(host_dev_bind(1, NULL));
+	ut_assertok(os_unlink(SRC_FILE));
+	ut_assertok(os_unlink(DST_FILE));
+	unmap_sysmem(dt->delta);
+	free(dt->src);
+	free(dt->dst);
+
+	return 0;
+}
+
+/* Check that the B slot holds the target image */
+static int delta_test_check_dst(struct unit_test_state *uts,
+				struct delta_test *dt)
+{
+	u8 *buf;
+
+	buf = malloc(IMAGE_SIZE);
+	ut_assertnonnull(buf);
+	ut_asserteq(IMAGE_SIZE / dt->dst_desc->blksz,
+		    blk_dread(dt->dst_desc, 0, IMAGE_SIZE / dt->dst_desc->blksz,
+			      buf));
+	ut_assertok(memcmp(dt->dst, buf, IMAGE_SIZE));
+	free(buf);
+
+	return 0;
+}
+
+/* Write blocks of the target image to the B slot */
+static int delta_test_write(struct unit_test_state *uts, struct delta_test *dt,
+			    const u8 *buf, ulong blk, ulong count)
+{
+	ulong per_block = BLOCK_SIZE / dt->dst_desc->blksz;
+
+	ut_asserteq(count * per_block,
+		    blk_dwrite(dt->dst_desc, blk * per_block,
+			       count * per_block, buf));
+
+	return 0;
+}
+
+/* Test applying a delta, and applying it again */
+static int lib_test_delta_apply(struct unit_test_state *uts)
+{
+	struct delta_stats stats;
+	struct delta_test dt;
+
+	ut_assertok(delta_test_setup(uts, &dt));
+	ut_assertok(delta_apply(dt.delta, dt.src_desc, &dt.src_part,
+				dt.dst_desc, &dt.dst_part, &stats));
+	ut_asserteq(130, stats.copied);
+	ut_asserteq(20, stats.zeroed);
+	ut_asserteq(10, stats.data);
+	ut_asserteq(0, stats.skipped);
+	ut_assertok(delta_test_check_dst(uts, &dt));
+
+	/* Nothing is written the second time */
+	ut_assertok(delta_apply(dt.delta, dt.src_desc, &dt.src_part,
+				dt.dst_desc, &dt.dst_part, &stats));
+	ut_asserteq(0, stats.copied + stats.zeroed + stats.data);
+	ut_asserteq(BLOCKS, stats.skipped);
+
+	/* The command does the same */
+	ut_assertok(run_command("delta check 1000000", 0));
+	ut_assertok(run_command("delta apply 1000000 host 0 host 1", 0));
+	ut_asserteq(1, run_command("delta apply 1000000 host 0 host 0", 0));
+	ut_assertok(delta_test_check_dst(uts, &dt));
+	ut_assertok(delta_test_cleanup(uts, &dt));
+
+	return 0;
+}
+LIB_TEST(lib_test_delta_apply, 0);
+
+/* Test finishing an update which was interrupted */
+static int lib_test_delta_resume(struct unit_test_state *uts)
+{
+	struct delta_stats stats;
+	struct delta_test dt;
+	u8 buf[BLOCK_SIZE];
+
+	ut_assertok(delta_test_setup(uts, &dt));
+
+	/* Power was lost after writing the first 70 blocks */
+	ut_assertok(delta_test_write(uts, &dt, dt.dst, 0, 70));
+	ut_assertok(delta_apply(dt.delta, dt.src_desc, &dt.src_part,
+				dt.dst_desc, &dt.dst_part, &stats));
+	ut_asserteq(70, stats.skipped);
+	ut_asserteq(BLOCKS - 70, stats.copied + stats.zeroed + stats.data);
+	ut_asserteq(20, stats.zeroed);
+	ut_assertok(delta_test_check_dst(uts, &dt));
+
+	/* The last block written before the power was lost is torn */
+	delta_test_fill(buf, 0, 3);
+	ut_assertok(delta_test_write(uts, &dt, buf, 44, 1));
+	ut_assertok(delta_apply(dt.delta, dt.src_desc, &dt.src_part,
+				dt.dst_desc, &dt.dst_part, &stats));
+	ut_asserteq(44, stats.skipped);
+	ut_asserteq(6, stats.data);
+	ut_assertok(delta_test_check_dst(uts, &dt));
+	ut_assertok(delta_test_cleanup(uts, &dt));
+
+	return 0;
+}
+LIB_TEST(lib_test_delta_resume, 0);
+
+/* Test deltas which do not match, and slots which do not fit */
+static int lib_test_delta_errors(struct unit_test_state *uts)
+{
+	struct delta_header *delta;
+	struct delta_stats stats;
+	struct delta_test dt;
+	ulong size;
+	u8 buf[BLOCK_SIZE];
+
+	ut_assertok(delta_test_setup(uts, &dt));
+	delta = dt.delta;
+	size = be32_to_cpu(delta->size);
+
+	ut_asserteq(-E2BIG, delta_check(delta, size - 1));
+	delta->magic = cpu_to_be32(DELTA_MAGIC + 1);
+	ut_asserteq(-ENOEXEC, delta_check(delta, size));
+	delta->magic = cpu_to_be32(DELTA_MAGIC);
+	delta->version = cpu_to_be32(DELTA_VERSION + 1);
+	ut_asserteq(-EPROTONOSUPPORT, delta_check(delta, size));
+	delta->version = cpu_to_be32(DELTA_VERSION);
+	delta->block_size = cpu_to_be32(BLOCK_SIZE + 1);
+	ut_asserteq(-EINVAL, delta_check(delta, size));
+	delta->block_size = cpu_to_be32(BLOCK_SIZE);
+	((u8 *)delta)[size - 1] ^= 1;
+	ut_asserteq(-EBADMSG, delta_check(delta, size));
+	((u8 *)delta)[size - 1] ^= 1;
+	ut_asserteq(1, run_command("delta check 1000001", 0));
+
+	/* The slots are the same */
+	ut_asserteq(-EINVAL, delta_apply(delta, dt.src_desc, &dt.src_part,
+					 dt.src_desc, &dt.src_part, &stats));
+
+	/* The target slot is too small */
+	dt.dst_part.size--;
+	ut_asserteq(-EINVAL, delta_apply(delta, dt.src_desc, &dt.src_part,
+					 dt.dst_desc, &dt.dst_part, &stats));
+	dt.dst_part.size++;
+
+	/*
+	 * The A slot holds a different image. The blocks before the one
+	 * taken from the changed source block are written.
+	 */
+	delta_test_fill(buf, 0, 3);
+	ut_asserteq(BLOCK_SIZE / dt.src_desc->blksz,
+		    blk_dwrite(dt.src_desc, 120 * BLOCK_SIZE /
+			       dt.src_desc->blksz, BLOCK_SIZE /
+			       dt.src_desc->blksz, buf));
+	ut_asserteq(-EILSEQ, delta_apply(delta, dt.src_desc, &dt.src_part,
+					 dt.dst_desc, &dt.dst_part, &stats));
+	ut_asserteq(40 + 20, stats.copied);
+	ut_asserteq(10, stats.data);
+	ut_assertok(delta_test_cleanup(uts, &dt));
+
+	return 0;
+}
+LIB_TEST(lib_test_delta_errors, 0);
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for DFU writes
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dfu.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+/* Size of each USB packet, and of the DFU buffer */
+#define DFU_TEST_PACKET		SZ_4K
+#define DFU_TEST_BUF_PACKETS	4
+#define DFU_TEST_BUF_SIZE	(DFU_TEST_BUF_PACKETS * DFU_TEST_PACKET)
+#define DFU_TEST_BUF_ENV	"0x4000"
+
+/* Total size of the transfer */
+#define DFU_TEST_PACKETS	64
+#define DFU_TEST_BUFS		(DFU_TEST_PACKETS / DFU_TEST_BUF_PACKETS)
+#define DFU_TEST_SIZE		(DFU_TEST_PACKETS * DFU_TEST_PACKET)
+
+/* Time taken to receive each packet and to write each buffer */
+#define DFU_TEST_USB_US		500
+#define DFU_TEST_WRITE_US	2000
+
+/**
+ * struct fake_medium - storage which takes a while to write
+ *
+ * @mem:	Contents of the storage
+ * @writes:	Number of writes so far
+ */
+struct fake_medium {
+	u8 *mem;
+	int writes;
+};
+
+static int fake_write_medium(struct dfu_entity *dfu, u64 offset, void *buf,
+			     long *len)
+{
+	struct fake_medium *fm = dfu->dev_private;
+	ulong start = timer_get_us();
+
+	/* Poll until the write is done, as a real driver would */
+	while (timer_get_us() - start < DFU_TEST_WRITE_US)
+		udelay(100);
+	memcpy(fm->mem + offset, buf, *len);
+	fm->writes++;
+
+	return 0;
+}
+
+/* Set up a new entity, as the dfu command does each time it runs */
+static void dfu_test_entity(struct dfu_entity *dfu, const char *name,
+			    struct fake_medium *fm)
+{
+	memset(dfu, '\0', sizeof(*dfu));
+	strlcpy(dfu->name, name, sizeof(dfu->name));
+	dfu->dev_type = DFU_DEV_MMC;
+	dfu->layout = DFU_RAW_ADDR;
+	dfu->dev_private = fm;
+	dfu->write_medium = fake_write_medium;
+	fm->writes = 0;
+}
+
+/* Send packets from the host, giving way to the medium in between */
+static int dfu_test_send(struct unit_test_state *uts, struct dfu_entity *dfu,
+			 u8 *data, int packets)
+{
+	ulong start;
+	int i;
+
+	for (i = 0; i < packets; i++) {
+		start = timer_get_us();
+		while (timer_get_us() - start < DFU_TEST_USB_US)
+			dfu_write_poll();
+		ut_assertok(dfu_write(dfu, data + i * DFU_TEST_PACKET,
+				      DFU_TEST_PACKET, i));
+	}
+
+	return 0;
+}
+
+static int dfu_test_setup(struct unit_test_state *uts, u8 **datap,
+			  struct fake_medium *fm)
+{
+	u8 *data;
+	int i;
+
+	data = malloc(DFU_TEST_SIZE);
+	fm->mem = calloc(1, DFU_TEST_SIZE);
+	ut_assertnonnull(data);
+	ut_assertnonnull(fm->mem);
+	for (i = 0; i < DFU_TEST_SIZE; i++)
+		data[i] = i * 13 + (i >> 10);
+	*datap = data;
+
+	dfu_free_buf();
+	setenv("dfu_bufsiz", DFU_TEST_BUF_ENV);
+
+	return 0;
+}
+
+static void dfu_test_teardown(u8 *data, struct fake_medium *fm)
+{
+	setenv("dfu_bufsiz", NULL);
+	dfu_free_buf();
+	free(fm->mem);
+	free(data);
+}
+
+/* Test that writing to the medium overlaps with receiving data */
+static int lib_test_dfu_write_speed(struct unit_test_state *uts)
+{
+	struct fake_medium fm;
+	struct dfu_entity dfu;
+	ulong start, elapsed, serial;
+	u8 *data;
+
+	ut_assertok(dfu_test_setup(uts, &data, &fm));
+	dfu_test_entity(&dfu, "speed", &fm);
+
+	start = get_timer(0);
+	ut_assertok(dfu_test_send(uts, &dfu, data, DFU_TEST_PACKETS));
+	ut_assertok(dfu_flush(&dfu, NULL, 0, DFU_TEST_PACKETS));
+	elapsed = max(get_timer(start), 1UL);
+
+	serial = (DFU_TEST_PACKETS * DFU_TEST_USB_US +
+		  DFU_TEST_BUFS * DFU_TEST_WRITE_US) / 1000;
+	printf("\nDFU: %d KiB in %lu ms, %lu KiB/s (%lu KiB/s one at a time)\n",
+	       DFU_TEST_SIZE >> 10, elapsed, (DFU_TEST_SIZE >> 10) * 1000 /
+	       elapsed, (DFU_TEST_SIZE >> 10) * 1000 / serial);
+	ut_asserteq(DFU_TEST_BUFS, fm.writes);
+	ut_assertok(memcmp(data, fm.mem, DFU_TEST_SIZE));
+	ut_assert(elapsed * 4 < serial * 3);
+	dfu_test_teardown(data, &fm);
+
+	return 0;
+}
+LIB_TEST(lib_test_dfu_write_speed, 0);
+
+/* Test that an interrupted transfer skips what was already written */
+static int lib_test_dfu_write_resume(struct unit_test_state *uts)
+{
+	const int sent = 11 * DFU_TEST_BUF_PACKETS;
+	struct fake_medium fm;
+	struct dfu_entity dfu;
+	u8 *data;
+
+	ut_assertok(dfu_test_setup(uts, &data, &fm));
+
+	/* Stop part-way through, then start again from the beginning */
+	dfu_test_entity(&dfu, "resume", &fm);
+	ut_assertok(dfu_test_send(uts, &dfu, data, sent));
+	dfu_write_transaction_cleanup(&dfu);
+	ut_asserteq(11, fm.writes);
+
+	dfu_test_entity(&dfu, "resume", &fm);
+	ut_assertok(dfu_test_send(uts, &dfu, data, DFU_TEST_PACKETS));
+	ut_assertok(dfu_flush(&dfu, NULL, 0, DFU_TEST_PACKETS));
+	ut_asserteq(DFU_TEST_BUFS - 11, fm.writes);
+	ut_assertok(memcmp(data, fm.mem, DFU_TEST_SIZE));
+
+	/* A completed transfer is written in full next time */
+	dfu_test_entity(&dfu, "resume", &fm);
+	ut_assertok(dfu_test_send(uts, &dfu, data, sent));
+	dfu_write_transaction_cleanup(&dfu);
+	ut_asserteq(11, fm.writes);
+
+	/* Different data is written from the first buffer which differs */
+	data[3 * DFU_TEST_BUF_SIZE + 5] ^= 0xff;
+	dfu_test_entity(&dfu, "resume", &fm);
+	ut_assertok(dfu_test_send(uts, &dfu, data, DFU_TEST_PACKETS));
+	ut_assertok(dfu_flush(&dfu, NULL, 0, DFU_TEST_PACKETS));
+	ut_asserteq(DFU_TEST_BUFS - 3, fm.writes);
+	ut_assertok(memcmp(data, fm.mem, DFU_TEST_SIZE));
+
+	/* Another entity does not use the record */
+	dfu_test_entity(&dfu, "resume", &fm);
+	ut_assertok(dfu_test_send(uts, &dfu, data, sent));
+	dfu_write_transaction_cleanup(&dfu);
+	dfu_test_entity(&dfu, "other", &fm);
+	ut_assertok(dfu_test_send(uts, &dfu, data, DFU_TEST_PACKETS));
+	ut_assertok(dfu_flush(&dfu, NULL, 0, DFU_TEST_PACKETS));
+	ut_asserteq(DFU_TEST_BUFS, fm.writes);
+	dfu_test_teardown(data, &fm);
+
+	return 0;
+}
+LIB_TEST(lib_test_dfu_write_resume, 0);
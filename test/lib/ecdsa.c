@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for ECDSA P-256 signature verification
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <image.h>
+#include <malloc.h>
+#include <libfdt.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/ecdsa.h>
+#include <u-boot/sha256.h>
+
+/* Number of signature checks to time in the speed test */
+#define ECDSA_SPEED_COUNT	20
+
+static const char ecdsa_test_msg[] = "u-boot";
+
+/* P-256 test key and signature (r, s) of "u-boot" */
+static const uint8_t ecdsa_pub_x[] = {
+	0xbd, 0x11, 0xce, 0x76, 0x63, 0x52, 0xdc, 0x15,
+	0x66, 0x17, 0xe3, 0x77, 0xf6, 0x45, 0x78, 0x9f,
+	0xea, 0xe2, 0xf8, 0xf2, 0x39, 0xa0, 0x3a, 0xff,
+	0x53, 0x23, 0x8e, 0x92, 0x17, 0xe7, 0xcc, 0x8e,
+};
+
+static const uint8_t ecdsa_pub_y[] = {
+	0x87, 0x15, 0x37, 0x35, 0x4a, 0x17, 0x5a, 0x00,
+	0xcb, 0x34, 0xd5, 0xd4, 0x6e, 0x9c, 0x20, 0xbe,
+	0xad, 0x22, 0xcd, 0xb8, 0xc4, 0x57, 0x31, 0xdd,
+	0x3e, 0xf7, 0x2d, 0x08, 0x01, 0x5c, 0x6f, 0xbc,
+};
+
+static const uint8_t ecdsa_sig[] = {
+	0xbf, 0x5c, 0xe7, 0x8c, 0xf0, 0x12, 0xa0, 0xa2,
+	0x79, 0xfd, 0xc9, 0x50, 0x8e, 0x34, 0x6c, 0x01,
+	0x17, 0x43, 0x41, 0x5c, 0xeb, 0x02, 0xe5, 0x13,
+	0x96, 0xb6, 0x1f, 0x5a, 0xff, 0x16, 0xe4, 0x95,
+	0x50, 0x8e, 0x16, 0xc4, 0xbe, 0xfe, 0x81, 0x34,
+	0xa2, 0x76, 0x38, 0x87, 0x30, 0x25, 0x8f, 0x05,
+	0x20, 0xcf, 0x8c, 0x95, 0x81, 0x59, 0x19, 0x83,
+	0x3e, 0xd5, 0x63, 0x34, 0x5f, 0x22, 0x07, 0xbd,
+};
+
+/* Test checking a signature against a hash */
+static int lib_test_ecdsa_hash(struct unit_test_state *uts)
+{
+	uint8_t hash[SHA256_SUM_LEN];
+	uint8_t sig[ECDSA_P256_SIG_BYTES];
+	uint8_t bad[ECDSA_P256_BYTES];
+
+	sha256_csum_wd((const uchar *)ecdsa_test_msg, strlen(ecdsa_test_msg),
+		       hash, 0);
+	memcpy(sig, ecdsa_sig, sizeof(sig));
+	ut_assertok(ecdsa_p256_verify_hash(ecdsa_pub_x, ecdsa_pub_y, hash,
+					   sizeof(hash), sig));
+
+	/* Corrupt r, then s */
+	sig[3] ^= 0x10;
+	ut_asserteq(-EACCES, ecdsa_p256_verify_hash(ecdsa_pub_x, ecdsa_pub_y,
+						    hash, sizeof(hash), sig));
+	memcpy(sig, ecdsa_sig, sizeof(sig));
+	sig[ECDSA_P256_SIG_BYTES - 1] ^= 0x01;
+	ut_asserteq(-EACCES, ecdsa_p256_verify_hash(ecdsa_pub_x, ecdsa_pub_y,
+						    hash, sizeof(hash), sig));
+
+	/* r and s must be in the range [1, n - 1] */
+	memset(sig, '\0', ECDSA_P256_BYTES);
+	memcpy(sig + ECDSA_P256_BYTES, ecdsa_sig + ECDSA_P256_BYTES,
+	       ECDSA_P256_BYTES);
+	ut_asserteq(-EACCES, ecdsa_p256_verify_hash(ecdsa_pub_x, ecdsa_pub_y,
+						    hash, sizeof(hash), sig));
+	memset(sig, 0xff, ECDSA_P256_BYTES);
+	ut_asserteq(-EACCES, ecdsa_p256_verify_hash(ecdsa_pub_x, ecdsa_pub_y,
+						    hash, sizeof(hash), sig));
+
+	/* A different hash must not verify */
+	memcpy(sig, ecdsa_sig, sizeof(sig));
+	hash[0] ^= 1;
+	ut_asserteq(-EACCES, ecdsa_p256_verify_hash(ecdsa_pub_x, ecdsa_pub_y,
+						    hash, sizeof(hash), sig));
+	hash[0] ^= 1;
+
+	/* The public key must be on the curve */
+	memcpy(bad, ecdsa_pub_y, sizeof(bad));
+	bad[ECDSA_P256_BYTES - 1] ^= 1;
+	ut_asserteq(-EINVAL, ecdsa_p256_verify_hash(ecdsa_pub_x, bad, hash,
+						    sizeof(hash), sig));
+
+	return 0;
+}
+LIB_TEST(lib_test_ecdsa_hash, 0);
+
+/**
+ * ecdsa_test_setup() - Create an FDT holding a public key
+ *
+ * This mirrors what mkimage adds to the control FDT with the -K option.
+ *
+ * @info:	Returns signing info ready for ecdsa_verify()
+ * @return pointer to the allocated FDT, or NULL on error
+ */
+static void *ecdsa_test_setup(struct image_sign_info *info)
+{
+	const int size = 1024;
+	int sig_node, node;
+	void *blob;
+
+	blob = malloc(size);
+	if (!blob)
+		return NULL;
+	if (fdt_create_empty_tree(blob, size))
+		goto err;
+	sig_node = fdt_add_subnode(blob, 0, FIT_SIG_NODENAME);
+	if (sig_node < 0)
+		goto err;
+	node = fdt_add_subnode(blob, sig_node, "key-dev");
+	if (node < 0 ||
+	    fdt_setprop_string(blob, node, "ecdsa,curve", "prime256v1") ||
+	    fdt_setprop(blob, node, "ecdsa,x-point", ecdsa_pub_x,
+			sizeof(ecdsa_pub_x)) ||
+	    fdt_setprop(blob, node, "ecdsa,y-point", ecdsa_pub_y,
+			sizeof(ecdsa_pub_y)))
+		goto err;
+
+	memset(info, '\0', sizeof(*info));
+	info->keyname = "dev";
+	info->algo = image_get_sig_algo("sha256,ecdsa256");
+	info->fdt_blob = blob;
+	info->required_keynode = -1;
+	if (!info->algo)
+		goto err;
+
+	return blob;
+err:
+	free(blob);
+	return NULL;
+}
+
+/* Test checking a signature using a key in the FDT, as verified boot does */
+static int lib_test_ecdsa_verify(struct unit_test_state *uts)
+{
+	uint8_t sig[ECDSA_P256_SIG_BYTES];
+	struct image_region region;
+	struct image_sign_info info;
+	void *blob;
+
+	blob = ecdsa_test_setup(&info);
+	ut_assertnonnull(blob);
+	region.data = ecdsa_test_msg;
+	region.size = strlen(ecdsa_test_msg);
+
+	memcpy(sig, ecdsa_sig, sizeof(sig));
+	ut_assertok(ecdsa_verify(&info, &region, 1, sig, sizeof(sig)));
+	ut_asserteq(-EINVAL, ecdsa_verify(&info, &region, 1, sig,
+					  sizeof(sig) - 1));
+	region.size--;
+	ut_assert(ecdsa_verify(&info, &region, 1, sig, sizeof(sig)) != 0);
+
+	free(blob);
+
+	return 0;
+}
+LIB_TEST(lib_test_ecdsa_verify, 0);
+
+/* Time signature checks, as done several times for each verified boot */
+static int lib_test_ecdsa_speed(struct unit_test_state *uts)
+{
+	uint8_t sig[ECDSA_P256_SIG_BYTES];
+	struct image_region region;
+	struct image_sign_info info;
+	ulong start, elapsed;
+	void *blob;
+	int i;
+
+	blob = ecdsa_test_setup(&info);
+	ut_assertnonnull(blob);
+	region.data = ecdsa_test_msg;
+	region.size = strlen(ecdsa_test_msg);
+	memcpy(sig, ecdsa_sig, sizeof(sig));
+
+	start = get_timer(0);
+	for (i = 0; i < ECDSA_SPEED_COUNT; i++)
+		ut_assertok(ecdsa_verify(&info, &region, 1, sig, sizeof(sig)));
+	elapsed = max(get_timer(start), 1UL);
+	printf("%s: %lu signature checks/s\n", info.algo->name,
+	       ECDSA_SPEED_COUNT * 1000 / elapsed);
+	free(blob);
+
+	return 0;
+}
+LIB_TEST(lib_test_ecdsa_speed, 0);
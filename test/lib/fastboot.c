@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for the fastboot protocol, using the sandbox USB device controller
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <fastboot.h>
+#include <g_dnl.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <mmc.h>
+#include <part.h>
+#include <asm/test.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+/* Configuration value of the download gadget */
+#define FB_TEST_CONFIG		1
+
+/* Size of each bulk transfer from the host, as the fastboot tool uses */
+#define FB_TEST_XFER		SZ_16K
+
+/* Size of the download used to measure throughput */
+#define FB_TEST_SIZE		(16 * SZ_1M)
+
+/* Partition on the sandbox MMC card used to test flashing in parts */
+#define FB_TEST_BLKSZ		512
+#define FB_TEST_PART_NAME	"test"
+#define FB_TEST_PART_START	64
+#define FB_TEST_PART_SIZE	(192 * SZ_1K)
+#define FB_TEST_PART_UUID	"bd68ac3c-1a94-4ef1-a3c1-6f2d0e3a6b00"
+#define FB_TEST_DISK_GUID	"e7bd8eb2-5c3f-4a24-9a5b-0d2f3e1f6c01"
+
+static int fb_test_connect(struct unit_test_state *uts)
+{
+	ut_assertok(sandbox_udc_connect(FB_TEST_CONFIG));
+
+	return 0;
+}
+
+/*
+ * Register the fastboot gadget, run a test and unregister it again, even
+ * if the test fails, so that later tests can use the gadget
+ */
+static int fb_test_run(struct unit_test_state *uts,
+		       int (*test)(struct unit_test_state *uts))
+{
+	int ret;
+
+	ut_assertok(g_dnl_register("usb_dnl_fastboot"));
+	ret = fb_test_connect(uts);
+	if (!ret)
+		ret = test(uts);
+	g_dnl_unregister();
+
+	return ret;
+}
+
+/* Send a command and check the response */
+static int fb_test_cmd(struct unit_test_state *uts, const char *cmd,
+		       const char *expect)
+{
+	char resp[FASTBOOT_RESPONSE_LEN];
+	int len;
+
+	ut_asserteq(strlen(cmd), sandbox_udc_bulk_out(cmd, strlen(cmd)));
+	len = sandbox_udc_bulk_in(resp, sizeof(resp) - 1);
+	ut_assert(len >= 0);
+	resp[len] = '\0';
+	ut_asserteq_str(expect, resp);
+
+	return 0;
+}
+
+/* Test data for each offset of a download, different for each @seed */
+static u8 fb_test_byte(uint offset, uint seed)
+{
+	return offset * 7 + (offset >> 9) + seed;
+}
+
+/*
+ * Download an image, sending it in bulk transfers of up to @xfer bytes,
+ * and check that it arrives intact
+ */
+static int fb_test_download(struct unit_test_state *uts, uint size,
+			    uint xfer, uint seed)
+{
+	char cmd[32], expect[16];
+	uint done, len, i;
+	u8 *buf, *data;
+	int ret;
+
+	buf = malloc(xfer);
+	ut_assertnonnull(buf);
+	snprintf(cmd, sizeof(cmd), "download:%08x", size);
+	snprintf(expect, sizeof(expect), "DATA%08x", size);
+	ut_assertok(fb_test_cmd(uts, cmd, expect));
+	for (done = 0; done < size; done += ret) {
+		len = min(xfer, size - done);
+		for (i = 0; i < len; i++)
+			buf[i] = fb_test_byte(done + i, seed);
+		ret = sandbox_udc_bulk_out(buf, len);
+		ut_assert(ret > 0);
+	}
+	free(buf);
+	ut_asserteq(4, sandbox_udc_bulk_in(expect, sizeof(expect) - 1));
+	ut_assertok(memcmp("OKAY", expect, 4));
+
+	data = map_sysmem(CONFIG_FASTBOOT_BUF_ADDR, size);
+	for (i = 0; i < size; i++) {
+		if (data[i] != fb_test_byte(i, seed))
+			break;
+	}
+	ut_asserteq(size, i);
+
+	return 0;
+}
+
+/* Test downloading an image and report the throughput */
+static int fb_test_download_speed(struct unit_test_state *uts)
+{
+	struct sandbox_udc_stats before, after;
+	ulong start, elapsed_us;
+	uint waits;
+	u64 bus_ns;
+
+	ut_assertok(fb_test_cmd(uts, "getvar:version", "OKAY0.4"));
+	ut_assertok(fb_test_cmd(uts, "getvar:max-download-size",
+				"OKAY0x02000000"));
+
+	sandbox_udc_get_stats(&before);
+	start = timer_get_us();
+	ut_assertok(fb_test_download(uts, FB_TEST_SIZE, FB_TEST_XFER, 0));
+	elapsed_us = max(timer_get_us() - start, 1UL);
+	sandbox_udc_get_stats(&after);
+	bus_ns = after.busy_ns + after.wait_ns - before.busy_ns -
+		before.wait_ns;
+	waits = after.waits - before.waits;
+	printf("fastboot: %d MiB in %llu us of bus time (%u waits), %llu MiB/s; %lu MiB/s on the host\n",
+	       FB_TEST_SIZE >> 20, bus_ns / 1000, waits,
+	       (u64)FB_TEST_SIZE * 1000000000 / bus_ns >> 20,
+	       (ulong)((u64)FB_TEST_SIZE * 1000000 / elapsed_us >> 20));
+
+	/*
+	 * The host waits while the download command is handled and again
+	 * until the first data requests are queued. With several requests
+	 * queued it never has to wait after that.
+	 */
+	ut_asserteq(2, waits);
+
+	return 0;
+}
+
+static int lib_test_fastboot_download(struct unit_test_state *uts)
+{
+	return fb_test_run(uts, fb_test_download_speed);
+}
+LIB_TEST(lib_test_fastboot_download, 0);
+
+/* Test downloads which cannot all go straight into the buffer */
+static int fb_test_download_odd(struct unit_test_state *uts)
+{
+	/* The host sends transfers which end with a short packet */
+	ut_assertok(fb_test_download(uts, SZ_1M + 100, 5000, 1));
+
+	/* The end of this would run past the buffer if rounded up */
+	ut_assertok(fb_test_download(uts, CONFIG_FASTBOOT_BUF_SIZE - 100,
+				     FB_TEST_XFER, 2));
+
+	/* A small download followed by another command */
+	ut_assertok(fb_test_download(uts, 100, FB_TEST_XFER, 3));
+	ut_assertok(fb_test_cmd(uts, "getvar:version", "OKAY0.4"));
+
+	return 0;
+}
+
+static int lib_test_fastboot_download_odd(struct unit_test_state *uts)
+{
+	return fb_test_run(uts, fb_test_download_odd);
+}
+LIB_TEST(lib_test_fastboot_download_odd, 0);
+
+/* Test commands which fail */
+static int fb_test_errors(struct unit_test_state *uts)
+{
+	ut_assertok(fb_test_cmd(uts, "download:0", "FAILdata invalid size"));
+	ut_assertok(fb_test_cmd(uts, "download:02000001",
+				"FAILdata too large"));
+	ut_assertok(fb_test_cmd(uts, "fred", "FAILunknown command"));
+	ut_assertok(fb_test_cmd(uts, "flash:boot:", "FAILinvalid offset"));
+	ut_assertok(fb_test_cmd(uts, "flash:boot:10x", "FAILinvalid offset"));
+	ut_assertok(fb_test_cmd(uts, "flash:gpt:1000",
+				"FAILoffset not supported for this image"));
+	ut_assertok(fb_test_cmd(uts, "getvar:version", "OKAY0.4"));
+
+	return 0;
+}
+
+static int lib_test_fastboot_errors(struct unit_test_state *uts)
+{
+	return fb_test_run(uts, fb_test_errors);
+}
+LIB_TEST(lib_test_fastboot_errors, 0);
+
+/* Check that part of the test partition holds the data for @seed */
+static int fb_test_check_part(struct unit_test_state *uts,
+			      struct blk_desc *dev_desc, uint offset,
+			      uint size, uint seed)
+{
+	uint blkcnt = DIV_ROUND_UP(size, FB_TEST_BLKSZ);
+	u8 *data;
+	uint i;
+
+	data = malloc(blkcnt * FB_TEST_BLKSZ);
+	ut_assertnonnull(data);
+	ut_asserteq(blkcnt, blk_dread(dev_desc, FB_TEST_PART_START +
+				      offset / FB_TEST_BLKSZ, blkcnt, data));
+	for (i = 0; i < size; i++) {
+		if (data[i] != fb_test_byte(i, seed))
+			break;
+	}
+	free(data);
+	ut_asserteq(size, i);
+
+	return 0;
+}
+
+/* Test flashing an image in parts, at offsets within a partition */
+static int fb_test_flash_parts(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	char cmd[32];
+
+	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	ut_assertnonnull(dev_desc);
+
+	/* The first part, written at the start of the partition */
+	ut_assertok(fb_test_download(uts, FB_TEST_PART_SIZE, FB_TEST_XFER,
+				     4));
+	ut_assertok(fb_test_cmd(uts, "flash:" FB_TEST_PART_NAME, "OKAY"));
+
+	/* The second part ends with a partial block */
+	ut_assertok(fb_test_download(uts, FB_TEST_PART_SIZE - 100,
+				     FB_TEST_XFER, 5));
+	snprintf(cmd, sizeof(cmd), "flash:%s:%x", FB_TEST_PART_NAME,
+		 FB_TEST_PART_SIZE);
+	ut_assertok(fb_test_cmd(uts, cmd, "OKAY"));
+
+	ut_assertok(fb_test_check_part(uts, dev_desc, 0, FB_TEST_PART_SIZE,
+				       4));
+	ut_assertok(fb_test_check_part(uts, dev_desc, FB_TEST_PART_SIZE,
+				       FB_TEST_PART_SIZE - 100, 5));
+
+	/* A part must start on a block and fit in the partition */
+	ut_assertok(fb_test_cmd(uts, "flash:" FB_TEST_PART_NAME ":100",
+				"FAILoffset not aligned to a block"));
+	snprintf(cmd, sizeof(cmd), "flash:%s:%x", FB_TEST_PART_NAME,
+		 FB_TEST_PART_SIZE * 2);
+	ut_assertok(fb_test_cmd(uts, cmd, "FAILtoo large for partition"));
+
+	/* The earlier parts are left alone */
+	ut_assertok(fb_test_check_part(uts, dev_desc, FB_TEST_PART_SIZE,
+				       FB_TEST_PART_SIZE - 100, 5));
+
+	return 0;
+}
+
+static int lib_test_fastboot_flash_parts(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	disk_partition_t part;
+	struct udevice *dev;
+
+	if (uclass_get_device(UCLASS_MMC, CONFIG_FASTBOOT_FLASH_MMC_DEV,
+			      &dev)) {
+		printf("Skipping: no MMC device\n");
+		return 0;
+	}
+
+	/* Give the card a single partition, two download parts long */
+	memset(&part, '\0', sizeof(part));
+	part.start = FB_TEST_PART_START;
+	part.size = FB_TEST_PART_SIZE * 2 / FB_TEST_BLKSZ;
+	part.blksz = FB_TEST_BLKSZ;
+	strcpy((char *)part.name, FB_TEST_PART_NAME);
+#ifdef CONFIG_PARTITION_UUIDS
+	strcpy(part.uuid, FB_TEST_PART_UUID);
+#endif
+	dev_desc = mmc_get_blk_desc(mmc_get_mmc_dev(dev));
+	ut_assertok(gpt_restore(dev_desc, FB_TEST_DISK_GUID, &part, 1));
+	part_init(dev_desc);
+
+	return fb_test_run(uts, fb_test_flash_parts);
+}
+LIB_TEST(lib_test_fastboot_flash_parts, 0);
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for the fast memory test
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+#define MEMTEST_SIZE		(4 * SZ_1M)
+
+/* Number of times each word is written or read by memtest_run() */
+#define MEMTEST_ACCESSES	19
+
+/* Test that good memory passes, and show the speed of both memory tests */
+static int lib_test_memtest_run(struct unit_test_state *uts)
+{
+	struct memtest_result res;
+	ulong start, fast, slow;
+	char cmd[60];
+	ulong addr;
+	void *buf;
+
+	buf = memalign(SZ_4K, MEMTEST_SIZE);
+	ut_assertnonnull(buf);
+	addr = map_to_sysmem(buf);
+
+	memset(&res, '\0', sizeof(res));
+	start = get_timer(0);
+	ut_assertok(memtest_run(addr, MEMTEST_SIZE, &res));
+	fast = max(get_timer(start), 1UL);
+	ut_asserteq(0, res.errors);
+	ut_asserteq(0, res.fail_bits);
+	ut_assert(res.bytes == (u64)MEMTEST_SIZE * MEMTEST_ACCESSES);
+
+	/* The simple test writes and reads each word once per iteration */
+	snprintf(cmd, sizeof(cmd), "mtest %lx %lx 0 1", addr,
+		 addr + MEMTEST_SIZE);
+	start = get_timer(0);
+	ut_assertok(run_command(cmd, 0));
+	slow = max(get_timer(start), 1UL);
+
+	printf("mtest: %lu MiB/s, mtest -f: %lu MiB/s\n",
+	       2 * (MEMTEST_SIZE >> 20) * 1000 / slow,
+	       MEMTEST_ACCESSES * (MEMTEST_SIZE >> 20) * 1000 / fast);
+
+	snprintf(cmd, sizeof(cmd), "mtest -f %lx %lx 2", addr,
+		 addr + MEMTEST_SIZE);
+	ut_assertok(run_command(cmd, 0));
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_memtest_run, 0);
+
+/* Test that failing addresses and bits are reported */
+static int lib_test_memtest_errors(struct unit_test_state *uts)
+{
+	const u64 pattern = 0x0123456789abcdefULL;
+	struct memtest_result res;
+	u64 *buf;
+	ulong addr;
+
+	buf = memalign(SZ_4K, SZ_64K);
+	ut_assertnonnull(buf);
+	addr = map_to_sysmem(buf);
+
+	memtest_fill(addr, SZ_64K, pattern);
+	buf[10] ^= 1 << 5;
+	buf[11] ^= 1 << 5;
+	buf[1000] ^= 1ULL << 63;
+
+	memset(&res, '\0', sizeof(res));
+	ut_assertok(memtest_check(addr, SZ_64K, pattern, &res));
+	ut_asserteq(3, res.errors);
+	ut_asserteq(addr + 10 * sizeof(u64), res.first_fail);
+	ut_assert(res.fail_bits == (1ULL << 63 | 1 << 5));
+	ut_assert(res.bytes == SZ_64K);
+
+	/* A partial word cannot be tested */
+	ut_asserteq(-EINVAL, memtest_run(addr + 4, SZ_64K - 8, &res));
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_memtest_errors, 0);
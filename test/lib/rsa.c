@@ -0,0 +1,619 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for RSA signature verification, as used by verified boot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <image.h>
+#include <malloc.h>
+#include <libfdt.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/rsa.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of signature checks to time in the speed test */
+#define RSA_SPEED_COUNT		200
+
+static const char rsa_test_msg[] = "u-boot";
+
+/* RSA-2048 test key and signature of "u-boot" */
+#define RSA2048_N0INV	0xc7616b13
+
+static const uint8_t rsa2048_modulus[] = {
+	0xc3, 0x8f, 0xb2, 0x88, 0xf1, 0x44, 0x94, 0xe1,
+	0x91, 0x9f, 0x1d, 0xa5, 0xe0, 0xf0, 0x59, 0xed,
+	0x37, 0xc2, 0x49, 0x5e, 0xcd, 0x5a, 0x4d, 0x40,
+	0xc0, 0x62, 0xad, 0xf7, 0xba, 0x75, 0xe4, 0x09,
+	0x18, 0x7c, 0x13, 0xae, 0xdb, 0x89, 0x24, 0x36,
+	0x07, 0x1a, 0xf1, 0x51, 0x89, 0xa6, 0x20, 0x8f,
+	0x12, 0xf2, 0x78, 0xa7, 0xd5, 0x09, 0x16, 0x87,
+	0x15, 0xad, 0xf2, 0x75, 0x83, 0xa5, 0x6f, 0x59,
+	0x1a, 0x43, 0xaf, 0xe1, 0xa4, 0x33, 0xa3, 0x40,
+	0x86, 0x83, 0x7f, 0x20, 0xe6, 0xa2, 0x35, 0xb1,
+	0x83, 0x5e, 0x02, 0xf7, 0xe4, 0xfe, 0xa7, 0xf4,
+	0x6e, 0x79, 0x4f, 0xe1, 0xdd, 0x45, 0xa7, 0xa8,
+	0xc8, 0x6e, 0x3e, 0xe0, 0xef, 0xf2, 0xc4, 0x91,
+	0x28, 0xe1, 0x30, 0xa4, 0x03, 0xb2, 0x66, 0xf8,
+	0x2b, 0xa5, 0xdc, 0x79, 0x6d, 0xfd, 0x33, 0xb4,
+	0xe7, 0x0c, 0x48, 0xa2, 0x80, 0xa6, 0x4b, 0xd9,
+	0xcf, 0xd8, 0xf2, 0x03, 0xb5, 0x61, 0xac, 0x44,
+	0xa3, 0xdb, 0x0d, 0x75, 0x8f, 0xcc, 0x2b, 0x77,
+	0x52, 0xef, 0x10, 0x16, 0xc1, 0x56, 0x2d, 0x1a,
+	0xc1, 0x31, 0x16, 0xf1, 0x83, 0x5c, 0x68, 0xc1,
+	0x34, 0x65, 0x25, 0xea, 0x2c, 0x28, 0x5f, 0x46,
+	0x92, 0x3c, 0x29, 0xa5, 0x59, 0xeb, 0x07, 0x84,
+	0x1c, 0x36, 0xc8, 0x59, 0x5c, 0x08, 0x11, 0x41,
+	0xe8, 0x77, 0x1a, 0x7d, 0x0d, 0x3b, 0x98, 0xbe,
+	0x28, 0x2e, 0x0d, 0x48, 0x20, 0x9f, 0x5d, 0x80,
+	0xcd, 0xff, 0x42, 0x43, 0xf6, 0x65, 0x1a, 0x47,
+	0xc8, 0x2a, 0xed, 0x56, 0xc9, 0xf1, 0xaf, 0x98,
+	0x7a, 0xf4, 0xcb, 0x2a, 0xcc, 0x23, 0x64, 0xde,
+	0x3d, 0x64, 0x5b, 0x54, 0xef, 0x53, 0xf1, 0x02,
+	0x5f, 0x0b, 0xac, 0x3b, 0x73, 0x4c, 0xe9, 0x04,
+	0x77, 0xc7, 0x17, 0xaa, 0x2d, 0x57, 0xc4, 0x53,
+	0xe6, 0x27, 0x0d, 0xa9, 0xa8, 0x26, 0xe8, 0xe5,
+};
+
+static const uint8_t rsa2048_rr[] = {
+	0x24, 0x0c, 0x87, 0x42, 0x11, 0x58, 0x43, 0xff,
+	0x79, 0x2b, 0xb9, 0xc1, 0x45, 0x77, 0x08, 0x25,
+	0xaf, 0x0c, 0x5e, 0x56, 0xd7, 0xe1, 0xd9, 0xf2,
+	0xf1, 0x36, 0x95, 0x28, 0x57, 0x09, 0x8f, 0x12,
+	0x5c, 0x78, 0xca, 0x6a, 0x10, 0x83, 0xa0, 0xc2,
+	0x4e, 0xfb, 0x87, 0x3c, 0x0b, 0x58, 0x35, 0xe2,
+	0x7b, 0x9c, 0xde, 0x8f, 0x22, 0x6e, 0xcf, 0x04,
+	0x61, 0x14, 0x64, 0xbb, 0x22, 0x9a, 0x89, 0xed,
+	0xb4, 0x9d, 0x97, 0x8e, 0x53, 0x29, 0x97, 0x99,
+	0xb1, 0x43, 0x67, 0xbf, 0x40, 0x0e, 0xf9, 0x53,
+	0xa6, 0x30, 0xe3, 0xcb, 0x73, 0x10, 0xaf, 0x0c,
+	0x38, 0x57, 0x9c, 0x36, 0x4f, 0x72, 0x60, 0x1f,
+	0xe5, 0x07, 0x9b, 0x9f, 0x4c, 0x82, 0x10, 0xe9,
+	0x26, 0xfd, 0x0b, 0x7b, 0xdc, 0x7f, 0x9e, 0xd0,
+	0x6a, 0xaf, 0xd1, 0x37, 0x2a, 0x74, 0x11, 0xd4,
+	0x88, 0x94, 0x95, 0x61, 0x51, 0x0e, 0x35, 0x62,
+	0xe8, 0xf4, 0xe8, 0x3e, 0x06, 0xec, 0x37, 0xf1,
+	0xf7, 0x89, 0x08, 0x14, 0x7b, 0x34, 0x73, 0x56,
+	0xce, 0xf5, 0x95, 0xb9, 0xb3, 0x24, 0xe0, 0xf0,
+	0x52, 0x1d, 0x8b, 0x5f, 0xbf, 0x8e, 0xbc, 0xc0,
+	0x4b, 0x2f, 0xa5, 0x3e, 0x5e, 0xf9, 0x3e, 0x5e,
+	0x35, 0x2a, 0xc8, 0x57, 0x48, 0xdf, 0x8f, 0x4c,
+	0x45, 0x77, 0x3f, 0x6e, 0xd1, 0x17, 0x90, 0xf0,
+	0x23, 0x8d, 0xe4, 0xa0, 0x7d, 0xee, 0xfa, 0xb3,
+	0x42, 0xe1, 0x57, 0x96, 0x99, 0x08, 0x05, 0x6f,
+	0x88, 0x77, 0xc3, 0x2b, 0x38, 0xed, 0x1b, 0xbf,
+	0x24, 0xd3, 0x12, 0x3f, 0x47, 0xe5, 0xa9, 0x0e,
+	0x73, 0x55, 0x3e, 0xb2, 0x53, 0x42, 0xea, 0xb8,
+	0x6b, 0x52, 0xf1, 0x22, 0xca, 0x48, 0x52, 0x4d,
+	0x46, 0x69, 0x6b, 0xc6, 0x6c, 0xe2, 0xc1, 0x54,
+	0x35, 0x3d, 0x24, 0x4f, 0x37, 0x8e, 0x9b, 0x52,
+	0x19, 0xf8, 0x85, 0xeb, 0x0a, 0x3f, 0x23, 0x2c,
+};
+
+static const uint8_t rsa2048_sig[] = {
+	0x42, 0x32, 0xaf, 0x72, 0xc2, 0xa9, 0xa5, 0x5c,
+	0x7c, 0xde, 0x76, 0x37, 0x47, 0xe5, 0x5c, 0x98,
+	0x44, 0xec, 0xb8, 0xc8, 0x57, 0xe3, 0xdf, 0x24,
+	0x21, 0xa8, 0xd0, 0x64, 0xc3, 0x50, 0x7f, 0xb8,
+	0x91, 0x91, 0xa3, 0xaa, 0x92, 0x73, 0xa1, 0x01,
+	0xea, 0xf7, 0xcd, 0x09, 0x87, 0xbe, 0x27, 0xca,
+	0xba, 0xff, 0xd5, 0xf7, 0xdf, 0x59, 0xbc, 0xb5,
+	0xbb, 0xf9, 0x37, 0x00, 0x13, 0x8b, 0x87, 0xbb,
+	0xf2, 0xcd, 0x83, 0x03, 0xb9, 0xcf, 0xc8, 0xd3,
+	0x84, 0xe9, 0x3a, 0x2a, 0x79, 0x00, 0xb9, 0x76,
+	0x8f, 0xf7, 0x35, 0x05, 0x81, 0x93, 0xbb, 0xe7,
+	0xa6, 0xcc, 0x81, 0x7f, 0x43, 0x05, 0x94, 0xfd,
+	0xb0, 0x77, 0xfa, 0x47, 0xaf, 0xad, 0x5b, 0x23,
+	0x65, 0xf8, 0x29, 0xac, 0x81, 0xcf, 0xc8, 0xbb,
+	0x58, 0x80, 0xb1, 0xd3, 0xdd, 0x55, 0xef, 0x7a,
+	0xbe, 0x47, 0xad, 0xf2, 0xa8, 0x5f, 0x73, 0x43,
+	0x81, 0x99, 0x3d, 0x42, 0x0c, 0x88, 0xa0, 0xd2,
+	0x70, 0xb2, 0xdc, 0x9b, 0xb8, 0x55, 0x11, 0x00,
+	0x49, 0x84, 0x7f, 0xa5, 0x98, 0xba, 0x6d, 0x42,
+	0xe6, 0x29, 0x68, 0x9d, 0x1d, 0x27, 0x86, 0x37,
+	0x9a, 0x54, 0xda, 0x52, 0xd3, 0x2a, 0x66, 0x25,
+	0x10, 0xe6, 0x20, 0xa1, 0xf8, 0x5c, 0xe6, 0xe2,
+	0xec, 0x29, 0x1f, 0x90, 0xfc, 0x96, 0x9c, 0xb7,
+	0x9c, 0x0e, 0xbf, 0x38, 0xb0, 0x2e, 0x45, 0x40,
+	0x38, 0xb5, 0xed, 0x4c, 0xd0, 0x9d, 0xcf, 0x6e,
+	0x80, 0x57, 0x91, 0x76, 0x44, 0x03, 0x17, 0x73,
+	0x34, 0x78, 0x22, 0x8d, 0x04, 0xe7, 0xc7, 0xe7,
+	0x4a, 0xf7, 0x44, 0x6d, 0x84, 0xe4, 0xdf, 0xf3,
+	0x70, 0x04, 0xb0, 0x40, 0xa5, 0x67, 0xbd, 0xe9,
+	0x3e, 0x9e, 0x78, 0x1f, 0xeb, 0xa4, 0x33, 0x0f,
+	0x1e, 0x54, 0x88, 0x7d, 0x43, 0x0e, 0x2d, 0x33,
+	0xd0, 0xf8, 0x54, 0x6c, 0x9c, 0x99, 0xa1, 0x9b,
+};
+
+/*
+ * A second RSA-2048 key and signature of "u-boot", to check that a key is
+ * not mistaken for another of the same size
+ */
+#define RSA2048B_N0INV	0x6c9203e1
+
+static const uint8_t rsa2048b_modulus[] = {
+	0x8c, 0x3e, 0x11, 0xe7, 0x77, 0x91, 0x15, 0x75,
+	0x24, 0xef, 0x6c, 0x0a, 0x28, 0xfb, 0x79, 0xd9,
+	0x60, 0xaf, 0x97, 0x36, 0xa4, 0x6e, 0x05, 0x71,
+	0x71, 0x21, 0x11, 0x78, 0x50, 0xae, 0x0a, 0x7e,
+	0x5d, 0x7e, 0x6c, 0x3b, 0xb6, 0x7d, 0xf0, 0xa1,
+	0x19, 0xd1, 0x1c, 0xf7, 0xc3, 0x78, 0xa8, 0xd1,
+	0xaa, 0xb0, 0xeb, 0x66, 0x11, 0x26, 0x9a, 0xd7,
+	0xf1, 0x95, 0x27, 0x2b, 0x3b, 0xf9, 0xfb, 0xd5,
+	0xb7, 0xd3, 0x30, 0x7d, 0xb5, 0x4b, 0xd0, 0xa5,
+	0x94, 0x84, 0x3d, 0x06, 0x36, 0xf8, 0xfb, 0x32,
+	0xab, 0xda, 0x68, 0x36, 0xbb, 0x46, 0x68, 0xf5,
+	0x3d, 0xb0, 0x03, 0xe5, 0xcf, 0x3e, 0x0a, 0xf8,
+	0x63, 0xd8, 0x20, 0x3f, 0x85, 0xf0, 0x11, 0x6e,
+	0x98, 0xeb, 0x7b, 0xf9, 0x94, 0x46, 0x90, 0x32,
+	0x55, 0xc4, 0x7f, 0x91, 0xf7, 0x4e, 0xdb, 0x63,
+	0x56, 0x6b, 0x26, 0x87, 0xc4, 0x08, 0x48, 0x65,
+	0xf8, 0x71, 0xde, 0x3f, 0x96, 0x37, 0x32, 0x1b,
+	0x4f, 0x94, 0xed, 0xfb, 0x11, 0x32, 0x2a, 0x5e,
+	0x8a, 0x30, 0xad, 0xef, 0xa9, 0xe5, 0x9d, 0x7b,
+	0xd8, 0x1b, 0xcd, 0x82, 0x6a, 0xbc, 0xa9, 0x98,
+	0x7a, 0x30, 0x62, 0x3a, 0x9d, 0x67, 0x19, 0xbd,
+	0x0b, 0xed, 0xee, 0x90, 0xb5, 0x15, 0xfd, 0x3e,
+	0x74, 0x60, 0x7a, 0x03, 0xa7, 0x56, 0x13, 0xa1,
+	0x29, 0xc5, 0x16, 0x3a, 0xd1, 0x23, 0xdf, 0xf4,
+	0x16, 0x56, 0x7b, 0xbd, 0x7b, 0x31, 0x68, 0x33,
+	0xfc, 0x19, 0x8b, 0x99, 0x3d, 0x91, 0xec, 0xb4,
+	0xc5, 0xae, 0xa9, 0x43, 0x82, 0x59, 0x32, 0x98,
+	0x6b, 0xea, 0xe6, 0x4f, 0x18, 0x3f, 0x5e, 0xe8,
+	0xa8, 0x74, 0xea, 0x9b, 0x23, 0xa0, 0x51, 0x67,
+	0xef, 0x5b, 0x4e, 0xe1, 0x7e, 0x8d, 0xaa, 0x72,
+	0x95, 0x77, 0x76, 0xe0, 0x25, 0x25, 0xa7, 0x42,
+	0x78, 0xb9, 0x0c, 0x67, 0x99, 0x22, 0x7f, 0xdf,
+};
+
+static const uint8_t rsa2048b_rr[] = {
+	0x63, 0x47, 0xc5, 0xd5, 0xa9, 0xee, 0x7d, 0x31,
+	0x4c, 0x38, 0x1b, 0xce, 0x50, 0xf5, 0xd7, 0xe0,
+	0x63, 0xdd, 0x90, 0x77, 0x2f, 0xc0, 0x35, 0x71,
+	0x9a, 0x2b, 0x49, 0x0c, 0xf2, 0x10, 0x3a, 0xb8,
+	0x98, 0x45, 0xa0, 0xc2, 0x85, 0xe9, 0x03, 0x9c,
+	0x96, 0x56, 0x0a, 0xbe, 0x99, 0x2a, 0x46, 0x71,
+	0x48, 0xa9, 0x5d, 0x43, 0xdf, 0xf7, 0x58, 0xbb,
+	0x01, 0x77, 0xa7, 0x43, 0x02, 0xf8, 0x3a, 0xfe,
+	0x6b, 0x1f, 0xab, 0x47, 0xd6, 0x85, 0x75, 0xad,
+	0x82, 0xc2, 0xbe, 0x70, 0x1a, 0x1c, 0x15, 0x25,
+	0xb4, 0x68, 0x41, 0x8f, 0xab, 0x6d, 0x50, 0x33,
+	0x85, 0x50, 0x59, 0x19, 0x79, 0xd1, 0x3a, 0xe1,
+	0x70, 0xe2, 0xdd, 0x3a, 0x9d, 0xa0, 0xbb, 0xbb,
+	0x11, 0x4f, 0x76, 0xc8, 0x96, 0xd9, 0xfb, 0x2a,
+	0xe3, 0x9b, 0xb5, 0xda, 0x34, 0xb9, 0x04, 0x19,
+	0x1f, 0xbd, 0x23, 0xc9, 0x09, 0x92, 0xcf, 0x48,
+	0xe5, 0xfc, 0x96, 0xbd, 0xfc, 0x6a, 0x6c, 0x07,
+	0xe5, 0xc2, 0x4a, 0x0e, 0xa5, 0x58, 0xa2, 0x7a,
+	0x6a, 0x02, 0xa3, 0x24, 0x34, 0x02, 0xc7, 0xc6,
+	0x68, 0xe4, 0x61, 0x48, 0xf7, 0x8a, 0x6c, 0xf8,
+	0xc8, 0x3d, 0xf1, 0xb0, 0x96, 0x9c, 0x52, 0x21,
+	0x83, 0xf3, 0x36, 0x72, 0x83, 0x16, 0x98, 0x74,
+	0x26, 0x23, 0x88, 0xfb, 0xfb, 0xc2, 0x99, 0x2e,
+	0x60, 0x65, 0xb4, 0x2e, 0x77, 0x24, 0x9f, 0xd5,
+	0xbc, 0xd3, 0x3b, 0xd3, 0x4b, 0x78, 0xce, 0xc1,
+	0x19, 0xbc, 0x72, 0xae, 0x11, 0x43, 0xff, 0x44,
+	0x2a, 0x19, 0x8e, 0xec, 0x42, 0x87, 0x64, 0xbf,
+	0xac, 0x47, 0xab, 0x0f, 0xa7, 0xd0, 0x61, 0xef,
+	0xbe, 0xe5, 0xb9, 0x32, 0x11, 0x1f, 0xfd, 0x56,
+	0x76, 0xe9, 0x78, 0xb8, 0xf9, 0xf7, 0xb0, 0x06,
+	0x90, 0x38, 0x5c, 0x71, 0x8a, 0x88, 0x47, 0xbb,
+	0xeb, 0x55, 0x42, 0x19, 0x57, 0xf3, 0x47, 0x38,
+};
+
+static const uint8_t rsa2048b_sig[] = {
+	0x0e, 0x12, 0x90, 0x46, 0xef, 0x10, 0x52, 0x4d,
+	0x7c, 0xcb, 0x6d, 0x62, 0xa0, 0x80, 0xc5, 0xc8,
+	0x6a, 0xd5, 0xb9, 0x50, 0x58, 0x25, 0x3c, 0xf5,
+	0x64, 0x4c, 0xda, 0x42, 0x60, 0xc0, 0x0f, 0x45,
+	0xc8, 0x0e, 0x60, 0xb2, 0x8d, 0xd0, 0x79, 0x00,
+	0x99, 0x1c, 0x7d, 0xc7, 0x8c, 0xfc, 0xb2, 0xdb,
+	0x7d, 0x23, 0x71, 0xc3, 0x6d, 0x0a, 0xdd, 0x08,
+	0xfc, 0x35, 0x99, 0xe6, 0xf1, 0xf7, 0x90, 0x1e,
+	0x75, 0x0c, 0xbb, 0x97, 0xfa, 0x5d, 0xf2, 0x5c,
+	0xdf, 0x9b, 0x83, 0x0d, 0xbe, 0xf6, 0x85, 0xff,
+	0x8a, 0x30, 0x6b, 0xa9, 0x88, 0xf4, 0x5c, 0x60,
+	0x33, 0x43, 0xde, 0x91, 0x8a, 0xc8, 0xa5, 0xec,
+	0x4b, 0xb7, 0x70, 0x44, 0x3e, 0x9b, 0x52, 0x0f,
+	0x14, 0x79, 0x5d, 0xbe, 0x8c, 0x66, 0x84, 0x11,
+	0x52, 0x98, 0x3e, 0x62, 0xce, 0x3b, 0x43, 0xd5,
+	0x69, 0xfe, 0xe7, 0xb4, 0xf9, 0x29, 0x8b, 0x4a,
+	0xd8, 0x0c, 0x6d, 0x44, 0x39, 0xc4, 0x53, 0xe4,
+	0xa5, 0xf2, 0x71, 0x54, 0x82, 0x0b, 0x91, 0xd2,
+	0xdf, 0x31, 0x2b, 0x6f, 0x14, 0xcc, 0x35, 0xb8,
+	0xce, 0xab, 0x1c, 0x6e, 0x02, 0xec, 0xbe, 0x97,
+	0xe4, 0x6f, 0x47, 0x60, 0x3d, 0x38, 0xe9, 0xe1,
+	0x04, 0x2c, 0x8a, 0x5d, 0xc4, 0x47, 0xfa, 0xb7,
+	0x43, 0x9c, 0xf0, 0x5b, 0xcb, 0x12, 0x76, 0x04,
+	0x83, 0xf3, 0x3d, 0xab, 0xef, 0x39, 0x6a, 0x9e,
+	0x31, 0x41, 0x18, 0x71, 0xe8, 0x90, 0xb2, 0x36,
+	0xc1, 0x08, 0xd7, 0xcb, 0x5b, 0x6c, 0x17, 0xb5,
+	0x6e, 0x62, 0x37, 0x8a, 0xcb, 0xef, 0x73, 0x2a,
+	0x44, 0xc9, 0x8a, 0xe5, 0xf8, 0xc1, 0x29, 0xb1,
+	0x8d, 0xc7, 0x06, 0x9a, 0xbf, 0x05, 0x3a, 0x82,
+	0xdc, 0x82, 0xf0, 0x0a, 0x92, 0xe7, 0x35, 0xa9,
+	0x6d, 0x1d, 0x71, 0x88, 0xef, 0x11, 0xe1, 0x37,
+	0xea, 0x69, 0x55, 0x38, 0xd2, 0x5c, 0x4f, 0xde,
+};
+
+/* RSA-3072 test key and signature of "u-boot" */
+#define RSA3072_N0INV	0x72e5c449
+
+static const uint8_t rsa3072_modulus[] = {
+	0xac, 0x5b, 0x47, 0x56, 0x84, 0x69, 0xc0, 0xb2,
+	0x0a, 0xed, 0x8e, 0xb9, 0xe5, 0x78, 0xa3, 0xd9,
+	0x40, 0xd9, 0x3c, 0x82, 0x8c, 0x62, 0xf7, 0x87,
+	0x23, 0xa3, 0x9b, 0x4a, 0x69, 0xe0, 0x1e, 0x68,
+	0xfe, 0xab, 0x0d, 0x8f, 0x21, 0xac, 0xaf, 0x8f,
+	0x59, 0xb5, 0xaa, 0xf6, 0xf3, 0x28, 0x5a, 0x8f,
+	0x50, 0xe3, 0xe2, 0xaa, 0x18, 0x74, 0xd7, 0x15,
+	0x9d, 0x3f, 0x32, 0xe3, 0x9c, 0x68, 0xf7, 0x08,
+	0xf3, 0xfe, 0x36, 0x96, 0x0c, 0xbd, 0x7d, 0x1d,
+	0xaf, 0x4e, 0x72, 0x07, 0x66, 0x04, 0xa9, 0x24,
+	0xde, 0xf7, 0xf2, 0xef, 0x33, 0x29, 0xd9, 0xc3,
+	0xa7, 0x4b, 0x27, 0x16, 0xd2, 0x21, 0x77, 0x37,
+	0x3d, 0xe4, 0xa6, 0x9f, 0x06, 0x1b, 0x5d, 0xeb,
+	0x4a, 0x26, 0x89, 0x28, 0xf1, 0x3c, 0xce, 0x8a,
+	0x2c, 0xed, 0xf0, 0xc9, 0x80, 0x98, 0xf7, 0x54,
+	0xdd, 0x4f, 0xc5, 0x0a, 0x3d, 0x47, 0x90, 0xa7,
+	0x80, 0xb2, 0xa1, 0x96, 0xd4, 0x71, 0x37, 0x31,
+	0x1e, 0x25, 0x0a, 0xde, 0x41, 0xf1, 0xc3, 0x22,
+	0xc1, 0x6e, 0xf5, 0x45, 0xfc, 0xcc, 0xde, 0xcd,
+	0x39, 0x7a, 0xa4, 0xed, 0x47, 0x9d, 0xbd, 0xfc,
+	0x8a, 0xc3, 0xb1, 0x11, 0xeb, 0x5f, 0xcf, 0x12,
+	0x80, 0xac, 0x2d, 0xf9, 0xca, 0x27, 0xde, 0x5e,
+	0x18, 0x19, 0x72, 0x1a, 0x9c, 0x91, 0x35, 0xde,
+	0xb4, 0x4f, 0xea, 0x24, 0xdf, 0x9d, 0xbe, 0x13,
+	0xcf, 0xf2, 0xeb, 0x65, 0xef, 0xec, 0x25, 0xca,
+	0xfc, 0x70, 0x49, 0x64, 0x08, 0xd0, 0x4c, 0x5d,
+	0x29, 0xbb, 0x68, 0xac, 0xcd, 0xfe, 0xf7, 0xa7,
+	0x95, 0x3a, 0x9b, 0x9d, 0x7e, 0xa1, 0x69, 0x1d,
+	0xb0, 0xa9, 0x24, 0xb3, 0xc5, 0x04, 0x4a, 0x30,
+	0xf9, 0xbc, 0xa5, 0x8e, 0x2a, 0x08, 0x00, 0x11,
+	0x18, 0x5a, 0x23, 0x07, 0x58, 0xc2, 0x60, 0x8d,
+	0x0d, 0xe8, 0xed, 0x72, 0x0e, 0xbc, 0x3b, 0x25,
+	0x6e, 0xd1, 0x90, 0x3d, 0x9e, 0x7f, 0x28, 0x94,
+	0xc6, 0xb8, 0x6c, 0x38, 0xc1, 0x5e, 0x82, 0x1e,
+	0xd1, 0x1c, 0x17, 0x30, 0x42, 0x89, 0x6a, 0x60,
+	0x46, 0xc7, 0xbf, 0x0f, 0x33, 0x85, 0x61, 0xd1,
+	0x4c, 0xc3, 0xee, 0x54, 0x2b, 0xdf, 0xc8, 0xa0,
+	0xc5, 0xa7, 0x73, 0xee, 0x41, 0xb9, 0x8b, 0xf7,
+	0xd3, 0xc8, 0x24, 0x12, 0x9e, 0xcf, 0xb2, 0x61,
+	0x65, 0x0c, 0xea, 0x7d, 0x52, 0x9c, 0x2b, 0x84,
+	0x9e, 0x26, 0x1a, 0xc3, 0x01, 0x74, 0x90, 0x29,
+	0xc3, 0x27, 0xd8, 0x7f, 0xb1, 0x98, 0x38, 0x29,
+	0xd2, 0x81, 0x00, 0xd0, 0xc1, 0x34, 0xdc, 0xfd,
+	0x95, 0x20, 0xc9, 0xcd, 0xbb, 0xeb, 0x97, 0x2f,
+	0xcd, 0x74, 0x4b, 0x8a, 0x34, 0x3e, 0xd4, 0x23,
+	0x0a, 0x51, 0xc4, 0xc6, 0x13, 0xb8, 0x74, 0x41,
+	0xf7, 0x17, 0xd1, 0xea, 0x2a, 0x7a, 0x2d, 0x49,
+	0x43, 0xd2, 0x29, 0x05, 0x57, 0x96, 0x92, 0x07,
+};
+
+static const uint8_t rsa3072_rr[] = {
+	0x20, 0x4c, 0x85, 0xdb, 0x8e, 0x42, 0x2d, 0x68,
+	0x69, 0x23, 0x7e, 0xa2, 0x76, 0x40, 0x9e, 0x51,
+	0xd0, 0xa5, 0xbb, 0xa9, 0xdd, 0x73, 0x1b, 0xda,
+	0xb8, 0xc9, 0x36, 0xf4, 0xe1, 0x8d, 0xef, 0x5b,
+	0x6c, 0xdf, 0x33, 0x10, 0xca, 0x6e, 0x30, 0x8d,
+	0xa3, 0xa3, 0xbf, 0x23, 0x56, 0xc6, 0xa2, 0x6f,
+	0xa5, 0xe4, 0x02, 0xe4, 0x93, 0xa5, 0xc6, 0x1d,
+	0x57, 0xc1, 0x2d, 0xc1, 0x23, 0x3b, 0xf1, 0xb0,
+	0x77, 0xde, 0x0d, 0x0b, 0x1f, 0x6a, 0x28, 0x2b,
+	0xa2, 0x72, 0x49, 0x28, 0x55, 0x01, 0x3b, 0xa6,
+	0xc1, 0x03, 0xda, 0x68, 0x1b, 0x49, 0x18, 0x5f,
+	0x1a, 0x4c, 0x2b, 0x32, 0xb4, 0x59, 0xd8, 0x31,
+	0xae, 0x74, 0xa4, 0x6f, 0x21, 0x06, 0x26, 0xc2,
+	0x87, 0xb4, 0x8b, 0x23, 0x56, 0xe1, 0xc1, 0x9b,
+	0x71, 0xdc, 0xb6, 0x33, 0x32, 0x51, 0xcd, 0xad,
+	0x3a, 0x36, 0xc5, 0x53, 0xd4, 0xf2, 0x76, 0x2e,
+	0x80, 0xc7, 0x4f, 0xec, 0x8c, 0x30, 0x3e, 0xbe,
+	0xf0, 0xd7, 0x64, 0x50, 0x82, 0x1a, 0xe4, 0xb7,
+	0x0f, 0x6f, 0xbd, 0xfc, 0xac, 0x71, 0xb3, 0xa1,
+	0x00, 0x1c, 0x03, 0xca, 0x6d, 0x4c, 0x65, 0xdd,
+	0xb4, 0xa0, 0xad, 0xc9, 0x8d, 0xca, 0xe2, 0xa2,
+	0xff, 0xda, 0xd3, 0xcf, 0x0e, 0x91, 0x43, 0x78,
+	0xce, 0x33, 0x39, 0x22, 0xd6, 0x3c, 0x17, 0x9c,
+	0x62, 0x1d, 0x29, 0x3c, 0x6f, 0x7b, 0x9c, 0xc0,
+	0x65, 0x89, 0xcd, 0xa3, 0x55, 0x69, 0x1f, 0x11,
+	0x95, 0xec, 0x59, 0x95, 0x26, 0x30, 0xd6, 0xe9,
+	0xdb, 0x1a, 0xad, 0x53, 0x31, 0xba, 0x94, 0x25,
+	0x61, 0x06, 0x04, 0xb1, 0x73, 0xea, 0xa9, 0xe6,
+	0x65, 0xc2, 0xbb, 0x99, 0xc1, 0x65, 0xa1, 0x12,
+	0x21, 0xf9, 0xce, 0xf6, 0x4d, 0x32, 0x36, 0xb3,
+	0x8a, 0xdc, 0x69, 0x83, 0x3a, 0x33, 0x05, 0xb6,
+	0x87, 0x25, 0xd3, 0x56, 0xdc, 0xe0, 0xb3, 0x74,
+	0x88, 0xcf, 0xa9, 0xb4, 0x75, 0xf6, 0x10, 0xba,
+	0x6e, 0xa9, 0x5e, 0x93, 0x49, 0x1a, 0xd8, 0xfc,
+	0xac, 0x50, 0x99, 0x05, 0x9f, 0x6a, 0x72, 0x64,
+	0x99, 0x9c, 0x80, 0x44, 0x98, 0x0e, 0xa5, 0x97,
+	0x3e, 0x97, 0xc9, 0xbc, 0x40, 0x46, 0x67, 0xe8,
+	0x42, 0x50, 0x39, 0xe6, 0x71, 0x43, 0x34, 0xf6,
+	0xd3, 0x3a, 0xcd, 0x37, 0x73, 0x37, 0xf3, 0xf9,
+	0xe7, 0x0c, 0x8e, 0x1e, 0xc4, 0xca, 0x55, 0x1b,
+	0x98, 0x55, 0x5d, 0xd2, 0xee, 0x9e, 0x30, 0x9c,
+	0x15, 0x07, 0x47, 0x92, 0x50, 0xe2, 0x2c, 0xdc,
+	0x30, 0xb0, 0xb5, 0xf0, 0x9c, 0x5f, 0x92, 0x9e,
+	0xbe, 0xe8, 0xea, 0x37, 0xc9, 0x0a, 0x29, 0x4a,
+	0xdb, 0x56, 0xad, 0xdd, 0x54, 0xdd, 0x78, 0xd3,
+	0x9c, 0x50, 0xbc, 0xbb, 0xe8, 0x53, 0xbd, 0x64,
+	0x6b, 0xb5, 0x46, 0x6c, 0xac, 0x1e, 0xd4, 0x21,
+	0xd7, 0xb9, 0x6c, 0x7f, 0x38, 0xbd, 0x8d, 0x1f,
+};
+
+static const uint8_t rsa3072_sig[] = {
+	0x18, 0xb6, 0x82, 0x9a, 0xf6, 0xa7, 0xc9, 0x4e,
+	0x05, 0xc2, 0x43, 0xaf, 0xec, 0xb9, 0x16, 0x1d,
+	0x25, 0x5e, 0x3a, 0x13, 0xec, 0xba, 0x58, 0x1f,
+	0x32, 0x8c, 0x27, 0x5c, 0xcb, 0x07, 0xb1, 0x6e,
+	0xe0, 0xc4, 0x13, 0x07, 0x0f, 0xcf, 0x82, 0x4f,
+	0x37, 0xd8, 0x64, 0xc9, 0x9b, 0xe3, 0x86, 0x47,
+	0xc1, 0x7a, 0xc8, 0x5e, 0xdb, 0xbd, 0xeb, 0x9e,
+	0x1b, 0xd6, 0x5b, 0xc9, 0x54, 0xe4, 0x6f, 0x51,
+	0x72, 0xb5, 0xd1, 0x41, 0x0f, 0xa3, 0x14, 0x11,
+	0x6c, 0xa2, 0x6c, 0xa3, 0x06, 0x06, 0xfd, 0x20,
+	0xbe, 0x33, 0x76, 0xc7, 0x46, 0x01, 0xca, 0x39,
+	0xe1, 0xa8, 0xa4, 0x1a, 0xf9, 0xe6, 0xa9, 0x2d,
+	0xad, 0x2d, 0x67, 0x85, 0xfb, 0x21, 0x35, 0xd4,
+	0x2a, 0xb1, 0x19, 0x08, 0x0c, 0x90, 0x16, 0xcb,
+	0x67, 0xff, 0xbb, 0x11, 0x03, 0x5e, 0xcf, 0xdc,
+	0x19, 0x27, 0xfd, 0x0d, 0x2c, 0x79, 0xda, 0xee,
+	0x49, 0xee, 0xad, 0x1e, 0x62, 0xaa, 0xac, 0xe9,
+	0x46, 0xde, 0x84, 0x25, 0x61, 0xc6, 0x96, 0xe1,
+	0x50, 0x6e, 0x91, 0x7a, 0xd7, 0xa0, 0x45, 0xca,
+	0xcc, 0xcf, 0xa7, 0x6b, 0x97, 0x3c, 0xeb, 0x49,
+	0x5c, 0x60, 0xbf, 0x7b, 0xeb, 0x2c, 0x4b, 0xab,
+	0x14, 0x53, 0xf2, 0x8e, 0x0c, 0xa5, 0x0d, 0x93,
+	0x4d, 0x7d, 0x43, 0x18, 0xae, 0x04, 0x1b, 0x2d,
+	0xb4, 0xce, 0xb9, 0xa3, 0xbb, 0x12, 0xfd, 0x4b,
+	0x4f, 0xf6, 0x42, 0xec, 0xe6, 0xe9, 0xb1, 0x7c,
+	0x2b, 0x6c, 0x5f, 0x96, 0x13, 0x5c, 0xbf, 0x7a,
+	0x4d, 0xea, 0x2e, 0x91, 0x36, 0x98, 0xa0, 0x8c,
+	0x0e, 0x31, 0x02, 0x66, 0x31, 0x7b, 0xb9, 0xf7,
+	0x27, 0x13, 0x56, 0xc0, 0x47, 0x5d, 0x26, 0x32,
+	0x3a, 0x6a, 0xca, 0x18, 0x32, 0x69, 0x3e, 0xf7,
+	0x92, 0x44, 0xad, 0x49, 0xb0, 0x4e, 0x5e, 0xf1,
+	0xf9, 0x16, 0xac, 0x51, 0x03, 0x3d, 0x33, 0x54,
+	0x94, 0x7d, 0xd9, 0x96, 0xc5, 0xc9, 0x39, 0x3d,
+	0xc9, 0x7d, 0x83, 0x2b, 0x2e, 0xa3, 0xc1, 0x00,
+	0x25, 0xc4, 0x70, 0xcb, 0x98, 0xd0, 0xc6, 0x52,
+	0xc4, 0x4c, 0x12, 0x10, 0x92, 0xfb, 0xf8, 0x1f,
+	0x7b, 0x33, 0x66, 0x16, 0x7a, 0xbe, 0x1d, 0x62,
+	0x0b, 0x56, 0xa1, 0x04, 0x2a, 0x38, 0x02, 0x84,
+	0x8a, 0x49, 0xd9, 0xca, 0xab, 0x4e, 0x91, 0xe6,
+	0x60, 0xab, 0xf9, 0x2b, 0xbd, 0x24, 0x21, 0x4e,
+	0x2c, 0x0b, 0xf4, 0x59, 0xe0, 0x12, 0xed, 0x26,
+	0x51, 0x31, 0x17, 0x6e, 0x62, 0xd2, 0x3a, 0x2b,
+	0x97, 0x65, 0xe7, 0xb7, 0xe4, 0x5b, 0x60, 0x93,
+	0x04, 0x06, 0x66, 0x09, 0xcf, 0xe5, 0xe2, 0x30,
+	0x77, 0xd5, 0x15, 0x74, 0x8f, 0x21, 0x7d, 0xff,
+	0xd8, 0xcc, 0x58, 0xc3, 0x77, 0xfb, 0x3b, 0xfc,
+	0x6d, 0xa2, 0x6c, 0x91, 0x91, 0x56, 0xce, 0x13,
+	0x57, 0x91, 0xdb, 0x68, 0x23, 0xa7, 0x1f, 0x2b,
+};
+
+struct rsa_test_key {
+	const char *algo;
+	int bits;
+	uint32_t n0inv;
+	const uint8_t *modulus;
+	const uint8_t *rr;
+	const uint8_t *sig;
+};
+
+static const struct rsa_test_key rsa_test_keys[] = {
+	{ "sha256,rsa2048", 2048, RSA2048_N0INV, rsa2048_modulus, rsa2048_rr,
+		rsa2048_sig },
+	{ "sha256,rsa3072", 3072, RSA3072_N0INV, rsa3072_modulus, rsa3072_rr,
+		rsa3072_sig },
+};
+
+static const struct rsa_test_key rsa_test_key2048b = {
+	"sha256,rsa2048", 2048, RSA2048B_N0INV, rsa2048b_modulus, rsa2048b_rr,
+	rsa2048b_sig
+};
+
+/**
+ * rsa_test_setup() - Create an FDT holding a public key
+ *
+ * This mirrors what mkimage adds to the control FDT with the -K option.
+ *
+ * @key:	Key to add
+ * @info:	Returns signing info ready for rsa_verify()
+ * @return pointer to the allocated FDT, or NULL on error
+ */
+static void *rsa_test_setup(const struct rsa_test_key *key,
+			    struct image_sign_info *info)
+{
+	const int size = 4096;
+	int sig_node, node;
+	void *blob;
+
+	blob = malloc(size);
+	if (!blob)
+		return NULL;
+	if (fdt_create_empty_tree(blob, size))
+		goto err;
+	sig_node = fdt_add_subnode(blob, 0, FIT_SIG_NODENAME);
+	if (sig_node < 0)
+		goto err;
+	node = fdt_add_subnode(blob, sig_node, "key-dev");
+	if (node < 0 ||
+	    fdt_setprop_u32(blob, node, "rsa,num-bits", key->bits) ||
+	    fdt_setprop_u32(blob, node, "rsa,n0-inverse", key->n0inv) ||
+	    fdt_setprop_u64(blob, node, "rsa,exponent", 65537) ||
+	    fdt_setprop(blob, node, "rsa,modulus", key->modulus,
+			key->bits / 8) ||
+	    fdt_setprop(blob, node, "rsa,r-squared", key->rr, key->bits / 8))
+		goto err;
+
+	memset(info, '\0', sizeof(*info));
+	info->keyname = "dev";
+	info->algo = image_get_sig_algo(key->algo);
+	info->fdt_blob = blob;
+	info->required_keynode = -1;
+	if (!info->algo)
+		goto err;
+
+	return blob;
+err:
+	free(blob);
+	return NULL;
+}
+
+static int rsa_test_verify(struct unit_test_state *uts,
+			   const struct rsa_test_key *key)
+{
+	struct image_region region;
+	struct image_sign_info info;
+	uint8_t sig[RSA_MAX_KEY_BITS / 8];
+	int len = key->bits / 8;
+	void *blob;
+
+	blob = rsa_test_setup(key, &info);
+	ut_assertnonnull(blob);
+	region.data = rsa_test_msg;
+	region.size = strlen(rsa_test_msg);
+
+	memcpy(sig, key->sig, len);
+	ut_assertok(rsa_verify(&info, &region, 1, sig, len));
+
+	/* A corrupted signature must be rejected */
+	sig[len / 2] ^= 1;
+	ut_assert(rsa_verify(&info, &region, 1, sig, len) != 0);
+
+	/* As must different data */
+	memcpy(sig, key->sig, len);
+	region.size--;
+	ut_assert(rsa_verify(&info, &region, 1, sig, len) != 0);
+
+	free(blob);
+
+	return 0;
+}
+
+/* Test verifying an RSA-2048 signature */
+static int lib_test_rsa2048(struct unit_test_state *uts)
+{
+	return rsa_test_verify(uts, &rsa_test_keys[0]);
+}
+LIB_TEST(lib_test_rsa2048, 0);
+
+/* Test verifying an RSA-3072 signature */
+static int lib_test_rsa3072(struct unit_test_state *uts)
+{
+	return rsa_test_verify(uts, &rsa_test_keys[1]);
+}
+LIB_TEST(lib_test_rsa3072, 0);
+
+/* Check the signature made with @key against the key in @info's FDT */
+static int rsa_test_check(struct image_sign_info *info,
+			  const struct rsa_test_key *key)
+{
+	struct image_region region;
+	uint8_t sig[RSA_MAX_KEY_BITS / 8];
+
+	region.data = rsa_test_msg;
+	region.size = strlen(rsa_test_msg);
+	info->algo = image_get_sig_algo(key->algo);
+	memcpy(sig, key->sig, key->bits / 8);
+
+	return rsa_verify(info, &region, 1, sig, key->bits / 8);
+}
+
+static int rsa_test_cache(struct unit_test_state *uts, void *blob,
+			  struct image_sign_info *info)
+{
+	const struct rsa_test_key *key2048 = &rsa_test_keys[0];
+	const struct rsa_test_key *key2048b = &rsa_test_key2048b;
+	const struct rsa_test_key *key3072 = &rsa_test_keys[1];
+	int node;
+
+	node = fdt_path_offset(blob, "/" FIT_SIG_NODENAME "/key-dev");
+	ut_assert(node >= 0);
+
+	/* The second check uses the cached key */
+	ut_assertok(rsa_test_check(info, key2048));
+	ut_assertok(rsa_test_check(info, key2048));
+
+	/* Replace the key in place with another of the same size */
+	ut_assertok(fdt_setprop_inplace_u32(blob, node, "rsa,n0-inverse",
+					    key2048b->n0inv));
+	ut_assertok(fdt_setprop_inplace(blob, node, "rsa,modulus",
+					key2048b->modulus, key2048b->bits / 8));
+	ut_assertok(fdt_setprop_inplace(blob, node, "rsa,r-squared",
+					key2048b->rr, key2048b->bits / 8));
+	ut_assert(rsa_test_check(info, key2048) != 0);
+	ut_assertok(rsa_test_check(info, key2048b));
+
+	/* Replace it with a larger key */
+	ut_assertok(fdt_setprop_u32(blob, node, "rsa,num-bits",
+				    key3072->bits));
+	ut_assertok(fdt_setprop_u32(blob, node, "rsa,n0-inverse",
+				    key3072->n0inv));
+	ut_assertok(fdt_setprop(blob, node, "rsa,modulus", key3072->modulus,
+				key3072->bits / 8));
+	ut_assertok(fdt_setprop(blob, node, "rsa,r-squared", key3072->rr,
+				key3072->bits / 8));
+	ut_assert(rsa_test_check(info, key2048b) != 0);
+	ut_assertok(rsa_test_check(info, key3072));
+
+	return 0;
+}
+
+/* Test that a cached key is only used while the key in the FDT is the same */
+static int lib_test_rsa_cache(struct unit_test_state *uts)
+{
+	const void *old_fdt_blob = gd->fdt_blob;
+	struct image_sign_info info;
+	void *blob;
+	int ret;
+
+	/* Only keys in the control FDT are cached */
+	blob = rsa_test_setup(&rsa_test_keys[0], &info);
+	ut_assertnonnull(blob);
+	gd->fdt_blob = blob;
+	ret = rsa_test_cache(uts, blob, &info);
+	gd->fdt_blob = old_fdt_blob;
+	free(blob);
+
+	return ret;
+}
+LIB_TEST(lib_test_rsa_cache, 0);
+
+/* Time signature checks, as done several times for each verified boot */
+static int lib_test_rsa_speed(struct unit_test_state *uts)
+{
+	struct image_region region;
+	struct image_sign_info info;
+	ulong start, elapsed;
+	void *blob;
+	int i, j;
+
+	region.data = rsa_test_msg;
+	region.size = strlen(rsa_test_msg);
+	for (i = 0; i < ARRAY_SIZE(rsa_test_keys); i++) {
+		const struct rsa_test_key *key = &rsa_test_keys[i];
+		uint8_t sig[RSA_MAX_KEY_BITS / 8];
+
+		blob = rsa_test_setup(key, &info);
+		ut_assertnonnull(blob);
+		memcpy(sig, key->sig, key->bits / 8);
+		start = get_timer(0);
+		for (j = 0; j < RSA_SPEED_COUNT; j++)
+			ut_assertok(rsa_verify(&info, &region, 1, sig,
+					       key->bits / 8));
+		elapsed = max(get_timer(start), 1UL);
+		printf("%s: %lu signature checks/s\n", key->algo,
+		       RSA_SPEED_COUNT * 1000 / elapsed);
+		free(blob);
+	}
+
+	return 0;
+}
+LIB_TEST(lib_test_rsa_speed, 0);
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Randomised tests for memcpy(), memmove() and memset()
+ *
+ * Each operation is checked against a simple byte-at-a-time version, over a
+ * buffer which is much larger than the area changed, so that writes outside
+ * the area are caught as well as wrong data within it.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+#define FUZZ_BUF_SIZE		SZ_8K
+#define FUZZ_MAX_LEN		(SZ_4K - 64)
+#define FUZZ_ROUNDS		3000
+
+enum fuzz_op {
+	FUZZ_MEMCPY,
+	FUZZ_MEMMOVE,
+	FUZZ_MEMSET,
+
+	FUZZ_OP_COUNT,
+};
+
+static const char *const fuzz_op_name[] = {
+	"memcpy", "memmove", "memset",
+};
+
+/* Simple xorshift generator, so that any failure can be reproduced */
+static uint fuzz_rand(uint *seed)
+{
+	uint x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+
+	return x;
+}
+
+/* Pick a length, mostly small since that is where the edge cases are */
+static uint fuzz_len(uint *seed)
+{
+	uint r = fuzz_rand(seed);
+
+	switch (r % 8) {
+	case 0 ... 3:
+		return (r >> 3) % 128;
+	case 4 ... 6:
+		return (r >> 3) % 1024;
+	default:
+		return (r >> 3) % FUZZ_MAX_LEN;
+	}
+}
+
+/* Perform an operation one byte at a time, as a reference */
+static void fuzz_ref(enum fuzz_op op, u8 *buf, uint dst, uint src, uint len,
+		     int c)
+{
+	uint i;
+
+	switch (op) {
+	case FUZZ_MEMCPY:
+		for (i = 0; i < len; i++)
+			buf[dst + i] = buf[src + i];
+		break;
+	case FUZZ_MEMMOVE:
+		if (dst < src) {
+			for (i = 0; i < len; i++)
+				buf[dst + i] = buf[src + i];
+		} else {
+			for (i = len; i-- > 0;)
+				buf[dst + i] = buf[src + i];
+		}
+		break;
+	case FUZZ_MEMSET:
+		for (i = 0; i < len; i++)
+			buf[dst + i] = c;
+		break;
+	default:
+		break;
+	}
+}
+
+static void *fuzz_run(enum fuzz_op op, u8 *buf, uint dst, uint src, uint len,
+		      int c)
+{
+	switch (op) {
+	case FUZZ_MEMCPY:
+		return memcpy(buf + dst, buf + src, len);
+	case FUZZ_MEMMOVE:
+		return memmove(buf + dst, buf + src, len);
+	case FUZZ_MEMSET:
+		return memset(buf + dst, c, len);
+	default:
+		return NULL;
+	}
+}
+
+/* Test each operation with random lengths, alignments and overlaps */
+static int lib_test_string_fuzz(struct unit_test_state *uts)
+{
+	uint dst, src, len, i, seed = 0x9e3779b9;
+	u8 *buf, *ref;
+	enum fuzz_op op;
+	int c;
+
+	buf = malloc(FUZZ_BUF_SIZE);
+	ut_assertnonnull(buf);
+	ref = malloc(FUZZ_BUF_SIZE);
+	ut_assertnonnull(ref);
+	for (i = 0; i < FUZZ_BUF_SIZE; i++)
+		buf[i] = fuzz_rand(&seed);
+
+	for (i = 0; i < FUZZ_ROUNDS * FUZZ_OP_COUNT; i++) {
+		op = i % FUZZ_OP_COUNT;
+		len = fuzz_len(&seed);
+		c = fuzz_rand(&seed);
+		if (op == FUZZ_MEMMOVE) {
+			/* Areas close together, often overlapping */
+			src = fuzz_rand(&seed) % (FUZZ_BUF_SIZE - len - 512) +
+				256;
+			dst = src + fuzz_rand(&seed) % 512 - 256;
+		} else {
+			/* Non-overlapping areas in each half of the buffer */
+			src = fuzz_rand(&seed) % (FUZZ_BUF_SIZE / 2 - len);
+			dst = fuzz_rand(&seed) % (FUZZ_BUF_SIZE / 2 - len);
+			if (i & 1)
+				src += FUZZ_BUF_SIZE / 2;
+			else
+				dst += FUZZ_BUF_SIZE / 2;
+		}
+
+		memcpy(ref, buf, FUZZ_BUF_SIZE);
+		fuzz_ref(op, ref, dst, src, len, c);
+		ut_asserteq_ptr(buf + dst, fuzz_run(op, buf, dst, src, len, c));
+		ut_assertf(!memcmp(buf, ref, FUZZ_BUF_SIZE),
+			   "%s dst=%x src=%x len=%x c=%02x", fuzz_op_name[op],
+			   dst, src, len, c & 0xff);
+	}
+	free(ref);
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_string_fuzz, 0);
+
+#ifdef CONFIG_CMD_MEMBENCH
+/* Test that the benchmark command runs */
+static int lib_test_string_membench(struct unit_test_state *uts)
+{
+	ut_assertok(run_command("membench 1000", 0));
+
+	return 0;
+}
+LIB_TEST(lib_test_string_membench, 0);
+#endif
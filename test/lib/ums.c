@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for USB mass storage read-ahead and write-back, using the sandbox
+ * USB device controller
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <g_dnl.h>
+#include <malloc.h>
+#include <scsi.h>
+#include <usb_defs.h>
+#include <usb_mass_storage.h>
+#include <asm/test.h>
+#include <asm/unaligned.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+/* Configuration value of the download gadget */
+#define UMS_TEST_CONFIG		1
+
+/* Size of the medium, and of each READ or WRITE command from the host */
+#define UMS_TEST_SECTORS	(4 * SZ_1M / SECTOR_SIZE)
+#define UMS_TEST_CMD_SECTORS	(SZ_64K / SECTOR_SIZE)
+
+/* Commands needed to read or write 1MiB */
+#define UMS_TEST_CMDS_PER_MB	(SZ_1M / SZ_64K)
+
+/* FUA bit in byte 1 of a WRITE(10) command */
+#define UMS_TEST_FUA		0x08
+
+/**
+ * struct ums_test_medium - storage backed by memory
+ *
+ * @ums:	UMS device, whose read_sector() and write_sector() use @mem
+ * @mem:	Contents of the medium
+ * @fail_writes:	true to make all writes fail
+ */
+struct ums_test_medium {
+	struct ums ums;
+	u8 *mem;
+	bool fail_writes;
+};
+
+/**
+ * struct ums_test_cmd - a SCSI command for the host to send
+ *
+ * @op:		SCSI opcode: SCSI_READ10, SCSI_WRITE10 or SCSI_SYNC_CACHE
+ * @flags:	Byte 1 of the command
+ * @lba:	First sector
+ * @count:	Number of sectors
+ * @data:	Data to write, or buffer to read into
+ * @status:	Status which the gadget should return
+ */
+struct ums_test_cmd {
+	u8 op;
+	u8 flags;
+	u32 lba;
+	u32 count;
+	u8 *data;
+	u8 status;
+};
+
+enum ums_test_stage {
+	UMS_TEST_CBW,
+	UMS_TEST_DATA,
+	UMS_TEST_CSW,
+};
+
+/**
+ * struct ums_test_host - simulated host sending a list of commands
+ *
+ * @cmd:	Command being sent
+ * @left:	Number of commands left, including @cmd
+ * @stage:	Stage of the Bulk-Only Transport protocol reached
+ * @done:	Bytes of data moved so far for @cmd
+ * @tag:	Tag of @cmd
+ * @bad:	Number of commands with unexpected status
+ */
+struct ums_test_host {
+	struct ums_test_cmd *cmd;
+	int left;
+	enum ums_test_stage stage;
+	uint done;
+	u32 tag;
+	int bad;
+};
+
+static int ums_test_read(struct ums *ums_dev, ulong start, lbaint_t blkcnt,
+			 void *buf)
+{
+	struct ums_test_medium *med;
+
+	med = container_of(ums_dev, struct ums_test_medium, ums);
+	memcpy(buf, med->mem + start * SECTOR_SIZE, blkcnt * SECTOR_SIZE);
+
+	return blkcnt;
+}
+
+static int ums_test_write(struct ums *ums_dev, ulong start, lbaint_t blkcnt,
+			  const void *buf)
+{
+	struct ums_test_medium *med;
+
+	med = container_of(ums_dev, struct ums_test_medium, ums);
+	if (med->fail_writes)
+		return 0;
+	memcpy(med->mem + start * SECTOR_SIZE, buf, blkcnt * SECTOR_SIZE);
+
+	return blkcnt;
+}
+
+static void ums_test_cbw(struct ums_test_host *host,
+			 struct umass_bbb_cbw *cbw)
+{
+	struct ums_test_cmd *cmd = host->cmd;
+
+	memset(cbw, '\0', sizeof(*cbw));
+	cbw->dCBWSignature = cpu_to_le32(CBWSIGNATURE);
+	cbw->dCBWTag = host->tag;
+	cbw->dCBWDataTransferLength = cpu_to_le32(cmd->count * SECTOR_SIZE);
+	cbw->bCBWFlags = cmd->op == SCSI_READ10 ? CBWFLAGS_IN : CBWFLAGS_OUT;
+	cbw->bCDBLength = 10;
+	cbw->CBWCDB[0] = cmd->op;
+	cbw->CBWCDB[1] = cmd->flags;
+	put_unaligned_be32(cmd->lba, &cbw->CBWCDB[2]);
+	if (cmd->op != SCSI_SYNC_CACHE)
+		put_unaligned_be16(cmd->count, &cbw->CBWCDB[7]);
+}
+
+/* Take the next step for the host, if the gadget is ready for it */
+static void ums_test_poll(void *priv)
+{
+	struct ums_test_host *host = priv;
+	struct ums_test_cmd *cmd = host->cmd;
+	struct umass_bbb_cbw cbw;
+	struct umass_bbb_csw csw;
+	uint size;
+	int ret;
+
+	if (!host->left)
+		return;
+	size = cmd->op == SCSI_SYNC_CACHE ? 0 : cmd->count * SECTOR_SIZE;
+	switch (host->stage) {
+	case UMS_TEST_CBW:
+		ums_test_cbw(host, &cbw);
+		if (sandbox_udc_bulk_out(&cbw, UMASS_BBB_CBW_SIZE) < 0)
+			return;
+		host->done = 0;
+		host->stage = size ? UMS_TEST_DATA : UMS_TEST_CSW;
+		break;
+	case UMS_TEST_DATA:
+		if (cmd->op == SCSI_WRITE10)
+			ret = sandbox_udc_bulk_out(cmd->data + host->done,
+						   size - host->done);
+		else
+			ret = sandbox_udc_bulk_in(cmd->data + host->done,
+						  size - host->done);
+		if (ret < 0)
+			return;
+		host->done += ret;
+		if (host->done == size)
+			host->stage = UMS_TEST_CSW;
+		break;
+	case UMS_TEST_CSW:
+		ret = sandbox_udc_bulk_in(&csw, UMASS_BBB_CSW_SIZE);
+		if (ret < 0)
+			return;
+		if (ret != UMASS_BBB_CSW_SIZE ||
+		    csw.dCSWSignature != cpu_to_le32(CSWSIGNATURE) ||
+		    csw.dCSWTag != host->tag || csw.bCSWStatus != cmd->status)
+			host->bad++;
+		host->cmd++;
+		host->tag++;
+		host->stage = UMS_TEST_CBW;
+		if (!--host->left)
+			sandbox_udc_disconnect();
+		break;
+	}
+}
+
+static int ums_test_setup(struct unit_test_state *uts,
+			  struct ums_test_medium *med)
+{
+	uint i;
+
+	memset(med, '\0', sizeof(*med));
+	med->mem = malloc(UMS_TEST_SECTORS * SECTOR_SIZE);
+	ut_assertnonnull(med->mem);
+	for (i = 0; i < UMS_TEST_SECTORS * SECTOR_SIZE; i++)
+		med->mem[i] = i * 11 + (i >> 9);
+	med->ums.read_sector = ums_test_read;
+	med->ums.write_sector = ums_test_write;
+	med->ums.num_sectors = UMS_TEST_SECTORS;
+	med->ums.name = "UMS test";
+
+	return 0;
+}
+
+/* Send the commands and wait until the host has finished and unplugged */
+static int ums_test_run(struct unit_test_state *uts,
+			struct ums_test_medium *med, struct ums_test_cmd *cmds,
+			int count)
+{
+	struct ums_test_host host;
+
+	memset(&host, '\0', sizeof(host));
+	host.cmd = cmds;
+	host.left = count;
+	host.tag = 1;
+
+	ut_assertok(fsg_init(&med->ums, 1));
+	ut_assertok(g_dnl_register("usb_dnl_ums"));
+	sandbox_udc_set_host(ums_test_poll, &host);
+	ut_assertok(sandbox_udc_connect(UMS_TEST_CONFIG));
+	while (!fsg_main_thread(NULL))
+		;
+	g_dnl_unregister();
+	ut_asserteq(0, host.left);
+	ut_asserteq(0, host.bad);
+
+	return 0;
+}
+
+/* Add a READ(10) or WRITE(10) command for a 64KiB transfer */
+static struct ums_test_cmd *ums_test_rw(struct ums_test_cmd *cmd, u8 op,
+					u8 flags, u32 lba, u8 *data)
+{
+	cmd->op = op;
+	cmd->flags = flags;
+	cmd->lba = lba;
+	cmd->count = UMS_TEST_CMD_SECTORS;
+	cmd->data = data;
+
+	return cmd + 1;
+}
+
+/* Test that writes are gathered, and reach the medium when they should */
+static int lib_test_ums_write_back(struct unit_test_state *uts)
+{
+	struct ums_test_cmd cmds[UMS_TEST_CMDS_PER_MB + 6], *cmd = cmds;
+	struct ums_test_medium med;
+	u8 *data, *expect, *rdata;
+	uint i;
+
+	ut_assertok(ums_test_setup(uts, &med));
+	data = malloc(SZ_1M);
+	rdata = malloc(SZ_64K);
+	expect = malloc(UMS_TEST_SECTORS * SECTOR_SIZE);
+	ut_assertnonnull(data);
+	ut_assertnonnull(rdata);
+	ut_assertnonnull(expect);
+	for (i = 0; i < SZ_1M; i++)
+		data[i] = i * 3 + (i >> 12);
+	memcpy(expect, med.mem, UMS_TEST_SECTORS * SECTOR_SIZE);
+	memset(cmds, '\0', sizeof(cmds));
+
+	/* 1MiB in order, which fills the buffer once */
+	for (i = 0; i < UMS_TEST_CMDS_PER_MB; i++) {
+		cmd = ums_test_rw(cmd, SCSI_WRITE10, 0,
+				  i * UMS_TEST_CMD_SECTORS,
+				  data + i * SZ_64K);
+	}
+	memcpy(expect, data, SZ_1M);
+
+	/* A write with FUA goes straight to the medium, in each transfer */
+	cmd = ums_test_rw(cmd, SCSI_WRITE10, UMS_TEST_FUA, 4096, data);
+	memcpy(expect + 4096 * SECTOR_SIZE, data, SZ_64K);
+
+	/* Reading buffered data writes it out first */
+	cmd = ums_test_rw(cmd, SCSI_WRITE10, 0, 6000, data + SZ_64K);
+	cmd = ums_test_rw(cmd, SCSI_READ10, 0, 6000, rdata);
+	memcpy(expect + 6000 * SECTOR_SIZE, data + SZ_64K, SZ_64K);
+
+	/* A rewrite is written out by SYNCHRONIZE CACHE */
+	cmd = ums_test_rw(cmd, SCSI_WRITE10, 0, 100, data + 2 * SZ_64K);
+	memcpy(expect + 100 * SECTOR_SIZE, data + 2 * SZ_64K, SZ_64K);
+	cmd->op = SCSI_SYNC_CACHE;
+	cmd++;
+
+	ut_assertok(ums_test_run(uts, &med, cmds, cmd - cmds));
+	ut_assertok(memcmp(data + SZ_64K, rdata, SZ_64K));
+	ut_assertok(memcmp(expect, med.mem, UMS_TEST_SECTORS * SECTOR_SIZE));
+
+	/* Without write-back this would take 76 writes */
+	ut_asserteq(1 + 4 + 1 + 1, med.ums.stats.dev_writes);
+	ut_asserteq((UMS_TEST_CMDS_PER_MB + 3) * SZ_64K,
+		    med.ums.stats.write_bytes);
+	ut_asserteq(SZ_64K, med.ums.stats.read_bytes);
+
+	free(expect);
+	free(rdata);
+	free(data);
+	free(med.mem);
+
+	return 0;
+}
+LIB_TEST(lib_test_ums_write_back, 0);
+
+/* Test that reads in order are served from the read-ahead buffer */
+static int lib_test_ums_read_ahead(struct unit_test_state *uts)
+{
+	struct ums_test_cmd cmds[UMS_TEST_CMDS_PER_MB + 3], *cmd = cmds;
+	struct ums_stats *stats;
+	struct ums_test_medium med;
+	u8 *data, *wdata;
+	uint i;
+
+	ut_assertok(ums_test_setup(uts, &med));
+	data = malloc(SZ_1M + SZ_64K);
+	wdata = malloc(SZ_64K);
+	ut_assertnonnull(data);
+	ut_assertnonnull(wdata);
+	memset(wdata, '\xa5', SZ_64K);
+	memset(cmds, '\0', sizeof(cmds));
+
+	/* 1MiB in order */
+	for (i = 0; i < UMS_TEST_CMDS_PER_MB; i++) {
+		cmd = ums_test_rw(cmd, SCSI_READ10, 0,
+				  i * UMS_TEST_CMD_SECTORS,
+				  data + i * SZ_64K);
+	}
+
+	/* A write drops what it replaces from the read-ahead buffer */
+	cmd = ums_test_rw(cmd, SCSI_READ10, 0, 5000, data + SZ_1M);
+	cmd = ums_test_rw(cmd, SCSI_WRITE10, 0, 5064, wdata);
+	cmd = ums_test_rw(cmd, SCSI_READ10, 0, 5000, data + SZ_1M);
+
+	ut_assertok(ums_test_run(uts, &med, cmds, cmd - cmds));
+	ut_assertok(memcmp(med.mem, data, SZ_1M));
+	ut_assertok(memcmp(med.mem + 5000 * SECTOR_SIZE, data + SZ_1M,
+			   SZ_64K));
+	ut_assertok(memcmp(wdata, data + SZ_1M + 64 * SECTOR_SIZE, SZ_32K));
+
+	/*
+	 * The first command is read in one go, then each read carries on
+	 * from the last and fills the whole buffer. Without read-ahead this
+	 * would take 72 reads.
+	 */
+	stats = &med.ums.stats;
+	printf("UMS: 1 MiB read in order with %u device reads\n",
+	       stats->dev_reads - 2);
+	ut_asserteq(1 + DIV_ROUND_UP(SZ_1M - SZ_64K,
+				     CONFIG_UMS_READ_AHEAD_SIZE) + 2,
+		    stats->dev_reads);
+	ut_asserteq(SZ_1M + 2 * SZ_64K, stats->read_bytes);
+	ut_asserteq(SZ_1M + 2 * SZ_64K, stats->ra_bytes);
+	ut_asserteq(1, stats->dev_writes);
+
+	free(wdata);
+	free(data);
+	free(med.mem);
+
+	return 0;
+}
+LIB_TEST(lib_test_ums_read_ahead, 0);
+
+/* Test that a failed write-back is reported to the host, once */
+static int lib_test_ums_write_error(struct unit_test_state *uts)
+{
+	struct ums_test_cmd cmds[4], *cmd = cmds;
+	struct ums_test_medium med;
+	u8 *data;
+
+	ut_assertok(ums_test_setup(uts, &med));
+	med.fail_writes = true;
+	data = malloc(SZ_64K);
+	ut_assertnonnull(data);
+	memset(data, '\x5a', SZ_64K);
+	memset(cmds, '\0', sizeof(cmds));
+
+	cmd = ums_test_rw(cmd, SCSI_WRITE10, 0, 0, data);
+	cmd->op = SCSI_SYNC_CACHE;
+	cmd->status = CSWSTATUS_FAILED;
+	cmd++;
+	cmd->op = SCSI_SYNC_CACHE;
+	cmd++;
+
+	/* Writing through to the medium fails straight away */
+	cmd = ums_test_rw(cmd, SCSI_WRITE10, UMS_TEST_FUA, 0, data);
+	cmd[-1].status = CSWSTATUS_FAILED;
+
+	ut_assertok(ums_test_run(uts, &med, cmds, cmd - cmds));
+	ut_asserteq(SZ_64K, med.ums.stats.write_bytes);
+	ut_asserteq(2, med.ums.stats.dev_writes);
+
+	free(data);
+	free(med.mem);
+
+	return 0;
+}
+LIB_TEST(lib_test_ums_write_error, 0);
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for cooperative threads
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <console.h>
+#include <errno.h>
+#include <membuff.h>
+#include <uthread.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of fake devices, and how long each takes to become ready */
+#define FAKE_DEV_COUNT		4
+#define FAKE_DEV_DELAY_US	50000
+
+/**
+ * struct order_thread - a thread which logs each time it runs
+ *
+ * @log:	Log shared by all threads
+ * @posp:	Next position in @log, shared by all threads
+ * @id:		Character to log
+ * @count:	Number of times to run
+ * @ret:	Value to return
+ * @create_ret:	Returns the result of trying to create a thread
+ */
+struct order_thread {
+	char *log;
+	int *posp;
+	char id;
+	int count;
+	int ret;
+	int create_ret;
+};
+
+static int order_thread_run(void *arg)
+{
+	struct order_thread *ot = arg;
+	int i;
+
+	ot->create_ret = uthread_create(order_thread_run, arg, "nested");
+	for (i = 0; i < ot->count; i++) {
+		ot->log[(*ot->posp)++] = ot->id;
+		printf("%c%d\n", ot->id, i);
+		uthread_schedule();
+	}
+
+	return ot->ret;
+}
+
+/* Test that threads take turns and that their output stays in order */
+static int lib_test_uthread_order(struct unit_test_state *uts)
+{
+	struct order_thread ot[3] = {
+		{ .id = 'a', .count = 3 },
+		{ .id = 'b', .count = 1 },
+		{ .id = 'c', .count = 2, .ret = -EIO },
+	};
+	char log[10], *data;
+	int pos = 0;
+	int i, len;
+
+	memset(log, '\0', sizeof(log));
+	for (i = 0; i < ARRAY_SIZE(ot); i++) {
+		ot[i].log = log;
+		ot[i].posp = &pos;
+		ut_assertok(uthread_create(order_thread_run, &ot[i], "order"));
+	}
+	ut_asserteq_ptr(NULL, uthread_self());
+
+	console_record_reset_enable();
+	ut_asserteq(-EIO, uthread_join_all());
+	gd->flags &= ~GD_FLG_RECORD;
+	len = membuff_getraw(&gd->console_out, -1, true, &data);
+	data[len] = '\0';
+
+	ut_asserteq_str("abcaca", log);
+	ut_asserteq_str("a0\na1\na2\nb0\nc0\nc1\n", data);
+	for (i = 0; i < ARRAY_SIZE(ot); i++)
+		ut_asserteq(-EPERM, ot[i].create_ret);
+	ut_asserteq_ptr(NULL, uthread_self());
+
+	/* There is nothing left to run */
+	ut_assertok(uthread_join_all());
+
+	return 0;
+}
+LIB_TEST(lib_test_uthread_order, 0);
+
+/**
+ * struct fake_dev - a device which takes a while to become ready
+ *
+ * @delay_us:	Time taken to become ready
+ * @polls:	Number of times the device was polled
+ */
+struct fake_dev {
+	ulong delay_us;
+	int polls;
+};
+
+/* Wait for the device to be ready, polling it as a real driver would */
+static int fake_dev_init(void *arg)
+{
+	struct fake_dev *dev = arg;
+	ulong start = timer_get_us();
+
+	while (timer_get_us() - start < dev->delay_us) {
+		dev->polls++;
+		udelay(1000);
+	}
+
+	return 0;
+}
+
+/*
+ * Test that waiting for several devices takes about as long as waiting for
+ * one, when each is set up in its own thread
+ */
+static int lib_test_uthread_delay(struct unit_test_state *uts)
+{
+	struct fake_dev dev[FAKE_DEV_COUNT];
+	ulong start, serial, threaded;
+	int i;
+
+	for (i = 0; i < FAKE_DEV_COUNT; i++) {
+		dev[i].delay_us = FAKE_DEV_DELAY_US;
+		dev[i].polls = 0;
+	}
+
+	start = get_timer(0);
+	for (i = 0; i < FAKE_DEV_COUNT; i++)
+		ut_assertok(fake_dev_init(&dev[i]));
+	serial = get_timer(start);
+
+	start = get_timer(0);
+	for (i = 0; i < FAKE_DEV_COUNT; i++)
+		ut_assertok(uthread_create(fake_dev_init, &dev[i], "fake"));
+	ut_assertok(uthread_join_all());
+	threaded = get_timer(start);
+
+	printf("%d devices: one at a time %lums, in threads %lums\n",
+	       FAKE_DEV_COUNT, serial, threaded);
+	ut_assert(serial >= FAKE_DEV_COUNT * FAKE_DEV_DELAY_US / 1000);
+	ut_assert(threaded * 2 < serial);
+	for (i = 0; i < FAKE_DEV_COUNT; i++)
+		ut_assert(dev[i].polls > 0);
+
+	return 0;
+}
+LIB_TEST(lib_test_uthread_delay, 0);
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for parallel jobs on the secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <worker.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+/* Number of parts in a job, more than the number of CPUs */
+#define WORKER_TEST_PARTS	20
+
+/* Size of memory regions, so that the last part is short */
+#define WORKER_TEST_SIZE	(3 * SZ_1M + 100)
+
+/**
+ * struct part_log - record of which parts of a job have run
+ *
+ * @count:	Number of times each part has run
+ * @nested:	Number of times each part of a nested job has run
+ */
+struct part_log {
+	int count[WORKER_TEST_PARTS];
+	int nested[WORKER_TEST_PARTS][2];
+};
+
+static void nested_part(void *arg, int part)
+{
+	int *nested = arg;
+
+	nested[part]++;
+}
+
+static void log_part(void *arg, int part)
+{
+	struct part_log *log = arg;
+
+	log->count[part]++;
+	worker_run(nested_part, log->nested[part], 2);
+}
+
+/* Test that each part of a job runs exactly once */
+static int lib_test_worker_run(struct unit_test_state *uts)
+{
+	struct part_log log;
+	int i;
+
+	memset(&log, '\0', sizeof(log));
+	ut_asserteq(CONFIG_WORKER_MAX_CPUS, worker_start());
+	ut_asserteq(CONFIG_WORKER_MAX_CPUS, worker_count());
+	worker_run(log_part, &log, WORKER_TEST_PARTS);
+	for (i = 0; i < WORKER_TEST_PARTS; i++) {
+		ut_asserteq(1, log.count[i]);
+		ut_asserteq(1, log.nested[i][0]);
+		ut_asserteq(1, log.nested[i][1]);
+	}
+
+	/* Once stopped, jobs start the CPUs again */
+	worker_stop();
+	ut_asserteq(1, worker_count());
+	worker_run(log_part, &log, WORKER_TEST_PARTS);
+	ut_asserteq(CONFIG_WORKER_MAX_CPUS, worker_count());
+	for (i = 0; i < WORKER_TEST_PARTS; i++)
+		ut_asserteq(2, log.count[i]);
+	worker_stop();
+
+	return 0;
+}
+LIB_TEST(lib_test_worker_run, 0);
+
+/* Test copying and filling memory with all CPUs */
+static int lib_test_worker_mem(struct unit_test_state *uts)
+{
+	char *src, *dest;
+	int i;
+
+	src = malloc(WORKER_TEST_SIZE);
+	dest = malloc(WORKER_TEST_SIZE + 1);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dest);
+	for (i = 0; i < WORKER_TEST_SIZE; i++)
+		src[i] = i * 7 + (i >> 12);
+	dest[WORKER_TEST_SIZE] = 0x5a;
+
+	worker_memcpy(dest, src, WORKER_TEST_SIZE);
+	ut_assert(worker_count() > 1);
+	ut_assertok(memcmp(dest, src, WORKER_TEST_SIZE));
+	ut_asserteq(0x5a, dest[WORKER_TEST_SIZE]);
+
+	worker_memset(dest, 0xa5, WORKER_TEST_SIZE);
+	for (i = 0; i < WORKER_TEST_SIZE; i++) {
+		if (dest[i] != (char)0xa5)
+			break;
+	}
+	ut_asserteq(WORKER_TEST_SIZE, i);
+	ut_asserteq(0x5a, dest[WORKER_TEST_SIZE]);
+
+	/* Small regions are done on the boot CPU */
+	worker_stop();
+	worker_memcpy(dest, src, SZ_4K);
+	ut_asserteq(1, worker_count());
+	ut_assertok(memcmp(dest, src, SZ_4K));
+
+	free(dest);
+	free(src);
+
+	return 0;
+}
+LIB_TEST(lib_test_worker_mem, 0);
+
+/* Test that memory errors found by several CPUs are reported in order */
+static int lib_test_worker_memtest(struct unit_test_state *uts)
+{
+	const u64 pattern = 0x0123456789abcdefULL;
+	struct memtest_result res;
+	ulong size = 4 * SZ_1M;
+	ulong addr;
+	u64 *buf;
+
+	buf = memalign(SZ_4K, size);
+	ut_assertnonnull(buf);
+	addr = map_to_sysmem(buf);
+
+	worker_start();
+	memtest_fill(addr, size, pattern);
+	buf[SZ_1M / sizeof(u64) * 3] ^= 1 << 3;
+	buf[SZ_1M / sizeof(u64) + 5] ^= 1ULL << 40;
+
+	memset(&res, '\0', sizeof(res));
+	ut_assertok(memtest_check(addr, size, pattern, &res));
+	ut_asserteq(2, res.errors);
+	ut_asserteq(addr + SZ_1M + 5 * sizeof(u64), res.first_fail);
+	ut_assert(res.fail_bits == (1ULL << 40 | 1 << 3));
+	ut_assert(res.bytes == size);
+	worker_stop();
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_worker_memtest, 0);
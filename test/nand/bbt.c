@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for the bad block table and reading / writing around bad blocks
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <nand.h>
+#include <asm/test.h>
+#include <test/nand.h>
+#include <test/ut.h>
+
+/* Area used by the tests, with two bad blocks near the start */
+#define AREA_BLOCK		16
+#define AREA_BLOCKS		10
+#define BAD_BLOCK1		(AREA_BLOCK + 1)
+#define BAD_BLOCK2		(AREA_BLOCK + 3)
+
+/* Number of good blocks written by the tests */
+#define DATA_BLOCKS		4
+
+/**
+ * scrub_area() - Erase the test area, including any bad blocks
+ *
+ * This also drops the RAM-based bad block table, so that it is built again
+ * from the markers on the chip.
+ *
+ * @mtd:	MTD device to erase
+ * @return 0 if OK, -ve on error
+ */
+static int scrub_area(struct mtd_info *mtd)
+{
+	nand_erase_options_t opts;
+
+	memset(&opts, '\0', sizeof(opts));
+	opts.offset = (loff_t)AREA_BLOCK * mtd->erasesize;
+	opts.length = AREA_BLOCKS * mtd->erasesize;
+	opts.scrub = 1;
+	opts.quiet = 1;
+
+	return nand_erase_opts(mtd, &opts);
+}
+
+/* Test that reads and writes skip bad blocks, which are found on demand */
+static int nand_test_bbt_skip_bad(struct unit_test_state *uts)
+{
+	struct mtd_info *mtd = nand_info[0];
+	loff_t offset = (loff_t)AREA_BLOCK * mtd->erasesize;
+	size_t size = DATA_BLOCKS * mtd->erasesize;
+	size_t lim = AREA_BLOCKS * mtd->erasesize;
+	struct sandbox_nand_stats stats;
+	int pages = mtd->erasesize / mtd->writesize;
+	size_t len, actual;
+	u8 *buf, *expect;
+	int i;
+
+	ut_assertok(scrub_area(mtd));
+	sandbox_nand_mark_bad(BAD_BLOCK1);
+	sandbox_nand_mark_bad(BAD_BLOCK2);
+
+	expect = malloc(size);
+	ut_assertnonnull(expect);
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	for (i = 0; i < size; i++)
+		expect[i] = i * 7 + (i >> 12);
+
+	/* Only the markers of the blocks which are written should be read */
+	len = size;
+	sandbox_nand_clear_stats();
+	ut_assertok(nand_write_skip_bad(mtd, offset, &len, &actual, lim, expect,
+					0));
+	sandbox_nand_get_stats(&stats);
+	ut_asserteq(size, len);
+	ut_asserteq(size + 2 * mtd->erasesize, actual);
+	ut_asserteq(DATA_BLOCKS + 2, stats.page_reads);
+	ut_asserteq(DATA_BLOCKS * pages, stats.page_progs);
+
+	ut_asserteq(1, mtd_block_isbad(mtd, (loff_t)BAD_BLOCK1 *
+				       mtd->erasesize));
+	ut_asserteq(1, mtd_block_isbad(mtd, (loff_t)BAD_BLOCK2 *
+				       mtd->erasesize));
+	ut_asserteq(0, mtd_block_isbad(mtd, offset));
+
+	/* Now the table is known, so reading only reads the data */
+	len = size;
+	memset(buf, '\0', size);
+	sandbox_nand_clear_stats();
+	ut_assertok(nand_read_skip_bad(mtd, offset, &len, &actual, lim, buf));
+	sandbox_nand_get_stats(&stats);
+	ut_asserteq(size, len);
+	ut_asserteq(size + 2 * mtd->erasesize, actual);
+	ut_asserteq(DATA_BLOCKS * pages, stats.page_reads);
+	ut_assertok(memcmp(expect, buf, size));
+
+	/* An unaligned length, ending just after the first bad block */
+	len = mtd->erasesize + mtd->writesize;
+	memset(buf, '\0', size);
+	ut_assertok(nand_read_skip_bad(mtd, offset, &len, &actual, lim, buf));
+	ut_asserteq(2 * mtd->erasesize + mtd->writesize, actual);
+	ut_assertok(memcmp(expect, buf, len));
+
+	/* Skipping the bad blocks must not go past the limit */
+	len = size;
+	ut_asserteq(-EFBIG, nand_read_skip_bad(mtd, offset, &len, NULL,
+					       size + mtd->erasesize, buf));
+	ut_asserteq(0, len);
+
+	ut_assertok(scrub_area(mtd));
+	free(buf);
+	free(expect);
+
+	return 0;
+}
+NAND_TEST(nand_test_bbt_skip_bad, 0);
+
+/* Test that a block marked bad is seen as bad without scanning it again */
+static int nand_test_bbt_markbad(struct unit_test_state *uts)
+{
+	struct mtd_info *mtd = nand_info[0];
+	loff_t offset = (loff_t)(AREA_BLOCK + 5) * mtd->erasesize;
+	struct sandbox_nand_stats stats;
+
+	ut_assertok(scrub_area(mtd));
+	ut_assertok(mtd_block_markbad(mtd, offset));
+
+	sandbox_nand_clear_stats();
+	ut_asserteq(1, mtd_block_isbad(mtd, offset));
+	sandbox_nand_get_stats(&stats);
+	ut_asserteq(0, stats.page_reads);
+
+	/* Scrubbing removes the marker again */
+	ut_assertok(scrub_area(mtd));
+	ut_asserteq(0, mtd_block_isbad(mtd, offset));
+
+	return 0;
+}
+NAND_TEST(nand_test_bbt_markbad, 0);
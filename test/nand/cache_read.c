@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for sequential page reads using the NAND cache register
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <nand.h>
+#include <linux/mtd/nand.h>
+#include <asm/test.h>
+#include <test/nand.h>
+#include <test/ut.h>
+
+/* Area used by the tests: two blocks, away from the start of the chip */
+#define TEST_OFFSET		0x40000
+#define TEST_BLOCKS		2
+
+/**
+ * setup_area() - Erase the test area and fill it with a pattern
+ *
+ * @mtd:	MTD device to write
+ * @bufp:	Returns an allocated buffer holding the pattern
+ * @sizep:	Returns the size of the test area
+ * @return 0 if OK, -ve on error
+ */
+static int setup_area(struct mtd_info *mtd, u8 **bufp, size_t *sizep)
+{
+	size_t size = mtd->erasesize * TEST_BLOCKS;
+	struct erase_info instr;
+	u8 *buf;
+	int ret;
+	int i;
+
+	memset(&instr, '\0', sizeof(instr));
+	instr.mtd = mtd;
+	instr.addr = TEST_OFFSET;
+	instr.len = size;
+	ret = mtd_erase(mtd, &instr);
+	if (ret)
+		return ret;
+
+	buf = malloc(size);
+	if (!buf)
+		return -ENOMEM;
+	for (i = 0; i < size; i++)
+		buf[i] = i ^ (i >> 8) ^ (i >> 16);
+	ret = nand_write(mtd, TEST_OFFSET, &size, buf);
+	if (ret) {
+		free(buf);
+		return ret;
+	}
+	*bufp = buf;
+	*sizep = size;
+
+	return 0;
+}
+
+/**
+ * read_area() - Read from NAND with cache reads enabled or disabled
+ *
+ * @mtd:	MTD device to read
+ * @cache:	true to allow cache reads
+ * @offset:	Offset to read from
+ * @size:	Number of bytes to read
+ * @buf:	Buffer for the data
+ * @stats:	Returns the chip activity for the read
+ * @return result of nand_read()
+ */
+static int read_area(struct mtd_info *mtd, bool cache, loff_t offset,
+		     size_t size, u8 *buf, struct sandbox_nand_stats *stats)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	ulong old_options = chip->options;
+	int ret;
+
+	if (cache)
+		chip->options |= NAND_CACHE_READ;
+	else
+		chip->options &= ~NAND_CACHE_READ;
+	/* Make sure that nothing comes from the driver's page buffer */
+	chip->pagebuf = -1;
+	sandbox_nand_clear_stats();
+	ret = nand_read(mtd, offset, &size, buf);
+	sandbox_nand_get_stats(stats);
+	chip->options = old_options;
+
+	return ret;
+}
+
+/* Test that the chip is detected as supporting cache reads */
+static int nand_test_cache_detect(struct unit_test_state *uts)
+{
+	struct mtd_info *mtd = nand_info[0];
+
+	ut_assertnonnull(mtd);
+	ut_assert(NAND_HAS_CACHE_READ(mtd_to_nand(mtd)));
+
+	return 0;
+}
+NAND_TEST(nand_test_cache_detect, 0);
+
+/* Test that a block reads the same with and without cache reads, but faster */
+static int nand_test_cache_read(struct unit_test_state *uts)
+{
+	struct sandbox_nand_stats plain, cached;
+	struct mtd_info *mtd = nand_info[0];
+	int pages = mtd->erasesize / mtd->writesize;
+	u8 *buf, *expect;
+	size_t size;
+
+	ut_assertok(setup_area(mtd, &expect, &size));
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+
+	memset(buf, '\0', size);
+	ut_assertok(read_area(mtd, false, TEST_OFFSET, mtd->erasesize, buf,
+			      &plain));
+	ut_assertok(memcmp(expect, buf, mtd->erasesize));
+	ut_asserteq(pages, plain.page_reads);
+	ut_asserteq(0, plain.cache_reads);
+
+	memset(buf, '\0', size);
+	ut_assertok(read_area(mtd, true, TEST_OFFSET, mtd->erasesize, buf,
+			      &cached));
+	ut_assertok(memcmp(expect, buf, mtd->erasesize));
+	ut_asserteq(pages, cached.page_reads);
+	ut_asserteq(pages - 1, cached.cache_reads);
+	ut_assert(cached.time_ns < plain.time_ns);
+	printf("Block read: %llu us, %llu us with cache reads\n",
+	       plain.time_ns / 1000, cached.time_ns / 1000);
+
+	/* A single page does not use a cache read */
+	ut_assertok(read_area(mtd, true, TEST_OFFSET, mtd->writesize, buf,
+			      &cached));
+	ut_asserteq(1, cached.page_reads);
+	ut_asserteq(0, cached.cache_reads);
+
+	free(buf);
+	free(expect);
+
+	return 0;
+}
+NAND_TEST(nand_test_cache_read, 0);
+
+/* Test an unaligned read which crosses a block boundary */
+static int nand_test_cache_unaligned(struct unit_test_state *uts)
+{
+	struct sandbox_nand_stats stats;
+	struct mtd_info *mtd = nand_info[0];
+	size_t size, start, len;
+	u8 *buf, *expect;
+
+	ut_assertok(setup_area(mtd, &expect, &size));
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+
+	/* Start part-way into the last two pages of the first block */
+	start = mtd->erasesize - 2 * mtd->writesize + 100;
+	len = 4 * mtd->writesize;
+	memset(buf, '\0', size);
+	ut_assertok(read_area(mtd, true, TEST_OFFSET + start, len, buf,
+			      &stats));
+	ut_assertok(memcmp(expect + start, buf, len));
+
+	/* Cache reads do not cross into the next block */
+	ut_asserteq(5, stats.page_reads);
+	ut_asserteq(3, stats.cache_reads);
+
+	free(buf);
+	free(expect);
+
+	return 0;
+}
+NAND_TEST(nand_test_cache_unaligned, 0);
+
+/* Test that a bit flip in a page read from the cache is corrected */
+static int nand_test_cache_bitflip(struct unit_test_state *uts)
+{
+	struct sandbox_nand_stats stats;
+	struct mtd_info *mtd = nand_info[0];
+	u8 *buf, *expect;
+	size_t size;
+
+	ut_assertok(setup_area(mtd, &expect, &size));
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+
+	sandbox_nand_flip_bit(TEST_OFFSET + 5 * mtd->writesize + 1234, 3);
+	memset(buf, '\0', size);
+	ut_asserteq(-EUCLEAN, read_area(mtd, true, TEST_OFFSET, size, buf,
+					&stats));
+	ut_assertok(memcmp(expect, buf, size));
+	ut_asserteq(size / mtd->writesize - TEST_BLOCKS, stats.cache_reads);
+
+	free(buf);
+	free(expect);
+
+	return 0;
+}
+NAND_TEST(nand_test_cache_bitflip, 0);
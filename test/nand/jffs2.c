@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for scanning and loading files from JFFS2 on NAND
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <nand.h>
+#include <jffs2/jffs2.h>
+#include <jffs2/jffs2_1pass.h>
+#include <jffs2/load_kernel.h>
+#include <linux/mtd/nand.h>
+#include <linux/stat.h>
+#include <u-boot/crc.h>
+#include <asm/test.h>
+#include <test/nand.h>
+#include <test/ut.h>
+#include "summary.h"
+
+/* Area used by the tests, away from the start of the chip */
+#define TEST_OFFSET		0x100000
+#define TEST_BLOCKS		8
+
+#define TEST_FILES		40
+#define TEST_FILE_SIZE		10000
+#define TEST_NODE_DATA		4096	/* most data held by one node */
+#define TEST_SUM_SIZE		4096	/* room for summary entries */
+
+#define BOOT_INO		2
+#define FIRST_FILE_INO		3
+
+/**
+ * struct jffs2_image - a JFFS2 image being built in memory
+ *
+ * @buf:	The image, TEST_BLOCKS erase blocks which start off erased
+ * @block_size:	Size of an erase block
+ * @ofs:	Offset in @buf where the next node goes
+ * @summary:	true to end each erase block with a summary node
+ * @sum:	Summary entries for the erase block being filled
+ * @sum_len:	Number of bytes used in @sum
+ * @sum_num:	Number of entries in @sum
+ */
+struct jffs2_image {
+	u8 *buf;
+	u32 block_size;
+	u32 ofs;
+	bool summary;
+	u8 sum[TEST_SUM_SIZE];
+	u32 sum_len;
+	u32 sum_num;
+};
+
+static u32 node_crc(const void *data, uint len)
+{
+	return crc32_no_comp(0, data, len);
+}
+
+/* Fill the data of a file, @gen being the generation of the data */
+static void fill_data(u8 *buf, u32 ino, u32 offset, u32 len, int gen)
+{
+	u32 i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = ino * 7 + (offset + i) * 13 + gen;
+}
+
+/* Finish the current erase block, adding a summary node if needed */
+static void close_block(struct jffs2_image *img)
+{
+	u32 block = img->ofs / img->block_size * img->block_size;
+	struct jffs2_raw_summary *sum;
+	struct jffs2_sum_marker *sm;
+	u32 ofs;
+
+	if (img->summary && img->sum_num) {
+		ofs = img->block_size - sizeof(*sum) - img->sum_len -
+			sizeof(*sm);
+		ofs &= ~3;
+		sum = (void *)img->buf + block + ofs;
+		memset(sum, '\0', img->block_size - ofs);
+		sum->magic = JFFS2_MAGIC_BITMASK;
+		sum->nodetype = JFFS2_NODETYPE_SUMMARY;
+		sum->totlen = img->block_size - ofs;
+		sum->hdr_crc = node_crc(sum,
+					sizeof(struct jffs2_unknown_node) - 4);
+		sum->sum_num = img->sum_num;
+		memcpy(sum->sum, img->sum, img->sum_len);
+		sm = (void *)img->buf + block + img->block_size - sizeof(*sm);
+		sm->offset = ofs;
+		sm->magic = JFFS2_SUM_MAGIC;
+		sum->sum_crc = node_crc(sum->sum, sum->totlen - sizeof(*sum));
+		sum->node_crc = node_crc(sum, sizeof(*sum) - 8);
+	}
+	img->ofs = block + img->block_size;
+	img->sum_len = 0;
+	img->sum_num = 0;
+}
+
+/**
+ * reserve() - Make room for a node in the current erase block
+ *
+ * @img:	Image being built
+ * @len:	Length of the node
+ * @entry_len:	Length of its summary entry
+ * @return 0 if OK, -ENOSPC if the image is full
+ */
+static int reserve(struct jffs2_image *img, u32 len, u32 entry_len)
+{
+	u32 room = img->block_size - img->ofs % img->block_size;
+	u32 need = ALIGN(len, 4);
+
+	if (img->summary) {
+		if (img->sum_len + entry_len > TEST_SUM_SIZE)
+			return -ENOSPC;
+		need += sizeof(struct jffs2_raw_summary) + img->sum_len +
+			entry_len + sizeof(struct jffs2_sum_marker) + 4;
+	}
+	if (need > room) {
+		close_block(img);
+		if (img->ofs >= TEST_BLOCKS * img->block_size)
+			return -ENOSPC;
+	}
+
+	return 0;
+}
+
+static int write_inode(struct jffs2_image *img, u32 ino, u32 version,
+		       u32 mode, u32 offset, const u8 *data, u32 dsize)
+{
+	struct jffs2_sum_inode_flash *spi;
+	struct jffs2_raw_inode *ri;
+	u32 len = sizeof(*ri) + dsize;
+
+	if (reserve(img, len, sizeof(*spi)))
+		return -ENOSPC;
+	ri = (void *)img->buf + img->ofs;
+	memset(ri, '\0', sizeof(*ri));
+	ri->magic = JFFS2_MAGIC_BITMASK;
+	ri->nodetype = JFFS2_NODETYPE_INODE;
+	ri->totlen = len;
+	ri->hdr_crc = node_crc(ri, sizeof(struct jffs2_unknown_node) - 4);
+	ri->ino = ino;
+	ri->version = version;
+	ri->mode = mode;
+	ri->isize = S_ISDIR(mode) ? 0 : TEST_FILE_SIZE;
+	ri->offset = offset;
+	ri->csize = dsize;
+	ri->dsize = dsize;
+	ri->compr = JFFS2_COMPR_NONE;
+	memcpy(ri + 1, data, dsize);
+	ri->data_crc = node_crc(ri + 1, dsize);
+	ri->node_crc = node_crc(ri, sizeof(*ri) - 8);
+
+	spi = (void *)img->sum + img->sum_len;
+	spi->nodetype = JFFS2_NODETYPE_INODE;
+	spi->inode = ino;
+	spi->version = version;
+	spi->offset = img->ofs % img->block_size;
+	spi->totlen = len;
+	img->sum_len += sizeof(*spi);
+	img->sum_num++;
+	img->ofs += ALIGN(len, 4);
+
+	return 0;
+}
+
+static int write_dirent(struct jffs2_image *img, u32 pino, u32 version,
+			u32 ino, u8 type, const char *name)
+{
+	struct jffs2_sum_dirent_flash *spd;
+	struct jffs2_raw_dirent *rd;
+	u32 nsize = strlen(name);
+	u32 len = sizeof(*rd) + nsize;
+
+	if (reserve(img, len, sizeof(*spd) + nsize))
+		return -ENOSPC;
+	rd = (void *)img->buf + img->ofs;
+	memset(rd, '\0', sizeof(*rd));
+	rd->magic = JFFS2_MAGIC_BITMASK;
+	rd->nodetype = JFFS2_NODETYPE_DIRENT;
+	rd->totlen = len;
+	rd->hdr_crc = node_crc(rd, sizeof(struct jffs2_unknown_node) - 4);
+	rd->pino = pino;
+	rd->version = version;
+	rd->ino = ino;
+	rd->nsize = nsize;
+	rd->type = type;
+	memcpy(rd->name, name, nsize);
+	rd->name_crc = node_crc(rd->name, nsize);
+	rd->node_crc = node_crc(rd, sizeof(*rd) - 8);
+
+	spd = (void *)img->sum + img->sum_len;
+	spd->nodetype = JFFS2_NODETYPE_DIRENT;
+	spd->totlen = len;
+	spd->offset = img->ofs % img->block_size;
+	spd->pino = pino;
+	spd->version = version;
+	spd->ino = ino;
+	spd->nsize = nsize;
+	spd->type = type;
+	memcpy(spd->name, name, nsize);
+	img->sum_len += sizeof(*spd) + nsize;
+	img->sum_num++;
+	img->ofs += ALIGN(len, 4);
+
+	return 0;
+}
+
+/**
+ * build_image() - Build an image holding /boot and the test files in it
+ *
+ * Each file is written in nodes of up to TEST_NODE_DATA bytes. The first
+ * file then has its first node replaced by one with a newer version, which
+ * is last in the image.
+ *
+ * @img:	Image to build, with @buf and @block_size set up
+ * @summary:	true to add a summary node to each erase block
+ * @return 0 if OK, -ve on error
+ */
+static int build_image(struct jffs2_image *img, bool summary)
+{
+	u8 data[TEST_NODE_DATA];
+	u32 ino, ofs, version;
+	char name[20];
+	int ret;
+	int i;
+
+	memset(img->buf, 0xff, TEST_BLOCKS * img->block_size);
+	img->summary = summary;
+	img->ofs = 0;
+	img->sum_len = 0;
+	img->sum_num = 0;
+
+	ret = write_inode(img, BOOT_INO, 1, S_IFDIR | 0755, 0, NULL, 0);
+	if (!ret)
+		ret = write_dirent(img, 1, 1, BOOT_INO, DT_DIR, "boot");
+	for (i = 0; !ret && i < TEST_FILES; i++) {
+		ino = FIRST_FILE_INO + i;
+		snprintf(name, sizeof(name), "file%02d", i);
+		ret = write_dirent(img, BOOT_INO, i + 1, ino, DT_REG, name);
+		for (ofs = 0, version = 1; !ret && ofs < TEST_FILE_SIZE;
+		     ofs += TEST_NODE_DATA, version++) {
+			u32 len = min_t(u32, TEST_NODE_DATA,
+					TEST_FILE_SIZE - ofs);
+
+			fill_data(data, ino, ofs, len, 0);
+			ret = write_inode(img, ino, version, S_IFREG | 0644,
+					  ofs, data, len);
+		}
+	}
+	if (ret)
+		return ret;
+
+	fill_data(data, FIRST_FILE_INO, 0, TEST_NODE_DATA, 1);
+	ret = write_inode(img, FIRST_FILE_INO, 100, S_IFREG | 0644, 0, data,
+			  TEST_NODE_DATA);
+	if (ret)
+		return ret;
+	close_block(img);
+
+	return 0;
+}
+
+/**
+ * setup_image() - Build an image and write it to the test area
+ *
+ * @mtd:	MTD device to write
+ * @summary:	true to add summary nodes
+ * @return 0 if OK, -ve on error
+ */
+static int setup_image(struct mtd_info *mtd, bool summary)
+{
+	struct jffs2_image *img;
+	struct erase_info instr;
+	size_t size = mtd->erasesize * TEST_BLOCKS;
+	int ret;
+
+	img = calloc(1, sizeof(*img));
+	if (!img)
+		return -ENOMEM;
+	img->block_size = mtd->erasesize;
+	img->buf = malloc(size);
+	if (!img->buf) {
+		free(img);
+		return -ENOMEM;
+	}
+	ret = build_image(img, summary);
+	if (!ret) {
+		memset(&instr, '\0', sizeof(instr));
+		instr.mtd = mtd;
+		instr.addr = TEST_OFFSET;
+		instr.len = size;
+		ret = mtd_erase(mtd, &instr);
+	}
+	if (!ret)
+		ret = nand_write(mtd, TEST_OFFSET, &size, img->buf);
+	free(img->buf);
+	free(img);
+
+	return ret;
+}
+
+/* Set up a partition covering the test area of NAND device 0 */
+static void setup_part(struct mtd_info *mtd, struct part_info *part,
+		       struct mtd_device *dev, struct mtdids *id)
+{
+	memset(id, '\0', sizeof(*id));
+	id->type = MTD_DEV_TYPE_NAND;
+	id->num = 0;
+	id->size = mtd->size;
+
+	memset(dev, '\0', sizeof(*dev));
+	dev->id = id;
+
+	memset(part, '\0', sizeof(*part));
+	part->name = "jffs2";
+	part->offset = TEST_OFFSET;
+	part->size = mtd->erasesize * TEST_BLOCKS;
+	part->sector_size = mtd->erasesize;
+	part->dev = dev;
+}
+
+/**
+ * load_file() - Load a file from the test partition and check it
+ *
+ * @uts:	Test state
+ * @part:	Partition to load from
+ * @num:	Number of the file to load, 0 to TEST_FILES - 1
+ * @stats:	Returns the chip activity for the load
+ * @return 0 if OK, -ve on error
+ */
+static int load_file(struct unit_test_state *uts, struct part_info *part,
+		     int num, struct sandbox_nand_stats *stats)
+{
+	struct mtd_info *mtd = nand_info[0];
+	u32 ino = FIRST_FILE_INO + num;
+	u8 *buf, *expect;
+	char fname[30];
+	u32 size;
+
+	buf = malloc(TEST_FILE_SIZE);
+	ut_assertnonnull(buf);
+	expect = malloc(TEST_FILE_SIZE);
+	ut_assertnonnull(expect);
+
+	/* The first file's first node was rewritten */
+	fill_data(expect, ino, 0, TEST_FILE_SIZE, 0);
+	if (!num)
+		fill_data(expect, ino, 0, TEST_NODE_DATA, 1);
+
+	snprintf(fname, sizeof(fname), "/boot/file%02d", num);
+	memset(buf, '\0', TEST_FILE_SIZE);
+	mtd_to_nand(mtd)->pagebuf = -1;
+	sandbox_nand_clear_stats();
+	size = jffs2_1pass_load((char *)buf, part, fname);
+	sandbox_nand_get_stats(stats);
+	ut_asserteq(TEST_FILE_SIZE, size);
+	ut_assertok(memcmp(expect, buf, TEST_FILE_SIZE));
+
+	free(expect);
+	free(buf);
+
+	return 0;
+}
+
+/* Test that summary nodes let the partition be scanned with fewer reads */
+static int nand_test_jffs2_summary(struct unit_test_state *uts)
+{
+	struct sandbox_nand_stats full, sum, stats;
+	struct mtd_info *mtd = nand_info[0];
+	struct mtd_device dev;
+	struct part_info part;
+	struct mtdids id;
+
+	setup_part(mtd, &part, &dev, &id);
+
+	ut_assertok(setup_image(mtd, false));
+	ut_assertok(load_file(uts, &part, 7, &full));
+	ut_assertok(load_file(uts, &part, 0, &stats));
+	jffs2_free_cache(&part);
+
+	ut_assertok(setup_image(mtd, true));
+	ut_assertok(load_file(uts, &part, 7, &sum));
+	ut_assertok(load_file(uts, &part, 0, &stats));
+	jffs2_free_cache(&part);
+
+	ut_assert(sum.page_reads * 4 < full.page_reads);
+	printf("JFFS2 scan and load: %u pages in %llu us, %u pages in %llu us with summaries\n",
+	       full.page_reads, full.time_ns / 1000, sum.page_reads,
+	       sum.time_ns / 1000);
+
+	return 0;
+}
+NAND_TEST(nand_test_jffs2_summary, 0);
+
+/* Test that a file is loaded with few reads once the partition is scanned */
+static int nand_test_jffs2_load(struct unit_test_state *uts)
+{
+	struct sandbox_nand_stats first, second;
+	struct mtd_info *mtd = nand_info[0];
+	struct mtd_device dev;
+	struct part_info part;
+	struct mtdids id;
+
+	setup_part(mtd, &part, &dev, &id);
+	ut_assertok(setup_image(mtd, false));
+	ut_assertok(load_file(uts, &part, 20, &first));
+
+	/*
+	 * The lists are kept, and a dirent is only read from flash if its
+	 * name might match, so little more than the file's nodes are read
+	 */
+	ut_assertok(load_file(uts, &part, 21, &second));
+	ut_assert(second.page_reads * 4 < first.page_reads);
+	jffs2_free_cache(&part);
+
+	return 0;
+}
+NAND_TEST(nand_test_jffs2_load, 0);
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Tests for applying a list of overlays, checking that it gives the same
+ * tree as fdt_overlay_apply()
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <linux/sizes.h>
+#include <test/overlay.h>
+#include <test/ut.h>
+
+#define FDT_COPY_SIZE		(4 * SZ_1K)
+
+/* Size of the generated tree used to measure throughput */
+#define BENCH_FDT_SIZE		(256 * SZ_1K)
+#define BENCH_OVERLAY_SIZE	(32 * SZ_1K)
+#define BENCH_NODES		1000
+#define BENCH_OVERLAYS		10
+#define BENCH_FRAGMENTS		100
+
+extern u32 __dtb_test_fdt_base_begin;
+extern u32 __dtb_test_fdt_overlay_begin;
+
+/* Check that two trees have the same nodes, properties and strings */
+static int check_same_tree(struct unit_test_state *uts, const void *fdt,
+			   const void *expect)
+{
+	const struct fdt_property *prop, *eprop;
+	int offset, nextoffset, len, elen;
+	uint32_t tag;
+
+	ut_asserteq(fdt_size_dt_struct(expect), fdt_size_dt_struct(fdt));
+	ut_asserteq(fdt_size_dt_strings(expect), fdt_size_dt_strings(fdt));
+	ut_assertok(memcmp(fdt_string(expect, 0), fdt_string(fdt, 0),
+			   fdt_size_dt_strings(fdt)));
+
+	for (offset = 0; offset >= 0; offset = nextoffset) {
+		tag = fdt_next_tag(expect, offset, &nextoffset);
+		ut_asserteq(tag, fdt_next_tag(fdt, offset, &len));
+		ut_asserteq(nextoffset, len);
+		if (tag == FDT_END)
+			break;
+		if (tag == FDT_BEGIN_NODE) {
+			ut_asserteq_str(fdt_get_name(expect, offset, NULL),
+					fdt_get_name(fdt, offset, NULL));
+		} else if (tag == FDT_PROP) {
+			eprop = fdt_get_property_by_offset(expect, offset,
+							   &elen);
+			prop = fdt_get_property_by_offset(fdt, offset, &len);
+			ut_asserteq(fdt32_to_cpu(eprop->nameoff),
+				    fdt32_to_cpu(prop->nameoff));
+			ut_asserteq(elen, len);
+			ut_assertok(memcmp(eprop->data, prop->data, len));
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * apply_test_overlay() - Apply the test overlay to the test base tree
+ *
+ * @uts:	Test state
+ * @fdt:	Buffer of FDT_COPY_SIZE bytes to hold the result
+ * @count:	Number of copies of the overlay to apply
+ * @list:	true to use fdt_overlay_apply_list(), false to apply each
+ *		overlay with fdt_overlay_apply()
+ * @return 0 if OK, -ve on error
+ */
+static int apply_test_overlay(struct unit_test_state *uts, void *fdt,
+			      int count, bool list)
+{
+	void *fdtos[2];
+	int i;
+
+	ut_assert(count <= ARRAY_SIZE(fdtos));
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, fdt,
+				  FDT_COPY_SIZE));
+	for (i = 0; i < count; i++) {
+		fdtos[i] = malloc(FDT_COPY_SIZE);
+		ut_assertnonnull(fdtos[i]);
+		ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_begin,
+					  fdtos[i], FDT_COPY_SIZE));
+		if (!list)
+			ut_assertok(fdt_overlay_apply(fdt, fdtos[i]));
+	}
+	if (list)
+		ut_assertok(fdt_overlay_apply_list(fdt, fdtos, count));
+	for (i = 0; i < count; i++) {
+		ut_asserteq(~0, fdt_magic(fdtos[i]));
+		free(fdtos[i]);
+	}
+
+	return 0;
+}
+
+/* Test that a single overlay gives the same result as fdt_overlay_apply() */
+static int fdt_overlay_list_same(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE], expect[FDT_COPY_SIZE];
+
+	ut_assertok(apply_test_overlay(uts, expect, 1, false));
+	ut_assertok(apply_test_overlay(uts, fdt, 1, true));
+	ut_assertok(check_same_tree(uts, fdt, expect));
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_same, 0);
+
+/* Test stacking an overlay on top of the nodes added by another */
+static int fdt_overlay_list_stack(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE], expect[FDT_COPY_SIZE];
+	int off;
+
+	ut_assertok(apply_test_overlay(uts, expect, 2, false));
+	ut_assertok(apply_test_overlay(uts, fdt, 2, true));
+	ut_assertok(check_same_tree(uts, fdt, expect));
+
+	/* Each overlay gets its own phandles */
+	off = fdt_path_offset(fdt, "/new-local-node");
+	ut_assert(off >= 0);
+	ut_asserteq(fdt_get_max_phandle(fdt), fdt_get_phandle(fdt, off));
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_stack, 0);
+
+/* Test that the base tree is left alone if the overlays cannot be applied */
+static int fdt_overlay_list_error(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE], fdto[FDT_COPY_SIZE], orig[FDT_COPY_SIZE];
+	const void *base = &__dtb_test_fdt_base_begin;
+	void *fdtos[] = { fdto };
+
+	/* Leave no free space in the tree */
+	ut_assertok(fdt_open_into(base, fdt, FDT_COPY_SIZE));
+	fdt_set_totalsize(fdt, fdt_off_dt_strings(fdt) +
+			  fdt_size_dt_strings(fdt));
+	memcpy(orig, fdt, fdt_totalsize(fdt));
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_begin, fdto,
+				  FDT_COPY_SIZE));
+	ut_asserteq(-FDT_ERR_NOSPACE, fdt_overlay_apply_list(fdt, fdtos, 1));
+	ut_assertok(memcmp(orig, fdt, fdt_totalsize(fdt)));
+
+	/* Likewise if a label is missing from the base tree */
+	ut_assertok(fdt_open_into(base, fdt, FDT_COPY_SIZE));
+	memcpy(orig, fdt, FDT_COPY_SIZE);
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_begin, fdto,
+				  FDT_COPY_SIZE));
+	ut_assertok(fdt_setprop_string(fdto,
+				       fdt_path_offset(fdto, "/__fixups__"),
+				       "missing", "/fragment@0:target:0"));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_overlay_apply_list(fdt, fdtos, 1));
+	ut_assertok(memcmp(orig, fdt, FDT_COPY_SIZE));
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_error, 0);
+
+/* Test that only the overlays which were fixed up are marked as damaged */
+static int fdt_overlay_list_error_magic(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE], fdto[2][FDT_COPY_SIZE];
+	void *fdtos[] = { fdto[0], fdto[1] };
+	int i;
+
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, fdt,
+				  FDT_COPY_SIZE));
+	for (i = 0; i < ARRAY_SIZE(fdtos); i++)
+		ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_begin,
+					  fdtos[i], FDT_COPY_SIZE));
+
+	/* A bad header is found before any overlay is touched */
+	fdt_set_magic(fdtos[1], 0);
+	ut_asserteq(-FDT_ERR_BADMAGIC, fdt_overlay_apply_list(fdt, fdtos, 2));
+	ut_asserteq(FDT_MAGIC, fdt_magic(fdtos[0]));
+	ut_asserteq(0, fdt_magic(fdtos[1]));
+
+	/* The overlay which fails is damaged but the one after it is not */
+	fdt_set_magic(fdtos[1], FDT_MAGIC);
+	ut_assertok(fdt_setprop_string(fdtos[0],
+				       fdt_path_offset(fdtos[0], "/__fixups__"),
+				       "missing", "/fragment@0:target:0"));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_overlay_apply_list(fdt, fdtos, 2));
+	ut_asserteq(~0, fdt_magic(fdtos[0]));
+	ut_asserteq(FDT_MAGIC, fdt_magic(fdtos[1]));
+
+	/* So that one can still be applied */
+	ut_assertok(fdt_overlay_apply_list(fdt, &fdtos[1], 1));
+	ut_asserteq(~0, fdt_magic(fdtos[1]));
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_error_magic, 0);
+
+/*
+ * Create a base tree with BENCH_NODES nodes, each with a phandle and a
+ * label in /__symbols__
+ */
+static int make_base(void *buf)
+{
+	char name[20], path[20];
+	int i;
+
+	fdt_create(buf, BENCH_FDT_SIZE);
+	fdt_finish_reservemap(buf);
+	fdt_begin_node(buf, "");
+	fdt_property_u32(buf, "#address-cells", 1);
+	fdt_property_u32(buf, "#size-cells", 0);
+	for (i = 0; i < BENCH_NODES; i++) {
+		snprintf(name, sizeof(name), "node@%d", i);
+		fdt_begin_node(buf, name);
+		fdt_property_u32(buf, "reg", i);
+		fdt_property_string(buf, "status", "disabled");
+		fdt_property_u32(buf, "phandle", i + 1);
+		fdt_end_node(buf);
+	}
+	fdt_begin_node(buf, "__symbols__");
+	for (i = 0; i < BENCH_NODES; i++) {
+		snprintf(name, sizeof(name), "node%d", i);
+		snprintf(path, sizeof(path), "/node@%d", i);
+		fdt_property_string(buf, name, path);
+	}
+	fdt_end_node(buf);
+	fdt_end_node(buf);
+	fdt_finish(buf);
+
+	return fdt_open_into(buf, buf, BENCH_FDT_SIZE);
+}
+
+/*
+ * Create an overlay with BENCH_FRAGMENTS fragments, each targeting a
+ * different node of the base tree. Each fragment enables its target, adds
+ * a reference to the next node in the base tree and one to a local node
+ * added by the first fragment.
+ */
+static int make_overlay(void *buf, int seq)
+{
+	char name[30], prop[30], fixup[60];
+	int f, target;
+
+	fdt_create(buf, BENCH_OVERLAY_SIZE);
+	fdt_finish_reservemap(buf);
+	fdt_begin_node(buf, "");
+	snprintf(prop, sizeof(prop), "overlay-%d", seq);
+	for (f = 0; f < BENCH_FRAGMENTS; f++) {
+		snprintf(name, sizeof(name), "fragment@%d", f);
+		fdt_begin_node(buf, name);
+		fdt_property_u32(buf, "target", -1);
+		fdt_begin_node(buf, "__overlay__");
+		fdt_property_string(buf, "status", "okay");
+		fdt_property_u32(buf, prop, -1);
+		fdt_property_u32(buf, "local-ref", 1);
+		if (!f) {
+			snprintf(name, sizeof(name), "local-%d", seq);
+			fdt_begin_node(buf, name);
+			fdt_property_u32(buf, "phandle", 1);
+			fdt_end_node(buf);
+		}
+		fdt_end_node(buf);
+		fdt_end_node(buf);
+	}
+
+	/* Targets are seven nodes apart, so no label is used twice */
+	fdt_begin_node(buf, "__fixups__");
+	for (f = 0; f < BENCH_FRAGMENTS; f++) {
+		target = (seq * BENCH_FRAGMENTS + f * 7) % BENCH_NODES;
+		snprintf(name, sizeof(name), "node%d", target);
+		snprintf(fixup, sizeof(fixup), "/fragment@%d:target:0", f);
+		fdt_property_string(buf, name, fixup);
+		snprintf(name, sizeof(name), "node%d",
+			 (target + 1) % BENCH_NODES);
+		snprintf(fixup, sizeof(fixup), "/fragment@%d/__overlay__:%s:0",
+			 f, prop);
+		fdt_property_string(buf, name, fixup);
+	}
+	fdt_end_node(buf);
+
+	fdt_begin_node(buf, "__local_fixups__");
+	for (f = 0; f < BENCH_FRAGMENTS; f++) {
+		snprintf(name, sizeof(name), "fragment@%d", f);
+		fdt_begin_node(buf, name);
+		fdt_begin_node(buf, "__overlay__");
+		fdt_property_u32(buf, "local-ref", 0);
+		fdt_end_node(buf);
+		fdt_end_node(buf);
+	}
+	fdt_end_node(buf);
+	fdt_end_node(buf);
+	fdt_finish(buf);
+
+	return fdt_open_into(buf, buf, BENCH_OVERLAY_SIZE);
+}
+
+/* Compare the time taken to apply many overlays with many fixups */
+static int fdt_overlay_list_speed(struct unit_test_state *uts)
+{
+	void *fdt, *expect, *fdtos[BENCH_OVERLAYS];
+	ulong start, libfdt_us, list_us;
+	int i;
+
+	fdt = malloc(BENCH_FDT_SIZE);
+	ut_assertnonnull(fdt);
+	expect = malloc(BENCH_FDT_SIZE);
+	ut_assertnonnull(expect);
+	for (i = 0; i < BENCH_OVERLAYS; i++) {
+		fdtos[i] = malloc(BENCH_OVERLAY_SIZE);
+		ut_assertnonnull(fdtos[i]);
+	}
+
+	ut_assertok(make_base(expect));
+	for (i = 0; i < BENCH_OVERLAYS; i++)
+		ut_assertok(make_overlay(fdtos[i], i));
+	start = timer_get_us();
+	for (i = 0; i < BENCH_OVERLAYS; i++)
+		ut_assertok(fdt_overlay_apply(expect, fdtos[i]));
+	libfdt_us = timer_get_us() - start;
+
+	ut_assertok(make_base(fdt));
+	for (i = 0; i < BENCH_OVERLAYS; i++)
+		ut_assertok(make_overlay(fdtos[i], i));
+	start = timer_get_us();
+	ut_assertok(fdt_overlay_apply_list(fdt, fdtos, BENCH_OVERLAYS));
+	list_us = timer_get_us() - start;
+
+	ut_assertok(check_same_tree(uts, fdt, expect));
+	printf("%d overlays of %d fragments: libfdt %lu us, list %lu us\n",
+	       BENCH_OVERLAYS, BENCH_FRAGMENTS, libfdt_us, list_us);
+
+	for (i = 0; i < BENCH_OVERLAYS; i++)
+		free(fdtos[i]);
+	free(expect);
+	free(fdt);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_speed, 0);
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Make a block-level delta between two images, for U-Boot's delta command
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "compiler.h"
+#include <delta.h>
+
+#define DEFAULT_BLOCK_SIZE	4096
+
+/* Hash of a source block, for finding blocks which have moved */
+struct block_hash {
+	uint8_t hash[DELTA_HASH_SIZE];
+	uint32_t blk;
+};
+
+struct image {
+	uint8_t *data;
+	uint32_t blocks;
+};
+
+static uint32_t block_size = DEFAULT_BLOCK_SIZE;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-b <block size>] <source> <target> <delta>\n"
+		"\n"
+		"Makes a delta which turns the source image into the target image,\n"
+		"for the U-Boot 'delta apply' command. Blocks of the target which\n"
+		"are in the source, at the same place or elsewhere, are copied from\n"
+		"it; the rest are put in the delta.\n"
+		"\n"
+		"\t-b <block size> : size of each block, a power of two from %d\n"
+		"\t                  (default %d)\n",
+		prog, DELTA_MIN_BLOCK_SIZE, DEFAULT_BLOCK_SIZE);
+	exit(EXIT_FAILURE);
+}
+
+/*
+ * Read an image, padded with zeroes to a whole number of blocks. If @full is
+ * not NULL it returns the number of blocks which were complete in the file.
+ */
+static int read_image(const char *fname, struct image *img, uint32_t *full)
+{
+	struct stat st;
+	uint64_t blocks;
+	size_t done;
+	ssize_t n;
+	int fd;
+
+	fd = open(fname, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		fprintf(stderr, "Cannot open '%s': %s\n", fname,
+			strerror(errno));
+		return -1;
+	}
+	blocks = (st.st_size + block_size - 1) / block_size;
+	if (blocks > UINT32_MAX) {
+		fprintf(stderr, "Image '%s' is too large\n", fname);
+		return -1;
+	}
+	img->blocks = blocks;
+	img->data = calloc(blocks ? blocks : 1, block_size);
+	if (!img->data) {
+		fprintf(stderr, "Out of memory\n");
+		return -1;
+	}
+	for (done = 0; done < st.st_size; done += n) {
+		n = read(fd, img->data + done, st.st_size - done);
+		if (n <= 0) {
+			fprintf(stderr, "Cannot read '%s': %s\n", fname,
+				n ? strerror(errno) : "Short file");
+			return -1;
+		}
+	}
+	close(fd);
+	if (full)
+		*full = st.st_size / block_size;
+
+	return 0;
+}
+
+static int compare_hash(const void *a, const void *b)
+{
+	const struct block_hash *ha = a, *hb = b;
+	int ret;
+
+	/* Among blocks which are the same, the first is found */
+	ret = memcmp(ha->hash, hb->hash, DELTA_HASH_SIZE);
+	if (ret)
+		return ret;
+
+	return ha->blk < hb->blk ? -1 : ha->blk > hb->blk;
+}
+
+static const uint8_t *block(const struct image *img, uint32_t blk)
+{
+	return img->data + (size_t)blk * block_size;
+}
+
+static int is_zero(const uint8_t *buf)
+{
+	uint32_t i;
+
+	for (i = 0; i < block_size; i++) {
+		if (buf[i])
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Find a source block holding the same data as target block @blk. Carrying
+ * on from the last copy keeps runs long, so that is tried first, then the
+ * same place in the source, then anywhere.
+ */
+static int find_block(const struct image *src, uint32_t src_blocks,
+		      const struct block_hash *index, const struct image *dst,
+		      uint32_t blk, const uint8_t *hash, int64_t next,
+		      uint32_t *found)
+{
+	const uint8_t *data = block(dst, blk);
+	const struct block_hash *bh;
+	uint32_t lo = 0, hi = src_blocks, mid;
+
+	if (next >= 0 && next < src_blocks &&
+	    !memcmp(block(src, next), data, block_size)) {
+		*found = next;
+		return 1;
+	}
+	if (blk < src_blocks && !memcmp(block(src, blk), data, block_size)) {
+		*found = blk;
+		return 1;
+	}
+	/* Find the first source block with this hash */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (memcmp(index[mid].hash, hash, DELTA_HASH_SIZE) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == src_blocks || memcmp(index[lo].hash, hash, DELTA_HASH_SIZE))
+		return 0;
+	bh = &index[lo];
+	if (memcmp(block(src, bh->blk), data, block_size))
+		return 0;
+	*found = bh->blk;
+
+	return 1;
+}
+
+static int add_op(struct delta_op **opsp, uint32_t *countp, uint32_t type,
+		  uint32_t arg)
+{
+	struct delta_op *ops = *opsp, *last;
+	uint32_t count = *countp;
+
+	last = count ? &ops[count - 1] : NULL;
+	if (last && be32_to_cpu(last->type) == type &&
+	    (type != DELTA_OP_COPY ||
+	     be32_to_cpu(last->arg) + be32_to_cpu(last->count) == arg)) {
+		last->count = cpu_to_be32(be32_to_cpu(last->count) + 1);
+		return 0;
+	}
+
+	/* Double the size of the array each time it fills up */
+	if (!(count & (count - 1))) {
+		ops = realloc(ops, (count ? count * 2 : 1) * sizeof(*ops));
+		if (!ops)
+			return -1;
+		*opsp = ops;
+	}
+	memset(&ops[count], '\0', sizeof(*ops));
+	ops[count].type = cpu_to_be32(type);
+	ops[count].count = cpu_to_be32(1);
+	ops[count].arg = cpu_to_be32(type == DELTA_OP_COPY ? arg : 0);
+	*countp = count + 1;
+
+	return 0;
+}
+
+static int write_all(int fd, const void *buf, size_t size)
+{
+	const uint8_t *ptr = buf;
+	ssize_t n;
+
+	for (; size; size -= n, ptr += n) {
+		n = write(fd, ptr, size);
+		if (n < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t src_blocks, op_count = 0, data_blocks = 0;
+	uint32_t copied = 0, zeroed = 0, blk, found;
+	struct delta_op *ops = NULL;
+	struct block_hash *index;
+	struct delta_header hdr;
+	struct image src, dst;
+	uint8_t *hashes, *data;
+	sha256_context ctx;
+	uint64_t size;
+	int64_t next = -1;
+	char *end;
+	int opt, fd;
+
+	while ((opt = getopt(argc, argv, "b:")) != -1) {
+		switch (opt) {
+		case 'b':
+			block_size = strtoul(optarg, &end, 0);
+			if (*end || block_size < DELTA_MIN_BLOCK_SIZE ||
+			    block_size > DELTA_MAX_BLOCK_SIZE ||
+			    (block_size & (block_size - 1))) {
+				fprintf(stderr, "Invalid block size '%s'\n",
+					optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (argc - optind != 3)
+		usage(argv[0]);
+
+	/* Only whole blocks of the source can be copied */
+	if (read_image(argv[optind], &src, &src_blocks) ||
+	    read_image(argv[optind + 1], &dst, NULL))
+		return EXIT_FAILURE;
+
+	index = malloc((src_blocks ? src_blocks : 1) * sizeof(*index));
+	hashes = malloc((dst.blocks ? dst.blocks : 1) * DELTA_HASH_SIZE);
+	data = malloc((size_t)(dst.blocks ? dst.blocks : 1) * block_size);
+	if (!index || !hashes || !data) {
+		fprintf(stderr, "Out of memory\n");
+		return EXIT_FAILURE;
+	}
+	for (blk = 0; blk < src_blocks; blk++) {
+		sha256_csum_wd(block(&src, blk), block_size, index[blk].hash,
+			       CHUNKSZ_SHA256);
+		index[blk].blk = blk;
+	}
+	qsort(index, src_blocks, sizeof(*index), compare_hash);
+
+	for (blk = 0; blk < dst.blocks; blk++) {
+		uint8_t *hash = hashes + (size_t)blk * DELTA_HASH_SIZE;
+		const uint8_t *buf = block(&dst, blk);
+		int ret;
+
+		sha256_csum_wd(buf, block_size, hash, CHUNKSZ_SHA256);
+		if (is_zero(buf)) {
+			ret = add_op(&ops, &op_count, DELTA_OP_ZERO, 0);
+			zeroed++;
+			next = -1;
+		} else if (find_block(&src, src_blocks, index, &dst, blk, hash,
+				      next, &found)) {
+			ret = add_op(&ops, &op_count, DELTA_OP_COPY, found);
+			copied++;
+			next = found + 1;
+		} else {
+			ret = add_op(&ops, &op_count, DELTA_OP_DATA, 0);
+			memcpy(data + (size_t)data_blocks * block_size, buf,
+			       block_size);
+			data_blocks++;
+			next = -1;
+		}
+		if (ret) {
+			fprintf(stderr, "Out of memory\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	size = sizeof(hdr) + (uint64_t)op_count * sizeof(*ops) +
+		(uint64_t)dst.blocks * DELTA_HASH_SIZE +
+		(uint64_t)data_blocks * block_size;
+	if (size > UINT32_MAX) {
+		fprintf(stderr, "Delta is too large (%llu bytes)\n",
+			(unsigned long long)size);
+		return EXIT_FAILURE;
+	}
+	memset(&hdr, '\0', sizeof(hdr));
+	hdr.magic = cpu_to_be32(DELTA_MAGIC);
+	hdr.version = cpu_to_be32(DELTA_VERSION);
+	hdr.block_size = cpu_to_be32(block_size);
+	hdr.src_blocks = cpu_to_be32(src_blocks);
+	hdr.dst_blocks = cpu_to_be32(dst.blocks);
+	hdr.op_count = cpu_to_be32(op_count);
+	hdr.size = cpu_to_be32(size);
+	sha256_starts(&ctx);
+	sha256_update(&ctx, (uint8_t *)ops, op_count * sizeof(*ops));
+	sha256_update(&ctx, hashes, dst.blocks * DELTA_HASH_SIZE);
+	sha256_update(&ctx, data, data_blocks * block_size);
+	sha256_finish(&ctx, hdr.body_hash);
+
+	fd = open(argv[optind + 2], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 ||
+	    write_all(fd, &hdr, sizeof(hdr)) ||
+	    write_all(fd, ops, op_count * sizeof(*ops)) ||
+	    write_all(fd, hashes, dst.blocks * DELTA_HASH_SIZE) ||
+	    write_all(fd, data, (size_t)data_blocks * block_size) ||
+	    close(fd)) {
+		fprintf(stderr, "Cannot write '%s': %s\n", argv[optind + 2],
+			strerror(errno));
+		return EXIT_FAILURE;
+	}
+	printf("%u blocks: %u copied, %u zeroed, %u in the delta; %llu bytes\n",
+	       dst.blocks, copied, zeroed, data_blocks,
+	       (unsigned long long)size);
+
+	return EXIT_SUCCESS;
+}
@@ -5,6 +5,11 @@
  *
  * 64-bit and little-endian target only until we need to support a different
  * arch that needs this.
+ *
+ * With -p the relative relocations are also packed into RELR format, in
+ * place of the rela entries, so that relocate_code() has far less to read.
+ * The packed list starts with RELR_MAGIC so that relocate_code() can tell
+ * it apart from the rela entries still present in other output formats.
  */
 
 #include <elf.h>
@@ -20,6 +25,12 @@
 #define R_AARCH64_RELATIVE	1027
 #endif
 
+/*
+ * Marks a packed list; must match arch/arm/lib/relocate_64.S. It is odd, so
+ * it can be neither a rela r_offset nor the first entry of a RELR list.
+ */
+#define RELR_MAGIC		0x52454c52ffffffffULL
+
 static const bool debug_en;
 
 static void debug(const char *fmt, ...)
@@ -91,17 +102,74 @@ static bool read_num(const char *str, uint64_t *num)
 	return str[0] && !endptr[0];
 }
 
+static int cmp_offset(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * Pack a list of relative relocations into RELR format. Each even word is
+ * the address of a location to relocate. It is followed by zero or more odd
+ * words, each a bitmap of which of the next 63 words need relocating. The
+ * list is ended by a zero word or by the end of the area.
+ *
+ * Returns the number of words used, or -1 if there is not enough space
+ */
+static int pack_relr(uint64_t *offsets, int count, uint64_t *out, int max)
+{
+	uint64_t where, bitmap;
+	int i = 0, n = 0, bit;
+
+	qsort(offsets, count, sizeof(*offsets), cmp_offset);
+	while (i < count) {
+		if (n == max)
+			return -1;
+		out[n++] = le64(offsets[i]);
+		where = offsets[i++] + sizeof(uint64_t);
+		for (;;) {
+			bitmap = 0;
+			for (; i < count && offsets[i] < where + 63 * 8; i++) {
+				bit = (offsets[i] - where) / sizeof(uint64_t);
+				bitmap |= 1ULL << (bit + 1);
+			}
+			if (!bitmap)
+				break;
+			if (n == max)
+				return -1;
+			out[n++] = le64(bitmap | 1);
+			where += 63 * 8;
+		}
+	}
+	if (n < max)
+		out[n] = 0;
+
+	return n;
+}
+
 int main(int argc, char **argv)
 {
 	FILE *f;
-	int i, num;
+	int i, num, count = 0;
 	uint64_t rela_start, rela_end, text_base;
-
+	uint64_t *offsets = NULL;
+	bool pack = false;
+	uint8_t *buf;
+	long size;
+
+	if (argc == 6 && !strcmp(argv[1], "-p")) {
+		pack = true;
+		argv[1] = argv[0];
+		argv++;
+		argc--;
+	}
 	if (argc != 5) {
 		fprintf(stderr, "Statically apply ELF rela relocations\n");
-		fprintf(stderr, "Usage: %s <bin file> <text base> " \
+		fprintf(stderr, "Usage: %s [-p] <bin file> <text base> "
 				"<rela start> <rela end>\n", argv[0]);
 		fprintf(stderr, "All numbers in hex.\n");
+		fprintf(stderr, "-p: Pack relocations into RELR format\n");
 		return 1;
 	}
 
@@ -128,26 +196,40 @@ int main(int argc, char **argv)
 	rela_start -= text_base;
 	rela_end -= text_base;
 
+	/* Work on a copy of the whole image, then write it back in one go */
+	size = fseek(f, 0, SEEK_END) < 0 ? -1 : ftell(f);
+	if (size < 0) {
+		fprintf(stderr, "%s: %s: cannot get size: %s\n",
+			argv[0], argv[1], strerror(errno));
+		return 4;
+	}
+	if (rela_end > size) {
+		fprintf(stderr, "%s: %s: rela end %" PRIx64 " beyond file\n",
+			argv[0], argv[1], rela_end);
+		return 3;
+	}
+	buf = malloc(size);
+	if (!buf || fseek(f, 0, SEEK_SET) < 0 ||
+	    fread(buf, size, 1, f) != 1) {
+		fprintf(stderr, "%s: %s: read failed\n", argv[0], argv[1]);
+		return 4;
+	}
+
 	num = (rela_end - rela_start) / sizeof(Elf64_Rela);
+	if (pack) {
+		offsets = malloc((num + 1) * sizeof(*offsets));
+		if (!offsets) {
+			fprintf(stderr, "%s: out of memory\n", argv[0]);
+			return 4;
+		}
+	}
 
 	for (i = 0; i < num; i++) {
 		Elf64_Rela rela, swrela;
 		uint64_t pos = rela_start + sizeof(Elf64_Rela) * i;
 		uint64_t addr;
 
-		if (fseek(f, pos, SEEK_SET) < 0) {
-			fprintf(stderr, "%s: %s: seek to %" PRIx64
-					" failed: %s\n",
-				argv[0], argv[1], pos, strerror(errno));
-		}
-
-		if (fread(&rela, sizeof(rela), 1, f) != 1) {
-			fprintf(stderr, "%s: %s: read rela failed at %"
-					PRIx64 "\n",
-				argv[0], argv[1], pos);
-			return 4;
-		}
-
+		memcpy(&rela, buf + pos, sizeof(rela));
 		swrela.r_offset = le64(rela.r_offset);
 		swrela.r_info = le64(rela.r_info);
 		swrela.r_addend = le64(rela.r_addend);
@@ -158,26 +240,49 @@ int main(int argc, char **argv)
 		debug("Rela %" PRIx64 " %" PRIu64 " %" PRIx64 "\n",
 		      swrela.r_offset, swrela.r_info, swrela.r_addend);
 
-		if (swrela.r_offset < text_base) {
+		addr = swrela.r_offset - text_base;
+		if (swrela.r_offset < text_base ||
+		    addr + sizeof(rela.r_addend) > size ||
+		    (pack && (addr & (sizeof(uint64_t) - 1)))) {
 			fprintf(stderr, "%s: %s: bad rela at %" PRIx64 "\n",
 				argv[0], argv[1], pos);
 			return 4;
 		}
 
-		addr = swrela.r_offset - text_base;
-
-		if (fseek(f, addr, SEEK_SET) < 0) {
-			fprintf(stderr, "%s: %s: seek to %"
-					PRIx64 " failed: %s\n",
-				argv[0], argv[1], addr, strerror(errno));
-		}
+		memcpy(buf + addr, &rela.r_addend, sizeof(rela.r_addend));
+		if (pack)
+			offsets[count++] = swrela.r_offset;
+	}
 
-		if (fwrite(&rela.r_addend, sizeof(rela.r_addend), 1, f) != 1) {
-			fprintf(stderr, "%s: %s: write failed at %" PRIx64 "\n",
-				argv[0], argv[1], addr);
+	if (pack) {
+		int max = (rela_end - rela_start) / sizeof(uint64_t);
+		uint64_t *out = (uint64_t *)(buf + rela_start);
+		int words;
+
+		/*
+		 * Each packed word covers at least one relocation and each
+		 * rela entry is three words, so the magic word and the list
+		 * always fit in the space used by the rela entries
+		 */
+		memset(out, '\0', rela_end - rela_start);
+		words = max ? pack_relr(offsets, count, out + 1, max - 1) : 0;
+		if (max)
+			out[0] = le64(RELR_MAGIC);
+		if (words < 0) {
+			fprintf(stderr, "%s: %s: no space for packed relocs\n",
+				argv[0], argv[1]);
 			return 4;
 		}
+		debug("Packed %d relocations into %d words\n", count, words);
+		free(offsets);
+	}
+
+	if (fseek(f, 0, SEEK_SET) < 0 || fwrite(buf, size, 1, f) != 1) {
+		fprintf(stderr, "%s: %s: write failed: %s\n",
+			argv[0], argv[1], strerror(errno));
+		return 4;
 	}
+	free(buf);
 
 	if (fclose(f) < 0) {
 		fprintf(stderr, "%s: %s: close failed: %s\n",